@@ -46,8 +46,11 @@ use h1::nvcounter::{FlashCounter,NvCounter};
 use h1::timels::Timels;
 use h1::usb::{Descriptor, StringDescriptor};
 
-// State for loading apps
-const NUM_PROCS: usize = 1;
+// State for loading apps. u2f_app is linked first and auxiliary (test
+// and diagnostic) apps after it; the priority scheduler below runs
+// processes in load order, so the extra slots never cost u2f_app a
+// scheduling quantum.
+const NUM_PROCS: usize = 4;
 
 // how should the kernel respond when a process faults
 const FAULT_RESPONSE: kernel::procs::FaultResponse = kernel::procs::FaultResponse::Panic;
@@ -59,6 +62,9 @@ static mut CHIP: Option<&'static h1::chip::Hotel> = None;
 #[cfg(not(test))]
 #[panic_handler]
 pub unsafe extern "C" fn panic_fmt(pi: &core::panic::PanicInfo) -> ! {
+    // Binary dump first: a few milliseconds to flash, so triage does
+    // not depend on the slow UART text below reaching anyone.
+    h1::fault_dump::write_dump();
     let led = &mut kernel::hil::led::LedLow::new(&mut h1::gpio::PORT0.pins[0]);
     let writer = &mut h1::io::WRITER;
     kernel::debug::panic(&mut [led], writer, pi, &cortexm3::support::nop, &crate::PROCESSES, &CHIP)
@@ -67,7 +73,7 @@ pub unsafe extern "C" fn panic_fmt(pi: &core::panic::PanicInfo) -> ! {
 #[link_section = ".app_memory"]
 static mut APP_MEMORY: [u8; 0xc000] = [0; 0xc000];
 
-static mut PROCESSES: [Option<&'static dyn kernel::procs::ProcessType>; NUM_PROCS] = [None];
+static mut PROCESSES: [Option<&'static dyn kernel::procs::ProcessType>; NUM_PROCS] = [None; NUM_PROCS];
 
 /// Dummy buffer that causes the linker to reserve enough space for the stack.
 #[no_mangle]
@@ -90,7 +96,10 @@ pub struct Golf {
     nvcounter: &'static h1_syscalls::nvcounter_syscall::NvCounterSyscall<'static,
         FlashCounter<'static, h1::hil::flash::virtual_flash::FlashUser<'static>>>,
     u2f_usb: &'static h1::usb::driver::U2fSyscallDriver<'static>,
+    bulk_usb: &'static h1::usb::bulk_driver::BulkSyscallDriver<'static>,
     personality: &'static h1_syscalls::personality::PersonalitySyscall<'static>,
+    timestamp: &'static h1_syscalls::timestamp::TimestampSyscall<'static>,
+    tracelog: &'static h1_syscalls::tracelog::TraceLogSyscall,
 }
 
 static mut STRINGS: [StringDescriptor; 7] = [
@@ -152,22 +161,74 @@ pub unsafe fn reset_handler() {
     timerhs.start();
     let start = timerhs.now();
 
+    // Boot timeline: one duration per bring-up phase, printed once the
+    // console is up. Cheap enough to stay on permanently, and names the
+    // culprit when the cold-boot budget regresses.
+    let mut boot_phases: [(&'static str, u32); 12] = [("", 0); 12];
+    let mut boot_phase_count = 0;
+    let mut boot_prev = start;
+    macro_rules! boot_phase {
+        ($name:expr) => {
+            if boot_phase_count < boot_phases.len() {
+                let now = timerhs.now();
+                boot_phases[boot_phase_count] = ($name, now.wrapping_sub(boot_prev));
+                boot_phase_count += 1;
+                boot_prev = now;
+            }
+        };
+    }
+
     {
         use h1::pmu::*;
+        use h1::pinmux::{Entry, Function, SelectablePin};
         Clock::new(PeripheralClock::Bank0(PeripheralClock0::Gpio0)).enable();
-        let pinmux = &mut *h1::pinmux::PINMUX;
-        // LED_0
-        pinmux.dioa11.select.set(h1::pinmux::Function::Gpio0Gpio0);
-
-        // SW1
-        pinmux.gpio0_gpio1.select.set(h1::pinmux::SelectablePin::Diom2);
-        pinmux.diom2.select.set(h1::pinmux::Function::Gpio0Gpio1);
-        pinmux.diom2.control.set(1 << 2 | 1 << 4);
-
-        pinmux.diob1.select.set(h1::pinmux::Function::Uart0Tx);
-        pinmux.diob6.control.set(1 << 2 | 1 << 4);
-        pinmux.uart0_rx.select.set(h1::pinmux::SelectablePin::Diob6);
+
+        // Whole-board pinout, applied in one pass.
+        const PINMUX_TABLE: &[Entry] = &[
+            // LED_0
+            Entry::PadFunction { pad: SelectablePin::Dioa11,
+                                 function: Function::Gpio0Gpio0 },
+            // SW1
+            Entry::PeripheralInput { function: Function::Gpio0Gpio1,
+                                     pad: SelectablePin::Diom2 },
+            Entry::PadFunction { pad: SelectablePin::Diom2,
+                                 function: Function::Gpio0Gpio1 },
+            Entry::PadControl { pad: SelectablePin::Diom2,
+                                bits: 1 << 2 | 1 << 4 },
+            // UART
+            Entry::PadFunction { pad: SelectablePin::Diob1,
+                                 function: Function::Uart0Tx },
+            Entry::PadControl { pad: SelectablePin::Diob6,
+                                bits: 1 << 2 | 1 << 4 },
+            Entry::PeripheralInput { function: Function::Uart0Rx,
+                                     pad: SelectablePin::Diob6 },
+        ];
+        h1::pinmux::apply(PINMUX_TABLE);
+    }
+
+    // ** GLOBALSEC **
+    // Runs before USB bring-up: the DUSB regions gate USB DMA, and USB
+    // init moves as early as possible so host-visible enumeration is
+    // not queued behind the rest of driver construction. The table of
+    // master regions lives in h1::globalsec; the one flash window
+    // covers the last eight pages of the second flash macro: the rng
+    // app's seed store (n-8, n-7), the FIPS store (n-6, n-5), the
+    // fault dump (n-4), Personality (n-3) and the non-volatile counter
+    // implementation (n-2, n-1). The page assignments are tabulated in
+    // userspace/libh1/flash_layout.h; keep the two in step. The SIZE
+    // register holds one less than the window's byte size.
+    {
+        const FLASH_START: usize = 0x40000;
+        const FLASH_SIZE: usize = 512 * 1024;
+        const FLASH_PAGE_SIZE: usize = 2048;
+        h1::globalsec::GLOBALSEC.init_with_flash_window(
+            (FLASH_START + FLASH_SIZE - 8 * FLASH_PAGE_SIZE) as u32,
+            (8 * FLASH_PAGE_SIZE - 1) as u32);
     }
+    // Logic-analyzer probe pins; no-op unless the h1 crate is built
+    // with the `probes` feature.
+    h1::probe::init();
+    boot_phase!("clocks+pinmux+globalsec");
 
     // Create capabilities that the board needs to call certain protected kernel
     // functions.
@@ -193,6 +254,14 @@ pub unsafe fn reset_handler() {
     let uart = &h1::uart::UART0;
     uart.config(115200);
 
+    // Kernel-side TX ring: console writes complete once staged here
+    // instead of once drained at baud rate.
+    uart.set_tx_ring(static_init!([u8; 512], [0; 512]));
+
+    // Kernel-side RX ring: bytes arriving between console reads spill
+    // here instead of overrunning the 32-character hardware FIFO.
+    uart.set_rx_ring(static_init!([u8; 512], [0; 512]));
+
     // Create virtual device for console.
     let console_uart = static_init!(UartDevice, UartDevice::new(uart_mux, true));
     console_uart.setup();
@@ -228,6 +297,7 @@ pub unsafe fn reset_handler() {
         )
     );
     hil::uart::Transmit::set_transmit_client(low_level_debug_uart, low_level_debug);
+    boot_phase!("console+debug");
 
     //debug!("Booting.");
     let wrapped_pins = static_init!(
@@ -280,12 +350,14 @@ pub unsafe fn reset_handler() {
         AlarmDriver<'static, VirtualMuxAlarm<'static, Timels>>,
         AlarmDriver::new(timer_virtual_alarm, kernel.create_grant(&grant_cap)));
     timer_virtual_alarm.set_alarm_client(timer);
+    boot_phase!("gpio+alarm+flash");
 
     let digest = static_init!(
         h1_syscalls::digest::DigestDriver<'static, h1::crypto::sha::ShaEngine>,
         h1_syscalls::digest::DigestDriver::new(
                 &mut h1::crypto::sha::KEYMGR0_SHA,
                 kernel.create_grant(&grant_cap)));
+    h1::crypto::sha::KEYMGR0_SHA.set_finalize_client(digest);
 
     let aes = static_init!(
         h1_syscalls::aes::AesDriver,
@@ -296,10 +368,42 @@ pub unsafe fn reset_handler() {
     h1::crypto::dcrypto::DCRYPTO.initialize();
     let dcrypto = static_init!(
         h1_syscalls::dcrypto::DcryptoDriver<'static>,
-        h1_syscalls::dcrypto::DcryptoDriver::new(&mut h1::crypto::dcrypto::DCRYPTO));
+        h1_syscalls::dcrypto::DcryptoDriver::new(
+            &mut h1::crypto::dcrypto::DCRYPTO,
+            kernel.create_grant(&grant_cap)));
 
     h1::crypto::dcrypto::DCRYPTO.set_client(dcrypto);
 
+    // Shared 1Mhz Timeus counter behind the crypto request queues,
+    // used to expire requests that wait too long for an engine.
+    let arbiter_timer = static_init!(h1::timeus::Timeus, h1::timeus::Timeus::new(2));
+    arbiter_timer.start_us();
+    aes.set_queue_timer(arbiter_timer);
+    dcrypto.set_queue_timer(arbiter_timer);
+
+    // Holds a checkpointed long dcrypto operation's DMEM while a
+    // queued short program runs. Sized for the full DMEM so any
+    // working set fits; shrink it if SRAM gets tight and long-running
+    // programs declare smaller working sets.
+    let dcrypto_checkpoint = static_init!([u8; 4096], [0; 4096]);
+    dcrypto.set_checkpoint_buffer(dcrypto_checkpoint);
+    boot_phase!("crypto");
+
+    // Dedicated 1Mhz Timeus counter behind the read-only timestamp
+    // syscall; the alarm driver's low-speed timer is too coarse for
+    // userspace profiling.
+    let timestamp_timer = static_init!(h1::timeus::Timeus, h1::timeus::Timeus::new(1));
+    timestamp_timer.start_us();
+    let timestamp = static_init!(
+        h1_syscalls::timestamp::TimestampSyscall<'static>,
+        h1_syscalls::timestamp::TimestampSyscall::new(timestamp_timer));
+
+    // Binary trace stream drain/append syscalls; a no-op unless the
+    // trace_stream feature is built in.
+    let tracelog = static_init!(
+        h1_syscalls::tracelog::TraceLogSyscall,
+        h1_syscalls::tracelog::TraceLogSyscall::new(kernel.create_grant(&grant_cap)));
+
     let nvcounter_buffer = static_init!([u32; 1], [0]);
     let nvcounter = static_init!(
         FlashCounter<'static, h1::hil::flash::virtual_flash::FlashUser<'static>>,
@@ -311,12 +415,41 @@ pub unsafe fn reset_handler() {
             FlashCounter<'static, h1::hil::flash::virtual_flash::FlashUser<'static>>>,
         h1_syscalls::nvcounter_syscall::NvCounterSyscall::new(nvcounter, kernel.create_grant(&grant_cap)));
     nvcounter.set_client(nvcounter_syscall);
+    boot_phase!("timestamp+nvcounter");
 
     let u2f = static_init!(
         h1::usb::driver::U2fSyscallDriver<'static>,
         h1::usb::driver::U2fSyscallDriver::new(&mut h1::usb::USB0, kernel.create_grant(&grant_cap)));
     h1::usb::u2f::UsbHidU2f::set_u2f_client(&h1::usb::USB0, u2f);
 
+    let bulk = static_init!(
+        h1::usb::bulk_driver::BulkSyscallDriver<'static>,
+        h1::usb::bulk_driver::BulkSyscallDriver::new(&h1::usb::USB0, kernel.create_grant(&grant_cap)));
+    h1::usb::bulk::UsbBulk::set_bulk_client(&h1::usb::USB0, bulk);
+    h1::usb::USB0.init_bulk(&mut h1::usb::EP2_OUT_DESCRIPTORS,
+                            &mut h1::usb::EP2_OUT_BUFFERS,
+                            &mut h1::usb::EP2_IN_DESCRIPTORS,
+                            &mut h1::usb::EP2_IN_BUFFERS);
+
+    // Bring the USB controller up as soon as its driver exists rather
+    // than after every remaining driver: the cold-boot SLO is measured
+    // by host-visible enumeration, so nothing that the host cannot see
+    // should run ahead of this.
+    h1::usb::USB0.init(&mut h1::usb::EP0_OUT_DESCRIPTORS,
+                       &mut h1::usb::EP0_OUT_BUFFERS,
+                       &mut h1::usb::EP0_IN_DESCRIPTORS,
+                       &mut h1::usb::EP0_IN_BUFFER,
+                       &mut h1::usb::EP1_OUT_DESCRIPTORS,
+                       &mut h1::usb::EP1_OUT_BUFFERS,
+                       &mut h1::usb::EP1_IN_DESCRIPTORS,
+                       &mut h1::usb::EP1_IN_BUFFERS,
+                       &mut h1::usb::CONFIGURATION_BUFFER,
+                       h1::usb::PHY::A,
+                       None,
+                       Some(0x18d1),  // Google vendor ID
+                       Some(0x5026),  // proto2
+                       &mut STRINGS);
+    boot_phase!("usb");
 
     h1::trng::TRNG0.init();
     let entropy_to_random = static_init!(
@@ -333,6 +466,7 @@ pub unsafe fn reset_handler() {
     );
     h1::trng::TRNG0.set_client(entropy_to_random);
     entropy_to_random.set_client(rng);
+    boot_phase!("rng");
 
     let personality = static_init!(
         h1_syscalls::personality::PersonalitySyscall<'static>,
@@ -341,89 +475,44 @@ pub unsafe fn reset_handler() {
 
     h1::personality::PERSONALITY.set_flash(flash_user);
     h1::personality::PERSONALITY.set_buffer(&mut h1::personality::BUFFER);
+    h1::personality::PERSONALITY.set_partial_buffer(&mut h1::personality::PARTIAL_BUFFER);
     h1::personality::PERSONALITY.set_client(personality);
     flash_user.set_client(&h1::personality::PERSONALITY);
-
-    // ** GLOBALSEC **
-    // TODO(alevy): refactor out
-    {
-        use core::intrinsics::volatile_store as vs;
-        const GLOBALSEC_BASE:      usize = 0x40090000;
-
-        const CPU0_D_REGION0_CTRL: usize = GLOBALSEC_BASE + 0x0;
-        const CPU0_D_REGION1_CTRL: usize = GLOBALSEC_BASE + 0x4;
-        const CPU0_D_REGION2_CTRL: usize = GLOBALSEC_BASE + 0x8;
-        const CPU0_D_REGION3_CTRL: usize = GLOBALSEC_BASE + 0xc;
-
-        const DDMA0_REGION0_CTRL: usize = GLOBALSEC_BASE + 0x80;
-        const DDMA0_REGION1_CTRL: usize = GLOBALSEC_BASE + 0x84;
-        const DDMA0_REGION2_CTRL: usize = GLOBALSEC_BASE + 0x88;
-        const DDMA0_REGION3_CTRL: usize = GLOBALSEC_BASE + 0x8c;
-
-        const DUSB0_REGION0_CTRL: usize = GLOBALSEC_BASE + 0xc0;
-        const DUSB0_REGION1_CTRL: usize = GLOBALSEC_BASE + 0xc4;
-        const DUSB0_REGION2_CTRL: usize = GLOBALSEC_BASE + 0xc8;
-        const DUSB0_REGION3_CTRL: usize = GLOBALSEC_BASE + 0xcc;
-
-        const FLASH_REGION2_BASE: usize = GLOBALSEC_BASE + 0x240;
-        const FLASH_REGION2_SIZE: usize = GLOBALSEC_BASE + 0x244;
-        const FLASH_REGION2_CTRL: usize = GLOBALSEC_BASE + 0x0e8;
-
-        vs(CPU0_D_REGION0_CTRL as *mut u32, !0);
-        vs(CPU0_D_REGION1_CTRL as *mut u32, !0);
-        vs(CPU0_D_REGION2_CTRL as *mut u32, !0);
-        vs(CPU0_D_REGION3_CTRL as *mut u32, !0);
-
-        // GLOBALSEC_DDMA0-DDMA3
-        vs(DDMA0_REGION0_CTRL as *mut u32, !0);
-        vs(DDMA0_REGION1_CTRL as *mut u32, !0);
-        vs(DDMA0_REGION2_CTRL as *mut u32, !0);
-        vs(DDMA0_REGION3_CTRL as *mut u32, !0);
-
-        // GLOBALSEC_DUSB_REGION0-DUSB_REGION3
-        vs(DUSB0_REGION0_CTRL as *mut u32, !0);
-        vs(DUSB0_REGION1_CTRL as *mut u32, !0);
-        vs(DUSB0_REGION2_CTRL as *mut u32, !0);
-        vs(DUSB0_REGION3_CTRL as *mut u32, !0);
-
-        // Flash region initialization. We initialize a single region for the
-        // last three pages of the second flash macro, used by Personality (n-3)
-        // and the non-volatile counter implementation (n-2, n-1).
-        const FLASH_START: usize = 0x40000;
-        const FLASH_SIZE: usize = 512 * 1024;
-        const FLASH_PAGE_SIZE: usize = 2048;
-        vs(FLASH_REGION2_BASE as *mut u32, (FLASH_START + FLASH_SIZE - 3*FLASH_PAGE_SIZE) as u32);
-        // The value of the SIZE register is one less than the size of the
-        // region, i.e. the last address within the region is the start address
-        // + the size register.
-        vs(FLASH_REGION2_SIZE as *mut u32, (3*FLASH_PAGE_SIZE - 1) as u32);
-        // Enable the region for reads and writes.
-        vs(FLASH_REGION2_CTRL as *mut u32, 0b111);
-    }
+    // Verify the stored certificate once now, while the digest engine
+    // is still ours; apps then query the latched verdict instead of
+    // re-hashing the 2KB certificate on every read.
+    h1::personality::PERSONALITY.set_digest(&h1::crypto::sha::KEYMGR0_SHA);
+    h1::personality::PERSONALITY.verify_certificate();
+    boot_phase!("personality");
 
     let mut _ctr = 0;
     let chip = static_init!(h1::chip::Hotel, h1::chip::Hotel::new());
     chip.mpu().enable_app_mpu();
     CHIP = Some(chip);
+    boot_phase!("chip+mpu");
 
     let end = timerhs.now();
-    println!("Tock: booted in {} tics; initializing USB and loading processes.",
+    println!("Tock: booted in {} tics; loading processes.",
              end.wrapping_sub(start));
+    for (name, tics) in boot_phases[..boot_phase_count].iter() {
+        println!("  boot phase {}: {} tics", name, tics);
+    }
+
+    // A previous boot may have left a panic fault dump in flash; print
+    // it now that the device is healthy and the line is otherwise idle.
+    // The page is only overwritten by the next panic, so the dump stays
+    // retrievable until then.
+    if let Some(dump) = h1::fault_dump::retrieve() {
+        println!("Fault dump from previous panic ({} words):", dump.len());
+        for (i, chunk) in dump.chunks(8).enumerate() {
+            print!("  {:03x}:", i * 8 * 4);
+            for word in chunk {
+                print!(" {:08x}", word);
+            }
+            println!("");
+        }
+    }
 
-    h1::usb::USB0.init(&mut h1::usb::EP0_OUT_DESCRIPTORS,
-                       &mut h1::usb::EP0_OUT_BUFFERS,
-                       &mut h1::usb::EP0_IN_DESCRIPTORS,
-                       &mut h1::usb::EP0_IN_BUFFER,
-                       &mut h1::usb::EP1_OUT_DESCRIPTOR,
-                       &mut h1::usb::EP1_OUT_BUFFER,
-                       &mut h1::usb::EP1_IN_DESCRIPTOR,
-                       &mut h1::usb::EP1_IN_BUFFER,
-                       &mut h1::usb::CONFIGURATION_BUFFER,
-                       h1::usb::PHY::A,
-                       None,
-                       Some(0x18d1),  // Google vendor ID
-                       Some(0x5026),  // proto2
-                       &mut STRINGS);
     let golf2 = Golf {
         console: console,
         gpio: gpio,
@@ -436,7 +525,10 @@ pub unsafe fn reset_handler() {
         nvcounter: nvcounter_syscall,
         rng: rng,
         u2f_usb: u2f,
+        bulk_usb: bulk,
         personality: personality,
+        timestamp: timestamp,
+        tracelog: tracelog,
     };
 
     // Uncomment to initialize NvCounter
@@ -463,8 +555,11 @@ pub unsafe fn reset_handler() {
     ).unwrap_or_else(|err| {
         debug!("Error loading processes!\n{:?}", err);
     });
-    let scheduler = components::sched::round_robin::RoundRobinComponent::new(&PROCESSES)
-        .finalize(components::rr_component_helper!(NUM_PROCS));
+    // Strict priority by load order: u2f_app (first) always preempts
+    // the auxiliary apps, so they cannot add round-robin quanta to
+    // authentication latency.
+    let scheduler = components::sched::priority::PriorityComponent::new(kernel)
+        .finalize(());
     debug!("Tock: starting main loop.");
     debug!(" ");
     kernel.kernel_loop(&golf2, chip, Some(&golf2.ipc), scheduler, &main_cap);
@@ -475,20 +570,26 @@ impl Platform for Golf {
     where
         F: FnOnce(Option<&dyn kernel::Driver>) -> R
     {
-        match driver_num {
+        h1::syscall_profile::syscall_enter(driver_num);
+        let res = match driver_num {
             capsules::alarm::DRIVER_NUM                => f(Some(self.timer)),
             capsules::console::DRIVER_NUM              => f(Some(self.console)),
             capsules::gpio::DRIVER_NUM                 => f(Some(self.gpio)),
             capsules::low_level_debug::DRIVER_NUM      => f(Some(self.low_level_debug)),
             capsules::rng::DRIVER_NUM                  => f(Some(self.rng)),
+            h1::usb::bulk_driver::DRIVER_NUM           => f(Some(self.bulk_usb)),
             h1::usb::driver::DRIVER_NUM                => f(Some(self.u2f_usb)),
             h1_syscalls::aes::DRIVER_NUM               => f(Some(self.aes)),
             h1_syscalls::dcrypto::DRIVER_NUM           => f(Some(self.dcrypto)),
             h1_syscalls::digest::DRIVER_NUM            => f(Some(self.digest)),
             h1_syscalls::nvcounter_syscall::DRIVER_NUM => f(Some(self.nvcounter)),
             h1_syscalls::personality::DRIVER_NUM       => f(Some(self.personality)),
+            h1_syscalls::timestamp::DRIVER_NUM         => f(Some(self.timestamp)),
+            h1_syscalls::tracelog::DRIVER_NUM          => f(Some(self.tracelog)),
             kernel::ipc::DRIVER_NUM                    => f(Some(&self.ipc)),
             _ =>  f(None),
-        }
+        };
+        h1::syscall_profile::syscall_exit(driver_num);
+        res
     }
 }
@@ -24,7 +24,7 @@ use crate::uart;
 use crate::usb;
 
 pub struct Hotel {
-    mpu: cortexm3::mpu::MPU,
+    mpu: crate::mpu::CachedMpu,
     userspace_kernel_boundary: cortexm3::syscall::SysCall,
     systick: cortexm3::systick::SysTick,
 }
@@ -32,7 +32,7 @@ pub struct Hotel {
 impl Hotel {
     pub unsafe fn new() -> Hotel {
         Hotel {
-            mpu: cortexm3::mpu::MPU::new(),
+            mpu: crate::mpu::CachedMpu::new(),
             userspace_kernel_boundary: cortexm3::syscall::SysCall::new(),
             systick: cortexm3::systick::SysTick::new(),
         }
@@ -40,7 +40,7 @@ impl Hotel {
 }
 
 impl Chip for Hotel {
-    type MPU = cortexm3::mpu::MPU;
+    type MPU = crate::mpu::CachedMpu;
     type UserspaceKernelBoundary = cortexm3::syscall::SysCall;
     type SchedulerTimer = cortexm3::systick::SysTick;
     type WatchDog = ();
@@ -51,56 +51,43 @@ impl Chip for Hotel {
 
     fn service_pending_interrupts(&self) {
         unsafe {
-            while let Some(nvic_num) = cortexm3::nvic::next_pending() {
-                match nvic_num {
-                    1 | 3 | 6 | 7 | 8 | 9 | 10 | 11 => crypto::dcrypto::DCRYPTO.handle_error_interrupt(nvic_num),
-                    2 => crypto::dcrypto::DCRYPTO.handle_wipe_interrupt(),
-                    4 => crypto::dcrypto::DCRYPTO.handle_done_interrupt(),
-                    5 => crypto::dcrypto::DCRYPTO.handle_receive_interrupt(),
-
-                    //54 => (), // KEYMGR HKEY ALERT, ignored
-                    104..=109 => crypto::aes::KEYMGR0_AES.handle_interrupt(nvic_num),
-
-                    110 => crypto::sha::KEYMGR0_SHA.handle_interrupt(nvic_num),
-                    111 => (), // KEYMGR0_SHA_WFIFO_FULL
-
-                    127 => spi_host::SPI_HOST0.handle_interrupt(),
-                    128 => spi_host::SPI_HOST1.handle_interrupt(),
-
-                    131 => spi_device::SPI_DEVICE0.handle_interrupt_cmd_addr_fifo_not_empty(),
-
-                    159 => timels::TIMELS0.handle_interrupt(),
-                    160 => timels::TIMELS1.handle_interrupt(),
-
-                    169 => trng::TRNG0.handle_interrupt(),
-
-                    174 => uart::UART0.handle_rx_interrupt(),
-                    177 => uart::UART0.handle_tx_interrupt(),
-                    181 => uart::UART1.handle_rx_interrupt(),
-                    184 => uart::UART1.handle_tx_interrupt(),
-                    188 => uart::UART2.handle_rx_interrupt(),
-                    191 => uart::UART2.handle_tx_interrupt(),
-
-                    193 => {
-                        usb::USB0.handle_interrupt()
-                    },
-
-                    pin @ 65..=80 => {
-                        gpio::PORT0.pins[(pin - 65) as usize].handle_interrupt();
-                    }
-                    81 => {
-                        // GPIO Combined interrupt... why does this remain asserted?
-                    }
-                    pin @ 82..=97 => {
-                        gpio::PORT1.pins[(pin - 82) as usize].handle_interrupt();
-                    }
-                    98 => {
-                        // GPIO Combined interrupt... why does this remain asserted?
+            // The NVIC scan returns the lowest pending interrupt number
+            // first, which puts USB (193) behind every UART, timer, and
+            // GPIO interrupt. Within one service pass, defer the
+            // low-priority numbers and dispatch the latency-sensitive
+            // tier -- dcrypto completions, the SPI device, and USB --
+            // first, then work through the deferred backlog one at a
+            // time, rescanning between each so a newly arrived
+            // high-priority event still jumps the queue.
+            let mut deferred = [0u32; 16];
+            let mut deferred_count = 0;
+            let mut next_deferred = 0;
+
+            loop {
+                while let Some(nvic_num) = cortexm3::nvic::next_pending() {
+                    let high_priority = match nvic_num {
+                        1..=11 => true,  // dcrypto
+                        131 => true,     // SPI device
+                        193 => true,     // USB
+                        _ => false,
+                    };
+                    if !high_priority && deferred_count < deferred.len() {
+                        // Interrupts arrive here already disabled; clear
+                        // the pending bit so the scan moves past this
+                        // one. It is re-enabled when dispatched below.
+                        cortexm3::nvic::Nvic::new(nvic_num).clear_pending();
+                        deferred[deferred_count] = nvic_num;
+                        deferred_count += 1;
+                        continue;
                     }
-                    _ => panic!("Unexpected ISR {}", nvic_num),
+                    Hotel::dispatch_interrupt(nvic_num);
                 }
-                cortexm3::nvic::Nvic::new(nvic_num).clear_pending();
-                cortexm3::nvic::Nvic::new(nvic_num).enable();
+                if next_deferred >= deferred_count {
+                    break;
+                }
+                let nvic_num = deferred[next_deferred];
+                next_deferred += 1;
+                Hotel::dispatch_interrupt(nvic_num);
             }
         }
     }
@@ -124,9 +111,11 @@ impl Chip for Hotel {
                 cortexm3::scb::unset_sleepdeep();
         }
 
+        crate::pmu::sleep_track_enter();
         unsafe {
             cortexm3::support::wfi();
         }
+        crate::pmu::sleep_track_exit();
     }
 
     unsafe fn atomic<F, R>(&self, f: F) -> R
@@ -140,3 +129,61 @@ impl Chip for Hotel {
         cortexm3::print_cortexm3_state(writer);
     }
 }
+
+impl Hotel {
+    // Runs the handler for a single interrupt, then clears and
+    // re-enables it.
+    unsafe fn dispatch_interrupt(nvic_num: u32) {
+        crate::syscall_profile::irq_enter(nvic_num);
+        match nvic_num {
+            1 | 3 | 6 | 7 | 8 | 9 | 10 | 11 => crypto::dcrypto::DCRYPTO.handle_error_interrupt(nvic_num),
+            2 => crypto::dcrypto::DCRYPTO.handle_wipe_interrupt(),
+            4 => crypto::dcrypto::DCRYPTO.handle_done_interrupt(),
+            5 => crypto::dcrypto::DCRYPTO.handle_receive_interrupt(),
+
+            //54 => (), // KEYMGR HKEY ALERT, ignored
+            104..=109 => crypto::aes::KEYMGR0_AES.handle_interrupt(nvic_num),
+
+            110 => crypto::sha::KEYMGR0_SHA.handle_interrupt(nvic_num),
+            111 => (), // KEYMGR0_SHA_WFIFO_FULL
+
+            127 => spi_host::SPI_HOST0.handle_interrupt(),
+            128 => spi_host::SPI_HOST1.handle_interrupt(),
+
+            131 => spi_device::SPI_DEVICE0.handle_interrupt_cmd_addr_fifo_not_empty(),
+
+            159 => timels::TIMELS0.handle_interrupt(),
+            160 => timels::TIMELS1.handle_interrupt(),
+
+            169 => trng::TRNG0.handle_interrupt(),
+
+            174 => uart::UART0.handle_rx_interrupt(),
+            177 => uart::UART0.handle_tx_interrupt(),
+            181 => uart::UART1.handle_rx_interrupt(),
+            184 => uart::UART1.handle_tx_interrupt(),
+            188 => uart::UART2.handle_rx_interrupt(),
+            191 => uart::UART2.handle_tx_interrupt(),
+
+            193 => {
+                usb::USB0.handle_interrupt()
+            },
+
+            pin @ 65..=80 => {
+                gpio::PORT0.pins[(pin - 65) as usize].handle_interrupt();
+            }
+            81 => {
+                // GPIO Combined interrupt... why does this remain asserted?
+            }
+            pin @ 82..=97 => {
+                gpio::PORT1.pins[(pin - 82) as usize].handle_interrupt();
+            }
+            98 => {
+                // GPIO Combined interrupt... why does this remain asserted?
+            }
+            _ => panic!("Unexpected ISR {}", nvic_num),
+        }
+        crate::syscall_profile::irq_exit(nvic_num);
+        cortexm3::nvic::Nvic::new(nvic_num).clear_pending();
+        cortexm3::nvic::Nvic::new(nvic_num).enable();
+    }
+}
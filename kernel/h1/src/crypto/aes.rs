@@ -170,11 +170,11 @@ impl<'a> AES128<'a> for AesEngine<'a> {
             self.input.put(source);
             self.output.replace(dest);
             if self.try_set_indices(start_index, stop_index) {
-                if self.input.is_some() {
-                    self.input.map(|buf| self.crypt(&buf[start_index..stop_index]));
-                } else {
-                    self.output.map(|buf| self.crypt(&buf[start_index..stop_index]));
-                }
+                // Feed the first block; handle_interrupt() streams the
+                // rest of the region from the cipher-done interrupt and
+                // notifies the client once everything has drained.
+                crate::probe::set(crate::probe::Probe::CryptoBusy);
+                self.feed_block();
                 None
             } else {
                 Some((ReturnCode::EINVAL,
@@ -304,6 +304,32 @@ impl<'a> AesEngine<'a> {
         }
     }
 
+    // Pushes the block at `write_index` into the write FIFO as four
+    // word writes and advances the index. In source mode the index
+    // walks the input buffer; in-place it walks the output buffer.
+    fn feed_block(&self) {
+        let feed = |buf: &[u8]| {
+            let index = self.write_index.get();
+            self.crypt(&buf[index..index + AES128_BLOCK_SIZE]);
+            self.write_index.set(index + AES128_BLOCK_SIZE);
+        };
+        if self.input.is_some() {
+            self.input.map(|buf| feed(buf));
+        } else {
+            self.output.map(|buf| feed(buf));
+        }
+    }
+
+    // Drains the finished block from the read FIFO into the output
+    // buffer at `read_index` and advances the index.
+    fn drain_block(&self) {
+        self.output.map(|buf| {
+            let index = self.read_index.get();
+            self.read_data(&mut buf[index..index + AES128_BLOCK_SIZE]);
+            self.read_index.set(index + AES128_BLOCK_SIZE);
+        });
+    }
+
     pub fn crypt(&self, input: &[u8]) -> usize {
         let ref regs = unsafe { &*self.regs }.aes;
 
@@ -382,10 +408,22 @@ impl<'a> AesEngine<'a> {
 
     pub fn handle_interrupt(&self, interrupt: u32) {
         if let ParsedInterrupt::Found(int) = interrupt.into() {
-            self.client.map(|client| match int {
-                Interrupt::DoneCipher => client.crypt_done(self.input.take(), self.output.take().unwrap() ),
-                _ => {}
-            });
+            if let Interrupt::DoneCipher = int {
+                // Stream the submitted region from interrupt context:
+                // drain the finished block, and while blocks remain
+                // feed the next one without a client round trip. The
+                // client only hears about the whole region.
+                self.drain_block();
+                if self.read_index.get() < self.stop_index.get() {
+                    self.feed_block();
+                } else {
+                    crate::probe::clear(crate::probe::Probe::CryptoBusy);
+                    self.client.map(|client| {
+                        client.crypt_done(self.input.take(),
+                                          self.output.take().unwrap())
+                    });
+                }
+            }
             self.clear_interrupt(int);
         } else {
             panic!("AesEngine: Unexpected interrupt: {}", interrupt);
@@ -56,7 +56,7 @@ use kernel::common::cells::TakeCell;
 use kernel::common::cells::VolatileCell;
 use kernel::ReturnCode;
 
-use crate::pmu::{Clock, PeripheralClock, PeripheralClock0, reset_dcrypto};
+use crate::pmu::{Clock, PeripheralClock, PeripheralClock0, crypto_turbo_finish, crypto_turbo_start, reset_dcrypto};
 
 
 
@@ -413,6 +413,8 @@ impl<'a> DcryptoEngine<'a> {
             cause == ProgramFault::LoopUnderflow ||
             cause == ProgramFault::StackOverflow)
         {
+            crypto_turbo_finish();
+            crate::probe::clear(crate::probe::Probe::CryptoBusy);
             self.client.get().map(|client| {
                 println!("DCRYPTO engine had a {:?} error but was in state {:?}, HW state is {:?}.", cause, prior_state, status);
                 client.execution_complete(ReturnCode::FAIL, cause);
@@ -446,6 +448,8 @@ impl<'a> DcryptoEngine<'a> {
                     _            => ProgramFault::Unknown
                 };
                 self.state.set(State::Halt);
+                crypto_turbo_finish();
+                crate::probe::clear(crate::probe::Probe::CryptoBusy);
                 self.client.get().map(|client| {
                         client.execution_complete(ReturnCode::SUCCESS, fault);
                 });
@@ -608,6 +612,10 @@ impl<'a> Dcrypto<'a> for DcryptoEngine<'a> {
             registers.int_state.get() & 0x3 != 0
         }{}
 
+        // Keep the engine clocks at full rate across idle-loop sleeps
+        // until the done (or error) interrupt arrives.
+        crypto_turbo_start();
+        crate::probe::set(crate::probe::Probe::CryptoBusy);
         registers.host_cmd.set(instruction);
         if is_call {
             self.state.set(State::Running);
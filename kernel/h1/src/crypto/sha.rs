@@ -14,7 +14,8 @@
 
 use core::cell::Cell;
 use core::mem;
-use crate::hil::digest::{DigestEngine, DigestMode, DigestError};
+use crate::hil::digest::{DigestAsyncClient, DigestEngine, DigestMode, DigestError};
+use crate::hil::dma;
 use kernel::common::cells::VolatileCell;
 use super::keymgr::{KEYMGR0_REGS, Registers};
 
@@ -43,6 +44,11 @@ enum ShaCfgEnMask {
 pub struct ShaEngine {
     regs: *mut Registers,
     current_mode: Cell<Option<DigestMode>>,
+    /// Client notified from the done interrupt; only set while an
+    /// asynchronous finalize is outstanding (the synchronous paths
+    /// consume the done status themselves by polling).
+    client: Cell<Option<&'static dyn DigestAsyncClient>>,
+    async_pending: Cell<bool>,
 }
 
 enum CertificateMask {
@@ -56,12 +62,28 @@ impl ShaEngine {
         ShaEngine {
             regs: regs,
             current_mode: Cell::new(None),
+            client: Cell::new(None),
+            async_pending: Cell::new(false),
         }
     }
 
+    /// Registers the client notified when an asynchronous finalize
+    /// completes.
+    pub fn set_finalize_client(&self, client: &'static dyn DigestAsyncClient) {
+        self.client.set(Some(client));
+    }
+
     pub fn handle_interrupt(&self, _nvic: u32) {
         let ref regs = unsafe { &*self.regs }.sha;
         regs.itop.set(0);
+        // A done interrupt can also latch from the synchronous finalize
+        // paths; only an asynchronous finalize expects a notification.
+        if self.async_pending.get() {
+            self.async_pending.set(false);
+            if let Some(client) = self.client.get() {
+                client.finalize_done();
+            }
+        }
     }
 }
 
@@ -148,10 +170,11 @@ impl DigestEngine for ShaEngine {
             return Err(DigestError::NotConfigured);
         }
 
+        // Whole words go over the bus four bytes at a time; the
+        // livestream FIFO takes the unaligned tail as byte writes.
+        let consumed = dma::burst_out_words(data, |word| regs.input_fifo.set(word));
         let fifo_u8: &VolatileCell<u8> = unsafe { mem::transmute(&regs.input_fifo) };
-
-        // TODO(yuriks): Feed FIFO word at a time when possible
-        for b in data {
+        for b in &data[consumed..] {
             fifo_u8.set(*b);
         }
         Ok(data.len())
@@ -173,16 +196,7 @@ impl DigestEngine for ShaEngine {
         regs.trig.set(ShaTrigMask::Stop as u32);
         while regs.itop.get() == 0 {}
 
-        for i in 0..(expected_output_size / 4) {
-            let word = regs.sts_h[i].get();
-            output[i * 4 + 0] = (word >> 0) as u8;
-            output[i * 4 + 1] = (word >> 8) as u8;
-            output[i * 4 + 2] = (word >> 16) as u8;
-            output[i * 4 + 3] = (word >> 24) as u8;
-        }
-        regs.itop.set(0);
-
-        Ok(expected_output_size)
+        self.finalize_result(output)
     }
 
     // Finalize withtout seeing the result; this is used for certificates
@@ -196,4 +210,41 @@ impl DigestEngine for ShaEngine {
 
         Ok(0)
     }
+
+    fn finalize_async(&self) -> Result<(), DigestError> {
+        let ref regs = unsafe { &*self.regs }.sha;
+        if self.current_mode.get().is_none() {
+            return Err(DigestError::NotConfigured);
+        }
+
+        // Tell hardware we're done streaming; the done interrupt fires
+        // once the hash calculation finishes instead of the CPU
+        // spinning on the status register.
+        regs.itop.set(0);
+        self.async_pending.set(true);
+        regs.trig.set(ShaTrigMask::Stop as u32);
+        Ok(())
+    }
+
+    fn finalize_result(&self, output: &mut [u8]) -> Result<usize, DigestError> {
+        let ref regs = unsafe { &*self.regs }.sha;
+        let expected_output_size = match self.current_mode.get() {
+            None => return Err(DigestError::NotConfigured),
+            Some(mode) => mode.output_size(),
+        };
+        if output.len() < expected_output_size {
+            return Err(DigestError::BufferTooSmall(expected_output_size));
+        }
+
+        for i in 0..(expected_output_size / 4) {
+            let word = regs.sts_h[i].get();
+            output[i * 4 + 0] = (word >> 0) as u8;
+            output[i * 4 + 1] = (word >> 8) as u8;
+            output[i * 4 + 2] = (word >> 16) as u8;
+            output[i * 4 + 3] = (word >> 24) as u8;
+        }
+        regs.itop.set(0);
+
+        Ok(expected_output_size)
+    }
 }
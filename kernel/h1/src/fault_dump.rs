@@ -0,0 +1,182 @@
+// Copyright 2021 Google LLC
+//
+// Licensed under the Apache License, Version 2.0 (the "License");
+// you may not use this file except in compliance with the License.
+// You may obtain a copy of the License at
+//
+//     https://www.apache.org/licenses/LICENSE-2.0
+//
+// Unless required by applicable law or agreed to in writing, software
+// distributed under the License is distributed on an "AS IS" BASIS,
+// WITHOUT WARRANTIES OR CONDITIONS OF ANY KIND, either express or implied.
+// See the License for the specific language governing permissions and
+// limitations under the License.
+
+//! Panic-time binary fault dump.
+//!
+//! The panic handler's text report streams over the UART at console
+//! speed and holds a wedged device on the line for seconds. This
+//! module captures the interesting state first — a cycle timestamp,
+//! the Cortex-M fault status registers and the most recent
+//! trace-stream records — as a binary image written to a reserved
+//! flash page in a few milliseconds. The dump survives the reset and
+//! is read back on the next boot, so triage does not depend on anyone
+//! having watched the UART while the device died.
+//!
+//! The writer runs with the system in an unknown state, so it uses
+//! none of the async machinery: it drives the flash hardware directly
+//! and spins, a synchronous rendition of the smart-program sequence
+//! the regular driver steps via alarms.
+//!
+//! Image layout (little-endian words):
+//! magic, version, time (24MHz Timeus counter 0), ICSR, CFSR, HFSR,
+//! MMFAR, BFAR, trace byte count, reserved, then raw trace-stream
+//! records (20 bytes each, see `trace_stream`).
+
+use core::cmp;
+use core::ptr;
+use crate::hil::flash::{Bank, Hardware};
+use crate::hil::flash::driver::{ERASE_OPCODE, WRITE_OPCODE};
+use crate::hil::flash::h1_hw;
+use crate::hil::flash::h1_hw::{H1_FLASH_PAGE_SIZE, H1_FLASH_START};
+use crate::trace_stream;
+
+/// Flash page reserved for the dump, just below the personality page
+/// (253) and the nvcounter pages (254, 255).
+pub const DUMP_PAGE: usize = 252;
+
+const WORDS_PER_PAGE: usize = H1_FLASH_PAGE_SIZE / 4;
+const WORDS_PER_BANK: usize = 0x10000;
+
+const MAGIC: u32 = 0x504d_4446; // "FDMP"
+const VERSION: u32 = 1;
+
+/// Fixed header words ahead of the trace records.
+const HEADER_WORDS: usize = 10;
+const MAX_TRACE_BYTES: usize = (WORDS_PER_PAGE - HEADER_WORDS) * 4;
+
+// Cortex-M3 System Control Block fault status registers.
+const SCB_ICSR: *const u32 = 0xe000_ed04 as *const u32;
+const SCB_CFSR: *const u32 = 0xe000_ed28 as *const u32;
+const SCB_HFSR: *const u32 = 0xe000_ed2c as *const u32;
+const SCB_MMFAR: *const u32 = 0xe000_ed34 as *const u32;
+const SCB_BFAR: *const u32 = 0xe000_ed38 as *const u32;
+
+// A panic raised while dumping (or while the text report runs) must
+// not restart the dump and clobber the image being written.
+static mut DUMPED: bool = false;
+
+// Poll bound for one program/erase pulse. Each iteration is two
+// register reads; the longest legitimate operation (a page erase
+// pulse) finishes well inside this.
+const SPIN_LIMIT: u32 = 10_000_000;
+
+unsafe fn spin_done(hw: &h1_hw::H1bHw) -> bool {
+    for _ in 0..SPIN_LIMIT {
+        if !hw.is_programming() {
+            return true;
+        }
+    }
+    false
+}
+
+/// Synchronous equivalent of the smart-program state machine in
+/// `hil::flash::smart_program`: pulse, wait, retry on error, with one
+/// final pulse after success for writes.
+unsafe fn sync_program(hw: &h1_hw::H1bHw, opcode: u32, bank: Bank,
+                       max_attempts: u32, final_pulse: bool) -> bool {
+    for _ in 0..max_attempts {
+        hw.trigger(opcode, bank);
+        if !spin_done(hw) {
+            return false;
+        }
+        if hw.read_error() == 0 {
+            if final_pulse {
+                hw.trigger(opcode, bank);
+                if !spin_done(hw) {
+                    return false;
+                }
+            }
+            return true;
+        }
+    }
+    false
+}
+
+/// Writes the fault dump to the reserved page. Called from the panic
+/// handler before the text report; failures are swallowed since there
+/// is nothing left to report them to.
+pub unsafe fn write_dump() {
+    if DUMPED {
+        return;
+    }
+    DUMPED = true;
+
+    let mut image = [0u32; WORDS_PER_PAGE];
+    image[0] = MAGIC;
+    image[1] = VERSION;
+    image[2] = crate::timeus::Timeus::new(0).now();
+    image[3] = ptr::read_volatile(SCB_ICSR);
+    image[4] = ptr::read_volatile(SCB_CFSR);
+    image[5] = ptr::read_volatile(SCB_HFSR);
+    image[6] = ptr::read_volatile(SCB_MMFAR);
+    image[7] = ptr::read_volatile(SCB_BFAR);
+
+    let trace_bytes = {
+        // Word-aligned byte view of the record area.
+        let records = core::slice::from_raw_parts_mut(
+            image[HEADER_WORDS..].as_mut_ptr() as *mut u8, MAX_TRACE_BYTES);
+        trace_stream::snapshot(records)
+    };
+    image[8] = trace_bytes as u32;
+    image[9] = 0;
+    let used_words = HEADER_WORDS + (trace_bytes + 3) / 4;
+
+    let hw = &*h1_hw::H1_HW;
+    // An async flash operation may have been in flight when the panic
+    // hit; let it settle before taking over the controller.
+    if !spin_done(hw) {
+        return;
+    }
+
+    let target = DUMP_PAGE * WORDS_PER_PAGE;
+    let bank = if target < WORDS_PER_BANK { Bank::Zero } else { Bank::One };
+    let bank_target = target % WORDS_PER_BANK;
+
+    // Erase parameters match the async driver's (45 attempts, no final
+    // pulse); writes go in the controller's 32-word bursts (8 attempts,
+    // final pulse).
+    hw.set_transaction(bank_target, 0);
+    if !sync_program(hw, ERASE_OPCODE, bank, 45, false) {
+        return;
+    }
+    let mut pos = 0;
+    while pos < used_words {
+        let len = cmp::min(32, used_words - pos);
+        hw.set_write_data(&image[pos..pos + len]);
+        hw.set_transaction(bank_target + pos, len - 1);
+        if !sync_program(hw, WRITE_OPCODE, bank, 8, true) {
+            return;
+        }
+        pos += len;
+    }
+}
+
+/// Returns the dump left by a previous panic, if the reserved page
+/// holds one. The page is not cleared on read: the dump stays
+/// retrievable across boots until the next panic overwrites it.
+pub fn retrieve() -> Option<&'static [u32]> {
+    unsafe {
+        let base = (H1_FLASH_START + DUMP_PAGE * H1_FLASH_PAGE_SIZE) as *const u32;
+        if ptr::read_volatile(base) != MAGIC ||
+           ptr::read_volatile(base.add(1)) != VERSION {
+            return None;
+        }
+        let trace_bytes = ptr::read_volatile(base.add(8)) as usize;
+        if trace_bytes > MAX_TRACE_BYTES {
+            return None;
+        }
+        let words = HEADER_WORDS + (trace_bytes + 3) / 4;
+        Some(core::slice::from_raw_parts(base, words))
+    }
+}
@@ -16,6 +16,7 @@
 
 use crate::hil::fuse::Fuse;
 
+use core::cell::Cell;
 use kernel::common::registers::register_structs;
 use kernel::common::registers::ReadOnly;
 use kernel::common::StaticRef;
@@ -42,19 +43,35 @@ pub static mut FUSE: FuseController = FuseController::new(FUSE_REGISTERS);
 /// Fuse Controller
 pub struct FuseController {
     registers: StaticRef<Registers>,
+    // SRAM shadow of the device ID fuse words. Fuse reads go through the
+    // slow OTP macro; the words are read once and every later query is
+    // served from the shadow in constant time.
+    shadow_dev_id: Cell<Option<u64>>,
 }
 
 impl FuseController {
     const fn new(base_addr: StaticRef<Registers>) -> FuseController {
         FuseController {
             registers: base_addr,
+            shadow_dev_id: Cell::new(None),
         }
     }
+
+    /// Warms the shadow cache. Called during board setup so that no
+    /// later device-ID query pays the OTP read latency.
+    pub fn init(&self) {
+        let _ = self.get_dev_id();
+    }
 }
 
 impl Fuse for FuseController {
     fn get_dev_id(&self) -> u64 {
-        ((self.registers.dev_id0.get() as u64) << 32)
-            | (self.registers.dev_id1.get() as u64)
+        if let Some(dev_id) = self.shadow_dev_id.get() {
+            return dev_id;
+        }
+        let dev_id = ((self.registers.dev_id0.get() as u64) << 32)
+            | (self.registers.dev_id1.get() as u64);
+        self.shadow_dev_id.set(Some(dev_id));
+        dev_id
     }
 }
@@ -86,6 +86,19 @@ const GLOBALSEC_REGISTERS: StaticRef<Registers> =
 
 pub static mut GLOBALSEC: GlobalSecHardware = GlobalSecHardware::new(GLOBALSEC_REGISTERS);
 
+// Boot-time region configuration is table-driven: the static part --
+// full access for all four windows of each DMA-capable master (CPU
+// data port, dcrypto DMA, USB DMA) -- is one const value applied
+// across a fixed register list in a single pass, and the applied state
+// is read back into a checksum so a dropped write (or a security block
+// still held in reset) is caught at boot instead of surfacing later as
+// an inexplicable bus fault.
+const REGION_CTRL_RWE: u32 = 0b111; // EN | RD_EN | WR_EN
+
+fn fold(sum: u32, value: u32) -> u32 {
+    sum.rotate_left(5) ^ value
+}
+
 pub struct Segments {
     pub ro_a: SegmentInfo,
     pub ro_b: SegmentInfo,
@@ -107,57 +120,66 @@ impl GlobalSecHardware {
         }
     }
 
+    /// Apply the static region table in one pass: full access for
+    /// every master window. Returns (expected, applied) checksums for
+    /// the caller to extend with its flash windows and verify.
+    fn apply_master_regions(&self) -> (u32, u32) {
+        let r = &*self.registers;
+        let ctrls: [&ReadWrite<u32, REGION_CTRL::Register>; 12] = [
+            &r.cpu0_d_region0_ctrl,
+            &r.cpu0_d_region1_ctrl,
+            &r.cpu0_d_region2_ctrl,
+            &r.cpu0_d_region3_ctrl,
+            &r.ddma0_region0_ctrl,
+            &r.ddma0_region1_ctrl,
+            &r.ddma0_region2_ctrl,
+            &r.ddma0_region3_ctrl,
+            &r.dusb0_region0_ctrl,
+            &r.dusb0_region1_ctrl,
+            &r.dusb0_region2_ctrl,
+            &r.dusb0_region3_ctrl,
+        ];
+        let mut expected: u32 = 0;
+        let mut applied: u32 = 0;
+
+        for ctrl in ctrls.iter() {
+            ctrl.set(REGION_CTRL_RWE);
+            expected = fold(expected, REGION_CTRL_RWE);
+            applied = fold(applied, ctrl.get());
+        }
+        (expected, applied)
+    }
+
+    /// Program one flash window (base, size register value, RWE ctrl)
+    /// and fold the read-back of all three registers into the running
+    /// checksums.
+    fn apply_flash_window(&self,
+                          base_reg: &ReadWrite<u32>,
+                          size_reg: &ReadWrite<u32>,
+                          ctrl_reg: &ReadWrite<u32, REGION_CTRL::Register>,
+                          base: u32,
+                          size: u32,
+                          sums: &mut (u32, u32)) {
+        base_reg.set(base);
+        size_reg.set(size);
+        ctrl_reg.set(REGION_CTRL_RWE);
+        for &(want, got) in [(base, base_reg.get()),
+                             (size, size_reg.get()),
+                             (REGION_CTRL_RWE, ctrl_reg.get())].iter() {
+            sums.0 = fold(sums.0, want);
+            sums.1 = fold(sums.1, got);
+        }
+    }
+
+    fn verify(sums: (u32, u32)) {
+        if sums.0 != sums.1 {
+            println!("Tock: GLOBALSEC config checksum mismatch \
+                      (want {:08x} got {:08x})", sums.0, sums.1);
+        }
+    }
+
     pub fn init(&mut self, segments: Segments) {
-        self.registers.cpu0_d_region0_ctrl.write(
-            REGION_CTRL::EN::SET +
-            REGION_CTRL::RD_EN::SET +
-            REGION_CTRL::WR_EN::SET);
-        self.registers.cpu0_d_region1_ctrl.write(
-            REGION_CTRL::EN::SET +
-            REGION_CTRL::RD_EN::SET +
-            REGION_CTRL::WR_EN::SET);
-        self.registers.cpu0_d_region2_ctrl.write(
-            REGION_CTRL::EN::SET +
-            REGION_CTRL::RD_EN::SET +
-            REGION_CTRL::WR_EN::SET);
-        self.registers.cpu0_d_region3_ctrl.write(
-            REGION_CTRL::EN::SET +
-            REGION_CTRL::RD_EN::SET +
-            REGION_CTRL::WR_EN::SET);
-
-        self.registers.ddma0_region0_ctrl.write(
-            REGION_CTRL::EN::SET +
-            REGION_CTRL::RD_EN::SET +
-            REGION_CTRL::WR_EN::SET);
-        self.registers.ddma0_region1_ctrl.write(
-            REGION_CTRL::EN::SET +
-            REGION_CTRL::RD_EN::SET +
-            REGION_CTRL::WR_EN::SET);
-        self.registers.ddma0_region2_ctrl.write(
-            REGION_CTRL::EN::SET +
-            REGION_CTRL::RD_EN::SET +
-            REGION_CTRL::WR_EN::SET);
-        self.registers.ddma0_region3_ctrl.write(
-            REGION_CTRL::EN::SET +
-            REGION_CTRL::RD_EN::SET +
-            REGION_CTRL::WR_EN::SET);
-
-        self.registers.dusb0_region0_ctrl.write(
-            REGION_CTRL::EN::SET +
-            REGION_CTRL::RD_EN::SET +
-            REGION_CTRL::WR_EN::SET);
-        self.registers.dusb0_region1_ctrl.write(
-            REGION_CTRL::EN::SET +
-            REGION_CTRL::RD_EN::SET +
-            REGION_CTRL::WR_EN::SET);
-        self.registers.dusb0_region2_ctrl.write(
-            REGION_CTRL::EN::SET +
-            REGION_CTRL::RD_EN::SET +
-            REGION_CTRL::WR_EN::SET);
-        self.registers.dusb0_region3_ctrl.write(
-            REGION_CTRL::EN::SET +
-            REGION_CTRL::RD_EN::SET +
-            REGION_CTRL::WR_EN::SET);
+        let mut sums = self.apply_master_regions();
 
         // Flash regions:
         // - REGION0 : Active RO image, already locked
@@ -179,14 +201,6 @@ impl GlobalSecHardware {
             },
             _ => println!("Tock: Unknown flash_region0_base")
         }
-        // Enable the inactive RO for reads and writes.
-        self.registers.flash_region2_base_addr.set(
-            H1_FLASH_START + self.runtime_segment_info.inactive_ro.address);
-        self.registers.flash_region2_size.set(self.runtime_segment_info.inactive_ro.size);
-        self.registers.flash_region2_ctrl.write(
-            REGION_CTRL::EN::SET +
-            REGION_CTRL::RD_EN::SET +
-            REGION_CTRL::WR_EN::SET);
 
         // Determine the inactive RW.
         match self.registers.flash_region1_base_addr.get() {
@@ -200,14 +214,43 @@ impl GlobalSecHardware {
             }
             _ => println!("Tock: Unknown flash_region1_base")
         }
-        // Enable the inactive RW for reads and writes.
-        self.registers.flash_region3_base_addr.set(
-            H1_FLASH_START + self.runtime_segment_info.inactive_rw.address);
-        self.registers.flash_region3_size.set(self.runtime_segment_info.inactive_rw.size);
-        self.registers.flash_region3_ctrl.write(
-            REGION_CTRL::EN::SET +
-            REGION_CTRL::RD_EN::SET +
-            REGION_CTRL::WR_EN::SET);
+
+        // Enable the inactive RO and RW for reads and writes.
+        self.apply_flash_window(
+            &self.registers.flash_region2_base_addr,
+            &self.registers.flash_region2_size,
+            &self.registers.flash_region2_ctrl,
+            H1_FLASH_START + self.runtime_segment_info.inactive_ro.address,
+            self.runtime_segment_info.inactive_ro.size,
+            &mut sums);
+        self.apply_flash_window(
+            &self.registers.flash_region3_base_addr,
+            &self.registers.flash_region3_size,
+            &self.registers.flash_region3_ctrl,
+            H1_FLASH_START + self.runtime_segment_info.inactive_rw.address,
+            self.runtime_segment_info.inactive_rw.size,
+            &mut sums);
+
+        Self::verify(sums);
+    }
+
+    /// Static boot configuration for boards without A/B image windows:
+    /// the master region table plus one read-write flash window
+    /// (golf2 uses it for the personality and NvCounter pages).
+    /// `size` is the raw SIZE register value, i.e. one less than the
+    /// window's byte size. Checksummed like `init`.
+    pub fn init_with_flash_window(&self, base: u32, size: u32) {
+        let mut sums = self.apply_master_regions();
+
+        self.apply_flash_window(
+            &self.registers.flash_region2_base_addr,
+            &self.registers.flash_region2_size,
+            &self.registers.flash_region2_ctrl,
+            base,
+            size,
+            &mut sums);
+
+        Self::verify(sums);
     }
 }
 
@@ -55,6 +55,13 @@ impl From<DigestError> for SyscallError {
     }
 }
 
+/// Client of an asynchronous finalize: notified from the engine's
+/// completion interrupt once the digest is ready to be read with
+/// `finalize_result`.
+pub trait DigestAsyncClient {
+    fn finalize_done(&self);
+}
+
 pub trait DigestEngine {
     /// Initializes the digest engine for the given mode.
     fn initialize(&self, mode: DigestMode) -> Result<(), DigestError>;
@@ -78,4 +85,12 @@ pub trait DigestEngine {
     /// to match the finalize() signature.
     fn finalize_hidden(&self) -> Result<usize, DigestError>;
 
+    /// Starts finalizing the digest without waiting for the engine.
+    /// The registered client is notified from the completion interrupt
+    /// and reads the digest with `finalize_result`.
+    fn finalize_async(&self) -> Result<(), DigestError>;
+
+    /// Reads out the finished digest after an asynchronous finalize
+    /// has completed. Returns the number of bytes stored.
+    fn finalize_result(&self, output: &mut [u8]) -> Result<usize, DigestError>;
 }
@@ -0,0 +1,72 @@
+// Copyright 2021 Google LLC
+//
+// Licensed under the Apache License, Version 2.0 (the "License");
+// you may not use this file except in compliance with the License.
+// You may obtain a copy of the License at
+//
+//     https://www.apache.org/licenses/LICENSE-2.0
+//
+// Unless required by applicable law or agreed to in writing, software
+// distributed under the License is distributed on an "AS IS" BASIS,
+// WITHOUT WARRANTIES OR CONDITIONS OF ANY KIND, either express or implied.
+// See the License for the specific language governing permissions and
+// limitations under the License.
+
+//! Word-burst data movement between memory and peripheral FIFOs.
+//!
+//! The H1 has no general-purpose DMA controller: every peripheral
+//! FIFO is fed and drained by the CPU. The byte-to-word packing the
+//! drivers were each doing ad hoc lives here instead, so a transfer
+//! moves four bytes per bus transaction everywhere and the packing
+//! rules (little-endian within the word, explicit padding) are
+//! written once. Buffer ownership and completion stay with the usual
+//! kernel pattern: drivers park buffers in TakeCells while the
+//! hardware works and hand them back through their client callbacks.
+//!
+//! The helpers are generic over a word sink or source closure because
+//! the drivers use different register types (`VolatileCell`,
+//! `tock-registers` FIFO arrays).
+
+/// Packs the largest whole-word prefix of `data` into little-endian
+/// words and pushes each into `sink`. Returns the number of bytes
+/// consumed; the caller moves any unaligned tail itself (a stream
+/// FIFO takes it as byte writes, a block FIFO pads it with
+/// `burst_out_padded`).
+pub fn burst_out_words<F: FnMut(u32)>(data: &[u8], mut sink: F) -> usize {
+    let words = data.len() / 4;
+    for i in 0..words {
+        let word = (data[4 * i] as u32) |
+                   (data[4 * i + 1] as u32) << 8 |
+                   (data[4 * i + 2] as u32) << 16 |
+                   (data[4 * i + 3] as u32) << 24;
+        sink(word);
+    }
+    words * 4
+}
+
+/// Packs all of `data` into little-endian words and pushes each into
+/// `sink`, filling the bytes of the final partial word with `pad`.
+pub fn burst_out_padded<F: FnMut(u32)>(data: &[u8], pad: u8, mut sink: F) {
+    let consumed = burst_out_words(data, &mut sink);
+    if consumed < data.len() {
+        let mut word: u32 = 0;
+        for byte in 0..4 {
+            let b = data.get(consumed + byte).cloned().unwrap_or(pad);
+            word |= (b as u32) << (8 * byte);
+        }
+        sink(word);
+    }
+}
+
+/// Fills `buf` from `source`, pulling one little-endian word per four
+/// bytes; `buf` need not be a whole number of words, the spare bytes
+/// of the last word pulled are dropped.
+pub fn burst_in<F: FnMut() -> u32>(buf: &mut [u8], mut source: F) {
+    let mut word: u32 = 0;
+    for idx in 0..buf.len() {
+        if idx % 4 == 0 {
+            word = source();
+        }
+        buf[idx] = (word >> (8 * (idx % 4))) as u8;
+    }
+}
@@ -24,6 +24,11 @@ pub struct MuxFlash<'f> {
     driver: &'f dyn Flash<'f>,
     users: List<'f, FlashUser<'f>>,
     in_flight: OptionalCell<&'f FlashUser<'f>>,
+    // The user whose operation was dispatched most recently. Scheduling
+    // resumes just past this user, so a user that requeues an operation
+    // from every completion callback (a DFU or provisioning write
+    // stream) cannot starve the other users' single operations.
+    last_served: Cell<Option<&'f FlashUser<'f>>>,
 }
 
 #[derive(Copy, Clone, PartialEq)]
@@ -125,17 +130,34 @@ impl<'f> MuxFlash<'f> {
             driver: driver,
             users: List::new(),
             in_flight: OptionalCell::empty(),
+            last_served: Cell::new(None),
         }
     }
 
+    // Picks the next user with a pending operation, round-robin: the
+    // first pending user after last_served in list order, wrapping back
+    // to the head if there is none.
+    fn next_user(&self) -> Option<&'f FlashUser<'f>> {
+        let mut seen_last = self.last_served.get().is_none();
+        let mut first_pending = None;
+        let mut after_last = None;
+        for node in self.users.iter() {
+            if node.operation.get() != Operation::Idle {
+                if first_pending.is_none() { first_pending = Some(node); }
+                if seen_last && after_last.is_none() { after_last = Some(node); }
+            }
+            if let Some(last) = self.last_served.get() {
+                if core::ptr::eq(node, last) { seen_last = true; }
+            }
+        }
+        after_last.or(first_pending)
+    }
+
     fn do_next_op(&self) {
         if self.in_flight.is_some() {
             return;
         } // busy
-        let mnode = self
-            .users
-            .iter()
-            .find(|node| node.operation.get() != Operation::Idle);
+        let mnode = self.next_user();
         // This code is mostly borrowed from virtual_flash in
         // mainline Tock's capsule directory
         mnode.map(|node| {
@@ -161,10 +183,14 @@ impl<'f> MuxFlash<'f> {
                     }
                 },
             );
+            self.last_served.set(Some(node));
             self.in_flight.set(node);
         });
     }
 
+    // Reads are synchronous loads from the memory-mapped flash and are
+    // served immediately, ahead of any queued writes or erases; only the
+    // hardware itself can stall them (a program pulse on the same macro).
     fn read(&self, word: usize) -> ReturnCode {
         self.driver.read(word)
     }
@@ -15,6 +15,7 @@
 pub mod aes;
 pub mod common;
 pub mod digest;
+pub mod dma;
 pub mod flash;
 pub mod fuse;
 pub mod globalsec;
@@ -51,6 +51,14 @@ pub trait Personality<'a> {
     /// Set the device's attestation data from a slice; this slice
     /// must be at least 2048 bytes long.
     fn set_u8(&self, personality: &mut [u8]) -> ReturnCode;
+
+    /// Update `data.len()` bytes of the device's attestation data
+    /// starting `offset` bytes into the structure, leaving the rest
+    /// untouched. Returns SUCCESS if a write was started, in which case
+    /// completion is signaled through `set_partial_done`; returns
+    /// SuccessWithValue if the stored data already matches the update,
+    /// in which case the flash is not touched and no callback is issued.
+    fn set_partial_u8(&self, data: &mut [u8], offset: usize) -> ReturnCode;
 }
 
 /// A [Personality](trait.Personality.html) client
@@ -65,4 +73,8 @@ pub trait Client<'a> {
     /// Called by (Personality)[trait.Personality.html] when a call to
     /// `set_u8` has been committed to nonvolatile storage.
     fn set_u8_done(&self, rval: ReturnCode);
+
+    /// Called by (Personality)[trait.Personality.html] when a call to
+    /// `set_partial_u8` has been committed to nonvolatile storage.
+    fn set_partial_done(&self, rval: ReturnCode);
 }
@@ -18,4 +18,13 @@ pub trait SpiHost {
     /// `enable`: Whether to enable (`true`) or disable (`false`) waiting for
     /// the BUSY bit to be cleared.
     fn wait_busy_clear_in_transactions(&self, enable: bool);
+
+    /// Set the SCK clock divider. The resulting SCK frequency is
+    /// PCLK / (divider + 1), so 0 runs SCK at the undivided peripheral
+    /// clock. The reset default is a conservative rate that any
+    /// attached part can keep up with; callers may raise it once they
+    /// have established what the attached flash supports.
+    ///
+    /// `divider`: Divider minus one (0-4095).
+    fn set_sck_divider(&self, divider: u32);
 }
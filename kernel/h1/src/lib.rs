@@ -32,18 +32,23 @@ pub mod io;
 
 pub mod chip;
 pub mod crypto;
+pub mod fault_dump;
 pub mod fuse;
 pub mod globalsec;
 pub mod gpio;
 pub mod hil;
+pub mod mpu;
 pub mod nvcounter;
 pub mod personality;
 pub mod pinmux;
 pub mod pmu;
+pub mod probe;
 pub mod spi_host;
 pub mod spi_device;
+pub mod syscall_profile;
 pub mod timels;
 pub mod timeus;
+pub mod trace_stream;
 pub mod trng;
 pub mod uart;
 pub mod usb;
@@ -167,6 +172,9 @@ pub unsafe fn init() {
 
     dcrypto_test::run_dcrypto();
     rng_test::run_rng();
+    // Raw sample capture for offline min-entropy assessment; feeds
+    // trng::Trng::set_conditioning_ratio() tuning.
+    rng_test::run_raw_capture(4096);
     flash_test.run();
     nvcounter_test.run();
     */
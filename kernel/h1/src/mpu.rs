@@ -0,0 +1,139 @@
+// Copyright 2021 Google LLC
+//
+// Licensed under the Apache License, Version 2.0 (the "License");
+// you may not use this file except in compliance with the License.
+// You may obtain a copy of the License at
+//
+//     https://www.apache.org/licenses/LICENSE-2.0
+//
+// Unless required by applicable law or agreed to in writing, software
+// distributed under the License is distributed on an "AS IS" BASIS,
+// WITHOUT WARRANTIES OR CONDITIONS OF ANY KIND, either express or implied.
+// See the License for the specific language governing permissions and
+// limitations under the License.
+
+//! Caching wrapper around the Cortex-M3 MPU.
+//!
+//! Every return to userspace reprograms the MPU regions from the
+//! scheduled process's configuration. On our two-app boards the
+//! scheduler re-enters the same process for long stretches -- a
+//! u2f_app-dominated schedule traps into the kernel on every digest
+//! and crypto shim call -- so most of those reprogrammings write back
+//! the exact state the hardware already holds. This wrapper remembers
+//! which configuration was last written and skips `configure_mpu` when
+//! it is asked for the same one again. Any call that can mutate a
+//! configuration drops the cache, so a stale skip is impossible.
+
+use core::cell::Cell;
+use kernel::mpu;
+
+pub struct CachedMpu {
+    inner: cortexm3::mpu::MPU,
+
+    /// Address of the configuration currently programmed into the
+    /// hardware, or 0 when unknown. Process configurations live at
+    /// stable addresses for the life of the process, so the address
+    /// identifies the configuration.
+    programmed: Cell<usize>,
+}
+
+impl CachedMpu {
+    pub const unsafe fn new() -> CachedMpu {
+        CachedMpu {
+            inner: cortexm3::mpu::MPU::new(),
+            programmed: Cell::new(0),
+        }
+    }
+}
+
+impl mpu::MPU for CachedMpu {
+    type MpuConfig = <cortexm3::mpu::MPU as mpu::MPU>::MpuConfig;
+
+    fn clear_mpu(&self) {
+        self.programmed.set(0);
+        self.inner.clear_mpu();
+    }
+
+    fn enable_app_mpu(&self) {
+        self.inner.enable_app_mpu();
+    }
+
+    fn disable_app_mpu(&self) {
+        self.inner.disable_app_mpu();
+    }
+
+    fn number_total_regions(&self) -> usize {
+        self.inner.number_total_regions()
+    }
+
+    fn allocate_region(
+        &self,
+        unallocated_memory_start: *const u8,
+        unallocated_memory_size: usize,
+        min_region_size: usize,
+        permissions: mpu::Permissions,
+        config: &mut Self::MpuConfig,
+    ) -> Option<mpu::Region> {
+        // The caller may be mutating the configuration that is live in
+        // the hardware (e.g. an IPC region added at runtime).
+        self.programmed.set(0);
+        self.inner.allocate_region(
+            unallocated_memory_start,
+            unallocated_memory_size,
+            min_region_size,
+            permissions,
+            config,
+        )
+    }
+
+    fn allocate_app_memory_region(
+        &self,
+        unallocated_memory_start: *const u8,
+        unallocated_memory_size: usize,
+        min_memory_size: usize,
+        initial_app_memory_size: usize,
+        initial_kernel_memory_size: usize,
+        permissions: mpu::Permissions,
+        config: &mut Self::MpuConfig,
+    ) -> Option<(*const u8, usize)> {
+        self.programmed.set(0);
+        self.inner.allocate_app_memory_region(
+            unallocated_memory_start,
+            unallocated_memory_size,
+            min_memory_size,
+            initial_app_memory_size,
+            initial_kernel_memory_size,
+            permissions,
+            config,
+        )
+    }
+
+    fn update_app_memory_region(
+        &self,
+        app_memory_break: *const u8,
+        kernel_memory_break: *const u8,
+        permissions: mpu::Permissions,
+        config: &mut Self::MpuConfig,
+    ) -> Result<(), ()> {
+        // Usually a brk/sbrk on the running process, so the hardware
+        // state is out of date the moment the grow succeeds.
+        self.programmed.set(0);
+        self.inner.update_app_memory_region(
+            app_memory_break,
+            kernel_memory_break,
+            permissions,
+            config,
+        )
+    }
+
+    fn configure_mpu(&self, config: &Self::MpuConfig) {
+        let addr = config as *const Self::MpuConfig as usize;
+        if self.programmed.get() == addr {
+            // Re-entering the process whose regions are already
+            // programmed: nothing to write.
+            return;
+        }
+        self.inner.configure_mpu(config);
+        self.programmed.set(addr);
+    }
+}
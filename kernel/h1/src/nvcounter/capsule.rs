@@ -168,6 +168,14 @@ impl <'c, F: hil::flash::Flash<'c> + 'c> NvCounter<'c> for FlashCounter<'c, F> {
         }
     }
 
+    fn read(&self) -> ReturnCode {
+        let high_count = read_page_count(Page::High, self.flash);
+        let low_count = read_page_count(Page::Low, self.flash);
+        ReturnCode::SuccessWithValue {
+            value: counter_value(high_count, low_count) as usize
+        }
+    }
+
     fn set_client(&self, client: &'c dyn Client) {
         self.client.set(Some(client));
     }
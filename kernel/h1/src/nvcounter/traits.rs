@@ -29,6 +29,11 @@ pub trait NvCounter<'c> {
     /// a Client::increment_done call to know whether the operation succeeded.
     fn read_and_increment(&self) -> ReturnCode;
 
+    /// Reads the current counter value without modifying it. Returns
+    /// SuccessWithValue; never writes or erases flash, and may be called
+    /// while an increment is ongoing.
+    fn read(&self) -> ReturnCode;
+
     fn set_client(&self, client: &'c dyn Client);
 }
 
@@ -18,7 +18,9 @@
 
 use core::cmp;
 use core::mem;
+use core::slice;
 use core::cell::Cell;
+use crate::hil::digest::{DigestEngine, DigestMode};
 use crate::hil::personality::{Client, Personality, PersonalityData};
 use crate::hil::flash;
 use kernel::ReturnCode;
@@ -31,19 +33,35 @@ enum State {
     WritingU8,
     ErasingStruct,
     WritingStruct,
+    ErasingPartial,
+    WritingPartialPage,
+    WritingPartialWords,
 }
 
 pub struct PersonalityDriver<'a> {
     state: Cell<State>,
     client: OptionalCell<&'a dyn Client<'a>>,
     flash: OptionalCell<&'a dyn flash::Flash<'a>>,
+    digest: OptionalCell<&'a dyn DigestEngine>,
+    // Latched certificate-hash verdict: Some(v) once verified, cleared
+    // back to None by any write to the personality.
+    cert_valid: Cell<Option<bool>>,
     write_buffer: TakeCell<'a, [u32]>,
+    partial_buffer: TakeCell<'a, [u32]>,
+    partial_pos: Cell<usize>,
+    partial_end: Cell<usize>,
 }
 
 pub static mut PERSONALITY: PersonalityDriver<'static> = unsafe {PersonalityDriver::new() };
 
 pub static mut BUFFER: [u32; PAGE_SIZE_U32] = [0; PAGE_SIZE_U32];
 
+// Staging buffer for partial updates; sized to the largest single write
+// transaction the flash driver supports (32 words).
+pub static mut PARTIAL_BUFFER: [u32; PARTIAL_BUFFER_WORDS] = [0; PARTIAL_BUFFER_WORDS];
+
+const PARTIAL_BUFFER_WORDS: usize = 32;
+
 
 // Personality data is stored as the third-to-last (N-3) page of flash;
 // it is followed by the two pages used as a counter.
@@ -52,13 +70,25 @@ const PERSONALITY_ADDRESS_U32: usize = PERSONALITY_ADDRESS / 4;
 const PERSONALITY_SIZE: usize = flash::h1_hw::H1_FLASH_PAGE_SIZE;
 const PAGE_SIZE_U32: usize    = flash::h1_hw::H1_FLASH_PAGE_SIZE / 4;
 
+// Byte offsets of fields within PersonalityData (repr(C)): checksum,
+// salt, pub_x and pub_y precede the certificate hash, then the length
+// word, then the certificate itself.
+const CERT_HASH_OFFSET: usize = 4 * (4 * 8);
+const CERT_LEN_OFFSET: usize  = CERT_HASH_OFFSET + 4 * 8;
+const CERT_OFFSET: usize      = CERT_LEN_OFFSET + 4;
+
 impl<'a> PersonalityDriver<'a> {
     const unsafe fn new() -> PersonalityDriver<'a> {
         PersonalityDriver {
             state: Cell::new(State::Idle),
             client: OptionalCell::empty(),
             flash: OptionalCell::empty(),
+            digest: OptionalCell::empty(),
+            cert_valid: Cell::new(None),
             write_buffer: TakeCell::empty(),
+            partial_buffer: TakeCell::empty(),
+            partial_pos: Cell::new(0),
+            partial_end: Cell::new(0),
         }
     }
 
@@ -70,10 +100,65 @@ impl<'a> PersonalityDriver<'a> {
         self.write_buffer.replace(buf);
     }
 
+    pub fn set_partial_buffer(&self, buf: &'a mut [u32]) {
+        self.partial_buffer.replace(buf);
+    }
+
+    pub fn set_digest(&self, digest: &'a dyn DigestEngine) {
+        self.digest.set(digest);
+    }
+
+    /// Hashes the flash-resident certificate with the digest engine and
+    /// compares it against the stored certificate hash, latching the
+    /// verdict so attestation reads can be served checksum-free. Run
+    /// once at boot, before the engine is shared with userspace; any
+    /// write to the personality clears the latch.
+    pub fn verify_certificate(&self) -> bool {
+        if let Some(valid) = self.cert_valid.get() {
+            return valid;
+        }
+        let valid = self.digest.map_or(false, |engine| {
+            let image = unsafe {
+                slice::from_raw_parts(self.address() as *const u8,
+                                      PERSONALITY_SIZE)
+            };
+            let len = (image[CERT_LEN_OFFSET] as usize) |
+                      (image[CERT_LEN_OFFSET + 1] as usize) << 8 |
+                      (image[CERT_LEN_OFFSET + 2] as usize) << 16 |
+                      (image[CERT_LEN_OFFSET + 3] as usize) << 24;
+            if len == 0 || len > PERSONALITY_SIZE - CERT_OFFSET {
+                return false;
+            }
+            let mut digest = [0; 32];
+            if engine.initialize(DigestMode::Sha256).is_err() ||
+                engine.update(&image[CERT_OFFSET..CERT_OFFSET + len]).is_err() ||
+                engine.finalize(&mut digest).is_err() {
+                return false;
+            }
+            digest[..] == image[CERT_HASH_OFFSET..CERT_HASH_OFFSET + 32]
+        });
+        self.cert_valid.set(Some(valid));
+        valid
+    }
+
+    /// Returns the latched verdict from `verify_certificate`, or None
+    /// when no verification has run since the last write.
+    pub fn certificate_valid(&self) -> Option<bool> {
+        self.cert_valid.get()
+    }
+
     pub fn set_client(&self, client: &'a dyn Client<'a>) {
         self.client.replace(client);
     }
 
+    /// Returns the memory-mapped address of the flash-resident
+    /// personality data. The region is CPU-readable, so callers that can
+    /// tolerate read-only access may use it directly instead of copying
+    /// the full structure out through get()/get_u8().
+    pub fn address(&self) -> usize {
+        flash::h1_hw::H1_FLASH_START + PERSONALITY_ADDRESS
+    }
+
     fn start_write(&self, target: usize) -> bool {
         if self.flash.is_none() || self.write_buffer.is_none() {
             false
@@ -92,6 +177,39 @@ impl<'a> PersonalityDriver<'a> {
         }
     }
 
+    /// Programs the next chunk of changed words for a partial update;
+    /// returns true if a flash write was started. Each transaction
+    /// programs a full staging buffer; a short tail is backed up within
+    /// the page so the last few words before it are rewritten with the
+    /// values they already hold.
+    fn stage_partial_chunk(&self) -> bool {
+        if self.flash.is_none() || self.partial_buffer.is_none() {
+            return false;
+        }
+        let end = self.partial_end.get();
+        let mut pos = self.partial_pos.get();
+        let buf = self.partial_buffer.take().unwrap();
+        if end - pos < buf.len() {
+            pos = end.saturating_sub(buf.len());
+        }
+        self.write_buffer.map(|buffer| {
+            for i in 0..buf.len() {
+                buf[i] = buffer[pos + i];
+            }
+        });
+        self.partial_pos.set(pos + buf.len());
+        self.flash.map(move |flash| {
+            let (_rcode, opt) = flash.write(PERSONALITY_ADDRESS_U32 + pos, buf);
+            match opt {
+                None => true,  // Operation successful
+                Some(buf) => { // Not successful
+                    self.partial_buffer.replace(buf);
+                    false
+                }
+            }
+        }).unwrap()
+    }
+
 }
 
 impl<'a> Personality<'a> for PersonalityDriver<'a> {
@@ -159,6 +277,7 @@ impl<'a> Personality<'a> for PersonalityDriver<'a> {
                 let rval = flash.erase(page);
                 match rval {
                     ReturnCode::SUCCESS => {
+                        self.cert_valid.set(None);
                         self.write_buffer.map(|buffer| {
                             self.state.set(State::ErasingStruct);
                             unsafe {
@@ -199,6 +318,7 @@ impl<'a> Personality<'a> for PersonalityDriver<'a> {
 
                     match rval {
                         ReturnCode::SUCCESS => {
+                            self.cert_valid.set(None);
                             self.write_buffer.map(|buffer| {
                                 self.state.set(State::ErasingU8);
                                 let len = cmp::min(data.len(), flash::h1_hw::H1_FLASH_PAGE_SIZE);
@@ -222,6 +342,94 @@ impl<'a> Personality<'a> for PersonalityDriver<'a> {
             }
         }
     }
+
+    fn set_partial_u8(&self, data: &mut [u8], offset: usize) -> ReturnCode {
+        if data.len() == 0 ||
+            offset.checked_add(data.len()).map_or(true, |end| end > PERSONALITY_SIZE) {
+            return ReturnCode::ESIZE;
+        }
+        if self.state.get() != State::Idle {
+            return ReturnCode::EBUSY;
+        }
+        if self.flash.is_none() || self.write_buffer.is_none() ||
+            self.partial_buffer.is_none() {
+            return ReturnCode::ENOMEM;
+        }
+        // Read-modify-write: fetch the current page image, merge the
+        // update into it, and record which words actually changed and
+        // whether any changed word needs a bit set back to 1 (which
+        // flash can only do with a page erase).
+        let merged = self.flash.map(|flash| {
+            self.write_buffer.map(|buffer| {
+                for i in 0..PAGE_SIZE_U32 {
+                    match flash.read(PERSONALITY_ADDRESS_U32 + i) {
+                        ReturnCode::SuccessWithValue{value: v} => buffer[i] = v as u32,
+                        _ => return None,
+                    }
+                }
+                let first_word = offset / 4;
+                let last_word = (offset + data.len() - 1) / 4;
+                let mut changed = None;
+                let mut needs_erase = false;
+                for word in first_word..(last_word + 1) {
+                    let old = buffer[word];
+                    let mut bytes = old.to_le_bytes();
+                    for byte in 0..4 {
+                        let index = word * 4 + byte;
+                        if index >= offset && index < offset + data.len() {
+                            bytes[byte] = data[index - offset];
+                        }
+                    }
+                    let new = u32::from_le_bytes(bytes);
+                    if new != old {
+                        buffer[word] = new;
+                        changed = Some(match changed {
+                            None => (word, word + 1),
+                            Some((first, _end)) => (first, word + 1),
+                        });
+                        if old & new != new {
+                            needs_erase = true;
+                        }
+                    }
+                }
+                Some((changed, needs_erase))
+            }).unwrap()
+        }).unwrap();
+
+        match merged {
+            None => ReturnCode::FAIL,
+            Some((None, _)) => {
+                // The stored data already matches the update; tell the
+                // caller no write was started (and so no callback will
+                // come) without spending an erase/program cycle.
+                ReturnCode::SuccessWithValue { value: 0 }
+            }
+            Some((Some((first, end)), false)) => {
+                // Every changed bit is a 1 -> 0 transition, so the
+                // affected words can be programmed in place without
+                // erasing the page.
+                self.cert_valid.set(None);
+                self.partial_pos.set(first);
+                self.partial_end.set(end);
+                self.state.set(State::WritingPartialWords);
+                if self.stage_partial_chunk() {
+                    ReturnCode::SUCCESS
+                } else {
+                    self.state.set(State::Idle);
+                    ReturnCode::FAIL
+                }
+            }
+            Some((Some(_), true)) => {
+                let page = PERSONALITY_ADDRESS / flash::h1_hw::H1_FLASH_PAGE_SIZE;
+                let rval = self.flash.map(|flash| flash.erase(page)).unwrap();
+                if rval == ReturnCode::SUCCESS {
+                    self.cert_valid.set(None);
+                    self.state.set(State::ErasingPartial);
+                }
+                rval
+            }
+        }
+    }
 }
 
 impl<'a> flash::Client<'a> for PersonalityDriver<'a> {
@@ -247,25 +455,56 @@ impl<'a> flash::Client<'a> for PersonalityDriver<'a> {
                     self.state.set(State::Idle);
                 }
             },
+
+            State::ErasingPartial => {
+                if self.start_write(target) {
+                    self.state.set(State::WritingPartialPage);
+                } else {
+                    self.client.map(|c| c.set_partial_done(ReturnCode::FAIL));
+                    self.state.set(State::Idle);
+                }
+            },
             _ => { // Should never happen -pal
                 debug!("Erase done called but in state {:?}", state);
             }
         }
     }
 
-    fn write_done(&self, _data: &'a mut [u32], rcode: ReturnCode) {
+    fn write_done(&self, data: &'a mut [u32], rcode: ReturnCode) {
         let state = self.state.get();
         match state {
             State::WritingStruct => {
+                self.write_buffer.replace(data);
                 self.state.set(State::Idle);
                 self.client.map(|c| c.set_done(rcode));
             },
             State::WritingU8 => {
+                self.write_buffer.replace(data);
                 self.state.set(State::Idle);
                 self.client.map(|c| {
                     c.set_u8_done(rcode);
                 });
             },
+            State::WritingPartialPage => {
+                self.write_buffer.replace(data);
+                self.state.set(State::Idle);
+                self.client.map(|c| c.set_partial_done(rcode));
+            },
+            State::WritingPartialWords => {
+                self.partial_buffer.replace(data);
+                if rcode != ReturnCode::SUCCESS {
+                    self.state.set(State::Idle);
+                    self.client.map(|c| c.set_partial_done(rcode));
+                } else if self.partial_pos.get() < self.partial_end.get() {
+                    if !self.stage_partial_chunk() {
+                        self.state.set(State::Idle);
+                        self.client.map(|c| c.set_partial_done(ReturnCode::FAIL));
+                    }
+                } else {
+                    self.state.set(State::Idle);
+                    self.client.map(|c| c.set_partial_done(ReturnCode::SUCCESS));
+                }
+            },
             _ => { // Should never happen -pal
                 debug!(" -- ERROR: personality::write_done in state {:?}", state);
             },
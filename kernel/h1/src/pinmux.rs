@@ -165,6 +165,82 @@ pub struct Registers {
 
 pub const PINMUX: *mut Registers = 0x40060000 as *mut Registers;
 
+// Boot-time pin configuration is table-driven: a board describes its
+// whole pinout as a const array of entries and applies it in one pass,
+// instead of scattering per-pin register writes through
+// reset_handler. Entries address registers by word offset within the
+// block, computed from the pad and function enums, so a table entry
+// costs two words of flash and one store at boot.
+
+/// One pinmux register write.
+#[derive(Clone, Copy)]
+pub enum Entry {
+    /// Route a DIO pad's output to a peripheral function.
+    PadFunction { pad: SelectablePin, function: Function },
+    /// Program a DIO pad's control register (bit 2: input enable,
+    /// bit 4: pull-up enable).
+    PadControl { pad: SelectablePin, bits: u32 },
+    /// Route a peripheral's input from a DIO pad.
+    PeripheralInput { function: Function, pad: SelectablePin },
+}
+
+// Word offset of the first peripheral select register; the 31 pads
+// before it are select/control pairs.
+const PERIPHERAL_WORD: usize = 62;
+
+// Index of a pad's register pair within the block. SelectablePin
+// enumerates the pads in reverse struct order, except that `resetb`
+// (which is not selectable) sits between diob7 and vio0.
+fn pad_index(pad: SelectablePin) -> usize {
+    match pad {
+        SelectablePin::Vio1 => 30,
+        SelectablePin::Vio0 => 29,
+        pad => 30 - pad as usize,
+    }
+}
+
+impl Entry {
+    fn register(self) -> (usize, u32) {
+        match self {
+            Entry::PadFunction { pad, function } =>
+                (2 * pad_index(pad), function as u32),
+            Entry::PadControl { pad, bits } =>
+                (2 * pad_index(pad) + 1, bits),
+            // Peripheral selects follow the pads and mirror the
+            // Function enum's order (Default has no register).
+            Entry::PeripheralInput { function, pad } =>
+                (PERIPHERAL_WORD + function as usize - 1, pad as u32),
+        }
+    }
+}
+
+/// Apply a configuration table in one pass.
+pub unsafe fn apply(table: &[Entry]) {
+    let base = PINMUX as *mut u32;
+
+    for entry in table {
+        let (word, value) = entry.register();
+        core::ptr::write_volatile(base.add(word), value);
+    }
+}
+
+/// Diff-apply: write only entries whose register does not already hold
+/// the requested value, so runtime reconfiguration can resubmit a full
+/// table and touch just what changed.
+pub unsafe fn reapply(table: &[Entry]) {
+    let base = PINMUX as *mut u32;
+
+    for entry in table {
+        let (word, value) = entry.register();
+        let reg = base.add(word);
+
+        if core::ptr::read_volatile(reg) != value {
+            core::ptr::write_volatile(reg, value);
+        }
+    }
+}
+
+#[derive(Clone, Copy)]
 #[repr(u32)]
 pub enum SelectablePin {
     Disconnected = 0,
@@ -200,6 +276,7 @@ pub enum SelectablePin {
     Diom0 = 30,
 }
 
+#[derive(Clone, Copy)]
 #[repr(u32)]
 pub enum Function {
     Default = 0,
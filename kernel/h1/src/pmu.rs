@@ -151,11 +151,21 @@ pub struct PMURegisters {
     pub _peripheral_clocks0_ro_mask: VolatileCell<u32>,
     pub _peripheral_clocks1_ro_mask: VolatileCell<u32>,
 
-    pub _gate_on_sleep_set0: VolatileCell<u32>,
-    pub _gate_on_sleep_clr0: VolatileCell<u32>,
+    /// Gate the corresponding peripheral clocks while the processor
+    /// sleeps (bank 0). Only effective when nap_enable is set.
+    pub gate_on_sleep_set0: VolatileCell<u32>,
 
-    pub _gate_on_sleep_set1: VolatileCell<u32>,
-    pub _gate_on_sleep_clr1: VolatileCell<u32>,
+    /// Keep the corresponding peripheral clocks running while the
+    /// processor sleeps (bank 0).
+    pub gate_on_sleep_clr0: VolatileCell<u32>,
+
+    /// Gate the corresponding peripheral clocks while the processor
+    /// sleeps (bank 1). Only effective when nap_enable is set.
+    pub gate_on_sleep_set1: VolatileCell<u32>,
+
+    /// Keep the corresponding peripheral clocks running while the
+    /// processor sleeps (bank 1).
+    pub gate_on_sleep_clr1: VolatileCell<u32>,
 
     pub _clock0: VolatileCell<u32>,
     pub _reset0_write_enable: VolatileCell<u32>,
@@ -272,6 +282,130 @@ impl Clock {
             }
         }
     }
+
+    /// Keeps this clock at full rate while the processor sleeps,
+    /// overriding nap gating.
+    pub fn run_during_sleep(&self) {
+        let pmu: &mut PMURegisters = unsafe { transmute(PMU) };
+        match self.clock {
+            PeripheralClock::Bank0(clock) => {
+                unsafe {pmu.gate_on_sleep_clr0.set(1 << (clock as u32))};
+            }
+            PeripheralClock::Bank1(clock) => {
+                unsafe {pmu.gate_on_sleep_clr1.set(1 << (clock as u32))};
+            }
+        }
+    }
+
+    /// Lets the PMU gate this clock while the processor sleeps (when
+    /// nap_enable is set).
+    pub fn gate_during_sleep(&self) {
+        let pmu: &mut PMURegisters = unsafe { transmute(PMU) };
+        match self.clock {
+            PeripheralClock::Bank0(clock) => {
+                unsafe {pmu.gate_on_sleep_set0.set(1 << (clock as u32))};
+            }
+            PeripheralClock::Bank1(clock) => {
+                unsafe {pmu.gate_on_sleep_set1.set(1 << (clock as u32))};
+            }
+        }
+    }
+}
+
+// Power-state telemetry. The chip's sleep() brackets every wfi with
+// sleep_track_enter/exit and the crypto turbo hooks below bracket
+// engine activity, so the accumulators split wall time into sleep,
+// active, and engine-boosted spans. Timestamps come from Timeus
+// counter 0 (24 ticks per microsecond), the same source the syscall
+// profiler uses; the u64 accumulators never wrap in practice. Plain
+// statics are safe here for the same reason they are for the
+// peripheral singletons: the kernel is single threaded.
+static mut SLEEP_TICKS: u64 = 0;
+static mut SLEEP_COUNT: u32 = 0;
+static mut SLEEP_SINCE: u32 = 0;
+static mut CRYPTO_TICKS: u64 = 0;
+static mut CRYPTO_SINCE: u32 = 0;
+
+fn telemetry_now() -> u32 {
+    // Read-only alias of Timeus counter 0; the boards configure it at
+    // reset and nothing reprograms it afterwards.
+    unsafe { crate::timeus::Timeus::new(0) }.now()
+}
+
+/// Called by the chip immediately before wfi.
+pub fn sleep_track_enter() {
+    unsafe {
+        SLEEP_SINCE = telemetry_now();
+    }
+}
+
+/// Called by the chip immediately after wfi returns.
+pub fn sleep_track_exit() {
+    unsafe {
+        SLEEP_TICKS += telemetry_now().wrapping_sub(SLEEP_SINCE) as u64;
+        SLEEP_COUNT = SLEEP_COUNT.wrapping_add(1);
+    }
+}
+
+/// Cumulative time spent asleep (in wfi) since boot, in microseconds.
+pub fn sleep_time_us() -> u64 {
+    unsafe { SLEEP_TICKS / 24 }
+}
+
+/// Number of sleep periods since boot. Together with sleep_time_us
+/// this distinguishes long quiet sleeps from wakeup churn.
+pub fn sleep_count() -> u32 {
+    unsafe { SLEEP_COUNT }
+}
+
+/// Cumulative time the crypto engine clocks were held at full rate by
+/// in-flight operations, in microseconds. Includes the currently
+/// running span, if any, so samples taken mid-operation still diff
+/// correctly.
+pub fn crypto_time_us() -> u64 {
+    unsafe {
+        let mut ticks = CRYPTO_TICKS;
+        if CRYPTO_TURBO_ACTIVE > 0 {
+            ticks += telemetry_now().wrapping_sub(CRYPTO_SINCE) as u64;
+        }
+        ticks / 24
+    }
+}
+
+// Number of crypto engine operations currently in flight; guards the
+// sleep-gating exemption below.
+static mut CRYPTO_TURBO_ACTIVE: usize = 0;
+
+/// Marks a crypto engine operation as started. While any operation is in
+/// flight the dcrypto and key manager clocks are exempt from nap gating,
+/// so a wfi in the idle loop (the common case while the kernel waits for
+/// a completion interrupt) does not throttle the running computation.
+/// Must be balanced by crypto_turbo_finish.
+pub fn crypto_turbo_start() {
+    unsafe {
+        CRYPTO_TURBO_ACTIVE += 1;
+        if CRYPTO_TURBO_ACTIVE == 1 {
+            CRYPTO_SINCE = telemetry_now();
+            Clock::new(PeripheralClock::Bank0(PeripheralClock0::Crypto0)).run_during_sleep();
+            Clock::new(PeripheralClock::Bank0(PeripheralClock0::KeyMgr0)).run_during_sleep();
+        }
+    }
+}
+
+/// Marks a crypto engine operation as complete, re-enabling sleep gating
+/// for the engine clocks once no operations remain.
+pub fn crypto_turbo_finish() {
+    unsafe {
+        if CRYPTO_TURBO_ACTIVE == 0 {
+            return;
+        }
+        CRYPTO_TURBO_ACTIVE -= 1;
+        if CRYPTO_TURBO_ACTIVE == 0 {
+            CRYPTO_TICKS += telemetry_now().wrapping_sub(CRYPTO_SINCE) as u64;
+            Clock::new(PeripheralClock::Bank0(PeripheralClock0::Crypto0)).gate_during_sleep();
+            Clock::new(PeripheralClock::Bank0(PeripheralClock0::KeyMgr0)).gate_during_sleep();
+        }
+    }
 }
 // This should be refactored to be a general reset
 pub fn reset_dcrypto() {
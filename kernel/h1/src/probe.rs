@@ -0,0 +1,87 @@
+// Copyright 2021 Google LLC
+//
+// Licensed under the Apache License, Version 2.0 (the "License");
+// you may not use this file except in compliance with the License.
+// You may obtain a copy of the License at
+//
+//     https://www.apache.org/licenses/LICENSE-2.0
+//
+// Unless required by applicable law or agreed to in writing, software
+// distributed under the License is distributed on an "AS IS" BASIS,
+// WITHOUT WARRANTIES OR CONDITIONS OF ANY KIND, either express or implied.
+// See the License for the specific language governing permissions and
+// limitations under the License.
+
+//! Logic-analyzer probe points.
+//!
+//! Console timestamps and host-side timing can only see syscall
+//! boundaries; a probe pin flips at the instrumented event itself, so
+//! an analyzer on the pad captures true hardware-level latency. The
+//! channels ride GPIO0 pins 0 and 1, which golf2 already muxes out to
+//! the LED and button pads, so no pinmux changes are needed — just
+//! don't run an app that drives those pins while probing. Only golf2
+//! calls init(); do NOT enable the feature for papa, where GPIO0 pins
+//! 0-3 drive the BMC reset lines.
+//!
+//! Everything here is gated on the h1 crate's `probes` feature; in a
+//! default build the functions are empty and the compiler removes the
+//! calls, so production images carry no instrumentation cost. With the
+//! feature on, a probe transition is a shadow-register update and one
+//! volatile store — tens of nanoseconds, cheap enough for interrupt
+//! paths. The whole data_out register is written (no read-modify-write
+//! of hardware state), which is why the shadow exists and why the
+//! probe port must not be shared with another data_out writer.
+
+use crate::gpio::{GPIO0_BASE, PortRegisters};
+
+/// Probe channels; the value is the bit driven on the probe port.
+#[derive(Clone, Copy)]
+pub enum Probe {
+    /// High from a U2F frame landing in the RX FIFO until the reply
+    /// frame finishes on the bus: the device's true turnaround time.
+    U2fFrame = 0,
+    /// High while a crypto engine (AES or dcrypto) is running.
+    CryptoBusy = 1,
+}
+
+#[allow(unused)]
+static mut PROBE_SHADOW: u32 = 0;
+
+/// Enables output on the probe pins. Boards call this unconditionally
+/// during reset; it does nothing unless the `probes` feature is on.
+pub fn init() {
+    if cfg!(feature = "probes") {
+        let port: &PortRegisters = unsafe { &*GPIO0_BASE };
+        port.output_enable.set(1 << Probe::U2fFrame as u32 |
+                               1 << Probe::CryptoBusy as u32);
+    }
+}
+
+/// Drives the probe's pin high.
+#[inline]
+pub fn set(probe: Probe) {
+    if cfg!(feature = "probes") {
+        unsafe {
+            PROBE_SHADOW |= 1 << probe as u32;
+            (&*GPIO0_BASE).data_out.set(PROBE_SHADOW);
+        }
+    }
+}
+
+/// Drives the probe's pin low.
+#[inline]
+pub fn clear(probe: Probe) {
+    if cfg!(feature = "probes") {
+        unsafe {
+            PROBE_SHADOW &= !(1 << probe as u32);
+            (&*GPIO0_BASE).data_out.set(PROBE_SHADOW);
+        }
+    }
+}
+
+/// A high-then-low blip for point events with no duration to show.
+#[inline]
+pub fn pulse(probe: Probe) {
+    set(probe);
+    clear(probe);
+}
@@ -23,6 +23,26 @@ pub unsafe fn run_rng() {
     r.run();
 }
 
+// Streams raw (unconditioned) TRNG samples to the console as
+// machine-parseable `RAW trng ...` lines for offline min-entropy
+// assessment (SP800-90B). Blocks for the whole capture; run it
+// instead of, not alongside, the normal boot.
+pub unsafe fn run_raw_capture(words: usize) {
+    let mut buf = [0u32; 8];
+    let mut remaining = words;
+
+    while remaining > 0 {
+        let n = core::cmp::min(remaining, buf.len());
+        trng::TRNG0.capture_raw(&mut buf[..n]);
+        print!("RAW trng");
+        for w in &buf[..n] {
+            print!(" {:08x}", w);
+        }
+        print!("\n");
+        remaining -= n;
+    }
+}
+
 unsafe fn static_init_test_rng() -> &'static mut TestRng<'static> {
     static_init!(
         TestRng<'static>,
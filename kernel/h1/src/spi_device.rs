@@ -1,6 +1,7 @@
 use crate::hil::spi_device::SpiDevice;
 use crate::hil::spi_device::SpiDeviceClient;
 
+use core::cell::Cell;
 use core::cmp::min;
 
 use kernel::common::cells::OptionalCell;
@@ -492,6 +493,11 @@ pub struct SpiDeviceHardware {
     registers: StaticRef<Registers>,
     client: OptionalCell<&'static dyn SpiDeviceClient>,
     config: SpiDeviceConfiguration,
+    // Number of leading generic_ram bytes the last payload dirtied.
+    // Everything past this is still the erased 0xff pattern, so
+    // put_send_data only rewrites the bytes that need it instead of
+    // refilling the whole 2 KiB buffer on every transaction.
+    tx_dirty: Cell<usize>,
 }
 
 impl SpiDeviceHardware {
@@ -500,6 +506,9 @@ impl SpiDeviceHardware {
             registers: base_addr,
             client: OptionalCell::empty(),
             config: config,
+            // Conservative until clear_send_data establishes the erased
+            // pattern.
+            tx_dirty: Cell::new(2048),
         }
     }
 
@@ -738,6 +747,7 @@ impl SpiDeviceHardware {
         for idx in 0..self.registers.generic_ram.len() {
             self.registers.generic_ram[idx].set(!0);
         }
+        self.tx_dirty.set(0);
     }
 
     fn clear_rx_interrupt(&self) {
@@ -918,9 +928,12 @@ impl SpiDevice for SpiDeviceHardware {
         for idx in 0..write_data.len() {
             self.registers.generic_ram[idx].set(write_data[idx]);
         }
-        for idx in write_data.len()..self.registers.generic_ram.len() {
+        // Only the bytes the previous payload dirtied need re-erasing;
+        // the rest of the buffer is already 0xff.
+        for idx in write_data.len()..self.tx_dirty.get() {
             self.registers.generic_ram[idx].set(!0);
         }
+        self.tx_dirty.set(write_data.len());
 
         ReturnCode::SUCCESS
     }
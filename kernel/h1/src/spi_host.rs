@@ -1,3 +1,4 @@
+use crate::hil::dma;
 use crate::hil::spi_host::SpiHost;
 use core::cell::Cell;
 use core::cmp::min;
@@ -9,6 +10,11 @@ use kernel::ReturnCode;
 
 // The TX and RX FIFOs both have the same length. We write and read at the same
 // time.
+//
+// The FIFOs are word-organized (the CTRL TXBYTOR/RXBYTOR fields select the
+// byte order within a buffer word), so they are accessed 32 bits at a time:
+// one bus transaction moves four bytes, which matters for passthrough
+// transfers that fill the whole FIFO per transaction.
 
 // Registers for the SPI host controller
 register_structs! {
@@ -19,8 +25,8 @@ register_structs! {
         (0x000c => istate: ReadOnly<u32, ISTATE::Register>),
         (0x0010 => istate_clr: ReadWrite<u32, ISTATE_CLR::Register>),
         (0x0014 => _reserved),
-        (0x1000 => tx_fifo: [WriteOnly<u8>; 128]),
-        (0x1080 => rx_fifo: [ReadOnly<u8>; 128]),
+        (0x1000 => tx_fifo: [WriteOnly<u32>; 32]),
+        (0x1080 => rx_fifo: [ReadOnly<u32>; 32]),
         (0x1100 => @END),
     }
 }
@@ -87,6 +93,9 @@ register_bitfields![u32,
     ]
 ];
 
+// FIFO length in bytes (32 words of 4 bytes each).
+const FIFO_SIZE: usize = 128;
+
 const SPI_HOST0_BASE_ADDR: u32 = 0x4070_0000;
 const SPI_HOST1_BASE_ADDR: u32 = 0x4071_0000;
 
@@ -177,10 +186,8 @@ impl SpiHostHardware {
         transaction_len: usize) -> ReturnCode {
         //debug!("SpiHostHardware::start_transaction: transaction_len={}", transaction_len);
         // The transaction needs at least one byte.
-        // It also cannot have more bytes than tx_fifo or rx_fifo is long.
-        if (transaction_len == 0) ||
-            (transaction_len > self.registers.tx_fifo.len()) ||
-            (transaction_len > self.registers.rx_fifo.len()) {
+        // It also cannot have more bytes than the FIFOs are long.
+        if (transaction_len == 0) || (transaction_len > FIFO_SIZE) {
             //debug!("SpiHostHardware::start_transaction: Invalid transaction_len={}", transaction_len);
             return ReturnCode::ESIZE;
         }
@@ -190,17 +197,23 @@ impl SpiHostHardware {
         let mut tx_buf_len = 0;
         write_buffer.as_ref().map(|tx_buf| {
             tx_buf_len = min(tx_buf.len(), transaction_len);
-            for idx in 0..tx_buf_len {
-                self.registers.tx_fifo[idx].set(tx_buf[idx]);
-            }
         });
 
-        // Clear the TX FIFO for additional bytes not supplied by write_buffer.
-        // Since we have no control over how many bytes the SPI host reads, we
-        // want to make sure to not accidentally leak information that made it
-        // into the TX FIFO beyond the length of the `write_buffer`.
-        for idx in tx_buf_len..transaction_len {
-            self.registers.tx_fifo[idx].set(0xff);
+        // Fill the FIFO a word at a time (byte 0 of the transaction is the
+        // low byte of the word; TXBYTOR is clear). Bytes not supplied by
+        // write_buffer are padded with 0xff: since we have no control over
+        // how many bytes the SPI host reads, we want to make sure to not
+        // accidentally leak information that made it into the TX FIFO
+        // beyond the length of the `write_buffer`.
+        let tx_data = write_buffer.as_ref()
+            .map_or(&[] as &[u8], |tx_buf| &tx_buf[..tx_buf_len]);
+        let mut word_idx = 0;
+        dma::burst_out_padded(tx_data, 0xff, |word| {
+            self.registers.tx_fifo[word_idx].set(word);
+            word_idx += 1;
+        });
+        for idx in word_idx..(transaction_len + 3) / 4 {
+            self.registers.tx_fifo[idx].set(0xffff_ffff);
         }
 
         write_buffer.map(|buf| {
@@ -219,10 +232,14 @@ impl SpiHostHardware {
 
     fn read_data(&self, read_buffer: &mut [u8]) {
         let read_len = min(read_buffer.len(), self.transaction_len.get());
-        for idx in 0..read_len {
-            let val = self.registers.rx_fifo[idx].get();
-            read_buffer[idx] = val;
-        }
+        // Drain the FIFO a word at a time (the first byte received is the
+        // low byte of the word; RXBYTOR is clear).
+        let mut word_idx = 0;
+        dma::burst_in(&mut read_buffer[..read_len], || {
+            let word = self.registers.rx_fifo[word_idx].get();
+            word_idx += 1;
+            word
+        });
     }
 }
 
@@ -236,6 +253,12 @@ impl SpiHost for SpiHostHardware {
         self.registers.xact.modify(
             if enabled { XACT::RDY_POLL::SET } else { XACT::RDY_POLL::CLEAR });
     }
+
+    fn set_sck_divider(&self, divider: u32) {
+        // IDIV is 12 bits; `init` programs the conservative reset
+        // default (divide by 3).
+        self.registers.ctrl.modify(CTRL::IDIV.val(min(divider, 0xfff)));
+    }
 }
 
 impl SpiMaster for SpiHostHardware {
@@ -0,0 +1,143 @@
+// Copyright 2021 Google LLC
+//
+// Licensed under the Apache License, Version 2.0 (the "License");
+// you may not use this file except in compliance with the License.
+// You may obtain a copy of the License at
+//
+//     https://www.apache.org/licenses/LICENSE-2.0
+//
+// Unless required by applicable law or agreed to in writing, software
+// distributed under the License is distributed on an "AS IS" BASIS,
+// WITHOUT WARRANTIES OR CONDITIONS OF ANY KIND, either express or implied.
+// See the License for the specific language governing permissions and
+// limitations under the License.
+
+//! Optional syscall and interrupt latency profiler.
+//!
+//! Built with the `syscall_profile` cargo feature, the boards wrap every
+//! `with_driver` dispatch and the chip wraps every interrupt handler
+//! dispatch with calls into this module, which appends
+//! `{kind, id, timestamp}` records to a RAM ring. Timestamps are read
+//! from Timeus counter 0, which the boards start at reset with divider 1
+//! (24 ticks per microsecond, wrapping every ~179 seconds).
+//!
+//! The point is attributing latency between a syscall and its completion
+//! callback to hardware vs. kernel scheduling: for example, the gap
+//! between the dcrypto driver's syscall-exit record and the next
+//! irq-enter record for ISR 4 (dcrypto done) is the hardware run time
+//! plus interrupt-pending time, while the remainder up to the following
+//! syscall-enter is spent in the kernel and other processes. `dump()`
+//! prints the ring over the debug console and resets it; command 2 of
+//! the timestamp driver triggers it from userspace.
+//!
+//! Without the feature every entry point compiles to an empty inline
+//! function, so the call sites in the boards and chip cost nothing.
+
+pub const KIND_SYSCALL_ENTER: u8 = 1;
+pub const KIND_SYSCALL_EXIT: u8 = 2;
+pub const KIND_IRQ_ENTER: u8 = 3;
+pub const KIND_IRQ_EXIT: u8 = 4;
+
+#[cfg(feature = "syscall_profile")]
+mod ring {
+    pub const ENTRIES: usize = 256;
+
+    #[derive(Clone, Copy)]
+    pub struct Event {
+        pub kind: u8,
+        /// Driver number for syscall events, NVIC number for irq events.
+        pub id: u32,
+        pub time: u32,
+    }
+
+    // The kernel is single threaded and interrupt handlers only run from
+    // the kernel loop, so plain statics are safe here, as they are for
+    // the peripheral singletons.
+    pub static mut EVENTS: [Event; ENTRIES] =
+        [Event { kind: 0, id: 0, time: 0 }; ENTRIES];
+
+    /// Total records ever written; `NEXT % ENTRIES` is the write index,
+    /// so older records are overwritten once the ring fills.
+    pub static mut NEXT: usize = 0;
+}
+
+#[cfg(feature = "syscall_profile")]
+fn record(kind: u8, id: u32) {
+    // Read-only alias of Timeus counter 0; the boards configure it at
+    // reset and nothing reprograms it afterwards.
+    let time = unsafe { crate::timeus::Timeus::new(0) }.now();
+    unsafe {
+        ring::EVENTS[ring::NEXT % ring::ENTRIES] =
+            ring::Event { kind: kind, id: id, time: time };
+        ring::NEXT += 1;
+    }
+    // With the binary stream built in, profiler events also go out
+    // through it, so the host gets them unformatted and without the
+    // console printing cost of dump().
+    crate::trace_stream::emit_kernel(kind, id, 0);
+}
+
+#[cfg(feature = "syscall_profile")]
+pub fn syscall_enter(driver_num: usize) {
+    record(KIND_SYSCALL_ENTER, driver_num as u32);
+}
+
+#[cfg(feature = "syscall_profile")]
+pub fn syscall_exit(driver_num: usize) {
+    record(KIND_SYSCALL_EXIT, driver_num as u32);
+}
+
+#[cfg(feature = "syscall_profile")]
+pub fn irq_enter(nvic_num: u32) {
+    record(KIND_IRQ_ENTER, nvic_num);
+}
+
+#[cfg(feature = "syscall_profile")]
+pub fn irq_exit(nvic_num: u32) {
+    record(KIND_IRQ_EXIT, nvic_num);
+}
+
+/// Prints the recorded events, oldest first, and resets the ring. One
+/// line per record: sequence number, kind, id (driver or NVIC number)
+/// and the raw 24Mhz timestamp.
+#[cfg(feature = "syscall_profile")]
+pub fn dump() {
+    unsafe {
+        let total = ring::NEXT;
+        let start = if total > ring::ENTRIES { total - ring::ENTRIES } else { 0 };
+        debug!("syscall_profile: {} events, showing {} (24 ticks/us):",
+               total, total - start);
+        for i in start..total {
+            let e = ring::EVENTS[i % ring::ENTRIES];
+            let kind = match e.kind {
+                KIND_SYSCALL_ENTER => "sys+",
+                KIND_SYSCALL_EXIT => "sys-",
+                KIND_IRQ_ENTER => "irq+",
+                KIND_IRQ_EXIT => "irq-",
+                _ => "????",
+            };
+            debug!("P{:06} {} {:08x} {:010}", i, kind, e.id, e.time);
+        }
+        ring::NEXT = 0;
+    }
+}
+
+#[cfg(not(feature = "syscall_profile"))]
+#[inline(always)]
+pub fn syscall_enter(_driver_num: usize) {}
+
+#[cfg(not(feature = "syscall_profile"))]
+#[inline(always)]
+pub fn syscall_exit(_driver_num: usize) {}
+
+#[cfg(not(feature = "syscall_profile"))]
+#[inline(always)]
+pub fn irq_enter(_nvic_num: u32) {}
+
+#[cfg(not(feature = "syscall_profile"))]
+#[inline(always)]
+pub fn irq_exit(_nvic_num: u32) {}
+
+#[cfg(not(feature = "syscall_profile"))]
+#[inline(always)]
+pub fn dump() {}
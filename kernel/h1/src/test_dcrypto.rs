@@ -12,7 +12,14 @@
 // See the License for the specific language governing permissions and
 // limitations under the License.
 
-//! Test DCRYPTO hardware
+//! Test and benchmark DCRYPTO hardware
+//!
+//! After the correctness tests pass, a benchmark phase times the
+//! engine-level phases (IMEM upload, program execution) separately,
+//! without any syscall overhead, and prints one machine-parseable
+//! `BENCH dcrypto <phase> key=value ...` line per phase. Cycle counts
+//! come from Timeus counter 0, which the boards run at the 24Mhz core
+//! clock.
 
 use core::cell::Cell;
 use crate::crypto::dcrypto::{Dcrypto, DcryptoClient, DcryptoEngine, ProgramFault};
@@ -23,11 +30,18 @@ enum TestCase {
     None,
     SuccessfulExecution,
     StackError,
+    Benchmark,
 }
 
+// Size of the benchmark upload; on the order of our real programs
+// (the P256 image is ~1KB).
+const BENCH_PROGRAM_BYTES: usize = 512;
+
 pub struct TestDcrypto<'a> {
     dcrypto: &'a DcryptoEngine<'a>,
     case: Cell<TestCase>,
+    // Cycle count when the benchmarked program was started.
+    bench_start: Cell<u32>,
 }
 
 impl<'a> TestDcrypto<'a> {
@@ -35,6 +49,7 @@ impl<'a> TestDcrypto<'a> {
         TestDcrypto {
             dcrypto: d,
             case: Cell::new(TestCase::None),
+            bench_start: Cell::new(0),
         }
     }
 
@@ -42,13 +57,19 @@ impl<'a> TestDcrypto<'a> {
         self.start_test_exec();
     }
 
+    fn cycles() -> u32 {
+        // Read-only alias of Timeus counter 0, as in syscall_profile.
+        unsafe { crate::timeus::Timeus::new(0) }.now()
+    }
+
     fn start_test_exec(&self) {
         self.case.set(TestCase::SuccessfulExecution);
         println!("DCRYPTO Testing single-instruction program that returns.");
         static INSTRUCTIONS: [u8; 4] = [
             0x00, 0x00, 0x00, 0x0c, // RET
         ];
-        self.dcrypto.write_instructions(&INSTRUCTIONS, 0, 4);
+        // Length is in words.
+        self.dcrypto.write_instructions(&INSTRUCTIONS, 0, 1);
         self.dcrypto.call_imem(0);
     }
 
@@ -73,10 +94,34 @@ impl<'a> TestDcrypto<'a> {
             0x00, 0x00, 0x00, 0x08, // CALL 0
             0x00, 0x00, 0x00, 0x00, // BREAK
         ];
-        self.dcrypto.write_instructions(&INSTRUCTIONS, 0, 8);
+        // Length is in words.
+        self.dcrypto.write_instructions(&INSTRUCTIONS, 0, 2);
+        self.dcrypto.call_imem(0);
+    }
+
+    // Times the IMEM upload synchronously, then starts a trivial
+    // program to time the call/completion path; complete_test_bench()
+    // reports it.
+    fn start_test_bench(&self) {
+        self.case.set(TestCase::Benchmark);
+        let mut program = [0; BENCH_PROGRAM_BYTES];
+        program[3] = 0x0c; // RET at the entry point; the rest is BREAK
+        let before = Self::cycles();
+        self.dcrypto.write_instructions(&program, 0,
+                                        (BENCH_PROGRAM_BYTES / 4) as u32);
+        println!("BENCH dcrypto imem_write bytes={} cycles={}",
+                 BENCH_PROGRAM_BYTES,
+                 Self::cycles().wrapping_sub(before));
+        self.bench_start.set(Self::cycles());
         self.dcrypto.call_imem(0);
     }
 
+    fn complete_test_bench(&self, error: ReturnCode) {
+        let cycles = Self::cycles().wrapping_sub(self.bench_start.get());
+        self.case.set(TestCase::None);
+        println!("BENCH dcrypto exec cycles={} error={:?}", cycles, error);
+    }
+
     // A PC stack overflow raises two interrupts, first an overflow then
     // a trap. 
     fn complete_test_stack(&self, error: ReturnCode, fault: ProgramFault) {
@@ -101,14 +146,18 @@ impl<'a> DcryptoClient<'a> for TestDcrypto<'a> {
             }
             TestCase::StackError => {
                 self.complete_test_stack(error, fault);
+                if self.case.get() == TestCase::None {
+                    println!("DCRYPTO all tests passed!");
+                    self.start_test_bench();
+                }
+            }
+            TestCase::Benchmark => {
+                self.complete_test_bench(error);
             }
             TestCase::None => {
                 println!("DCRYPTO received execution complete for no test case.");
             }
         }
-        if self.case.get() == TestCase::None {
-            println!("DCRYPTO all tests passed!");
-        }
     }
 
     fn reset_complete(&self, _error: ReturnCode) {
@@ -12,6 +12,7 @@
 // See the License for the specific language governing permissions and
 // limitations under the License.
 
+use core::cell::Cell;
 use core::mem;
 use kernel::common::cells::VolatileCell;
 
@@ -99,6 +100,11 @@ const BASE_REGISTERS: *const Registers = 0x40670000 as *const Registers;
 pub struct Timeus {
     regs: &'static Registers,
     idx: usize,
+    /// Software extension of the 32-bit hardware counter: the number of
+    /// wraps observed so far and the value seen by the last `now64()`
+    /// read, used to detect the next wrap.
+    wraps: Cell<u32>,
+    last: Cell<u32>,
 }
 
 impl Timeus {
@@ -111,6 +117,8 @@ impl Timeus {
         Timeus {
             regs: mem::transmute(BASE_REGISTERS),
             idx: idx,
+            wraps: Cell::new(0),
+            last: Cell::new(0),
         }
     }
 
@@ -118,6 +126,21 @@ impl Timeus {
         unsafe {self.counter().current_value.get()}
     }
 
+    /// The counter widened to 64 bits in software, so it never wraps in
+    /// practice (~585,000 years at 1Mhz). Wraps are detected by the
+    /// value moving backwards between reads, so this is only monotonic
+    /// if it is called on the same `Timeus` instance at least once per
+    /// hardware wrap period (~71 minutes at 1Mhz); the timestamp
+    /// syscall driver owns its counter and is the only reader.
+    pub fn now64(&self) -> u64 {
+        let cur = self.now();
+        if cur < self.last.get() {
+            self.wraps.set(self.wraps.get() + 1);
+        }
+        self.last.set(cur);
+        (self.wraps.get() as u64) << 32 | cur as u64
+    }
+
 
     pub fn start(&self) {
         let counter = self.counter();
@@ -126,6 +149,15 @@ impl Timeus {
                 counter.wrapping.set(Enable::Enabled)};
     }
 
+    /// Starts the counter ticking once per microsecond (divider 24 at
+    /// the 24Mhz input), wrapping at the 32-bit limit (~71 minutes).
+    pub fn start_us(&self) {
+        let counter = self.counter();
+        unsafe {counter.max_value.set(!0); // MAX_INT
+                counter.divider.set(24);
+                counter.wrapping.set(Enable::Enabled)};
+    }
+
     fn counter(&self) -> &Counter {
         &self.regs.counters[self.idx]
     }
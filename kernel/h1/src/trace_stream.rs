@@ -0,0 +1,184 @@
+// Copyright 2021 Google LLC
+//
+// Licensed under the Apache License, Version 2.0 (the "License");
+// you may not use this file except in compliance with the License.
+// You may obtain a copy of the License at
+//
+//     https://www.apache.org/licenses/LICENSE-2.0
+//
+// Unless required by applicable law or agreed to in writing, software
+// distributed under the License is distributed on an "AS IS" BASIS,
+// WITHOUT WARRANTIES OR CONDITIONS OF ANY KIND, either express or implied.
+// See the License for the specific language governing permissions and
+// limitations under the License.
+
+//! RTT-style binary trace stream.
+//!
+//! A RAM ring of fixed-size binary records that both the kernel and
+//! apps append to, built with the `trace_stream` cargo feature. Unlike
+//! the text debug console, writing a record is a handful of stores and
+//! a timestamp read — cheap enough for hot paths — and nothing is
+//! formatted on the device: a drainer (the low_level_debug app, via
+//! the tracelog syscall driver) copies raw records out in batches and
+//! streams them over the UART while the system is otherwise idle.
+//!
+//! Each record carries a monotonically increasing sequence number.
+//! When the ring wraps before the drainer catches up, the oldest
+//! records are overwritten and the drain skips ahead, so the host sees
+//! a gap in sequence numbers and knows exactly how many records were
+//! lost — the stream never blocks a writer to avoid loss.
+//!
+//! Record layout (20 bytes, little-endian, matching the wire format):
+//! seq: u32, time: u32 (24MHz Timeus counter 0), id: u32,
+//! arg: u32, source: u8, kind: u8, pad: u16. With the
+//! `syscall_profile` feature also enabled, profiler events are
+//! mirrored in as kernel records, giving them a lossless, unformatted
+//! path off the device.
+//!
+//! Without the feature every entry point compiles to an empty inline
+//! function and the ring is not allocated.
+
+/// Serialized record size in bytes.
+pub const RECORD_BYTES: usize = 20;
+
+pub const SOURCE_KERNEL: u8 = 0;
+pub const SOURCE_APP: u8 = 1;
+
+#[cfg(feature = "trace_stream")]
+mod ring {
+    use super::RECORD_BYTES;
+
+    /// 128 records = 2.5KB of RAM.
+    pub const ENTRIES: usize = 128;
+
+    // The kernel is single threaded and syscalls/interrupt handlers
+    // only run from the kernel loop, so plain statics are safe here,
+    // as they are for the syscall profiler's ring.
+    pub static mut RECORDS: [[u8; RECORD_BYTES]; ENTRIES] =
+        [[0; RECORD_BYTES]; ENTRIES];
+
+    /// Total records ever written; `NEXT % ENTRIES` is the write slot.
+    pub static mut NEXT: u32 = 0;
+    /// Sequence number of the next record to drain.
+    pub static mut READ: u32 = 0;
+}
+
+#[cfg(feature = "trace_stream")]
+pub fn enabled() -> bool {
+    true
+}
+
+#[cfg(feature = "trace_stream")]
+fn emit(source: u8, kind: u8, id: u32, arg: u32) {
+    let time = unsafe { crate::timeus::Timeus::new(0) }.now();
+    unsafe {
+        let seq = ring::NEXT;
+        let rec = &mut ring::RECORDS[(seq as usize) % ring::ENTRIES];
+        rec[0..4].copy_from_slice(&seq.to_le_bytes());
+        rec[4..8].copy_from_slice(&time.to_le_bytes());
+        rec[8..12].copy_from_slice(&id.to_le_bytes());
+        rec[12..16].copy_from_slice(&arg.to_le_bytes());
+        rec[16] = source;
+        rec[17] = kind;
+        rec[18] = 0;
+        rec[19] = 0;
+        ring::NEXT = seq.wrapping_add(1);
+    }
+}
+
+/// Appends a kernel-sourced record.
+#[cfg(feature = "trace_stream")]
+pub fn emit_kernel(kind: u8, id: u32, arg: u32) {
+    emit(SOURCE_KERNEL, kind, id, arg);
+}
+
+/// Appends an app-sourced record (called by the tracelog syscall
+/// driver; kind carries the low bits of the app identifier).
+#[cfg(feature = "trace_stream")]
+pub fn emit_app(kind: u8, id: u32, arg: u32) {
+    emit(SOURCE_APP, kind, id, arg);
+}
+
+/// Number of records currently waiting to be drained.
+#[cfg(feature = "trace_stream")]
+pub fn available() -> usize {
+    unsafe { ring::NEXT.wrapping_sub(ring::READ) as usize }
+}
+
+/// Copies whole undrained records into `buf`, oldest first, and
+/// returns the number of bytes written. If the ring overwrote records
+/// the drainer had not fetched yet, the read cursor jumps to the
+/// oldest surviving record; the host detects the loss from the gap in
+/// sequence numbers.
+#[cfg(feature = "trace_stream")]
+pub fn drain(buf: &mut [u8]) -> usize {
+    let mut written = 0;
+    unsafe {
+        let mut pending = ring::NEXT.wrapping_sub(ring::READ);
+        if pending as usize > ring::ENTRIES {
+            ring::READ = ring::NEXT.wrapping_sub(ring::ENTRIES as u32);
+            pending = ring::ENTRIES as u32;
+        }
+        while pending > 0 && written + RECORD_BYTES <= buf.len() {
+            let rec = &ring::RECORDS[(ring::READ as usize) % ring::ENTRIES];
+            buf[written..written + RECORD_BYTES].copy_from_slice(rec);
+            ring::READ = ring::READ.wrapping_add(1);
+            pending -= 1;
+            written += RECORD_BYTES;
+        }
+    }
+    written
+}
+
+/// Copies the most recent records into `buf`, oldest first, and
+/// returns the number of bytes written. Unlike `drain`, the read
+/// cursor does not move and already-drained records are included:
+/// this is post-mortem capture (the panic fault dump), not streaming.
+#[cfg(feature = "trace_stream")]
+pub fn snapshot(buf: &mut [u8]) -> usize {
+    let mut written = 0;
+    unsafe {
+        let held = core::cmp::min(ring::NEXT as usize, ring::ENTRIES);
+        let take = core::cmp::min(held, buf.len() / RECORD_BYTES);
+        let mut seq = ring::NEXT.wrapping_sub(take as u32);
+        for _ in 0..take {
+            let rec = &ring::RECORDS[(seq as usize) % ring::ENTRIES];
+            buf[written..written + RECORD_BYTES].copy_from_slice(rec);
+            seq = seq.wrapping_add(1);
+            written += RECORD_BYTES;
+        }
+    }
+    written
+}
+
+#[cfg(not(feature = "trace_stream"))]
+#[inline(always)]
+pub fn enabled() -> bool {
+    false
+}
+
+#[cfg(not(feature = "trace_stream"))]
+#[inline(always)]
+pub fn emit_kernel(_kind: u8, _id: u32, _arg: u32) {}
+
+#[cfg(not(feature = "trace_stream"))]
+#[inline(always)]
+pub fn emit_app(_kind: u8, _id: u32, _arg: u32) {}
+
+#[cfg(not(feature = "trace_stream"))]
+#[inline(always)]
+pub fn available() -> usize {
+    0
+}
+
+#[cfg(not(feature = "trace_stream"))]
+#[inline(always)]
+pub fn drain(_buf: &mut [u8]) -> usize {
+    0
+}
+
+#[cfg(not(feature = "trace_stream"))]
+#[inline(always)]
+pub fn snapshot(_buf: &mut [u8]) -> usize {
+    0
+}
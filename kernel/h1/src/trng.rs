@@ -135,9 +135,32 @@ const TRNG0_BASE: *mut Registers = 0x40410000 as *mut Registers;
 
 pub static mut TRNG0: Trng<'static> = unsafe { Trng::new(TRNG0_BASE) };
 
+/// Words of conditioned entropy banked in the driver. The generator
+/// keeps producing into this pool from its data-ready interrupt while
+/// nobody is asking, so a request is usually a pool copy instead of a
+/// wait for the full conditioning latency.
+const POOL_WORDS: usize = 16;
+
+/// Post-processing settings. The conditioned value (bit shuffling and
+/// churn mode on, XOR and Von Neumann off) is the production setting
+/// every client word is served from. The raw value disables all
+/// post-processing and samples the 1-bit alphabet directly -- the
+/// configuration SP800-90B min-entropy assessment tools expect -- and
+/// is only ever entered by capture_raw(), which restores the
+/// conditioned setting before the driver serves another word.
+const POST_PROCESSING_CONDITIONED: u32 = 0xa;
+const POST_PROCESSING_RAW: u32 = 0x0;
+
 pub struct Trng<'a> {
     regs: *mut Registers,
     client: Cell<Option<&'a dyn Client32>>,
+    // Banked entropy. Order is irrelevant, so the pool is a stack:
+    // pool[..pool_count] holds valid words.
+    pool: Cell<[u32; POOL_WORDS]>,
+    pool_count: Cell<usize>,
+    // A client asked for entropy the pool could not fully cover; the
+    // next interrupt delivers to it rather than just banking words.
+    requested: Cell<bool>,
 }
 
 impl<'a> Trng<'a> {
@@ -145,6 +168,41 @@ impl<'a> Trng<'a> {
         Trng {
             regs: trng,
             client: Cell::new(None),
+            pool: Cell::new([0; POOL_WORDS]),
+            pool_count: Cell::new(0),
+            requested: Cell::new(false),
+        }
+    }
+
+    // Move whatever the hardware has ready into the pool.
+    fn refill_pool(&self) {
+        let regs = unsafe { &*self.regs };
+        let mut pool = self.pool.get();
+        let mut count = self.pool_count.get();
+        while count < POOL_WORDS && regs.empty.get() == 0 {
+            pool[count] = regs.read_data.get();
+            count += 1;
+        }
+        self.pool.set(pool);
+        self.pool_count.set(count);
+    }
+
+    fn pop_pool(&self) -> Option<u32> {
+        let count = self.pool_count.get();
+        if count == 0 {
+            return None;
+        }
+        self.pool_count.set(count - 1);
+        Some(self.pool.get()[count - 1])
+    }
+
+    // Leave the data-ready interrupt on whenever there is a waiting
+    // client or spare pool space; a full pool with no waiter lets the
+    // interrupt rest until a request drains it.
+    fn update_interrupt(&self) {
+        let regs = unsafe { &*self.regs };
+        if self.requested.get() || self.pool_count.get() < POOL_WORDS {
+            regs.interrupt_enable.set(0x1);
         }
     }
 
@@ -155,20 +213,29 @@ impl<'a> Trng<'a> {
         regs.interrupt_enable.set(0);
         regs.interrupt_state.set(0x1);
 
-        self.client.get().map(|client| {
-            if let Continue::More = client.entropy_available(&mut Iter(self), ReturnCode::SUCCESS) {
-                // Re-enable the interrupt since the client needs more data.
-                regs.interrupt_enable.set(0x1);
-            }
-        });
+        self.refill_pool();
+
+        if self.requested.get() {
+            self.requested.set(false);
+            self.client.get().map(|client| {
+                if let Continue::More = client.entropy_available(&mut Iter(self), ReturnCode::SUCCESS) {
+                    self.requested.set(true);
+                }
+            });
+        }
+        self.update_interrupt();
     }
 
-    pub fn init(&self) {
+    // Program the generator. The only difference between the two
+    // configurations is the post-processing chain and the slice width;
+    // the timeout envelope is shared so a stuck analog side is caught
+    // the same way in both.
+    fn configure(&self, post_processing: u32, slice_max: u32) {
         let regs = unsafe { &*self.regs };
 
-        // Enable bit shuffling and churn mode.  Disable XOR and Von Neumann processing.
-        regs.post_processing_control.set(0xa);
-        regs.slice_max_upper_limit.set(1);
+        regs.stop_work.set(1);
+        regs.post_processing_control.set(post_processing);
+        regs.slice_max_upper_limit.set(slice_max);
         regs.slice_min_lower_limit.set(0);
         regs.timeout_counter.set(0x7ff);
         regs.timeout_max_try_num.set(4);
@@ -176,6 +243,61 @@ impl<'a> Trng<'a> {
         regs.go_event.set(1);
     }
 
+    pub fn init(&self) {
+        // Enable bit shuffling and churn mode.  Disable XOR and Von Neumann processing.
+        self.configure(POST_PROCESSING_CONDITIONED, 1);
+
+        // Start banking entropy right away instead of waiting for the
+        // first request.
+        let regs = unsafe { &*self.regs };
+        regs.interrupt_enable.set(0x1);
+    }
+
+    /// Sets the output refresh counter: how many generator cycles are
+    /// folded into each conditioned output word. The reset value is
+    /// deliberately conservative; a board whose silicon has an offline
+    /// min-entropy assessment on file (collected with capture_raw) can
+    /// lower the ratio and recover conditioned throughput
+    /// proportionally. The continuous health tests downstream keep
+    /// screening the conditioned stream whatever the ratio, so a
+    /// regression is caught within one screening batch.
+    pub fn set_conditioning_ratio(&self, cycles: u32) {
+        let regs = unsafe { &*self.regs };
+
+        regs.stop_work.set(1);
+        regs.output_time_counter.set(cycles);
+        regs.go_event.set(1);
+    }
+
+    /// Fills `buf` with raw (unconditioned) samples for offline
+    /// min-entropy assessment. Blocks until the buffer is full. On the
+    /// way out the raw FIFO is drained and the banked pool dropped, so
+    /// a capture can never leak a raw word into the conditioned stream.
+    pub fn capture_raw(&self, buf: &mut [u32]) {
+        let regs = unsafe { &*self.regs };
+
+        regs.interrupt_enable.set(0);
+        self.configure(POST_PROCESSING_RAW, 0);
+
+        for word in buf.iter_mut() {
+            while regs.empty.get() != 0 {
+                if regs.fsm_state.get() & 0x8 != 0 {
+                    // TRNG timed out.  Restart.
+                    regs.stop_work.set(1);
+                    regs.go_event.set(1);
+                }
+            }
+            *word = regs.read_data.get();
+        }
+
+        while regs.empty.get() == 0 {
+            regs.read_data.get();
+        }
+        self.pool_count.set(0);
+        self.configure(POST_PROCESSING_CONDITIONED, 1);
+        self.update_interrupt();
+    }
+
 }
 
 impl<'a> Entropy32<'a> for Trng<'a> {
@@ -187,7 +309,9 @@ impl<'a> Entropy32<'a> for Trng<'a> {
     fn get(&self) -> ReturnCode {
         let regs = unsafe { &*self.regs };
 
-        if regs.empty.get() > 0 {
+        self.refill_pool();
+
+        if self.pool_count.get() == 0 && regs.empty.get() > 0 {
             // Make sure the TRNG isn't stuck.
             if regs.fsm_state.get() & 0x8 != 0 {
                 // TRNG timed out.  Restart.
@@ -195,15 +319,16 @@ impl<'a> Entropy32<'a> for Trng<'a> {
                 regs.go_event.set(1);
             }
 
-            // Enable interrupts so we know when there is random data ready.
-            regs.interrupt_enable.set(0x1);
+            // Nothing banked; deliver from the interrupt when data is ready.
+            self.requested.set(true);
         } else {
             self.client.get().map(|client| {
                 if let Continue::More = client.entropy_available(&mut Iter(self), ReturnCode::SUCCESS) {
-                    regs.interrupt_enable.set(0x1);
+                    self.requested.set(true);
                 }
             });
         }
+        self.update_interrupt();
         ReturnCode::SUCCESS
     }
 
@@ -220,6 +345,10 @@ impl<'a, 'b> Iterator for Iter<'a, 'b> {
     fn next(&mut self) -> Option<u32> {
         let regs = unsafe { &*self.0.regs };
 
+        // Banked words first, then whatever the hardware has ready.
+        if let Some(word) = self.0.pop_pool() {
+            return Some(word);
+        }
         if regs.empty.get() == 0 {
             Some(regs.read_data.get())
         } else {
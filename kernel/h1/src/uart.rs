@@ -19,6 +19,20 @@
 //! flow-control. There is no DMA for the UART, but it has a 32-character deep
 //! FIFO transmit and receive buffer.
 //!
+//! Since the hardware offers no DMA, the cheapest transmit the chip can do
+//! is a kernel-owned ring: with `set_tx_ring` attached (see the board
+//! setup), `transmit_buffer` copies the client's bytes into the ring and
+//! completes at the next TX interrupt, so a console write costs its callers
+//! a memcpy plus one FIFO refill per 32 characters instead of blocking a
+//! client buffer at wire speed for the whole drain.
+//!
+//! Receive gets the mirror-image treatment: with `set_rx_ring` attached,
+//! bytes that arrive while no client buffer is pending (or after it has
+//! filled) spill out of the hardware FIFO into the ring instead of being
+//! dropped, and the next `receive_buffer` call drains the ring first.
+//! This lets command streams run at full baud across the gaps between a
+//! client's reads, which the 32-character FIFO alone cannot cover.
+//!
 //! # Examples
 //!
 //! Before using the UART you must configure the TX and/or RX pins and set the
@@ -86,9 +100,17 @@ pub struct UART<'a> {
     tx_buffer: TakeCell<'static, [u8]>,
     tx_limit: Cell<usize>,
     tx_cursor: Cell<usize>,
+    tx_ring: TakeCell<'static, [u8]>,
+    tx_ring_head: Cell<usize>,
+    tx_ring_count: Cell<usize>,
+    tx_done_buffer: TakeCell<'static, [u8]>,
+    tx_done_len: Cell<usize>,
     rx_buffer: TakeCell<'static, [u8]>,
     rx_limit: Cell<usize>,
     rx_cursor: Cell<usize>,
+    rx_ring: TakeCell<'static, [u8]>,
+    rx_ring_head: Cell<usize>,
+    rx_ring_count: Cell<usize>,
     tx_client: OptionalCell<&'a dyn hil::uart::TransmitClient>,
     rx_client: OptionalCell<&'a dyn hil::uart::ReceiveClient>,
 }
@@ -103,9 +125,17 @@ impl<'a> UART<'a> {
             tx_buffer: TakeCell::empty(),
             tx_limit: Cell::new(0),
             tx_cursor: Cell::new(0),
+            tx_ring: TakeCell::empty(),
+            tx_ring_head: Cell::new(0),
+            tx_ring_count: Cell::new(0),
+            tx_done_buffer: TakeCell::empty(),
+            tx_done_len: Cell::new(0),
             rx_buffer: TakeCell::empty(),
             rx_limit: Cell::new(0),
             rx_cursor: Cell::new(0),
+            rx_ring: TakeCell::empty(),
+            rx_ring_head: Cell::new(0),
+            rx_ring_count: Cell::new(0),
             tx_client: OptionalCell::empty(),
             rx_client: OptionalCell::empty(),
         }
@@ -210,47 +240,65 @@ impl<'a> UART<'a> {
         while regs.state.get() & (1 << 5 | 1 << 4) != 0b110000 {}
     }
 
-    // Call this function when there might be bytes left in the `buffer` to
-    // send. Writes bytes out to the TX FIFO until there are no bytes left, or
-    // the FIFO is full. If any bytes _were_ written, it will enable the TX
-    // interrupt, which will fire when number of bytes in the FIFO drops to a
-    // certain threshold (determined by the `fifo` register and defaults to 1
-    // byte).
-    //
-    // Returns the number of bytes written, -1 if no more to write.
-    fn send_remaining_bytes(&self) -> isize {
+    /// Attach a kernel-owned ring that buffers transmitted bytes.
+    ///
+    /// With a ring attached, `transmit_buffer` stages the client's bytes
+    /// here and hands the buffer back at the next TX interrupt instead of
+    /// when the last byte has left the wire. Called once from board setup.
+    pub fn set_tx_ring(&self, ring: &'static mut [u8]) {
+        self.tx_ring.replace(ring);
+    }
+
+    /// Attach a kernel-owned ring that buffers received bytes.
+    ///
+    /// With a ring attached, bytes that arrive while no client buffer is
+    /// pending are drained out of the hardware FIFO into the ring on each
+    /// RX interrupt and handed over on the next `receive_buffer` call,
+    /// instead of overrunning the FIFO. Called once from board setup.
+    pub fn set_rx_ring(&self, ring: &'static mut [u8]) {
+        self.rx_ring.replace(ring);
+    }
+
+    // Call this function when there might be bytes left to send. Writes
+    // bytes out to the TX FIFO until there are no bytes left, or the FIFO
+    // is full: ring bytes first (they were queued earlier, which keeps
+    // wire order), then any direct client buffer. Enables the TX
+    // interrupt whenever work remains -- including a completion callback
+    // still owed -- which fires when the number of bytes in the FIFO
+    // drops to a certain threshold (determined by the `fifo` register
+    // and defaults to 1 byte).
+    fn fill_fifo(&self) {
         let regs = unsafe { &*self.regs };
 
-        // If there is no current buffer, just return zero. Probably shouldn't
-        // happen though.
-        let nwritten: isize = self.tx_buffer.map(|bytes| {
-            let init_cursor = self.tx_cursor.get();
-            let limit = self.tx_limit.get();
-            if init_cursor == limit {
-                -1 // done
-            } else {
-                for b in bytes[init_cursor..limit].iter() {
+        self.tx_ring.map(|ring| {
+            while self.tx_ring_count.get() > 0 {
+                if regs.state.get() & 1 == 1 {
+                    break; // TX FIFO full, we'll continue later
+                }
+                let head = self.tx_ring_head.get();
+                regs.write_data.set(ring[head] as u32);
+                self.tx_ring_head.set((head + 1) % ring.len());
+                self.tx_ring_count.set(self.tx_ring_count.get() - 1);
+            }
+        });
+
+        if self.tx_ring_count.get() == 0 {
+            self.tx_buffer.map(|bytes| {
+                let limit = self.tx_limit.get();
+                for b in bytes[self.tx_cursor.get()..limit].iter() {
                     if regs.state.get() & 1 == 1 {
-                        break; // TX Buffer full, we'll continue later
+                        break; // TX FIFO full, we'll continue later
                     }
                     self.tx_cursor.set(self.tx_cursor.get() + 1);
                     regs.write_data.set(*b as u32);
                 }
-                (self.tx_cursor.get() - init_cursor) as isize
-            }
-        })
-            .unwrap_or(0 as isize);
-
-        if nwritten >= 0 {
-            // if we wrote anything, we're gonna want to get notified when the FIFO has room again.
-            // Technically we could be done here if there is nothing left to send, but we want to
-            // get an interrupt anyway so we can return the buffer to the client from
-            // `handle_tx_interrupt`.
-            regs.interrupt_control.set(regs.interrupt_control.get() | 1);
+            });
         }
 
-        nwritten
-
+        if self.tx_ring_count.get() > 0 || self.tx_buffer.is_some()
+            || self.tx_done_buffer.is_some() {
+            regs.interrupt_control.set(regs.interrupt_control.get() | 1);
+        }
     }
 
     fn purge_rx_fifo(&self) {
@@ -260,28 +308,64 @@ impl<'a> UART<'a> {
             // While RX FIFO is not empty, continue to purge it
             let _rx_byte = regs.read_data.get();
         }
+
+        // Stale ring bytes go the same way as stale FIFO bytes.
+        self.rx_ring_head.set(0);
+        self.rx_ring_count.set(0);
     }
 
     fn read_rx_fifo(&self) {
-        if self.rx_buffer.is_some() {
-            let regs = unsafe { &*self.regs };
-
-            self.rx_buffer.map(|rx_buffer| {
-                while self.rx_cursor.get() < self.rx_limit.get() &&
-                    (regs.state.get() & (1 << 7)) == 0 {
-                    // While RX FIFO is not empty and we have space in the buffer ...
-                    let rx_byte = regs.read_data.get() as u8;
-                    rx_buffer[self.rx_cursor.get()] = rx_byte;
+        let regs = unsafe { &*self.regs };
+
+        self.rx_buffer.map(|rx_buffer| {
+            // Ring bytes arrived before anything still in the FIFO; hand
+            // them over first so the stream stays in wire order.
+            self.rx_ring.map(|ring| {
+                while self.rx_ring_count.get() > 0 &&
+                    self.rx_cursor.get() < self.rx_limit.get() {
+                    let head = self.rx_ring_head.get();
+                    rx_buffer[self.rx_cursor.get()] = ring[head];
                     self.rx_cursor.set(self.rx_cursor.get() + 1);
+                    self.rx_ring_head.set((head + 1) % ring.len());
+                    self.rx_ring_count.set(self.rx_ring_count.get() - 1);
                 }
             });
 
-            if self.rx_limit.get() > 0 && self.rx_cursor.get() >= self.rx_limit.get() {
-                self.rx_client.map(|client| {
-                    client.received_buffer(self.rx_buffer.take().unwrap(),
-                        self.rx_limit.get(), ReturnCode::SUCCESS, hil::uart::Error::None);
-                });
+            while self.rx_cursor.get() < self.rx_limit.get() &&
+                (regs.state.get() & (1 << 7)) == 0 {
+                // While RX FIFO is not empty and we have space in the buffer ...
+                let rx_byte = regs.read_data.get() as u8;
+                rx_buffer[self.rx_cursor.get()] = rx_byte;
+                self.rx_cursor.set(self.rx_cursor.get() + 1);
+            }
+        });
+
+        // No client buffer pending (or it just filled): spill whatever is
+        // left in the FIFO into the ring so it survives until the next
+        // receive_buffer call instead of overrunning the 32-byte FIFO.
+        self.rx_ring.map(|ring| {
+            while (regs.state.get() & (1 << 7)) == 0 {
+                if self.rx_ring_count.get() == ring.len() {
+                    // Ring full: drop the oldest byte. This is the same
+                    // data loss as a FIFO overrun, just ring.len()
+                    // characters later.
+                    self.rx_ring_head.set(
+                        (self.rx_ring_head.get() + 1) % ring.len());
+                    self.rx_ring_count.set(self.rx_ring_count.get() - 1);
+                }
+                let tail = (self.rx_ring_head.get() + self.rx_ring_count.get())
+                    % ring.len();
+                ring[tail] = regs.read_data.get() as u8;
+                self.rx_ring_count.set(self.rx_ring_count.get() + 1);
             }
+        });
+
+        if self.rx_buffer.is_some() &&
+            self.rx_limit.get() > 0 && self.rx_cursor.get() >= self.rx_limit.get() {
+            self.rx_client.map(|client| {
+                client.received_buffer(self.rx_buffer.take().unwrap(),
+                    self.rx_limit.get(), ReturnCode::SUCCESS, hil::uart::Error::None);
+            });
         }
     }
 
@@ -300,7 +384,24 @@ impl<'a> UART<'a> {
         let regs = unsafe { &*self.regs };
 
         regs.clear_interrupt_state.set(1);
-        if self.send_remaining_bytes() == -1 {
+        self.fill_fifo();
+
+        // A ring-buffered transmit is complete once its bytes are staged;
+        // return the client's buffer on the first interrupt after
+        // submission while the ring drains on its own.
+        if self.tx_done_buffer.is_some() {
+            self.tx_client.map(|client| {
+                if self.tx_done_buffer.is_some() {
+                    client.transmitted_buffer(self.tx_done_buffer.take().unwrap(),
+                                              self.tx_done_len.get(),
+                                              ReturnCode::SUCCESS);
+                }
+            });
+        }
+
+        // A direct transmit (no ring, or ring full at submission) still
+        // completes when every byte has been written to the FIFO.
+        if self.tx_cursor.get() == self.tx_limit.get() {
             self.tx_client.map(|client| {
                 if self.tx_buffer.is_some() {
                     client.transmitted_buffer(self.tx_buffer.take().unwrap(),
@@ -329,13 +430,35 @@ impl<'a> hil::uart::Transmit<'a> for UART<'a> {
     }
 
     fn transmit_buffer(&self, tx_buffer: &'static mut [u8], tx_len: usize) -> (ReturnCode, Option<&'static mut [u8]>) {
-        if self.tx_buffer.is_some() {
+        if self.tx_buffer.is_some() || self.tx_done_buffer.is_some() {
             return (ReturnCode::EBUSY, Some(tx_buffer));
         }
-        self.tx_buffer.replace(tx_buffer);
-        self.tx_cursor.set(0);
-        self.tx_limit.set(tx_len);
-        self.send_remaining_bytes();
+
+        // Fast path: stage the bytes in the ring so the client gets its
+        // buffer back at the next TX interrupt rather than at wire speed.
+        let buffered = self.tx_ring.map_or(false, |ring| {
+            if ring.len() - self.tx_ring_count.get() < tx_len {
+                return false; // ring full; drain directly below
+            }
+            let mut tail =
+                (self.tx_ring_head.get() + self.tx_ring_count.get()) % ring.len();
+            for b in tx_buffer[..tx_len].iter() {
+                ring[tail] = *b;
+                tail = (tail + 1) % ring.len();
+            }
+            self.tx_ring_count.set(self.tx_ring_count.get() + tx_len);
+            true
+        });
+
+        if buffered {
+            self.tx_done_buffer.replace(tx_buffer);
+            self.tx_done_len.set(tx_len);
+        } else {
+            self.tx_buffer.replace(tx_buffer);
+            self.tx_cursor.set(0);
+            self.tx_limit.set(tx_len);
+        }
+        self.fill_fifo();
         return (ReturnCode::SUCCESS, None);
     }
 
@@ -344,7 +467,7 @@ impl<'a> hil::uart::Transmit<'a> for UART<'a> {
     }
 
     fn transmit_abort(&self) -> ReturnCode {
-        if self.tx_buffer.is_some() {
+        if self.tx_buffer.is_some() || self.tx_done_buffer.is_some() {
             ReturnCode::FAIL
         } else {
             ReturnCode::SUCCESS
@@ -0,0 +1,67 @@
+// Copyright 2021 Google LLC
+//
+// Licensed under the Apache License, Version 2.0 (the "License");
+// you may not use this file except in compliance with the License.
+// You may obtain a copy of the License at
+//
+//     https://www.apache.org/licenses/LICENSE-2.0
+//
+// Unless required by applicable law or agreed to in writing, software
+// distributed under the License is distributed on an "AS IS" BASIS,
+// WITHOUT WARRANTIES OR CONDITIONS OF ANY KIND, either express or implied.
+// See the License for the specific language governing permissions and
+// limitations under the License.
+
+#![allow(dead_code)]
+
+use kernel::ReturnCode;
+
+use crate::usb::constants::EP_BUFFER_SIZE_WORDS;
+
+/// Trait a USB peripheral stack must implement to support the vendor
+/// bulk syscall capsule. The bulk pair (EP2) carries raw 64-byte
+/// packets with no report header and no polling interval: the host
+/// fills spare bus time with them, so DFU payload delivery and trace
+/// extraction run at bulk rates instead of one HID report per poll.
+/// Any block structure (offsets, lengths, checksums) is between the
+/// host tool and the application; the kernel moves packets.
+pub trait UsbBulk<'a> {
+    fn set_bulk_client(&self, client: &'a dyn UsbBulkClient<'a>);
+
+    /// Enable reception of the next packet; call after `get_slice` or
+    /// `get_packet`.
+    fn enable_rx(&self) -> ReturnCode;
+
+    /// In streaming mode the stack re-arms reception from its interrupt
+    /// handler, so back-to-back packets are accepted at line rate. The
+    /// client must then consume every packet during `packet_received`,
+    /// because the buffer it lives in is reused for the packet after
+    /// next. When disabled (the default), reception is only armed by
+    /// `enable_rx`.
+    fn set_rx_streaming(&self, streaming: bool);
+
+    /// Blindly copies a packet out of the RXFIFO: run in response to
+    /// `packet_received`.
+    fn get_packet(&self, packet: &mut [u32; EP_BUFFER_SIZE_WORDS]);
+
+    /// Blindly copies a packet out of the RXFIFO: run in response to
+    /// `packet_received`.
+    fn get_slice(&self, packet: &mut [u8]) -> ReturnCode;
+
+    /// Returns whether the TXFIFO is available for sending.
+    fn transmit_ready(&self) -> bool;
+
+    /// Transmits a packet, fails if the TXFIFO is not ready. Simple
+    /// word copy; use this when possible.
+    fn put_packet(&self, packet: &[u32; EP_BUFFER_SIZE_WORDS]) -> ReturnCode;
+
+    /// Transmits a packet, fails if the TXFIFO is not ready.
+    /// Byte-by-byte copy for unaligned caller buffers.
+    fn put_slice(&self, packet: &[u8]) -> ReturnCode;
+}
+
+/// Client for the UsbBulk trait.
+pub trait UsbBulkClient<'a> {
+    fn packet_received(&self);
+    fn packet_transmitted(&self);
+}
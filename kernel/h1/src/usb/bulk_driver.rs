@@ -0,0 +1,228 @@
+// Copyright 2021 Google LLC
+//
+// Licensed under the Apache License, Version 2.0 (the "License");
+// you may not use this file except in compliance with the License.
+// You may obtain a copy of the License at
+//
+//     https://www.apache.org/licenses/LICENSE-2.0
+//
+// Unless required by applicable law or agreed to in writing, software
+// distributed under the License is distributed on an "AS IS" BASIS,
+// WITHOUT WARRANTIES OR CONDITIONS OF ANY KIND, either express or implied.
+// See the License for the specific language governing permissions and
+// limitations under the License.
+
+//! Provides userspace with access to the vendor bulk endpoint pair.
+//!
+//! The transfer unit is the raw 64-byte bulk packet; any block
+//! structure (DFU offsets, trace record boundaries) is between the
+//! host tool and the application. Transmit is always vectored: the
+//! allowed transmit buffer holds N consecutive packets, streamed out
+//! back to back with one completion callback after the last, so a
+//! trace dump costs one syscall per buffer rather than one per packet.
+//! Receive fills the allowed buffer's 64-byte slots round-robin with a
+//! callback per packet, re-arming from the completion handler when the
+//! buffer has more than one slot so back-to-back packets of a DFU
+//! block land at line rate.
+
+use core::cell::Cell;
+use kernel::{AppId, AppSlice, Callback, Driver, Grant, ReturnCode, Shared};
+use crate::usb::bulk::{UsbBulk, UsbBulkClient};
+
+pub const DRIVER_NUM: usize = 0x20009;
+
+pub const BULK_CMD_CHECK:            usize = 0;
+pub const BULK_CMD_TRANSMIT_PACKETS: usize = 1;
+pub const BULK_CMD_RECEIVE:          usize = 2;
+
+pub const BULK_ALLOW_TRANSMIT: usize = 1;
+pub const BULK_ALLOW_RECEIVE:  usize = 2;
+
+pub const BULK_SUBSCRIBE_TRANSMIT_DONE: usize = 1;
+pub const BULK_SUBSCRIBE_RECEIVE_DONE:  usize = 2;
+
+pub const BULK_PACKET_SIZE: usize = 64;
+
+#[derive(Default)]
+pub struct App {
+    tx_callback: Option<Callback>,
+    rx_callback: Option<Callback>,
+    tx_buffer: Option<AppSlice<Shared, u8>>,
+    rx_buffer: Option<AppSlice<Shared, u8>>,
+}
+
+pub struct BulkSyscallDriver<'a> {
+    endpoints: &'a dyn UsbBulk<'a>,
+    apps: Grant<App>,
+    // Vectored transmit state, as in the U2F driver: `tx_total` is the
+    // packet count of the transfer in flight (0 = idle), packets are
+    // staged as endpoint buffers free up, and one callback fires after
+    // the last completion.
+    tx_total: Cell<usize>,
+    tx_next: Cell<usize>,
+    tx_done: Cell<usize>,
+    rx_slot: Cell<usize>,
+}
+
+impl<'a> BulkSyscallDriver<'a> {
+    pub fn new(endpoints: &'a dyn UsbBulk<'a>, grant: Grant<App>) -> BulkSyscallDriver<'a> {
+        BulkSyscallDriver {
+            endpoints: endpoints,
+            apps: grant,
+            tx_total: Cell::new(0),
+            tx_next: Cell::new(0),
+            tx_done: Cell::new(0),
+            rx_slot: Cell::new(0),
+        }
+    }
+}
+
+impl<'a> UsbBulkClient<'a> for BulkSyscallDriver<'a> {
+    fn packet_received(&self) {
+        for cntr in self.apps.iter() {
+            cntr.enter(|app, _| {
+                let mut slot = 0;
+                if app.rx_buffer.is_some() {
+                    let mut buf = app.rx_buffer.take().unwrap();
+                    let slots = buf.len() / BULK_PACKET_SIZE;
+                    if slots > 1 {
+                        slot = self.rx_slot.get() % slots;
+                        let offset = slot * BULK_PACKET_SIZE;
+                        self.endpoints.get_slice(
+                            &mut buf.as_mut()[offset..offset + BULK_PACKET_SIZE]);
+                        self.rx_slot.set(self.rx_slot.get().wrapping_add(1));
+                        self.endpoints.enable_rx();
+                    } else {
+                        self.endpoints.get_slice(buf.as_mut());
+                    }
+                    app.rx_buffer = Some(buf);
+                }
+                app.rx_callback.map(|mut cb| cb.schedule(slot, 0, 0));
+            });
+        }
+    }
+
+    fn packet_transmitted(&self) {
+        let total = self.tx_total.get();
+        if total == 0 {
+            return;
+        }
+        self.tx_done.set(self.tx_done.get() + 1);
+        for cntr in self.apps.iter() {
+            cntr.enter(|app, _| {
+                if app.tx_buffer.is_some() {
+                    let buf = app.tx_buffer.take().unwrap();
+                    while self.tx_next.get() < total &&
+                          self.endpoints.transmit_ready() {
+                        let offset = self.tx_next.get() * BULK_PACKET_SIZE;
+                        if self.endpoints.put_slice(
+                            &buf.as_ref()[offset..offset + BULK_PACKET_SIZE]) !=
+                            ReturnCode::SUCCESS {
+                            break;
+                        }
+                        self.tx_next.set(self.tx_next.get() + 1);
+                    }
+                    app.tx_buffer = Some(buf);
+                }
+                if self.tx_done.get() >= total {
+                    self.tx_total.set(0);
+                    app.tx_callback.map(|mut cb| {
+                        cb.schedule(total, 0, 0);
+                    });
+                }
+            });
+        }
+    }
+}
+
+impl<'a> Driver for BulkSyscallDriver<'a> {
+    fn allow(
+        &self,
+        appid: AppId,
+        allow_num: usize,
+        slice: Option<AppSlice<Shared, u8>>,
+    ) -> ReturnCode {
+        match allow_num {
+            BULK_ALLOW_TRANSMIT => self.apps.enter(appid, |app, _| {
+                app.tx_buffer = slice;
+                ReturnCode::SUCCESS
+            }).unwrap_or_else(|err| err.into()),
+            BULK_ALLOW_RECEIVE => self.apps.enter(appid, |app, _| {
+                // A multi-slot buffer means packets are consumed
+                // synchronously in packet_received, so the stack can
+                // stream without waiting for userspace.
+                self.endpoints.set_rx_streaming(slice.as_ref().map_or(
+                    false, |s| s.len() / BULK_PACKET_SIZE > 1));
+                app.rx_buffer = slice;
+                ReturnCode::SUCCESS
+            }).unwrap_or_else(|err| err.into()),
+            _ => ReturnCode::ENOSUPPORT,
+        }
+    }
+
+    fn subscribe(
+        &self,
+        subscribe_num: usize,
+        callback: Option<Callback>,
+        app_id: AppId,
+    ) -> ReturnCode {
+        match subscribe_num {
+            BULK_SUBSCRIBE_TRANSMIT_DONE => self.apps.enter(app_id, |app, _| {
+                app.tx_callback = callback;
+                ReturnCode::SUCCESS
+            }).unwrap_or_else(|err| err.into()),
+
+            BULK_SUBSCRIBE_RECEIVE_DONE => self.apps.enter(app_id, |app, _| {
+                app.rx_callback = callback;
+                ReturnCode::SUCCESS
+            }).unwrap_or_else(|err| err.into()),
+
+            _ => ReturnCode::ENOSUPPORT,
+        }
+    }
+
+    fn command(&self, command_num: usize, _data: usize, _: usize, appid: AppId) -> ReturnCode {
+        match command_num {
+            BULK_CMD_CHECK => ReturnCode::SUCCESS, // Existence check
+            // Transmit _data consecutive 64-byte packets from the
+            // allowed transmit buffer.
+            BULK_CMD_TRANSMIT_PACKETS => self.apps.enter(appid, |app, _| {
+                if self.tx_total.get() != 0 {
+                    return ReturnCode::EBUSY;
+                }
+                if app.tx_callback.is_none() || app.tx_buffer.is_none() {
+                    return ReturnCode::ERESERVE;
+                }
+                let packets = _data;
+                if packets < 1 || app.tx_buffer.as_ref().map_or(true,
+                    |buf| packets * BULK_PACKET_SIZE > buf.len()) {
+                    return ReturnCode::EINVAL;
+                }
+                self.tx_total.set(packets);
+                self.tx_next.set(0);
+                self.tx_done.set(0);
+                let buf = app.tx_buffer.take().unwrap();
+                // Stage what fits now; the rest follows from the
+                // completion handler.
+                while self.tx_next.get() < packets &&
+                      self.endpoints.transmit_ready() {
+                    let offset = self.tx_next.get() * BULK_PACKET_SIZE;
+                    let rcode = self.endpoints.put_slice(
+                        &buf.as_ref()[offset..offset + BULK_PACKET_SIZE]);
+                    if rcode != ReturnCode::SUCCESS {
+                        app.tx_buffer = Some(buf);
+                        self.tx_total.set(0);
+                        return rcode;
+                    }
+                    self.tx_next.set(self.tx_next.get() + 1);
+                }
+                app.tx_buffer = Some(buf);
+                ReturnCode::SUCCESS
+            }).unwrap_or_else(|err| err.into()),
+            BULK_CMD_RECEIVE => {
+                self.endpoints.enable_rx()
+            },
+            _ => ReturnCode::ENOSUPPORT,
+        }
+    }
+}
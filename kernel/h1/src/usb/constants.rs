@@ -28,6 +28,20 @@ const MAX_NORMAL_ENDPOINTS:  u16 = 16;
 pub const MAX_PACKET_SIZE:   u16 = 64;
 pub const U2F_REPORT_SIZE:   u16 = 64;
 
+/// Polling interval (bInterval, milliseconds at full speed) advertised
+/// for the U2F interrupt endpoints. The default of 2 matches the
+/// reference gnubby descriptor. A large U2F message spends most of its
+/// wall time waiting for IN tokens — ~7.6KB is 119 frames, one per
+/// poll — so on hosts that honor bInterval the interval scales
+/// large-message throughput directly. The `u2f_fast_poll` feature
+/// advertises 1ms for deployments whose hosts are known to schedule
+/// 1ms interrupt endpoints; the kernel side needs no buffering change,
+/// since frames are produced and consumed one EP buffer at a time.
+#[cfg(feature = "u2f_fast_poll")]
+pub const U2F_POLL_INTERVAL_MS: u8 = 1;
+#[cfg(not(feature = "u2f_fast_poll"))]
+pub const U2F_POLL_INTERVAL_MS: u8 = 2;
+
 // Constants defining buffer sizes for all endpoints.
 pub const EP_BUFFER_SIZE_BYTES:    usize = MAX_PACKET_SIZE as usize;
 pub const EP_BUFFER_SIZE_WORDS:    usize = EP_BUFFER_SIZE_BYTES / 4;
@@ -100,6 +114,23 @@ pub const U2F_REPORT_DESCRIPTOR: [u8; 34] = [
     0xC0              /* End Collection */
 ];
 
+/// The report descriptor packed into little-endian words at compile
+/// time, in the layout the EP0 IN buffers use, so serving it is a
+/// straight word copy instead of per-byte shifting at request time.
+pub const U2F_REPORT_DESCRIPTOR_WORDS: [u32; (U2F_REPORT_DESCRIPTOR.len() + 3) / 4] =
+    pack_descriptor_words(&U2F_REPORT_DESCRIPTOR);
+
+const fn pack_descriptor_words(bytes: &[u8; U2F_REPORT_DESCRIPTOR.len()])
+                               -> [u32; (U2F_REPORT_DESCRIPTOR.len() + 3) / 4] {
+    let mut words = [0u32; (U2F_REPORT_DESCRIPTOR.len() + 3) / 4];
+    let mut i = 0;
+    while i < bytes.len() {
+        words[i / 4] |= (bytes[i] as u32) << ((i % 4) * 8);
+        i += 1;
+    }
+    words
+}
+
 pub enum U2fHidCommand {
     Error = 0xbf,
 }
@@ -19,12 +19,15 @@
 use core::cell::Cell;
 use kernel::{AppId, AppSlice, Callback, Driver, Grant, ReturnCode, Shared};
 use crate::usb::{UsbHidU2f, UsbHidU2fClient};
+use crate::usb::constants::EP_BUFFER_SIZE_WORDS;
 
 pub const DRIVER_NUM: usize = 0x20008;
 
-pub const U2F_CMD_CHECK:    usize = 0;
-pub const U2F_CMD_TRANSMIT: usize = 1;
-pub const U2F_CMD_RECEIVE:  usize = 2;
+pub const U2F_CMD_CHECK:           usize = 0;
+pub const U2F_CMD_TRANSMIT:        usize = 1;
+pub const U2F_CMD_RECEIVE:         usize = 2;
+pub const U2F_CMD_RX_COALESCE:     usize = 3;
+pub const U2F_CMD_TRANSMIT_FRAMES: usize = 4;
 
 pub const U2F_ALLOW_TRANSMIT: usize = 1;
 pub const U2F_ALLOW_RECEIVE:  usize = 2;
@@ -33,6 +36,12 @@ pub const U2F_SUBSCRIBE_TRANSMIT_DONE: usize = 1;
 pub const U2F_SUBSCRIBE_RECEIVE_DONE:  usize = 2;
 pub const U2F_SUBSCRIBE_RECONNECT:     usize = 3;
 
+pub const U2F_FRAME_SIZE: usize = 64;
+
+// U2FHID framing constants for the kernel PING fast path.
+const U2FHID_PING: u32 = 0x81; // TYPE_INIT | 0x01
+const U2FHID_BROADCAST_CID: u32 = 0xffff_ffff;
+
 #[derive(Default)]
 pub struct App {
     tx_callback: Option<Callback>,
@@ -46,6 +55,37 @@ pub struct U2fSyscallDriver<'a> {
     u2f_endpoints: &'a dyn UsbHidU2f<'a>,
     apps: Grant<App>,
     busy: Cell<bool>,
+    rx_slot: Cell<usize>,
+    // Transmit-done callbacks deferred until a hardware completion.
+    // When the stack still has a free transmit buffer after a put, the
+    // callback is issued immediately instead, so the app can stage the
+    // next frame while this one is on the wire.
+    tx_cbs_owed: Cell<usize>,
+    // Vectored transmit: the allowed transmit buffer holds
+    // `tx_multi_total` consecutive frames (0 = inactive). Frames are
+    // staged into the endpoint as its buffers free up, and one callback
+    // fires after the last frame completes.
+    tx_multi_total: Cell<usize>,
+    tx_multi_next: Cell<usize>,
+    tx_multi_done: Cell<usize>,
+    // Receive coalescing: with a frame ring allowed, up to
+    // `rx_coalesce` frames are accumulated per receive callback. U2FHID
+    // message boundaries are tracked so the final frames of a message
+    // are never held back waiting for a full batch. 1 (the default)
+    // delivers a callback per frame.
+    rx_coalesce: Cell<usize>,
+    rx_batch_start: Cell<usize>,
+    rx_batch_count: Cell<usize>,
+    rx_msg_frames_left: Cell<usize>,
+    // PING fast path: frames of a ping being echoed in the kernel.
+    // While `ping_frames_left` is nonzero, continuation frames on
+    // `ping_cid` are reflected without waking the app.
+    ping_cid: Cell<u32>,
+    ping_frames_left: Cell<usize>,
+    // An echo frame is sitting unconsumed in the receive buffer
+    // because both transmit buffers were full; reception stays
+    // un-armed and frame_transmitted() finishes the echo.
+    ping_pending: Cell<bool>,
 }
 
 impl<'a> U2fSyscallDriver<'a> {
@@ -53,9 +93,78 @@ impl<'a> U2fSyscallDriver<'a> {
         U2fSyscallDriver {
             u2f_endpoints: u2f,
             apps: grant,
-            busy: Cell::new(false)
+            busy: Cell::new(false),
+            rx_slot: Cell::new(0),
+            tx_cbs_owed: Cell::new(0),
+            tx_multi_total: Cell::new(0),
+            tx_multi_next: Cell::new(0),
+            tx_multi_done: Cell::new(0),
+            rx_coalesce: Cell::new(1),
+            rx_batch_start: Cell::new(0),
+            rx_batch_count: Cell::new(0),
+            rx_msg_frames_left: Cell::new(0),
+            ping_cid: Cell::new(0),
+            ping_frames_left: Cell::new(0),
+            ping_pending: Cell::new(false),
         }
     }
+
+    // U2FHID PING is a pure echo: the response is identical to the
+    // request frame-for-frame, including continuations. Reflecting it
+    // here answers liveness probes at transport latency instead of
+    // scheduler latency, without waking the app. Returns true when the
+    // frame was consumed; `get_frame` only peeks at the RXFIFO, so on
+    // false the normal delivery path still sees the frame.
+    fn try_ping_echo(&self) -> bool {
+        let mut frame: [u32; EP_BUFFER_SIZE_WORDS] = [0; EP_BUFFER_SIZE_WORDS];
+        self.u2f_endpoints.get_frame(&mut frame);
+        let cid = frame[0];
+        let cmd = frame[1] & 0xff; // byte 4: command or sequence number
+
+        let echo = if self.ping_frames_left.get() > 0 {
+            // Continuation of a ping already being echoed.
+            cid == self.ping_cid.get() && cmd & 0x80 == 0
+        } else {
+            // Only claim pings on established (non-broadcast) channels,
+            // and not while a vectored transmit is staging frames --
+            // echoes would interleave with the app's message.
+            cmd == U2FHID_PING && cid != 0 && cid != U2FHID_BROADCAST_CID &&
+                self.tx_multi_total.get() == 0
+        };
+        if !echo {
+            return false;
+        }
+
+        if self.ping_frames_left.get() == 0 {
+            // Only claim a new ping if it can be echoed right away:
+            // the transmit buffers drain via an interrupt this handler
+            // would be blocking, so there is no waiting for one here.
+            // Unclaimed pings take the normal app path.
+            if !self.u2f_endpoints.transmit_ready() {
+                return false;
+            }
+            // bcnt (bytes 5-6, big-endian) determines how many
+            // continuation frames follow the initial one.
+            let bcnt = ((frame[1] >> 8) & 0xff) << 8 | (frame[1] >> 16) & 0xff;
+            let extra = (bcnt as usize).saturating_sub(U2F_FRAME_SIZE - 7);
+            self.ping_cid.set(cid);
+            self.ping_frames_left.set(
+                1 + (extra + (U2F_FRAME_SIZE - 5) - 1) / (U2F_FRAME_SIZE - 5));
+        } else if !self.u2f_endpoints.transmit_ready() {
+            // Continuation of a claimed ping with both transmit buffers
+            // full: park it. The frame stays peekable in the receive
+            // buffer because reception is not re-armed, and
+            // frame_transmitted() completes the echo once a transmit
+            // buffer frees up.
+            self.ping_pending.set(true);
+            return true;
+        }
+
+        self.u2f_endpoints.put_frame(&frame);
+        self.ping_frames_left.set(self.ping_frames_left.get() - 1);
+        self.u2f_endpoints.enable_rx();
+        true
+    }
 }
 
 impl<'a> UsbHidU2fClient<'a> for U2fSyscallDriver<'a> {
@@ -69,25 +178,151 @@ impl<'a> UsbHidU2fClient<'a> for U2fSyscallDriver<'a> {
         }
     }
 
+    // Shares the connection callback with reconnected(); arg0
+    // distinguishes a resume (1, session state intact) from a
+    // reconnect (0).
+    fn resumed(&self) {
+        for cntr in self.apps.iter() {
+            cntr.enter(|app, _| {
+                app.connection_callback.map(|mut cb| {
+                    cb.schedule(1, 0, 0);
+                });
+            });
+        }
+    }
+
     fn frame_received(&self) {
+        if self.try_ping_echo() {
+            return;
+        }
         for cntr in self.apps.iter() {
             cntr.enter(|app, _| {
+                let mut first_slot = 0;
+                let mut batch = 1;
+                let mut deliver = true;
                 if app.rx_buffer.is_some() {
                     let mut buf = app.rx_buffer.take().unwrap();
-                    self.u2f_endpoints.get_slice(buf.as_mut());
+                    let frames = buf.len() / U2F_FRAME_SIZE;
+                    if frames > 1 {
+                        // The app allowed a ring of frame slots: fill the
+                        // next slot round-robin and immediately re-arm
+                        // reception, so userspace can parse this frame in
+                        // place while the next one arrives.
+                        let slot = self.rx_slot.get() % frames;
+                        let offset = slot * U2F_FRAME_SIZE;
+                        self.u2f_endpoints.get_slice(
+                            &mut buf.as_mut()[offset..offset + U2F_FRAME_SIZE]);
+                        self.rx_slot.set(self.rx_slot.get().wrapping_add(1));
+                        self.u2f_endpoints.enable_rx();
+
+                        if self.rx_batch_count.get() == 0 {
+                            self.rx_batch_start.set(slot);
+                        }
+                        self.rx_batch_count.set(self.rx_batch_count.get() + 1);
+
+                        // Track U2FHID message boundaries: byte 4 of an
+                        // initial frame is the command with the high bit
+                        // set, bytes 5-6 the payload length, from which
+                        // the number of continuation frames follows
+                        // (57-byte initial payload, 59 per continuation).
+                        if self.rx_msg_frames_left.get() == 0 {
+                            let frame = &buf.as_ref()[offset..offset + U2F_FRAME_SIZE];
+                            if frame[4] & 0x80 != 0 {
+                                let bcnt = ((frame[5] as usize) << 8) |
+                                           (frame[6] as usize);
+                                let extra = bcnt.saturating_sub(U2F_FRAME_SIZE - 7);
+                                self.rx_msg_frames_left.set(
+                                    (extra + (U2F_FRAME_SIZE - 5) - 1) /
+                                    (U2F_FRAME_SIZE - 5));
+                            }
+                            // A continuation outside any message is
+                            // delivered on its own for the app to reject.
+                        } else {
+                            self.rx_msg_frames_left.set(
+                                self.rx_msg_frames_left.get() - 1);
+                        }
+
+                        // Deliver at the end of a message or once the
+                        // batch limit is reached, leaving at least one
+                        // ring slot of headroom for the next frame.
+                        let limit = ::core::cmp::max(1,
+                            ::core::cmp::min(self.rx_coalesce.get(), frames - 1));
+                        deliver = self.rx_msg_frames_left.get() == 0 ||
+                                  self.rx_batch_count.get() >= limit;
+                        if deliver {
+                            first_slot = self.rx_batch_start.get();
+                            batch = self.rx_batch_count.get();
+                            self.rx_batch_count.set(0);
+                        }
+                    } else {
+                        self.u2f_endpoints.get_slice(buf.as_mut());
+                    }
                     app.rx_buffer = Some(buf);
                 }
-                app.rx_callback.map(|mut cb| cb.schedule(0, 0, 0));
+                if deliver {
+                    app.rx_callback.map(|mut cb| cb.schedule(first_slot, batch, 0));
+                }
             });
         }
     }
 
     fn frame_transmitted(&self) {
+        if self.ping_pending.get() && self.u2f_endpoints.transmit_ready() {
+            // A parked echo frame: transmit it and re-arm the
+            // reception it was holding back.
+            self.ping_pending.set(false);
+            let mut frame: [u32; EP_BUFFER_SIZE_WORDS] = [0; EP_BUFFER_SIZE_WORDS];
+            self.u2f_endpoints.get_frame(&mut frame);
+            self.u2f_endpoints.put_frame(&frame);
+            self.ping_frames_left.set(self.ping_frames_left.get() - 1);
+            self.u2f_endpoints.enable_rx();
+        }
+
+        if self.tx_cbs_owed.get() > 0 {
+            self.tx_cbs_owed.set(self.tx_cbs_owed.get() - 1);
+            for cntr in self.apps.iter() {
+                cntr.enter(|app, _| {
+                    app.tx_callback.map(|mut cb| {
+                        cb.schedule(0, 0, 0);
+                    });
+                });
+            }
+            return;
+        }
+
+        let total = self.tx_multi_total.get();
+        if total == 0 {
+            // Completions whose callback was already issued at put time
+            // (because another buffer was free) owe nothing here.
+            return;
+        }
+
+        // A frame of a vectored transmit completed: stage as many of the
+        // remaining frames as the endpoint has room for, and fire the
+        // single completion callback once all of them are out.
+        self.tx_multi_done.set(self.tx_multi_done.get() + 1);
         for cntr in self.apps.iter() {
             cntr.enter(|app, _| {
-                app.tx_callback.map(|mut cb| {
-                    cb.schedule(0, 0, 0);
-                });
+                if app.tx_buffer.is_some() {
+                    let buf = app.tx_buffer.take().unwrap();
+                    while self.tx_multi_next.get() < total &&
+                          self.u2f_endpoints.transmit_ready() {
+                        let offset = self.tx_multi_next.get() * U2F_FRAME_SIZE;
+                        if self.u2f_endpoints.put_slice(
+                            &buf.as_ref()[offset..offset + U2F_FRAME_SIZE]) !=
+                            ReturnCode::SUCCESS {
+                            break;
+                        }
+                        self.tx_multi_next.set(self.tx_multi_next.get() + 1);
+                    }
+                    app.tx_buffer = Some(buf);
+                }
+                if self.tx_multi_done.get() >= total {
+                    self.tx_multi_total.set(0);
+                    app.tx_callback.map(|mut cb| {
+                        cb.schedule(total, 0, 0);
+                    });
+                }
             });
         }
     }
@@ -106,6 +341,11 @@ impl<'a> Driver for U2fSyscallDriver<'a> {
                 ReturnCode::SUCCESS
             }).unwrap_or_else(|err| err.into()),
             U2F_ALLOW_RECEIVE => self.apps.enter(appid, |app, _| {
+                // A multi-frame buffer means frames are consumed
+                // synchronously in frame_received, so the stack can
+                // stream without waiting for userspace.
+                self.u2f_endpoints.set_rx_streaming(slice.as_ref().map_or(
+                    false, |s| s.len() / U2F_FRAME_SIZE > 1));
                 app.rx_buffer = slice;
                 ReturnCode::SUCCESS
             }).unwrap_or_else(|err| err.into()),
@@ -154,6 +394,19 @@ impl<'a> Driver for U2fSyscallDriver<'a> {
                         app.tx_buffer.take().map_or(ReturnCode::ERESERVE, |buf| {
                             let rcode = self.u2f_endpoints.put_slice(buf.as_ref());
                             app.tx_buffer = Some(buf);
+                            if rcode == ReturnCode::SUCCESS {
+                                if self.u2f_endpoints.transmit_ready() {
+                                    // Another buffer is free: complete
+                                    // now so the app stages the next
+                                    // frame during this one's flight.
+                                    app.tx_callback.map(|mut cb| {
+                                        cb.schedule(0, 0, 0);
+                                    });
+                                } else {
+                                    self.tx_cbs_owed.set(
+                                        self.tx_cbs_owed.get() + 1);
+                                }
+                            }
                             //print!("U2F transmit: returning to userspace.\n");
                             rcode
                         })
@@ -173,6 +426,48 @@ impl<'a> Driver for U2fSyscallDriver<'a> {
             U2F_CMD_RECEIVE => {
                 self.u2f_endpoints.enable_rx()
             },
+            // Vectored transmit: the allowed transmit buffer holds _data
+            // consecutive 64-byte frames, streamed out back to back with
+            // a single completion callback after the last one.
+            U2F_CMD_TRANSMIT_FRAMES => self.apps.enter(appid, |app, _| {
+                if self.tx_multi_total.get() != 0 {
+                    return ReturnCode::EBUSY;
+                }
+                if app.tx_callback.is_none() || app.tx_buffer.is_none() {
+                    return ReturnCode::ERESERVE;
+                }
+                let frames = _data;
+                if frames < 1 || app.tx_buffer.as_ref().map_or(true,
+                    |buf| frames * U2F_FRAME_SIZE > buf.len()) {
+                    return ReturnCode::EINVAL;
+                }
+                self.tx_multi_total.set(frames);
+                self.tx_multi_next.set(0);
+                self.tx_multi_done.set(0);
+                let buf = app.tx_buffer.take().unwrap();
+                // Stage what fits now; the rest follows from the
+                // completion handler.
+                while self.tx_multi_next.get() < frames &&
+                      self.u2f_endpoints.transmit_ready() {
+                    let offset = self.tx_multi_next.get() * U2F_FRAME_SIZE;
+                    let rcode = self.u2f_endpoints.put_slice(
+                        &buf.as_ref()[offset..offset + U2F_FRAME_SIZE]);
+                    if rcode != ReturnCode::SUCCESS {
+                        app.tx_buffer = Some(buf);
+                        self.tx_multi_total.set(0);
+                        return rcode;
+                    }
+                    self.tx_multi_next.set(self.tx_multi_next.get() + 1);
+                }
+                app.tx_buffer = Some(buf);
+                ReturnCode::SUCCESS
+            }).unwrap_or_else(|err| err.into()),
+            // Set how many frames may be accumulated per receive
+            // callback; 0 or 1 restores a callback per frame.
+            U2F_CMD_RX_COALESCE => {
+                self.rx_coalesce.set(::core::cmp::max(_data, 1));
+                ReturnCode::SUCCESS
+            },
             _ => ReturnCode::ENOSUPPORT,
         }
     }
@@ -14,6 +14,8 @@
 
 #![allow(dead_code)]
 
+pub mod bulk;
+pub mod bulk_driver;
 pub mod constants;
 pub mod driver;
 mod registers;
@@ -45,6 +47,7 @@ use self::types::{ConfigurationDescriptor, DeviceDescriptor,
                   SetupRequest, SetupRequestClass, SetupRequestType,
                   StaticRef};
 use self::u2f::{UsbHidU2f, UsbHidU2fClient};
+use self::bulk::{UsbBulk, UsbBulkClient};
 
 // Simple macros for USB debugging output: default definitions do nothing,
 // but you can uncomment print defintions to get detailed output on the
@@ -93,6 +96,12 @@ enum USBState {
 const EP0_IN_BUFFER_COUNT:  usize = 4;
 const EP0_OUT_BUFFER_COUNT: usize = 2;
 
+// Number of ping-pong buffers for EP1 (U2F data), in each direction.
+const EP1_BUFFER_COUNT: usize = 2;
+
+// Number of ping-pong buffers for EP2 (vendor bulk), in each direction.
+const EP2_BUFFER_COUNT: usize = 2;
+
 /// Driver for the Synopsys DesignWare Cores USB 2.0 Hi-Speed
 /// On-The-Go (OTG) controller.
 ///
@@ -133,6 +142,11 @@ pub struct USB<'a> {
     timer_clock: Clock,
     state: Cell<USBState>,
 
+    // Set while the bus is suspended. Device address, configuration
+    // and endpoint state are kept across suspend so a resume picks up
+    // the existing session without re-enumerating.
+    suspended: Cell<bool>,
+
     // Descriptor and buffers should exist after a call to init.
 
     // EP0 is used for control messages (enumeration, etc.): they
@@ -154,12 +168,51 @@ pub struct USB<'a> {
     last_ep0_out_idx: Cell<usize>,
 
     // EP1 is used for application messages: userspace applications
-    // can communicate using them through system calls. EP1 in and out
-    // are both 64-byte buffers.
-    ep1_out_descriptor: TakeCell<'static, DMADescriptor>,
-    ep1_out_buffer: Cell<Option<&'static [u32; EP_BUFFER_SIZE_WORDS]>>,
-    ep1_in_descriptor: TakeCell<'static, DMADescriptor>,
-    ep1_in_buffer: TakeCell<'static,[u32; EP_BUFFER_SIZE_WORDS]>,
+    // can communicate using them through system calls. Each direction
+    // has two 64-byte buffers managed as a ping-pong pair, so the
+    // hardware can move one frame while software fills or drains the
+    // other: back-to-back frames of a large U2F message then run at
+    // line rate instead of stalling on a NAK between every frame.
+    ep1_out_descriptors: TakeCell<'static, [DMADescriptor; EP1_BUFFER_COUNT]>,
+    ep1_out_buffers: Cell<Option<&'static [[u32; EP_BUFFER_SIZE_WORDS]; EP1_BUFFER_COUNT]>>,
+    ep1_in_descriptors: TakeCell<'static, [DMADescriptor; EP1_BUFFER_COUNT]>,
+    ep1_in_buffers: TakeCell<'static, [u32; EP_BUFFER_SIZE_WORDS * EP1_BUFFER_COUNT]>,
+
+    // Ping-pong bookkeeping for EP1. OUT mirrors the EP0 scheme:
+    // `next` is the descriptor armed (or about to be armed) for
+    // reception, `last` holds the most recent frame for
+    // get_frame/get_slice. IN stages frames at `stage` and transmits
+    // from `arm`.
+    next_ep1_out_idx: Cell<usize>,
+    last_ep1_out_idx: Cell<usize>,
+    ep1_rx_armed: Cell<bool>,
+    // In streaming mode reception is re-armed straight from the
+    // interrupt handler, so the client must consume each frame during
+    // its `frame_received` callback. Otherwise arming waits for
+    // `enable_rx`, preserving the original lockstep flow control.
+    ep1_rx_streaming: Cell<bool>,
+    ep1_in_stage_idx: Cell<usize>,
+    ep1_in_arm_idx: Cell<usize>,
+    ep1_in_staged: Cell<usize>,
+    ep1_in_active: Cell<bool>,
+
+    // EP2 is a vendor-specific bulk pair for DFU payload delivery and
+    // trace extraction. It reuses the EP1 ping-pong scheme, but the
+    // endpoints are bulk: no HID report header and no polling
+    // interval, so large transfers run at whatever rate the host bus
+    // scheduler grants instead of one 64-byte report per poll.
+    ep2_out_descriptors: TakeCell<'static, [DMADescriptor; EP2_BUFFER_COUNT]>,
+    ep2_out_buffers: Cell<Option<&'static [[u32; EP_BUFFER_SIZE_WORDS]; EP2_BUFFER_COUNT]>>,
+    ep2_in_descriptors: TakeCell<'static, [DMADescriptor; EP2_BUFFER_COUNT]>,
+    ep2_in_buffers: TakeCell<'static, [u32; EP_BUFFER_SIZE_WORDS * EP2_BUFFER_COUNT]>,
+    next_ep2_out_idx: Cell<usize>,
+    last_ep2_out_idx: Cell<usize>,
+    ep2_rx_armed: Cell<bool>,
+    ep2_rx_streaming: Cell<bool>,
+    ep2_in_stage_idx: Cell<usize>,
+    ep2_in_arm_idx: Cell<usize>,
+    ep2_in_staged: Cell<usize>,
+    ep2_in_active: Cell<bool>,
 
 
     // Numeric configurations set by instantation. These values are
@@ -179,6 +232,17 @@ pub struct USB<'a> {
     // Which USB configuration is currently being used.
     configuration_current_value: Cell<u8>,
 
+    // Control responses whose content is fixed once `init` has run,
+    // prebuilt into the EP0 IN buffer word layout so GET_DESCRIPTOR is
+    // served with a word copy instead of reserializing the descriptor
+    // on every request. The configuration words are filled by
+    // `generate_full_configuration_descriptor`, the rest by
+    // `prebuild_control_responses`.
+    device_descriptor_words: Cell<[u32; 5]>,
+    device_descriptor_length: Cell<usize>,
+    interface_descriptor_words: Cell<[u32; 3]>,
+    configuration_words: Cell<[u32; 16]>,
+
     // The strings of the USB StringDescriptors (vendor name, device name,
     // etc.). Because different Descriptors index into this array, changing
     // the number of elements or their ordering requires changing other
@@ -187,6 +251,9 @@ pub struct USB<'a> {
 
     // Client to give callbacks to.
     u2f_client: OptionalCell<&'a dyn UsbHidU2fClient<'a>>,
+
+    // Client for the vendor bulk pair (EP2).
+    bulk_client: OptionalCell<&'a dyn UsbBulkClient<'a>>,
 }
 
 // Hardware base address of the singleton USB controller
@@ -209,14 +276,35 @@ impl<'a> USB<'a> {
             core_clock: Clock::new(PeripheralClock::Bank1(PeripheralClock1::Usb0)),
             timer_clock: Clock::new(PeripheralClock::Bank1(PeripheralClock1::Usb0TimerHs)),
             state: Cell::new(USBState::WaitingForSetupPacket),
+            suspended: Cell::new(false),
             ep0_out_descriptors: TakeCell::empty(),
             ep0_out_buffers: Cell::new(None),
             ep0_in_descriptors: TakeCell::empty(),
             ep0_in_buffers: TakeCell::empty(),
-            ep1_out_descriptor: TakeCell::empty(),
-            ep1_out_buffer: Cell::new(None),
-            ep1_in_descriptor: TakeCell::empty(),
-            ep1_in_buffer: TakeCell::empty(),
+            ep1_out_descriptors: TakeCell::empty(),
+            ep1_out_buffers: Cell::new(None),
+            ep1_in_descriptors: TakeCell::empty(),
+            ep1_in_buffers: TakeCell::empty(),
+            next_ep1_out_idx: Cell::new(0),
+            last_ep1_out_idx: Cell::new(0),
+            ep1_rx_armed: Cell::new(false),
+            ep1_rx_streaming: Cell::new(false),
+            ep1_in_stage_idx: Cell::new(0),
+            ep1_in_arm_idx: Cell::new(0),
+            ep1_in_staged: Cell::new(0),
+            ep1_in_active: Cell::new(false),
+            ep2_out_descriptors: TakeCell::empty(),
+            ep2_out_buffers: Cell::new(None),
+            ep2_in_descriptors: TakeCell::empty(),
+            ep2_in_buffers: TakeCell::empty(),
+            next_ep2_out_idx: Cell::new(0),
+            last_ep2_out_idx: Cell::new(0),
+            ep2_rx_armed: Cell::new(false),
+            ep2_rx_streaming: Cell::new(false),
+            ep2_in_stage_idx: Cell::new(0),
+            ep2_in_arm_idx: Cell::new(0),
+            ep2_in_staged: Cell::new(0),
+            ep2_in_active: Cell::new(false),
             configuration_descriptor: TakeCell::empty(),
             next_ep0_out_idx: Cell::new(0),
             last_ep0_out_idx: Cell::new(0),
@@ -225,8 +313,13 @@ impl<'a> USB<'a> {
             product_id: Cell::new(0x7788),  // be replaced in call to init()
             configuration_current_value: Cell::new(0),
             configuration_total_length: Cell::new(0),
+            device_descriptor_words: Cell::new([0; 5]),
+            device_descriptor_length: Cell::new(0),
+            interface_descriptor_words: Cell::new([0; 3]),
+            configuration_words: Cell::new([0; 16]),
             strings: TakeCell::empty(),
             u2f_client: OptionalCell::empty(),
+            bulk_client: OptionalCell::empty(),
         }
     }
 
@@ -260,6 +353,7 @@ impl<'a> USB<'a> {
     /// Reset the device in response to a USB RESET.
     fn usb_reset(&self) {
         control_debug!("USB: WaitingForSetupPacket in reset.\n");
+        self.suspended.set(false);
         self.state.set(USBState::WaitingForSetupPacket);
         // Reset device address field (bits 10:4) of device config
         self.registers.device_config.modify(DeviceConfig::DeviceAddress.val(0));
@@ -267,34 +361,44 @@ impl<'a> USB<'a> {
         self.expect_setup_packet();
     }
 
-    fn ep1_tx_fifo_is_ready(&self) -> bool {
-        self.ep1_in_descriptor.map_or(false, |desc| {
-            desc.flags & DescFlag::STATUS_MASK == DescFlag::DMA_DONE ||
-                desc.flags & DescFlag::STATUS_MASK == DescFlag::HOST_BUSY
-        })
-    }
-
-    fn ep1_rx_fifo_is_ready(&self) -> bool {
-        self.ep1_out_descriptor.map_or(false, |desc| {
-            desc.flags & DescFlag::DMA_DONE == DescFlag::DMA_DONE
-        })
+    /// True when at least one IN buffer is free for staging a frame.
+    fn ep1_tx_is_ready(&self) -> bool {
+        self.ep1_in_staged.get() + (self.ep1_in_active.get() as usize) < EP1_BUFFER_COUNT
     }
 
-    fn ep1_enable_tx(&self) {
-        self.ep1_in_descriptor.map(|desc| {
-            desc.flags = (DescFlag::LAST |
-                          DescFlag::HOST_READY |
-                          DescFlag::IOC).bytes(U2F_REPORT_SIZE);
+    /// Arms the oldest staged IN frame for transmission. Must only be
+    /// called with the endpoint idle and at least one frame staged:
+    /// either from put_frame/put_slice when nothing is in flight, or
+    /// from the transfer-completed interrupt so back-to-back frames go
+    /// out without waiting for software.
+    fn ep1_arm_tx(&self) {
+        self.ep1_in_descriptors.map(|descs| {
+            let idx = self.ep1_in_arm_idx.get();
+            descs[idx].flags = (DescFlag::LAST |
+                                DescFlag::HOST_READY |
+                                DescFlag::IOC).bytes(U2F_REPORT_SIZE);
+            self.registers.in_endpoints[1].dma_address.set(&descs[idx]);
+            self.ep1_in_arm_idx.set((idx + 1) % EP1_BUFFER_COUNT);
+            self.ep1_in_staged.set(self.ep1_in_staged.get() - 1);
+            self.ep1_in_active.set(true);
             self.registers.in_endpoints[1].control.modify(EndpointControl::Enable::SET +
                                                           EndpointControl::ClearNak::SET);
         });
     }
 
-    fn ep1_enable_rx(&self) -> ReturnCode {
-        self.ep1_out_descriptor.map_or(ReturnCode::FAIL, |desc| {
-            desc.flags = (DescFlag::LAST |
-                          DescFlag::HOST_READY |
-                          DescFlag::IOC).bytes(U2F_REPORT_SIZE);
+    /// Arms the next OUT descriptor for reception; a no-op if reception
+    /// is already armed.
+    fn ep1_arm_rx(&self) -> ReturnCode {
+        if self.ep1_rx_armed.get() {
+            return ReturnCode::SUCCESS;
+        }
+        self.ep1_out_descriptors.map_or(ReturnCode::FAIL, |descs| {
+            let idx = self.next_ep1_out_idx.get();
+            descs[idx].flags = (DescFlag::LAST |
+                                DescFlag::HOST_READY |
+                                DescFlag::IOC).bytes(U2F_REPORT_SIZE);
+            self.registers.out_endpoints[1].dma_address.set(&descs[idx]);
+            self.ep1_rx_armed.set(true);
             self.registers.out_endpoints[1].control.modify(EndpointControl::Enable::SET +
                                                            EndpointControl::ClearNak::SET);
             data_debug!("Set EP1 receive flags.\n");
@@ -302,6 +406,48 @@ impl<'a> USB<'a> {
         })
     }
 
+    /// True when at least one EP2 IN buffer is free for staging a packet.
+    fn ep2_tx_is_ready(&self) -> bool {
+        self.ep2_in_staged.get() + (self.ep2_in_active.get() as usize) < EP2_BUFFER_COUNT
+    }
+
+    /// Arms the oldest staged EP2 IN packet for transmission. Same
+    /// contract as ep1_arm_tx: endpoint idle, at least one packet
+    /// staged.
+    fn ep2_arm_tx(&self) {
+        self.ep2_in_descriptors.map(|descs| {
+            let idx = self.ep2_in_arm_idx.get();
+            descs[idx].flags = (DescFlag::LAST |
+                                DescFlag::HOST_READY |
+                                DescFlag::IOC).bytes(MAX_PACKET_SIZE);
+            self.registers.in_endpoints[2].dma_address.set(&descs[idx]);
+            self.ep2_in_arm_idx.set((idx + 1) % EP2_BUFFER_COUNT);
+            self.ep2_in_staged.set(self.ep2_in_staged.get() - 1);
+            self.ep2_in_active.set(true);
+            self.registers.in_endpoints[2].control.modify(EndpointControl::Enable::SET +
+                                                          EndpointControl::ClearNak::SET);
+        });
+    }
+
+    /// Arms the next EP2 OUT descriptor for reception; a no-op if
+    /// reception is already armed.
+    fn ep2_arm_rx(&self) -> ReturnCode {
+        if self.ep2_rx_armed.get() {
+            return ReturnCode::SUCCESS;
+        }
+        self.ep2_out_descriptors.map_or(ReturnCode::FAIL, |descs| {
+            let idx = self.next_ep2_out_idx.get();
+            descs[idx].flags = (DescFlag::LAST |
+                                DescFlag::HOST_READY |
+                                DescFlag::IOC).bytes(MAX_PACKET_SIZE);
+            self.registers.out_endpoints[2].dma_address.set(&descs[idx]);
+            self.ep2_rx_armed.set(true);
+            self.registers.out_endpoints[2].control.modify(EndpointControl::Enable::SET +
+                                                           EndpointControl::ClearNak::SET);
+            ReturnCode::SUCCESS
+        })
+    }
+
     fn usb_reconnect(&self) {}
 
     /// Perform a soft reset on the USB core; timeout if the reset
@@ -349,9 +495,27 @@ impl<'a> USB<'a> {
 
         if status.is_set(Interrupt::EarlySuspend) ||
             status.is_set(Interrupt::Suspend) {
-                // Currently do not support suspend
+                // The bus has gone idle. Deliberately keep the device
+                // address, configuration and EP1 descriptors: the host
+                // resumes into the same configuration, and tearing the
+                // state down here would force a full re-enumeration
+                // (hundreds of ms) before the first post-resume frame.
+                if status.is_set(Interrupt::Suspend) {
+                    self.suspended.set(true);
+                }
             }
 
+        if status.is_set(Interrupt::ResumeWakeup) && self.suspended.get() {
+            self.suspended.set(false);
+            // Make sure reception is armed so the first frame after
+            // resume is accepted immediately, then let the client know
+            // the link is back.
+            if self.ep1_rx_streaming.get() {
+                self.ep1_arm_rx();
+            }
+            self.u2f_client.map(|client| client.resumed());
+        }
+
         if mask.is_set(Interrupt::StartOfFrame) &&
             status.is_set(Interrupt::StartOfFrame) { // Clear SOF
                 self.registers.interrupt_mask.modify(Interrupt::StartOfFrame::CLEAR);
@@ -369,6 +533,8 @@ impl<'a> USB<'a> {
                 let inter_ep0_in = pending_interrupts.is_set(AllEndpointInterrupt::IN0);
                 let inter_ep1_out = pending_interrupts.is_set(AllEndpointInterrupt::OUT1);
                 let inter_ep1_in = pending_interrupts.is_set(AllEndpointInterrupt::IN1);
+                let inter_ep2_out = pending_interrupts.is_set(AllEndpointInterrupt::OUT2);
+                let inter_ep2_in = pending_interrupts.is_set(AllEndpointInterrupt::IN2);
                 int_debug!(" - handling endpoint interrupts {:032b}\n", pending_interrupts.get());
                 int_debug!(" -      all endpoint mask       {:032b}\n", self.registers.device_all_ep_interrupt_mask.get());
                 int_debug!(" -     out1 endpoint ints       {:032b}\n", self.registers.out_endpoints[1].interrupt.get());
@@ -380,6 +546,9 @@ impl<'a> USB<'a> {
                 } else if inter_ep1_out || inter_ep1_in {
                     int_debug!("   - ep1out: {} ep1in: {}\n", inter_ep1_out, inter_ep1_in);
                     self.handle_endpoint1_events(inter_ep1_out, inter_ep1_in);
+                } else if inter_ep2_out || inter_ep2_in {
+                    int_debug!("   - ep2out: {} ep2in: {}\n", inter_ep2_out, inter_ep2_in);
+                    self.handle_endpoint2_events(inter_ep2_out, inter_ep2_in);
                 }
             }
 
@@ -434,7 +603,15 @@ impl<'a> USB<'a> {
             print_in_endpoint_interrupt_status(ep_in_interrupts);
             ep_in.interrupt.set(ep_in_interrupts.get());
             if ep_in_interrupts.is_set(InEndpointInterruptMask::TransferCompleted) {
+                self.ep1_in_active.set(false);
+                // Start the next staged frame from the bottom half so
+                // consecutive frames of a message hit the bus at line
+                // rate, before the client has even run.
+                if self.ep1_in_staged.get() > 0 {
+                    self.ep1_arm_tx();
+                }
                 data_debug!("U2F: frame_transmitted callback on ep1.\n");
+                crate::probe::clear(crate::probe::Probe::U2fFrame);
                 self.u2f_client.map(|client| client.frame_transmitted());
             }
 
@@ -445,13 +622,58 @@ impl<'a> USB<'a> {
             data_debug!("Out interrupts: {:#x}\n", ep_out_interrupts.get());
             ep_out.interrupt.set(ep_out_interrupts.get());
             if ep_out_interrupts.is_set(OutEndpointInterruptMask::TransferCompleted) {
+                // The frame landed in `next`: make it `last` for
+                // get_frame/get_slice and swap, so the other buffer can
+                // take the host's next frame while this one is drained.
+                let idx = self.next_ep1_out_idx.get();
+                self.last_ep1_out_idx.set(idx);
+                self.next_ep1_out_idx.set((idx + 1) % EP1_BUFFER_COUNT);
+                self.ep1_rx_armed.set(false);
+                if self.ep1_rx_streaming.get() {
+                    self.ep1_arm_rx();
+                }
                 data_debug!("U2F: ep1 frame received.\n");
+                crate::probe::set(crate::probe::Probe::U2fFrame);
                 self.u2f_client.map(|client| client.frame_received());
             }
         }
 
     }
 
+    /// Handles events for endpoint 2 (vendor bulk). Same structure as
+    /// endpoint 1: clear pending interrupts, keep the ping-pong
+    /// pipeline moving from the bottom half, then issue client
+    /// callbacks.
+    fn handle_endpoint2_events(&self, out_interrupt: bool, in_interrupt: bool) {
+        if in_interrupt {
+            let ep_in = &self.registers.in_endpoints[2];
+            let ep_in_interrupts = ep_in.interrupt.extract();
+            ep_in.interrupt.set(ep_in_interrupts.get());
+            if ep_in_interrupts.is_set(InEndpointInterruptMask::TransferCompleted) {
+                self.ep2_in_active.set(false);
+                if self.ep2_in_staged.get() > 0 {
+                    self.ep2_arm_tx();
+                }
+                self.bulk_client.map(|client| client.packet_transmitted());
+            }
+        }
+        if out_interrupt {
+            let ep_out = &self.registers.out_endpoints[2];
+            let ep_out_interrupts = ep_out.interrupt.extract();
+            ep_out.interrupt.set(ep_out_interrupts.get());
+            if ep_out_interrupts.is_set(OutEndpointInterruptMask::TransferCompleted) {
+                let idx = self.next_ep2_out_idx.get();
+                self.last_ep2_out_idx.set(idx);
+                self.next_ep2_out_idx.set((idx + 1) % EP2_BUFFER_COUNT);
+                self.ep2_rx_armed.set(false);
+                if self.ep2_rx_streaming.get() {
+                    self.ep2_arm_rx();
+                }
+                self.bulk_client.map(|client| client.packet_received());
+            }
+        }
+    }
+
     /// Handle all endpoint 0 events; clear pending interrupt flags,
     /// swap buffers if needed, then either stall, dispatch to
     /// `handle_setup`, or dispatch to `expect_setup_packet` depending
@@ -626,10 +848,12 @@ impl<'a> USB<'a> {
                 let descriptor_type: u32 = (request.w_value >> 8) as u32;
                 match descriptor_type {
                     GET_DESCRIPTOR_DEVICE => {
-                        let mut len = self.ep0_in_buffers.map(|buf| {
-                            self.generate_device_descriptor().serialize(buf)
-                        }).unwrap_or(0);
+                        let words = self.device_descriptor_words.get();
+                        self.ep0_in_buffers.map(|buf| {
+                            buf[..words.len()].copy_from_slice(&words);
+                        });
 
+                        let mut len = self.device_descriptor_length.get();
                         len = ::core::cmp::min(len, request.w_length as usize);
                         self.ep0_in_descriptors.map(|descs| {
                             descs[0].flags = (DescFlag::HOST_READY |
@@ -642,18 +866,11 @@ impl<'a> USB<'a> {
                         self.expect_data_phase_in(transfer_type);
                     },
                     GET_DESCRIPTOR_CONFIGURATION => {
-                        let mut len = 0;
+                        let words = self.configuration_words.get();
                         self.ep0_in_buffers.map(|buf| {
-                            self.configuration_descriptor.map(|desc| {
-                                len = self.get_configuration_total_length();
-                                for i in 0..16 {
-                                    buf[i] = desc[4 * i + 0] as u32 |
-                                             (desc[4 * i + 1] as u32) << 8 |
-                                             (desc[4 * i + 2] as u32) << 16 |
-                                             (desc[4 * i + 3] as u32) << 24;
-                                }
-                            });
+                            buf[..words.len()].copy_from_slice(&words);
                         });
+                        let mut len = self.get_configuration_total_length();
                         control_debug!("USB: Trying to send configuration descriptor, len {}\n  ", len);
                         len = ::core::cmp::min(len, request.w_length);
                         self.ep0_in_descriptors.map(|descs| {
@@ -665,11 +882,11 @@ impl<'a> USB<'a> {
                         self.expect_data_phase_in(transfer_type);
                     },
                     GET_DESCRIPTOR_INTERFACE => {
-                        let i = InterfaceDescriptor::new(STRING_INTERFACE2, 0, 0x03, 0, 0);
-                        let mut len = 0;
+                        let words = self.interface_descriptor_words.get();
                         self.ep0_in_buffers.map(|buf| {
-                            len = i.into_u32_buf(buf);
+                            buf[..words.len()].copy_from_slice(&words);
                         });
+                        let mut len = 9; // bLength of the interface descriptor
                         len = ::core::cmp::min(len, request.w_length as usize);
                         self.ep0_in_descriptors.map(|descs| {
                             descs[0].flags = (DescFlag::HOST_READY |
@@ -760,13 +977,8 @@ impl<'a> USB<'a> {
                         }
 
                         self.ep0_in_buffers.map(|buf| {
-                            for i in 0..len {
-                                if (i % 4) == 0 {
-                                    buf[i / 4] = (U2F_REPORT_DESCRIPTOR[i] as u32) << ((i % 4) * 8);
-                                } else {
-                                    buf[i / 4] |= (U2F_REPORT_DESCRIPTOR[i] as u32) << ((i % 4) * 8);
-                                }
-                            }
+                            let words = &U2F_REPORT_DESCRIPTOR_WORDS;
+                            buf[..words.len()].copy_from_slice(words);
                             self.ep0_in_descriptors.map(|descs| {
                                 descs[0].flags = (DescFlag::HOST_READY |
                                                   DescFlag::LAST |
@@ -841,6 +1053,7 @@ impl<'a> USB<'a> {
                 let new_addr = (request.w_value & 0x7f) as u32;
                 self.registers.device_config.modify(DeviceConfig::DeviceAddress.val(new_addr));
                 self.setup_u2f_descriptors(); // Need to activate EP1 after SetAddress
+                self.setup_bulk_descriptors(); // Likewise EP2
                 self.expect_status_phase_in(transfer_type);
             }
             SetConfiguration => {
@@ -1033,7 +1246,7 @@ impl<'a> USB<'a> {
     fn generate_full_configuration_descriptor(&self) {
         self.configuration_descriptor.map(|desc| {
 
-            let mut config = ConfigurationDescriptor::new(1, STRING_PLATFORM, 50);
+            let mut config = ConfigurationDescriptor::new(2, STRING_PLATFORM, 50);
 
             let attributes_u2f_in = EndpointAttributes {
                 transfer: EndpointTransferType::Interrupt,
@@ -1048,8 +1261,8 @@ impl<'a> USB<'a> {
 
             let u2f = InterfaceDescriptor::new(STRING_INTERFACE2, 0, 3, 0, 0);
             let hid = HidDeviceDescriptor::new();
-            let ep1out = EndpointDescriptor::new(0x01, attributes_u2f_out, 2);
-            let ep1in  = EndpointDescriptor::new(0x81, attributes_u2f_in, 2);
+            let ep1out = EndpointDescriptor::new(0x01, attributes_u2f_out, U2F_POLL_INTERVAL_MS);
+            let ep1in  = EndpointDescriptor::new(0x81, attributes_u2f_in, U2F_POLL_INTERVAL_MS);
 
             let mut size: usize = config.length();
             size += u2f.into_u8_buf(&mut desc[size..size + u2f.length()]);
@@ -1057,31 +1270,65 @@ impl<'a> USB<'a> {
             size += ep1out.into_u8_buf(&mut desc[size..size + ep1out.length()]);
             size += ep1in.into_u8_buf(&mut desc[size..size + ep1in.length()]);
 
-            // In case we want to start including a shell like the normal gnubby.
-            // Note this requires changing config to have 2 interfaces, not 1.
-            /*let attributes_shell_in = EndpointAttributes {
+            // Vendor-specific bulk interface (EP2): DFU payload
+            // delivery and trace extraction. Bulk endpoints have no
+            // polling interval, so the interval fields are 0.
+            let attributes_bulk_in = EndpointAttributes {
                 transfer: EndpointTransferType::Bulk,
                 synchronization: EndpointSynchronizationType::None,
                 usage: EndpointUsageType::Data,
             };
-            let attributes_shell_out = EndpointAttributes {
+            let attributes_bulk_out = EndpointAttributes {
                 transfer: EndpointTransferType::Bulk,
                 synchronization: EndpointSynchronizationType::None,
                 usage: EndpointUsageType::Data,
             };
-            let shell = InterfaceDescriptor::new(STRING_INTERFACE1, 1, 0xFF, 80, 1);
-            let ep2in  = EndpointDescriptor::new(0x82, attributes_shell_in, 10);
-            let ep2out = EndpointDescriptor::new(0x02, attributes_shell_out, 0);
-            size += shell.into_u8_buf(&mut desc[size..size + shell.length()]);
+            let vendor = InterfaceDescriptor::new(STRING_INTERFACE1, 1, 0xFF, 0, 0);
+            let ep2out = EndpointDescriptor::new(0x02, attributes_bulk_out, 0);
+            let ep2in  = EndpointDescriptor::new(0x82, attributes_bulk_in, 0);
+            size += vendor.into_u8_buf(&mut desc[size..size + vendor.length()]);
+            size += ep2out.into_u8_buf(&mut desc[size..size + ep2out.length()]);
             size += ep2in.into_u8_buf(&mut desc[size..size + ep2in.length()]);
-            size += ep2out.into_u8_buf(&mut desc[size..size + ep2out.length()]);*/
 
             config.set_total_length(size as u16);
             config.into_u8_buf(&mut desc[0..config.length()]);
             self.set_configuration_total_length(size as u16);
+
+            // Pack the finished descriptor into the EP0 IN word layout
+            // once, so GET_DESCRIPTOR(Configuration) is a word copy.
+            let mut words = [0u32; 16];
+            for i in 0..words.len() {
+                words[i] = desc[4 * i + 0] as u32 |
+                           (desc[4 * i + 1] as u32) << 8 |
+                           (desc[4 * i + 2] as u32) << 16 |
+                           (desc[4 * i + 3] as u32) << 24;
+            }
+            self.configuration_words.set(words);
         });
     }
 
+    /// Serializes the control responses that are fixed for the lifetime
+    /// of the device (the device and interface descriptors), so the
+    /// standard enumeration sequence never assembles a descriptor at
+    /// request time. Must run after `init` has set the vendor and
+    /// product IDs.
+    fn prebuild_control_responses(&self) {
+        use self::serialize::Serialize;
+        let mut buf = [0u32; 64];
+
+        let len = self.generate_device_descriptor().serialize(&mut buf);
+        let mut words = [0u32; 5];
+        words.copy_from_slice(&buf[..words.len()]);
+        self.device_descriptor_words.set(words);
+        self.device_descriptor_length.set(len);
+
+        let interface = InterfaceDescriptor::new(STRING_INTERFACE2, 0, 0x03, 0, 0);
+        interface.into_u32_buf(&mut buf);
+        let mut words = [0u32; 3];
+        words.copy_from_slice(&buf[..words.len()]);
+        self.interface_descriptor_words.set(words);
+    }
+
     pub fn set_configuration_total_length(&self, length: u16) {
         self.configuration_total_length.set(length);
     }
@@ -1172,6 +1419,64 @@ impl<'a> USB<'a> {
     }
 
 
+    /// Resets the EP2 (vendor bulk) descriptors and endpoint controls.
+    /// Like setup_u2f_descriptors, this must run after SetAddress to
+    /// activate the endpoints. Reception is deliberately not armed
+    /// here: packets are only accepted once a client asks via
+    /// enable_rx, so host writes cannot land before anyone listens.
+    fn setup_bulk_descriptors(&self) {
+        self.ep2_out_descriptors.map(|descs| {
+            self.ep2_out_buffers.get().map(|bufs| {
+                for (desc, buf) in descs.iter_mut().zip(bufs.iter()) {
+                    desc.flags = DescFlag::HOST_BUSY;
+                    desc.addr = buf.as_ptr() as usize;
+                }
+                self.next_ep2_out_idx.set(0);
+                self.last_ep2_out_idx.set(0);
+                self.ep2_rx_armed.set(false);
+                self.registers.out_endpoints[2].dma_address.set(&descs[0]);
+            });
+        });
+
+        self.ep2_in_descriptors.map(|descs| {
+            self.ep2_in_buffers.map(|bufs| {
+                for (i, desc) in descs.iter_mut().enumerate() {
+                    desc.flags = DescFlag::LAST | DescFlag::HOST_BUSY | DescFlag::IOC;
+                    desc.addr = bufs.as_ptr() as usize + i * EP_BUFFER_SIZE_BYTES;
+                }
+                self.ep2_in_stage_idx.set(0);
+                self.ep2_in_arm_idx.set(0);
+                self.ep2_in_staged.set(0);
+                self.ep2_in_active.set(false);
+                self.registers.in_endpoints[2].dma_address.set(&descs[0]);
+            });
+        });
+
+        self.registers.out_endpoints[2].control.write(EndpointControl::UsbActiveEndpoint::SET +
+                                                      EndpointControl::EndpointType::Bulk +
+                                                      EndpointControl::MaximumPacketSize.val(MAX_PACKET_SIZE as u32));
+        self.registers.in_endpoints[2].control.write(EndpointControl::UsbActiveEndpoint::SET +
+                                                     EndpointControl::TxFifoNumber.val(2) +
+                                                     EndpointControl::EndpointType::Bulk +
+                                                     EndpointControl::MaximumPacketSize.val(MAX_PACKET_SIZE as u32));
+
+        self.registers.device_all_ep_interrupt_mask.modify(AllEndpointInterrupt::OUT2::SET + AllEndpointInterrupt::IN2::SET);
+    }
+
+    /// Installs the descriptors and buffers for the vendor bulk
+    /// endpoint pair (EP2). Must run before init() so enumeration
+    /// advertises an interface with working endpoints behind it.
+    pub fn init_bulk(&self,
+                     ep2_out_descriptors: &'static mut [DMADescriptor; EP2_BUFFER_COUNT],
+                     ep2_out_buffers: &'static mut [[u32; EP_BUFFER_SIZE_WORDS]; EP2_BUFFER_COUNT],
+                     ep2_in_descriptors: &'static mut [DMADescriptor; EP2_BUFFER_COUNT],
+                     ep2_in_buffers: &'static mut [u32; EP_BUFFER_SIZE_WORDS * EP2_BUFFER_COUNT]) {
+        self.ep2_out_descriptors.replace(ep2_out_descriptors);
+        self.ep2_out_buffers.set(Some(ep2_out_buffers));
+        self.ep2_in_descriptors.replace(ep2_in_descriptors);
+        self.ep2_in_buffers.replace(ep2_in_buffers);
+    }
+
     /// Initialize the USB driver in device mode, so it can be begin
     /// communicating with a connected host.
     pub fn init(&self,
@@ -1179,10 +1484,10 @@ impl<'a> USB<'a> {
                 ep0_out_buffers: &'static mut [[u32; 16]; EP0_OUT_BUFFER_COUNT],
                 ep0_in_descriptors: &'static mut [DMADescriptor; EP0_IN_BUFFER_COUNT],
                 ep0_in_buffers: &'static mut [u32; 16 * 4],
-                ep1_out_descriptor: &'static mut DMADescriptor,
-                ep1_out_buffer: &'static mut [u32; 16],
-                ep1_in_descriptor: &'static mut DMADescriptor,
-                ep1_in_buffer: &'static mut [u32; 16],
+                ep1_out_descriptors: &'static mut [DMADescriptor; EP1_BUFFER_COUNT],
+                ep1_out_buffers: &'static mut [[u32; EP_BUFFER_SIZE_WORDS]; EP1_BUFFER_COUNT],
+                ep1_in_descriptors: &'static mut [DMADescriptor; EP1_BUFFER_COUNT],
+                ep1_in_buffers: &'static mut [u32; EP_BUFFER_SIZE_WORDS * EP1_BUFFER_COUNT],
                 configuration_buffer: &'static mut [u8; 64],
                 phy: PHY,
                 device_class: Option<u8>,
@@ -1193,10 +1498,10 @@ impl<'a> USB<'a> {
         self.ep0_out_buffers.set(Some(ep0_out_buffers));
         self.ep0_in_descriptors.replace(ep0_in_descriptors);
         self.ep0_in_buffers.replace(ep0_in_buffers);
-        self.ep1_out_descriptor.replace(ep1_out_descriptor);
-        self.ep1_out_buffer.set(Some(ep1_out_buffer));
-        self.ep1_in_descriptor.replace(ep1_in_descriptor);
-        self.ep1_in_buffer.replace(ep1_in_buffer);
+        self.ep1_out_descriptors.replace(ep1_out_descriptors);
+        self.ep1_out_buffers.set(Some(ep1_out_buffers));
+        self.ep1_in_descriptors.replace(ep1_in_descriptors);
+        self.ep1_in_buffers.replace(ep1_in_buffers);
         self.configuration_descriptor.replace(configuration_buffer);
         self.strings.replace(strings);
 
@@ -1213,6 +1518,7 @@ impl<'a> USB<'a> {
         }
 
         self.generate_full_configuration_descriptor();
+        self.prebuild_control_responses();
 
         self.core_clock.enable();
         self.timer_clock.enable();
@@ -1328,6 +1634,7 @@ impl<'a> USB<'a> {
                    Interrupt::OutEndpoints::SET +
                    Interrupt::EarlySuspend::SET +
                    Interrupt::Suspend::SET +
+                   Interrupt::ResumeWakeup::SET +
                    Interrupt::StartOfFrame::SET);
 
         // Power on programming done
@@ -1363,27 +1670,38 @@ impl<'a> UsbHidU2f<'a> for USB<'a> {
     // This method must be called after a SetConfiguration and SetAddress
     // command, to initialize EP1 and enable data transmission.
     fn setup_u2f_descriptors(&self) {
-        self.ep1_out_descriptor.map(|out_desc| {
-            self.ep1_out_buffer.get().map(|out_buf| {
-                out_desc.flags = (DescFlag::LAST |
+        self.ep1_out_descriptors.map(|descs| {
+            self.ep1_out_buffers.get().map(|bufs| {
+                for (desc, buf) in descs.iter_mut().zip(bufs.iter()) {
+                    desc.flags = DescFlag::HOST_BUSY;
+                    desc.addr = buf.as_ptr() as usize;
+                }
+                self.next_ep1_out_idx.set(0);
+                self.last_ep1_out_idx.set(0);
+                self.ep1_rx_armed.set(true); // Armed by the control write below
+                descs[0].flags = (DescFlag::LAST |
                                   DescFlag::HOST_READY |
                                   DescFlag::IOC).bytes(U2F_REPORT_SIZE);
-                out_desc.addr = out_buf.as_ptr() as usize;
-                self.registers.out_endpoints[1].dma_address.set(&out_desc);
+                self.registers.out_endpoints[1].dma_address.set(&descs[0]);
             });
         });
 
-        self.ep1_in_descriptor.map(|in_desc| {
-            self.ep1_in_buffer.map(|in_buf| {
-                in_desc.flags =  DescFlag::LAST | DescFlag::HOST_BUSY | DescFlag::IOC;
-                in_desc.addr = in_buf.as_ptr() as usize;
-                self.registers.in_endpoints[1].dma_address.set(&in_desc);
-
+        self.ep1_in_descriptors.map(|descs| {
+            self.ep1_in_buffers.map(|bufs| {
+                for (i, desc) in descs.iter_mut().enumerate() {
+                    desc.flags = DescFlag::LAST | DescFlag::HOST_BUSY | DescFlag::IOC;
+                    desc.addr = bufs.as_ptr() as usize + i * EP_BUFFER_SIZE_BYTES;
+                }
+                self.ep1_in_stage_idx.set(0);
+                self.ep1_in_arm_idx.set(0);
+                self.ep1_in_staged.set(0);
+                self.ep1_in_active.set(false);
+                self.registers.in_endpoints[1].dma_address.set(&descs[0]);
             });
         });
 
-        self.ep1_out_descriptor.map(|_out_desc| {
-            self.ep1_out_buffer.get().map(|_out_buf| {
+        self.ep1_out_descriptors.map(|_out_descs| {
+            self.ep1_out_buffers.get().map(|_out_bufs| {
                 self.registers.out_endpoints[1].control.write(EndpointControl::Enable::SET +
                                                               EndpointControl::ClearNak::SET +
                                                               EndpointControl::UsbActiveEndpoint::SET +
@@ -1392,8 +1710,8 @@ impl<'a> UsbHidU2f<'a> for USB<'a> {
             });
         });
 
-        self.ep1_in_descriptor.map(|_in_desc| {
-            self.ep1_in_buffer.map(|_in_buf| {
+        self.ep1_in_descriptors.map(|_in_descs| {
+            self.ep1_in_buffers.map(|_in_bufs| {
                 self.registers.in_endpoints[1].control.write(EndpointControl::UsbActiveEndpoint::SET +
                                                              EndpointControl::TxFifoNumber.val(1) +
                                                              EndpointControl::EndpointType::Interrupt +
@@ -1408,29 +1726,38 @@ impl<'a> UsbHidU2f<'a> for USB<'a> {
         panic!("Trying to force reconnect USB EP1\n");
     }
 
+    fn set_rx_streaming(&self, streaming: bool) {
+        self.ep1_rx_streaming.set(streaming);
+    }
+
     fn enable_rx(&self) -> ReturnCode {
-        self.ep1_enable_rx();
-        ReturnCode::SUCCESS
+        self.ep1_arm_rx()
     }
 
     fn iface_respond(&self) -> ReturnCode {ReturnCode::FAIL}
 
     fn transmit_ready(&self) -> bool {
-        self.ep1_tx_fifo_is_ready()
+        self.ep1_tx_is_ready()
     }
 
     fn put_frame(&self, frame: &[u32; 16]) -> ReturnCode {
         data_debug!("U2F: put_frame\n");
-        if !self.ep1_tx_fifo_is_ready() {
+        if !self.ep1_tx_is_ready() {
             data_debug!("Tried to put frame but busy.\n");
             ReturnCode::EBUSY
         } else {
-            self.ep1_in_buffer.map(|hardware_buffer| {
+            let base = self.ep1_in_stage_idx.get() * EP_BUFFER_SIZE_WORDS;
+            self.ep1_in_buffers.map(|hardware_buffer| {
                 for i in 0..frame.len() {
-                    hardware_buffer[i] = frame[i];
+                    hardware_buffer[base + i] = frame[i];
                 }
             });
-            self.ep1_enable_tx();
+            self.ep1_in_stage_idx.set(
+                (self.ep1_in_stage_idx.get() + 1) % EP1_BUFFER_COUNT);
+            self.ep1_in_staged.set(self.ep1_in_staged.get() + 1);
+            if !self.ep1_in_active.get() {
+                self.ep1_arm_tx();
+            }
             data_debug!("Sending frame.\n");
             ReturnCode::SUCCESS
         }
@@ -1441,13 +1768,14 @@ impl<'a> UsbHidU2f<'a> for USB<'a> {
         if slice.len() > 64 {
             data_debug!("U2F EP1: ERROR: slice too large\n");
             ReturnCode::ESIZE
-        } else if !self.ep1_tx_fifo_is_ready() {
+        } else if !self.ep1_tx_is_ready() {
             data_debug!("U2F EP1: ERROR: Tried to put slice but busy.\n");
             ReturnCode::EBUSY
         } else {
-            self.ep1_in_buffer.map(|hardware_buffer| {
+            let base = self.ep1_in_stage_idx.get() * EP_BUFFER_SIZE_WORDS;
+            self.ep1_in_buffers.map(|hardware_buffer| {
                 for (i, c) in slice.iter().enumerate() {
-                    let hw_index = i / 4;
+                    let hw_index = base + i / 4;
                     let byte_index = i % 4;
                     if byte_index == 0 {
                         hardware_buffer[hw_index] = *c as u32;
@@ -1456,7 +1784,12 @@ impl<'a> UsbHidU2f<'a> for USB<'a> {
                     }
                 }
             });
-            self.ep1_enable_tx();
+            self.ep1_in_stage_idx.set(
+                (self.ep1_in_stage_idx.get() + 1) % EP1_BUFFER_COUNT);
+            self.ep1_in_staged.set(self.ep1_in_staged.get() + 1);
+            if !self.ep1_in_active.get() {
+                self.ep1_arm_tx();
+            }
             data_debug!("U2FData: Started slice send.\n");
             data_debug!("U2FData: {} words available.\n", self.registers.in_endpoints[1].tx_fifo_status.get());
             ReturnCode::SUCCESS
@@ -1466,7 +1799,8 @@ impl<'a> UsbHidU2f<'a> for USB<'a> {
     fn get_frame(&self, frame: &mut [u32; 16]) {
         // Unlike the CR52 code, we don't need to disable interrupts,
         // because Tock handles the USB interrupts as bottom halves. -pal
-        self.ep1_out_buffer.get().map(|hardware_buffer| {
+        self.ep1_out_buffers.get().map(|bufs| {
+            let hardware_buffer = &bufs[self.last_ep1_out_idx.get()];
             for i in 0..16 {
                 frame[i] = hardware_buffer[i];
             }
@@ -1478,7 +1812,102 @@ impl<'a> UsbHidU2f<'a> for USB<'a> {
         if slice.len() > 64 {
             ReturnCode::ESIZE
         } else {
-            self.ep1_out_buffer.get().map(|hardware_buffer| {
+            self.ep1_out_buffers.get().map(|bufs| {
+                let hardware_buffer = &bufs[self.last_ep1_out_idx.get()];
+                let len = slice.len();
+                for i in 0..len {
+                    let hw_index = i / 4;
+                    let byte_index = i % 4;
+                    slice[i] = ((hardware_buffer[hw_index] >> (8 * byte_index)) & 0xff) as u8;
+                }
+            });
+            ReturnCode::SUCCESS
+        }
+    }
+}
+
+/// Implementation of the vendor bulk API for the USB device. It
+/// assumes the bulk pair is endpoint 2. The packet plumbing mirrors
+/// the EP1 implementation above; only the endpoint type differs.
+impl<'a> UsbBulk<'a> for USB<'a> {
+    fn set_bulk_client(&self, client: &'a dyn UsbBulkClient<'a>) {
+        self.bulk_client.set(client);
+    }
+
+    fn enable_rx(&self) -> ReturnCode {
+        self.ep2_arm_rx()
+    }
+
+    fn set_rx_streaming(&self, streaming: bool) {
+        self.ep2_rx_streaming.set(streaming);
+    }
+
+    fn transmit_ready(&self) -> bool {
+        self.ep2_tx_is_ready()
+    }
+
+    fn put_packet(&self, packet: &[u32; EP_BUFFER_SIZE_WORDS]) -> ReturnCode {
+        if !self.ep2_tx_is_ready() {
+            return ReturnCode::EBUSY;
+        }
+        let base = self.ep2_in_stage_idx.get() * EP_BUFFER_SIZE_WORDS;
+        self.ep2_in_buffers.map(|hardware_buffer| {
+            for i in 0..packet.len() {
+                hardware_buffer[base + i] = packet[i];
+            }
+        });
+        self.ep2_in_stage_idx.set(
+            (self.ep2_in_stage_idx.get() + 1) % EP2_BUFFER_COUNT);
+        self.ep2_in_staged.set(self.ep2_in_staged.get() + 1);
+        if !self.ep2_in_active.get() {
+            self.ep2_arm_tx();
+        }
+        ReturnCode::SUCCESS
+    }
+
+    fn put_slice(&self, slice: &[u8]) -> ReturnCode {
+        if slice.len() > EP_BUFFER_SIZE_BYTES {
+            return ReturnCode::ESIZE;
+        }
+        if !self.ep2_tx_is_ready() {
+            return ReturnCode::EBUSY;
+        }
+        let base = self.ep2_in_stage_idx.get() * EP_BUFFER_SIZE_WORDS;
+        self.ep2_in_buffers.map(|hardware_buffer| {
+            for (i, c) in slice.iter().enumerate() {
+                let hw_index = base + i / 4;
+                let byte_index = i % 4;
+                if byte_index == 0 {
+                    hardware_buffer[hw_index] = *c as u32;
+                } else {
+                    hardware_buffer[hw_index] |= (*c as u32) << (8 * byte_index);
+                }
+            }
+        });
+        self.ep2_in_stage_idx.set(
+            (self.ep2_in_stage_idx.get() + 1) % EP2_BUFFER_COUNT);
+        self.ep2_in_staged.set(self.ep2_in_staged.get() + 1);
+        if !self.ep2_in_active.get() {
+            self.ep2_arm_tx();
+        }
+        ReturnCode::SUCCESS
+    }
+
+    fn get_packet(&self, packet: &mut [u32; EP_BUFFER_SIZE_WORDS]) {
+        self.ep2_out_buffers.get().map(|bufs| {
+            let hardware_buffer = &bufs[self.last_ep2_out_idx.get()];
+            for i in 0..EP_BUFFER_SIZE_WORDS {
+                packet[i] = hardware_buffer[i];
+            }
+        });
+    }
+
+    fn get_slice(&self, slice: &mut [u8]) -> ReturnCode {
+        if slice.len() > EP_BUFFER_SIZE_BYTES {
+            ReturnCode::ESIZE
+        } else {
+            self.ep2_out_buffers.get().map(|bufs| {
+                let hardware_buffer = &bufs[self.last_ep2_out_idx.get()];
                 let len = slice.len();
                 for i in 0..len {
                     let hw_index = i / 4;
@@ -1622,12 +2051,33 @@ pub static mut EP0_OUT_BUFFERS: [[u32; EP_BUFFER_SIZE_WORDS]; EP0_OUT_BUFFER_COU
 pub static mut EP0_IN_BUFFER: [u32; EP_BUFFER_SIZE_WORDS * EP0_IN_BUFFER_COUNT] =
                                 [0; EP_BUFFER_SIZE_WORDS * EP0_IN_BUFFER_COUNT];
 
-pub static mut EP1_OUT_DESCRIPTOR: DMADescriptor = DMADescriptor {flags: DescFlag::HOST_BUSY,
-                                                                  addr: 0};
-pub static mut EP1_IN_DESCRIPTOR:  DMADescriptor = DMADescriptor {flags: DescFlag::HOST_BUSY,
-                                                                  addr: 0};
-pub static mut EP1_OUT_BUFFER: [u32; EP_BUFFER_SIZE_WORDS] = [0; EP_BUFFER_SIZE_WORDS];
-pub static mut EP1_IN_BUFFER:  [u32; EP_BUFFER_SIZE_WORDS] = [0; EP_BUFFER_SIZE_WORDS];
+pub static mut EP1_OUT_DESCRIPTORS: [DMADescriptor; EP1_BUFFER_COUNT] = [DMADescriptor {
+    flags: DescFlag::HOST_BUSY,
+    addr: 0,
+}; EP1_BUFFER_COUNT];
+pub static mut EP1_IN_DESCRIPTORS: [DMADescriptor; EP1_BUFFER_COUNT] = [DMADescriptor {
+    flags: DescFlag::HOST_BUSY,
+    addr: 0,
+}; EP1_BUFFER_COUNT];
+
+pub static mut EP1_OUT_BUFFERS: [[u32; EP_BUFFER_SIZE_WORDS]; EP1_BUFFER_COUNT] =
+                                  [[0; EP_BUFFER_SIZE_WORDS]; EP1_BUFFER_COUNT];
+pub static mut EP1_IN_BUFFERS: [u32; EP_BUFFER_SIZE_WORDS * EP1_BUFFER_COUNT] =
+                                 [0; EP_BUFFER_SIZE_WORDS * EP1_BUFFER_COUNT];
+
+pub static mut EP2_OUT_DESCRIPTORS: [DMADescriptor; EP2_BUFFER_COUNT] = [DMADescriptor {
+    flags: DescFlag::HOST_BUSY,
+    addr: 0,
+}; EP2_BUFFER_COUNT];
+pub static mut EP2_IN_DESCRIPTORS: [DMADescriptor; EP2_BUFFER_COUNT] = [DMADescriptor {
+    flags: DescFlag::HOST_BUSY,
+    addr: 0,
+}; EP2_BUFFER_COUNT];
+
+pub static mut EP2_OUT_BUFFERS: [[u32; EP_BUFFER_SIZE_WORDS]; EP2_BUFFER_COUNT] =
+                                  [[0; EP_BUFFER_SIZE_WORDS]; EP2_BUFFER_COUNT];
+pub static mut EP2_IN_BUFFERS: [u32; EP_BUFFER_SIZE_WORDS * EP2_BUFFER_COUNT] =
+                                 [0; EP_BUFFER_SIZE_WORDS * EP2_BUFFER_COUNT];
 
 // Buffer used to store device configuration (descriptors), initialized at startup.
 pub static mut CONFIGURATION_BUFFER: [u8; EP_BUFFER_SIZE_BYTES] = [0; EP_BUFFER_SIZE_BYTES];
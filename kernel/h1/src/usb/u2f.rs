@@ -32,6 +32,14 @@ pub trait UsbHidU2f<'a> {
     /// Enable reception of next frame; call after `get_slice` or `get_frame`.
     fn enable_rx(&self) -> ReturnCode;
 
+    /// In streaming mode the stack re-arms reception from its interrupt
+    /// handler, so back-to-back frames are accepted at line rate. The
+    /// client must then consume every frame during `frame_received`,
+    /// because the buffer it lives in is reused for the frame after
+    /// next. When disabled (the default), reception is only armed by
+    /// `enable_rx`.
+    fn set_rx_streaming(&self, streaming: bool);
+
     /// Sends the U2F report descriptor over the control channel (EP0)
     fn iface_respond(&self) -> ReturnCode;
 
@@ -57,6 +65,10 @@ pub trait UsbHidU2f<'a> {
 /// Client for the UsbHidU2f trait.
 pub trait UsbHidU2fClient<'a> {
     fn reconnected(&self);
+    /// The bus resumed from suspend with the device configuration and
+    /// endpoint state intact; no re-enumeration happened and any
+    /// session state the client holds is still valid.
+    fn resumed(&self);
     fn frame_received(&self);
     fn frame_transmitted(&self);
 }
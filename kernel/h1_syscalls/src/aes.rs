@@ -12,8 +12,11 @@
 // See the License for the specific language governing permissions and
 // limitations under the License.
 
+use crate::arbiter::RequestQueue;
 use core::cell::Cell;
+use core::cmp;
 use h1::crypto::aes::{AesEngine, AES128Ecb};
+use h1::timeus::Timeus;
 use kernel::{AppId, Callback, Driver, Grant, ReturnCode, Shared, AppSlice};
 use kernel::common::cells::TakeCell;
 use kernel::hil::symmetric_encryption;
@@ -23,14 +26,58 @@ use kernel::hil::symmetric_encryption::{AES128, AES128CBC, AES128Ctr};
 
 pub const DRIVER_NUM: usize = 0x40010;
 
-pub static mut AES_BUF: [u8; AES128_BLOCK_SIZE] = [0; AES128_BLOCK_SIZE];
+// Staging buffer between app memory and the engine. Each chunk of this
+// size streams through the engine on a single submission, so a larger
+// buffer means fewer staging copies per operation; 32 blocks keeps a
+// 4KB operation to 8 refills without a noticeable bite out of kernel
+// RAM.
+pub const AES_BUF_LEN: usize = 32 * AES128_BLOCK_SIZE;
+
+pub static mut AES_BUF: [u8; AES_BUF_LEN] = [0; AES_BUF_LEN];
+
+// Number of cached key slots per application. Four covers the wrap,
+// unwrap and MAC keys of a U2F session with one to spare.
+pub const KEY_SLOT_COUNT: usize = 4;
+
+// AES-CMAC (RFC 4493) runs as a small state machine on top of the
+// engine: one ECB encryption of the zero block to derive the subkeys,
+// then a CBC-MAC pass over the message.
+#[derive(Copy, Clone, PartialEq)]
+enum CmacPhase {
+    Idle,
+    Subkey,
+    Data,
+}
+
+// One-bit left shift over the whole block with the RFC 4493 reduction
+// constant folded into the last byte on carry-out.
+fn cmac_ls1(input: &[u8; AES128_BLOCK_SIZE]) -> [u8; AES128_BLOCK_SIZE] {
+    let mut out = [0; AES128_BLOCK_SIZE];
+    let mut carry = 0;
+    for i in (0..AES128_BLOCK_SIZE).rev() {
+        out[i] = (input[i] << 1) | carry;
+        carry = input[i] >> 7;
+    }
+    if carry != 0 {
+        out[AES128_BLOCK_SIZE - 1] ^= 0x87;
+    }
+    out
+}
 
 #[derive(Default)]
 pub struct AppData {
     key: Option<AppSlice<Shared, u8>>,
+    // Keys stored once and referenced by index, so repeated operations
+    // skip the per-operation key transfer.
+    key_slots: [Option<[u8; AES128_KEY_SIZE]>; KEY_SLOT_COUNT],
+    active_key_slot: Option<usize>,
     input_buffer: Option<AppSlice<Shared, u8>>,
     output_buffer: Option<AppSlice<Shared, u8>>,
     iv_buffer: Option<AppSlice<Shared, u8>>,
+    // CMAC message; unlike the input buffer this may be any length,
+    // since the driver pads the final block itself.
+    cmac_buffer: Option<AppSlice<Shared, u8>>,
+    cmac_len: usize,
     crypto_callback: Option<Callback>,
 }
 
@@ -39,6 +86,23 @@ pub struct AesDriver<'a> {
     apps: Grant<AppData>,
     current_user: Cell<Option<AppId>>,
     buffer: TakeCell<'a, [u8]>,
+    // Byte offset into the app buffer of the chunk currently in the
+    // engine; nonzero only while walking an input longer than the
+    // kernel buffer.
+    crypt_offset: Cell<usize>,
+    // Size in bytes of the chunk currently in the engine.
+    crypt_chunk: Cell<usize>,
+    busy: Cell<bool>,
+    // Requests arriving while the engine is busy are parked here
+    // rather than rejected, so applications can submit and continue
+    // with other work; started as running operations complete.
+    queue: RequestQueue,
+    // Which app's key slot the hardware key register currently holds;
+    // None after a key is loaded through the legacy allow path.
+    loaded_key: Cell<Option<(AppId, usize)>>,
+    cmac_phase: Cell<CmacPhase>,
+    cmac_k1: Cell<[u8; AES128_BLOCK_SIZE]>,
+    cmac_k2: Cell<[u8; AES128_BLOCK_SIZE]>,
 }
 
 impl<'a> AesDriver<'a> {
@@ -49,17 +113,26 @@ impl<'a> AesDriver<'a> {
             apps: container,
             current_user: Cell::new(None),
             buffer: TakeCell::empty(),
+            crypt_offset: Cell::new(0),
+            crypt_chunk: Cell::new(0),
+            busy: Cell::new(false),
+            queue: RequestQueue::new(),
+            loaded_key: Cell::new(None),
+            cmac_phase: Cell::new(CmacPhase::Idle),
+            cmac_k1: Cell::new([0; AES128_BLOCK_SIZE]),
+            cmac_k2: Cell::new([0; AES128_BLOCK_SIZE]),
         }
     }
 
-    // Register a buffer, which must be of size AES128_BLOCK_SIZE; if
-    // it is not the proper size, return the buffer in the
+    // Register a buffer, which must be a whole nonzero number of
+    // blocks; if it is not the proper size, return the buffer in the
     // Option. Return None if the buffer was correct.
     pub fn initialize(&self,
                       input_buffer: &'a mut [u8]) -> Option<&'a mut [u8]>  {
         self.device.setup();
 
-        if input_buffer.len() != AES128_BLOCK_SIZE {
+        if input_buffer.len() == 0 ||
+           input_buffer.len() % AES128_BLOCK_SIZE != 0 {
             Some(input_buffer)
         } else {
             self.buffer.replace(input_buffer);
@@ -67,12 +140,48 @@ impl<'a> AesDriver<'a> {
         }
     }
 
+    // Loads the app's key into the engine, preferring a selected key
+    // slot over the legacy allowed key. Slot keys are reloaded only when
+    // the register holds a different (app, slot) pair, so back-to-back
+    // operations on the same slot skip both the transfer and the
+    // hardware key expansion.
+    fn install_app_key(&self, app_data: &mut AppData, caller_id: AppId) -> ReturnCode {
+        if let Some(slot) = app_data.active_key_slot {
+            match app_data.key_slots[slot] {
+                Some(ref key) => {
+                    if self.loaded_key.get() != Some((caller_id, slot)) {
+                        self.device.set_key(&key[..]);
+                        self.loaded_key.set(Some((caller_id, slot)));
+                    }
+                    ReturnCode::SUCCESS
+                }
+                None => {
+                    debug!("AES: key slot {} is empty.\n", slot);
+                    ReturnCode::EINVAL
+                }
+            }
+        } else {
+            let key = app_data.key.take();
+            key.map_or(ReturnCode::EINVAL, |key| {
+                if key.len() == AES128_KEY_SIZE {
+                    self.device.set_key(key.as_ref());
+                    self.loaded_key.set(None);
+                    app_data.key = Some(key);
+                    ReturnCode::SUCCESS
+                } else {
+                    debug!("AES: application encryption key is wrong size.\n");
+                    ReturnCode::EINVAL
+                }
+            })
+        }
+    }
+
     fn run_aes(&self, caller_id: AppId) -> ReturnCode {
         self.apps.enter(caller_id, |app_data, _| {
             if app_data.input_buffer.is_none() {
                 debug!("AES: Missing input buffer.\n");
                 return ReturnCode::ENOMEM;
-            } else if app_data.key.is_none() {
+            } else if app_data.key.is_none() && app_data.active_key_slot.is_none() {
                 debug!("AES: Missing application encryption key.\n");
                 return ReturnCode::ENOMEM;
             } else if self.buffer.is_none() {
@@ -80,32 +189,25 @@ impl<'a> AesDriver<'a> {
                 return ReturnCode::ENOMEM;
             }
 
-            let key = app_data.key.take();
-            let rcode = key.map_or(ReturnCode::EINVAL, |key| {
-                if key.len() == AES128_KEY_SIZE {
-                    self.device.set_key(key.as_ref());
-                    app_data.key = Some(key);
-                    ReturnCode::SUCCESS
-                } else {
-                    debug!("AES: application encryption key is wrong size.\n");
-                    ReturnCode::EINVAL
-                }
-            });
-
+            let rcode = self.install_app_key(app_data, caller_id);
             if rcode != ReturnCode::SUCCESS {
                 return rcode;
             }
 
-            // Copy application data into the kernel buffer
+            // Stage up to a kernel buffer's worth of application data;
+            // the engine streams the whole chunk on one submission and
+            // crypt_done() walks any remaining chunks.
+            self.crypt_offset.set(0);
+            let mut chunk = 0;
             self.buffer.map(|buf| {
                 app_data.input_buffer.as_ref().map(|src| {
-                    for (i, c) in src.as_ref()[0..AES128_BLOCK_SIZE].iter().enumerate() {
-                        buf[i] = *c;
-                    }
+                    chunk = cmp::min(src.len(), buf.len());
+                    buf[..chunk].copy_from_slice(&src.as_ref()[..chunk]);
                 });
             });
+            self.crypt_chunk.set(chunk);
             let buf = self.buffer.take().unwrap();
-            let opt =  AES128::crypt(self.device, None, buf, 0, AES128_BLOCK_SIZE);
+            let opt =  AES128::crypt(self.device, None, buf, 0, chunk);
             if let Some((rcode, _ibufopt, obuf)) = opt {
                 debug!("Failed to invoke AES encryption: {:?}", rcode);
                 self.buffer.put(Some(obuf));
@@ -115,55 +217,181 @@ impl<'a> AesDriver<'a> {
             }
         }).unwrap_or(ReturnCode::ENOMEM)
     }
-}
 
-impl<'a> symmetric_encryption::Client<'a> for AesDriver<'a> {
-    fn crypt_done(&self, _source: Option<&'a mut [u8]>, output: &'a mut [u8]) {
-        self.current_user.get().map(|current_user| {
-            let _ = self.apps.enter(current_user, move |app_data, _| {
-                if let Some(ref mut slice) = app_data.output_buffer {
-                    self.device.read_data(slice.as_mut());
+    // Starts a CMAC computation with the subkey-derivation encryption
+    // of the zero block; the data pass is chained from crypt_done().
+    fn start_cmac(&self, caller_id: AppId) -> ReturnCode {
+        self.apps.enter(caller_id, |app_data, _| {
+            let len = app_data.cmac_len;
+            if len > 0 && app_data.cmac_buffer.as_ref().map_or(true, |b| b.len() < len) {
+                debug!("AES: CMAC message buffer too short.\n");
+                return ReturnCode::ESIZE;
+            }
+            if app_data.output_buffer.as_ref()
+                .map_or(true, |b| b.len() < AES128_BLOCK_SIZE) {
+                debug!("AES: CMAC needs an output buffer for the tag.\n");
+                return ReturnCode::ENOMEM;
+            }
+            if self.buffer.is_none() {
+                debug!("AES: Missing kernel buffer.\n");
+                return ReturnCode::ENOMEM;
+            }
+            let rcode = self.install_app_key(app_data, caller_id);
+            if rcode != ReturnCode::SUCCESS {
+                return rcode;
+            }
+            self.device.set_mode_aes128ecb(true);
+            self.cmac_phase.set(CmacPhase::Subkey);
+            self.buffer.map(|buf| {
+                for b in buf[..AES128_BLOCK_SIZE].iter_mut() {
+                    *b = 0;
                 }
-                let val = {
-                    if let Some(ref mut slice) = app_data.input_buffer {
-                        self.device.read_data(slice.as_mut())
-                    } else {
-                        0
-                    }
-                };
-                self.current_user.set(None);
-                app_data.crypto_callback.map(|mut cb| cb.schedule(val, 0, 0));
             });
-        });
-        self.buffer.replace(output);
+            self.crypt_chunk.set(AES128_BLOCK_SIZE);
+            let buf = self.buffer.take().unwrap();
+            let opt = AES128::crypt(self.device, None, buf, 0, AES128_BLOCK_SIZE);
+            if let Some((rcode, _ibufopt, obuf)) = opt {
+                debug!("Failed to invoke AES encryption: {:?}", rcode);
+                self.buffer.put(Some(obuf));
+                self.cmac_phase.set(CmacPhase::Idle);
+                rcode
+            } else {
+                ReturnCode::SUCCESS
+            }
+        }).unwrap_or(ReturnCode::ENOMEM)
     }
-}
 
-
-
-impl<'a> Driver for AesDriver<'a> {
-    fn subscribe(&self,
-                 subscribe_num: usize,
-                 callback: Option<Callback>,
-                 app_id: AppId,
-    ) -> ReturnCode {
-        match subscribe_num {
-            0 => { // Encrypt/decrypt done
-                self.apps.enter(app_id, |app_data, _| {
-                    app_data.crypto_callback = callback;
-                    ReturnCode::SUCCESS
-                }).unwrap_or(ReturnCode::ENOMEM)
-            },
-            _ => ReturnCode::ENOSUPPORT
+    // Stages up to a kernel buffer's worth of CMAC blocks starting at
+    // crypt_offset, applying the RFC 4493 padding and subkey XOR when
+    // the chunk holds the final block, and pushes the chunk into the
+    // engine.
+    fn cmac_stage_and_run(&self, app_data: &mut AppData) -> ReturnCode {
+        let offset = self.crypt_offset.get();
+        let len = app_data.cmac_len;
+        // The message slice was validated when the CMAC started, but
+        // the app may have re-allowed a shorter buffer between chunk
+        // interrupts; re-check before indexing into it.
+        if len > 0 && app_data.cmac_buffer.as_ref().map_or(true, |b| b.len() < len) {
+            return ReturnCode::ESIZE;
+        }
+        let blocks = if len == 0 {
+            1
+        } else {
+            (len + AES128_BLOCK_SIZE - 1) / AES128_BLOCK_SIZE
+        };
+        let total = blocks * AES128_BLOCK_SIZE;
+        let mut chunk = 0;
+        self.buffer.map(|buf| {
+            chunk = cmp::min(total - offset, buf.len());
+            let src = app_data.cmac_buffer.as_ref().map_or(&[] as &[u8], |b| b.as_ref());
+            for i in 0..chunk {
+                let idx = offset + i;
+                buf[i] = if idx < len {
+                    src[idx]
+                } else if idx == len {
+                    0x80
+                } else {
+                    0
+                };
+            }
+            if offset + chunk == total {
+                let subkey = if len > 0 && len % AES128_BLOCK_SIZE == 0 {
+                    self.cmac_k1.get()
+                } else {
+                    self.cmac_k2.get()
+                };
+                for i in 0..AES128_BLOCK_SIZE {
+                    buf[chunk - AES128_BLOCK_SIZE + i] ^= subkey[i];
+                }
+            }
+        });
+        self.crypt_chunk.set(chunk);
+        let buf = self.buffer.take().unwrap();
+        let opt = AES128::crypt(self.device, None, buf, 0, chunk);
+        if let Some((rcode, _ibufopt, obuf)) = opt {
+            debug!("Failed to invoke AES encryption: {:?}", rcode);
+            self.buffer.put(Some(obuf));
+            rcode
+        } else {
+            ReturnCode::SUCCESS
         }
     }
 
-    fn command(&self, command_num: usize, _arg1: usize, _: usize, caller_id: AppId) -> ReturnCode {
-        if self.current_user.get() == None {
-            self.current_user.set(Some(caller_id));
-        }
-        match command_num {
-            0 /* Check if present */ => ReturnCode::SUCCESS,
+    // Advances the CMAC state machine on each cipher-done interrupt. A
+    // count of AES128_BLOCK_SIZE reports success to the app; 0 reports
+    // failure.
+    fn cmac_step(&self) {
+        self.current_user.get().map(|current_user| {
+            let _ = self.apps.enter(current_user, |app_data, _| {
+                // The engine drains the ciphertext back into the kernel
+                // buffer; the state machine only needs the last block of
+                // the submission (the subkey seed or the running tag).
+                let mut block = [0; AES128_BLOCK_SIZE];
+                self.buffer.map(|buf| {
+                    let chunk = self.crypt_chunk.get();
+                    block.copy_from_slice(&buf[chunk - AES128_BLOCK_SIZE..chunk]);
+                });
+                let finished = match self.cmac_phase.get() {
+                    CmacPhase::Subkey => {
+                        let k1 = cmac_ls1(&block);
+                        self.cmac_k2.set(cmac_ls1(&k1));
+                        self.cmac_k1.set(k1);
+                        self.device.set_mode_aes128cbc(true);
+                        self.device.set_iv(&[0; AES128_BLOCK_SIZE]);
+                        self.cmac_phase.set(CmacPhase::Data);
+                        self.crypt_offset.set(0);
+                        if self.cmac_stage_and_run(app_data) != ReturnCode::SUCCESS {
+                            Some(0)
+                        } else {
+                            None
+                        }
+                    }
+                    CmacPhase::Data => {
+                        let len = app_data.cmac_len;
+                        let blocks = if len == 0 {
+                            1
+                        } else {
+                            (len + AES128_BLOCK_SIZE - 1) / AES128_BLOCK_SIZE
+                        };
+                        let next = self.crypt_offset.get() + self.crypt_chunk.get();
+                        if next < blocks * AES128_BLOCK_SIZE {
+                            self.crypt_offset.set(next);
+                            if self.cmac_stage_and_run(app_data) != ReturnCode::SUCCESS {
+                                Some(0)
+                            } else {
+                                None
+                            }
+                        } else {
+                            // The final ciphertext block is the tag.
+                            app_data.output_buffer.as_mut().map(|out| {
+                                out.as_mut()[..AES128_BLOCK_SIZE]
+                                    .copy_from_slice(&block);
+                            });
+                            Some(AES128_BLOCK_SIZE)
+                        }
+                    }
+                    CmacPhase::Idle => Some(0),
+                };
+                if let Some(val) = finished {
+                    // Scrub the subkeys; they are derived from the key.
+                    self.cmac_k1.set([0; AES128_BLOCK_SIZE]);
+                    self.cmac_k2.set([0; AES128_BLOCK_SIZE]);
+                    self.cmac_phase.set(CmacPhase::Idle);
+                    self.busy.set(false);
+                    self.current_user.set(None);
+                    app_data.crypto_callback.map(|mut cb| cb.schedule(val, 0, 0));
+                }
+            });
+        });
+    }
+
+    // Claims the engine and starts one of the crypt commands (1-6, 10)
+    // for the given app. Clears the claim again if the start fails, so a
+    // queued request can never wedge the driver.
+    fn start_crypt(&self, command_num: usize, caller_id: AppId) -> ReturnCode {
+        self.busy.set(true);
+        self.current_user.set(Some(caller_id));
+        let rcode = match command_num {
             1 /* encrypt ECB */ => {
                 self.device.set_mode_aes128ecb(true);
                 self.run_aes(caller_id)
@@ -191,12 +419,161 @@ impl<'a> Driver for AesDriver<'a> {
                 self.device.set_mode_aes128cbc(false);
                 self.run_aes(caller_id)
             },
+            10 /* AES-CMAC */ => self.start_cmac(caller_id),
+            _ => ReturnCode::ENOSUPPORT,
+        };
+        if rcode != ReturnCode::SUCCESS {
+            self.busy.set(false);
+            self.current_user.set(None);
+        }
+        rcode
+    }
+
+    // Fails a request back to its app through the callback (count of
+    // 0), the only path a queued request has once its synchronous
+    // return is gone.
+    fn fail_queued(&self, app_id: AppId) {
+        let _ = self.apps.enter(app_id, |app_data, _| {
+            app_data.crypto_callback.map(|mut cb| cb.schedule(0, 0, 0));
+        });
+    }
+
+    // Drops timed-out requests, then starts queued requests in order
+    // until one is running or the queue is empty.
+    fn run_next_queued(&self) {
+        self.queue.expire_stale(|app_id| self.fail_queued(app_id));
+        while !self.busy.get() {
+            match self.queue.dequeue() {
+                None => return,
+                Some((app_id, command_num, _)) => {
+                    if self.start_crypt(command_num, app_id) != ReturnCode::SUCCESS {
+                        self.fail_queued(app_id);
+                    }
+                }
+            }
+        }
+    }
+
+    /// Wires up the microsecond clock used to expire queued requests.
+    pub fn set_queue_timer(&self, timer: &'static Timeus) {
+        self.queue.set_timer(timer);
+    }
+}
+
+impl<'a> symmetric_encryption::Client<'a> for AesDriver<'a> {
+    fn crypt_done(&self, _source: Option<&'a mut [u8]>, output: &'a mut [u8]) {
+        self.buffer.replace(output);
+        if self.cmac_phase.get() != CmacPhase::Idle {
+            self.cmac_step();
+            self.run_next_queued();
+            return;
+        }
+        self.current_user.get().map(|current_user| {
+            let _ = self.apps.enter(current_user, move |app_data, _| {
+                let offset = self.crypt_offset.get();
+                let chunk = self.crypt_chunk.get();
+                // The engine drained the results into the kernel buffer;
+                // copy the finished chunk back out to the app. The app
+                // may have re-allowed a shorter buffer since the chunk
+                // was staged, so both paths re-check the length.
+                self.buffer.map(|buf| {
+                    if let Some(ref mut slice) = app_data.output_buffer {
+                        if slice.len() >= offset + chunk {
+                            slice.as_mut()[offset..offset + chunk]
+                                .copy_from_slice(&buf[..chunk]);
+                        }
+                    } else if let Some(ref mut slice) = app_data.input_buffer {
+                        if slice.len() >= offset + chunk {
+                            slice.as_mut()[offset..offset + chunk]
+                                .copy_from_slice(&buf[..chunk]);
+                        }
+                    }
+                });
+                // If the allowed input buffer holds further chunks, stage
+                // the next one and keep the engine running: it carries the
+                // CTR/CBC state between blocks, so an arbitrary-length
+                // buffer is a single submission with one callback at the
+                // end instead of a command/callback round trip per block.
+                let next = offset + chunk;
+                let more = app_data.input_buffer.as_ref()
+                    .map_or(false, |src| next + AES128_BLOCK_SIZE <= src.len());
+                if more {
+                    self.crypt_offset.set(next);
+                    let mut staged = 0;
+                    self.buffer.map(|buf| {
+                        app_data.input_buffer.as_ref().map(|src| {
+                            staged = cmp::min(src.len() - next, buf.len());
+                            buf[..staged].copy_from_slice(
+                                &src.as_ref()[next..next + staged]);
+                        });
+                    });
+                    self.crypt_chunk.set(staged);
+                    let buf = self.buffer.take().unwrap();
+                    let opt = AES128::crypt(self.device, None, buf, 0, staged);
+                    if let Some((rcode, _ibufopt, obuf)) = opt {
+                        debug!("Failed to invoke AES encryption: {:?}", rcode);
+                        self.buffer.put(Some(obuf));
+                        self.busy.set(false);
+                        self.current_user.set(None);
+                        app_data.crypto_callback.map(|mut cb| cb.schedule(next, 0, 0));
+                    }
+                } else {
+                    self.busy.set(false);
+                    self.current_user.set(None);
+                    app_data.crypto_callback.map(|mut cb| cb.schedule(next, 0, 0));
+                }
+            });
+        });
+        self.run_next_queued();
+    }
+}
+
+
+
+impl<'a> Driver for AesDriver<'a> {
+    fn subscribe(&self,
+                 subscribe_num: usize,
+                 callback: Option<Callback>,
+                 app_id: AppId,
+    ) -> ReturnCode {
+        match subscribe_num {
+            0 => { // Encrypt/decrypt done
+                self.apps.enter(app_id, |app_data, _| {
+                    app_data.crypto_callback = callback;
+                    ReturnCode::SUCCESS
+                }).unwrap_or(ReturnCode::ENOMEM)
+            },
+            _ => ReturnCode::ENOSUPPORT
+        }
+    }
+
+    fn command(&self, command_num: usize, arg1: usize, _: usize, caller_id: AppId) -> ReturnCode {
+        match command_num {
+            0 /* Check if present */ => ReturnCode::SUCCESS,
+            1 | 2 | 3 | 4 | 5 | 6 /* ECB/CTR/CBC encrypt/decrypt */ => {
+                if self.busy.get() {
+                    // Engine in use: park the request and report it
+                    // through the app's callback once it completes.
+                    self.queue.expire_stale(|app_id| self.fail_queued(app_id));
+                    self.queue.enqueue(caller_id, command_num, 0)
+                } else {
+                    self.start_crypt(command_num, caller_id)
+                }
+            },
             7 /* install key */ => {
+                if self.busy.get() {
+                    // Loading the key register would corrupt the running
+                    // operation.
+                    return ReturnCode::EBUSY;
+                }
                 self.apps.enter(caller_id, |app_data, _| {
                     let key = app_data.key.take();
                     let rcode = key.map_or(ReturnCode::ENOMEM, |key| {
                         if key.len() == AES128_KEY_SIZE {
                             self.device.set_key(key.as_ref());
+                            // The register no longer holds any cached
+                            // slot key.
+                            self.loaded_key.set(None);
                         }
                         app_data.key = Some(key);
                         ReturnCode::SUCCESS
@@ -204,10 +581,54 @@ impl<'a> Driver for AesDriver<'a> {
                     rcode
                 }).unwrap_or(ReturnCode::ENOMEM)
             }
-            _ => {
-                self.current_user.set(None);
-                ReturnCode::ENOSUPPORT
+            8 /* store key in slot arg1 */ => {
+                if arg1 >= KEY_SLOT_COUNT {
+                    return ReturnCode::EINVAL;
+                }
+                self.apps.enter(caller_id, |app_data, _| {
+                    app_data.key.as_ref().map_or(ReturnCode::ENOMEM, |key| {
+                        if key.len() != AES128_KEY_SIZE {
+                            return ReturnCode::ESIZE;
+                        }
+                        let mut stored = [0; AES128_KEY_SIZE];
+                        stored.copy_from_slice(key.as_ref());
+                        app_data.key_slots[arg1] = Some(stored);
+                        // The register may hold this slot's old key.
+                        if self.loaded_key.get() == Some((caller_id, arg1)) {
+                            self.loaded_key.set(None);
+                        }
+                        ReturnCode::SUCCESS
+                    })
+                }).unwrap_or(ReturnCode::ENOMEM)
+            }
+            9 /* select key slot arg1 */ => {
+                if arg1 >= KEY_SLOT_COUNT {
+                    return ReturnCode::EINVAL;
+                }
+                self.apps.enter(caller_id, |app_data, _| {
+                    if app_data.key_slots[arg1].is_none() {
+                        return ReturnCode::EINVAL;
+                    }
+                    app_data.active_key_slot = Some(arg1);
+                    ReturnCode::SUCCESS
+                }).unwrap_or(ReturnCode::ENOMEM)
             }
+            10 /* AES-CMAC, arg1 = message length in bytes */ => {
+                let rcode = self.apps.enter(caller_id, |app_data, _| {
+                    app_data.cmac_len = arg1;
+                    ReturnCode::SUCCESS
+                }).unwrap_or(ReturnCode::ENOMEM);
+                if rcode != ReturnCode::SUCCESS {
+                    return rcode;
+                }
+                if self.busy.get() {
+                    self.queue.expire_stale(|app_id| self.fail_queued(app_id));
+                    self.queue.enqueue(caller_id, command_num, 0)
+                } else {
+                    self.start_crypt(command_num, caller_id)
+                }
+            }
+            _ => ReturnCode::ENOSUPPORT,
         }
     }
 
@@ -226,6 +647,9 @@ impl<'a> Driver for AesDriver<'a> {
                                     return ReturnCode::ESIZE;
                                 }
                                 app_data.key = Some(s);
+                                // A freshly allowed key takes precedence
+                                // over any selected slot.
+                                app_data.active_key_slot = None;
                             } else {
                                 app_data.key = slice;
                             }
@@ -235,11 +659,11 @@ impl<'a> Driver for AesDriver<'a> {
                         .unwrap_or(ReturnCode::FAIL)
                 }
                 1 => {
-                    // Input Buffer
+                    // Input Buffer; any whole number of blocks
                     self.apps
                         .enter(app_id, |app_data, _| {
                             if let Some(s) = slice {
-                                if s.len() != AES128_BLOCK_SIZE {
+                                if s.len() == 0 || s.len() % AES128_BLOCK_SIZE != 0 {
                                     return ReturnCode::ESIZE;
                                 }
                                 app_data.input_buffer = Some(s);
@@ -251,11 +675,11 @@ impl<'a> Driver for AesDriver<'a> {
                         .unwrap_or(ReturnCode::FAIL)
                 }
                 2 => {
-                    // Output Buffer
+                    // Output Buffer; any whole number of blocks
                     self.apps
                         .enter(app_id, |app_data, _| {
                             if let Some(s) = slice {
-                                if s.len() != AES128_BLOCK_SIZE {
+                                if s.len() == 0 || s.len() % AES128_BLOCK_SIZE != 0 {
                                     return ReturnCode::ESIZE;
                                 }
                                 app_data.output_buffer = Some(s);
@@ -282,6 +706,16 @@ impl<'a> Driver for AesDriver<'a> {
                         })
                         .unwrap_or(ReturnCode::FAIL)
                 }
+                4 => {
+                    // CMAC message; any length, the driver pads the
+                    // final block itself
+                    self.apps
+                        .enter(app_id, |app_data, _| {
+                            app_data.cmac_buffer = slice;
+                            ReturnCode::SUCCESS
+                        })
+                        .unwrap_or(ReturnCode::FAIL)
+                }
             _ => ReturnCode::ENOSUPPORT,
         }
     }
@@ -0,0 +1,155 @@
+// Copyright 2021 Google LLC
+//
+// Licensed under the Apache License, Version 2.0 (the "License");
+// you may not use this file except in compliance with the License.
+// You may obtain a copy of the License at
+//
+//     https://www.apache.org/licenses/LICENSE-2.0
+//
+// Unless required by applicable law or agreed to in writing, software
+// distributed under the License is distributed on an "AS IS" BASIS,
+// WITHOUT WARRANTIES OR CONDITIONS OF ANY KIND, either express or implied.
+// See the License for the specific language governing permissions and
+// limitations under the License.
+
+//! Request arbitration shared by the crypto engine drivers.
+//!
+//! Each hardware engine serves one request at a time; when several
+//! processes use an engine, requests arriving while it is busy are
+//! parked in a `RequestQueue` instead of busy-failing back to the app.
+//! The queue is priority-aware (the U2F app jumps ahead of test and
+//! management apps, so token latency stays bounded) and FIFO within a
+//! priority class, which keeps scheduling fair among the background
+//! apps. Entries that sit queued past a timeout are dropped and their
+//! apps notified, so a wedged or slow requester cannot park the rest
+//! of the system forever.
+
+use core::cell::Cell;
+use h1::timeus::Timeus;
+use kernel::{AppId, ReturnCode};
+
+/// Our boards load the U2F app first, so process index 0 gets
+/// priority; everything else (tests, management apps) shares the
+/// normal class.
+const HIGH_PRIORITY_APP_IDX: usize = 0;
+
+/// How long a request may sit queued before it is dropped. Expiry is
+/// lazy - checked when the queue is touched, not from a timer
+/// interrupt - which is enough here because the queue is only
+/// non-empty while an operation is running, and every operation ends
+/// in an interrupt that consults the queue. Generous compared to any
+/// single engine operation (the longest, a dcrypto P256 sign, is
+/// under 100ms).
+const REQUEST_TIMEOUT_US: u32 = 3_000_000;
+
+const QUEUE_LEN: usize = 4;
+
+#[derive(Copy, Clone)]
+struct Entry {
+    app: AppId,
+    command: usize,
+    arg: usize,
+    enqueued_at: u32,
+}
+
+pub struct RequestQueue {
+    slots: [Cell<Option<Entry>>; QUEUE_LEN],
+    /// Microsecond clock for expiry, shared by the drivers and wired
+    /// up by the board. Ages are computed with wrapping arithmetic, so
+    /// the 32-bit wrap (~71 minutes) is harmless for entries that live
+    /// for seconds. Without a clock nothing ever expires.
+    timer: Cell<Option<&'static Timeus>>,
+}
+
+impl RequestQueue {
+    pub fn new() -> RequestQueue {
+        RequestQueue {
+            slots: Default::default(),
+            timer: Cell::new(None),
+        }
+    }
+
+    pub fn set_timer(&self, timer: &'static Timeus) {
+        self.timer.set(Some(timer));
+    }
+
+    fn now(&self) -> u32 {
+        self.timer.get().map_or(0, |t| t.now())
+    }
+
+    /// Parks a request. High-priority requests are inserted behind any
+    /// queued high-priority requests but ahead of the normal class;
+    /// within a class order is FIFO. EBUSY once the queue is full.
+    pub fn enqueue(&self, app: AppId, command: usize, arg: usize) -> ReturnCode {
+        if self.slots[QUEUE_LEN - 1].get().is_some() {
+            return ReturnCode::EBUSY;
+        }
+        let high = app.idx() == HIGH_PRIORITY_APP_IDX;
+        let mut pos = QUEUE_LEN - 1;
+        for (i, slot) in self.slots.iter().enumerate() {
+            match slot.get() {
+                None => {
+                    pos = i;
+                    break;
+                }
+                Some(entry) => {
+                    if high && entry.app.idx() != HIGH_PRIORITY_APP_IDX {
+                        pos = i;
+                        break;
+                    }
+                }
+            }
+        }
+        for i in (pos..QUEUE_LEN - 1).rev() {
+            self.slots[i + 1].set(self.slots[i].get());
+        }
+        self.slots[pos].set(Some(Entry {
+            app: app,
+            command: command,
+            arg: arg,
+            enqueued_at: self.now(),
+        }));
+        ReturnCode::SUCCESS
+    }
+
+    /// Returns whether any request is parked. Callers deciding whether
+    /// to checkpoint around the next operation should run
+    /// `expire_stale` first so stale entries do not force a save.
+    pub fn is_empty(&self) -> bool {
+        self.slots[0].get().is_none()
+    }
+
+    /// Removes and returns the request at the head of the queue.
+    pub fn dequeue(&self) -> Option<(AppId, usize, usize)> {
+        let head = self.slots[0].take();
+        for i in 1..QUEUE_LEN {
+            self.slots[i - 1].set(self.slots[i].take());
+        }
+        head.map(|entry| (entry.app, entry.command, entry.arg))
+    }
+
+    /// Drops every entry that has waited past the timeout, invoking
+    /// `expired` for each so the driver can fail it back to its app.
+    /// Drivers call this before consulting or extending the queue.
+    pub fn expire_stale<F: FnMut(AppId)>(&self, mut expired: F) {
+        if self.timer.get().is_none() {
+            return;
+        }
+        let now = self.now();
+        let mut i = 0;
+        while i < QUEUE_LEN {
+            let stale = self.slots[i].get().map_or(false, |entry| {
+                now.wrapping_sub(entry.enqueued_at) > REQUEST_TIMEOUT_US
+            });
+            if stale {
+                let entry = self.slots[i].take().unwrap();
+                for j in i + 1..QUEUE_LEN {
+                    self.slots[j - 1].set(self.slots[j].take());
+                }
+                expired(entry.app);
+            } else {
+                i += 1;
+            }
+        }
+    }
+}
@@ -12,10 +12,14 @@
 // See the License for the specific language governing permissions and
 // limitations under the License.
 
+use crate::arbiter::RequestQueue;
 use core::cell::Cell;
+use core::cmp;
+use core::slice;
+use kernel::common::cells::TakeCell;
 use h1::crypto::dcrypto::{Dcrypto, DcryptoClient, ProgramFault};
-use kernel::{AppId, Callback, Driver, ReturnCode, Shared, AppSlice};
-use kernel::common::cells::MapCell;
+use h1::timeus::Timeus;
+use kernel::{AppId, Callback, Driver, Grant, ReturnCode, Shared, AppSlice};
 
 pub const DRIVER_NUM: usize = 0x40004;
 
@@ -23,6 +27,9 @@ pub struct App {
     program: Option<AppSlice<Shared, u8>>,
     data_buffer: Option<AppSlice<Shared, u8>>,
     callback: Option<Callback>,
+    // DMEM words preserved across yields of this app's checkpoint
+    // session (see command 7). 0 until the first segment runs.
+    checkpoint_words: usize,
 }
 
 impl Default for App {
@@ -30,27 +37,107 @@ impl Default for App {
         App {
             program: None,
             data_buffer: None,
-            callback: None
+            callback: None,
+            checkpoint_words: 0,
         }
     }
 }
 
 pub struct DcryptoDriver<'a> {
     device: &'a dyn Dcrypto<'a>,
-    app: MapCell<App>,
+    // Per-process state, so two apps using the engine cannot clobber
+    // each other's buffers or callbacks.
+    apps: Grant<App>,
+    // Which app's operation is running on the engine.
+    current_user: Cell<Option<AppId>>,
     busy: Cell<bool>,
+    // Requests arriving while the engine is busy wait here and start
+    // as running operations complete.
+    queue: RequestQueue,
+    // Owning app, content hash and length of the program currently
+    // resident in IMEM, so an app re-loading its own identical program
+    // skips the upload. The owner is part of the key because residency
+    // also stands in for the register and DMEM state the owner's runs
+    // built up: another app's runs clobber those even when its program
+    // bytes happen to hash the same. Only a cache: a stale entry costs
+    // a redundant upload, never a wrong program.
+    resident_program: Cell<Option<(usize, u32, usize)>>,
+    // Checkpoint state for one long-running operation executed as a
+    // series of segments (command 7). At each segment boundary the
+    // session's DMEM working set is saved here if another request is
+    // waiting, so a queued short program (a U2F sign jumping the queue)
+    // can clobber DMEM and the next segment command restores it. The
+    // buffer is board-allocated; without one, command 7 reports
+    // ENOSUPPORT.
+    checkpoint_buffer: TakeCell<'static, [u8]>,
+    checkpoint_user: Cell<Option<AppId>>,
+    checkpoint_saved: Cell<bool>,
 }
 
 impl<'a> DcryptoDriver<'a> {
-    pub fn new(device: &'a mut dyn Dcrypto<'a>) -> DcryptoDriver<'a> {
+    pub fn new(device: &'a mut dyn Dcrypto<'a>,
+               container: Grant<App>) -> DcryptoDriver<'a> {
         DcryptoDriver {
             device: device,
-            app: MapCell::new(App::default()),
+            apps: container,
+            current_user: Cell::new(None),
             busy: Cell::new(false),
+            queue: RequestQueue::new(),
+            resident_program: Cell::new(None),
+            checkpoint_buffer: TakeCell::empty(),
+            checkpoint_user: Cell::new(None),
+            checkpoint_saved: Cell::new(false),
        }
     }
 
-    fn run_program(&self, app: &mut App, instruction: u32) -> ReturnCode {
+    /// Wires up the microsecond clock used to expire queued requests.
+    pub fn set_queue_timer(&self, timer: &'static Timeus) {
+        self.queue.set_timer(timer);
+    }
+
+    /// Wires up the board-allocated buffer that DMEM checkpoints are
+    /// saved into. Its length bounds how large a working set a
+    /// checkpoint session can preserve across yields.
+    pub fn set_checkpoint_buffer(&self, buffer: &'static mut [u8]) {
+        self.checkpoint_buffer.replace(buffer);
+    }
+
+    /// FNV-1a over the program bytes. Cheap enough to run on every load
+    /// (a few cycles per byte over a ~1KB program) and collision
+    /// resistance is not load-bearing here: the hash only dedupes
+    /// uploads of content the same process supplied.
+    fn program_hash(program: &[u8]) -> u32 {
+        let mut hash: u32 = 0x811c9dc5;
+        for byte in program {
+            hash ^= *byte as u32;
+            hash = hash.wrapping_mul(16777619);
+        }
+        hash
+    }
+
+    /// Uploads the app's program to IMEM unless this app's identical
+    /// program is already resident. Returns SuccessWithValue(1) when
+    /// the program was actually uploaded and plain SUCCESS when it was
+    /// already resident, so callers can tell whether engine state tied
+    /// to the previous residency (wide registers, staged DMEM)
+    /// survived.
+    fn write_program_if_changed(&self, caller_id: AppId, program: &[u8]) -> ReturnCode {
+        let key = (caller_id.idx(), Self::program_hash(program), program.len());
+        if self.resident_program.get() == Some(key) {
+            return ReturnCode::SUCCESS;
+        }
+        // Invalidate across the upload so a failure partway through
+        // does not leave a matching entry for mixed IMEM contents.
+        self.resident_program.set(None);
+        let rval = self.device.write_instructions(program, 0, (program.len() / 4) as u32);
+        if rval == ReturnCode::SUCCESS {
+            self.resident_program.set(Some(key));
+            return ReturnCode::SuccessWithValue { value: 1 };
+        }
+        rval
+    }
+
+    fn run_program(&self, app: &mut App, caller_id: AppId, instruction: u32) -> ReturnCode {
         if app.data_buffer.is_none() || app.program.is_none() {
             return ReturnCode::ENOMEM;
         }
@@ -65,12 +152,16 @@ impl<'a> DcryptoDriver<'a> {
             let data = data_slice.as_ref();
             let data_len = data.len() / 4;
             let program = program_slice.as_ref();
-            let program_len = program.len() / 4;
 
             rval = self.device.write_data(data, 0, data_len as u32);
 
             if rval == ReturnCode::SUCCESS {
-                rval = self.device.write_instructions(program, 0, program_len as u32);
+                // A full run stages everything, so whether the upload
+                // was fresh does not matter here.
+                rval = match self.write_program_if_changed(caller_id, program) {
+                    ReturnCode::SuccessWithValue { .. } => ReturnCode::SUCCESS,
+                    other => other,
+                };
             }
         };
         app.data_buffer = Some(data_slice);
@@ -85,51 +176,303 @@ impl<'a> DcryptoDriver<'a> {
         }
         ReturnCode::SUCCESS
     }
+
+    fn load_program(&self, app: &mut App, caller_id: AppId) -> ReturnCode {
+        if app.program.is_none() {
+            return ReturnCode::ENOMEM;
+        }
+
+        let program_slice = app.program.take().unwrap();
+        let rval = self.write_program_if_changed(caller_id, program_slice.as_ref());
+        app.program = Some(program_slice);
+        rval
+    }
+
+    /// Uploads a program to IMEM straight from its address in the
+    /// memory-mapped flash, so a flash-resident program (e.g. a const
+    /// array in app code) never needs staging through an app RAM buffer.
+    /// The range must be word aligned and lie entirely within the
+    /// flash window; flash is uniformly readable on this chip, so
+    /// pointing at it grants the app nothing it could not already read.
+    fn load_program_flash(&self, caller_id: AppId, addr: usize, len: usize) -> ReturnCode {
+        use h1::hil::flash::h1_hw::{H1_FLASH_SIZE, H1_FLASH_START};
+        if len == 0 || addr % 4 != 0 || len % 4 != 0 {
+            return ReturnCode::EINVAL;
+        }
+        let end = match addr.checked_add(len) {
+            Some(end) => end,
+            None => return ReturnCode::EINVAL,
+        };
+        if addr < H1_FLASH_START || end > H1_FLASH_START + H1_FLASH_SIZE {
+            return ReturnCode::EINVAL;
+        }
+        let program = unsafe { slice::from_raw_parts(addr as *const u8, len) };
+        self.write_program_if_changed(caller_id, program)
+    }
+
+    /// Copies one word range of the app's data buffer into DMEM at the
+    /// same offset. `range` packs the word offset in its high 16 bits
+    /// and the word count in its low 16 bits. Together with
+    /// `call_staged`, this lets a caller re-stage only the DMEM words
+    /// that changed since the last run instead of the whole buffer.
+    fn stage_range(&self, app: &mut App, range: usize) -> ReturnCode {
+        if app.data_buffer.is_none() {
+            return ReturnCode::ENOMEM;
+        }
+
+        let offset = (range >> 16) & 0xffff;
+        let length = range & 0xffff;
+
+        let data_slice = app.data_buffer.take().unwrap();
+        let rval = {
+            let data = data_slice.as_ref();
+            if (offset + length) * 4 > data.len() {
+                ReturnCode::ESIZE
+            } else {
+                self.device.write_data(&data[offset * 4..], offset as u32, length as u32)
+            }
+        };
+        app.data_buffer = Some(data_slice);
+        rval
+    }
+
+    /// Calls the resident program without touching DMEM: the caller is
+    /// responsible for having staged (or kept) the DMEM contents it
+    /// needs, via a previous full call or `stage_range`. The data
+    /// buffer must still be allowed, since results are read back into
+    /// it on completion.
+    fn call_staged(&self, app: &mut App, instruction: u32) -> ReturnCode {
+        if app.data_buffer.is_none() {
+            return ReturnCode::ENOMEM;
+        }
+        self.device.call_imem(instruction)
+    }
+
+    fn call_program(&self, app: &mut App, instruction: u32) -> ReturnCode {
+        if app.data_buffer.is_none() {
+            return ReturnCode::ENOMEM;
+        }
+
+        // Only data memory is staged; the program loaded by a previous
+        // load command stays resident in IMEM.
+        let data_slice = app.data_buffer.take().unwrap();
+        let rval = {
+            let data = data_slice.as_ref();
+            let data_len = data.len() / 4;
+            self.device.write_data(data, 0, data_len as u32)
+        };
+        app.data_buffer = Some(data_slice);
+
+        if rval != ReturnCode::SUCCESS {
+            return rval;
+        }
+        self.device.call_imem(instruction)
+    }
+
+    /// Runs one segment of a long operation that yields the engine at
+    /// segment boundaries. The first segment stages data and program
+    /// like a full run; later segments resume from the DMEM state the
+    /// previous segment left (restoring it from the checkpoint buffer
+    /// if another program ran in between). The sign-latency impact of
+    /// the long operation on other users is thereby bounded by one
+    /// segment, not its full length.
+    fn run_segment(&self, app: &mut App, caller_id: AppId,
+                   instruction: u32) -> ReturnCode {
+        if self.checkpoint_user.get().map_or(false,
+            |user| user.idx() != caller_id.idx()) {
+            // One checkpoint session at a time; a second long job has
+            // to wait for command 8 from the first.
+            return ReturnCode::EBUSY;
+        }
+        if self.checkpoint_user.get().is_none() {
+            // First segment of a session.
+            if app.checkpoint_words == 0 {
+                app.checkpoint_words = app.data_buffer.as_ref()
+                    .map_or(0, |buffer| buffer.len() / 4);
+            }
+            let rval = self.run_program(app, caller_id, instruction);
+            if rval == ReturnCode::SUCCESS {
+                self.checkpoint_user.set(Some(caller_id));
+            }
+            return rval;
+        }
+        if self.checkpoint_saved.get() {
+            // Another program ran since the last segment: put the
+            // session's DMEM working set and program back.
+            let mut rval = ReturnCode::FAIL;
+            self.checkpoint_buffer.map(|buffer| {
+                let words = cmp::min(app.checkpoint_words, buffer.len() / 4);
+                rval = self.device.write_data(buffer, 0, words as u32);
+            });
+            if rval == ReturnCode::SUCCESS {
+                if app.program.is_none() {
+                    return ReturnCode::ENOMEM;
+                }
+                let program_slice = app.program.take().unwrap();
+                rval = match self.write_program_if_changed(
+                    caller_id, program_slice.as_ref()) {
+                    ReturnCode::SuccessWithValue { .. } => ReturnCode::SUCCESS,
+                    other => other,
+                };
+                app.program = Some(program_slice);
+            }
+            if rval != ReturnCode::SUCCESS {
+                return rval;
+            }
+            self.checkpoint_saved.set(false);
+        }
+        self.call_staged(app, instruction)
+    }
+
+    // Claims the engine and starts one of the program-execution
+    // commands (1, 3, 5, 7) for the given app. The claim is only taken
+    // on success, so a failed start can never wedge the driver.
+    fn start_op(&self, command_num: usize, instruction: usize,
+                caller_id: AppId) -> ReturnCode {
+        self.apps.enter(caller_id, |app, _| {
+            let rval = match command_num {
+                1 => self.run_program(app, caller_id, instruction as u32),
+                3 => self.call_program(app, instruction as u32),
+                5 => self.call_staged(app, instruction as u32),
+                7 => self.run_segment(app, caller_id, instruction as u32),
+                _ => ReturnCode::ENOSUPPORT,
+            };
+            if rval == ReturnCode::SUCCESS {
+                self.busy.set(true);
+                self.current_user.set(Some(caller_id));
+            }
+            rval
+        }).unwrap_or(ReturnCode::ENOMEM)
+    }
+
+    // Fails a request back to its app through the callback, the only
+    // path a queued request has once its synchronous return is gone.
+    fn fail_queued(&self, app_id: AppId) {
+        let _ = self.apps.enter(app_id, |app, _| {
+            app.callback.map(|mut cb| {
+                cb.schedule(usize::from(ReturnCode::FAIL), 0, 0)
+            });
+        });
+    }
+
+    // Drops timed-out requests, then starts queued requests in order
+    // until one is running or the queue is empty.
+    fn run_next_queued(&self) {
+        self.queue.expire_stale(|app_id| self.fail_queued(app_id));
+        while !self.busy.get() {
+            match self.queue.dequeue() {
+                None => return,
+                Some((app_id, command_num, instruction)) => {
+                    if self.start_op(command_num, instruction, app_id) !=
+                       ReturnCode::SUCCESS {
+                        self.fail_queued(app_id);
+                    }
+                }
+            }
+        }
+    }
 }
 
 impl<'a> Driver for DcryptoDriver<'a> {
     fn subscribe(&self,
                  subscribe_num: usize,
                  callback: Option<Callback>,
-                 _app_id: AppId,
+                 app_id: AppId,
     ) -> ReturnCode {
         match subscribe_num {
             0 => {
-                self.app.map(|app| {
+                self.apps.enter(app_id, |app, _| {
                     app.callback = callback;
-                });
-                ReturnCode::SUCCESS
+                    ReturnCode::SUCCESS
+                }).unwrap_or(ReturnCode::ENOMEM)
             },
             _ => ReturnCode::ENOSUPPORT
         }
     }
 
-    fn command(&self, command_num: usize, instruction: usize, _: usize, _: AppId) -> ReturnCode {
+    fn command(&self, command_num: usize, instruction: usize, arg2: usize, caller_id: AppId) -> ReturnCode {
         match command_num {
             0 /* Check if present */ => ReturnCode::SUCCESS,
-            1 /* run program */ => {
+            1 | 3 | 5 | 7 /* run / call resident / call staged /
+                             run checkpointable segment */ => {
+                if command_num == 7 {
+                    if self.checkpoint_buffer.is_none() {
+                        return ReturnCode::ENOSUPPORT;
+                    }
+                    // arg2 sets (or, when 0, keeps) how many DMEM words
+                    // the session preserves across yields; saving only
+                    // the working set keeps yield cost proportional to
+                    // it.
+                    if arg2 != 0 {
+                        let rval = self.apps.enter(caller_id, |app, _| {
+                            app.checkpoint_words = arg2;
+                            ReturnCode::SUCCESS
+                        }).unwrap_or(ReturnCode::ENOMEM);
+                        if rval != ReturnCode::SUCCESS {
+                            return rval;
+                        }
+                    }
+                }
                 if self.busy.get() {
+                    // Engine in use: park the request and report it
+                    // through the app's callback once it runs.
+                    self.queue.expire_stale(|app_id| self.fail_queued(app_id));
+                    self.queue.enqueue(caller_id, command_num, instruction)
+                } else {
+                    self.start_op(command_num, instruction, caller_id)
+                }
+            }
+            2 /* load program into IMEM */ => {
+                if self.busy.get() {
+                    // Synchronous commands touch engine memory in place
+                    // and have no callback to defer to, so they cannot
+                    // be queued behind a running operation.
                     ReturnCode::EBUSY
                 } else {
-                    self.app.map_or(ReturnCode::EBUSY, |app| {
-                        self.busy.set(true);
-                        self.run_program(app, instruction as u32)
-                    })
+                    self.apps.enter(caller_id, |app, _| {
+                        self.load_program(app, caller_id)
+                    }).unwrap_or(ReturnCode::ENOMEM)
                 }
             }
+            4 /* stage DMEM range */ => {
+                if self.busy.get() {
+                    ReturnCode::EBUSY
+                } else {
+                    self.apps.enter(caller_id, |app, _| {
+                        self.stage_range(app, instruction)
+                    }).unwrap_or(ReturnCode::ENOMEM)
+                }
+            }
+            6 /* load program into IMEM from flash.
+                 instruction: byte address of the program in flash.
+                 arg2: program length in bytes. */ => {
+                if self.busy.get() {
+                    ReturnCode::EBUSY
+                } else {
+                    self.load_program_flash(caller_id, instruction, arg2)
+                }
+            }
+            8 /* end checkpoint session */ => {
+                if self.checkpoint_user.get().map_or(false,
+                    |user| user.idx() == caller_id.idx()) {
+                    self.checkpoint_user.set(None);
+                    self.checkpoint_saved.set(false);
+                }
+                ReturnCode::SUCCESS
+            }
             _ => ReturnCode::ENOSUPPORT,
         }
     }
 
-    fn allow(&self, _: AppId,
+    fn allow(&self, app_id: AppId,
              minor_num: usize,
              slice: Option<AppSlice<Shared, u8>>
     ) -> ReturnCode {
         match minor_num {
             0 => {
                 // Data memory
-                self.app
-                    .map(|app_data| {
+                self.apps
+                    .enter(app_id, |app_data, _| {
                         app_data.data_buffer = slice;
                         ReturnCode::SUCCESS
                     })
@@ -137,8 +480,8 @@ impl<'a> Driver for DcryptoDriver<'a> {
             }
             1 => {
                 // Input Buffer
-                self.app
-                    .map(|app_data| {
+                self.apps
+                    .enter(app_id, |app_data, _| {
                         app_data.program = slice;
                         ReturnCode::SUCCESS
                     })
@@ -152,21 +495,43 @@ impl<'a> Driver for DcryptoDriver<'a> {
 impl<'a> DcryptoClient<'a> for DcryptoDriver<'a> {
     fn execution_complete(&self, error: ReturnCode, fault: ProgramFault) {
         self.busy.set(false);
-        self.app.map(move |app| {
-            app.callback.map(|mut callback| {
-                let mut data_slice = app.data_buffer.take().unwrap();
-                {
-                    let data = data_slice.as_mut();
-                    // In user space, len is in bytes. For the device,
-                    // however, len is in terms of words, with partial
-                    // words being truncated.  So divide by 4.
-                    let len = (data.len() / 4) as u32;
-                    self.device.read_data(data, 0, len);
-                    callback.schedule(usize::from(error), usize::from(fault), 0);
+        self.current_user.take().map(|app_id| {
+            let checkpoint_words = self.apps.enter(app_id, move |app, _| {
+                app.callback.map(|mut callback| {
+                    let mut data_slice = app.data_buffer.take().unwrap();
+                    {
+                        let data = data_slice.as_mut();
+                        // In user space, len is in bytes. For the device,
+                        // however, len is in terms of words, with partial
+                        // words being truncated.  So divide by 4.
+                        let len = (data.len() / 4) as u32;
+                        self.device.read_data(data, 0, len);
+                        callback.schedule(usize::from(error), usize::from(fault), 0);
+                    }
+                    app.data_buffer = Some(data_slice);
+                });
+                app.checkpoint_words
+            }).unwrap_or(0);
+            // Yield point of a checkpoint session: if another request
+            // is waiting, save the session's DMEM working set so the
+            // preempting program can clobber DMEM freely; the next
+            // segment command restores it. With nothing queued, DMEM
+            // is left in place and resume costs nothing.
+            if self.checkpoint_user.get().map_or(false,
+                |user| user.idx() == app_id.idx()) &&
+               !self.checkpoint_saved.get() {
+                self.queue.expire_stale(|id| self.fail_queued(id));
+                if !self.queue.is_empty() {
+                    self.checkpoint_buffer.map(|buffer| {
+                        let words = cmp::min(checkpoint_words,
+                                             buffer.len() / 4);
+                        self.device.read_data(buffer, 0, words as u32);
+                    });
+                    self.checkpoint_saved.set(true);
                 }
-                app.data_buffer = Some(data_slice);
-            });
+            }
         });
+        self.run_next_queued();
     }
 
     fn reset_complete(&self, _error: ReturnCode) {
@@ -13,8 +13,8 @@
 // limitations under the License.
 
 use core::cell::Cell;
-use h1::hil::digest::{DigestEngine, DigestError, DigestMode};
-use kernel::{AppId, AppSlice, Driver, Grant, ReturnCode, Shared};
+use h1::hil::digest::{DigestAsyncClient, DigestEngine, DigestError, DigestMode};
+use kernel::{AppId, AppSlice, Callback, Driver, Grant, ReturnCode, Shared};
 
 pub const DRIVER_NUM: usize = 0x40003;
 
@@ -24,6 +24,11 @@ pub struct App {
     input_buffer: Option<AppSlice<Shared, u8>>,
     /// Buffer where the digest will be written to when hashing is finished.
     output_buffer: Option<AppSlice<Shared, u8>>,
+    /// HMAC key cached from the last keyed initialize, so repeated MACs
+    /// with the same key can skip re-allowing the key buffer.
+    hmac_key: Option<[u8; 32]>,
+    /// Callback fired when an asynchronous finalize completes.
+    callback: Option<Callback>,
 }
 
 impl Default for App {
@@ -31,6 +36,8 @@ impl Default for App {
         App {
             input_buffer: None,
             output_buffer: None,
+            hmac_key: None,
+            callback: None,
         }
     }
 }
@@ -57,9 +64,36 @@ const COMMAND_UPDATE: usize           = 2;
 const COMMAND_FINALIZE: usize         = 3;
 const COMMAND_BUSY: usize             = 4;
 const COMMAND_CERTIFICATE_INIT: usize = 5;
+const COMMAND_HMAC_REINITIALIZE: usize = 6;
+const COMMAND_HMAC_ONESHOT: usize     = 7;
+const COMMAND_FINALIZE_ASYNC: usize   = 8;
+const COMMAND_CERT_CHAIN: usize       = 9;
+
+/// Longest certificate chain COMMAND_CERT_CHAIN accepts; bounded by the
+/// one-byte-per-step cert packing in the command argument.
+const CERT_CHAIN_MAX_STEPS: usize = 4;
 
 impl<'a, E: DigestEngine> Driver for DigestDriver<'a, E> {
-    fn command(&self, minor_num: usize, r2: usize, _r3: usize, caller_id: AppId) -> ReturnCode {
+    fn subscribe(&self,
+                 subscribe_num: usize,
+                 callback: Option<Callback>,
+                 app_id: AppId,
+    ) -> ReturnCode {
+        match subscribe_num {
+            // Asynchronous finalize completion
+            0 => {
+                self.apps
+                    .enter(app_id, |app_data, _| {
+                        app_data.callback = callback;
+                        ReturnCode::SUCCESS
+                    })
+                    .unwrap_or(ReturnCode::ENOMEM)
+            }
+            _ => ReturnCode::ENOSUPPORT,
+        }
+    }
+
+    fn command(&self, minor_num: usize, r2: usize, r3: usize, caller_id: AppId) -> ReturnCode {
         match minor_num {
             COMMAND_CHECK => ReturnCode::SUCCESS,
             // Initialize hash engine (arg: digest mode)
@@ -81,11 +115,25 @@ impl<'a, E: DigestEngine> Driver for DigestDriver<'a, E> {
                             DigestMode::Sha1 | DigestMode::Sha256 =>
                                 self.engine.initialize(digest_mode),
                             DigestMode::Sha256Hmac => {
-                                let input_buffer = match app_data.input_buffer {
-                                    Some(ref slice) => slice,
-                                    None => return ReturnCode::ENOMEM
+                                let result = {
+                                    let input_buffer = match app_data.input_buffer {
+                                        Some(ref slice) => slice,
+                                        None => return ReturnCode::ENOMEM
+                                    };
+                                    self.engine.initialize_hmac(&input_buffer.as_ref())
                                 };
-                                self.engine.initialize_hmac(&input_buffer.as_ref())
+                                if result.is_ok() {
+                                    // Cache the key so later MACs can reload
+                                    // it without re-allowing the key buffer.
+                                    if let Some(ref slice) = app_data.input_buffer {
+                                        if slice.len() >= 32 {
+                                            let mut key = [0u8; 32];
+                                            key.copy_from_slice(&slice.as_ref()[..32]);
+                                            app_data.hmac_key = Some(key);
+                                        }
+                                    }
+                                }
+                                result
                             }
                         };
                         match init_result {
@@ -186,6 +234,162 @@ impl<'a, E: DigestEngine> Driver for DigestDriver<'a, E> {
                     }).unwrap_or(ReturnCode::ENOMEM);
                 rval
             },
+            // Re-initialize a keyed hash with the key cached by the last
+            // HMAC initialize (arg: unused)
+            COMMAND_HMAC_REINITIALIZE => {
+                self.apps
+                    .enter(caller_id, |app_data, _| {
+                        if self.current_user.get().is_some() {
+                            return ReturnCode::EBUSY;
+                        }
+                        let key = match app_data.hmac_key {
+                            Some(ref key) => key,
+                            None => return ReturnCode::ERESERVE,
+                        };
+                        self.current_user.set(Some(caller_id));
+                        match self.engine.initialize_hmac(key) {
+                            Ok(_t) => ReturnCode::SUCCESS,
+                            Err(DigestError::EngineNotSupported) => ReturnCode::ENOSUPPORT,
+                            Err(DigestError::NotConfigured) => ReturnCode::FAIL,
+                            Err(DigestError::BufferTooSmall(_s)) => ReturnCode::ESIZE,
+                            Err(DigestError::Timeout) => ReturnCode::FAIL,
+                        }
+                    }).unwrap_or(ReturnCode::ENOMEM)
+            },
+            // One-shot keyed hash: the input buffer holds the key (32
+            // bytes) followed by the message (arg: message length). The
+            // engine is keyed, fed and finalized within this single
+            // command; HMAC-heavy callers like the DRBG pay one syscall
+            // per pass instead of one per phase.
+            COMMAND_HMAC_ONESHOT => {
+                self.apps
+                    .enter(caller_id, |app_data, _| {
+                        if self.current_user.get().is_some() {
+                            return ReturnCode::EBUSY;
+                        }
+                        let app_data: &mut App = app_data;
+                        let msg_len = r2;
+                        {
+                            let input_buffer = match app_data.input_buffer {
+                                Some(ref slice) => slice,
+                                None => return ReturnCode::ENOMEM,
+                            };
+                            if input_buffer.len() < 32 + msg_len {
+                                return ReturnCode::ESIZE;
+                            }
+                            let input = input_buffer.as_ref();
+                            let fed = self.engine.initialize_hmac(&input[..32])
+                                .and_then(|_| self.engine.update(&input[32..32 + msg_len]));
+                            match fed {
+                                Ok(_t) => {}
+                                Err(DigestError::EngineNotSupported) => return ReturnCode::ENOSUPPORT,
+                                Err(DigestError::NotConfigured) => return ReturnCode::FAIL,
+                                Err(DigestError::BufferTooSmall(_s)) => return ReturnCode::ESIZE,
+                                Err(DigestError::Timeout) => return ReturnCode::FAIL,
+                            }
+                        }
+                        let rval = match app_data.output_buffer {
+                            Some(ref mut slice) => self.engine.finalize(slice.as_mut()),
+                            None => self.engine.finalize_hidden()
+                        };
+                        match rval {
+                            Ok(_t) => ReturnCode::SUCCESS,
+                            Err(DigestError::EngineNotSupported) => ReturnCode::ENOSUPPORT,
+                            Err(DigestError::NotConfigured) => ReturnCode::FAIL,
+                            Err(DigestError::BufferTooSmall(_s)) => ReturnCode::ESIZE,
+                            Err(DigestError::Timeout) => ReturnCode::FAIL,
+                        }
+                    })
+                    .unwrap_or(ReturnCode::ENOMEM)
+            },
+            // Finalize the hash without waiting for the engine: the
+            // digest is read into the output buffer and the subscribed
+            // callback fired from the engine's done interrupt, so long
+            // hashes neither spin the CPU in the kernel nor require the
+            // app to poll COMMAND_BUSY.
+            COMMAND_FINALIZE_ASYNC => {
+                self.apps
+                    .enter(caller_id, |app_data, _| {
+                        match self.current_user.get() {
+                            Some(cur) if cur == caller_id => {}
+                            _ => {
+                                return ReturnCode::EBUSY
+                            }
+                        }
+                        if app_data.output_buffer.is_none() {
+                            return ReturnCode::ENOMEM;
+                        }
+                        match self.engine.finalize_async() {
+                            Ok(()) => ReturnCode::SUCCESS,
+                            Err(DigestError::NotConfigured) => ReturnCode::ERESERVE,
+                            Err(_) => ReturnCode::FAIL,
+                        }
+                    })
+                    .unwrap_or(ReturnCode::ENOMEM)
+            },
+            // Run a chain of certificate digest steps in one command:
+            // the input buffer holds one 32-byte block per step, r2
+            // packs the certificate numbers a byte per step (step 0 in
+            // the low byte), r3 is the step count (1-4). Intermediates
+            // pass engine to engine without ever being read out; only
+            // the last step's digest lands in the output buffer (or
+            // stays hidden if none is allowed). Key-ladder derivations
+            // are exactly such chains, and this replaces their per-step
+            // syscall round-trips with one.
+            COMMAND_CERT_CHAIN => {
+                self.apps
+                    .enter(caller_id, |app_data, _| {
+                        if self.current_user.get().is_some() {
+                            return ReturnCode::EBUSY;
+                        }
+                        let app_data: &mut App = app_data;
+                        let steps = r3;
+                        if steps == 0 || steps > CERT_CHAIN_MAX_STEPS {
+                            return ReturnCode::EINVAL;
+                        }
+                        {
+                            let input_buffer = match app_data.input_buffer {
+                                Some(ref slice) => slice,
+                                None => return ReturnCode::ENOMEM,
+                            };
+                            if input_buffer.len() < 32 * steps {
+                                return ReturnCode::ESIZE;
+                            }
+                            let input = input_buffer.as_ref();
+                            for step in 0..steps {
+                                let cert = ((r2 >> (8 * step)) & 0xff) as u32;
+                                let block = &input[32 * step..32 * (step + 1)];
+                                let fed = self.engine.initialize_certificate(cert)
+                                    .and_then(|_| self.engine.update(block));
+                                match fed {
+                                    Ok(_t) => {}
+                                    Err(DigestError::EngineNotSupported) => return ReturnCode::ENOSUPPORT,
+                                    Err(DigestError::NotConfigured) => return ReturnCode::FAIL,
+                                    Err(DigestError::BufferTooSmall(_s)) => return ReturnCode::ESIZE,
+                                    Err(DigestError::Timeout) => return ReturnCode::FAIL,
+                                }
+                                if step < steps - 1 {
+                                    match self.engine.finalize_hidden() {
+                                        Ok(_t) => {}
+                                        Err(_e) => return ReturnCode::FAIL,
+                                    }
+                                }
+                            }
+                        }
+                        let rval = match app_data.output_buffer {
+                            Some(ref mut slice) => self.engine.finalize(slice.as_mut()),
+                            None => self.engine.finalize_hidden()
+                        };
+                        match rval {
+                            Ok(_t) => ReturnCode::SUCCESS,
+                            Err(DigestError::EngineNotSupported) => ReturnCode::ENOSUPPORT,
+                            Err(DigestError::NotConfigured) => ReturnCode::FAIL,
+                            Err(DigestError::BufferTooSmall(_s)) => ReturnCode::ESIZE,
+                            Err(DigestError::Timeout) => ReturnCode::FAIL,
+                        }
+                    })
+                    .unwrap_or(ReturnCode::ENOMEM)
+            },
             _ => ReturnCode::ENOSUPPORT
         }
     }
@@ -218,3 +422,27 @@ impl<'a, E: DigestEngine> Driver for DigestDriver<'a, E> {
             }
     }
 }
+
+impl<'a, E: DigestEngine> DigestAsyncClient for DigestDriver<'a, E> {
+    fn finalize_done(&self) {
+        let user = match self.current_user.get() {
+            Some(user) => user,
+            None => return,
+        };
+        self.current_user.set(None);
+        let _ = self.apps.enter(user, |app_data, _| {
+            let rval = match app_data.output_buffer {
+                Some(ref mut slice) => self.engine.finalize_result(slice.as_mut()),
+                None => Ok(0),
+            };
+            app_data.callback.map(|mut callback| {
+                match rval {
+                    Ok(len) => callback.schedule(
+                        usize::from(ReturnCode::SUCCESS), len, 0),
+                    Err(_) => callback.schedule(
+                        usize::from(ReturnCode::FAIL), 0, 0),
+                }
+            });
+        });
+    }
+}
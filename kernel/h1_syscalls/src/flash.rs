@@ -138,7 +138,8 @@ impl<'a> FlashSyscalls<'a> {
 
 impl<'a> Client<'a> for FlashSyscalls<'a> {
     fn erase_done(&self, return_code: ReturnCode) {
-        self.current_user.get().map(|current_user| {
+        // Completion releases the driver for the next requester.
+        self.current_user.take().map(|current_user| {
             let _ = self.apps.enter(current_user, move |app_data, _| {
                 app_data.operation_done_callback.map(
                     |mut cb| cb.schedule(usize::from(return_code), 0, 0));
@@ -148,7 +149,7 @@ impl<'a> Client<'a> for FlashSyscalls<'a> {
 
     fn write_done(&self, write_buffer: &'a mut [u32], return_code: ReturnCode) {
         self.write_buffer.set(Some(write_buffer));
-        self.current_user.get().map(|current_user| {
+        self.current_user.take().map(|current_user| {
             let _ = self.apps.enter(current_user, move |app_data, _| {
                 app_data.operation_done_callback.map(
                     |mut cb| cb.schedule(usize::from(return_code), 0, 0));
@@ -177,19 +178,36 @@ impl<'a> Driver for FlashSyscalls<'a> {
     }
 
     fn command(&self, command_num: usize, arg1: usize, arg2: usize, caller_id: AppId) -> ReturnCode {
-        if self.current_user.get() == None {
-            self.current_user.set(Some(caller_id));
-        }
         match command_num {
             0 /* Check if present */ => ReturnCode::SUCCESS,
             1 /* Erase page
                  arg1: page # to erase */ => {
-                self.erase(caller_id, arg1)
+                // The device runs one erase/write at a time; current_user
+                // records whose operation is in flight so erase_done/
+                // write_done route the completion back to it. More than
+                // one app uses this driver, so a second request while an
+                // operation is outstanding is EBUSY, not a silent
+                // callback steal.
+                if self.current_user.get().is_some() {
+                    return ReturnCode::EBUSY;
+                }
+                let return_code = self.erase(caller_id, arg1);
+                if return_code == ReturnCode::SUCCESS {
+                    self.current_user.set(Some(caller_id));
+                }
+                return_code
             },
             2 /* Write data
                  arg1: target offset in flash
                  arg2: number of bytes to write */ => {
-                self.write(caller_id, arg1, arg2)
+                if self.current_user.get().is_some() {
+                    return ReturnCode::EBUSY;
+                }
+                let return_code = self.write(caller_id, arg1, arg2);
+                if return_code == ReturnCode::SUCCESS {
+                    self.current_user.set(Some(caller_id));
+                }
+                return_code
             },
             3 /* Read data
                  arg1: offset in flash
@@ -18,6 +18,7 @@ extern crate h1;
 #[macro_use(static_init, debug)]
 extern crate kernel;
 
+pub mod arbiter;
 pub mod digest;
 pub mod aes;
 pub mod dcrypto;
@@ -30,6 +31,8 @@ pub mod personality;
 pub mod reset;
 pub mod spi_host;
 pub mod spi_device;
+pub mod timestamp;
+pub mod tracelog;
 
 pub unsafe fn init() {
 }
@@ -20,12 +20,27 @@ use kernel::{AppId,Callback,ReturnCode};
 
 pub const DRIVER_NUM: usize = 0x80040000;
 
+// Upper bound on the coalescing stride. Keeps strikes * stride well
+// inside usize on 32-bit targets and bounds how far the persisted value
+// can run ahead of the true count.
+const MAX_STRIDE: usize = 256;
+
 #[derive(Default)]
 pub struct AppData {
     wants_increment: bool,
     callback: Option<kernel::Callback>,
 }
 
+// Outcome of trying to start one logical increment.
+enum StartResult {
+    // A flash strike is in flight; completion arrives via increment_done.
+    Started,
+    // The increment was absorbed by the persisted high-water mark and is
+    // already complete; no flash operation was needed.
+    Done,
+    Error,
+}
+
 pub struct NvCounterSyscall<'c, C: NvCounter<'c>> {
     op_ongoing: core::cell::Cell<bool>,
     current_app: core::cell::Cell<usize>,  // AppId::id, if an op is ongoing
@@ -33,6 +48,36 @@ pub struct NvCounterSyscall<'c, C: NvCounter<'c>> {
     init_failed: core::cell::Cell<bool>,
     nvcounter: &'c C,
     value: core::cell::Cell<usize>,
+
+    // Write coalescing: each flash strike stands for `stride` logical
+    // increments, so the persisted value (strikes * stride) is a
+    // high-water mark that is always >= the true count. Increments that
+    // stay under the mark complete without touching flash. A stride of 1
+    // is the legacy write-per-increment behavior. The stride must be
+    // configured consistently across boots for the recovered value to be
+    // interpreted the same way.
+    stride: core::cell::Cell<usize>,
+    // Number of strikes recorded in flash, i.e. the flash counter value.
+    flash_strikes: core::cell::Cell<usize>,
+    // Strike count to commit once the in-flight flash write succeeds.
+    pending_strikes: core::cell::Cell<usize>,
+    // Whether value/flash_strikes reflect the flash contents. Cleared on
+    // failures and stride changes to force a resynchronization.
+    synced: core::cell::Cell<bool>,
+
+    // Background initialization: while the format erases run, increment
+    // requests are acknowledged immediately instead of failing or waiting
+    // behind two page erases. This is sound because initialization itself
+    // resets the persisted count -- an increment acknowledged during the
+    // format is covered by the same recovery story as the format. The
+    // acknowledged increments are replayed as catch-up strikes once the
+    // pages are erased, restoring the high-water-mark invariant.
+    init_ongoing: core::cell::Cell<bool>,
+    // Increments acknowledged while the format was running.
+    optimistic: core::cell::Cell<usize>,
+    // Set while catch-up strikes are pushing the persisted mark back
+    // above the RAM value. No app callback is tied to these strikes.
+    catching_up: core::cell::Cell<bool>,
 }
 
 impl<'c, C: NvCounter<'c>> NvCounterSyscall<'c, C> {
@@ -45,7 +90,14 @@ impl<'c, C: NvCounter<'c>> NvCounterSyscall<'c, C> {
             nvcounter,
             // value will be corrected when the first operation completes, and
             // is not used until afterwards.
-            value: Default::default()
+            value: Default::default(),
+            stride: core::cell::Cell::new(1),
+            flash_strikes: Default::default(),
+            pending_strikes: Default::default(),
+            synced: Default::default(),
+            init_ongoing: Default::default(),
+            optimistic: Default::default(),
+            catching_up: Default::default(),
         }
     }
 
@@ -60,12 +112,19 @@ impl<'c, C: NvCounter<'c>> NvCounterSyscall<'c, C> {
         if self.nvcounter.initialize() != ReturnCode::SUCCESS {
             debug!("NvCounterSyscall initialization failed.");
             self.handle_failed_init();
+        } else {
+            // The format runs in the background off the flash completion
+            // callbacks; increments arriving meanwhile are acknowledged
+            // optimistically (see read_and_increment).
+            self.init_ongoing.set(true);
+            self.optimistic.set(0);
         }
     }
 
     /// Sends failures to all apps with outstanding increment requests and marks
     /// init_failed as true.
     fn handle_failed_init(&self) {
+        self.init_ongoing.set(false);
         self.init_failed.set(true);
         self.grant.each(|app_data| {
             if !app_data.wants_increment { return; }
@@ -76,12 +135,65 @@ impl<'c, C: NvCounter<'c>> NvCounterSyscall<'c, C> {
         });
     }
 
+    // Performs one logical increment: absorbed by the persisted
+    // high-water mark when possible, otherwise a flash strike is started
+    // that extends the mark by another stride's worth of increments.
+    fn start_increment(&self) -> StartResult {
+        use ReturnCode::SuccessWithValue;
+        let stride = self.stride.get();
+        if self.synced.get() &&
+           self.value.get() + 1 <= self.flash_strikes.get().saturating_mul(stride) {
+            self.value.set(self.value.get() + 1);
+            return StartResult::Done;
+        }
+        if let SuccessWithValue { value } = self.nvcounter.read_and_increment() {
+            if !self.synced.get() {
+                // Resynchronize from flash. The true count is at most
+                // strikes * stride; taking the larger of that and the RAM
+                // mirror keeps the mark ahead of the truth in both the
+                // post-boot and post-failure cases.
+                let recovered = value.saturating_mul(stride);
+                if recovered > self.value.get() {
+                    self.value.set(recovered);
+                }
+            }
+            self.pending_strikes.set(value + 1);
+            self.op_ongoing.set(true);
+            StartResult::Started
+        } else {
+            StartResult::Error
+        }
+    }
+
+    // Replays optimistically-acknowledged increments as flash strikes
+    // until the persisted high-water mark covers the RAM value again.
+    // Leaves op_ongoing set while a catch-up strike is in flight, so app
+    // requests queue behind it.
+    fn catch_up(&self) {
+        if self.value.get() <=
+           self.flash_strikes.get().saturating_mul(self.stride.get()) {
+            self.catching_up.set(false);
+            return;
+        }
+        if let ReturnCode::SuccessWithValue { value } =
+            self.nvcounter.read_and_increment()
+        {
+            self.pending_strikes.set(value + 1);
+            self.catching_up.set(true);
+            self.op_ongoing.set(true);
+        } else {
+            // Leave the mirror unsynchronized; the next app increment
+            // will strike flash and repair the mark.
+            self.catching_up.set(false);
+            self.synced.set(false);
+        }
+    }
+
     // Scans through the apps and starts the next increment, if any app wants an
     // increment. This will also call the callback for app callback_id with the
     // given callback code -- specify an id if usize::max_value() if no callback
     // is necessary.
     fn do_next_op(&self, callback_id: Option<usize>, callback_code: usize) {
-        use ReturnCode::SuccessWithValue;
         // TODO: Fairness? This seems to be the common approach but it gives
         // priority to lower-numbered apps. Probably not an issue for this
         // particular driver because read_and_increment() shouldn't see much
@@ -91,14 +203,20 @@ impl<'c, C: NvCounter<'c>> NvCounterSyscall<'c, C> {
                app_data.wants_increment
             {
                 app_data.wants_increment = false;
-                if let SuccessWithValue { value } =
-                    self.nvcounter.read_and_increment()
-                {
-                    self.value.set(value);
-                    self.op_ongoing.set(true);
-                    self.current_app.set(app_data.appid().id());
-                } else if let Some(mut callback) = app_data.callback {
-                    callback.schedule(0, 0, 0);
+                match self.start_increment() {
+                    StartResult::Started => {
+                        self.current_app.set(app_data.appid().id());
+                    }
+                    StartResult::Done => {
+                        if let Some(mut callback) = app_data.callback {
+                            callback.schedule(2, self.value.get(), 0);
+                        }
+                    }
+                    StartResult::Error => {
+                        if let Some(mut callback) = app_data.callback {
+                            callback.schedule(0, 0, 0);
+                        }
+                    }
                 }
             }
 
@@ -123,21 +241,42 @@ impl<'c, C: NvCounter<'c>> NvCounterSyscall<'c, C> {
             debug!("Failed to start system call for NV Counter increment.");
             return result;
         }
+        // Initialization is formatting the pages in the background.
+        // Acknowledge now; initialize_done replays these as catch-up
+        // strikes. The post-format value the counter will report is the
+        // number of increments acknowledged so far.
+        if self.init_ongoing.get() {
+            let value = self.optimistic.get() + 1;
+            self.optimistic.set(value);
+            return self.grant.enter(app, |app_data, _| {
+                if let Some(mut callback) = app_data.callback {
+                    callback.schedule(2, value, 0);
+                }
+                ReturnCode::SUCCESS
+            }).unwrap_or(ReturnCode::ENOMEM);
+        }
         // Currently, idle, so just increment
         if !self.op_ongoing.get() {
-            let increment_result = self.nvcounter.read_and_increment();
-            match increment_result {
-                ReturnCode::SuccessWithValue{value} => {
-                    self.value.set(value);
-                },
-                _ => {
-                    debug!("Failed to read and increment NV Counter: {:?}", increment_result);
-                    return ReturnCode::FAIL;
+            match self.start_increment() {
+                StartResult::Started => {
+                    self.current_app.set(app.id());
+                    ReturnCode::SUCCESS
+                }
+                StartResult::Done => {
+                    // Absorbed by the high-water mark; deliver the
+                    // completion callback right away.
+                    self.grant.enter(app, |app_data, _| {
+                        if let Some(mut callback) = app_data.callback {
+                            callback.schedule(2, self.value.get(), 0);
+                        }
+                        ReturnCode::SUCCESS
+                    }).unwrap_or(ReturnCode::ENOMEM)
+                }
+                StartResult::Error => {
+                    debug!("Failed to read and increment NV Counter.");
+                    ReturnCode::FAIL
                 }
             }
-            self.op_ongoing.set(true);
-            self.current_app.set(app.id());
-            ReturnCode::SUCCESS
         } else { // Busy, so mark wants_increment, perform op later
             self.grant.enter(app, |app_data, _| {
                 app_data.wants_increment = true;
@@ -155,10 +294,41 @@ impl<'c, C: NvCounter<'c>> NvCounterSyscall<'c, C> {
 }
 
 impl<'c, C: NvCounter<'c>> kernel::Driver for NvCounterSyscall<'c, C> {
-    fn command(&self, minor_num: usize, _: usize, _: usize, app: AppId) -> ReturnCode {
+    fn command(&self, minor_num: usize, arg1: usize, _: usize, app: AppId) -> ReturnCode {
         match minor_num {
             0 => ReturnCode::SUCCESS,
             1 => self.read_and_increment(app),
+            2 => {
+                // Configure the coalescing stride. Takes effect on the
+                // next increment; forces a resynchronization so the
+                // high-water mark is reinterpreted under the new stride.
+                if arg1 < 1 || arg1 > MAX_STRIDE {
+                    return ReturnCode::EINVAL;
+                }
+                self.stride.set(arg1);
+                self.synced.set(false);
+                ReturnCode::SUCCESS
+            }
+            3 => {
+                // Read the current value without incrementing. Served
+                // from the RAM mirror, so it costs no flash cycles and
+                // does not wait behind write completions.
+                if self.synced.get() {
+                    ReturnCode::SuccessWithValue { value: self.value.get() }
+                } else {
+                    // Mirror not synchronized yet (before the first
+                    // increment, or after a failed strike); report the
+                    // persisted high-water mark, which is >= the true
+                    // count.
+                    match self.nvcounter.read() {
+                        ReturnCode::SuccessWithValue { value } =>
+                            ReturnCode::SuccessWithValue {
+                                value: value.saturating_mul(self.stride.get())
+                            },
+                        other => other,
+                    }
+                }
+            }
             _ => ReturnCode::ENOSUPPORT,
         }
     }
@@ -174,21 +344,54 @@ impl<'c, C: NvCounter<'c>> kernel::Driver for NvCounterSyscall<'c, C> {
 impl<'c, C: NvCounter<'c>> h1::nvcounter::Client for NvCounterSyscall<'c, C> {
     fn initialize_done(&self, status: ReturnCode) {
         if status == ReturnCode::SUCCESS {
+            self.init_ongoing.set(false);
             self.init_failed.set(false);
-            self.value.set(0);
-            self.do_next_op(None, 0);
+            // Increments acknowledged during the format become the
+            // starting value; catch-up strikes push the persisted mark
+            // back above it.
+            self.value.set(self.optimistic.get());
+            self.optimistic.set(0);
+            self.flash_strikes.set(0);
+            self.synced.set(true);
+            self.catch_up();
+            if !self.op_ongoing.get() {
+                self.do_next_op(None, 0);
+            }
         } else {
             self.handle_failed_init();
         }
     }
 
     fn increment_done(&self, status: ReturnCode) {
+        // Catch-up strikes carry no app callback and do not advance the
+        // RAM value; they only extend the persisted mark.
+        if self.catching_up.get() {
+            self.op_ongoing.set(false);
+            if status == ReturnCode::SUCCESS {
+                self.flash_strikes.set(self.pending_strikes.get());
+                self.catch_up();
+            } else {
+                self.catching_up.set(false);
+                self.synced.set(false);
+            }
+            if !self.op_ongoing.get() {
+                self.do_next_op(None, 0);
+            }
+            return;
+        }
+
         let callback_app = self.current_app.get();
         self.op_ongoing.set(false);
         let mut callback_code = 1;
         if status == ReturnCode::SUCCESS {
+            self.flash_strikes.set(self.pending_strikes.get());
+            self.synced.set(true);
             self.value.set(self.value.get() + 1);
             callback_code = 2;
+        } else {
+            // The strike may or may not have landed; reread the flash
+            // value before the next strike.
+            self.synced.set(false);
         }
         self.do_next_op(Some(callback_app), callback_code);
     }
@@ -21,9 +21,22 @@
 //!   1. read personality data into a user buffer.
 //!   2. durably write personality data from a user buffer, completion signaled
 //!      by a callback.
+//!   3. get the memory-mapped flash address of the personality data, for
+//!      zero-copy read-only access on boards whose MPU configuration
+//!      permits userspace flash reads.
+//!   4. durably update part of the personality data: the allowed buffer
+//!      is merged into the stored data at the byte offset given in the
+//!      first argument, completion signaled by a callback. The kernel
+//!      performs a read-modify-write that only erases/programs the
+//!      affected flash words.
+//!   5. query the certificate validity latch: returns 1 if the kernel
+//!      verified at boot that the stored certificate hashes to the
+//!      stored certificate hash (and no write has happened since), 0
+//!      otherwise. A 1 lets userspace skip its own pass over the 2KB
+//!      certificate; on 0 it must verify for itself.
 //!
 //! The driver implements 1 allow:
-//!   0. userspace buffer used for read and write (commands 1 and 2).
+//!   0. userspace buffer used for read and write (commands 1, 2 and 4).
 //!
 //! The driver implements 1 subscribe:
 //!   0. callback for when a durable write completes.
@@ -40,6 +53,9 @@ pub const DRIVER_NUM: usize = 0x5000b;
 const COMMAND_CHECK: usize             = 0;
 const COMMAND_READ: usize              = 1;
 const COMMAND_WRITE: usize             = 2;
+const COMMAND_GET_ADDRESS: usize       = 3;
+const COMMAND_UPDATE: usize            = 4;
+const COMMAND_CERT_VALID: usize        = 5;
 const ALLOW_BUFFER: usize              = 0;
 const SUBSCRIBE_WRITE_DONE: usize      = 0;
 
@@ -89,7 +105,7 @@ impl<'a> Driver for PersonalitySyscall<'a> {
         }
     }
 
-    fn command(&self, command_num: usize, _: usize, _: usize, app_id: AppId) -> ReturnCode {
+    fn command(&self, command_num: usize, arg1: usize, _: usize, app_id: AppId) -> ReturnCode {
         match command_num {
             COMMAND_CHECK => ReturnCode::SUCCESS,
             COMMAND_READ  => {
@@ -114,13 +130,64 @@ impl<'a> Driver for PersonalitySyscall<'a> {
                         if app_data.data.is_none() {return ReturnCode::ENOMEM;}
 
                         let mut data_slice = app_data.data.take().unwrap();
-                        self.device.set_u8(data_slice.as_mut());
-                        self.current_user.replace(app_id);
+                        let rval = self.device.set_u8(data_slice.as_mut());
                         app_data.data = Some(data_slice);
-                        ReturnCode::SUCCESS
+                        // Claim the driver only once the device accepts
+                        // the write, so a rejected request never
+                        // disturbs an in-flight operation's owner.
+                        if rval == ReturnCode::SUCCESS {
+                            self.busy.set(true);
+                            self.current_user.replace(app_id);
+                        }
+                        rval
+                    }).unwrap_or(ReturnCode::ENOMEM)
+                }
+            },
+            COMMAND_UPDATE => {
+                if self.busy.get() {
+                    ReturnCode::EBUSY
+                } else {
+                    self.apps.enter(app_id, |app_data, _| {
+                        if app_data.data.is_none() {return ReturnCode::ENOMEM;}
+
+                        let mut data_slice = app_data.data.take().unwrap();
+                        let rval = self.device.set_partial_u8(data_slice.as_mut(), arg1);
+                        app_data.data = Some(data_slice);
+                        match rval {
+                            ReturnCode::SUCCESS => {
+                                // Claim the driver only once the device
+                                // accepts the update (see COMMAND_WRITE).
+                                self.busy.set(true);
+                                self.current_user.replace(app_id);
+                                ReturnCode::SUCCESS
+                            },
+                            ReturnCode::SuccessWithValue{..} => {
+                                // Stored data already matched the update;
+                                // complete without a flash operation.
+                                app_data.callback.map(|mut cb| {
+                                    cb.schedule(From::from(ReturnCode::SUCCESS), 0, 0)
+                                });
+                                ReturnCode::SUCCESS
+                            },
+                            other => other,
+                        }
                     }).unwrap_or(ReturnCode::ENOMEM)
                 }
             },
+            COMMAND_CERT_VALID => {
+                // Reads the latch only: re-verifying here would claim
+                // the digest engine out from under a userspace session.
+                ReturnCode::SuccessWithValue {
+                    value: if self.device.certificate_valid() == Some(true)
+                           { 1 } else { 0 }
+                }
+            },
+            COMMAND_GET_ADDRESS => {
+                // The personality is flash-resident and only changes via
+                // command 2, so handing out its address lets userspace
+                // read it in place without the 2KB copy.
+                ReturnCode::SuccessWithValue { value: self.device.address() }
+            },
             _ => ReturnCode::ENOSUPPORT
         }
     }
@@ -147,18 +214,28 @@ impl<'a> Driver for PersonalitySyscall<'a> {
 impl<'a> Client<'a> for PersonalitySyscall<'a> {
 
     fn set_done(&self, rval: ReturnCode) {
-        self.current_user.map(|current_user| {
-            let _ = self.apps.enter(*current_user, |app_data, _| {
-                self.current_user.clear();
+        // Release the driver even if the owner is gone.
+        self.busy.set(false);
+        self.current_user.take().map(|current_user| {
+            let _ = self.apps.enter(current_user, |app_data, _| {
                 app_data.callback.map(|mut cb| cb.schedule(From::from(rval), 0, 0));
             });
         });
     }
 
     fn set_u8_done(&self, rval: ReturnCode) {
-        self.current_user.map(|current_user| {
-            let _ = self.apps.enter(*current_user, |app_data, _| {
-                self.current_user.clear();
+        self.busy.set(false);
+        self.current_user.take().map(|current_user| {
+            let _ = self.apps.enter(current_user, |app_data, _| {
+                app_data.callback.map(|mut cb| cb.schedule(From::from(rval), 0, 0));
+            });
+        });
+    }
+
+    fn set_partial_done(&self, rval: ReturnCode) {
+        self.busy.set(false);
+        self.current_user.take().map(|current_user| {
+            let _ = self.apps.enter(current_user, |app_data, _| {
                 app_data.callback.map(|mut cb| cb.schedule(From::from(rval), 0, 0));
             });
         });
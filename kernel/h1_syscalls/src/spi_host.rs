@@ -37,6 +37,13 @@ impl<'a> SpiHostSyscall<'a> {
             ReturnCode::SUCCESS
         }).unwrap_or(ReturnCode::ENOMEM)
     }
+
+    fn set_sck_divider(&self, caller_id: AppId, divider: u32) -> ReturnCode {
+        self.apps.enter(caller_id, |_app_data, _| {
+            self.device.set_sck_divider(divider);
+            ReturnCode::SUCCESS
+        }).unwrap_or(ReturnCode::ENOMEM)
+    }
 }
 
 impl<'a> Driver for SpiHostSyscall<'a> {
@@ -66,6 +73,10 @@ impl<'a> Driver for SpiHostSyscall<'a> {
                  arg1: 0: disable, != 0: enable) */ => {
                 self.wait_busy_clear_in_transactions(caller_id, arg1 != 0)
             },
+            3 /* Set the SCK clock divider: SCK = PCLK / (arg1 + 1).
+                 arg1: divider minus one (0-4095) */ => {
+                self.set_sck_divider(caller_id, arg1 as u32)
+            },
             _ => ReturnCode::ENOSUPPORT
         }
     }
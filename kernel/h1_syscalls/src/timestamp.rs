@@ -0,0 +1,104 @@
+// Copyright 2021 Google LLC
+//
+// Licensed under the Apache License, Version 2.0 (the "License");
+// you may not use this file except in compliance with the License.
+// You may obtain a copy of the License at
+//
+//     https://www.apache.org/licenses/LICENSE-2.0
+//
+// Unless required by applicable law or agreed to in writing, software
+// distributed under the License is distributed on an "AS IS" BASIS,
+// WITHOUT WARRANTIES OR CONDITIONS OF ANY KIND, either express or implied.
+// See the License for the specific language governing permissions and
+// limitations under the License.
+
+//! Read-only high-resolution timestamp syscall.
+//!
+//! The alarm driver runs off the low-speed timer, which is too coarse
+//! for profiling. This driver exposes a dedicated Timeus counter ticking
+//! once per microsecond: a single `command()` with no allow or
+//! subscribe, returning the current counter value, so a userspace
+//! timestamp costs one syscall (a few microseconds end to end). The
+//! raw counter (command 1) wraps every ~71 minutes; callers compute
+//! deltas in `u32` arithmetic. Commands 3/4 expose the counter widened
+//! to 64 bits in software, for timestamps that must stay monotonic
+//! across wraps. Commands 5-7 read the PMU's power-state telemetry
+//! (sleep time, sleep count, crypto clock-boost time) so benchmarks
+//! can report energy proxies alongside latency.
+
+use core::cell::Cell;
+use h1::timeus::Timeus;
+use kernel::{AppId, Driver, ReturnCode};
+
+pub const DRIVER_NUM: usize = 0x40080;
+
+pub struct TimestampSyscall<'a> {
+    timer: &'a Timeus,
+    /// High word of the 64-bit value sampled by the last command 3, so
+    /// a command 3 + command 4 pair reads one consistent timestamp.
+    latched_high: Cell<u32>,
+}
+
+impl<'a> TimestampSyscall<'a> {
+    pub fn new(timer: &'a Timeus) -> TimestampSyscall<'a> {
+        TimestampSyscall {
+            timer: timer,
+            latched_high: Cell::new(0),
+        }
+    }
+}
+
+impl<'a> Driver for TimestampSyscall<'a> {
+    fn command(&self, command_num: usize, _arg1: usize, _arg2: usize, _caller_id: AppId)
+        -> ReturnCode {
+        match command_num {
+            0 /* Check if present */ => ReturnCode::SUCCESS,
+            1 /* Current time in microseconds. The raw counter value is
+                 returned as the "value"; near the wrap point it can
+                 collide with error encodings, which profiling callers
+                 tolerate. */ => {
+                ReturnCode::SuccessWithValue { value: self.timer.now() as usize }
+            },
+            2 /* Dump the kernel syscall/interrupt profile over the debug
+                 console and reset it. A no-op unless the kernel was
+                 built with the h1 crate's syscall_profile feature. */ => {
+                h1::syscall_profile::dump();
+                ReturnCode::SUCCESS
+            },
+            3 /* Low word of the 64-bit monotonic time in microseconds.
+                 Samples the widened counter and latches its high word
+                 for command 4. */ => {
+                let now = self.timer.now64();
+                self.latched_high.set((now >> 32) as u32);
+                ReturnCode::SuccessWithValue { value: now as u32 as usize }
+            },
+            4 /* High word latched by the most recent command 3. */ => {
+                ReturnCode::SuccessWithValue {
+                    value: self.latched_high.get() as usize
+                }
+            },
+            5 /* Cumulative time the chip has spent asleep (in wfi)
+                 since boot, microseconds, low 32 bits. Benchmarks diff
+                 two samples around the measured section, so the wrap
+                 (~71 minutes of sleep) is handled by u32 arithmetic. */ => {
+                ReturnCode::SuccessWithValue {
+                    value: h1::pmu::sleep_time_us() as u32 as usize
+                }
+            },
+            6 /* Number of sleep periods since boot. Diffed together
+                 with command 5 this separates long quiet sleeps from
+                 wakeup churn. */ => {
+                ReturnCode::SuccessWithValue {
+                    value: h1::pmu::sleep_count() as usize
+                }
+            },
+            7 /* Cumulative time the crypto engine clocks were boosted
+                 by in-flight operations, microseconds, low 32 bits. */ => {
+                ReturnCode::SuccessWithValue {
+                    value: h1::pmu::crypto_time_us() as u32 as usize
+                }
+            },
+            _ => ReturnCode::ENOSUPPORT
+        }
+    }
+}
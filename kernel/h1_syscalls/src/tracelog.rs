@@ -0,0 +1,109 @@
+// Copyright 2021 Google LLC
+//
+// Licensed under the Apache License, Version 2.0 (the "License");
+// you may not use this file except in compliance with the License.
+// You may obtain a copy of the License at
+//
+//     https://www.apache.org/licenses/LICENSE-2.0
+//
+// Unless required by applicable law or agreed to in writing, software
+// distributed under the License is distributed on an "AS IS" BASIS,
+// WITHOUT WARRANTIES OR CONDITIONS OF ANY KIND, either express or implied.
+// See the License for the specific language governing permissions and
+// limitations under the License.
+
+//! Userspace access to the binary trace stream (h1::trace_stream).
+//!
+//! Apps use two roles. Writers append a record per `command(1)` — no
+//! allow, no subscribe, no formatting — so instrumenting a hot path
+//! costs one syscall. The drainer (the low_level_debug app) shares a
+//! buffer and uses `command(3)` to pull raw records out of the kernel
+//! ring for streaming over the UART.
+//!
+//! Without the `trace_stream` feature in the h1 crate the check
+//! command fails and every other command is a cheap no-op.
+
+use h1::trace_stream;
+use kernel::{AppId, Callback, Driver, Grant, ReturnCode, Shared, AppSlice};
+
+pub const DRIVER_NUM: usize = 0x40090;
+
+#[derive(Default)]
+pub struct AppData {
+    drain_buffer: Option<AppSlice<Shared, u8>>,
+}
+
+pub struct TraceLogSyscall {
+    apps: Grant<AppData>,
+}
+
+impl TraceLogSyscall {
+    pub fn new(container: Grant<AppData>) -> TraceLogSyscall {
+        TraceLogSyscall { apps: container }
+    }
+}
+
+impl Driver for TraceLogSyscall {
+    fn subscribe(&self,
+                 _subscribe_num: usize,
+                 _callback: Option<Callback>,
+                 _app_id: AppId,
+    ) -> ReturnCode {
+        ReturnCode::ENOSUPPORT
+    }
+
+    fn command(&self, command_num: usize, arg1: usize, arg2: usize, caller_id: AppId)
+        -> ReturnCode {
+        match command_num {
+            0 /* Check if present */ => {
+                if trace_stream::enabled() {
+                    ReturnCode::SUCCESS
+                } else {
+                    ReturnCode::ENOSUPPORT
+                }
+            },
+            1 /* Append a record: arg1 = event id, arg2 = argument. The
+                 record is stamped with the caller's app index so the
+                 host can attribute it. */ => {
+                trace_stream::emit_app(caller_id.idx() as u8,
+                                       arg1 as u32, arg2 as u32);
+                ReturnCode::SUCCESS
+            },
+            2 /* Records waiting to be drained. */ => {
+                ReturnCode::SuccessWithValue { value: trace_stream::available() }
+            },
+            3 /* Drain whole records into the shared buffer; returns the
+                 number of bytes written. */ => {
+                self.apps.enter(caller_id, |app_data, _| {
+                    if let Some(ref mut buffer) = app_data.drain_buffer {
+                        let written = trace_stream::drain(buffer.as_mut());
+                        ReturnCode::SuccessWithValue { value: written }
+                    } else {
+                        ReturnCode::ENOMEM
+                    }
+                }).unwrap_or(ReturnCode::ENOMEM)
+            },
+            4 /* Serialized record size, so the drainer does not
+                 hard-code the layout version. */ => {
+                ReturnCode::SuccessWithValue { value: trace_stream::RECORD_BYTES }
+            },
+            _ => ReturnCode::ENOSUPPORT,
+        }
+    }
+
+    fn allow(&self,
+             app_id: AppId,
+             minor_num: usize,
+             slice: Option<AppSlice<Shared, u8>>
+    ) -> ReturnCode {
+        match minor_num {
+            0 => {
+                self.apps.enter(app_id, |app_data, _| {
+                    app_data.drain_buffer = slice;
+                    ReturnCode::SUCCESS
+                }).unwrap_or(ReturnCode::FAIL)
+            },
+            _ => ReturnCode::ENOSUPPORT,
+        }
+    }
+}
@@ -66,6 +66,9 @@ static mut CHIP: Option<&'static h1::chip::Hotel> = None;
 #[cfg(not(test))]
 #[panic_handler]
 pub unsafe extern "C" fn panic_fmt(pi: &core::panic::PanicInfo) -> ! {
+    // Binary dump first: a few milliseconds to flash, so triage does
+    // not depend on the slow UART text below reaching anyone.
+    h1::fault_dump::write_dump();
     // Use an unused GPIO
     let led = &mut kernel::hil::led::LedLow::new(&mut h1::gpio::PORT1.pins[15]);
     let writer = &mut h1::io::WRITER;
@@ -103,6 +106,8 @@ pub struct Papa {
     fuse_syscalls: &'static h1_syscalls::fuse::FuseSyscall<'static>,
     globalsec_syscalls: &'static h1_syscalls::globalsec::GlobalSecSyscall<'static>,
     reset_syscalls: &'static h1_syscalls::reset::ResetSyscall<'static>,
+    timestamp: &'static h1_syscalls::timestamp::TimestampSyscall<'static>,
+    tracelog: &'static h1_syscalls::tracelog::TraceLogSyscall,
 }
 
 fn get_h1_flash_segment_info(identifier: SegmentAndLocation, address: u32, size: u32) -> SegmentInfo {
@@ -136,41 +141,57 @@ pub unsafe fn reset_handler() {
 
     {
         use h1::pmu::*;
+        use h1::pinmux::{Entry, Function, SelectablePin};
         Clock::new(PeripheralClock::Bank0(PeripheralClock0::Gpio0)).enable();
-        let pinmux = &mut *h1::pinmux::PINMUX;
 
         const GPIO_INPUT_EN: u32 = 1 << 2;
         const GPIO_PULLUP_EN: u32 = 1 << 4;
 
-        // BMC_SRST#
-        pinmux.diob2.select.set(h1::pinmux::Function::Gpio0Gpio0);
-        pinmux.gpio0_gpio0.select.set(h1::pinmux::SelectablePin::Diob2);
-
-        // BMC_CPU_RST#
-        pinmux.diob6.select.set(h1::pinmux::Function::Gpio0Gpio1);
-        pinmux.gpio0_gpio1.select.set(h1::pinmux::SelectablePin::Diob6);
-
-        // SYS_RSTMON#
-        pinmux.diob0.select.set(h1::pinmux::Function::Gpio0Gpio2);
-        pinmux.diob0.control.set(GPIO_INPUT_EN | GPIO_PULLUP_EN);
-        pinmux.gpio0_gpio2.select.set(h1::pinmux::SelectablePin::Diob0);
-
-        // BMC_RSTMON#
-        pinmux.diob7.select.set(h1::pinmux::Function::Gpio0Gpio3);
-        pinmux.diob7.control.set(GPIO_INPUT_EN | GPIO_PULLUP_EN);
-        pinmux.gpio0_gpio3.select.set(h1::pinmux::SelectablePin::Diob7);
-
-        pinmux.dioa0.select.set(h1::pinmux::Function::Uart0Tx);
-        pinmux.diom0.control.set(GPIO_INPUT_EN | GPIO_PULLUP_EN);
-        pinmux.uart0_rx.select.set(h1::pinmux::SelectablePin::Diom0);
-
-        // SPI MISO: input enable + pull-up enable
-        pinmux.dioa11.control.set(GPIO_INPUT_EN | GPIO_PULLUP_EN);
-
-        // SPS CLK, CS, MOSI: input enable + pull-up enable
-        pinmux.dioa6.control.set(GPIO_INPUT_EN | GPIO_PULLUP_EN);
-        pinmux.dioa12.control.set(GPIO_INPUT_EN | GPIO_PULLUP_EN);
-        pinmux.dioa2.control.set(GPIO_INPUT_EN | GPIO_PULLUP_EN);
+        // Whole-board pinout, applied in one pass.
+        const PINMUX_TABLE: &[Entry] = &[
+            // BMC_SRST#
+            Entry::PadFunction { pad: SelectablePin::Diob2,
+                                 function: Function::Gpio0Gpio0 },
+            Entry::PeripheralInput { function: Function::Gpio0Gpio0,
+                                     pad: SelectablePin::Diob2 },
+            // BMC_CPU_RST#
+            Entry::PadFunction { pad: SelectablePin::Diob6,
+                                 function: Function::Gpio0Gpio1 },
+            Entry::PeripheralInput { function: Function::Gpio0Gpio1,
+                                     pad: SelectablePin::Diob6 },
+            // SYS_RSTMON#
+            Entry::PadFunction { pad: SelectablePin::Diob0,
+                                 function: Function::Gpio0Gpio2 },
+            Entry::PadControl { pad: SelectablePin::Diob0,
+                                bits: GPIO_INPUT_EN | GPIO_PULLUP_EN },
+            Entry::PeripheralInput { function: Function::Gpio0Gpio2,
+                                     pad: SelectablePin::Diob0 },
+            // BMC_RSTMON#
+            Entry::PadFunction { pad: SelectablePin::Diob7,
+                                 function: Function::Gpio0Gpio3 },
+            Entry::PadControl { pad: SelectablePin::Diob7,
+                                bits: GPIO_INPUT_EN | GPIO_PULLUP_EN },
+            Entry::PeripheralInput { function: Function::Gpio0Gpio3,
+                                     pad: SelectablePin::Diob7 },
+            // UART
+            Entry::PadFunction { pad: SelectablePin::Dioa0,
+                                 function: Function::Uart0Tx },
+            Entry::PadControl { pad: SelectablePin::Diom0,
+                                bits: GPIO_INPUT_EN | GPIO_PULLUP_EN },
+            Entry::PeripheralInput { function: Function::Uart0Rx,
+                                     pad: SelectablePin::Diom0 },
+            // SPI MISO: input enable + pull-up enable
+            Entry::PadControl { pad: SelectablePin::Dioa11,
+                                bits: GPIO_INPUT_EN | GPIO_PULLUP_EN },
+            // SPS CLK, CS, MOSI: input enable + pull-up enable
+            Entry::PadControl { pad: SelectablePin::Dioa6,
+                                bits: GPIO_INPUT_EN | GPIO_PULLUP_EN },
+            Entry::PadControl { pad: SelectablePin::Dioa12,
+                                bits: GPIO_INPUT_EN | GPIO_PULLUP_EN },
+            Entry::PadControl { pad: SelectablePin::Dioa2,
+                                bits: GPIO_INPUT_EN | GPIO_PULLUP_EN },
+        ];
+        h1::pinmux::apply(PINMUX_TABLE);
     }
 
     let gpio_bmc_srst_n = &h1::gpio::PORT0.pins[0];
@@ -213,6 +234,14 @@ pub unsafe fn reset_handler() {
     let uart = &h1::uart::UART0;
     uart.config(115200);
 
+    // Kernel-side TX ring: console writes complete once staged here
+    // instead of once drained at baud rate.
+    uart.set_tx_ring(static_init!([u8; 512], [0; 512]));
+
+    // Kernel-side RX ring: bytes arriving between console reads spill
+    // here instead of overrunning the 32-character hardware FIFO.
+    uart.set_rx_ring(static_init!([u8; 512], [0; 512]));
+
     // Create virtual device for console.
     let console_uart = static_init!(UartDevice, UartDevice::new(uart_mux, true));
     console_uart.setup();
@@ -319,6 +348,7 @@ pub unsafe fn reset_handler() {
         h1_syscalls::digest::DigestDriver::new(
                 &mut h1::crypto::sha::KEYMGR0_SHA,
                 kernel.create_grant(&grant_cap)));
+    h1::crypto::sha::KEYMGR0_SHA.set_finalize_client(digest);
 
     let aes = static_init!(
         h1_syscalls::aes::AesDriver,
@@ -329,10 +359,41 @@ pub unsafe fn reset_handler() {
     h1::crypto::dcrypto::DCRYPTO.initialize();
     let dcrypto = static_init!(
         h1_syscalls::dcrypto::DcryptoDriver<'static>,
-        h1_syscalls::dcrypto::DcryptoDriver::new(&mut h1::crypto::dcrypto::DCRYPTO));
+        h1_syscalls::dcrypto::DcryptoDriver::new(
+            &mut h1::crypto::dcrypto::DCRYPTO,
+            kernel.create_grant(&grant_cap)));
 
     h1::crypto::dcrypto::DCRYPTO.set_client(dcrypto);
 
+    // Shared 1Mhz Timeus counter behind the crypto request queues,
+    // used to expire requests that wait too long for an engine.
+    let arbiter_timer = static_init!(h1::timeus::Timeus, h1::timeus::Timeus::new(2));
+    arbiter_timer.start_us();
+    aes.set_queue_timer(arbiter_timer);
+    dcrypto.set_queue_timer(arbiter_timer);
+
+    // Holds a checkpointed long dcrypto operation's DMEM while a
+    // queued short program runs. Sized for the full DMEM so any
+    // working set fits; shrink it if SRAM gets tight and long-running
+    // programs declare smaller working sets.
+    let dcrypto_checkpoint = static_init!([u8; 4096], [0; 4096]);
+    dcrypto.set_checkpoint_buffer(dcrypto_checkpoint);
+
+    // Dedicated 1Mhz Timeus counter behind the read-only timestamp
+    // syscall; the alarm driver's low-speed timer is too coarse for
+    // userspace profiling.
+    let timestamp_timer = static_init!(h1::timeus::Timeus, h1::timeus::Timeus::new(1));
+    timestamp_timer.start_us();
+    let timestamp = static_init!(
+        h1_syscalls::timestamp::TimestampSyscall<'static>,
+        h1_syscalls::timestamp::TimestampSyscall::new(timestamp_timer));
+
+    // Binary trace stream drain/append syscalls; a no-op unless the
+    // trace_stream feature is built in.
+    let tracelog = static_init!(
+        h1_syscalls::tracelog::TraceLogSyscall,
+        h1_syscalls::tracelog::TraceLogSyscall::new(kernel.create_grant(&grant_cap)));
+
     h1::trng::TRNG0.init();
     let entropy_to_random = static_init!(
         capsules::rng::Entropy32ToRandom<'static>,
@@ -374,6 +435,8 @@ pub unsafe fn reset_handler() {
         h1_syscalls::fuse::FuseSyscall<'static>,
         h1_syscalls::fuse::FuseSyscall::new(&h1::fuse::FUSE, kernel.create_grant(&grant_cap))
     );
+    // Capture the fuse shadow now so device-ID queries never touch OTP.
+    h1::fuse::FUSE.init();
 
     const H1_FLASH_BANK_SIZE: u32 = h1::hil::flash::h1_hw::H1_FLASH_BANK_SIZE as u32;
     h1::globalsec::GLOBALSEC.init(h1::globalsec::Segments {
@@ -420,6 +483,8 @@ pub unsafe fn reset_handler() {
         fuse_syscalls: fuse_syscalls,
         globalsec_syscalls: globalsec_syscalls,
         reset_syscalls: reset_syscalls,
+        timestamp: timestamp,
+        tracelog: tracelog,
     };
 
     extern "C" {
@@ -456,7 +521,8 @@ impl Platform for Papa {
     where
         F: FnOnce(Option<&dyn kernel::Driver>) -> R
     {
-        match driver_num {
+        h1::syscall_profile::syscall_enter(driver_num);
+        let res = match driver_num {
             capsules::alarm::DRIVER_NUM                => f(Some(self.timer)),
             capsules::console::DRIVER_NUM              => f(Some(self.console)),
             capsules::gpio::DRIVER_NUM                 => f(Some(self.gpio)),
@@ -472,8 +538,12 @@ impl Platform for Papa {
             h1_syscalls::fuse::DRIVER_NUM              => f(Some(self.fuse_syscalls)),
             h1_syscalls::globalsec::DRIVER_NUM         => f(Some(self.globalsec_syscalls)),
             h1_syscalls::reset::DRIVER_NUM             => f(Some(self.reset_syscalls)),
+            h1_syscalls::timestamp::DRIVER_NUM         => f(Some(self.timestamp)),
+            h1_syscalls::tracelog::DRIVER_NUM          => f(Some(self.tracelog)),
             kernel::ipc::DRIVER_NUM                    => f(Some(&self.ipc)),
             _ =>  f(None),
-        }
+        };
+        h1::syscall_profile::syscall_exit(driver_num);
+        res
     }
 }
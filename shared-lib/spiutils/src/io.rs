@@ -255,6 +255,38 @@ pub trait LeInt: Sized + Copy {
     fn write_to<W: Write>(self, w: W) -> Result<(), Error>;
 }
 
+impl LeInt for u8 {
+    #[inline]
+    fn read_from<'a, R: Read<'a>>(mut r: R) -> Result<Self, Error> {
+        Ok(r.read_bytes(mem::size_of::<Self>())?[0])
+    }
+
+    #[inline]
+    fn write_to<W: Write>(self, mut w: W) -> Result<(), Error> {
+        w.write_bytes(&[self])
+    }
+}
+
+impl LeInt for u16 {
+    #[inline]
+    fn read_from<'a, R: Read<'a>>(mut r: R) -> Result<Self, Error> {
+        use byteorder::ByteOrder as _;
+
+        Ok(byteorder::LE::read_u16(
+            r.read_bytes(mem::size_of::<Self>())?,
+        ))
+    }
+
+    #[inline]
+    fn write_to<W: Write>(self, mut w: W) -> Result<(), Error> {
+        use byteorder::ByteOrder as _;
+
+        let mut bytes = [0; mem::size_of::<Self>()];
+        byteorder::LE::write_u16(&mut bytes, self);
+        w.write_bytes(&bytes)
+    }
+}
+
 impl LeInt for u32 {
     #[inline]
     fn read_from<'a, R: Read<'a>>(mut r: R) -> Result<Self, Error> {
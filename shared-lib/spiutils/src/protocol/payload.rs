@@ -16,6 +16,7 @@
 
 //! SPI flash protocol payload.
 
+use crate::io;
 use crate::io::Read;
 use crate::io::Write;
 use crate::protocol::wire::FromWireError;
@@ -24,6 +25,8 @@ use crate::protocol::wire::ToWireError;
 use crate::protocol::wire::ToWire;
 use crate::protocol::wire::WireEnum;
 
+use core::convert::TryFrom;
+
 /// Data for CRC8 implementation.
 struct Crc8 {
     crc: u16,
@@ -124,3 +127,105 @@ impl ToWire for Header {
         Ok(())
     }
 }
+
+/// A borrowed view of a payload header still in its wire encoding.
+///
+/// [`Header::from_wire`] copies each field out of the buffer into an
+/// owned struct; a view borrows the header bytes in place and decodes
+/// fields on access, so the per-transaction parse allocates and copies
+/// nothing. In particular [`HeaderView::verify_checksum`] runs the CRC
+/// straight over the wire bytes instead of re-serializing the fields
+/// the way [`compute_checksum`] does. The wire format is byte-oriented
+/// (big-endian, unaligned), so fields are decoded on access rather
+/// than reinterpreted.
+#[derive(Clone, Copy)]
+pub struct HeaderView<'a> {
+    bytes: &'a [u8; HEADER_LEN],
+}
+
+impl<'a> HeaderView<'a> {
+    /// Creates a view over the header at the start of `buf`, returning
+    /// the view and the bytes following it.
+    ///
+    /// Only the buffer length is validated here; use [`HeaderView::content`]
+    /// to find out whether the content type is known.
+    pub fn new(buf: &'a [u8]) -> Result<(Self, &'a [u8]), FromWireError> {
+        if buf.len() < HEADER_LEN {
+            return Err(FromWireError::Io(io::Error::BufferExhausted));
+        }
+        let (header_bytes, rest) = buf.split_at(HEADER_LEN);
+        let bytes = <&[u8; HEADER_LEN]>::try_from(header_bytes)
+            .map_err(|_| FromWireError::OutOfRange)?;
+        Ok((Self { bytes }, rest))
+    }
+
+    /// The content type following the header, or None if the wire value
+    /// is unknown.
+    pub fn content(&self) -> Option<ContentType> {
+        ContentType::from_wire_value(self.bytes[0])
+    }
+
+    /// The length of the content following the header.
+    pub fn content_len(&self) -> usize {
+        u16::from_be_bytes([self.bytes[1], self.bytes[2]]) as usize
+    }
+
+    /// The checksum field.
+    pub fn checksum(&self) -> u8 {
+        self.bytes[HEADER_LEN - 1]
+    }
+
+    /// Checks the checksum over the header and content, both still in
+    /// wire form. `payload` is the byte sequence following the header;
+    /// bytes beyond [`HeaderView::content_len`] are ignored.
+    pub fn verify_checksum(&self, payload: &[u8]) -> bool {
+        let len = self.content_len();
+        if payload.len() < len {
+            return false;
+        }
+        Crc8::init()
+            .add(&self.bytes[..HEADER_LEN - 1])
+            .add(&payload[..len])
+            .get() == self.checksum()
+    }
+}
+
+#[cfg(test)]
+mod test {
+    use super::*;
+
+    #[test]
+    fn view_matches_from_wire() {
+        let payload = [0xde, 0xad, 0xbe, 0xef];
+        let mut header = Header {
+            content: ContentType::Firmware,
+            content_len: payload.len() as u16,
+            checksum: 0,
+        };
+        header.checksum = compute_checksum(&header, &payload);
+
+        let mut buf = [0u8; HEADER_LEN + 4];
+        {
+            let mut w = &mut buf[..HEADER_LEN];
+            header.to_wire(&mut w).unwrap();
+        }
+        buf[HEADER_LEN..].copy_from_slice(&payload);
+
+        let (view, rest) = HeaderView::new(&buf).unwrap();
+        assert_eq!(view.content(), Some(ContentType::Firmware));
+        assert_eq!(view.content_len(), payload.len());
+        assert_eq!(view.checksum(), header.checksum);
+        assert!(view.verify_checksum(rest));
+
+        // A flipped payload bit must fail the checksum.
+        let mut bad = buf;
+        bad[HEADER_LEN] ^= 1;
+        let (view, rest) = HeaderView::new(&bad).unwrap();
+        assert!(!view.verify_checksum(rest));
+    }
+
+    #[test]
+    fn view_short_buffer() {
+        assert!(HeaderView::new(&[0u8; HEADER_LEN - 1]).is_err());
+    }
+}
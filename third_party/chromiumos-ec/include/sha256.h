@@ -32,11 +32,46 @@ uint8_t *SHA256_final(struct sha256_ctx *ctx);
 void hmac_SHA256(uint8_t *output, const uint8_t *key, const int key_len,
                  const uint8_t *message, const int message_len);
 
+/* Precomputed HMAC key context: init hashes the ipad and opad key
+ * blocks once and stores the two midstates, so every MAC with the same
+ * key skips key processing and starts two compressions ahead. */
+struct hmac_sha256_ctx {
+        struct sha256_ctx hash;
+        uint32_t ih[8]; /* midstate after the key ^ ipad block */
+        uint32_t oh[8]; /* midstate after the key ^ opad block */
+};
+
+/* key_len must be <= SHA256_BLOCK_SIZE. */
+void hmac_SHA256_ctx_init(struct hmac_sha256_ctx *ctx, const uint8_t *key,
+                          const int key_len);
+void hmac_SHA256_ctx_mac(struct hmac_sha256_ctx *ctx, uint8_t *output,
+                         const uint8_t *message, const int message_len);
+
 uint8_t* tock_compat_sha256(const void* data, size_t len, uint8_t* digest);
 
 void fips_hwHMAC256_init(const uint32_t[]);
+/* Whole HMAC pass in one kernel command; returns 1 on success, 0 if
+ * the caller must fall back to init/update/final streaming. */
+int fips_hwHMAC256_oneshot(const uint32_t key[SHA256_DIGEST_WORDS],
+                           const void *msg, size_t msg_len,
+                           uint32_t output[SHA256_DIGEST_WORDS]);
 void fips_hwSHA256_init(void);
 void fips_hwSHA256_update(const void*, size_t);
 const uint8_t* fips_hwSHA256_final(uint32_t[SHA256_DIGEST_WORDS]);
 
+/* Multi-session digests: the hardware engine holds a single running
+ * hash, so the first session to init claims it and any session opened
+ * while it is busy transparently runs on the software implementation.
+ * This lets interleaved hashes proceed without rehashing. */
+typedef struct {
+        int hw; /* !0 when this session owns the hardware engine */
+        struct sha256_ctx soft;
+} fips_sha256_session;
+
+void fips_SHA256_session_init(fips_sha256_session *s);
+void fips_SHA256_session_update(fips_sha256_session *s, const void *data,
+                                size_t n);
+const uint8_t *fips_SHA256_session_final(fips_sha256_session *s,
+                                         uint32_t out[SHA256_DIGEST_WORDS]);
+
 #endif  /* __CROS_EC_SHA256_H */
@@ -72,6 +72,15 @@
                         + SHA256_F3(w[i - 15]) + w[i - 16];	\
         }
 
+#define SHA256_EXP(a, b, c, d, e, f, g, h, j)			\
+        {							\
+                t1 = wv[h] + SHA256_F2(wv[e]) + CH(wv[e], wv[f], wv[g]) \
+                        + sha256_k[j] + w[j];			\
+                t2 = SHA256_F1(wv[a]) + MAJ(wv[a], wv[b], wv[c]); \
+                wv[d] += t1;					\
+                wv[h] = t1 + t2;				\
+        }
+
 static const uint32_t sha256_h0[8] = {
         0x6a09e667, 0xbb67ae85, 0x3c6ef372, 0xa54ff53a,
         0x510e527f, 0x9b05688c, 0x1f83d9ab, 0x5be0cd19};
@@ -118,8 +127,18 @@ static void SHA256_transform(struct sha256_ctx *ctx, const uint8_t *message,
         for (i = 0; i < (int) block_nb; i++) {
                 sub_block = message + (i << 6);
 
-                for (j = 0; j < 16; j++)
-                        PACK32(&sub_block[j << 2], &w[j]);
+                /* Word-aligned blocks (the common case: ctx->block and
+                 * most callers' buffers) can be loaded 4 bytes at a
+                 * time with a byte swap instead of bytewise shifts. */
+                if (((uintptr_t)sub_block & 3) == 0) {
+                        const uint32_t *sub_words =
+                                (const uint32_t *)sub_block;
+                        for (j = 0; j < 16; j++)
+                                w[j] = __builtin_bswap32(sub_words[j]);
+                } else {
+                        for (j = 0; j < 16; j++)
+                                PACK32(&sub_block[j << 2], &w[j]);
+                }
 
 #ifdef CONFIG_SHA256_UNROLLED
                 for (j = 16; j < 64; j += 8) {
@@ -246,48 +265,87 @@ uint8_t *SHA256_final(struct sha256_ctx *ctx)
         return ctx->buf;
 }
 
-static void hmac_SHA256_step(uint8_t *output, uint8_t mask,
-                        const uint8_t *key, const int key_len,
-                        const uint8_t *data, const int data_len) {
-        struct sha256_ctx ctx;
-        uint8_t *key_pad = ctx.block;
-        uint8_t *tmp;
+void hmac_SHA256_ctx_init(struct hmac_sha256_ctx *ctx, const uint8_t *key,
+                          const int key_len)
+{
+        struct sha256_ctx *hash = &ctx->hash;
+        uint8_t *key_pad = hash->block;
         int i;
 
-        /* key_pad = key (zero-padded) ^ mask */
-        memset(key_pad, mask, SHA256_BLOCK_SIZE);
+        /* This code does not support key_len > block_size. */
+  //ASSERT(key_len <= SHA256_BLOCK_SIZE);
+
+        /* i_key_pad = key (zero-padded) ^ 0x36 */
+        memset(key_pad, 0x36, SHA256_BLOCK_SIZE);
         for (i = 0; i < key_len; i++)
                 key_pad[i] ^= key[i];
+        SHA256_init_1b(hash, key_pad);
+        memcpy(ctx->ih, hash->h, sizeof(ctx->ih));
+
+        /* o_key_pad = i_key_pad ^ 0x36 ^ 0x5c */
+        for (i = 0; i < SHA256_BLOCK_SIZE; i++)
+                key_pad[i] ^= 0x36 ^ 0x5c;
+        SHA256_init_1b(hash, key_pad);
+        memcpy(ctx->oh, hash->h, sizeof(ctx->oh));
+}
+
+/* Resume a hash from a stored key-block midstate */
+static void SHA256_init_midstate(struct sha256_ctx *ctx, const uint32_t *h)
+{
+        int i;
 
-        /* tmp = hash(key_pad || message) */
-        SHA256_init_1b(&ctx, key_pad);
-        SHA256_update(&ctx, data, data_len);
-        tmp = SHA256_final(&ctx);
-        memcpy(output, tmp, SHA256_DIGEST_SIZE);
+        for (i = 0; i < 8; i++)
+                ctx->h[i] = h[i];
+
+        ctx->len = 0;
+        ctx->tot_len = SHA256_BLOCK_SIZE;
+}
+
+void hmac_SHA256_ctx_mac(struct hmac_sha256_ctx *ctx, uint8_t *output,
+                         const uint8_t *message, const int message_len)
+{
+        struct sha256_ctx *hash = &ctx->hash;
+
+        /* output = hash(i_key_pad || message), from the stored
+         * midstate (use output as temporary buffer) */
+        SHA256_init_midstate(hash, ctx->ih);
+        SHA256_update(hash, message, message_len);
+        memcpy(output, SHA256_final(hash), SHA256_DIGEST_SIZE);
+
+        /* output = hash(o_key_pad || output) */
+        SHA256_init_midstate(hash, ctx->oh);
+        SHA256_update(hash, output, SHA256_DIGEST_SIZE);
+        memcpy(output, SHA256_final(hash), SHA256_DIGEST_SIZE);
 }
 
 void hmac_SHA256(uint8_t *output, const uint8_t *key, const int key_len,
                  const uint8_t *message, const int message_len) {
-        /* This code does not support key_len > block_size. */
-  //ASSERT(key_len <= SHA256_BLOCK_SIZE);
+        struct hmac_sha256_ctx ctx;
 
-        /*
-         * i_key_pad = key (zero-padded) ^ 0x36
-         * output = hash(i_key_pad || message)
-         * (Use output as temporary buffer)
-         */
-        hmac_SHA256_step(output, 0x36, key, key_len, message, message_len);
-
-        /*
-         * o_key_pad = key (zero-padded) ^ 0x5c
-         * output = hash(o_key_pad || output)
-         */
-        hmac_SHA256_step(output, 0x5c,
-                         key, key_len, output, SHA256_DIGEST_SIZE);
+        hmac_SHA256_ctx_init(&ctx, key, key_len);
+        hmac_SHA256_ctx_mac(&ctx, output, message, message_len);
 }
 
+/* One-shot hashes below this size run on the software implementation:
+ * the allow/init/update/finalize syscalls of the hardware path cost
+ * more than hashing a block or two locally. Override at build time to
+ * retune. */
+#ifndef SHA256_HW_THRESHOLD
+#define SHA256_HW_THRESHOLD 128
+#endif
+
 uint8_t* tock_compat_sha256(const void* data, size_t len, uint8_t* digest) {
-  int rval = tock_digest_hash_easy((void*)data, len, digest, SHA256_DIGEST_SIZE, DIGEST_MODE_SHA256);
+  int rval;
+
+  if (len < SHA256_HW_THRESHOLD) {
+    struct sha256_ctx ctx;
+    SHA256_init(&ctx);
+    SHA256_update(&ctx, data, len);
+    memcpy(digest, SHA256_final(&ctx), SHA256_DIGEST_SIZE);
+    return digest;
+  }
+
+  rval = tock_digest_hash_easy((void*)data, len, digest, SHA256_DIGEST_SIZE, DIGEST_MODE_SHA256);
   if (rval < 0) {
     printf("Error on digest: %i\n", rval);
   }
@@ -15,7 +15,9 @@
 BUILD_SUBDIRS := $(addprefix userspace/,                   \
                                          aes_test          \
                                          blink             \
+                                         crypto_bench      \
                                          dcrypto_test      \
+                                         flash_profile     \
                                          flash_test        \
                                          gpio_test         \
                                          low_level_debug   \
@@ -461,7 +463,13 @@ userspace/$(APP)/$(BOARD)/run: \
 .PHONY: build/userspace/$(APP)/$(BOARD)/app
 build/userspace/$(APP)/$(BOARD)/app: sandbox_setup
 	rm -f build/userspace/cargo/thumbv7m-none-eabi/release/deps/$(APP)-*
+	# The test harness bakes TANGO_PERF_BOARD in via option_env!, and
+	# cargo does not rebuild dependencies when the environment changes,
+	# so force it to be recompiled for this board.
+	rm -f build/userspace/cargo/thumbv7m-none-eabi/release/deps/test-* \
+		build/userspace/cargo/thumbv7m-none-eabi/release/deps/libtest-*
 	cd userspace/$(APP) && TOCK_KERNEL_VERSION=$(APP) \
+		TANGO_PERF_BOARD=$(BOARD) \
 		$(BWRAP) cargo test --no-run --offline --release
 	mkdir -p build/userspace/$(APP)/$(BOARD)
 	find build/userspace/cargo/thumbv7m-none-eabi/release/deps -maxdepth 1 -regex \
@@ -28,6 +28,39 @@ BUILDDIR ?= $(APP_DIR)/../../build/userspace/$(APP)
 
 C_SRCS   := $(wildcard *.c)
 
+# Use the unrolled software SHA-256 rounds (see
+# third_party/chromiumos-ec/sha256.c). Costs ~1.5KB of flash; set
+# SHA256_UNROLLED=0 for the compact loop-based variant.
+SHA256_UNROLLED ?= 1
+ifeq ($(SHA256_UNROLLED),1)
+override CPPFLAGS += -DCONFIG_SHA256_UNROLLED
+endif
+
+# Slim production profile. SLIM=1 compiles out the FIPS known-answer
+# vectors and their runners (see libh1's Makefile, which drops
+# fips_crypto_tests.c from the library) and keeps test-only HID
+# surfaces like CONFIG_FIPS_TEST off. Saves several KB of .text --
+# flash headroom for the A/B image scheme -- and keeps the once-a-boot
+# test code out of the hot path's icache reach. The default keeps the
+# self-test surface for lab builds.
+SLIM ?= 0
+ifeq ($(SLIM),1)
+override CPPFLAGS += -DCONFIG_SLIM
+endif
+
+# Link-time optimization and hot/cold text placement. LTO lets the
+# linker inline and prune across the app/libh1/chromiumos-ec boundary,
+# and -freorder-functions groups __attribute__((hot)) code (the U2F
+# frame handling path) into a contiguous .text.hot stretch at the front
+# of the app's flash while __attribute__((cold)) code (the FIPS
+# self-tests, run once at boot) lands in .text.unlikely at the end.
+# Flash wait states on H1 make this locality measurable. Set LTO=0 for
+# debug builds whose objects map one-to-one to sources.
+LTO ?= 1
+ifeq ($(LTO),1)
+override CFLAGS += -flto -ffat-lto-objects -ffunction-sections -freorder-functions
+endif
+
 OBJS += $(patsubst %.c,$(BUILDDIR)/%.o,$(C_SRCS))
 
 TOCK_APP_CONFIG = -Xlinker --defsym=STACK_SIZE=$$(STACK_SIZE)\
@@ -13,7 +13,7 @@
 // limitations under the License.
 
 #include <gpio.h>
-#include <stdio.h>
+#include "fmt.h"
 #include <string.h>
 
 #include "h1_aes_syscalls.h"
@@ -26,46 +26,45 @@ void print_buffer(unsigned char *buffer, size_t length);
 
 void print_buffer(unsigned char *buffer, size_t length) {
   for (size_t i = 0; i < length; i++) {
-    printf("%02x ", buffer[i]);
-    fflush(stdout);
+    h1_printf("%02x ", buffer[i]);
   }
-  printf("\n");
+  h1_printf("\n");
 }
 
 int main(void) {
-  printf("==== Starting Encryption ====\n");
-  //  printf("Expecting [%d]: 0x", sizeof(expected));
+  h1_printf("==== Starting Encryption ====\n");
+  //  h1_printf("Expecting [%d]: 0x", sizeof(expected));
   // print_buffer(expected, sizeof(expected), "%02x");
-  printf("Setting up key.\n");
+  h1_printf("Setting up key.\n");
   tock_aes_set_key(key, strlen((const char*)key));
-  printf("Encrypting %i bytes.\n", strlen((const char*)data));
+  h1_printf("Encrypting %i bytes.\n", strlen((const char*)data));
   memcpy(buffer, data, strlen((const char*)data) + 1);
   int len = tock_aes_encrypt_ecb_sync(16, buffer, sizeof(buffer));
 
   if (len >= 0) {
-    printf("Result    [%i]: ", len);
+    h1_printf("Result    [%i]: ", len);
     print_buffer(buffer, sizeof(buffer));
   } else {
-    printf("Got error while encrypting: %d\n", len);
+    h1_printf("Got error while encrypting: %d\n", len);
     return -1;
   }
 
-  printf("\n");
-  printf("==== Starting Decryption ====\n");
+  h1_printf("\n");
+  h1_printf("==== Starting Decryption ====\n");
 
-  printf("Expecting [%d]: ", strlen((const char*)data));
+  h1_printf("Expecting [%d]: ", strlen((const char*)data));
   print_buffer(data, strlen((const char*)data));
 
   int res;
-  printf("Setting up key.\n");
+  h1_printf("Setting up key.\n");
   res = tock_aes_set_key(key, strlen((const char*)key));
   if (res < 0) {
-    printf("Got error while setup: %d\n", res);
+    h1_printf("Got error while setup: %d\n", res);
   }
-  printf("Decrypting.\n");
+  h1_printf("Decrypting.\n");
   int dec_len = tock_aes_decrypt_ecb_sync(16, buffer, sizeof(buffer));
 
-  printf("Result    [%d]: ", dec_len);
+  h1_printf("Result    [%d]: ", dec_len);
   print_buffer(buffer, sizeof(buffer));
 
 }
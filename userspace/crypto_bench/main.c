@@ -0,0 +1,271 @@
+// Copyright 2021 Google LLC
+//
+// Licensed under the Apache License, Version 2.0 (the "License");
+// you may not use this file except in compliance with the License.
+// You may obtain a copy of the License at
+//
+//     https://www.apache.org/licenses/LICENSE-2.0
+//
+// Unless required by applicable law or agreed to in writing, software
+// distributed under the License is distributed on an "AS IS" BASIS,
+// WITHOUT WARRANTIES OR CONDITIONS OF ANY KIND, either express or implied.
+// See the License for the specific language governing permissions and
+// limitations under the License.
+
+// Benchmark app for the H1 crypto drivers. The per-feature test apps
+// (aes_test, sha_test, dcrypto_test) check correctness; this app times
+// each primitive from userspace and prints min/median/p99/max in
+// microseconds over BENCH_ITERS iterations, so performance changes can
+// be regression-gated instead of eyeballed. Build with e.g.
+//   make BENCH_ITERS=128
+// to change the iteration count.
+
+#include "fmt.h"
+#include <string.h>
+#include <tock.h>
+
+#include "digest_syscalls.h"
+#include "h1_aes_syscalls.h"
+#include "nvcounter_syscalls.h"
+#include "timestamp_syscalls.h"
+
+#include "drbg.h"
+#include "fips.h"
+#include "p256.h"
+#include "p256_ecdsa.h"
+#include "sha256.h"
+
+#ifndef BENCH_ITERS
+#define BENCH_ITERS 64
+#endif
+
+// Timestamps come from the kernel's free-running microsecond counter
+// (timestamp_syscalls.h): one syscall per sample, no yields, and no
+// dependence on the coarse low-speed alarm timer.
+static uint32_t bench_ticks(void) {
+  return gettimeus();
+}
+
+typedef int (*bench_fn)(void);
+
+static uint32_t samples[BENCH_ITERS];
+
+static void sort_samples(uint32_t* s, int n) {
+  int i, j;
+  for (i = 1; i < n; ++i) {
+    uint32_t v = s[i];
+    for (j = i; j > 0 && s[j - 1] > v; --j) s[j] = s[j - 1];
+    s[j] = v;
+  }
+}
+
+static void bench_run(const char* name, bench_fn fn, int iters) {
+  int i;
+  for (i = 0; i < iters; ++i) {
+    uint32_t t0 = bench_ticks();
+    if (fn() != 0) {
+      h1_printf("%-28s FAILED on iteration %d\n", name, i);
+      return;
+    }
+    samples[i] = bench_ticks() - t0;
+  }
+  sort_samples(samples, iters);
+  h1_printf("%-28s n=%-3d min=%6lu med=%6lu p99=%6lu max=%6lu us\n", name, iters,
+         (unsigned long)samples[0], (unsigned long)samples[iters / 2],
+         (unsigned long)samples[(iters * 99) / 100],
+         (unsigned long)samples[iters - 1]);
+}
+
+// ---------------------------------------------------------------------------
+// Workloads. Buffers are static so every iteration touches the same
+// memory and the numbers reflect the driver, not cache or allocator
+// noise.
+// ---------------------------------------------------------------------------
+
+static uint8_t msg_buf[1024];
+static uint8_t digest_out[SHA256_DIGEST_SIZE];
+static size_t sha_len;
+
+static int bench_sha256(void) {
+  return tock_digest_hash_easy(msg_buf, sha_len, digest_out,
+                               sizeof(digest_out), DIGEST_MODE_SHA256) < 0;
+}
+
+// HMAC through the FIPS shim layer, the path the U2F app signs with.
+// The key context is cached kernel-side, so the steady-state cost
+// measured here is reuse + stream + finalize.
+static uint32_t hmac_key[SHA256_DIGEST_WORDS];
+
+static int bench_hmac_sha256(void) {
+  uint32_t out[SHA256_DIGEST_WORDS];
+  fips_hwHMAC256_init(hmac_key);
+  fips_hwSHA256_update(msg_buf, sha_len);
+  return fips_hwSHA256_final(out) == NULL;
+}
+
+static uint8_t aes_key[16] = "0123456789abcdef";
+static uint8_t aes_buf[128];
+static uint8_t aes_iv[16];
+
+// The sync AES wrappers return the byte count processed on success,
+// not TOCK_SUCCESS; only negative values are errors.
+static int bench_aes_ecb(void) {
+  return tock_aes_encrypt_ecb_sync(sizeof(aes_key), aes_buf,
+                                   sizeof(aes_buf)) < 0;
+}
+
+static int bench_aes_cbc(void) {
+  memset(aes_iv, 0, sizeof(aes_iv));
+  return tock_aes_encrypt_cbc_sync(aes_buf, sizeof(aes_buf), aes_iv,
+                                   sizeof(aes_iv)) < 0;
+}
+
+static int bench_aes_ctr(void) {
+  memset(aes_iv, 0, sizeof(aes_iv));
+  return tock_aes_encrypt_ctr_sync(aes_buf, sizeof(aes_buf), aes_iv,
+                                   sizeof(aes_iv)) < 0;
+}
+
+static int bench_aes_ctr_stream(void) {
+  memset(aes_iv, 0, sizeof(aes_iv));
+  return tock_aes_encrypt_ctr_stream_sync(msg_buf, sizeof(msg_buf), aes_iv,
+                                          sizeof(aes_iv)) < 0;
+}
+
+static DRBG bench_drbg;
+static p256_int ec_d, ec_x, ec_y, ec_r, ec_s, ec_msg;
+
+static int bench_ecdsa_sign(void) {
+  return !ECDSA_SIGN(&bench_drbg, &ec_d, &ec_msg, &ec_r, &ec_s);
+}
+
+static int bench_ecdsa_verify(void) {
+  return !fips_p256_ecdsa_verify(&ec_x, &ec_y, &ec_msg, &ec_r, &ec_s);
+}
+
+// The scalar base-point multiply is the dcrypto cost of a keygen;
+// fips_keygen() itself also burns a monotonic flash counter increment
+// per keypair, which a benchmark loop should not do.
+static int bench_ecdsa_keygen(void) {
+  return fips_p256_base_point_mul(&ec_d, &ec_x, &ec_y) != 0;
+}
+
+static unsigned int nv_val;
+
+static int bench_nvcounter(void) {
+  return tock_nvcounter_increment(&nv_val) != TOCK_SUCCESS;
+}
+
+// ---------------------------------------------------------------------------
+// Engine contention. A self-resubmitting background AES-CTR stream
+// keeps the AES engine, the bus and the interrupt path busy while the
+// foreground primitives are re-timed; comparing a "+aes" line against
+// its solo counterpart shows how much each engine degrades when AES
+// traffic is present. The background operation size is the load knob
+// (bigger ops occupy the engine longer per submission):
+//   make BENCH_BG_BYTES=4096
+// ---------------------------------------------------------------------------
+
+#ifndef BENCH_BG_BYTES
+#define BENCH_BG_BYTES 1024
+#endif
+
+static uint8_t bg_buf[BENCH_BG_BYTES];
+static uint8_t bg_ctr[16];
+static bool bg_stopping;
+static bool bg_idle;
+static uint32_t bg_ops;
+
+static void bg_aes_done(int count __attribute__((unused)), void* ud __attribute__((unused))) {
+  bg_ops++;
+  if (bg_stopping ||
+      tock_aes_encrypt_ctr_async(bg_buf, sizeof(bg_buf), bg_ctr,
+                                 sizeof(bg_ctr), bg_aes_done,
+                                 NULL) != TOCK_SUCCESS) {
+    bg_idle = true;
+  }
+}
+
+static int bg_start(void) {
+  bg_stopping = false;
+  bg_idle = false;
+  bg_ops = 0;
+  return tock_aes_encrypt_ctr_async(bg_buf, sizeof(bg_buf), bg_ctr,
+                                    sizeof(bg_ctr), bg_aes_done, NULL);
+}
+
+static void bg_stop(void) {
+  bg_stopping = true;
+  yield_for(&bg_idle);
+}
+
+int main(void) {
+  size_t i;
+  h1_printf("= H1 crypto benchmark, %d iterations per primitive =\n",
+         BENCH_ITERS);
+
+  if (tock_timestamp_check() != TOCK_SUCCESS) {
+    h1_printf("ERROR: no timestamp driver; cannot take timestamps.\n");
+    return 1;
+  }
+
+  for (i = 0; i < sizeof(msg_buf); ++i) msg_buf[i] = (uint8_t)i;
+  for (i = 0; i < SHA256_DIGEST_WORDS; ++i) hmac_key[i] = (uint32_t)i;
+
+  // One-time setup: FIPS self tests, a TRNG-seeded DRBG and a keypair
+  // for the sign/verify loops.
+  init_fips();
+  make_drbg2(&bench_drbg);
+  if (fips_keygen(&bench_drbg, &ec_d, &ec_x, &ec_y, NULL, 0) != 0) {
+    h1_printf("ERROR: keygen for the ECDSA benchmarks failed.\n");
+    return 1;
+  }
+  fips_p256_from_bin(msg_buf, &ec_msg);
+
+  for (sha_len = 16; sha_len <= sizeof(msg_buf); sha_len *= 4) {
+    char name[32];
+    h1_snprintf(name, sizeof(name), "sha256/%uB", (unsigned int)sha_len);
+    bench_run(name, bench_sha256, BENCH_ITERS);
+  }
+  sha_len = 256;
+  bench_run("hmac-sha256/256B", bench_hmac_sha256, BENCH_ITERS);
+
+  if (tock_aes_set_key(aes_key, sizeof(aes_key)) == TOCK_SUCCESS) {
+    bench_run("aes128-ecb/128B", bench_aes_ecb, BENCH_ITERS);
+    bench_run("aes128-cbc/128B", bench_aes_cbc, BENCH_ITERS);
+    bench_run("aes128-ctr/128B", bench_aes_ctr, BENCH_ITERS);
+    bench_run("aes128-ctr-stream/1KB", bench_aes_ctr_stream, BENCH_ITERS);
+  } else {
+    h1_printf("aes: set_key failed, skipping AES benchmarks\n");
+  }
+
+  bench_run("ecdsa-p256/sign", bench_ecdsa_sign, BENCH_ITERS);
+  bench_run("ecdsa-p256/verify", bench_ecdsa_verify, BENCH_ITERS);
+  bench_run("ecdsa-p256/keygen", bench_ecdsa_keygen, BENCH_ITERS);
+
+  // Each increment is a flash write; keep the iteration count low so a
+  // benchmark run does not wear the counter pages.
+  bench_run("nvcounter/increment", bench_nvcounter,
+            BENCH_ITERS < 8 ? BENCH_ITERS : 8);
+
+  // Contention runs: digest and dcrypto primitives with the AES
+  // engine saturated in the background. The background stream shares
+  // this process's AES driver state, so the AES primitives themselves
+  // cannot be re-run here — the interesting pairs are cross-engine.
+  h1_printf("= Contention: re-run with background AES-CTR (%uB ops) =\n",
+            (unsigned int)BENCH_BG_BYTES);
+  if (bg_start() == TOCK_SUCCESS) {
+    sha_len = 256;
+    bench_run("sha256/256B+aes", bench_sha256, BENCH_ITERS);
+    bench_run("hmac-sha256/256B+aes", bench_hmac_sha256, BENCH_ITERS);
+    bench_run("ecdsa-p256/sign+aes", bench_ecdsa_sign, BENCH_ITERS);
+    bench_run("ecdsa-p256/verify+aes", bench_ecdsa_verify, BENCH_ITERS);
+    bg_stop();
+    h1_printf("background aes ops completed: %lu\n", (unsigned long)bg_ops);
+  } else {
+    h1_printf("could not start background AES; skipping contention runs\n");
+  }
+
+  h1_printf("= Benchmark complete =\n");
+  return 0;
+}
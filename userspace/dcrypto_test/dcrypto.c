@@ -12,6 +12,11 @@
 // See the License for the specific language governing permissions and
 // limitations under the License.
 
+// The profiling build links libh1, whose dcrypto_syscalls.c provides
+// the current (five-argument) tock_dcrypto_run; this older local
+// wrapper would clash with it, so it only exists in the default build.
+#ifndef DCRYPTO_PROFILE
+
 #include <tock.h>
 #include "dcrypto.h"
 
@@ -101,3 +106,5 @@ int tock_dcrypto_run(void* data, size_t datalen,
   }
 }
 
+
+#endif  // DCRYPTO_PROFILE
@@ -0,0 +1,236 @@
+// Copyright 2021 Google LLC
+//
+// Licensed under the Apache License, Version 2.0 (the "License");
+// you may not use this file except in compliance with the License.
+// You may obtain a copy of the License at
+//
+//     https://www.apache.org/licenses/LICENSE-2.0
+//
+// Unless required by applicable law or agreed to in writing, software
+// distributed under the License is distributed on an "AS IS" BASIS,
+// WITHOUT WARRANTIES OR CONDITIONS OF ANY KIND, either express or implied.
+// See the License for the specific language governing permissions and
+// limitations under the License.
+
+// Flash latency and endurance profiler. The flash_test crate checks the
+// driver's functional behavior against fake hardware; this app runs on
+// the real part and measures what the datasheet typicals hide: the
+// erase and program latency distribution of a page and how it drifts as
+// the cells wear. The nvcounter coalescing window and the DFU pipeline
+// are sized from these numbers.
+//
+// Each cycle erases the scratch page and programs it full in 128-byte
+// chunks (the kernel's write buffer size), timing every operation with
+// the microsecond timestamp counter. A summary line is printed per
+// report window so latency growth across cycles shows up in the log,
+// and log2-bucketed histograms are dumped at the end. Build with e.g.
+//   make PROFILE_CYCLES=5000
+// to change the cycle count.
+//
+// DESTRUCTIVE: the boards only open the last three flash pages to this
+// driver, and the default scratch page (n-3) is the personality page.
+// Run personality_test afterwards to reinstall one. Do not point this
+// at the nvcounter pages (n-2, n-1) unless losing the counter is OK.
+
+#include <stdbool.h>
+#include <string.h>
+
+#include "fmt.h"
+#include "timestamp_syscalls.h"
+#include "tock.h"
+
+#define H1_DRIVER_FLASH 0x40040
+
+#define TOCK_FLASH_CMD_ERASE     1
+#define TOCK_FLASH_CMD_WRITE     2
+
+#define TOCK_FLASH_ALLOW_WRITE   0
+
+#define TOCK_FLASH_OPERATION_DONE 0
+
+#define FLASH_PAGE_SIZE  2048
+#define FLASH_NUM_PAGES  256
+// The kernel's flash write buffer holds 32 words, so writes are issued
+// in chunks of at most 128 bytes.
+#define FLASH_CHUNK      128
+#define CHUNKS_PER_PAGE  (FLASH_PAGE_SIZE / FLASH_CHUNK)
+
+// Scratch page; n-3 is the personality page, see the header comment.
+#ifndef PROFILE_PAGE
+#define PROFILE_PAGE (FLASH_NUM_PAGES - 3)
+#endif
+
+// Total erase+program cycles to put on the scratch page.
+#ifndef PROFILE_CYCLES
+#define PROFILE_CYCLES 2000
+#endif
+
+// Cycles per summary line.
+#ifndef PROFILE_WINDOW
+#define PROFILE_WINDOW 250
+#endif
+
+// Latency histogram: bucket i counts samples in [64us << i, 64us << (i+1)),
+// bucket 0 also takes anything faster, the last bucket anything slower.
+// 64us..8ms spans a healthy program pulse up to a worn page needing the
+// driver's full retry budget.
+#define HIST_BUCKETS     8
+#define HIST_BASE_US     64
+
+typedef struct {
+  bool fired;
+  int rc;
+} flash_op_t;
+
+static void flash_op_done(int rc,
+                          int unused1 __attribute__((unused)),
+                          int unused2 __attribute__((unused)),
+                          void* callback_args) {
+  flash_op_t* op = (flash_op_t*)callback_args;
+  op->rc = rc;
+  op->fired = true;
+}
+
+// Running stats for one operation type within the current window.
+typedef struct {
+  uint32_t min_us;
+  uint32_t max_us;
+  uint32_t sum_us;
+  uint32_t samples;
+} window_stats_t;
+
+static void window_reset(window_stats_t* w) {
+  w->min_us = 0xffffffff;
+  w->max_us = 0;
+  w->sum_us = 0;
+  w->samples = 0;
+}
+
+static void window_add(window_stats_t* w, uint32_t us) {
+  if (us < w->min_us) w->min_us = us;
+  if (us > w->max_us) w->max_us = us;
+  w->sum_us += us;
+  w->samples++;
+}
+
+static window_stats_t erase_window;
+static window_stats_t program_window;
+static uint32_t erase_hist[HIST_BUCKETS];
+static uint32_t program_hist[HIST_BUCKETS];
+static uint32_t erase_errors;
+static uint32_t program_errors;
+
+static void hist_add(uint32_t* hist, uint32_t us) {
+  int bucket = 0;
+  while (bucket < HIST_BUCKETS - 1 &&
+         us >= (uint32_t)(HIST_BASE_US << (bucket + 1))) {
+    bucket++;
+  }
+  hist[bucket]++;
+}
+
+static void hist_print(const char* op, const uint32_t* hist) {
+  int i;
+  for (i = 0; i < HIST_BUCKETS; ++i) {
+    if (hist[i] == 0) continue;
+    h1_printf("flash_profile hist op=%s lt_us=%lu count=%lu\n", op,
+              (unsigned long)(HIST_BASE_US << (i + 1)),
+              (unsigned long)hist[i]);
+  }
+}
+
+static uint8_t chunk_buf[FLASH_CHUNK];
+
+// Times one erase of the scratch page. Returns the callback's return
+// code; the latency is recorded even for failed operations since a
+// worn page fails by exhausting retry pulses, i.e. slowly.
+static int timed_erase(flash_op_t* op) {
+  op->fired = false;
+  uint32_t t0 = gettimeus();
+  int ret = command(H1_DRIVER_FLASH, TOCK_FLASH_CMD_ERASE, PROFILE_PAGE, 0);
+  if (ret < 0) return ret;
+  yield_for(&op->fired);
+  uint32_t us = gettimeus() - t0;
+  window_add(&erase_window, us);
+  hist_add(erase_hist, us);
+  return op->rc;
+}
+
+// Times one 128-byte program at the given byte offset into the page.
+static int timed_program(flash_op_t* op, uint32_t offset) {
+  int ret = allow(H1_DRIVER_FLASH, TOCK_FLASH_ALLOW_WRITE, chunk_buf,
+                  sizeof(chunk_buf));
+  if (ret < 0) return ret;
+  op->fired = false;
+  uint32_t t0 = gettimeus();
+  ret = command(H1_DRIVER_FLASH, TOCK_FLASH_CMD_WRITE,
+                PROFILE_PAGE * FLASH_PAGE_SIZE + offset, sizeof(chunk_buf));
+  if (ret < 0) return ret;
+  yield_for(&op->fired);
+  uint32_t us = gettimeus() - t0;
+  window_add(&program_window, us);
+  hist_add(program_hist, us);
+  return op->rc;
+}
+
+static void window_print(const char* op, uint32_t cycle,
+                         const window_stats_t* w) {
+  if (w->samples == 0) return;
+  h1_printf("flash_profile page=%u cycle=%lu op=%s n=%lu "
+            "min_us=%lu mean_us=%lu max_us=%lu\n",
+            (unsigned int)PROFILE_PAGE, (unsigned long)cycle, op,
+            (unsigned long)w->samples, (unsigned long)w->min_us,
+            (unsigned long)(w->sum_us / w->samples),
+            (unsigned long)w->max_us);
+}
+
+int main(void) {
+  flash_op_t op;
+  uint32_t cycle;
+  size_t i;
+
+  h1_printf("= Flash profiler: page %u, %u erase+program cycles =\n",
+            (unsigned int)PROFILE_PAGE, (unsigned int)PROFILE_CYCLES);
+
+  if (tock_timestamp_check() != TOCK_SUCCESS) {
+    h1_printf("ERROR: no timestamp driver; cannot take timestamps.\n");
+    return 1;
+  }
+  if (subscribe(H1_DRIVER_FLASH, TOCK_FLASH_OPERATION_DONE, flash_op_done,
+                &op) < 0) {
+    h1_printf("ERROR: could not register the flash callback.\n");
+    return 1;
+  }
+
+  window_reset(&erase_window);
+  window_reset(&program_window);
+
+  for (cycle = 1; cycle <= PROFILE_CYCLES; ++cycle) {
+    if (timed_erase(&op) != TOCK_SUCCESS) erase_errors++;
+
+    // Fill the page with a cycle-dependent pattern so every program
+    // pulse flips cells rather than re-programming identical data.
+    for (i = 0; i < sizeof(chunk_buf); ++i) {
+      chunk_buf[i] = (uint8_t)(cycle + i);
+    }
+    for (i = 0; i < CHUNKS_PER_PAGE; ++i) {
+      if (timed_program(&op, i * FLASH_CHUNK) != TOCK_SUCCESS) {
+        program_errors++;
+      }
+    }
+
+    if (cycle % PROFILE_WINDOW == 0 || cycle == PROFILE_CYCLES) {
+      window_print("erase", cycle, &erase_window);
+      window_print("program", cycle, &program_window);
+      window_reset(&erase_window);
+      window_reset(&program_window);
+    }
+  }
+
+  hist_print("erase", erase_hist);
+  hist_print("program", program_hist);
+  h1_printf("flash_profile errors erase=%lu program=%lu\n",
+            (unsigned long)erase_errors, (unsigned long)program_errors);
+  h1_printf("= Flash profiler complete =\n");
+  return 0;
+}
@@ -23,6 +23,8 @@
 #include <gpio.h>
 #include <timer.h>
 
+#include "probe.h"
+
 #define LED_0 0
 
 void output_cb(int arg0, int arg2, int arg3, void* userdata);
@@ -31,6 +33,7 @@ void input_cb(int arg0, int arg2, int arg3, void* userdata);
 void gpio_input(void);
 void interrupt_cb(int arg0, int arg2, int arg3, void* userdata);
 void gpio_interrupt(void);
+void probe_calibration(void);
 
 tock_timer_t timer;
 
@@ -96,6 +99,32 @@ void gpio_interrupt(void) {
 }
 
 
+//**************************************************
+// Probe calibration for logic-analyzer capture
+//**************************************************
+// Emits a known waveform on probe pin 0 so an analyzer setup can be
+// verified before trusting latency measurements from the kernel's
+// `probes` feature or an app's tock_probe_* points: a burst of ten
+// back-to-back pulses (each edge one syscall — their spacing is the
+// app-level probe resolution), then a 10ms-wide frame, repeated every
+// 100ms.
+void probe_calibration(void) {
+  printf("Probe calibration waveform on GPIO pin 0\n");
+  if (tock_probe_init(0) < 0) {
+    printf("ERROR: could not configure probe pin\n");
+    return;
+  }
+  while (1) {
+    for (int i = 0; i < 10; i++) {
+      tock_probe_pulse(0);
+    }
+    tock_probe_hi(0);
+    delay_ms(10);
+    tock_probe_lo(0);
+    delay_ms(90);
+  }
+}
+
 int main(void) {
   printf("*********************\n");
   printf("GPIO Test Application\n");
@@ -104,5 +133,6 @@ int main(void) {
   gpio_output();
   //gpio_input();
   //gpio_interrupt();
+  //probe_calibration();
   return 0;
 }
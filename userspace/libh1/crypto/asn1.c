@@ -160,6 +160,111 @@ size_t asn1_pubp(uint8_t* buf, const p256_int* x, const p256_int* y) {
   return asn1.n;
 }
 
+/*************************/
+/* Reverse DER builder   */
+/*************************/
+
+static uint8_t* der_prepend(DER* der, size_t n) {
+  if ((size_t)(der->p - der->base) < n) {
+    // Arena exhausted; scribble at the base and flag the result bad.
+    der->oom = 1;
+    return der->base;
+  }
+  der->p -= n;
+  return der->p;
+}
+
+void der_start(DER* der, uint8_t* arena, size_t size) {
+  der->base = arena;
+  der->end = arena + size;
+  der->p = der->end;
+  der->oom = 0;
+}
+
+size_t der_mark(const DER* der) { return der->end - der->p; }
+
+void der_byte(DER* der, uint8_t b) { *der_prepend(der, 1) = b; }
+
+void der_bytes(DER* der, const uint8_t* b, size_t n) {
+  memcpy(der_prepend(der, n), b, n);
+}
+
+void der_hdr(DER* der, uint8_t tag, size_t len) {
+  uint8_t* p;
+
+  if (len >= 256) {
+    p = der_prepend(der, 4);
+    p[1] = 0x82;
+    p[2] = len >> 8;
+    p[3] = len;
+  } else if (len >= 128) {
+    p = der_prepend(der, 3);
+    p[1] = 0x81;
+    p[2] = len;
+  } else {
+    p = der_prepend(der, 2);
+    p[1] = len;
+  }
+  p[0] = tag;
+}
+
+void der_seq(DER* der, uint8_t tag, size_t mark) {
+  der_hdr(der, tag, der_mark(der) - mark);
+}
+
+void der_int(DER* der, uint32_t val) {
+  size_t mark = der_mark(der);
+
+  do {
+    der_byte(der, val);
+    val >>= 8;
+  } while (val);
+  if (der->p[0] & 0x80) der_byte(der, 0);  // keep it positive
+  der_hdr(der, t_INT, der_mark(der) - mark);
+}
+
+void der_p256_int(DER* der, const p256_int* n) {
+  uint8_t bn[P256_NBYTES];
+  size_t mark = der_mark(der);
+  int i;
+
+  PT_TO_BIN(n, bn);
+  for (i = 0; i < P256_NBYTES - 1; ++i) {
+    if (bn[i] != 0) break;
+  }
+  der_bytes(der, bn + i, P256_NBYTES - i);
+  if (bn[i] & 0x80) der_byte(der, 0);  // keep it positive
+  der_hdr(der, t_INT, der_mark(der) - mark);
+}
+
+void der_object(DER* der, size_t n, const uint8_t* b) {
+  der_bytes(der, b, n);
+  der_hdr(der, t_OBJ, n);
+}
+
+void der_string(DER* der, uint8_t tag, const char* s) {
+  size_t n = strlen(s);
+
+  der_bytes(der, (const uint8_t*)s, n);
+  der_hdr(der, tag, n);
+}
+
+void der_pub(DER* der, const p256_int* x, const p256_int* y) {
+  uint8_t* p = der_prepend(der, 1 + 2 * P256_NBYTES);
+
+  p[0] = 4;  // uncompressed format
+  PT_TO_BIN(x, p + 1);
+  PT_TO_BIN(y, p + 1 + P256_NBYTES);
+}
+
+size_t der_finish(DER* der, uint8_t* out, size_t max) {
+  size_t n = der_mark(der);
+
+  if (der->oom || n > max) return 0;
+  memmove(out, der->p, n);  // out may alias the arena
+  return n;
+}
+
 const uint8_t OID_commonName[3] = {0x55, 0x04, 0x03};
 const uint8_t OID_organizationName[3] = {0x55, 0x04, 0x0a};
 const uint8_t OID_ecdsa_with_SHA256[8] = {0x2A, 0x86, 0x48, 0xCE,
@@ -12,9 +12,18 @@
 // See the License for the specific language governing permissions and
 // limitations under the License.
 
+#include <string.h>
+
 #include "drbg.h"
 #include "sha256.h"
 
+/* Gather buffer for one-shot HMAC passes: the message parts are packed
+ * here so the hardware engine can be keyed, fed and finalized in a
+ * single kernel command. Sized for V || tag || three seed inputs;
+ * anything longer takes the streaming fallback. */
+#define DRBG_GATHER_MAX 224
+static uint8_t gather[DRBG_GATHER_MAX];
+
 void set_8words(uint32_t* dst, uint32_t v);
 
 void set_8words(uint32_t* dst, uint32_t v) {
@@ -29,6 +38,8 @@ void set_8words(uint32_t* dst, uint32_t v) {
 }
 
 static void _updateV(DRBG* ctx) {
+  if (fips_hwHMAC256_oneshot(ctx->K, ctx->V, sizeof(ctx->V), ctx->V)) return;
+
   fips_hwHMAC256_init(ctx->K);
   fips_hwSHA256_update(ctx->V, sizeof(ctx->V));
   fips_hwSHA256_final(ctx->V);
@@ -37,6 +48,23 @@ static void _updateV(DRBG* ctx) {
 static void _updateKV(DRBG* ctx, uint8_t tag, const void* p0, size_t p0_len,
                       const void* p1, size_t p1_len, const void* p2,
                       size_t p2_len) {
+  size_t total = sizeof(ctx->V) + sizeof(tag) + p0_len + p1_len + p2_len;
+
+  if (total <= sizeof(gather)) {
+    uint8_t* p = gather;
+
+    memcpy(p, ctx->V, sizeof(ctx->V));
+    p += sizeof(ctx->V);
+    *p++ = tag;
+    if (p0_len) { memcpy(p, p0, p0_len); p += p0_len; }
+    if (p1_len) { memcpy(p, p1, p1_len); p += p1_len; }
+    if (p2_len) { memcpy(p, p2, p2_len); p += p2_len; }
+    if (fips_hwHMAC256_oneshot(ctx->K, gather, total, ctx->K)) {
+      _updateV(ctx);
+      return;
+    }
+  }
+
   fips_hwHMAC256_init(ctx->K);
   fips_hwSHA256_update(ctx->V, sizeof(ctx->V));
   fips_hwSHA256_update(&tag, sizeof(tag));
@@ -16,6 +16,7 @@
 #include "storage.h"
 
 // libtock-c
+#include "fmt.h"
 #include "rng.h"
 
 #define FLASH_ENTROPY_SIZE FLASH_INFO_MANUFACTURE_STATE_SIZE
@@ -44,7 +45,7 @@ void ensure_factory_entropy(void) {
   //uint32_t ones = -1u, v;
   uint8_t entropy[128];  // 1024 bits
   uint32_t digest[8];    // SHA256 digest
-  printf("Generating entropy:");
+  h1_printf("Generating entropy:");
   for (int i = 0; i < FLASH_ENTROPY_SIZE; i += (8 * sizeof(uint32_t))) {
     rng_sync(entropy, sizeof(entropy), sizeof(entropy));
     SHA256(entropy, sizeof(entropy), (uint8_t*)digest);
@@ -52,11 +53,11 @@ void ensure_factory_entropy(void) {
   }
   for (int i = 0; i < FLASH_ENTROPY_SIZE; i++) {
     if (i % 32 == 0) {
-      printf("\n  ");
+      h1_printf("\n  ");
     } else if (i % 4 == 0) {
-      printf(" ");
+      h1_printf(" ");
     }
-    printf("%02x", fips_entropy[i]);
+    h1_printf("%02x", fips_entropy[i]);
   }
-  printf("\n\n");
+  h1_printf("\n\n");
 }
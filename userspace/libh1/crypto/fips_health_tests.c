@@ -127,3 +127,19 @@ void adaptive_proportion_test(uint32_t val) {
 }
 
 int apt_is_initialized(void) { return __apt_initialized != 0; }
+
+/**
+ * Incremental screening entry point for the runtime entropy pipeline.
+ * Feeds each buffered word through the continuous tests above, using
+ * the same persistent state the startup tests primed, so a streak or
+ * bias that spans two batches is still caught.
+ * N.B. This function can set the global 'fips_error' variable.
+ */
+void trng_health_screen(const uint32_t *in, uint32_t n) {
+  while (n--) {
+    uint32_t rnd = *in++;
+
+    repetition_count_test(rnd);
+    adaptive_proportion_test(rnd);
+  }
+}
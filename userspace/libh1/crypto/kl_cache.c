@@ -0,0 +1,106 @@
+// Copyright 2021 Google LLC
+//
+// Licensed under the Apache License, Version 2.0 (the "License");
+// you may not use this file except in compliance with the License.
+// You may obtain a copy of the License at
+//
+//     https://www.apache.org/licenses/LICENSE-2.0
+//
+// Unless required by applicable law or agreed to in writing, software
+// distributed under the License is distributed on an "AS IS" BASIS,
+// WITHOUT WARRANTIES OR CONDITIONS OF ANY KIND, either express or implied.
+// See the License for the specific language governing permissions and
+// limitations under the License.
+
+/*
+ * Small LRU cache in front of the hardware key ladder.
+ *
+ * kl_derive() runs two ladder steps (two digest-with-cert syscalls plus
+ * the hardware ladder itself) for every derivation, and a session that
+ * re-authenticates the same origin repeats the exact same derivation
+ * each time. Remembering the last few (salt, input) -> output triples
+ * lets those repeats skip the ladder entirely.
+ *
+ * The cache holds derived key material in SRAM, so it is cleared
+ * whenever the ladder is (re)initialized, and lookups compare the full
+ * key in constant time -- input halves are derived from caller-supplied
+ * key handles, and an early-out memcmp would leak match length.
+ */
+
+#include <stdint.h>
+#include <string.h>
+
+#include "kl.h"
+
+#define KL_CACHE_ENTRIES 4
+#define KL_CACHE_WORDS 8
+
+static struct {
+  uint32_t salt[KL_CACHE_WORDS];
+  uint32_t input[KL_CACHE_WORDS];
+  uint32_t output[KL_CACHE_WORDS];
+  uint32_t last_used; /* 0 = empty */
+} cache[KL_CACHE_ENTRIES];
+
+static uint32_t use_tick;
+
+static uint32_t next_tick(void) {
+  /* 0 marks an empty entry; skip it if the tick ever wraps. */
+  if (++use_tick == 0) use_tick = 1;
+  return use_tick;
+}
+
+/* Constant time; accumulates over the full width regardless of where a
+ * mismatch occurs. */
+static int ct_equal(const uint32_t *a, const uint32_t *b, size_t nwords) {
+  uint32_t accu = 0;
+  size_t i;
+
+  for (i = 0; i < nwords; ++i) {
+    accu |= a[i] ^ b[i];
+  }
+  return accu == 0;
+}
+
+void kl_cache_clear(void) {
+  volatile uint32_t *p = (volatile uint32_t *)cache;
+  size_t i;
+
+  /* Volatile stores so the zeroization of key material is not elided. */
+  for (i = 0; i < sizeof(cache) / sizeof(uint32_t); ++i) {
+    p[i] = 0;
+  }
+  use_tick = 0;
+}
+
+int kl_cache_get(const uint32_t salt[8], const uint32_t input[8],
+                 uint32_t output[8]) {
+  int i;
+
+  for (i = 0; i < KL_CACHE_ENTRIES; ++i) {
+    if (cache[i].last_used == 0) continue;
+    /* '&' rather than '&&': both halves are always compared. */
+    if (ct_equal(cache[i].salt, salt, KL_CACHE_WORDS) &
+        ct_equal(cache[i].input, input, KL_CACHE_WORDS)) {
+      memcpy(output, cache[i].output, sizeof(cache[i].output));
+      cache[i].last_used = next_tick();
+      return 1;
+    }
+  }
+  return 0;
+}
+
+void kl_cache_put(const uint32_t salt[8], const uint32_t input[8],
+                  const uint32_t output[8]) {
+  int victim = 0;
+  int i;
+
+  /* Empty entries have last_used == 0 and win automatically. */
+  for (i = 1; i < KL_CACHE_ENTRIES; ++i) {
+    if (cache[i].last_used < cache[victim].last_used) victim = i;
+  }
+  memcpy(cache[victim].salt, salt, sizeof(cache[victim].salt));
+  memcpy(cache[victim].input, input, sizeof(cache[victim].input));
+  memcpy(cache[victim].output, output, sizeof(cache[victim].output));
+  cache[victim].last_used = next_tick();
+}
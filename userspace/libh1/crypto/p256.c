@@ -0,0 +1,471 @@
+// Copyright 2018 Google LLC
+//
+// Licensed under the Apache License, Version 2.0 (the "License");
+// you may not use this file except in compliance with the License.
+// You may obtain a copy of the License at
+//
+//     https://www.apache.org/licenses/LICENSE-2.0
+//
+// Unless required by applicable law or agreed to in writing, software
+// distributed under the License is distributed on an "AS IS" BASIS,
+// WITHOUT WARRANTIES OR CONDITIONS OF ANY KIND, either express or implied.
+// See the License for the specific language governing permissions and
+// limitations under the License.
+
+#include "p256.h"
+#include "drbg.h"
+#include "trng.h"
+
+const p256_int FIPS_SECP256r1_n =  // curve order
+    {{0xfc632551, 0xf3b9cac2, 0xa7179e84, 0xbce6faad, -1, -1, 0, -1}};
+
+const p256_int FIPS_SECP256r1_nMin2 =  // curve order - 2
+    {{0xfc632551 - 2, 0xf3b9cac2, 0xa7179e84, 0xbce6faad, -1, -1, 0, -1}};
+
+// w/ cryptoc and dcrypto.
+// Return -1, 0, 1 for a < b, a == b or a > b respectively.
+int fips_p256_cmp(const p256_int* a, const p256_int* b) {
+  size_t i;
+  int notzero = 0;
+  p256_sddigit borrow = 0;
+
+  for (i = 0; i < P256_NDIGITS; ++i) {
+    borrow += (p256_sddigit)P256_DIGIT(a, i) - P256_DIGIT(b, i);
+    // Track whether any result digit is ever not zero.
+    // Relies on !!(non-zero) evaluating to 1, e.g., !!(-1) evaluating to 1.
+    notzero |= !!((p256_digit)borrow);
+    borrow >>= P256_BITSPERDIGIT;
+  }
+  return (int)borrow | notzero;
+}
+
+// b = a + d. Returns carry, 0 or 1.
+int fips_p256_add_d(const p256_int* a, p256_digit d, p256_int* b) {
+  size_t i;
+  p256_ddigit carry = d;
+
+  for (i = 0; i < P256_NDIGITS; ++i) {
+    carry += (p256_ddigit)P256_DIGIT(a, i);
+    P256_DIGIT(b, i) = (p256_digit)carry;
+    carry >>= P256_BITSPERDIGIT;
+  }
+  return (int)carry;
+}
+
+// 1 < k < |p256|
+// TODO: How do we know the DRBG has been initialized?
+// Returns 0 on success
+int fips_p256_pick(DRBG* drbg, p256_int* output, const void* data,
+                   size_t data_len) {
+  int result = 0;
+  p256_int tmp;
+
+  do {
+    result |= DRBG_generate(drbg, &tmp, sizeof(tmp), data, data_len);
+  } while (result == 0 && fips_p256_cmp(&tmp, &FIPS_SECP256r1_nMin2) > 0);
+
+  fips_p256_add_d(&tmp, 1, output);
+
+  fips_p256_clear(&tmp);
+
+  return result;
+}
+
+// !!! NOT OK for crypto use; only for "zeroization"
+static void fips_p256_rnd(p256_int* output) {
+  size_t i;
+
+  for (i = 0; i < sizeof(output->a) / sizeof(output->a[0]); ++i) {
+    output->a[i] = fips_rand();
+  }
+}
+
+// Randomize (side-channels) then zeroize
+void fips_p256_clear(p256_int* output) {
+  fips_p256_rnd(output);
+  fips_p256_init(output);
+}
+
+void fips_p256_from_bin(const uint8_t src[P256_NBYTES], p256_int* dst) {
+  int i;
+  const uint8_t* p = &src[0];
+
+  for (i = P256_NDIGITS - 1; i >= 0; --i) {
+    P256_DIGIT(dst, i) = (p[0] << 24) | (p[1] << 16) | (p[2] << 8) | p[3];
+    p += 4;
+  }
+}
+
+void fips_p256_to_bin(const p256_int* src, uint8_t dst[P256_NBYTES]) {
+  int i;
+  uint8_t* p = &dst[0];
+
+  for (i = P256_NDIGITS - 1; i >= 0; --i) {
+    p256_digit digit = P256_DIGIT(src, i);
+    p[0] = (uint8_t)(digit >> 24);
+    p[1] = (uint8_t)(digit >> 16);
+    p[2] = (uint8_t)(digit >> 8);
+    p[3] = (uint8_t)(digit);
+    p += 4;
+  }
+}
+
+void fips_p256_init(p256_int* a) {
+  int i;
+  for (i = 0; i < P256_NDIGITS; ++i) P256_DIGIT(a, i) = 0;
+}
+
+int fips_p256_is_zero(const p256_int* a) {
+  int i, result = 0;
+  for (i = 0; i < P256_NDIGITS; ++i) result |= P256_DIGIT(a, i);
+  return !result;
+}
+
+/* ------------------------------------------------------------------
+ * Montgomery-form modular arithmetic and a software ECDSA verify.
+ *
+ * Everything below is plain C with 64-bit accumulation: every 32x32
+ * product compiles to a single UMULL on the Cortex-M3, and the CIOS
+ * multiply keeps one lazy conditional subtraction per product instead
+ * of a reduction per limb. Verify operates on public data only, so
+ * none of it needs to be constant time. The point arithmetic uses
+ * Jacobian coordinates (a = -3 formulas) and Shamir's trick for the
+ * u1*G + u2*Q double-scalar multiply.
+ * ------------------------------------------------------------------ */
+
+static const p256_int p256_prime =  // field prime
+    {{-1, -1, -1, 0, 0, 0, 1, -1}};
+
+static const p256_int p256_one = {{1, 0, 0, 0, 0, 0, 0, 0}};
+
+static const p256_int p256_Gx =  // generator
+    {{0xd898c296, 0xf4a13945, 0x2deb33a0, 0x77037d81, 0x63a440f2,
+      0xf8bce6e5, 0xe12c4247, 0x6b17d1f2}};
+static const p256_int p256_Gy =
+    {{0x37bf51f5, 0xcbb64068, 0x6b315ece, 0x2bce3357, 0x7c0f9e16,
+      0x8ee7eb4a, 0xfe1a7f9b, 0x4fe342e2}};
+
+/* c = a - b; returns the borrow out (0 or all-ones) */
+static p256_digit p256_sub(const p256_int* a, const p256_int* b, p256_int* c) {
+  p256_sddigit borrow = 0;
+  size_t i;
+
+  for (i = 0; i < P256_NDIGITS; ++i) {
+    borrow += (p256_sddigit)P256_DIGIT(a, i) - P256_DIGIT(b, i);
+    P256_DIGIT(c, i) = (p256_digit)borrow;
+    borrow >>= P256_BITSPERDIGIT;
+  }
+  return (p256_digit)borrow;
+}
+
+/* c = a + b; returns the carry out (0 or 1) */
+static p256_digit p256_add(const p256_int* a, const p256_int* b, p256_int* c) {
+  p256_ddigit carry = 0;
+  size_t i;
+
+  for (i = 0; i < P256_NDIGITS; ++i) {
+    carry += (p256_ddigit)P256_DIGIT(a, i) + P256_DIGIT(b, i);
+    P256_DIGIT(c, i) = (p256_digit)carry;
+    carry >>= P256_BITSPERDIGIT;
+  }
+  return (p256_digit)carry;
+}
+
+/* Montgomery context for one modulus; both the field prime and the
+ * curve order get one, built lazily on first use. */
+typedef struct {
+  const p256_int* mod;
+  p256_digit n0inv; /* -mod^-1 mod 2^32 */
+  p256_int rr;      /* R^2 mod mod, R = 2^256 */
+  int ready;
+} MONT_CTX;
+
+static MONT_CTX mont_p; /* field prime */
+static MONT_CTX mont_n; /* curve order */
+
+static void mod_add(const MONT_CTX* m, const p256_int* a, const p256_int* b,
+                    p256_int* c) {
+  if (p256_add(a, b, c) || fips_p256_cmp(c, m->mod) >= 0)
+    p256_sub(c, m->mod, c);
+}
+
+static void mod_sub(const MONT_CTX* m, const p256_int* a, const p256_int* b,
+                    p256_int* c) {
+  if (p256_sub(a, b, c)) p256_add(c, m->mod, c);
+}
+
+/* c = a * b * R^-1 mod mod (CIOS). The product stays below 2*mod
+ * throughout, so one conditional subtraction at the end suffices.
+ * c may alias a or b. */
+static void mont_mul(const MONT_CTX* m, const p256_int* a, const p256_int* b,
+                     p256_int* c) {
+  p256_digit t[P256_NDIGITS + 1];
+  p256_digit t_top = 0;
+  size_t i, j;
+
+  for (i = 0; i <= P256_NDIGITS; ++i) t[i] = 0;
+
+  for (i = 0; i < P256_NDIGITS; ++i) {
+    p256_digit carry = 0;
+    p256_digit mi;
+    p256_ddigit acc;
+
+    /* t += a[i] * b */
+    for (j = 0; j < P256_NDIGITS; ++j) {
+      acc = (p256_ddigit)P256_DIGIT(a, i) * P256_DIGIT(b, j) + t[j] + carry;
+      t[j] = (p256_digit)acc;
+      carry = (p256_digit)(acc >> P256_BITSPERDIGIT);
+    }
+    acc = (p256_ddigit)t[P256_NDIGITS] + carry;
+    t[P256_NDIGITS] = (p256_digit)acc;
+    t_top = (p256_digit)(acc >> P256_BITSPERDIGIT);
+
+    /* t += mi * mod, then drop the now-zero low word */
+    mi = t[0] * m->n0inv;
+    acc = (p256_ddigit)mi * P256_DIGIT(m->mod, 0) + t[0];
+    carry = (p256_digit)(acc >> P256_BITSPERDIGIT);
+    for (j = 1; j < P256_NDIGITS; ++j) {
+      acc = (p256_ddigit)mi * P256_DIGIT(m->mod, j) + t[j] + carry;
+      t[j - 1] = (p256_digit)acc;
+      carry = (p256_digit)(acc >> P256_BITSPERDIGIT);
+    }
+    acc = (p256_ddigit)t[P256_NDIGITS] + carry;
+    t[P256_NDIGITS - 1] = (p256_digit)acc;
+    t[P256_NDIGITS] = t_top + (p256_digit)(acc >> P256_BITSPERDIGIT);
+  }
+
+  for (j = 0; j < P256_NDIGITS; ++j) P256_DIGIT(c, j) = t[j];
+  if (t[P256_NDIGITS] != 0 || fips_p256_cmp(c, m->mod) >= 0)
+    p256_sub(c, m->mod, c);
+}
+
+/* -mod^-1 mod 2^32 by Newton iteration: an odd m is its own inverse
+ * mod 8, and each step doubles the valid bits. */
+static p256_digit mont_n0inv(p256_digit m0) {
+  p256_digit x = m0;
+  int i;
+
+  for (i = 0; i < 4; ++i) x *= 2 - m0 * x;
+  return (p256_digit)0 - x;
+}
+
+static void mont_ctx_init(MONT_CTX* m, const p256_int* mod) {
+  p256_int zero;
+  int i;
+
+  if (m->ready) return;
+  m->mod = mod;
+  m->n0inv = mont_n0inv(P256_DIGIT(mod, 0));
+  /* R mod mod: both moduli exceed 2^255, so 2^256 mod mod = -mod */
+  fips_p256_init(&zero);
+  p256_sub(&zero, mod, &m->rr);
+  /* R^2 mod mod by 256 modular doublings; one-time cost per modulus */
+  for (i = 0; i < 256; ++i) mod_add(m, &m->rr, &m->rr, &m->rr);
+  m->ready = 1;
+}
+
+static void to_mont(const MONT_CTX* m, const p256_int* a, p256_int* c) {
+  mont_mul(m, a, &m->rr, c);
+}
+
+static void from_mont(const MONT_CTX* m, const p256_int* a, p256_int* c) {
+  mont_mul(m, a, &p256_one, c);
+}
+
+/* c = a^-1 (Montgomery domain) by Fermat: a^(mod-2) */
+static void mont_inv(const MONT_CTX* m, const p256_int* a, p256_int* c) {
+  p256_int exp = *m->mod;
+  p256_int acc;
+  int i;
+
+  exp.a[0] -= 2; /* both moduli are well above 2; no borrow */
+  to_mont(m, &p256_one, &acc);
+  for (i = 255; i >= 0; --i) {
+    mont_mul(m, &acc, &acc, &acc);
+    if ((exp.a[i >> 5] >> (i & 31)) & 1) mont_mul(m, &acc, a, &acc);
+  }
+  *c = acc;
+}
+
+/* Jacobian point, coordinates in the Montgomery domain; z == 0 is the
+ * point at infinity. */
+typedef struct {
+  p256_int x, y, z;
+} PT_JAC;
+
+static void pt_infinity(PT_JAC* p) {
+  fips_p256_init(&p->x);
+  fips_p256_init(&p->y);
+  fips_p256_init(&p->z);
+}
+
+/* r = 2p (dbl-2001-b, a = -3); r may alias p */
+static void pt_dbl(const PT_JAC* p, PT_JAC* r) {
+  const MONT_CTX* m = &mont_p;
+  p256_int delta, gamma, beta, alpha, t1, t2;
+
+  if (fips_p256_is_zero(&p->z)) {
+    *r = *p;
+    return;
+  }
+
+  mont_mul(m, &p->z, &p->z, &delta);
+  mont_mul(m, &p->y, &p->y, &gamma);
+  mont_mul(m, &p->x, &gamma, &beta);
+  mod_sub(m, &p->x, &delta, &t1);
+  mod_add(m, &p->x, &delta, &t2);
+  mont_mul(m, &t1, &t2, &alpha);
+  mod_add(m, &alpha, &alpha, &t1);
+  mod_add(m, &t1, &alpha, &alpha); /* alpha = 3(x - d)(x + d) */
+
+  /* Z3 = (Y1 + Z1)^2 - gamma - delta, before X/Y are overwritten */
+  mod_add(m, &p->y, &p->z, &t1);
+  mont_mul(m, &t1, &t1, &t1);
+  mod_sub(m, &t1, &gamma, &t1);
+  mod_sub(m, &t1, &delta, &r->z);
+
+  /* X3 = alpha^2 - 8 beta */
+  mod_add(m, &beta, &beta, &t2);
+  mod_add(m, &t2, &t2, &t2); /* 4 beta */
+  mont_mul(m, &alpha, &alpha, &t1);
+  mod_sub(m, &t1, &t2, &t1);
+  mod_sub(m, &t1, &t2, &r->x);
+
+  /* Y3 = alpha (4 beta - X3) - 8 gamma^2 */
+  mod_sub(m, &t2, &r->x, &t2);
+  mont_mul(m, &alpha, &t2, &t2);
+  mont_mul(m, &gamma, &gamma, &t1);
+  mod_add(m, &t1, &t1, &t1);
+  mod_add(m, &t1, &t1, &t1);
+  mod_add(m, &t1, &t1, &t1);
+  mod_sub(m, &t2, &t1, &r->y);
+}
+
+/* r = a + b (add-2007-bl); r may alias a or b */
+static void pt_add(const PT_JAC* a, const PT_JAC* b, PT_JAC* r) {
+  const MONT_CTX* m = &mont_p;
+  p256_int z1z1, z2z2, u1, u2, s1, s2, h, ii, j, rh, v, t, z3;
+
+  if (fips_p256_is_zero(&a->z)) {
+    *r = *b;
+    return;
+  }
+  if (fips_p256_is_zero(&b->z)) {
+    *r = *a;
+    return;
+  }
+
+  mont_mul(m, &a->z, &a->z, &z1z1);
+  mont_mul(m, &b->z, &b->z, &z2z2);
+  mont_mul(m, &a->x, &z2z2, &u1);
+  mont_mul(m, &b->x, &z1z1, &u2);
+  mont_mul(m, &a->y, &b->z, &s1);
+  mont_mul(m, &s1, &z2z2, &s1);
+  mont_mul(m, &b->y, &a->z, &s2);
+  mont_mul(m, &s2, &z1z1, &s2);
+  mod_sub(m, &u2, &u1, &h);
+  mod_sub(m, &s2, &s1, &rh);
+
+  if (fips_p256_is_zero(&h)) {
+    if (fips_p256_is_zero(&rh)) {
+      pt_dbl(a, r);
+    } else {
+      pt_infinity(r); /* a = -b */
+    }
+    return;
+  }
+
+  mod_add(m, &h, &h, &t);
+  mont_mul(m, &t, &t, &ii); /* I = (2H)^2 */
+  mont_mul(m, &h, &ii, &j); /* J = H I */
+  mod_add(m, &rh, &rh, &rh); /* r = 2(S2 - S1) */
+  mont_mul(m, &u1, &ii, &v); /* V = U1 I */
+
+  /* Z3 = ((Z1 + Z2)^2 - Z1Z1 - Z2Z2) H, before X/Y are overwritten */
+  mod_add(m, &a->z, &b->z, &t);
+  mont_mul(m, &t, &t, &t);
+  mod_sub(m, &t, &z1z1, &t);
+  mod_sub(m, &t, &z2z2, &t);
+  mont_mul(m, &t, &h, &z3);
+
+  /* X3 = r^2 - J - 2V */
+  mont_mul(m, &rh, &rh, &t);
+  mod_sub(m, &t, &j, &t);
+  mod_sub(m, &t, &v, &t);
+  mod_sub(m, &t, &v, &r->x);
+
+  /* Y3 = r (V - X3) - 2 S1 J */
+  mod_sub(m, &v, &r->x, &t);
+  mont_mul(m, &rh, &t, &t);
+  mont_mul(m, &s1, &j, &v);
+  mod_add(m, &v, &v, &v);
+  mod_sub(m, &t, &v, &r->y);
+  r->z = z3;
+}
+
+/* r = u1 G + u2 Q, bits of both scalars scanned together (Shamir):
+ * 256 doublings plus one add per nonzero bit pair. */
+static void pt_mul2(const p256_int* u1, const PT_JAC* g, const p256_int* u2,
+                    const PT_JAC* q, PT_JAC* r) {
+  PT_JAC tbl[3];
+  int i;
+
+  tbl[0] = *g;
+  tbl[1] = *q;
+  pt_add(g, q, &tbl[2]);
+  pt_infinity(r);
+  for (i = 255; i >= 0; --i) {
+    int idx = ((u1->a[i >> 5] >> (i & 31)) & 1) |
+              (((u2->a[i >> 5] >> (i & 31)) & 1) << 1);
+
+    pt_dbl(r, r);
+    if (idx) pt_add(r, &tbl[idx - 1], r);
+  }
+}
+
+int fips_p256_ecdsa_verify_sw(const p256_int* key_x, const p256_int* key_y,
+                              const p256_int* message, const p256_int* r,
+                              const p256_int* s) {
+  p256_int w, u1, u2, e, t;
+  PT_JAC g, q, res;
+
+  /* r, s in [1, n-1] */
+  if (fips_p256_is_zero(r) || fips_p256_is_zero(s)) return 0;
+  if (fips_p256_cmp(r, &FIPS_SECP256r1_n) >= 0) return 0;
+  if (fips_p256_cmp(s, &FIPS_SECP256r1_n) >= 0) return 0;
+
+  mont_ctx_init(&mont_p, &p256_prime);
+  mont_ctx_init(&mont_n, &FIPS_SECP256r1_n);
+
+  /* w = s^-1, u1 = e w, u2 = r w (all mod n) */
+  to_mont(&mont_n, s, &w);
+  mont_inv(&mont_n, &w, &w);
+  e = *message;
+  if (fips_p256_cmp(&e, &FIPS_SECP256r1_n) >= 0)
+    p256_sub(&e, &FIPS_SECP256r1_n, &e);
+  to_mont(&mont_n, &e, &t);
+  mont_mul(&mont_n, &t, &w, &u1);
+  from_mont(&mont_n, &u1, &u1);
+  to_mont(&mont_n, r, &t);
+  mont_mul(&mont_n, &t, &w, &u2);
+  from_mont(&mont_n, &u2, &u2);
+
+  /* res = u1 G + u2 Q */
+  to_mont(&mont_p, &p256_Gx, &g.x);
+  to_mont(&mont_p, &p256_Gy, &g.y);
+  to_mont(&mont_p, &p256_one, &g.z);
+  to_mont(&mont_p, key_x, &q.x);
+  to_mont(&mont_p, key_y, &q.y);
+  q.z = g.z;
+  pt_mul2(&u1, &g, &u2, &q, &res);
+  if (fips_p256_is_zero(&res.z)) return 0;
+
+  /* affine x = X / Z^2, then compare against r mod n */
+  mont_inv(&mont_p, &res.z, &t);
+  mont_mul(&mont_p, &t, &t, &t);
+  mont_mul(&mont_p, &res.x, &t, &t);
+  from_mont(&mont_p, &t, &t);
+  if (fips_p256_cmp(&t, &FIPS_SECP256r1_n) >= 0)
+    p256_sub(&t, &FIPS_SECP256r1_n, &t);
+  return fips_p256_cmp(&t, r) == 0;
+}
@@ -12,19 +12,28 @@
 // See the License for the specific language governing permissions and
 // limitations under the License.
 
+#include <string.h>
+
 #include "fips.h"
 #include "p256_ecdsa.h"
 #include "drbg.h"
 #include "dcrypto_syscalls.h"
+#include "kl.h"
+#include "sha256.h"
 #include "trng.h"
 
 #include "console.h"
+#include "tock.h"
 
 /* Firmware blob for crypto accelerator */
 
 /* AUTO-GENERATED.  DO NOT MODIFY. */
 /* clang-format off */
-static uint32_t IMEM_dcrypto_p256[] = {
+/* Kept const in flash (see userspace/layout.ld): the kernel loads it
+ * into engine IMEM straight from this address, so the ~3KB program
+ * never occupies app RAM and is never staged through a copy. */
+static const uint32_t IMEM_dcrypto_p256[]
+    __attribute__((section(".text.dcrypto_imem"), aligned(4))) = {
 /* @0x0: function tag[1] { */
 //#define CF_tag_adr 0
 0xf8000002,	/* sigini #2 */
@@ -79,7 +88,7 @@ static uint32_t IMEM_dcrypto_p256[] = {
 0x0c000000,	/* ret */
 /* } */
 /* @0x2c: function MulMod[38] { */
-//#define CF_MulMod_adr 44
+#define CF_MulMod_adr 44
 0x584f3800,	/* mul128 r19, r24l, r25l */
 0x59d33800,	/* mul128 r20, r24u, r25u */
 0x58d73800,	/* mul128 r21, r24u, r25l */
@@ -147,7 +156,7 @@ static uint32_t IMEM_dcrypto_p256[] = {
 0x0c000000,	/* ret */
 /* } */
 /* @0x6a: function ProjAdd[80] { */
-//#define CF_ProjAdd_adr 106
+#define CF_ProjAdd_adr 106
 0x7c600b00,	/* mov r24, r11 */
 0x7c640800,	/* mov r25, r8 */
 0x0800002c,	/* call &MulMod */
@@ -230,7 +239,7 @@ static uint32_t IMEM_dcrypto_p256[] = {
 0x0c000000,	/* ret */
 /* } */
 /* @0xba: function ProjToAffine[116] { */
-//#define CF_ProjToAffine_adr 186
+#define CF_ProjToAffine_adr 186
 0x9c2bea00,	/* addm r10, r10, r31 */
 0x7c600a00,	/* mov r24, r10 */
 0x7c640a00,	/* mov r25, r10 */
@@ -359,7 +368,7 @@ static uint32_t IMEM_dcrypto_p256[] = {
 0x0c000000,	/* ret */
 /* } */
 /* @0x12e: function ModInv[17] { */
-//#define CF_ModInv_adr 302
+#define CF_ModInv_adr 302
 0x98080000,	/* stmod r2 */
 0x55080202,	/* subi r2, r2, #2 */
 0x7c041e00,	/* mov r1, r30 */
@@ -395,7 +404,7 @@ static uint32_t IMEM_dcrypto_p256[] = {
 0x0c000000,	/* ret */
 /* } */
 /* @0x14a: function ProjDouble[5] { */
-//#define CF_ProjDouble_adr 330
+#define CF_ProjDouble_adr 330
 0x7c2c0800,	/* mov r11, r8 */
 0x7c300900,	/* mov r12, r9 */
 0x7c340a00,	/* mov r13, r10 */
@@ -486,7 +495,7 @@ static uint32_t IMEM_dcrypto_p256[] = {
 0x0c000000,	/* ret */
 /* } */
 /* @0x19b: function get_P256B[35] { */
-//#define CF_get_P256B_adr 411
+#define CF_get_P256B_adr 411
 0x7c201f00,	/* mov r8, r31 */
 0x83a16b17,	/* movi r8.7h, #27415 */
 0x83a0d1f2,	/* movi r8.7l, #53746 */
@@ -782,24 +791,86 @@ typedef struct DMEM_ecc {
 
 static DMEM_ecc pEcc;
 
+static void fips_dcrypto_drain_async(void);
+
 uint32_t fips_dcrypto_call(uint32_t addr) __attribute__((warn_unused_result));
 
+/* p256init materializes the curve constants (p, n Barrett mu, curve b,
+ * one, zero) in wide registers. Those registers persist across calls
+ * while the program stays resident, so the init program only needs to
+ * run again when the program had to be re-uploaded. */
+static int p256_constants_loaded = 0;
+
+/* Set once a call has staged the complete pEcc image into DMEM. While
+ * it holds, repeat signs only need to re-stage the fields they changed
+ * (see fips_dcrypto_sign_call). */
+static int dmem_image_staged = 0;
+
+/* (Re-)loads the p256 program into dcrypto IMEM. Issued before every
+ * engine entry rather than latched: any other process's dcrypto use
+ * evicts the program, and the kernel dedupes the upload by content, so
+ * re-issuing is nearly free while it is still resident. A positive
+ * load return means the upload really ran -- the wide-register
+ * constants and any staged DMEM image went with the old program. */
+static int fips_dcrypto_ensure_program(void) {
+  int ret = tock_dcrypto_load_program_flash(IMEM_dcrypto_p256,
+                                            sizeof(IMEM_dcrypto_p256));
+  if (ret < 0) return -1;
+  if (ret > 0) {
+    p256_constants_loaded = 0;
+    dmem_image_staged = 0;
+  }
+  return 0;
+}
+
 // Note: addr is a word address (index into word array)
 uint32_t fips_dcrypto_call(uint32_t addr) {
-  /*  printf("Invoking dcrypto with data %p len %i, instruction %i stream len %i\n",
-         &pEcc,
-         sizeof(DMEM_ecc),
-         addr,
-         sizeof(IMEM_dcrypto_p256));*/
-  return tock_dcrypto_run(&pEcc,
-                          sizeof(DMEM_ecc),
-                          IMEM_dcrypto_p256,
-                          sizeof(IMEM_dcrypto_p256),
-                          addr
-                          );
+  uint32_t ret;
+  if (fips_dcrypto_ensure_program() != 0) return 1;
+  /* If the load replaced an evicted program, the constants went with
+   * it; restore them before running anything that depends on them. */
+  if (!p256_constants_loaded && addr != CF_p256init_adr) {
+    if (tock_dcrypto_call(&pEcc, sizeof(DMEM_ecc), CF_p256init_adr) != 0)
+      return 1;
+    p256_constants_loaded = 1;
+  }
+  ret = tock_dcrypto_call(&pEcc, sizeof(DMEM_ecc), addr);
+  if (ret == 0) dmem_image_staged = 1;
+  return ret;
+}
+
+/* Run the sign program, staging only its inputs (k, rnd, msg and d)
+ * when DMEM already holds a full pEcc image: the pointer header never
+ * changes after init and r/s/x/y are engine outputs, so between signs
+ * more than half of the staging bytes are identical. Falls back to
+ * full staging on the first call or after a failed partial copy. */
+static uint32_t fips_dcrypto_sign_call(void) {
+  size_t k_off = (const uint8_t *)&pEcc.k - (const uint8_t *)&pEcc;
+  size_t d_off = (const uint8_t *)&pEcc.d - (const uint8_t *)&pEcc;
+
+  if (fips_dcrypto_ensure_program() != 0) return 1;
+  if (!dmem_image_staged) return fips_dcrypto_call(CF_p256sign_adr);
+
+  /* k, rnd and msg are contiguous, so they go in one range. */
+  if (tock_dcrypto_stage(&pEcc, sizeof(DMEM_ecc), k_off,
+                         3 * sizeof(p256_int)) != 0 ||
+      tock_dcrypto_stage(&pEcc, sizeof(DMEM_ecc), d_off,
+                         sizeof(p256_int)) != 0) {
+    /* DMEM contents are unknown after a failed partial copy. */
+    dmem_image_staged = 0;
+    return fips_dcrypto_call(CF_p256sign_adr);
+  }
+  return tock_dcrypto_call_staged(&pEcc, sizeof(DMEM_ecc), CF_p256sign_adr);
 }
 
-static void fips_dcrypto_ecc_init(void) {
+static uint32_t fips_dcrypto_ecc_init(void) {
+  /* An async sign still in flight owns both the engine and the shared
+   * pEcc staging block. Wait for its completion callback (delivered on
+   * yield) before staging new parameters: the caller sleeps until the
+   * engine frees up instead of clobbering the sign's DMEM image or
+   * bouncing off the kernel's busy check. */
+  fips_dcrypto_drain_async();
+
   pEcc.pK = DMEM_INDEX(pEcc, k);
   pEcc.pRnd = DMEM_INDEX(pEcc, rnd);
   pEcc.pMsg = DMEM_INDEX(pEcc, msg);
@@ -818,6 +889,18 @@ static void fips_dcrypto_ecc_init(void) {
   pEcc.x.a[0] = 6;
   pEcc.y.a[0] = 7;
   pEcc.d.a[0] = 8;
+
+  /* Re-issue the program load before consulting the constants latch:
+   * a fresh upload means another process evicted the program and took
+   * the wide-register constants with it. */
+  if (fips_dcrypto_ensure_program() != 0) return 1;
+  if (!p256_constants_loaded) {
+    if (fips_dcrypto_call(CF_p256init_adr) != 0) return 1;
+    p256_constants_loaded = 1;
+  }
+  /* Lazy KAT gate; a no-op once the dcrypto group has run. */
+  if (fips_ensure_kat(FIPS_KAT_ECDSA) != EC_SUCCESS) return 1;
+  return 0;
 }
 
 /* k-generation compliant w/ NIST publication 186-4, Sec. B.5.2
@@ -826,8 +909,7 @@ int fips_p256_ecdsa_sign(DRBG *ctx, const p256_int *key,
                          const p256_int *message, p256_int *r, p256_int *s) {
   int i, result;
 
-  fips_dcrypto_ecc_init();
-  result = fips_dcrypto_call(CF_p256init_adr);
+  result = fips_dcrypto_ecc_init();
 
   // entropy guard
   DRBG_update(ctx, key, sizeof(p256_int), message, sizeof(p256_int), NULL, 0);
@@ -841,7 +923,118 @@ int fips_p256_ecdsa_sign(DRBG *ctx, const p256_int *key,
   pEcc.msg = *message;
   pEcc.d = *key;
 
-  result |= fips_dcrypto_call(CF_p256sign_adr);
+  result |= fips_dcrypto_sign_call();
+
+  *r = pEcc.r;
+  *s = pEcc.s;
+
+  /* Wipe d,k */
+  pEcc.d = pEcc.rnd;
+  pEcc.k = pEcc.rnd;
+
+  return result == 0;
+}
+
+/* In-flight async sign, if any. */
+static struct {
+  p256_ecdsa_sign_cb callback;
+  void *arg;
+  int setup_result;
+} async_sign;
+
+static void fips_p256_ecdsa_sign_done(int error,
+                                      void *user_data __attribute__((unused))) {
+  p256_ecdsa_sign_cb cb = async_sign.callback;
+  void *arg = async_sign.arg;
+  int result = (async_sign.setup_result == 0) && (error == 0);
+
+  async_sign.callback = NULL;
+
+  /* Wipe d,k before surfacing the result. */
+  pEcc.d = pEcc.rnd;
+  pEcc.k = pEcc.rnd;
+
+  if (cb != NULL) cb(result, &pEcc.r, &pEcc.s, arg);
+}
+
+static void fips_dcrypto_drain_async(void) {
+  while (async_sign.callback != NULL) {
+    yield();
+  }
+}
+
+/* Same contract as fips_p256_ecdsa_sign, but the dcrypto run completes
+ * through a callback so the app can keep servicing USB traffic. */
+int fips_p256_ecdsa_sign_async(DRBG *ctx, const p256_int *key,
+                               const p256_int *message,
+                               p256_ecdsa_sign_cb callback, void *arg) {
+  int i, result;
+
+  if (async_sign.callback != NULL) return 0;
+
+  result = fips_dcrypto_ecc_init();
+
+  // entropy guard
+  DRBG_update(ctx, key, sizeof(p256_int), message, sizeof(p256_int), NULL, 0);
+
+  result |= fips_p256_pick(ctx, &pEcc.k, NULL, 0);
+
+  DRBG_exit(ctx);
+
+  for (i = 0; i < 8; ++i) pEcc.rnd.a[i] = fips_rand();
+
+  pEcc.msg = *message;
+  pEcc.d = *key;
+
+  async_sign.callback = callback;
+  async_sign.arg = arg;
+  async_sign.setup_result = result;
+
+  if (tock_dcrypto_call_async(&pEcc, sizeof(DMEM_ecc), CF_p256sign_adr,
+                              fips_p256_ecdsa_sign_done, NULL) != 0) {
+    async_sign.callback = NULL;
+    /* Wipe d,k */
+    pEcc.d = pEcc.rnd;
+    pEcc.k = pEcc.rnd;
+    return 0;
+  }
+
+  return 1;
+}
+
+/* SSH CA signing: derive the signing key over the KL_SEED_SSH ladder
+ * branch and sign message with it, in one call. The scalar is picked
+ * straight into the engine staging block (FIPS-186-4 B.4.2 candidate
+ * testing, same flow as fips_keygen) instead of round-tripping through
+ * a caller buffer, so the only app-memory copy of the key is the
+ * staging block the engine reads anyway, wiped before returning. */
+int fips_p256_ecdsa_sign_ssh(const uint32_t input[8], const p256_int *message,
+                             p256_int *r, p256_int *s) {
+  uint32_t seed[8];
+  DRBG ctx;
+  int i, result;
+
+  result = fips_dcrypto_ecc_init();
+
+  if (kl_derive_ssh(input, seed) != 0) return 0;
+
+  make_drbg1(&ctx);
+
+  result |= fips_p256_pick(&ctx, &pEcc.d, seed, sizeof(seed));
+
+  memset(seed, 0, sizeof(seed));
+
+  /* Per-message k, as in fips_p256_ecdsa_sign. */
+  DRBG_update(&ctx, &pEcc.d, sizeof(p256_int), message, sizeof(p256_int),
+              NULL, 0);
+  result |= fips_p256_pick(&ctx, &pEcc.k, NULL, 0);
+  DRBG_exit(&ctx);
+
+  for (i = 0; i < 8; ++i) pEcc.rnd.a[i] = fips_rand();
+
+  pEcc.msg = *message;
+
+  result |= fips_dcrypto_sign_call();
 
   *r = pEcc.r;
   *s = pEcc.s;
@@ -858,8 +1051,7 @@ int fips_p256_ecdsa_sign(DRBG *ctx, const p256_int *key,
 int fips_p256_base_point_mul(const p256_int *k, p256_int *x, p256_int *y) {
   int i, result;
 
-  fips_dcrypto_ecc_init();
-  result = fips_dcrypto_call(CF_p256init_adr);
+  result = fips_dcrypto_ecc_init();
 
   for (i = 0; i < 8; ++i) pEcc.rnd.a[i] ^= fips_rand();
 
@@ -882,8 +1074,7 @@ int fips_p256_point_mul(const p256_int *k, const p256_int *in_x,
                         const p256_int *in_y, p256_int *x, p256_int *y) {
   int i, result;
 
-  fips_dcrypto_ecc_init();
-  result = fips_dcrypto_call(CF_p256init_adr);
+  result = fips_dcrypto_ecc_init();
 
   for (i = 0; i < 8; ++i) pEcc.rnd.a[i] ^= fips_rand();
 
@@ -904,13 +1095,62 @@ int fips_p256_point_mul(const p256_int *k, const p256_int *in_x,
   return result == 0;
 }
 
+/* P-256 ECDH for the CTAP2 PIN protocol: shared_secret =
+ * SHA-256(x-coordinate of d*Q). The scalar multiply is one dcrypto
+ * invocation of the resident program and the x-coordinate goes through
+ * the hardware SHA engine without leaving this module, so callers only
+ * ever see the derived secret. The peer point must be on the curve --
+ * mandatory for ECDH, where a crafted off-curve point leaks bits of
+ * the private key -- so it is checked first. */
+int fips_p256_ecdh(const p256_int *d, const p256_int *peer_x,
+                   const p256_int *peer_y,
+                   uint8_t shared_secret[SHA256_DIGEST_SIZE]) {
+  uint8_t x_bin[P256_NBYTES];
+  uint32_t digest[SHA256_DIGEST_WORDS];
+  int i, result;
+
+  if (!fips_p256_is_valid_point(peer_x, peer_y)) return 0;
+
+  result = fips_dcrypto_ecc_init();
+
+  for (i = 0; i < 8; ++i) pEcc.rnd.a[i] ^= fips_rand();
+
+  pEcc.k = *d;
+  pEcc.x = *peer_x;
+  pEcc.y = *peer_y;
+
+  result |= fips_dcrypto_call(CF_p256scalarmult_adr);
+
+  fips_p256_to_bin(&pEcc.x, x_bin);
+
+  /* Wipe k,x,y */
+  pEcc.k = pEcc.rnd;
+  pEcc.x = pEcc.rnd;
+  pEcc.y = pEcc.rnd;
+
+  fips_hwSHA256_init();
+  fips_hwSHA256_update(x_bin, sizeof(x_bin));
+  memcpy(shared_secret, fips_hwSHA256_final(digest), SHA256_DIGEST_SIZE);
+
+  memset(x_bin, 0, sizeof(x_bin));
+  memset(digest, 0, sizeof(digest));
+
+  return result == 0;
+}
+
 int fips_p256_ecdsa_verify(const p256_int *key_x, const p256_int *key_y,
                            const p256_int *message, const p256_int *r,
                            const p256_int *s) {
   int i, result;
 
-  fips_dcrypto_ecc_init();
-  result = fips_dcrypto_call(CF_p256init_adr);
+  /* Verify is the one ECC operation with a software implementation
+   * (Montgomery arithmetic, p256.c): when an async sign has the
+   * engine, verify there instead of queueing behind it. */
+  if (tock_dcrypto_busy()) {
+    return fips_p256_ecdsa_verify_sw(key_x, key_y, message, r, s);
+  }
+
+  result = fips_dcrypto_ecc_init();
 
   pEcc.msg = *message;
   pEcc.r = *r;
@@ -925,11 +1165,38 @@ int fips_p256_ecdsa_verify(const p256_int *key_x, const p256_int *key_y,
   return result == 0;
 }
 
+/* Batch variant: the engine setup (IMEM load, curve constants, DMEM
+ * pointer table) is paid once, then each tuple only stages its own
+ * parameters. Every item is checked even after a failure so the cost
+ * is independent of where a bad signature sits in the batch. */
+int fips_p256_ecdsa_verify_batch(const p256_ecdsa_verify_item *items,
+                                 size_t count) {
+  int i, result;
+  size_t n;
+
+  result = fips_dcrypto_ecc_init();
+
+  for (n = 0; n < count; ++n) {
+    const p256_ecdsa_verify_item *item = &items[n];
+
+    pEcc.msg = *item->message;
+    pEcc.r = *item->r;
+    pEcc.s = *item->s;
+    pEcc.x = *item->key_x;
+    pEcc.y = *item->key_y;
+
+    result |= fips_dcrypto_call(CF_p256verify_adr);
+
+    for (i = 0; i < 8; ++i) result |= (pEcc.rnd.a[i] ^ item->r->a[i]);
+  }
+
+  return result == 0;
+}
+
 int fips_p256_is_valid_point(const p256_int *x, const p256_int *y) {
   int i, result;
 
-  fips_dcrypto_ecc_init();
-  result = fips_dcrypto_call(CF_p256init_adr);
+  result = fips_dcrypto_ecc_init();
 
   pEcc.x = *x;
   pEcc.y = *y;
@@ -960,3 +1227,46 @@ int fips_p256_key_from_bytes(p256_int *x, p256_int *y, p256_int *d,
   // Compute public key.
   return fips_p256_base_point_mul(d, x, y);
 }
+
+/*
+ * Routine-level profiling hooks for dcrypto_test's DCRYPTO_PROFILE
+ * mode. The engine has no breakpoint or trace facility reachable from
+ * userspace, so attribution works by timing the internal routines of
+ * the resident program individually: each entry below is called on its
+ * own through fips_dcrypto_call() against the placeholder DMEM image
+ * that fips_dcrypto_ecc_init() stages. The addresses are the #defines
+ * uncommented in the generated listing above; they only move when the
+ * microcode is regenerated, which regenerates this file with them.
+ */
+static const struct {
+  uint32_t adr;
+  const char *name;
+} p256_profile_routines[P256_PROFILE_COUNT] = {
+    [P256_PROFILE_GET_BASE] = {CF_get_P256B_adr, "get_base"},
+    [P256_PROFILE_MULMOD] = {CF_MulMod_adr, "mulmod"},
+    [P256_PROFILE_PROJ_ADD] = {CF_ProjAdd_adr, "proj_add"},
+    [P256_PROFILE_PROJ_DOUBLE] = {CF_ProjDouble_adr, "proj_double"},
+    [P256_PROFILE_MODINV] = {CF_ModInv_adr, "modinv"},
+    [P256_PROFILE_PROJ_TO_AFFINE] = {CF_ProjToAffine_adr, "proj_to_affine"},
+    [P256_PROFILE_BASE_MULT] = {CF_p256scalarbasemult_adr, "base_mult"},
+    [P256_PROFILE_SCALAR_MULT] = {CF_p256scalarmult_adr, "scalar_mult"},
+    [P256_PROFILE_SIGN] = {CF_p256sign_adr, "sign"},
+    [P256_PROFILE_VERIFY] = {CF_p256verify_adr, "verify"},
+};
+
+int fips_p256_profile_init(void) {
+  if (fips_dcrypto_ecc_init() != 0) return 1;
+  /* Pay the first-call full DMEM upload here so profiled calls all
+   * measure the steady state: stage, run, copy back. */
+  return fips_dcrypto_call(CF_get_P256B_adr) != 0;
+}
+
+const char *fips_p256_profile_name(p256_profile_routine routine) {
+  if (routine >= P256_PROFILE_COUNT) return "?";
+  return p256_profile_routines[routine].name;
+}
+
+int fips_p256_profile_call(p256_profile_routine routine) {
+  if (routine >= P256_PROFILE_COUNT) return 1;
+  return fips_dcrypto_call(p256_profile_routines[routine].adr) != 0;
+}
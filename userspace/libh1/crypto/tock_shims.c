@@ -12,6 +12,7 @@
 // See the License for the specific language governing permissions and
 // limitations under the License.
 
+#include "fips.h"
 #include "fips_aes.h"
 #include "sha256.h"
 #include "storage.h"
@@ -19,10 +20,12 @@
 #include "u2f_hid_corp.h"
 
 #include "digest_syscalls.h"
+#include "fmt.h"
 #include "h1_aes_syscalls.h"
 #include "personality_syscalls.h"
 #include "u2f_syscalls.h"
 #include "nvcounter_syscalls.h"
+#include "timestamp_syscalls.h"
 
 #include "tock.h"
 #include "rng.h"
@@ -33,22 +36,71 @@
 static uint32_t current_key[SHA256_DIGEST_WORDS];
 static uint32_t current_digest[SHA256_DIGEST_WORDS];
 
+/* Staging ring allowed to the digest driver once per hash; update
+ * chunks stream through it with one syscall each instead of an
+ * allow()+command() pair per chunk. The size trades syscall count
+ * against RAM: measure it with sha_test's SHA_SWEEP mode and override
+ * per app with CPPFLAGS += -DDIGEST_RING_BYTES=<best chunk>. */
+#ifndef DIGEST_RING_BYTES
+#define DIGEST_RING_BYTES 256
+#endif
+static uint8_t digest_ring[DIGEST_RING_BYTES];
+
+/* Set once an HMAC key context exists kernel-side; repeated MACs with
+ * the same key then start in a single syscall. */
+static int hmac_key_cached = 0;
+
 void fips_hwHMAC256_init(const uint32_t key[SHA256_DIGEST_WORDS]) {
-  for (unsigned int i = 0 ; i < SHA256_DIGEST_WORDS; i++) {
-    current_key[i] = key[i];
+  fips_ensure_kat(FIPS_KAT_DIGEST);
+  if (hmac_key_cached &&
+      memcmp(current_key, key, SHA256_DIGEST_SIZE) == 0) {
+    tock_digest_hmac_ctx_reuse();
+  } else {
+    for (unsigned int i = 0 ; i < SHA256_DIGEST_WORDS; i++) {
+      current_key[i] = key[i];
+    }
+    if (tock_digest_hmac_ctx_create(current_key, SHA256_DIGEST_SIZE) ==
+        TOCK_SUCCESS) {
+      hmac_key_cached = 1;
+    }
   }
-  tock_digest_set_input((void*)current_key, SHA256_DIGEST_SIZE);
-  tock_digest_hash_initialize(DIGEST_MODE_SHA256_HMAC);
+  tock_digest_stream_attach(digest_ring, sizeof(digest_ring));
 }
 
 void fips_hwSHA256_update(const void* data, size_t n) {
-  tock_digest_set_input((void*)data, n);
-  tock_digest_hash_update(n);
+  tock_digest_stream_update(data, n);
+}
+
+/* One-shot HMAC pass: key and message are packed into a single allowed
+ * buffer and the kernel keys the engine, feeds the message and
+ * finalizes in one command. Returns 1 on success, 0 when the message
+ * does not fit or the kernel lacks the command; the caller then takes
+ * the streaming path above. */
+static uint8_t hmac_oneshot_buf[SHA256_DIGEST_SIZE + 256];
+static int hmac_oneshot_supported = 1;
+
+int fips_hwHMAC256_oneshot(const uint32_t key[SHA256_DIGEST_WORDS],
+                           const void* msg, size_t msg_len,
+                           uint32_t output[SHA256_DIGEST_WORDS]) {
+  if (!hmac_oneshot_supported) return 0;
+  if (msg_len > sizeof(hmac_oneshot_buf) - SHA256_DIGEST_SIZE) return 0;
+  fips_ensure_kat(FIPS_KAT_DIGEST);
+  memcpy(hmac_oneshot_buf, key, SHA256_DIGEST_SIZE);
+  memcpy(hmac_oneshot_buf + SHA256_DIGEST_SIZE, msg, msg_len);
+  if (tock_digest_hmac_easy(hmac_oneshot_buf, msg_len,
+                            output, SHA256_DIGEST_SIZE) != TOCK_SUCCESS) {
+    /* Old kernel: remember and stream from now on. */
+    hmac_oneshot_supported = 0;
+    return 0;
+  }
+  return 1;
 }
 
 void fips_hwSHA256_init(void) {
+  fips_ensure_kat(FIPS_KAT_DIGEST);
   tock_digest_hash_initialize(DIGEST_MODE_SHA256);
   tock_digest_set_output(current_digest, SHA256_DIGEST_SIZE);
+  tock_digest_stream_attach(digest_ring, sizeof(digest_ring));
 }
 
 const uint8_t* fips_hwSHA256_final(uint32_t* output) {
@@ -57,6 +109,40 @@ const uint8_t* fips_hwSHA256_final(uint32_t* output) {
   return (uint8_t*)output;
 }
 
+/* Session currently occupying the hardware engine, if any. */
+static fips_sha256_session* hw_session = NULL;
+
+void fips_SHA256_session_init(fips_sha256_session* s) {
+  if (hw_session == NULL) {
+    s->hw = 1;
+    hw_session = s;
+    fips_hwSHA256_init();
+  } else {
+    /* Engine busy with another session: run this one in software. */
+    s->hw = 0;
+    SHA256_init(&s->soft);
+  }
+}
+
+void fips_SHA256_session_update(fips_sha256_session* s, const void* data,
+                                size_t n) {
+  if (s->hw) {
+    fips_hwSHA256_update(data, n);
+  } else {
+    SHA256_update(&s->soft, data, n);
+  }
+}
+
+const uint8_t* fips_SHA256_session_final(fips_sha256_session* s,
+                                         uint32_t out[SHA256_DIGEST_WORDS]) {
+  if (s->hw) {
+    hw_session = NULL;
+    return fips_hwSHA256_final(out);
+  }
+  memcpy(out, SHA256_final(&s->soft), SHA256_DIGEST_SIZE);
+  return (const uint8_t*)out;
+}
+
 static enum AES_encrypt_mode encrypt_mode = AES_ENCRYPT_MODE;
 static enum AES_cipher_mode cipher_mode = AES_CIPHER_MODE_CTR;
 static uint8_t block_len = AES128_BLOCK_CIPHER_KEY_SIZE;
@@ -65,11 +151,12 @@ static const uint8_t* initialization_vector = NULL;
 
 int fips_aes_init(const uint8_t *key, uint32_t key_len, const uint8_t *iv,
                   enum AES_cipher_mode c_mode, enum AES_encrypt_mode e_mode) {
+  fips_ensure_kat(FIPS_KAT_AES);
   if (cipher_mode != AES_CIPHER_MODE_CTR &&
       cipher_mode != AES_CIPHER_MODE_CBC &&
       cipher_mode != AES_CIPHER_MODE_ECB) {
-    printf("fips_aes_init: unsupported cipher mode: %i\n", c_mode);
-    printf("  supports CTR (%i), CBC (%i) and ECB (%i)\n", AES_CIPHER_MODE_CTR, AES_CIPHER_MODE_CBC, AES_CIPHER_MODE_ECB);
+    h1_printf("fips_aes_init: unsupported cipher mode: %i\n", c_mode);
+    h1_printf("  supports CTR (%i), CBC (%i) and ECB (%i)\n", AES_CIPHER_MODE_CTR, AES_CIPHER_MODE_CBC, AES_CIPHER_MODE_ECB);
     return 0;
   }
   encrypt_mode = e_mode;
@@ -84,7 +171,7 @@ int fips_aes_init(const uint8_t *key, uint32_t key_len, const uint8_t *iv,
     tock_aes_set_key(key, key_len);
     block_len = key_len;
   } else {
-    printf("FAIL: aes_init passed a non-standard key length: %lu\n", key_len);
+    h1_printf("FAIL: aes_init passed a non-standard key length: %lu\n", key_len);
     return 0;
   }
   return 1;
@@ -94,7 +181,7 @@ int fips_aes_init(const uint8_t *key, uint32_t key_len, const uint8_t *iv,
 int fips_aes_block(const uint8_t *in, uint8_t *out) {
   if (block_len != AES128_BLOCK_CIPHER_KEY_SIZE &&
       block_len != AES256_BLOCK_CIPHER_KEY_SIZE) {
-    printf("fips_aes_block: invalid block length: %i\n", block_len);
+    h1_printf("fips_aes_block: invalid block length: %i\n", block_len);
     return 0;
   }
   if (cipher_mode == AES_CIPHER_MODE_CTR) {
@@ -126,21 +213,73 @@ int fips_aes_block(const uint8_t *in, uint8_t *out) {
       tock_aes_decrypt_ecb_sync(block_len, out, block_len);
     }
   } else {
-    printf("fips_aes_block: unsupported cipher mode: %i\n", cipher_mode);
+    h1_printf("fips_aes_block: unsupported cipher mode: %i\n", cipher_mode);
     return 0;
   }
   return 1;
 }
 
+/* RAM-mirrored counter: the mirror is authoritative between flushes
+ * and the nvcounter only persists a high-water mark every
+ * `counter_stride` increments, so the common-case increment is a RAM
+ * write. On the first call after boot the mirror recovers to
+ * mark * stride, which is at or above every value handed out before
+ * the reboot. This is the userspace complement to the kernel's own
+ * write coalescing and also covers boards without the nvcounter
+ * driver, where the mirror alone serves the API. */
+static unsigned int counter_mirror;
+static unsigned int counter_ceiling;
+static unsigned int counter_stride = 1;
+static int counter_state;  /* 0 unmounted, 1 nvcounter-backed, -1 RAM only */
+
+void increment_counter_set_stride(unsigned int stride) {
+  counter_stride = stride ? stride : 1;
+}
+
 unsigned int increment_counter(void) {
-  unsigned int counter;
-  return tock_nvcounter_increment(&counter);
+  unsigned int mark;
+
+  if (counter_state == 0) {
+    if (tock_nvcounter_check() >= 0 &&
+        tock_nvcounter_read(&mark) == TOCK_SUCCESS) {
+      counter_mirror = mark * counter_stride;
+      counter_ceiling = counter_mirror;
+      counter_state = 1;
+    } else {
+      counter_state = -1;
+    }
+  }
+  counter_mirror++;
+  if (counter_state == 1 && counter_mirror > counter_ceiling) {
+    /* Raise the persisted mark before handing out a value above the
+     * old one, so a crash can only skip counts, never repeat them. */
+    if (tock_nvcounter_increment(&mark) != TOCK_SUCCESS) {
+      counter_mirror--;
+      return 0;
+    }
+    counter_ceiling = mark * counter_stride;
+  }
+  return counter_mirror;
 }
 
+/* Double-buffered transmit: the caller's frame is copied into the idle
+ * half of the buffer while the previous frame is still on the wire, so
+ * the transport serializes frame N+1 while frame N is in flight. */
+static U2FHID_FRAME tx_frames[2];
+static int tx_frame_next = 0;
+static bool tx_in_flight = false;
+
 int usbu2f_put_frame(const U2FHID_FRAME* frame_p) {
-  //printf("calling tock_u2f_transmit\n");
-  tock_u2f_transmit((void*)frame_p, sizeof(U2FHID_FRAME));
-  //printf("returned from tock_u2f_transmit\n");
+  U2FHID_FRAME* slot = &tx_frames[tx_frame_next];
+
+  memcpy(slot, frame_p, sizeof(U2FHID_FRAME));
+  if (tx_in_flight) tock_u2f_transmit_wait();
+  if (tock_u2f_transmit_start(slot, sizeof(U2FHID_FRAME)) < 0) {
+    tx_in_flight = false;
+    return -1;
+  }
+  tx_in_flight = true;
+  tx_frame_next ^= 1;
   return 0;
 }
 
@@ -172,12 +311,21 @@ void pop_falling_callback(int __attribute__((unused)) arg1,
                           int __attribute__((unused)) arg2,
                           int __attribute__((unused)) arg3,
                           void* __attribute__((unused)) data) {
-  printf("Button pressed (user contact)\n\n");
+  h1_printf("Button pressed (user contact)\n\n");
   tock_pop_set();
 }
 
 
+/* Touch detection is edge-driven: the kernel GPIO interrupt lands in
+ * pop_falling_callback during a yield, which latches the touch along
+ * with a timestamp of the edge. Presence checks are then a plain read
+ * of the latch -- no syscall, no polling -- and a latch older than the
+ * presence window is treated as no touch rather than satisfying a
+ * request seconds later. */
+#define POP_TOUCH_WINDOW_US (10 * 1000 * 1000)
+
 static enum touch_state touch_latch = POP_TOUCH_NO;
+static uint32_t touch_edge_us;
 
 void tock_pop_enable_detection(void) {
   gpio_enable_input(1, PullUp);
@@ -187,14 +335,25 @@ void tock_pop_enable_detection(void) {
 
 void tock_pop_set(void) {
   touch_latch = POP_TOUCH_YES;
+  touch_edge_us = gettimeus();
 }
 
 void tock_pop_clear(void) {
   touch_latch = POP_TOUCH_NO;
 }
 
+uint32_t tock_pop_touch_age_us(void) {
+  if (touch_latch != POP_TOUCH_YES) return 0;
+  return gettimeus() - touch_edge_us;
+}
+
 enum touch_state tock_pop_check_presence(int consume) {
   enum touch_state old = touch_latch;
+  if (old == POP_TOUCH_YES &&
+      gettimeus() - touch_edge_us > POP_TOUCH_WINDOW_US) {
+    tock_pop_clear();
+    return POP_TOUCH_NO;
+  }
   if (consume) {
     tock_pop_clear();
   }
@@ -223,12 +382,15 @@ static uint32_t KL_SEED_ORIGIN[8] = {0x06a7f502, 0x213c40c4, 0x5f3d4f19,
 static uint32_t KL_SEED_SSH[8] = {0x2baf15a8, 0xaa452083, 0x08de59eb,
                                   0x44e5004c, 0x352acdaa, 0xc3ba7d54,
                                   0xc2d77c11, 0x79767216};
+static uint32_t KL_SEED_KHFP[8] = {0x905df673, 0x214902f1, 0x6d5c6530,
+                                   0xfa45ae95, 0x3a4577c0, 0xe78004f3,
+                                   0x2c47c75b, 0x6a8ea9ad};
 
 static int kl_step(uint32_t cert,
                    const uint32_t input[8],
                    uint32_t output[8]) {
   if (tock_digest_busy()) {
-    printf("kl_step: DIGEST BUSY\n");
+    h1_printf("kl_step: DIGEST BUSY\n");
     return TOCK_EBUSY;
   } else {
     int rval = tock_digest_with_cert(cert,
@@ -243,7 +405,9 @@ int kl_init(void) {
   uint32_t salt[8];
   int error = 0;
   size_t i;
-  printf("Initializing keyladder.\n");
+  h1_printf("Initializing keyladder.\n");
+  /* Cached derivations are stale once the ladder is rebuilt. */
+  kl_cache_clear();
   // salt rsr some
   rand_bytes(salt, sizeof(salt));
   //error = error || kl_step(40, salt, NULL);
@@ -278,13 +442,29 @@ int kl_random(void* output) {
   return error;
 }
 
+/* Fused chain for kl_derive: isr2 -> usr0 (cert 35), then hmac (cert
+ * 38), executed kernel-side in one command. The usr0 intermediate
+ * never leaves the kernel, and the two-block staging buffer is static
+ * so its allow is cached across derivations. */
+static const uint8_t KL_DERIVE_CERTS[2] = {35, 38};
+static uint32_t kl_derive_blocks[16]; /* salt || input */
+
 int kl_derive(const uint32_t salt[8] ,
               const uint32_t input[8] ,
               uint32_t output[8]) {
-  int error = 0;
+  int error;
 
-  error = error || kl_step(35, salt, NULL);     // isr2 -> usr0
-  error = error || kl_step(38, input, output);  // hmac
+  if (kl_cache_get(salt, input, output)) return 0;
+
+  if (tock_digest_busy()) {
+    h1_printf("kl_derive: DIGEST BUSY\n");
+    return TOCK_EBUSY;
+  }
+  memcpy(kl_derive_blocks, salt, 32);
+  memcpy(kl_derive_blocks + 8, input, 32);
+  error = tock_digest_cert_chain(KL_DERIVE_CERTS, 2, kl_derive_blocks,
+                                 output, 32);
+  if (!error) kl_cache_put(salt, input, output);
   return error;
 }
 
@@ -308,16 +488,29 @@ int kl_derive_ssh(const uint32_t input[8] ,
   return kl_derive(KL_SEED_SSH, input, output);
 }
 
+int kl_derive_khfp(const uint32_t input[8],
+                   uint32_t output[8]) {
+  return kl_derive(KL_SEED_KHFP, input, output);
+}
+
 static perso_st personality;
+static bool personality_valid = false;
 
 perso_st* get_personality(void) {
-  tock_get_personality(&personality);
+  /* The personality is flash-resident and immutable outside
+   * set_personality(), so one 2KB fetch per boot serves every
+   * attestation; later calls are answered from the cache. */
+  if (!personality_valid &&
+      tock_get_personality(&personality) == TOCK_SUCCESS) {
+    personality_valid = true;
+  }
   return &personality;
 }
 
 int set_personality(const perso_st* id) {
   int rval = tock_set_personality(id);
   if (rval == TOCK_SUCCESS) {
+    personality_valid = false;
     return EC_SUCCESS;
   } else {
     return EC_ERROR_UNKNOWN;
@@ -90,13 +90,55 @@ void fips_trng_startup(void) {
   }
 }
 
+/*
+ * Entropy pipeline. Words are produced in small batches, screened with
+ * the continuous health tests as they come off the TRNG, and parked in
+ * a ring of pre-qualified words. fips_rand() then just pops a word, so
+ * the sign path never pays for a kernel round-trip or a health test as
+ * long as the idle loop keeps the ring topped up. Consumed slots are
+ * wiped so past output cannot be recovered from the pool.
+ */
+#define TRNG_POOL_WORDS 64
+#define TRNG_BATCH_WORDS 8
+
+static uint32_t trng_pool[TRNG_POOL_WORDS];
+static size_t trng_pool_count; /* qualified words available */
+static size_t trng_pool_rd;    /* oldest qualified word */
+
+/* N.B. This function can set the global 'fips_error' variable. */
+static void trng_pool_produce(void) {
+  uint32_t batch[TRNG_BATCH_WORDS];
+  size_t i, n = TRNG_POOL_WORDS - trng_pool_count;
+
+  if (n == 0) return;
+  if (n > TRNG_BATCH_WORDS) n = TRNG_BATCH_WORDS;
+
+  rng_sync((uint8_t *)batch, n * sizeof(uint32_t), n * sizeof(uint32_t));
+  trng_health_screen(batch, n);
+
+  for (i = 0; i < n; i++) {
+    trng_pool[(trng_pool_rd + trng_pool_count + i) % TRNG_POOL_WORDS] =
+        batch[i];
+  }
+  trng_pool_count += n;
+  memset(batch, 0, sizeof(batch));
+}
+
+void fips_trng_top_up(void) {
+  while (trng_pool_count < TRNG_POOL_WORDS) trng_pool_produce();
+}
+
 /* N.B. This function can set the global 'fips_error' variable. */
 uint32_t fips_rand(void) {
-  uint32_t r = raw_rand();
+  uint32_t r;
+
+  /* Only reached when a single request outruns the whole ring. */
+  if (trng_pool_count == 0) trng_pool_produce();
 
-  /* Add sample to continuous health tests */
-  repetition_count_test(r);
-  adaptive_proportion_test(r);
+  r = trng_pool[trng_pool_rd];
+  trng_pool[trng_pool_rd] = 0;
+  trng_pool_rd = (trng_pool_rd + 1) % TRNG_POOL_WORDS;
+  trng_pool_count--;
 
   return r;
 }
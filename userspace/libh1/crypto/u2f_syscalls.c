@@ -0,0 +1,279 @@
+// Copyright 2018 Google LLC
+//
+// Licensed under the Apache License, Version 2.0 (the "License");
+// you may not use this file except in compliance with the License.
+// You may obtain a copy of the License at
+//
+//     https://www.apache.org/licenses/LICENSE-2.0
+//
+// Unless required by applicable law or agreed to in writing, software
+// distributed under the License is distributed on an "AS IS" BASIS,
+// WITHOUT WARRANTIES OR CONDITIONS OF ANY KIND, either express or implied.
+// See the License for the specific language governing permissions and
+// limitations under the License.
+
+#include <tock.h>
+#include "fmt.h"
+#include "u2f_syscalls.h"
+
+#define H1_DRIVER_U2F 0x20008
+
+#define TOCK_U2F_CMD_CHECK    0
+
+#define TOCK_U2F_CMD_TRANSMIT 1
+#define TOCK_U2F_CMD_RECEIVE  2
+#define TOCK_U2F_CMD_RX_COALESCE 3
+#define TOCK_U2F_CMD_TRANSMIT_FRAMES 4
+
+#define TOCK_U2F_ALLOW_TRANSMIT 1
+#define TOCK_U2F_ALLOW_RECEIVE  2
+
+#define TOCK_U2F_SUBSCRIBE_TRANSMIT_DONE 1
+#define TOCK_U2F_SUBSCRIBE_RECEIVE_DONE  2
+#define TOCK_U2F_SUBSCRIBE_RECONNECT     3
+
+int tock_u2f_check(void) {
+  return command(H1_DRIVER_U2F, TOCK_U2F_CMD_CHECK, 0, 0);
+}
+
+static void tock_u2f_transmit_done(int error __attribute__((unused)),
+                                   int fault  __attribute__((unused)),
+                                   int unused __attribute__((unused)),
+                                   void *callback_args) {
+  *(bool*)callback_args = true;
+}
+
+/* Set when no transmit is in flight; cleared by transmit_start and set
+ * again by the completion callback. */
+static bool tx_idle = true;
+
+int tock_u2f_transmit_start(void* data, size_t datalen) {
+  int ret = subscribe(H1_DRIVER_U2F, TOCK_U2F_SUBSCRIBE_TRANSMIT_DONE,
+                      tock_u2f_transmit_done, (void*)&tx_idle);
+
+  if (ret < 0) {
+    h1_printf("Could not register U2F transmit callback with kernel: %d\n", ret);
+    return ret;
+  }
+
+  ret = allow(H1_DRIVER_U2F, TOCK_U2F_ALLOW_TRANSMIT, data, datalen);
+  if (ret < 0) {
+    h1_printf("Could not give kernel access to U2F data: %d\n", ret);
+    return TOCK_EBUSY;
+  }
+
+  tx_idle = false;
+  ret = command(H1_DRIVER_U2F, TOCK_U2F_CMD_TRANSMIT, datalen, 0);
+
+  if (ret < 0) {
+    tx_idle = true;
+    h1_printf("Could not transmit over U2F: %d\n", ret);
+    return ret;
+  }
+
+  return 0;
+}
+
+int tock_u2f_transmit_wait(void) {
+  yield_for(&tx_idle);
+  return 0;
+}
+
+int tock_u2f_transmit(void* data, size_t datalen) {
+  bool tx_done = false;
+  int ret = subscribe(H1_DRIVER_U2F, TOCK_U2F_SUBSCRIBE_TRANSMIT_DONE,
+                      tock_u2f_transmit_done, &tx_done);
+
+  if (ret < 0) {
+    h1_printf("Could not register U2F transmit callback with kernel: %d\n", ret);
+    return ret;
+  }
+
+  ret = allow(H1_DRIVER_U2F, TOCK_U2F_ALLOW_TRANSMIT,
+              data, datalen);
+  if (ret < 0) {
+    // This should only occur if application state is not available,
+    // which means the driver is busy.
+    h1_printf("Could not give kernel access to U2F data: %d\n", ret);
+    return TOCK_EBUSY;
+  }
+
+  ret = command(H1_DRIVER_U2F, TOCK_U2F_CMD_TRANSMIT, datalen, 0);
+
+  if (ret < 0) {
+    h1_printf("Could not transmit over U2F: %d\n", ret);
+    return ret;
+  }
+
+  yield_for(&tx_done);
+
+  return 0;
+}
+
+int tock_u2f_transmit_frames(void* data, size_t nframes) {
+  bool tx_done = false;
+  int ret;
+
+  if (nframes < 1) return TOCK_EINVAL;
+
+  /* Quiesce the single-frame path: a completion still owed to
+   * tock_u2f_transmit_start() would otherwise fire into the callback
+   * registered below and end this transmit early. */
+  tock_u2f_transmit_wait();
+
+  ret = subscribe(H1_DRIVER_U2F, TOCK_U2F_SUBSCRIBE_TRANSMIT_DONE,
+                  tock_u2f_transmit_done, &tx_done);
+  if (ret < 0) {
+    h1_printf("Could not register U2F transmit callback with kernel: %d\n", ret);
+    return ret;
+  }
+
+  ret = allow(H1_DRIVER_U2F, TOCK_U2F_ALLOW_TRANSMIT,
+              data, nframes * TOCK_U2F_FRAME_SIZE);
+  if (ret < 0) {
+    h1_printf("Could not give kernel access to U2F data: %d\n", ret);
+    return TOCK_EBUSY;
+  }
+
+  ret = command(H1_DRIVER_U2F, TOCK_U2F_CMD_TRANSMIT_FRAMES, nframes, 0);
+  if (ret < 0) {
+    h1_printf("Could not transmit frames over U2F: %d\n", ret);
+    return ret;
+  }
+
+  yield_for(&tx_done);
+
+  return 0;
+}
+
+/* Receive ring state. The ring is allowed to the kernel exactly once;
+ * afterwards the kernel fills successive slots on its own and each
+ * callback just accounts for one more frame being available. */
+static uint8_t* rx_ring = NULL;
+static size_t rx_ring_frames = 0;
+static size_t rx_ring_next = 0;
+static volatile uint32_t rx_ring_pending = 0;
+
+static void tock_u2f_ring_received(int slot    __attribute__((unused)),
+                                   int nframes,
+                                   int unused1 __attribute__((unused)),
+                                   void *callback_args __attribute__((unused))) {
+  /* One callback may cover a coalesced batch of consecutive slots. */
+  rx_ring_pending += nframes;
+}
+
+int tock_u2f_receive_ring_setup(void* ring, size_t ringlen) {
+  int ret;
+
+  if (ringlen < 2 * TOCK_U2F_FRAME_SIZE ||
+      (ringlen % TOCK_U2F_FRAME_SIZE) != 0) {
+    return TOCK_EINVAL;
+  }
+
+  ret = subscribe(H1_DRIVER_U2F, TOCK_U2F_SUBSCRIBE_RECEIVE_DONE,
+                  tock_u2f_ring_received, NULL);
+  if (ret < 0) {
+    h1_printf("Could not register U2F ring callback with kernel: %d\n", ret);
+    return ret;
+  }
+
+  ret = allow(H1_DRIVER_U2F, TOCK_U2F_ALLOW_RECEIVE, ring, ringlen);
+  if (ret < 0) {
+    h1_printf("Could not give kernel access to U2F ring: %d\n", ret);
+    return TOCK_EBUSY;
+  }
+
+  rx_ring = ring;
+  rx_ring_frames = ringlen / TOCK_U2F_FRAME_SIZE;
+  rx_ring_next = 0;
+  rx_ring_pending = 0;
+
+  /* Prime reception; the kernel re-arms the endpoint after each frame. */
+  ret = command(H1_DRIVER_U2F, TOCK_U2F_CMD_RECEIVE, ringlen, 0);
+  if (ret < 0) {
+    h1_printf("Could not enable U2F reception: %d\n", ret);
+    return ret;
+  }
+
+  return 0;
+}
+
+int tock_u2f_receive_coalesce(size_t nframes) {
+  return command(H1_DRIVER_U2F, TOCK_U2F_CMD_RX_COALESCE, nframes, 0);
+}
+
+static void (*resume_handler)(void) = NULL;
+
+static void tock_u2f_connection_event(int resumed,
+                                      int unused1 __attribute__((unused)),
+                                      int unused2 __attribute__((unused)),
+                                      void *callback_args __attribute__((unused))) {
+  /* resumed == 1 is a resume from suspend with the kernel's endpoint
+   * and address state kept; 0 is a full reconnect/re-enumeration. */
+  if (resumed && resume_handler != NULL) {
+    resume_handler();
+  }
+}
+
+int tock_u2f_on_resume(void (*handler)(void)) {
+  resume_handler = handler;
+  return subscribe(H1_DRIVER_U2F, TOCK_U2F_SUBSCRIBE_RECONNECT,
+                   tock_u2f_connection_event, NULL);
+}
+
+size_t tock_u2f_frames_pending(void) {
+  return rx_ring_pending;
+}
+
+int tock_u2f_receive_frame(void** frame) {
+  if (rx_ring == NULL) return TOCK_EINVAL;
+
+  while (rx_ring_pending == 0) {
+    yield();
+  }
+
+  *frame = rx_ring + rx_ring_next * TOCK_U2F_FRAME_SIZE;
+  rx_ring_next = (rx_ring_next + 1) % rx_ring_frames;
+  rx_ring_pending--;
+
+  return 0;
+}
+
+static void tock_u2f_receive_done(int error __attribute__((unused)),
+                                  int fault  __attribute__((unused)),
+                                  int unused __attribute__((unused)),
+                                  void *callback_args) {
+  *(bool*)callback_args = true;
+}
+
+int tock_u2f_receive(void* data, size_t datalen) {
+  bool rx_done = false;
+
+  int ret = subscribe(H1_DRIVER_U2F, TOCK_U2F_SUBSCRIBE_RECEIVE_DONE,
+                      tock_u2f_receive_done, &rx_done);
+
+  if (ret < 0) {
+    h1_printf("Could not register U2F receive callback with kernel: %d\n", ret);
+    return ret;
+  }
+
+  ret = allow(H1_DRIVER_U2F, TOCK_U2F_ALLOW_RECEIVE,
+              data, datalen);
+  if (ret < 0) {
+    // This should only occur if application state is not available,
+    // which means the driver is busy.
+    h1_printf("Could not give kernel access to U2F data: %d\n", ret);
+    return TOCK_EBUSY;
+  }
+
+  ret = command(H1_DRIVER_U2F, TOCK_U2F_CMD_RECEIVE, datalen, 0);
+
+  if (ret < 0) {
+    h1_printf("Could not receive over U2F: %d\n", ret);
+    return ret;
+  }
+
+  yield_for(&rx_done);
+
+  return 0;
+}
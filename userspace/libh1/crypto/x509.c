@@ -0,0 +1,271 @@
+// Copyright 2018 Google LLC
+//
+// Licensed under the Apache License, Version 2.0 (the "License");
+// you may not use this file except in compliance with the License.
+// You may obtain a copy of the License at
+//
+//     https://www.apache.org/licenses/LICENSE-2.0
+//
+// Unless required by applicable law or agreed to in writing, software
+// distributed under the License is distributed on an "AS IS" BASIS,
+// WITHOUT WARRANTIES OR CONDITIONS OF ANY KIND, either express or implied.
+// See the License for the specific language governing permissions and
+// limitations under the License.
+
+#include "asn1.h"
+#include "kl.h"
+#include "signed_header.h"
+#include "storage.h"
+#include "system.h"
+#include "u2f_corp.h"
+#include "u2f_hid_corp.h"
+#include "x509.h"
+#include "drbg.h"
+#include "fips.h"
+#include "p256.h"
+#include "sha256.h"
+#include "p256_ecdsa.h"
+
+// Tock
+#include "u2f_syscalls.h"
+
+static void get_serial(p256_int* n) {
+
+  // const struct SignedHeader* ro_hdr =
+  //    (const struct SignedHeader*)get_program_memory_addr(
+  //        system_get_ro_image_copy());
+  uint32_t tmp[8] = {0};
+
+  //tmp[7] = ro_hdr->keyid;
+  tmp[6] = tock_chip_dev_id0();
+  tmp[5] = tock_chip_dev_id1();
+  tmp[4] = (SN_VERSION << 16) | ((tock_chip_category() & 255) << 24);
+
+  PT_FROM_BIN((const uint8_t*)tmp, n);
+}
+
+int individual_keypair(p256_int* d, p256_int* pk_x, p256_int* pk_y,
+                       const uint32_t* salt) {
+  uint8_t buf[32];
+
+  if (salt == NULL) salt = get_personality()->salt;
+
+  /* Incorporate HIK & diversification constant */
+  if (kl_derive_attest(salt, (uint32_t*)buf)) return EC_ERROR_UNKNOWN;
+
+#ifndef CONFIG_FIPS_ATTESTATION_KEYGEN
+  /* Generate legacy attestation key */
+  while (!KEY_FROM_BYTES(pk_x, pk_y, d, buf)) {
+    SHA256(buf, sizeof(buf), buf);
+  }
+#else
+  {
+    /* Generate FIPS compliant attestation key */
+    DRBG ctx;
+
+    make_drbg1(&ctx);
+    fips_keygen(&ctx, d, pk_x, pk_y, buf, sizeof(buf));
+    DRBG_exit(&ctx);
+  }
+#endif
+
+  return EC_SUCCESS;
+}
+
+// CN=<name> as a full X501 name; single-child sequences share one mark
+static void der_CN(DER* der, int unique) {
+  size_t mark = der_mark(der);
+
+  if (unique) {
+    // TODO: add build version info?
+    der_string(der, t_ASCII, BOARD_STRING);
+  } else {
+    der_string(der, t_ASCII, "U2F");
+  }
+  der_object(der, OID(commonName));
+  der_seq(der, t_SEQ, mark);
+  der_seq(der, t_SET, mark);
+  der_seq(der, t_SEQ, mark);
+}
+
+// Cert body (tbsCertificate), emitted back-to-front: the builder
+// prepends, so children of each sequence appear here in reverse order.
+// If pk_mark is non-NULL it receives der_mark() taken right after the
+// public-key point lands, which locates the point in the finished body.
+static void der_cert_body(DER* der, const p256_int* pk_x,
+                          const p256_int* pk_y, int unique,
+                          size_t* pk_mark) {
+  size_t body = der_mark(der);
+  size_t mark, inner;
+  p256_int serial;
+
+  // U2F usb transport indicator extension
+  mark = der_mark(der);
+  der_byte(der, 0x20);  // usb transport
+  der_byte(der, 5);     // 5 zero bits
+  der_seq(der, t_BITS, mark);
+  der_seq(der, t_BYTES, mark);
+  der_object(der, OID(fido_u2f));
+  der_seq(der, t_SEQ, mark);
+  der_seq(der, t_SEQ, mark);
+  der_seq(der, 0xa3, mark);
+
+  // Subject pk
+  mark = der_mark(der);
+  // pk bits
+  der_pub(der, pk_x, pk_y);
+  if (pk_mark != NULL) *pk_mark = der_mark(der);
+  der_byte(der, t_NULL);  // ?
+  der_seq(der, t_BITS, mark);
+  // pk parameters
+  inner = der_mark(der);
+  der_object(der, OID(prime256v1));
+  der_object(der, OID(id_ecPublicKey));
+  der_seq(der, t_SEQ, inner);
+  der_seq(der, t_SEQ, mark);
+
+  // Subject
+  der_CN(der, unique);
+
+  // Expiry
+  mark = der_mark(der);
+  der_string(der, t_TIME, "20991231235959Z");
+  der_string(der, t_TIME, "20000101000000Z");
+  der_seq(der, t_SEQ, mark);
+
+  // Issuer
+  der_CN(der, unique);
+
+  // Signature algo
+  mark = der_mark(der);
+  der_object(der, OID(ecdsa_with_SHA256));
+  der_seq(der, t_SEQ, mark);
+
+  // Serial number
+  if (unique) {
+    get_serial(&serial);
+    der_p256_int(der, &serial);
+  } else {
+    der_int(der, 1);
+  }
+
+  // X509 v3
+  mark = der_mark(der);
+  der_int(der, 2);
+  der_seq(der, 0xa0, mark);
+
+  der_seq(der, t_SEQ, body);
+}
+
+// Body template: the tbsCertificate skeleton depends only on the
+// flavor (unique: board CN and device serial; anonymous: fixed CN and
+// serial 1) -- the only per-call content is the 65-byte public-key
+// point, which sits at a fixed offset. The first generation of a
+// flavor encodes the skeleton through asn1.c and records the point's
+// offset; later generations patch the point in place and re-sign.
+static struct {
+  uint8_t body[MAX_CERT_SIZE];
+  size_t len;    /* 0 while unbuilt */
+  size_t pk_off; /* offset of the 04||X||Y point */
+  int unique;    /* flavor held in body */
+} cert_tmpl;
+
+int generate_cert(const p256_int* d, const p256_int* pk_x, const p256_int* pk_y,
+                  int unique, uint8_t* cert, const int n,
+                  uint32_t* cert_hash) {
+  static uint8_t arena[MAX_CERT_SIZE];
+  DER der;
+  LITE_SHA256_CTX sha_ctx;  // SHA256 output container
+  p256_int h, r, s;
+  DRBG drbg_ctx;
+  fips_sha256_session sha;
+  uint8_t* body;
+  size_t body_len, mark, inner;
+  size_t len, off, chunk;
+
+  if (cert_tmpl.len == 0 || cert_tmpl.unique != unique) {
+    // Build (or rebuild, on a flavor switch) the body template.
+    size_t pk_mark;
+
+    der_start(&der, cert_tmpl.body, sizeof(cert_tmpl.body));
+    der_cert_body(&der, pk_x, pk_y, unique, &pk_mark);
+    if (der.oom) {
+      cert_tmpl.len = 0;
+      return 0;
+    }
+    cert_tmpl.len = der_mark(&der);
+    cert_tmpl.pk_off = cert_tmpl.len - pk_mark;
+    cert_tmpl.unique = unique;
+    memmove(cert_tmpl.body, der.p, cert_tmpl.len);
+  } else {
+    // Patch the public-key point; everything else in the body is
+    // constant for this device and flavor.
+    uint8_t* p = cert_tmpl.body + cert_tmpl.pk_off;
+
+    p[0] = 4;  // uncompressed format
+    PT_TO_BIN(pk_x, p + 1);
+    PT_TO_BIN(pk_y, p + 1 + P256_NBYTES);
+  }
+  body = cert_tmpl.body;
+  body_len = cert_tmpl.len;
+
+  // Sign all of cert body
+  SHA256_INIT(&sha_ctx);
+  SHA256_UPDATE(&sha_ctx, body, body_len);
+  PT_FROM_BIN(SHA256_FINAL(&sha_ctx), &h);
+
+  make_drbg2(&drbg_ctx);
+  if (!ECDSA_SIGN(&drbg_ctx, d, &h, &r, &s)) {
+    return 0;
+  }
+
+  // Now the full cert: X509 signature, then the staged body in front
+  // of it, then the outer header.
+  der_start(&der, arena, sizeof(arena));
+  mark = der_mark(&der);
+  inner = der_mark(&der);
+  der_p256_int(&der, &s);
+  der_p256_int(&der, &r);
+  der_seq(&der, t_SEQ, inner);
+  der_byte(&der, t_NULL);  // ?
+  der_seq(&der, t_BITS, mark);
+  mark = der_mark(&der);
+  der_object(&der, OID(ecdsa_with_SHA256));
+  der_seq(&der, t_SEQ, mark);
+  der_bytes(&der, body, body_len);
+  der_seq(&der, t_SEQ, 0);
+
+  if (cert_hash == NULL) return der_finish(&der, cert, n);
+
+  // Copy-out and hash in one pass: each chunk streams through the
+  // digest session as it lands in the caller's buffer, sparing
+  // provisioning a second full walk over the emitted cert.
+  len = der_mark(&der);
+  if (der.oom || len > (size_t)n) return 0;
+  fips_SHA256_session_init(&sha);
+  for (off = 0; off < len; off += chunk) {
+    chunk = len - off;
+    if (chunk > 256) chunk = 256;
+    memcpy(cert + off, der.p + off, chunk);
+    fips_SHA256_session_update(&sha, cert + off, chunk);
+  }
+  fips_SHA256_session_final(&sha, cert_hash);
+  return len;
+}
+
+int anonymous_cert(const p256_int* d, const p256_int* pk_x,
+                   const p256_int* pk_y, uint8_t* cert, const int n) {
+  return generate_cert(d, pk_x, pk_y, 0, cert, n, NULL);
+}
+
+int individual_cert(uint8_t* cert, const int n) {
+  // Served straight from the cached personality: check_personality()
+  // verified cert against cert_hash at boot, and the only other way a
+  // cert appears is new_personality(), which hashes what it generates.
+  const perso_st* me = get_personality();
+
+  if (me->cert_len > (const unsigned int)n) return 0;
+
+  memcpy(cert, me->cert, me->cert_len);
+  return me->cert_len;
+}
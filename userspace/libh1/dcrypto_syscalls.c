@@ -13,12 +13,20 @@
 // limitations under the License.
 
 #include <tock.h>
+#include "fmt.h"
 #include "dcrypto_syscalls.h"
 
 #define H1_DRIVER_DCRYPTO 0x40004
 
 #define TOCK_DCRYPTO_CMD_CHECK 0
 #define TOCK_DCRYPTO_CMD_RUN   1
+#define TOCK_DCRYPTO_CMD_LOAD  2
+#define TOCK_DCRYPTO_CMD_CALL  3
+#define TOCK_DCRYPTO_CMD_STAGE 4
+#define TOCK_DCRYPTO_CMD_CALL_STAGED 5
+#define TOCK_DCRYPTO_CMD_LOAD_FLASH 6
+#define TOCK_DCRYPTO_CMD_RUN_SEGMENT 7
+#define TOCK_DCRYPTO_CMD_END_SEGMENTS 8
 
 #define TOCK_DCRYPTO_ALLOW_DATA 0
 #define TOCK_DCRYPTO_ALLOW_PROG 1
@@ -84,7 +92,7 @@ int tock_dcrypto_run(void* data, size_t datalen,
   ret = subscribe(H1_DRIVER_DCRYPTO, TOCK_DCRYPTO_RUN_DONE,
                   tock_dcrypto_run_done, &run_done);
   if (ret < 0) {
-    printf("Could not register dcrypto callback with kernel: %d\n", ret);
+    h1_printf("Could not register dcrypto callback with kernel: %d\n", ret);
     return ret;
   }
 
@@ -93,7 +101,7 @@ int tock_dcrypto_run(void* data, size_t datalen,
   if (ret < 0) {
     // This should only occur if application state is not available,
     // which means the driver is busy.
-    printf("Could not give kernel access to dcrypto data: %d\n", ret);
+    h1_printf("Could not give kernel access to dcrypto data: %d\n", ret);
     return TOCK_EBUSY;
   }
 
@@ -102,21 +110,268 @@ int tock_dcrypto_run(void* data, size_t datalen,
   if (ret < 0) {
     // This should only occur if application state is not available,
     // which means the driver is busy.
-    printf("Could not give kernel access to dcrypto program: %d\n", ret);
+    h1_printf("Could not give kernel access to dcrypto program: %d\n", ret);
     return TOCK_EBUSY;
   }
 
   ret = command(H1_DRIVER_DCRYPTO, TOCK_DCRYPTO_CMD_RUN, start_instruction, 0);
 
   if (ret < 0) {
-    printf("Could not invoke dcrypto program instruction %i rcode: %d\n", start_instruction, ret);
+    h1_printf("Could not invoke dcrypto program instruction %i rcode: %d\n", start_instruction, ret);
     return ret;
   }
 
   yield_for(&run_done);
 
   if (last_error != 0) {
-    printf("\nDCRYPTO failed: %s (%i).\n", tock_dcrypto_fault_to_str(last_fault), last_fault);
+    h1_printf("\nDCRYPTO failed: %s (%i).\n", tock_dcrypto_fault_to_str(last_fault), last_fault);
+    return last_fault;
+  } else {
+    return 0;
+  }
+}
+
+/* Outstanding async call, if any. */
+static tock_dcrypto_callback async_callback = NULL;
+static void* async_user_data = NULL;
+
+static void tock_dcrypto_call_async_done(int error,
+                                         int fault,
+                                         int unused __attribute__((unused)),
+                                         void *callback_args
+                                             __attribute__((unused))) {
+  tock_dcrypto_callback cb = async_callback;
+  void* user_data = async_user_data;
+
+  last_error = error;
+  last_fault = fault;
+  async_callback = NULL;
+  async_user_data = NULL;
+  if (error != 0) {
+    h1_printf("\nDCRYPTO failed: %s (%i).\n",
+           tock_dcrypto_fault_to_str(fault), fault);
+  }
+  if (cb != NULL) cb(error == 0 ? 0 : fault, user_data);
+}
+
+int tock_dcrypto_call_async(void* data, size_t datalen,
+                            size_t start_instruction,
+                            tock_dcrypto_callback callback,
+                            void* user_data) {
+  int ret;
+
+  if (async_callback != NULL) return TOCK_EBUSY;
+
+  ret = subscribe(H1_DRIVER_DCRYPTO, TOCK_DCRYPTO_RUN_DONE,
+                  tock_dcrypto_call_async_done, NULL);
+  if (ret < 0) {
+    h1_printf("Could not register dcrypto callback with kernel: %d\n", ret);
+    return ret;
+  }
+
+  ret = allow(H1_DRIVER_DCRYPTO, TOCK_DCRYPTO_ALLOW_DATA,
+              data, datalen);
+  if (ret < 0) {
+    h1_printf("Could not give kernel access to dcrypto data: %d\n", ret);
+    return TOCK_EBUSY;
+  }
+
+  async_callback = callback;
+  async_user_data = user_data;
+
+  ret = command(H1_DRIVER_DCRYPTO, TOCK_DCRYPTO_CMD_CALL,
+                start_instruction, 0);
+  if (ret < 0) {
+    h1_printf("Could not invoke dcrypto program instruction %i rcode: %d\n",
+           start_instruction, ret);
+    async_callback = NULL;
+    async_user_data = NULL;
+    return ret;
+  }
+
+  return 0;
+}
+
+int tock_dcrypto_busy(void) {
+  return async_callback != NULL;
+}
+
+int tock_dcrypto_load_program(void* program, size_t programlen) {
+  int ret = allow(H1_DRIVER_DCRYPTO, TOCK_DCRYPTO_ALLOW_PROG,
+                  program, programlen);
+  if (ret < 0) {
+    h1_printf("Could not give kernel access to dcrypto program: %d\n", ret);
+    return TOCK_EBUSY;
+  }
+
+  // The IMEM upload is synchronous; no callback is involved.
+  ret = command(H1_DRIVER_DCRYPTO, TOCK_DCRYPTO_CMD_LOAD, 0, 0);
+  if (ret < 0) {
+    h1_printf("Could not load dcrypto program, rcode: %d\n", ret);
+  }
+  return ret;
+}
+
+int tock_dcrypto_load_program_flash(const void* program, size_t programlen) {
+  // No allow: the kernel reads the program in place from its flash
+  // address, so there is no app RAM staging buffer to share.
+  int ret = command(H1_DRIVER_DCRYPTO, TOCK_DCRYPTO_CMD_LOAD_FLASH,
+                    (size_t)program, programlen);
+  if (ret < 0) {
+    h1_printf("Could not load dcrypto program from flash, rcode: %d\n", ret);
+  }
+  return ret;
+}
+
+int tock_dcrypto_stage(void* data, size_t datalen,
+                       size_t offset, size_t length) {
+  int ret;
+
+  // Whole words only, and the packed command argument carries 16 bits
+  // each of word offset and word count.
+  if ((offset % 4) != 0 || (length % 4) != 0 ||
+      offset + length > datalen || (datalen / 4) > 0xffff) {
+    return TOCK_EINVAL;
+  }
+
+  ret = allow(H1_DRIVER_DCRYPTO, TOCK_DCRYPTO_ALLOW_DATA,
+              data, datalen);
+  if (ret < 0) {
+    h1_printf("Could not give kernel access to dcrypto data: %d\n", ret);
+    return TOCK_EBUSY;
+  }
+
+  // The copy is synchronous; no callback is involved.
+  ret = command(H1_DRIVER_DCRYPTO, TOCK_DCRYPTO_CMD_STAGE,
+                ((offset / 4) << 16) | (length / 4), 0);
+  if (ret < 0) {
+    h1_printf("Could not stage dcrypto data range, rcode: %d\n", ret);
+  }
+  return ret;
+}
+
+int tock_dcrypto_call_staged(void* data, size_t datalen,
+                             size_t start_instruction) {
+  int ret = -1;
+  bool run_done = false;
+
+  ret = subscribe(H1_DRIVER_DCRYPTO, TOCK_DCRYPTO_RUN_DONE,
+                  tock_dcrypto_run_done, &run_done);
+  if (ret < 0) {
+    h1_printf("Could not register dcrypto callback with kernel: %d\n", ret);
+    return ret;
+  }
+
+  // The data buffer must stay allowed: results are read back into it
+  // when the program completes, even though nothing is staged here.
+  ret = allow(H1_DRIVER_DCRYPTO, TOCK_DCRYPTO_ALLOW_DATA,
+              data, datalen);
+  if (ret < 0) {
+    h1_printf("Could not give kernel access to dcrypto data: %d\n", ret);
+    return TOCK_EBUSY;
+  }
+
+  ret = command(H1_DRIVER_DCRYPTO, TOCK_DCRYPTO_CMD_CALL_STAGED,
+                start_instruction, 0);
+  if (ret < 0) {
+    h1_printf("Could not invoke dcrypto program instruction %i rcode: %d\n",
+           start_instruction, ret);
+    return ret;
+  }
+
+  yield_for(&run_done);
+
+  if (last_error != 0) {
+    h1_printf("\nDCRYPTO failed: %s (%i).\n", tock_dcrypto_fault_to_str(last_fault), last_fault);
+    return last_fault;
+  } else {
+    return 0;
+  }
+}
+
+int tock_dcrypto_run_segment(void* data, size_t datalen,
+                             void* program, size_t programlen,
+                             size_t start_instruction,
+                             size_t checkpoint_words) {
+  int ret = -1;
+  bool run_done = false;
+
+  ret = subscribe(H1_DRIVER_DCRYPTO, TOCK_DCRYPTO_RUN_DONE,
+                  tock_dcrypto_run_done, &run_done);
+  if (ret < 0) {
+    h1_printf("Could not register dcrypto callback with kernel: %d\n", ret);
+    return ret;
+  }
+
+  ret = allow(H1_DRIVER_DCRYPTO, TOCK_DCRYPTO_ALLOW_DATA,
+              data, datalen);
+  if (ret < 0) {
+    h1_printf("Could not give kernel access to dcrypto data: %d\n", ret);
+    return TOCK_EBUSY;
+  }
+
+  // The program must stay allowed for the whole session: the kernel
+  // reloads it from here if a preempting program evicted it from IMEM.
+  ret = allow(H1_DRIVER_DCRYPTO, TOCK_DCRYPTO_ALLOW_PROG,
+              program, programlen);
+  if (ret < 0) {
+    h1_printf("Could not give kernel access to dcrypto program: %d\n", ret);
+    return TOCK_EBUSY;
+  }
+
+  ret = command(H1_DRIVER_DCRYPTO, TOCK_DCRYPTO_CMD_RUN_SEGMENT,
+                start_instruction, checkpoint_words);
+  if (ret < 0) {
+    h1_printf("Could not invoke dcrypto segment instruction %i rcode: %d\n",
+           start_instruction, ret);
+    return ret;
+  }
+
+  yield_for(&run_done);
+
+  if (last_error != 0) {
+    h1_printf("\nDCRYPTO failed: %s (%i).\n", tock_dcrypto_fault_to_str(last_fault), last_fault);
+    return last_fault;
+  } else {
+    return 0;
+  }
+}
+
+int tock_dcrypto_end_segments(void) {
+  return command(H1_DRIVER_DCRYPTO, TOCK_DCRYPTO_CMD_END_SEGMENTS, 0, 0);
+}
+
+int tock_dcrypto_call(void* data, size_t datalen,
+                      size_t start_instruction) {
+  int ret = -1;
+  bool run_done = false;
+
+  ret = subscribe(H1_DRIVER_DCRYPTO, TOCK_DCRYPTO_RUN_DONE,
+                  tock_dcrypto_run_done, &run_done);
+  if (ret < 0) {
+    h1_printf("Could not register dcrypto callback with kernel: %d\n", ret);
+    return ret;
+  }
+
+  ret = allow(H1_DRIVER_DCRYPTO, TOCK_DCRYPTO_ALLOW_DATA,
+              data, datalen);
+  if (ret < 0) {
+    h1_printf("Could not give kernel access to dcrypto data: %d\n", ret);
+    return TOCK_EBUSY;
+  }
+
+  ret = command(H1_DRIVER_DCRYPTO, TOCK_DCRYPTO_CMD_CALL,
+                start_instruction, 0);
+  if (ret < 0) {
+    h1_printf("Could not invoke dcrypto program instruction %i rcode: %d\n",
+           start_instruction, ret);
+    return ret;
+  }
+
+  yield_for(&run_done);
+
+  if (last_error != 0) {
+    h1_printf("\nDCRYPTO failed: %s (%i).\n", tock_dcrypto_fault_to_str(last_fault), last_fault);
     return last_fault;
   } else {
     return 0;
@@ -33,4 +33,79 @@ int tock_dcrypto_run(void* data, size_t datalen,
                      void* program, size_t programlen,
                      size_t instruction);
 
+// Load a program into dcrypto instruction memory without running it.
+// The program stays resident across tock_dcrypto_call() invocations,
+// so a caller that runs the same program many times pays the IMEM
+// upload cost only once -- but any other process's dcrypto use evicts
+// it, so loads must be re-issued before every call rather than
+// latched. Returns 0 when the program was already resident (engine
+// register and DMEM state from this process's earlier calls
+// survives), 1 when it was freshly uploaded (that state is gone), or
+// a negative error. Length semantics match tock_dcrypto_run.
+int tock_dcrypto_load_program(void* program, size_t programlen);
+
+// Like tock_dcrypto_load_program, but for a program that lives in
+// flash (a const array). The kernel copies it into IMEM straight from
+// its flash address, so the program needs no staging buffer in app RAM.
+// program must be word aligned and programlen a multiple of 4.
+int tock_dcrypto_load_program_flash(const void* program, size_t programlen);
+
+// Run the previously loaded program at the given start instruction,
+// staging data in and out of data memory. Length semantics match
+// tock_dcrypto_run.
+int tock_dcrypto_call(void* data, size_t datalen, size_t instruction);
+
+// Copy only the byte range [offset, offset + length) of data into the
+// corresponding offset of data memory, leaving the rest of DMEM as the
+// last call staged it. offset and length must be multiples of 4.
+// Callers that change only a few fields of a large staging structure
+// between runs can stage just those fields and then start the program
+// with tock_dcrypto_call_staged.
+int tock_dcrypto_stage(void* data, size_t datalen,
+                       size_t offset, size_t length);
+
+// Like tock_dcrypto_call, but does not stage data memory: DMEM holds
+// whatever a previous call or tock_dcrypto_stage left there. Results
+// are still read back into data when the program completes.
+int tock_dcrypto_call_staged(void* data, size_t datalen,
+                             size_t instruction);
+
+// Run one segment of a long operation (an RSA modexp, a batch verify)
+// that yields the engine at segment boundaries. The first segment
+// stages data and program like tock_dcrypto_run; between segments the
+// kernel may run a queued request from another app (a U2F sign jumps
+// the queue), checkpointing this session's DMEM around it and
+// restoring it before the next segment. The operation's impact on
+// other users' latency is thus bounded by one segment, so split long
+// programs where a few milliseconds of intermediate state is cheap to
+// keep. checkpoint_words is how many DMEM words the kernel preserves
+// across yields (0 keeps the previous value, defaulting to the data
+// buffer size); smaller working sets make yields cheaper. Call
+// tock_dcrypto_end_segments when the operation finishes.
+int tock_dcrypto_run_segment(void* data, size_t datalen,
+                             void* program, size_t programlen,
+                             size_t instruction,
+                             size_t checkpoint_words);
+
+// Ends a segment session started by tock_dcrypto_run_segment,
+// releasing the engine's checkpoint reservation for other long
+// operations.
+int tock_dcrypto_end_segments(void);
+
+// Completion handler for tock_dcrypto_call_async. error is 0 on
+// success, otherwise the dcrypto fault code.
+typedef void (*tock_dcrypto_callback)(int error, void* user_data);
+
+// Start the previously loaded program at the given instruction and
+// return without waiting. The callback fires from a later yield() once
+// the engine finishes and the data buffer has been copied back, so the
+// app can keep servicing other events while dcrypto works. Only one
+// async call may be outstanding at a time.
+int tock_dcrypto_call_async(void* data, size_t datalen, size_t instruction,
+                            tock_dcrypto_callback callback, void* user_data);
+
+// Nonzero while an async dcrypto call is outstanding, so callers with
+// a software alternative can take it instead of queueing on the engine.
+int tock_dcrypto_busy(void);
+
 #endif
@@ -12,8 +12,11 @@
 // See the License for the specific language governing permissions and
 // limitations under the License.
 
+#include <string.h>
+
 #include "digest_syscalls.h"
 #include "tock.h"
+#include "trace.h"
 
 // TODO These need to be standardized
 #define H1_DRIVER_DIGEST 0x40003
@@ -25,27 +28,89 @@
 #define TOCK_DIGEST_CMD_FINALIZE   3
 #define TOCK_DIGEST_CMD_BUSY       4
 #define TOCK_DIGEST_CMD_CERT_INIT  5
+#define TOCK_DIGEST_CMD_HMAC_REINIT 6
+#define TOCK_DIGEST_CMD_HMAC_ONESHOT 7
+#define TOCK_DIGEST_CMD_FINALIZE_ASYNC 8
+#define TOCK_DIGEST_CMD_CERT_CHAIN 9
 
 // allow() type ids
 #define TOCK_DIGEST_ALLOW_INPUT    0
 #define TOCK_DIGEST_ALLOW_OUTPUT   1
 
+// subscribe() type ids
+#define TOCK_DIGEST_SUB_DONE       0
+
+/* Buffers currently allowed to the kernel. Nothing else revokes a
+ * digest allow, so re-allowing the same buffer is a no-op the shim can
+ * skip; callers that flip between the same buffers (the DRBG's HMAC
+ * passes in particular) then pay one command per operation. */
+static void* cur_input = NULL;
+static size_t cur_input_len = 0;
+static void* cur_output = NULL;
+static size_t cur_output_len = 0;
+
 int tock_digest_set_input(void* buf, size_t len) {
-  int rval = allow(H1_DRIVER_DIGEST, TOCK_DIGEST_ALLOW_INPUT, buf, len);
-  if (rval != TOCK_SUCCESS){
-    printf("Digest set input returned error %i\n", rval);
+  int rval;
+  if (buf == cur_input && len == cur_input_len) return TOCK_SUCCESS;
+  rval = allow(H1_DRIVER_DIGEST, TOCK_DIGEST_ALLOW_INPUT, buf, len);
+  if (rval != TOCK_SUCCESS) {
+    TRACE_ERR(TRACE_DIGEST_SET_INPUT, rval, len);
+    return rval;
   }
+  cur_input = buf;
+  cur_input_len = len;
   return rval;
 }
 
 int tock_digest_set_output(void* buf, size_t len) {
-  int rval = allow(H1_DRIVER_DIGEST, TOCK_DIGEST_ALLOW_OUTPUT, buf, len);
-  if (rval != TOCK_SUCCESS){
-    printf("Digest set output returned error %i\n", rval);
+  int rval;
+  if (buf == cur_output && len == cur_output_len) return TOCK_SUCCESS;
+  rval = allow(H1_DRIVER_DIGEST, TOCK_DIGEST_ALLOW_OUTPUT, buf, len);
+  if (rval != TOCK_SUCCESS) {
+    TRACE_ERR(TRACE_DIGEST_SET_OUTPUT, rval, len);
+    return rval;
+  }
+  cur_output = buf;
+  cur_output_len = len;
+  return rval;
+}
+
+/* Staging ring for the streaming interface. */
+static uint8_t* stream_ring = NULL;
+static size_t stream_ring_len = 0;
+
+int tock_digest_stream_attach(void* ring, size_t ringlen) {
+  int rval = tock_digest_set_input(ring, ringlen);
+  if (rval != TOCK_SUCCESS) {
+    TRACE_ERR(TRACE_DIGEST_STREAM_ATTACH, rval, ringlen);
+    return rval;
   }
+  stream_ring = ring;
+  stream_ring_len = ringlen;
   return rval;
 }
 
+int tock_digest_stream_update(const void* data, size_t len) {
+  const uint8_t* p = data;
+
+  if (stream_ring == NULL) return TOCK_EINVAL;
+
+  while (len > 0) {
+    size_t n = len > stream_ring_len ? stream_ring_len : len;
+    int rval;
+
+    memcpy(stream_ring, p, n);
+    rval = command(H1_DRIVER_DIGEST, TOCK_DIGEST_CMD_UPDATE, n, 0);
+    if (rval < 0) {
+      TRACE_ERR(TRACE_DIGEST_STREAM_UPDATE, rval, n);
+      return rval;
+    }
+    p += n;
+    len -= n;
+  }
+  return TOCK_SUCCESS;
+}
+
 int tock_digest_check(void) {
   return command(H1_DRIVER_DIGEST, TOCK_DIGEST_CMD_CHECK, 0, 0);
 }
@@ -58,12 +123,60 @@ int tock_digest_cert_initialize(uint32_t cert) {
   return command(H1_DRIVER_DIGEST, TOCK_DIGEST_CMD_CERT_INIT, cert, 0);
 }
 
+int tock_digest_hmac_ctx_create(const void* key, size_t keylen) {
+  int rval = tock_digest_set_input((void*)key, keylen);
+  if (rval != TOCK_SUCCESS) return rval;
+  return tock_digest_hash_initialize(DIGEST_MODE_SHA256_HMAC);
+}
+
+int tock_digest_hmac_ctx_reuse(void) {
+  return command(H1_DRIVER_DIGEST, TOCK_DIGEST_CMD_HMAC_REINIT, 0, 0);
+}
+
+int tock_digest_hmac_easy(void* keymsg, size_t msglen,
+                          void* output, size_t output_len) {
+  int rval = tock_digest_set_input(keymsg, 32 + msglen);
+  if (rval != TOCK_SUCCESS) return rval; /* traced by set_input */
+  rval = tock_digest_set_output(output, output_len);
+  if (rval != TOCK_SUCCESS) return rval; /* traced by set_output */
+  return command(H1_DRIVER_DIGEST, TOCK_DIGEST_CMD_HMAC_ONESHOT, msglen, 0);
+}
+
 int tock_digest_hash_update(size_t n) {
   return command(H1_DRIVER_DIGEST, TOCK_DIGEST_CMD_UPDATE, n, 0);
 }
 
+/* Completion state of an interrupt-driven finalize. */
+struct digest_done {
+  bool fired;
+  int result;
+};
+
+static void tock_digest_done(int result,
+                             int len __attribute__((unused)),
+                             int unused __attribute__((unused)),
+                             void* callback_args) {
+  struct digest_done* done = callback_args;
+  done->result = result;
+  done->fired = true;
+}
+
 int tock_digest_hash_finalize(void) {
-  return command(H1_DRIVER_DIGEST, TOCK_DIGEST_CMD_FINALIZE, 0, 0);
+  struct digest_done done = { false, TOCK_FAIL };
+  int ret;
+
+  /* Interrupt-driven: the kernel starts the engine and returns, the
+   * digest is read out and the callback fired from the done interrupt.
+   * The CPU yields instead of spinning while the engine drains. */
+  ret = subscribe(H1_DRIVER_DIGEST, TOCK_DIGEST_SUB_DONE,
+                  tock_digest_done, &done);
+  if (ret < 0) return ret;
+
+  ret = command(H1_DRIVER_DIGEST, TOCK_DIGEST_CMD_FINALIZE_ASYNC, 0, 0);
+  if (ret < 0) return ret;
+
+  yield_for(&done.fired);
+  return done.result;
 }
 
 int tock_digest_busy(void) {
@@ -74,28 +187,22 @@ int tock_digest_hash_easy(void* input_buf, size_t input_len,
                           void* output_buf, size_t output_len, TockDigestMode mode) {
   int err = -1;
   err = tock_digest_set_input(input_buf, input_len);
-  if (err < 0) {
-    printf("Digest: error %i on hash_easy set_input\n", err);
-    return err;
-  }
+  if (err < 0) return err; /* traced by set_input */
   err = tock_digest_set_output(output_buf, output_len);
-  if (err < 0) {
-    printf("Digest: error %i on hash_easy set_output\n", err);
-    return err;
-  }
+  if (err < 0) return err; /* traced by set_output */
   err = tock_digest_hash_initialize(mode);
   if (err < 0) {
-    printf("Digest: error %i on hash_easy initialize\n", err);
+    TRACE_ERR(TRACE_DIGEST_INITIALIZE, err, mode);
     return err;
   }
   err = tock_digest_hash_update(input_len);
   if (err < 0) {
-    printf("Digest: error %i on hash_easy update\n", err);
+    TRACE_ERR(TRACE_DIGEST_UPDATE, err, input_len);
     return err;
   }
   err = tock_digest_hash_finalize();
   if (err < 0) {
-    printf("Digest: error %i on hash_easy finalize\n", err);
+    TRACE_ERR(TRACE_DIGEST_FINALIZE, err, 0);
   }
   return err;
 }
@@ -105,32 +212,47 @@ int tock_digest_with_cert(uint32_t cert,
                           void* output_buf, size_t output_len) {
   int err = -1;
   err = tock_digest_set_input(input_buf, input_len);
-  if (err < 0) {
-    printf("Digest with cert: error %i on set_input\n", err);
-    return err;
-  }
+  if (err < 0) return err; /* traced by set_input */
   err = tock_digest_set_output(output_buf, output_len);
-  if (err < 0) {
-    printf("Digest with cert: error %i on set_output\n", err);
-    return err;
-  }
+  if (err < 0) return err; /* traced by set_output */
 
   err = tock_digest_cert_initialize(cert);
   if (err < 0) {
-    printf("Digest with cert: error %i on initialize\n", err);
+    TRACE_ERR(TRACE_DIGEST_INITIALIZE, err, cert);
     return err;
   }
   if (input_buf != NULL) {
     err = tock_digest_hash_update(input_len);
     if (err < 0) {
-      printf("Digest with cert: error %i on update\n", err);
+      TRACE_ERR(TRACE_DIGEST_UPDATE, err, input_len);
       return err;
     }
     err = tock_digest_hash_finalize();
     if (err < 0) {
-      printf("Digest with cert: error %i on finalize\n", err);
+      TRACE_ERR(TRACE_DIGEST_FINALIZE, err, cert);
     }
   }
 
   return err;
 }
+
+int tock_digest_cert_chain(const uint8_t* certs, size_t nsteps,
+                           void* blocks, void* output, size_t output_len) {
+  uint32_t packed = 0;
+  size_t i;
+  int err;
+
+  if (nsteps == 0 || nsteps > 4) return TOCK_EINVAL;
+  for (i = 0; i < nsteps; i++) packed |= (uint32_t)certs[i] << (8 * i);
+
+  err = tock_digest_set_input(blocks, 32 * nsteps);
+  if (err < 0) return err; /* traced by set_input */
+  err = tock_digest_set_output(output, output_len);
+  if (err < 0) return err; /* traced by set_output */
+
+  err = command(H1_DRIVER_DIGEST, TOCK_DIGEST_CMD_CERT_CHAIN, packed, nsteps);
+  if (err < 0) {
+    TRACE_ERR(TRACE_DIGEST_FINALIZE, err, packed);
+  }
+  return err;
+}
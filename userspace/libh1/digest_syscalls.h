@@ -39,6 +39,29 @@ int tock_digest_hash_finalize(void);
 // Return if the hash engine is busy
 int tock_digest_busy(void);
 
+// Streaming interface: attach a staging ring that is allowed to the
+// kernel once for the lifetime of the hash, so each update costs a
+// single command() syscall instead of an allow()+command() pair per
+// chunk. Chunks larger than the ring are fed through it in ring-sized
+// pieces. The engine feeds its FIFO synchronously, so the ring is a
+// bounce buffer, not a DMA target.
+int tock_digest_stream_attach(void* ring, size_t ringlen);
+int tock_digest_stream_update(const void* data, size_t len);
+
+// Keyed-context interface: create loads the key and starts a keyed
+// hash; the kernel caches the key, so a later reuse starts another MAC
+// with the same key in a single syscall without re-allowing the key
+// buffer. keylen must be >= 32.
+int tock_digest_hmac_ctx_create(const void* key, size_t keylen);
+int tock_digest_hmac_ctx_reuse(void);
+
+// One-shot keyed hash: keymsg holds the key (32 bytes) followed by the
+// message. The kernel keys the engine, feeds the message and finalizes
+// in a single command, so a full HMAC pass costs one syscall once the
+// buffers are allowed (allows of unchanged buffers are skipped).
+int tock_digest_hmac_easy(void* keymsg, size_t msglen,
+                          void* output, size_t output_len);
+
 int tock_digest_hash_easy(void* input_buf, size_t input_len,
                           void* output_buf, size_t output_len,
                           TockDigestMode mode);
@@ -56,4 +79,13 @@ int tock_digest_with_cert(uint32_t cert,
                           void* input_buf, size_t input_len,
                           void* output_buf, size_t output_len);
 
+// Fused certificate chain: runs nsteps (1..4) certificate digests
+// back to back entirely kernel-side. blocks holds one 32-byte input
+// per step; certs one certificate number (0..255) per step. Only the
+// final step's digest is read out, into output (or kept hidden when
+// output is NULL); intermediates never leave the kernel. One command
+// syscall replaces the per-step init/update/finalize round-trips.
+int tock_digest_cert_chain(const uint8_t* certs, size_t nsteps,
+                           void* blocks, void* output, size_t output_len);
+
 #endif // TOCK_DIGEST_H
@@ -0,0 +1,66 @@
+// Copyright 2021 Google LLC
+//
+// Licensed under the Apache License, Version 2.0 (the "License");
+// you may not use this file except in compliance with the License.
+// You may obtain a copy of the License at
+//
+//     https://www.apache.org/licenses/LICENSE-2.0
+//
+// Unless required by applicable law or agreed to in writing, software
+// distributed under the License is distributed on an "AS IS" BASIS,
+// WITHOUT WARRANTIES OR CONDITIONS OF ANY KIND, either express or implied.
+// See the License for the specific language governing permissions and
+// limitations under the License.
+
+#include "entropy_ipc.h"
+
+#include <string.h>
+#include <tock.h>
+
+int tock_entropy_connect(void* buf, size_t len, entropy_conn* conn) {
+  if (len < 2 * sizeof(uint32_t)) return TOCK_EINVAL;
+  return h1_ipc_connect(ENTROPY_BROKER_PKG, buf, len, &conn->conn);
+}
+
+// One request/response round trip for up to a buffer's worth of bytes.
+// Returns the served count or a negative error.
+static int entropy_call(entropy_conn* conn, size_t len) {
+  uint32_t req = (uint32_t)len;
+  int32_t res;
+
+  memcpy(conn->conn.buf, &req, sizeof(req));
+  int ret = h1_ipc_call(&conn->conn);
+  if (ret < 0) return ret;
+
+  memcpy(&res, conn->conn.buf, sizeof(res));
+  return res;
+}
+
+int tock_entropy_get_ptr(entropy_conn* conn, size_t len, uint8_t** bytes) {
+  if (len > conn->conn.len - sizeof(uint32_t)) return TOCK_ESIZE;
+
+  int res = entropy_call(conn, len);
+  if (res < 0) return res;
+  if ((size_t)res != len) return TOCK_FAIL;
+
+  *bytes = conn->conn.buf + sizeof(uint32_t);
+  return TOCK_SUCCESS;
+}
+
+int tock_entropy_get(entropy_conn* conn, void* out, size_t len) {
+  uint8_t* dst = (uint8_t*)out;
+  size_t chunk_max = conn->conn.len - sizeof(uint32_t);
+
+  while (len > 0) {
+    size_t chunk = len > chunk_max ? chunk_max : len;
+    uint8_t* bytes;
+
+    int ret = tock_entropy_get_ptr(conn, chunk, &bytes);
+    if (ret != TOCK_SUCCESS) return ret;
+
+    memcpy(dst, bytes, chunk);
+    dst += chunk;
+    len -= chunk;
+  }
+  return TOCK_SUCCESS;
+}
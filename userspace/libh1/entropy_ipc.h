@@ -0,0 +1,57 @@
+// Copyright 2021 Google LLC
+//
+// Licensed under the Apache License, Version 2.0 (the "License");
+// you may not use this file except in compliance with the License.
+// You may obtain a copy of the License at
+//
+//     https://www.apache.org/licenses/LICENSE-2.0
+//
+// Unless required by applicable law or agreed to in writing, software
+// distributed under the License is distributed on an "AS IS" BASIS,
+// WITHOUT WARRANTIES OR CONDITIONS OF ANY KIND, either express or implied.
+// See the License for the specific language governing permissions and
+// limitations under the License.
+
+#ifndef TOCK_ENTROPY_IPC_H
+#define TOCK_ENTROPY_IPC_H
+
+#include <stddef.h>
+#include <stdint.h>
+
+#include "h1_ipc.h"
+
+// Client interface to the entropy broker (the rng app). The broker
+// owns the TRNG health-test pipeline and a DRBG seeded from a
+// persisted, key-ladder-encrypted seed, so entropy is available to
+// clients immediately after boot without each app draining and
+// screening the TRNG itself.
+
+// Package name the broker registers its IPC service under.
+#define ENTROPY_BROKER_PKG "rng"
+
+// Shared-buffer protocol: the client writes the requested byte count
+// into the first word and notifies; the broker overwrites that word
+// with the served byte count (or a negative tock error) and places the
+// bytes directly after it. The payload never leaves the shared buffer,
+// so one draw costs two context switches and no copies.
+
+typedef struct {
+  h1_ipc_conn conn;
+} entropy_conn;
+
+// Connects to the broker, sharing buf (power-of-two sized, aligned to
+// its size, at least 8 bytes; see h1_ipc.h) with it. Returns a
+// negative error if the broker app is not loaded.
+int tock_entropy_connect(void* buf, size_t len, entropy_conn* conn);
+
+// Fills out with len random bytes, issuing as many broker calls as the
+// shared buffer size requires. Returns TOCK_SUCCESS or the broker's
+// error.
+int tock_entropy_get(entropy_conn* conn, void* out, size_t len);
+
+// Zero-copy variant: serves len bytes (at most the shared buffer size
+// minus the header word) and points *bytes at them inside the shared
+// buffer. The bytes are valid until the next call on this connection.
+int tock_entropy_get_ptr(entropy_conn* conn, size_t len, uint8_t** bytes);
+
+#endif  // TOCK_ENTROPY_IPC_H
@@ -0,0 +1,41 @@
+// Copyright 2021 Google LLC
+//
+// Licensed under the Apache License, Version 2.0 (the "License");
+// you may not use this file except in compliance with the License.
+// You may obtain a copy of the License at
+//
+//     https://www.apache.org/licenses/LICENSE-2.0
+//
+// Unless required by applicable law or agreed to in writing, software
+// distributed under the License is distributed on an "AS IS" BASIS,
+// WITHOUT WARRANTIES OR CONDITIONS OF ANY KIND, either express or implied.
+// See the License for the specific language governing permissions and
+// limitations under the License.
+
+#ifndef TOCK_FLASH_LAYOUT_H
+#define TOCK_FLASH_LAYOUT_H
+
+// Assignments of the writable pages at the top of the 512KB flash
+// (2KB pages, numbered 0-255). The kernel's GLOBALSEC flash window on
+// golf2 opens pages FLASH_LAYOUT_FIRST_OPEN_PAGE through 255; writes
+// to any page below that are rejected by hardware, so every store
+// listed here must sit inside the window. Keep this table and the
+// window in kernel/golf2/src/main.rs in step.
+//
+// A kvstore page pair is owned by exactly one process: the store's
+// in-RAM state (log tail, active generation) lives in the mounting
+// process, so two processes mounting the same pair would append with
+// independent tails and corrupt the log.
+//
+//   248-249  rng app: persisted DRBG seed kvstore
+//   250-251  u2f_app: FIPS KAT cache and per-origin counter kvstore
+//   252      kernel: crash fault dump
+//   253      kernel: personality
+//   254-255  kernel: non-volatile counter
+
+#define FLASH_LAYOUT_FIRST_OPEN_PAGE 248
+
+#define FLASH_LAYOUT_RNG_SEED_PAGE   248
+#define FLASH_LAYOUT_FIPS_STORE_PAGE 250
+
+#endif
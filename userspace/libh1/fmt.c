@@ -0,0 +1,150 @@
+// Copyright 2021 Google LLC
+//
+// Licensed under the Apache License, Version 2.0 (the "License");
+// you may not use this file except in compliance with the License.
+// You may obtain a copy of the License at
+//
+//     https://www.apache.org/licenses/LICENSE-2.0
+//
+// Unless required by applicable law or agreed to in writing, software
+// distributed under the License is distributed on an "AS IS" BASIS,
+// WITHOUT WARRANTIES OR CONDITIONS OF ANY KIND, either express or implied.
+// See the License for the specific language governing permissions and
+// limitations under the License.
+
+#include "fmt.h"
+
+#include <console.h>
+#include <stdint.h>
+#include <string.h>
+
+// One line of output. Big enough for every message in the tree; longer
+// output is truncated rather than grown on the heap.
+#define FMT_LINE_MAX 128
+
+typedef struct {
+  char* buf;
+  size_t size;  // bytes available, including the NUL
+  size_t len;   // untruncated length produced so far
+} fmt_out;
+
+static void out_char(fmt_out* o, char c) {
+  if (o->len + 1 < o->size) o->buf[o->len] = c;
+  o->len++;
+}
+
+// Emit one converted field with padding. digits==NULL pads with the
+// string s; otherwise s holds digits to print after zero-padding.
+static void out_field(fmt_out* o, const char* s, size_t n, int width,
+                      int left, int zero) {
+  int pad = width > (int)n ? width - (int)n : 0;
+  if (!left) {
+    while (pad-- > 0) out_char(o, zero ? '0' : ' ');
+  }
+  while (n--) out_char(o, *s++);
+  if (left) {
+    while (pad-- > 0) out_char(o, ' ');
+  }
+}
+
+static size_t utoa_rev(char* digits, uint32_t v, uint32_t base, int upper) {
+  const char* set = upper ? "0123456789ABCDEF" : "0123456789abcdef";
+  char tmp[10];  // 32 bits: <= 10 decimal digits
+  size_t n = 0;
+  do {
+    tmp[n++] = set[v % base];
+    v /= base;
+  } while (v);
+  for (size_t i = 0; i < n; i++) digits[i] = tmp[n - 1 - i];
+  return n;
+}
+
+static void format(fmt_out* o, const char* fmt, va_list args) {
+  while (*fmt) {
+    if (*fmt != '%') {
+      out_char(o, *fmt++);
+      continue;
+    }
+    fmt++;
+
+    int left = 0, zero = 0;
+    while (*fmt == '-' || *fmt == '0') {
+      if (*fmt == '-') left = 1;
+      else zero = 1;
+      fmt++;
+    }
+    int width = 0;
+    while (*fmt >= '0' && *fmt <= '9') width = width * 10 + (*fmt++ - '0');
+    if (*fmt == 'l') fmt++;  // long and int are both 32 bits here
+
+    char digits[11];
+    size_t n;
+    switch (*fmt) {
+      case 'd':
+      case 'i': {
+        int32_t v = va_arg(args, int32_t);
+        char* p = digits;
+        if (v < 0) *p++ = '-';
+        n = (p - digits) + utoa_rev(p, v < 0 ? -(uint32_t)v : (uint32_t)v,
+                                    10, 0);
+        out_field(o, digits, n, width, left, zero);
+        break;
+      }
+      case 'u':
+        n = utoa_rev(digits, va_arg(args, uint32_t), 10, 0);
+        out_field(o, digits, n, width, left, zero);
+        break;
+      case 'x':
+      case 'X':
+        n = utoa_rev(digits, va_arg(args, uint32_t), 16, *fmt == 'X');
+        out_field(o, digits, n, width, left, zero);
+        break;
+      case 'c':
+        digits[0] = (char)va_arg(args, int);
+        out_field(o, digits, 1, width, left, 0);
+        break;
+      case 's': {
+        const char* s = va_arg(args, const char*);
+        out_field(o, s, strlen(s), width, left, 0);
+        break;
+      }
+      case '%':
+        out_char(o, '%');
+        break;
+      case '\0':
+        return;  // dangling '%' at end of format
+      default:
+        // Unsupported conversion: echo it so the gap is visible.
+        out_char(o, '%');
+        out_char(o, *fmt);
+        break;
+    }
+    fmt++;
+  }
+}
+
+int h1_vsnprintf(char* buf, size_t size, const char* fmt, va_list args) {
+  fmt_out o = {buf, size, 0};
+  format(&o, fmt, args);
+  if (size) buf[o.len < size ? o.len : size - 1] = '\0';
+  return (int)o.len;
+}
+
+int h1_snprintf(char* buf, size_t size, const char* fmt, ...) {
+  va_list args;
+  va_start(args, fmt);
+  int n = h1_vsnprintf(buf, size, fmt, args);
+  va_end(args);
+  return n;
+}
+
+int h1_printf(const char* fmt, ...) {
+  static char line[FMT_LINE_MAX];
+  va_list args;
+  va_start(args, fmt);
+  int n = h1_vsnprintf(line, sizeof(line), fmt, args);
+  va_end(args);
+  if (n > (int)sizeof(line) - 1) n = sizeof(line) - 1;
+  putnstr(line, n);
+  return n;
+}
@@ -0,0 +1,41 @@
+// Copyright 2021 Google LLC
+//
+// Licensed under the Apache License, Version 2.0 (the "License");
+// you may not use this file except in compliance with the License.
+// You may obtain a copy of the License at
+//
+//     https://www.apache.org/licenses/LICENSE-2.0
+//
+// Unless required by applicable law or agreed to in writing, software
+// distributed under the License is distributed on an "AS IS" BASIS,
+// WITHOUT WARRANTIES OR CONDITIONS OF ANY KIND, either express or implied.
+// See the License for the specific language governing permissions and
+// limitations under the License.
+
+#ifndef TOCK_FMT_H
+#define TOCK_FMT_H
+
+#include <stdarg.h>
+#include <stddef.h>
+
+// Heap-free console formatting. newlib's printf() allocates its stdio
+// state lazily, so the first message on a hot path pays a malloc and
+// every build carries the full float-capable formatter in .text. These
+// format into a static buffer and write straight to the console.
+//
+// Supported conversions: %d %i %u %x %X %c %s %%, with '-' and '0'
+// flags, a field width, and the 'l' length modifier (long is 32-bit
+// here, so it only affects parsing). No floats, no heap.
+
+// printf() replacement. Output longer than the internal line buffer
+// (128 bytes) is truncated. Returns the number of bytes written.
+int h1_printf(const char* format, ...)
+    __attribute__((format(printf, 1, 2)));
+
+// snprintf() replacements with the same conversion subset. Always
+// NUL-terminate (when size > 0) and return the untruncated length.
+int h1_snprintf(char* buf, size_t size, const char* format, ...)
+    __attribute__((format(printf, 3, 4)));
+int h1_vsnprintf(char* buf, size_t size, const char* format, va_list args);
+
+#endif  // TOCK_FMT_H
@@ -24,11 +24,15 @@
 #define TOCK_AES_CMD_CTR_DEC 4
 #define TOCK_AES_CMD_CBC_ENC 5
 #define TOCK_AES_CMD_CBC_DEC 6
+#define TOCK_AES_CMD_STORE_KEY_SLOT  8
+#define TOCK_AES_CMD_SELECT_KEY_SLOT 9
+#define TOCK_AES_CMD_CMAC 10
 
 #define TOCK_AES_ALLOW_KEY    0
 #define TOCK_AES_ALLOW_INPUT  1
-//#define TOCK_AES_ALLOW_OUTPUT 2
+#define TOCK_AES_ALLOW_OUTPUT 2
 #define TOCK_AES_ALLOW_IVCTR  3
+#define TOCK_AES_ALLOW_CMAC   4
 
 #define TOCK_AES_SUBSCRIBE_CRYPT 0
 
@@ -90,6 +94,113 @@ static void increment_counter(unsigned char* buf, unsigned char len) {
   }
 }
 
+// Adds count to a big-endian counter, carrying left. Used to advance
+// the counter past a whole streaming submission in one go.
+static void increment_counter_by(unsigned char* buf, unsigned char len,
+                                 size_t count) {
+  for (int i = len - 1; i >= 0 && count != 0; i--) {
+    size_t sum = (size_t)buf[i] + (count & 0xff);
+    buf[i] = (unsigned char)sum;
+    count = (count >> 8) + (sum >> 8);
+  }
+}
+
+
+// ***** Asynchronous Calls *****
+
+// One request may be outstanding at a time from this process: the
+// kernel walks the allowed input buffer while the operation runs, so
+// re-allowing it for a second request would corrupt the first. The
+// kernel-side queue orders requests across processes.
+typedef struct {
+  tock_aes_callback callback;
+  void* user_data;
+  unsigned char* ctr;
+  unsigned char ctr_len;
+  size_t buf_len;
+} aes_async_req;
+
+static aes_async_req async_pending;
+static bool async_busy = false;
+
+// Internal kernel callback: advances the caller's counter (CTR mode
+// only), then hands completion to the user callback.
+static void aes_async_done(int count,
+                           __attribute__ ((unused)) int unused1,
+                           __attribute__ ((unused)) int unused2,
+                           __attribute__ ((unused)) void* ud) {
+  aes_async_req req = async_pending;
+  async_busy = false;
+  if (req.ctr != NULL && count >= 0 && (size_t)count == req.buf_len) {
+    increment_counter_by(req.ctr, req.ctr_len, req.buf_len / req.ctr_len);
+  }
+  if (req.callback != NULL) {
+    req.callback(count, req.user_data);
+  }
+}
+
+// Submits one operation without blocking. ctr is NULL for ECB.
+static int aes_submit_async(unsigned char* buf, size_t buf_len,
+                            unsigned char* ctr, unsigned char ctr_len,
+                            unsigned int cmd,
+                            tock_aes_callback callback, void* user_data) {
+  int err;
+
+  if (async_busy) return TOCK_EBUSY;
+  if ((buf_len == 0) || (buf_len % 16 != 0) ||
+      (ctr != NULL && ctr_len != 16)) {
+    return TOCK_ESIZE;
+  }
+
+  err = tock_aes_set_callback(aes_async_done, NULL);
+  if (err < TOCK_SUCCESS) return err;
+
+  err = allow(H1_AES_DRIVER, TOCK_AES_ALLOW_INPUT, (void*)buf, buf_len);
+  if (err < TOCK_SUCCESS) return err;
+
+  if (ctr != NULL) {
+    err = tock_aes_set_ctr(ctr, ctr_len);
+    if (err < TOCK_SUCCESS) return err;
+  }
+
+  err = command(H1_AES_DRIVER, cmd, 0, 0);
+  if (err < TOCK_SUCCESS) return err;
+
+  async_pending.callback = callback;
+  async_pending.user_data = user_data;
+  async_pending.ctr = ctr;
+  async_pending.ctr_len = ctr_len;
+  async_pending.buf_len = buf_len;
+  async_busy = true;
+  return TOCK_SUCCESS;
+}
+
+int tock_aes_encrypt_ctr_async(unsigned char* buf, size_t buf_len,
+                               unsigned char* ctr, unsigned char ctr_len,
+                               tock_aes_callback callback, void* user_data) {
+  return aes_submit_async(buf, buf_len, ctr, ctr_len,
+                          TOCK_AES_CMD_CTR_ENC, callback, user_data);
+}
+
+int tock_aes_decrypt_ctr_async(unsigned char* buf, size_t buf_len,
+                               unsigned char* ctr, unsigned char ctr_len,
+                               tock_aes_callback callback, void* user_data) {
+  return aes_submit_async(buf, buf_len, ctr, ctr_len,
+                          TOCK_AES_CMD_CTR_DEC, callback, user_data);
+}
+
+int tock_aes_encrypt_ecb_async(unsigned char* buf, size_t buf_len,
+                               tock_aes_callback callback, void* user_data) {
+  return aes_submit_async(buf, buf_len, NULL, 0,
+                          TOCK_AES_CMD_ECB_ENC, callback, user_data);
+}
+
+int tock_aes_decrypt_ecb_async(unsigned char* buf, size_t buf_len,
+                               tock_aes_callback callback, void* user_data) {
+  return aes_submit_async(buf, buf_len, NULL, 0,
+                          TOCK_AES_CMD_ECB_DEC, callback, user_data);
+}
+
 
 // ***** Synchronous Calls *****
 
@@ -98,6 +209,17 @@ int tock_aes_set_key(const unsigned char* data, unsigned char len) {
   return allow(H1_AES_DRIVER, TOCK_AES_ALLOW_KEY, (void*)data, len);
 }
 
+int tock_aes_install_key_slot(const unsigned char* key, unsigned char len,
+                              unsigned int slot) {
+  int err = tock_aes_set_key(key, len);
+  if (err < TOCK_SUCCESS) return err;
+  return command(H1_AES_DRIVER, TOCK_AES_CMD_STORE_KEY_SLOT, slot, 0);
+}
+
+int tock_aes_use_key_slot(unsigned int slot) {
+  return command(H1_AES_DRIVER, TOCK_AES_CMD_SELECT_KEY_SLOT, slot, 0);
+}
+
 // Operates on a single 16-byte block.
 // buf and ctr are assumed to be >= 16 bytes.
 static int aes_encrypt_ctr_block(unsigned char* buf,
@@ -156,6 +278,80 @@ static int aes_decrypt_ctr_block(unsigned char* buf,
   return result.count;
 }
 
+// Runs an arbitrary-length counter-mode operation as a single kernel
+// submission: the whole buffer is allowed once and the driver walks it
+// block by block, with the engine carrying the counter between blocks.
+static int aes_crypt_ctr_stream(unsigned char* buf, size_t buf_len,
+                                unsigned char* ctr, unsigned char ctr_len,
+                                unsigned int cmd) {
+  int err;
+  aes_data_t result = { .fired = false, .count = 0 };
+
+  // The hardware counter register is 128 bits, and the buffer must be a
+  // whole number of blocks.
+  if ((ctr_len != 16) || (buf_len % ctr_len != 0)) {
+    return TOCK_ESIZE;
+  }
+  if (buf_len == 0) {
+    return 0;
+  }
+
+  err = tock_aes_set_callback(aes_cb, &result);
+  if (err < TOCK_SUCCESS) return err;
+
+  err = allow(H1_AES_DRIVER, TOCK_AES_ALLOW_INPUT, (void*)buf, buf_len);
+  if (err < TOCK_SUCCESS) return err;
+
+  err = tock_aes_set_ctr(ctr, ctr_len);
+  if (err < TOCK_SUCCESS) return err;
+
+  err = command(H1_AES_DRIVER, cmd, 0, 0);
+  if (err < TOCK_SUCCESS) return err;
+
+  yield_for(&result.fired);
+
+  if (result.count >= 0 && (size_t)result.count == buf_len) {
+    // Advance the caller's counter past everything the kernel processed
+    // so chained calls continue the keystream.
+    increment_counter_by(ctr, ctr_len, buf_len / ctr_len);
+  } else {
+    return TOCK_FAIL;
+  }
+
+  return result.count;
+}
+
+int tock_aes_cmac(const void* data, size_t data_len, unsigned char tag[16]) {
+  int err;
+  aes_data_t result = { .fired = false, .count = 0 };
+
+  err = tock_aes_set_callback(aes_cb, &result);
+  if (err < TOCK_SUCCESS) return err;
+
+  err = allow(H1_AES_DRIVER, TOCK_AES_ALLOW_CMAC, (void*)data, data_len);
+  if (err < TOCK_SUCCESS) return err;
+
+  err = allow(H1_AES_DRIVER, TOCK_AES_ALLOW_OUTPUT, (void*)tag, 16);
+  if (err < TOCK_SUCCESS) return err;
+
+  err = command(H1_AES_DRIVER, TOCK_AES_CMD_CMAC, data_len, 0);
+  if (err < TOCK_SUCCESS) return err;
+
+  yield_for(&result.fired);
+
+  return result.count == 16 ? TOCK_SUCCESS : TOCK_FAIL;
+}
+
+int tock_aes_encrypt_ctr_stream_sync(unsigned char* buf, size_t buf_len,
+                                     unsigned char* ctr, unsigned char ctr_len) {
+  return aes_crypt_ctr_stream(buf, buf_len, ctr, ctr_len, TOCK_AES_CMD_CTR_ENC);
+}
+
+int tock_aes_decrypt_ctr_stream_sync(unsigned char* buf, size_t buf_len,
+                                     unsigned char* ctr, unsigned char ctr_len) {
+  return aes_crypt_ctr_stream(buf, buf_len, ctr, ctr_len, TOCK_AES_CMD_CTR_DEC);
+}
+
 int tock_aes_encrypt_ctr_sync(unsigned char* buf, unsigned char buf_len,
                               unsigned char* ctr, unsigned char ctr_len) {
   // Expects a 128 or 256 bit counter and that the buffer is an integer
@@ -165,7 +361,14 @@ int tock_aes_encrypt_ctr_sync(unsigned char* buf, unsigned char buf_len,
     return TOCK_ESIZE;
   }
 
-  // Just encrypt each block
+  // The kernel walks the whole allowed buffer in one submission, so a
+  // hardware-sized counter needs one syscall sequence for any length.
+  if (ctr_len == 16) {
+    return aes_crypt_ctr_stream(buf, buf_len, ctr, ctr_len,
+                                TOCK_AES_CMD_CTR_ENC);
+  }
+
+  // 256-bit counters still go block by block.
   for (int i = 0; i < buf_len; i+= ctr_len) {
     int count = aes_encrypt_ctr_block(buf + i, ctr, ctr_len);
     if (count != ctr_len) {
@@ -184,7 +387,14 @@ int tock_aes_decrypt_ctr_sync(unsigned char* buf, unsigned char buf_len,
     return TOCK_ESIZE;
   }
 
-  // Just decrypt each block
+  // The kernel walks the whole allowed buffer in one submission, so a
+  // hardware-sized counter needs one syscall sequence for any length.
+  if (ctr_len == 16) {
+    return aes_crypt_ctr_stream(buf, buf_len, ctr, ctr_len,
+                                TOCK_AES_CMD_CTR_DEC);
+  }
+
+  // 256-bit counters still go block by block.
   for (int i = 0; i < buf_len; i+= ctr_len) {
     int count = aes_decrypt_ctr_block(buf + i, ctr, ctr_len);
     if (count != ctr_len){
@@ -194,85 +404,52 @@ int tock_aes_decrypt_ctr_sync(unsigned char* buf, unsigned char buf_len,
   return buf_len;
 }
 
-// Assumes buf is 16 or 32 bytes long.
-static int aes_encrypt_ecb_block(unsigned char* buf, unsigned char len) {
+// Runs an arbitrary-length ECB operation as a single kernel
+// submission: the whole buffer is allowed once and the driver walks it
+// block by block, with one completion callback at the end.
+static int aes_crypt_ecb_stream(unsigned char* buf, unsigned char buf_len,
+                                unsigned int cmd) {
   int err;
-  if (len != 16 && len != 32) {
-    return TOCK_ESIZE;
-  }
-
   aes_data_t result = { .fired = false, .count = 0 };
 
-  err = tock_aes_set_callback(aes_cb, &result);
-  if (err < TOCK_SUCCESS) return err;
-
-  err = tock_aes_set_input(buf, len);
-  if (err < TOCK_SUCCESS) return err;
-
-  err = command(H1_AES_DRIVER, TOCK_AES_CMD_ECB_ENC, 0, 0);
-  if (err < TOCK_SUCCESS) return err;
-
-  yield_for(&result.fired);
-
-  return result.count;
-}
-
-// Assumes buf is 16 or 32 bytes long
-static int aes_decrypt_ecb_block(unsigned char* buf, unsigned char len) {
-  int err;
-
-  if (len != 16 && len != 32) {
-    return TOCK_ESIZE;
+  if (buf_len == 0) {
+    return 0;
   }
 
-  aes_data_t result = { .fired = false, .count = 0 };
-
   err = tock_aes_set_callback(aes_cb, &result);
   if (err < TOCK_SUCCESS) return err;
 
-  err = tock_aes_set_input(buf, len);
+  err = tock_aes_set_input(buf, buf_len);
   if (err < TOCK_SUCCESS) return err;
 
-  err = command(H1_AES_DRIVER, TOCK_AES_CMD_ECB_DEC, 0, 0);
+  err = command(H1_AES_DRIVER, cmd, 0, 0);
   if (err < TOCK_SUCCESS) return err;
 
   yield_for(&result.fired);
 
-  return result.count;
+  return result.count == buf_len ? buf_len : TOCK_FAIL;
 }
 
 int tock_aes_encrypt_ecb_sync(unsigned char block_len,
                               unsigned char* buf,
                               unsigned char buf_len) {
-  if (buf_len % block_len != 0) {
+  if ((block_len != 16 && block_len != 32) ||
+      (buf_len % block_len != 0)) {
     return TOCK_ESIZE;
   }
 
-  // Just encrypt each block
-  for (int i = 0; i < buf_len; i+= block_len) {
-    int count = aes_encrypt_ecb_block(buf + i, block_len);
-    if (count != block_len){
-      return TOCK_FAIL;
-    }
-  }
-  return buf_len;
+  return aes_crypt_ecb_stream(buf, buf_len, TOCK_AES_CMD_ECB_ENC);
 }
 
 int tock_aes_decrypt_ecb_sync(unsigned char block_len,
                               unsigned char* buf,
                               unsigned char buf_len) {
-  if (buf_len % block_len != 0) {
+  if ((block_len != 16 && block_len != 32) ||
+      (buf_len % block_len != 0)) {
     return TOCK_ESIZE;
   }
 
-  // Just decrypt each block
-  for (int i = 0; i < buf_len; i+= block_len) {
-    int count = aes_decrypt_ecb_block(buf + i, block_len);
-    if (count != block_len) {
-      return TOCK_FAIL;
-    }
-  }
-  return buf_len;
+  return aes_crypt_ecb_stream(buf, buf_len, TOCK_AES_CMD_ECB_DEC);
 }
 
 // Encrypt a block using CBC mode. Assumes both buf and iv are
@@ -354,6 +531,51 @@ static int aes_decrypt_cbc_block(unsigned char block_len,
 }
 
 
+// Runs an arbitrary-length CBC operation as a single kernel
+// submission; the engine carries the chaining state between blocks.
+// The caller's iv is advanced past the whole buffer on success so
+// chained calls continue the ciphertext chain, matching the per-block
+// helpers above.
+static int aes_crypt_cbc_stream(unsigned char* buf, unsigned char buf_len,
+                                unsigned char* iv, unsigned int cmd) {
+  int err;
+  aes_data_t result = { .fired = false, .count = 0 };
+  unsigned char next_iv[16];
+
+  if (buf_len == 0) {
+    return 0;
+  }
+
+  // The next IV is the last ciphertext block: for decryption that is
+  // input we are about to overwrite, so save it up front.
+  memcpy(next_iv, buf + buf_len - 16,  16);
+
+  err = tock_aes_set_callback(aes_cb, &result);
+  if (err < TOCK_SUCCESS) return err;
+
+  err = tock_aes_set_input(buf, buf_len);
+  if (err < TOCK_SUCCESS) return err;
+
+  err = tock_aes_set_ctr(iv, 16);
+  if (err < TOCK_SUCCESS) return err;
+
+  err = command(H1_AES_DRIVER, cmd, 0, 0);
+  if (err < TOCK_SUCCESS) return err;
+
+  yield_for(&result.fired);
+
+  if (result.count != buf_len) {
+    return TOCK_FAIL;
+  }
+
+  if (cmd == TOCK_AES_CMD_CBC_ENC) {
+    memcpy(iv, buf + buf_len - 16, 16);
+  } else {
+    memcpy(iv, next_iv, 16);
+  }
+  return buf_len;
+}
+
 int tock_aes_encrypt_cbc_sync(unsigned char* buf, unsigned char buf_len,
                               unsigned char* iv, unsigned char iv_len) {
   // Expects a 128 or 256 bit initialization vector (IV) and that the
@@ -363,7 +585,11 @@ int tock_aes_encrypt_cbc_sync(unsigned char* buf, unsigned char buf_len,
     return TOCK_ESIZE;
   }
 
-  // Just decrypt each block
+  // Hardware-sized IVs go through in one submission.
+  if (iv_len == 16) {
+    return aes_crypt_cbc_stream(buf, buf_len, iv, TOCK_AES_CMD_CBC_ENC);
+  }
+
   for (int i = 0; i < buf_len; i+= iv_len) {
     int count = aes_encrypt_cbc_block(iv_len, buf + i, iv);
     if (count != iv_len){
@@ -383,7 +609,11 @@ int tock_aes_decrypt_cbc_sync(unsigned char* buf, unsigned char buf_len,
     return TOCK_ESIZE;
   }
 
-  // Just decrypt each block
+  // Hardware-sized IVs go through in one submission.
+  if (iv_len == 16) {
+    return aes_crypt_cbc_stream(buf, buf_len, iv, TOCK_AES_CMD_CBC_DEC);
+  }
+
   for (int i = 0; i < buf_len; i+= iv_len) {
     int count = aes_decrypt_cbc_block(iv_len, buf + i, iv);
     if (count != iv_len){
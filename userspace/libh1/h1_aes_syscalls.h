@@ -31,6 +31,36 @@ int tock_aes_check(void);
 // len - length of the buffer (must be 16 for AES128 or 32 for AES256)
 int tock_aes_set_key(const unsigned char* key, unsigned char len);
 
+// Stores a key in one of the kernel's numbered key slots (0-3). The key
+// is transferred once; subsequent operations reference it by index and
+// pay no per-operation key upload or hardware key expansion.
+//
+// key  - a buffer containing the key (length must be 16 for AES128)
+// len  - length of the buffer (must be 16 for AES128)
+// slot - slot index to store the key in (0-3)
+int tock_aes_install_key_slot(const unsigned char* key, unsigned char len,
+                              unsigned int slot);
+
+// Selects a previously installed key slot for subsequent operations.
+// Returns TOCK_EINVAL if the slot is out of range or empty. The
+// selection persists until another slot is selected or a key is passed
+// to tock_aes_set_key(), which takes precedence.
+//
+// slot - slot index to use (0-3)
+int tock_aes_use_key_slot(unsigned int slot);
+
+// Computes the AES-CMAC (RFC 4493) of an arbitrary-length message in a
+// single kernel submission, using the key previously configured with
+// tock_aes_set_key() or a selected key slot. The kernel derives the
+// subkeys, pads the final block and runs the whole CBC-MAC chain, so
+// there is no per-block syscall and the subkeys never reach userspace.
+// Returns TOCK_SUCCESS with the 16-byte tag written to tag, or an error.
+//
+// data     - message to authenticate (any length, not modified)
+// data_len - length of the message in bytes
+// tag      - receives the 16-byte tag
+int tock_aes_cmac(const void* data, size_t data_len, unsigned char tag[16]);
+
 
 // Encrypts a payload according to AES counter-mode. The counter
 // stored in ctr is incremented for each block encrypted in a single
@@ -61,6 +91,48 @@ int tock_aes_encrypt_ctr_sync(unsigned char* buf, unsigned char buf_len,
 int tock_aes_decrypt_ctr_sync(unsigned char* buf, unsigned char buf_len,
                               unsigned char* ctr, unsigned char ctr_len);
 
+// Streaming variants of the counter-mode calls above. buf_len is a
+// size_t, so one call covers an arbitrary-length buffer: the kernel
+// driver walks the whole buffer in a single submission and delivers one
+// callback at the end, instead of one command/callback round trip per
+// 16-byte block. As with the block variants, ctr is advanced past the
+// processed blocks on return so chained calls continue the keystream.
+//
+// buf      - buffer to encrypt/decrypt in place (must be N*16 bytes)
+// buf_len  - length of the buffer in bytes
+// ctr      - buffer with the initial counter (must be 16 bytes long)
+// ctr_len  - length of buffer with the initial counter (must be 16)
+int tock_aes_encrypt_ctr_stream_sync(unsigned char* buf, size_t buf_len,
+                                     unsigned char* ctr, unsigned char ctr_len);
+int tock_aes_decrypt_ctr_stream_sync(unsigned char* buf, size_t buf_len,
+                                     unsigned char* ctr, unsigned char ctr_len);
+
+// Invoked when an asynchronous AES operation completes. count is the
+// number of bytes processed; anything other than the submitted length
+// indicates failure.
+typedef void (*tock_aes_callback)(int count, void* user_data);
+
+// Asynchronous variants: submit the operation and return immediately,
+// so the caller can drive other hardware (e.g. the SHA engine) while
+// AES runs. The operation is performed in place on buf, which must stay
+// allocated and untouched until the callback fires. One request may be
+// outstanding at a time; a second submission returns TOCK_EBUSY. If the
+// kernel engine is serving another process the request is queued there
+// and completes in order.
+//
+// The CTR variants advance ctr past the processed blocks before the
+// callback is invoked, as the synchronous calls do on return.
+int tock_aes_encrypt_ctr_async(unsigned char* buf, size_t buf_len,
+                               unsigned char* ctr, unsigned char ctr_len,
+                               tock_aes_callback callback, void* user_data);
+int tock_aes_decrypt_ctr_async(unsigned char* buf, size_t buf_len,
+                               unsigned char* ctr, unsigned char ctr_len,
+                               tock_aes_callback callback, void* user_data);
+int tock_aes_encrypt_ecb_async(unsigned char* buf, size_t buf_len,
+                               tock_aes_callback callback, void* user_data);
+int tock_aes_decrypt_ecb_async(unsigned char* buf, size_t buf_len,
+                               tock_aes_callback callback, void* user_data);
+
 // Encrypts a payload according to AES electronic codebook mode. Note
 // that this encryption mode is generally frowned upon, two identical
 // cleartexts have the same ciphertext (it leaks information). The
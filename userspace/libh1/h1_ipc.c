@@ -0,0 +1,82 @@
+// Copyright 2021 Google LLC
+//
+// Licensed under the Apache License, Version 2.0 (the "License");
+// you may not use this file except in compliance with the License.
+// You may obtain a copy of the License at
+//
+//     https://www.apache.org/licenses/LICENSE-2.0
+//
+// Unless required by applicable law or agreed to in writing, software
+// distributed under the License is distributed on an "AS IS" BASIS,
+// WITHOUT WARRANTIES OR CONDITIONS OF ANY KIND, either express or implied.
+// See the License for the specific language governing permissions and
+// limitations under the License.
+
+#include "h1_ipc.h"
+
+#include <ipc.h>
+#include <tock.h>
+
+// There is one service handler per app; the kernel's IPC driver keys
+// clients by process, so a single registration covers all of them.
+static h1_ipc_svc_handler svc_handler = NULL;
+static void* svc_userdata = NULL;
+
+static void svc_trampoline(int pid, int len, int buf,
+                           void* ud __attribute__((unused))) {
+  if (svc_handler != NULL) {
+    svc_handler(pid, (uint8_t*)buf, (size_t)len, svc_userdata);
+  }
+}
+
+static void client_done(int pid __attribute__((unused)),
+                        int arg2 __attribute__((unused)),
+                        int arg3 __attribute__((unused)),
+                        void* done) {
+  *(bool*)done = true;
+}
+
+int h1_ipc_connect(const char* pkg_name, void* buf, size_t len,
+                   h1_ipc_conn* conn) {
+  int svc_id = ipc_discover(pkg_name);
+  if (svc_id < 0) {
+    return svc_id;
+  }
+
+  int ret = ipc_share(svc_id, buf, len);
+  if (ret < 0) {
+    return ret;
+  }
+
+  conn->svc_id = svc_id;
+  conn->buf = (uint8_t*)buf;
+  conn->len = len;
+  return TOCK_SUCCESS;
+}
+
+int h1_ipc_call(h1_ipc_conn* conn) {
+  bool done = false;
+
+  int ret = ipc_register_client_cb(conn->svc_id, client_done, &done);
+  if (ret < 0) {
+    return ret;
+  }
+
+  ret = ipc_notify_svc(conn->svc_id);
+  if (ret < 0) {
+    return ret;
+  }
+
+  yield_for(&done);
+  return TOCK_SUCCESS;
+}
+
+int h1_ipc_register_service(h1_ipc_svc_handler handler, void* userdata) {
+  svc_handler = handler;
+  svc_userdata = userdata;
+  return ipc_register_svc(svc_trampoline, NULL);
+}
+
+int h1_ipc_reply(int pid) {
+  return ipc_notify_client(pid);
+}
@@ -0,0 +1,67 @@
+// Copyright 2021 Google LLC
+//
+// Licensed under the Apache License, Version 2.0 (the "License");
+// you may not use this file except in compliance with the License.
+// You may obtain a copy of the License at
+//
+//     https://www.apache.org/licenses/LICENSE-2.0
+//
+// Unless required by applicable law or agreed to in writing, software
+// distributed under the License is distributed on an "AS IS" BASIS,
+// WITHOUT WARRANTIES OR CONDITIONS OF ANY KIND, either express or implied.
+// See the License for the specific language governing permissions and
+// limitations under the License.
+
+#ifndef TOCK_H1_IPC_H
+#define TOCK_H1_IPC_H
+
+#include <stddef.h>
+#include <stdint.h>
+
+// Request/response IPC between apps over a shared buffer.
+//
+// A service app registers itself under its package name; client apps
+// discover it and share a buffer with it once, at connect time. After
+// that, a call is just two notifications: the client writes its request
+// into the shared buffer and notifies the service, the service writes
+// its response into the same buffer and notifies back. No bytes are
+// copied in either direction, so a broker app (entropy, metrics) costs
+// two context switches per request rather than a copy of the payload.
+//
+// The kernel exposes the shared buffer to the service through the MPU,
+// so it must be sized to a power of two and aligned to its size (e.g.
+// uint8_t buf[64] __attribute__((aligned(64)))).
+
+// A client's connection to a service.
+typedef struct {
+  int svc_id;    // Service process id, from discovery.
+  uint8_t* buf;  // Buffer shared with the service.
+  size_t len;
+} h1_ipc_conn;
+
+// Client side: looks up the service registered under pkg_name and
+// shares buf with it. Returns TOCK_SUCCESS and fills *conn, or a
+// negative error (notably if the service app is not loaded).
+int h1_ipc_connect(const char* pkg_name, void* buf, size_t len,
+                   h1_ipc_conn* conn);
+
+// Client side: notifies the service and blocks until it replies. The
+// request and response are exchanged in conn->buf.
+int h1_ipc_call(h1_ipc_conn* conn);
+
+// Service side: called when a client notifies the service. pid
+// identifies the client (pass it to h1_ipc_reply); buf/len is that
+// client's shared buffer, holding the request and receiving the
+// response.
+typedef void (*h1_ipc_svc_handler)(int pid, uint8_t* buf, size_t len,
+                                   void* userdata);
+
+// Service side: registers the handler for incoming requests. The
+// service is discoverable under its own package name.
+int h1_ipc_register_service(h1_ipc_svc_handler handler, void* userdata);
+
+// Service side: completes the request from the given client, waking its
+// h1_ipc_call.
+int h1_ipc_reply(int pid);
+
+#endif  // TOCK_H1_IPC_H
@@ -85,6 +85,48 @@ void asn1_object(ASN1* ctx, size_t n, const uint8_t* b);
 size_t asn1_sigp(uint8_t* p, const p256_int* r, const p256_int* s);
 size_t asn1_pubp(uint8_t* p, const p256_int* x, const p256_int* y);
 
+/*
+ * Reverse DER builder. The forward encoder above has to reserve length
+ * bytes up front and memmove the contents when the guess was too wide
+ * (see asn1_seq); over a cert-sized tree those moves add up. The DER
+ * builder instead writes back-to-front in a scratch arena: children are
+ * emitted before their enclosing header, so every length is exact when
+ * it is written and nothing ever moves. Bracket a constructed type with
+ * der_mark()/der_seq(); der_finish() does the one copy to the caller's
+ * buffer. Note children of a SEQUENCE are emitted in reverse order.
+ */
+typedef struct {
+  uint8_t* base;  // arena start
+  uint8_t* p;     // write cursor; encoded bytes live in [p, end)
+  uint8_t* end;   // arena end
+  int oom;        // set when the arena overflows; result is garbage
+} DER;
+
+void der_start(DER* der, uint8_t* arena, size_t size);
+
+// Bytes emitted so far; pass to der_seq to close a constructed type
+size_t der_mark(const DER* der);
+
+// Prepend a raw byte / raw bytes
+void der_byte(DER* der, uint8_t b);
+void der_bytes(DER* der, const uint8_t* b, size_t n);
+
+// Prepend tag and DER-encoded length for len bytes of content
+void der_hdr(DER* der, uint8_t tag, size_t len);
+
+// Close a constructed type over everything emitted since mark
+void der_seq(DER* der, uint8_t tag, size_t mark);
+
+// Leaf encoders, mirroring the forward ones
+void der_int(DER* der, uint32_t val);
+void der_p256_int(DER* der, const p256_int* n);
+void der_object(DER* der, size_t n, const uint8_t* b);
+void der_string(DER* der, uint8_t tag, const char* s);
+void der_pub(DER* der, const p256_int* x, const p256_int* y);
+
+// Copy the encoding to out; 0 on overflow of the arena or out
+size_t der_finish(DER* der, uint8_t* out, size_t max);
+
 extern const uint8_t OID_commonName[3];
 extern const uint8_t OID_organizationName[3];
 extern const uint8_t OID_ecdsa_with_SHA256[8];
@@ -45,7 +45,8 @@
 
 /* FIPS startup health tests */
 /* Sub-initializers are in their respective crypto drivers */
-int init_fips(void);
+/* Cold: runs once at boot; keep it out of the hot text region. */
+int init_fips(void) __attribute__((cold));
 
 /* Factory-derived entropy */
 #ifndef FACTORY_ENTROPY_OFFSET
@@ -70,9 +71,35 @@ uint32_t flash_physical_info_read_word(uint32_t addr, uint32_t* output);
 int flash_info_read_enable(uint32_t addr, uint32_t len);
 int flash_info_read_disable(void);
 
+/* Known-answer test groups, one per hardware engine. Each group runs
+ * lazily before the first use of its algorithms; failures accumulate
+ * into fips_fatal as before. */
+#define FIPS_KAT_DIGEST (1 << 0) /* SHA256, HMAC, HMAC-DRBG */
+#define FIPS_KAT_AES (1 << 1)    /* AES128, AES-CMAC */
+#define FIPS_KAT_ECDSA (1 << 2)  /* P256 sign/verify on dcrypto */
+
+int fips_ensure_kat(int groups);
+
+// Mount the app's kvstore (KAT cache, signature counters) on its
+// dedicated flash pages. Idempotent. Returns EC_SUCCESS once mounted.
+int fips_kvstore_mount(void);
+
 /* DRBG flavors */
 void make_drbg1(DRBG*);
 void make_drbg2(DRBG*);
 int fips_keygen(DRBG*, p256_int*, p256_int*, p256_int*, const void*, int);
 
+/* Per-channel ephemeral DRBG instances. The transport layer records
+ * the channel a request arrived on; fips_channel_drbg() then hands out
+ * that channel's drbg2-style instance, reseeding it from the TRNG only
+ * every DRBG2_RESEED_INTERVAL generate calls instead of once per
+ * signature. */
+void fips_set_active_channel(uint32_t cid);
+DRBG* fips_channel_drbg(void);
+
+/* Idle-cycle hook: reseed one exhausted channel DRBG from the TRNG so
+ * the next signature on that channel skips the reseed. Returns nonzero
+ * if a slot was refreshed (i.e. work was done). */
+int fips_drbg_precompute(void);
+
 #endif  // __FIPS_H__
@@ -40,4 +40,7 @@ int repetition_count_test_n(uint32_t *in, uint32_t n);
 int apt_is_initialized(void);
 void adaptive_proportion_test(uint32_t val);
 
+/* (3) Incremental screening over buffered samples */
+void trng_health_screen(const uint32_t *in, uint32_t n);
+
 #endif  // __FIPS_HEALTH_TESTS_H__
@@ -45,5 +45,19 @@ int kl_derive_origin(const uint32_t input[8], uint32_t output[8])
     __attribute__((warn_unused_result));
 int kl_derive_ssh(const uint32_t input[8], uint32_t output[8])
     __attribute__((warn_unused_result));
+int kl_derive_khfp(const uint32_t input[8], uint32_t output[8])
+    __attribute__((warn_unused_result));
+
+/**
+ * LRU cache of recent kl_derive() results (kl_cache.c), so repeat
+ * derivations for the same origin skip the hardware ladder. Holds
+ * derived key material: kl_cache_clear() zeroizes it and must be
+ * called whenever the ladder is (re)initialized.
+ */
+void kl_cache_clear(void);
+int kl_cache_get(const uint32_t salt[8], const uint32_t input[8],
+                 uint32_t output[8]);
+void kl_cache_put(const uint32_t salt[8], const uint32_t input[8],
+                  const uint32_t output[8]);
 
 #endif /* __CROS_EC_KL_H */
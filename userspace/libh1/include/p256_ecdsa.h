@@ -0,0 +1,146 @@
+// Copyright 2018 Google LLC
+//
+// Licensed under the Apache License, Version 2.0 (the "License");
+// you may not use this file except in compliance with the License.
+// You may obtain a copy of the License at
+//
+//     https://www.apache.org/licenses/LICENSE-2.0
+//
+// Unless required by applicable law or agreed to in writing, software
+// distributed under the License is distributed on an "AS IS" BASIS,
+// WITHOUT WARRANTIES OR CONDITIONS OF ANY KIND, either express or implied.
+// See the License for the specific language governing permissions and
+// limitations under the License.
+
+#ifndef __P256_ECDSA_H__
+#define __P256_ECDSA_H__
+
+#include "common.h"
+#include "p256.h"
+#include "drbg.h"
+
+//
+// ECC.
+//
+// {r,s} := {kG mod n, (message + r*key)/k mod n}
+//
+// Note: message is a p256_int.
+// Convert from a binary string using p256_from_bin().
+int fips_p256_ecdsa_sign(DRBG *ctx, const p256_int *key,
+                         const p256_int *message, p256_int *r, p256_int *s)
+    __attribute__((warn_unused_result));
+
+// Completion handler for fips_p256_ecdsa_sign_async. result is !0 on
+// success; r and s are only valid for the duration of the callback and
+// must be copied out.
+typedef void (*p256_ecdsa_sign_cb)(int result, const p256_int *r,
+                                   const p256_int *s, void *arg);
+
+// Start an ECDSA sign without blocking: the k-generation and parameter
+// staging happen inline, the dcrypto run completes through a later
+// yield() and invokes the callback. Returns !0 if the sign was
+// submitted. Only one async sign may be outstanding at a time.
+int fips_p256_ecdsa_sign_async(DRBG *ctx, const p256_int *key,
+                               const p256_int *message,
+                               p256_ecdsa_sign_cb callback, void *arg)
+    __attribute__((warn_unused_result));
+
+// Sign message with the SSH origin key derived from input over the
+// key ladder's SSH branch. The derived scalar goes directly into the
+// dcrypto staging block and is wiped after the engine run; it is
+// never written to a caller buffer. Returns !0 on success.
+int fips_p256_ecdsa_sign_ssh(const uint32_t input[8], const p256_int *message,
+                             p256_int *r, p256_int *s)
+    __attribute__((warn_unused_result));
+
+// Returns 0 if {r,s} is not a signature on message for
+// public key {key_x,key_y}.
+//
+// Note: message is a p256_int.
+// Convert from a binary string using p256_from_bin().
+int fips_p256_ecdsa_verify(const p256_int *key_x, const p256_int *key_y,
+                           const p256_int *message, const p256_int *r,
+                           const p256_int *s)
+    __attribute__((warn_unused_result));
+
+// One (key, message, signature) tuple for batch verification.
+typedef struct {
+  const p256_int *key_x;
+  const p256_int *key_y;
+  const p256_int *message;
+  const p256_int *r;
+  const p256_int *s;
+} p256_ecdsa_verify_item;
+
+// Verify a batch of signatures in one pass, staging each tuple into
+// the already-initialized dcrypto engine so per-item setup cost is
+// paid once for the whole batch. Returns 0 if any signature in the
+// batch fails to verify (the whole batch is checked regardless).
+int fips_p256_ecdsa_verify_batch(const p256_ecdsa_verify_item *items,
+                                 size_t count)
+    __attribute__((warn_unused_result));
+
+// EC ops
+int fips_p256_base_point_mul(const p256_int *k, p256_int *x, p256_int *y)
+    __attribute__((warn_unused_result));
+int fips_p256_point_mul(const p256_int *k, const p256_int *in_x,
+                        const p256_int *in_y, p256_int *x, p256_int *y)
+    __attribute__((warn_unused_result));
+
+// ECDH key agreement (CTAP2 PIN protocol): writes SHA-256 of the
+// x-coordinate of d * {peer_x, peer_y} into shared_secret (P256_NBYTES
+// bytes). Rejects peer points that are not on the curve. The raw
+// x-coordinate never leaves the module. Returns !0 on success.
+int fips_p256_ecdh(const p256_int *d, const p256_int *peer_x,
+                   const p256_int *peer_y,
+                   uint8_t shared_secret[P256_NBYTES])
+    __attribute__((warn_unused_result));
+
+// Return whether point {x,y} is on curve.
+int fips_p256_is_valid_point(const p256_int *x, const p256_int *y)
+    __attribute__((warn_unused_result));
+
+// Return !0 if key_bytes makes a valid 0 < d < p256-groupsize
+int fips_p256_key_from_bytes(p256_int *x, p256_int *y, p256_int *d,
+                             const uint8_t key_bytes[P256_NBYTES])
+    __attribute__((warn_unused_result));
+
+//
+// Profiling.
+//
+// Internal routines of the resident p256 program that dcrypto_test's
+// DCRYPTO_PROFILE mode times individually. GET_BASE runs a handful of
+// register loads and serves as the per-call overhead baseline (syscall,
+// DMEM staging, completion interrupt); the rest are the building blocks
+// the full ladders and the sign/verify programs are made of.
+typedef enum {
+  P256_PROFILE_GET_BASE = 0,
+  P256_PROFILE_MULMOD,          // one modular multiply
+  P256_PROFILE_PROJ_ADD,        // projective point add
+  P256_PROFILE_PROJ_DOUBLE,     // projective point double
+  P256_PROFILE_MODINV,          // constant-time modular inverse
+  P256_PROFILE_PROJ_TO_AFFINE,  // ModInv plus the affine conversion
+  P256_PROFILE_BASE_MULT,       // full fixed-base scalar ladder
+  P256_PROFILE_SCALAR_MULT,     // full variable-base scalar ladder
+  P256_PROFILE_SIGN,            // complete sign program
+  P256_PROFILE_VERIFY,          // complete verify program
+  P256_PROFILE_COUNT
+} p256_profile_routine;
+
+// Load the p256 program, run its init and stage a placeholder DMEM
+// image so profiled calls measure steady-state cost. Returns 0 on
+// success. Requires init_fips() to have run.
+int fips_p256_profile_init(void) __attribute__((warn_unused_result));
+
+// Short label for a routine, for log lines.
+const char *fips_p256_profile_name(p256_profile_routine routine);
+
+// Run one routine against the resident image; returns 0 on success.
+// Inputs are the placeholders staged by init, so results are
+// meaningless — only the duration is. VERIFY runs a variable-time
+// inverse and may fault or wander on placeholder inputs; callers
+// should tolerate failure here.
+int fips_p256_profile_call(p256_profile_routine routine)
+    __attribute__((warn_unused_result));
+
+#endif  // __P256_ECDSA_H__
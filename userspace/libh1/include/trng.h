@@ -30,6 +30,13 @@ void fips_trng_startup(void);
  **/
 uint32_t fips_rand(void);
 
+/**
+ * Refill the entropy pool behind fips_rand() if it is running low.
+ * Called from the idle loop so that signing can draw nonce material
+ * from the pool without waiting on the TRNG.
+ **/
+void fips_trng_top_up(void);
+
 /**
  * Output len random bytes into buffer.
  **/
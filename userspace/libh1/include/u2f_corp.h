@@ -59,6 +59,7 @@ typedef struct {
 #define G2F_TUP 0x01     /* user presence required */
 #define G2F_CONSUME 0x02 /* consume presence */
 #define G2F_CHECK 0x04   /* test keyhandle */
+#define G2F_COMPACT_KH 0x08 /* mint compact v2 keyhandle */
 
 /* KH covert channel flags */
 #define G2F_KH_VERSION 0x01 /* fw version encoding present */
@@ -100,9 +101,17 @@ typedef struct {
 
 uint16_t apdu_rcv(const uint8_t *in, uint16_t in_len, uint8_t *out);
 
+/* One unit of idle-time precompute (key derivations, store mounts,
+ * DRBG reseeds); returns nonzero while warm-up work remains. */
+int u2f_idle_precompute(void);
+
 /* Encryption constants */
 #define AES_BLOCK_LEN 16
 #define KH_LEN 64
+/* Compact v2 keyhandle: the three cipher blocks carry all the key
+ * material (the v1 tail block is filler), so v2 follows them with an
+ * 8 byte fingerprint and stops. Saves 8 wire bytes per handle. */
+#define KH_V2_LEN 56
 
 /* Attestation certificate constants */
 #define SN_VERSION 0x02
@@ -71,6 +71,7 @@ typedef struct {
 #define U2FHID_INIT (TYPE_INIT | 0x06)
 #define U2FHID_PROMPT (TYPE_INIT | 0x07) /* slow, long blink */
 #define U2FHID_WINK (TYPE_INIT | 0x08)   /* fast, short blink */
+#define U2FHID_CBOR (TYPE_INIT | 0x10)   /* CTAP2 message (CTAPHID_CBOR) */
 #define U2FHID_SYNC (TYPE_INIT | 0x3c)
 #define U2FHID_ERROR (TYPE_INIT | 0x3F)
 
@@ -81,6 +82,7 @@ typedef struct {
 #define INIT_NONCE_SIZE 8 /* Size of channel initialization challenge */
 #define CAPFLAG_WINK 0x01 /* Supports WINK command */
 #define CAPFLAG_LOCK 0x02 /* Supports application lock */
+#define CAPFLAG_CBOR 0x04 /* Supports CBOR (CTAP2) messages */
 
 typedef struct {                  /* it's the cmd input FROM host */
   uint8_t nonce[INIT_NONCE_SIZE]; /* Client application nonce */
@@ -24,6 +24,31 @@
 /* Include the "official" FIDO header */
 #include "u2f_hid.h"
 
+/*
+ * Channel-error policy.
+ *
+ * Every U2FHID_ERROR the device emits falls into exactly one of two
+ * classes, applied uniformly by the transport's error handler:
+ *
+ *  - Message errors -- ERR_INVALID_CMD, ERR_INVALID_SEQ,
+ *    ERR_MSG_TIMEOUT. The in-flight message on the channel is corrupt
+ *    or unservable, so the channel's transaction state is reset. The
+ *    host's next INIT frame on the same CID starts a fresh transaction
+ *    with no further handshake.
+ *
+ *  - Frame errors -- ERR_INVALID_CID, ERR_INVALID_LEN,
+ *    ERR_CHANNEL_BUSY, ERR_OTHER. The offending frame is rejected but
+ *    any transaction already established on the channel is untouched;
+ *    the host may retry the same frame (or back off and resume)
+ *    without re-INIT.
+ *
+ * The split means a host never has to guess how much state survived
+ * an error: its transaction is either gone entirely or intact, by
+ * error code alone. The device counts every error sent, per code, in
+ * the U2FHID_LATENCY payload (see u2f_latency.h) so residual host
+ * retries show up in the field.
+ */
+
 #define USB_HID_SUBCLASS_NONE 0x00
 #define USB_HID_PROTOCOL_NONE 0x00
 
@@ -53,6 +78,18 @@ typedef struct {
 #define U2FHID_SYSINFO (TYPE_INIT | 0x05)
 #define U2FHID_DFU (TYPE_INIT | 0xba)
 
+/* Keepalive frame, device -> host only; payload is one status byte.
+ * Emitted on a timer while a command is being processed so hosts do
+ * not time out long sign operations. */
+#define U2FHID_KEEPALIVE (TYPE_INIT | 0x3b)
+
+/* Vendor command: fetch the device-side latency histograms (see
+ * u2f_latency.h for the payload layout). A nonzero first request byte
+ * resets the accumulated stats after they are reported. */
+#define U2FHID_LATENCY (TYPE_INIT | 0x41)
+#define KEEPALIVE_STATUS_PROCESSING 0x01
+#define KEEPALIVE_INTERVAL_MS 100
+
 /* U2F HID extensions for USB update */
 #define DFU_LOAD_BEGIN 0xfe
 #define DFU_LOAD_EXTENDED 0xfd
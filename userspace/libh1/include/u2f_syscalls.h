@@ -0,0 +1,100 @@
+// Copyright 2018 Google LLC
+//
+// Licensed under the Apache License, Version 2.0 (the "License");
+// you may not use this file except in compliance with the License.
+// You may obtain a copy of the License at
+//
+//     https://www.apache.org/licenses/LICENSE-2.0
+//
+// Unless required by applicable law or agreed to in writing, software
+// distributed under the License is distributed on an "AS IS" BASIS,
+// WITHOUT WARRANTIES OR CONDITIONS OF ANY KIND, either express or implied.
+// See the License for the specific language governing permissions and
+// limitations under the License.
+
+#ifndef TOCK_U2F_H
+#define TOCK_U2F_H
+
+#include <stdlib.h>
+
+// Size of a single U2F HID frame on the wire.
+#define TOCK_U2F_FRAME_SIZE 64
+
+// Check whether driver present (0 is success, means present)
+int tock_u2f_check(void);
+// Transmit as a frame from U2F endpoint. datalen must be <= 64.
+int tock_u2f_transmit(void* data, size_t datalen);
+// Receive a frame from U2F endopint. datalen must be <= 64.
+int tock_u2f_receive(void* data, size_t datalen);
+
+// Start transmitting a frame without waiting for it to leave the wire.
+// data must stay valid and unmodified until tock_u2f_transmit_wait()
+// returns. datalen must be <= 64.
+int tock_u2f_transmit_start(void* data, size_t datalen);
+// Wait for the transmit started by tock_u2f_transmit_start() to
+// complete. Returns immediately if none is in flight.
+int tock_u2f_transmit_wait(void);
+
+// Transmit nframes consecutive 64-byte frames from data with a single
+// kernel submission: the kernel streams the frames out back to back
+// and delivers one completion callback after the last one, instead of
+// one syscall pair and one wakeup per frame.
+int tock_u2f_transmit_frames(void* data, size_t nframes);
+
+// Share a ring of 64-byte frame slots with the kernel once; the kernel
+// fills successive slots as frames arrive and re-arms reception itself,
+// so no per-frame allow()/subscribe()/command() round trip is needed.
+// ringlen must be a multiple of TOCK_U2F_FRAME_SIZE and hold at least
+// two frames.
+int tock_u2f_receive_ring_setup(void* ring, size_t ringlen);
+// Let the kernel accumulate up to nframes ring slots per receive
+// callback instead of waking this process for every 64-byte frame. The
+// final frames of a U2FHID message are always delivered immediately,
+// so only continuation frames of large messages are batched. 0 or 1
+// restores a callback per frame.
+int tock_u2f_receive_coalesce(size_t nframes);
+// Wait for the next received frame and return a pointer to it inside
+// the ring. The frame may be parsed in place; its slot is not reused
+// until the ring wraps around.
+int tock_u2f_receive_frame(void** frame);
+// Number of received frames waiting in the ring. Does not yield, so a
+// dispatch loop can poll for frame work before taking on anything
+// lower priority.
+size_t tock_u2f_frames_pending(void);
+// Register a handler invoked when the USB bus resumes from suspend.
+// The kernel keeps the device configured across suspend, so transport
+// state (open channels, pending transactions) is still valid when the
+// handler runs.
+int tock_u2f_on_resume(void (*handler)(void));
+
+// Low-level chip accesses
+uint32_t tock_chip_dev_id0(void);
+uint32_t tock_chip_dev_id1(void);
+int tock_chip_category(void);
+
+// Robust counter. Backed by a RAM mirror over the nvcounter: the
+// persisted mark is flushed every stride increments and stays at or
+// above every value handed out, so counts may be skipped across a
+// reboot but never repeat. Returns the incremented value, or 0 if the
+// mark could not be persisted.
+unsigned int increment_counter(void);
+// Flush the persisted mark every `stride` increments instead of every
+// one (the default); in between, increments are pure RAM writes. The
+// same stride must be used across boots, since the recovered count is
+// mark * stride.
+void increment_counter_set_stride(unsigned int stride);
+
+enum touch_state {
+  POP_TOUCH_NO  = 0,
+  POP_TOUCH_YES = 1,
+};
+
+void tock_pop_enable_detection(void);
+void tock_pop_set(void);
+void tock_pop_clear(void);
+enum touch_state tock_pop_check_presence(int consume);
+// Microseconds since the latched touch edge, 0 if no touch is latched.
+// Useful for touch-to-response latency accounting.
+uint32_t tock_pop_touch_age_us(void);
+
+#endif
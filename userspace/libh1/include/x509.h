@@ -36,11 +36,15 @@
  * @param unique != 0 to generate a device individual certificate
  * @param cert Pointer to the output byte buffer
  * @param n Size of the output byte buffer
+ * @param cert_hash If non-NULL, receives the SHA-256 of the emitted
+ *   cert (8 words), computed inline during the final copy-out rather
+ *   than in a second pass over the buffer
  *
  * @return Number of bytes written to *cert
  */
 int generate_cert(const p256_int* d, const p256_int* pk_x, const p256_int* pk_y,
-                  int unique, uint8_t* cert, const int n);
+                  int unique, uint8_t* cert, const int n,
+                  uint32_t* cert_hash);
 
 int anonymous_cert(const p256_int* d, const p256_int* pk_x,
                    const p256_int* pk_y, uint8_t* cert, const int n);
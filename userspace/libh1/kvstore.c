@@ -0,0 +1,389 @@
+// Copyright 2019 Google LLC
+//
+// Licensed under the Apache License, Version 2.0 (the "License");
+// you may not use this file except in compliance with the License.
+// You may obtain a copy of the License at
+//
+//     https://www.apache.org/licenses/LICENSE-2.0
+//
+// Unless required by applicable law or agreed to in writing, software
+// distributed under the License is distributed on an "AS IS" BASIS,
+// WITHOUT WARRANTIES OR CONDITIONS OF ANY KIND, either express or implied.
+// See the License for the specific language governing permissions and
+// limitations under the License.
+
+#include <stdbool.h>
+#include <string.h>
+
+#include "fmt.h"
+#include "kvstore.h"
+#include "tock.h"
+
+#define H1_DRIVER_FLASH 0x40040
+
+#define TOCK_FLASH_CMD_CHECK     0
+#define TOCK_FLASH_CMD_ERASE     1
+#define TOCK_FLASH_CMD_WRITE     2
+#define TOCK_FLASH_CMD_READ      3
+
+#define TOCK_FLASH_ALLOW_WRITE   0
+#define TOCK_FLASH_ALLOW_READ    1
+
+#define TOCK_FLASH_OPERATION_DONE 0
+
+#define KV_PAGE_SIZE   2048
+// The kernel's flash write buffer holds 32 words, so writes are issued
+// in chunks of at most 128 bytes.
+#define KV_CHUNK       128
+#define KV_MAGIC       0x3153564b  // "KVS1"
+#define KV_HEADER_SIZE 8
+// Record length word marking a deletion.
+#define KV_TOMBSTONE   0x80000000
+// Value of an erased flash word.
+#define KV_ERASED      0xffffffff
+
+// Log layout. Each page starts with a two-word header {KV_MAGIC, seq};
+// the page with the highest sequence number is the active log.
+// Records follow the header back to back:
+//   word 0:  key (KV_ERASED is reserved)
+//   word 1:  value length in bytes, or KV_TOMBSTONE
+//   ...      value, padded with 0xff to a word boundary
+//   last:    checksum over all preceding record words, xor 0xa5a5a5a5
+// The checksum word is programmed last, so a record cut short by a
+// power loss fails verification and is discarded at the next mount.
+
+typedef struct {
+  bool fired;
+  int rc;
+} flash_op_t;
+
+static void tock_flash_op_done(int rc,
+                               int unused1 __attribute__((unused)),
+                               int unused2 __attribute__((unused)),
+                               void *callback_args) {
+  flash_op_t* op = (flash_op_t*)callback_args;
+  op->rc = rc;
+  op->fired = true;
+}
+
+static struct {
+  bool mounted;
+  unsigned int pages[2];  // flash page numbers
+  int active;             // index into pages
+  uint32_t seq;
+  uint32_t tail;          // byte offset of the first free word
+} kv;
+
+static uint8_t kv_chunk[KV_CHUNK];
+static uint8_t kv_record[KV_HEADER_SIZE + KVSTORE_MAX_VALUE + 4];
+
+static uint32_t kv_base(int page_index) {
+  return kv.pages[page_index] * KV_PAGE_SIZE;
+}
+
+static uint32_t kv_word(const uint8_t* bytes) {
+  return (uint32_t)bytes[0] | ((uint32_t)bytes[1] << 8) |
+         ((uint32_t)bytes[2] << 16) | ((uint32_t)bytes[3] << 24);
+}
+
+static int kv_flash_read(uint32_t offset, void* buf, size_t len) {
+  int ret = allow(H1_DRIVER_FLASH, TOCK_FLASH_ALLOW_READ, buf, len);
+  if (ret < 0) {
+    h1_printf("Could not give kernel access to kvstore read buffer.\n");
+    return ret;
+  }
+  ret = command(H1_DRIVER_FLASH, TOCK_FLASH_CMD_READ, offset, len);
+  if (ret < 0) {
+    h1_printf("Could not read kvstore flash.\n");
+    return ret;
+  }
+  return TOCK_SUCCESS;
+}
+
+static int kv_flash_write(uint32_t offset, const void* buf, size_t len) {
+  flash_op_t op;
+  int ret = subscribe(H1_DRIVER_FLASH, TOCK_FLASH_OPERATION_DONE,
+                      tock_flash_op_done, &op);
+  if (ret < 0) {
+    h1_printf("Could not register for kvstore flash callback.\n");
+    return ret;
+  }
+  for (size_t pos = 0; pos < len; pos += KV_CHUNK) {
+    size_t chunk = len - pos < KV_CHUNK ? len - pos : KV_CHUNK;
+    ret = allow(H1_DRIVER_FLASH, TOCK_FLASH_ALLOW_WRITE,
+                (uint8_t*)buf + pos, chunk);
+    if (ret < 0) {
+      h1_printf("Could not give kernel access to kvstore write buffer.\n");
+      return ret;
+    }
+    op.fired = false;
+    ret = command(H1_DRIVER_FLASH, TOCK_FLASH_CMD_WRITE, offset + pos, chunk);
+    if (ret < 0) {
+      h1_printf("Could not write kvstore flash.\n");
+      return ret;
+    }
+    yield_for(&op.fired);
+    if (op.rc != 0) {
+      h1_printf("kvstore flash write failed: %d\n", op.rc);
+      return TOCK_FAIL;
+    }
+  }
+  return TOCK_SUCCESS;
+}
+
+static int kv_flash_erase(unsigned int page) {
+  flash_op_t op;
+  op.fired = false;
+  int ret = subscribe(H1_DRIVER_FLASH, TOCK_FLASH_OPERATION_DONE,
+                      tock_flash_op_done, &op);
+  if (ret < 0) {
+    h1_printf("Could not register for kvstore flash callback.\n");
+    return ret;
+  }
+  ret = command(H1_DRIVER_FLASH, TOCK_FLASH_CMD_ERASE, page, 0);
+  if (ret < 0) {
+    h1_printf("Could not erase kvstore flash page.\n");
+    return ret;
+  }
+  yield_for(&op.fired);
+  if (op.rc != 0) {
+    h1_printf("kvstore flash erase failed: %d\n", op.rc);
+    return TOCK_FAIL;
+  }
+  return TOCK_SUCCESS;
+}
+
+// Reads and verifies the record at byte offset off in the given page.
+// Returns the record size in bytes, 0 at the end of the log, or -1 for
+// a record that is torn, corrupt or unreadable. key and lenword are
+// filled in on success.
+static int kv_record_at(int page_index, uint32_t off,
+                        uint32_t* key, uint32_t* lenword) {
+  if (off + 12 > KV_PAGE_SIZE) return 0;
+
+  uint8_t header[8];
+  if (kv_flash_read(kv_base(page_index) + off, header, 8) < 0) return -1;
+  *key = kv_word(header);
+  *lenword = kv_word(header + 4);
+
+  if (*key == KV_ERASED) {
+    // A clean tail is fully erased; anything else here is torn.
+    return *lenword == KV_ERASED ? 0 : -1;
+  }
+
+  uint32_t data_len;
+  if (*lenword == KV_TOMBSTONE) {
+    data_len = 0;
+  } else if (*lenword <= KVSTORE_MAX_VALUE) {
+    data_len = *lenword;
+  } else {
+    return -1;
+  }
+  uint32_t padded = (data_len + 3) & ~3u;
+  uint32_t size = KV_HEADER_SIZE + padded + 4;
+  if (off + size > KV_PAGE_SIZE) return -1;
+
+  // Verify the trailing checksum over the record's words.
+  uint32_t sum = *key + *lenword;
+  uint32_t pos = 0;
+  while (pos < padded + 4) {
+    uint32_t chunk = padded + 4 - pos;
+    if (chunk > KV_CHUNK) chunk = KV_CHUNK;
+    if (kv_flash_read(kv_base(page_index) + off + KV_HEADER_SIZE + pos,
+                      kv_chunk, chunk) < 0) {
+      return -1;
+    }
+    for (uint32_t i = 0; i < chunk; i += 4) {
+      if (pos + i == padded) {
+        if ((sum ^ 0xa5a5a5a5) != kv_word(kv_chunk + i)) return -1;
+      } else {
+        sum += kv_word(kv_chunk + i);
+      }
+    }
+    pos += chunk;
+  }
+  return size;
+}
+
+// Copies the live records of the active page into the other page, then
+// commits the new page by programming its header and erases the old
+// one. A crash before the header write leaves the old page valid; a
+// crash after it leaves the new page valid and the old page is erased
+// here on the next compaction.
+static int kv_compact(void) {
+  int src = kv.active;
+  int dst = 1 - src;
+  int ret = kv_flash_erase(kv.pages[dst]);
+  if (ret < 0) return ret;
+
+  uint32_t new_tail = KV_HEADER_SIZE;
+  uint32_t key, lenword;
+  int size;
+  for (uint32_t off = KV_HEADER_SIZE;
+       (size = kv_record_at(src, off, &key, &lenword)) > 0;
+       off += size) {
+    // Only the newest record for each key survives.
+    bool newest = true;
+    uint32_t key2, lenword2;
+    int size2;
+    for (uint32_t off2 = off + size;
+         (size2 = kv_record_at(src, off2, &key2, &lenword2)) > 0;
+         off2 += size2) {
+      if (key2 == key) {
+        newest = false;
+        break;
+      }
+    }
+    if (!newest || lenword == KV_TOMBSTONE) continue;
+
+    for (int pos = 0; pos < size; pos += KV_CHUNK) {
+      uint32_t chunk = (uint32_t)(size - pos) < KV_CHUNK ?
+                       (uint32_t)(size - pos) : KV_CHUNK;
+      ret = kv_flash_read(kv_base(src) + off + pos, kv_chunk, chunk);
+      if (ret < 0) return ret;
+      ret = kv_flash_write(kv_base(dst) + new_tail + pos, kv_chunk, chunk);
+      if (ret < 0) return ret;
+    }
+    new_tail += size;
+  }
+
+  uint32_t header[2] = {KV_MAGIC, kv.seq + 1};
+  ret = kv_flash_write(kv_base(dst), header, sizeof(header));
+  if (ret < 0) return ret;
+  ret = kv_flash_erase(kv.pages[src]);
+  if (ret < 0) return ret;
+
+  kv.active = dst;
+  kv.seq = kv.seq + 1;
+  kv.tail = new_tail;
+  return TOCK_SUCCESS;
+}
+
+static int kv_append(uint32_t key, uint32_t lenword,
+                     const void* value, size_t len) {
+  if (!kv.mounted) return TOCK_FAIL;
+  if (key == KV_ERASED) return TOCK_EINVAL;
+
+  uint32_t padded = ((uint32_t)len + 3) & ~3u;
+  uint32_t size = KV_HEADER_SIZE + padded + 4;
+  if (kv.tail + size > KV_PAGE_SIZE) {
+    int ret = kv_compact();
+    if (ret < 0) return ret;
+    if (kv.tail + size > KV_PAGE_SIZE) return TOCK_ENOMEM;
+  }
+
+  memcpy(kv_record, &key, 4);
+  memcpy(kv_record + 4, &lenword, 4);
+  if (len > 0) memcpy(kv_record + KV_HEADER_SIZE, value, len);
+  memset(kv_record + KV_HEADER_SIZE + len, 0xff, padded - len);
+  uint32_t sum = key + lenword;
+  for (uint32_t i = 0; i < padded; i += 4) {
+    sum += kv_word(kv_record + KV_HEADER_SIZE + i);
+  }
+  sum ^= 0xa5a5a5a5;
+  memcpy(kv_record + KV_HEADER_SIZE + padded, &sum, 4);
+
+  int ret = kv_flash_write(kv_base(kv.active) + kv.tail, kv_record, size);
+  if (ret < 0) return ret;
+  kv.tail += size;
+  return TOCK_SUCCESS;
+}
+
+int tock_kvstore_init(unsigned int first_page) {
+  int ret = command(H1_DRIVER_FLASH, TOCK_FLASH_CMD_CHECK, 0, 0);
+  if (ret < 0) {
+    h1_printf("No flash driver for kvstore.\n");
+    return ret;
+  }
+
+  kv.mounted = false;
+  kv.pages[0] = first_page;
+  kv.pages[1] = first_page + 1;
+
+  uint8_t header[8];
+  uint32_t seq[2];
+  bool valid[2];
+  for (int i = 0; i < 2; i++) {
+    ret = kv_flash_read(kv_base(i), header, 8);
+    if (ret < 0) return ret;
+    seq[i] = kv_word(header + 4);
+    valid[i] = kv_word(header) == KV_MAGIC && seq[i] != KV_ERASED;
+  }
+
+  if (!valid[0] && !valid[1]) {
+    // Fresh pages: format page 0 as the first generation.
+    ret = kv_flash_erase(kv.pages[0]);
+    if (ret < 0) return ret;
+    uint32_t fresh[2] = {KV_MAGIC, 1};
+    ret = kv_flash_write(kv_base(0), fresh, sizeof(fresh));
+    if (ret < 0) return ret;
+    kv.active = 0;
+    kv.seq = 1;
+    kv.tail = KV_HEADER_SIZE;
+    kv.mounted = true;
+    return TOCK_SUCCESS;
+  }
+
+  // Both pages are valid after a crash between compaction's commit and
+  // its erase of the old page; the newer generation wins.
+  if (valid[0] && valid[1]) {
+    kv.active = seq[1] > seq[0] ? 1 : 0;
+  } else {
+    kv.active = valid[1] ? 1 : 0;
+  }
+  kv.seq = seq[kv.active];
+
+  uint32_t key, lenword;
+  int size;
+  uint32_t off = KV_HEADER_SIZE;
+  while ((size = kv_record_at(kv.active, off, &key, &lenword)) > 0) {
+    off += size;
+  }
+  kv.tail = off;
+  kv.mounted = true;
+  if (size < 0) {
+    // A torn record from an interrupted put occupies the tail; compact
+    // onto the other page to reclaim the space.
+    return kv_compact();
+  }
+  return TOCK_SUCCESS;
+}
+
+int tock_kvstore_put(uint32_t key, const void* value, size_t len) {
+  if (len > KVSTORE_MAX_VALUE) return TOCK_ESIZE;
+  return kv_append(key, (uint32_t)len, value, len);
+}
+
+int tock_kvstore_delete(uint32_t key) {
+  return kv_append(key, KV_TOMBSTONE, NULL, 0);
+}
+
+int tock_kvstore_get(uint32_t key, void* value, size_t max_len) {
+  if (!kv.mounted) return TOCK_FAIL;
+
+  uint32_t found_off = 0;
+  uint32_t found_len = 0;
+  bool found = false;
+  uint32_t scan_key, lenword;
+  int size;
+  for (uint32_t off = KV_HEADER_SIZE;
+       (size = kv_record_at(kv.active, off, &scan_key, &lenword)) > 0;
+       off += size) {
+    if (scan_key != key) continue;
+    if (lenword == KV_TOMBSTONE) {
+      found = false;
+    } else {
+      found = true;
+      found_off = off + KV_HEADER_SIZE;
+      found_len = lenword;
+    }
+  }
+  if (!found) return TOCK_FAIL;
+
+  uint32_t copy_len = found_len < max_len ? found_len : (uint32_t)max_len;
+  if (copy_len > 0) {
+    int ret = kv_flash_read(kv_base(kv.active) + found_off, value, copy_len);
+    if (ret < 0) return ret;
+  }
+  return (int)found_len;
+}
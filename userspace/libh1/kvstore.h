@@ -0,0 +1,60 @@
+// Copyright 2019 Google LLC
+//
+// Licensed under the Apache License, Version 2.0 (the "License");
+// you may not use this file except in compliance with the License.
+// You may obtain a copy of the License at
+//
+//     https://www.apache.org/licenses/LICENSE-2.0
+//
+// Unless required by applicable law or agreed to in writing, software
+// distributed under the License is distributed on an "AS IS" BASIS,
+// WITHOUT WARRANTIES OR CONDITIONS OF ANY KIND, either express or implied.
+// See the License for the specific language governing permissions and
+// limitations under the License.
+
+#ifndef TOCK_KVSTORE_H
+#define TOCK_KVSTORE_H
+
+#include <stddef.h>
+#include <stdint.h>
+
+// A small log-structured key/value store over the kernel flash driver.
+//
+// The store owns two consecutive 2KB flash pages. One page holds an
+// append-only log of records, so a put is O(1) amortized: it programs
+// only the new record's words and never rewrites existing data. When
+// the log page fills up, the live records are compacted into the other
+// page and the old page is erased, spreading erase cycles evenly across
+// both pages.
+//
+// Each record carries a checksum that is programmed last, so a record
+// interrupted by a power loss is detected and discarded on the next
+// mount; compaction commits the new page by programming its header only
+// after every live record has been copied, so a crash at any point
+// leaves either the old or the new page as the valid generation.
+//
+// Lookups scan the log, so their cost grows with the number of records
+// written since the last compaction.
+
+// Largest value a single record can hold, in bytes.
+#define KVSTORE_MAX_VALUE 256
+
+// Mounts the store on flash pages first_page and first_page + 1,
+// formatting them if neither holds a valid log. Must be called before
+// any other kvstore function.
+int tock_kvstore_init(unsigned int first_page);
+
+// Appends a record setting key to the given value (len bytes, at most
+// KVSTORE_MAX_VALUE). Compacts the log first if the record does not
+// fit.
+int tock_kvstore_put(uint32_t key, const void* value, size_t len);
+
+// Copies the current value for key into value (at most max_len bytes)
+// and returns its full length, or TOCK_FAIL if the key is not present.
+int tock_kvstore_get(uint32_t key, void* value, size_t max_len);
+
+// Appends a tombstone for key; the entry is reclaimed at the next
+// compaction. Deleting an absent key succeeds.
+int tock_kvstore_delete(uint32_t key);
+
+#endif
@@ -13,12 +13,15 @@
 // limitations under the License.
 
 #include "nvcounter_syscalls.h"
+#include "fmt.h"
 #include "tock.h"
 
 #define H1_DRIVER_NVCOUNTER 0x80040000
 
 #define TOCK_NVCOUNTER_CMD_CHECK   0
 #define TOCK_NVCOUNTER_CMD_INCREMENT     1
+#define TOCK_NVCOUNTER_CMD_SET_STRIDE    2
+#define TOCK_NVCOUNTER_CMD_READ          3
 
 #define TOCK_NVCOUNTER_INCREMENT_DONE    0
 
@@ -45,6 +48,21 @@ int tock_nvcounter_check(void) {
   return command(H1_DRIVER_NVCOUNTER, TOCK_NVCOUNTER_CMD_CHECK, 0, 0);
 }
 
+int tock_nvcounter_set_stride(unsigned int stride) {
+  return command(H1_DRIVER_NVCOUNTER, TOCK_NVCOUNTER_CMD_SET_STRIDE,
+                 stride, 0);
+}
+
+int tock_nvcounter_read(unsigned int* counter) {
+  int ret = command(H1_DRIVER_NVCOUNTER, TOCK_NVCOUNTER_CMD_READ, 0, 0);
+  if (ret < 0) {
+    h1_printf("Could not read NV counter: %s (%i).\n", tock_strerror(ret), ret);
+    return ret;
+  }
+  *counter = (unsigned int)ret;
+  return TOCK_SUCCESS;
+}
+
 int tock_nvcounter_increment(unsigned int* counter) {
   int ret = 0;
   bool increment_done = false;
@@ -52,14 +70,14 @@ int tock_nvcounter_increment(unsigned int* counter) {
   ret = subscribe(H1_DRIVER_NVCOUNTER, TOCK_NVCOUNTER_INCREMENT_DONE,
                   tock_nvcounter_increment_done, &increment_done);
   if (ret < 0) {
-    printf("Could not register for NV counter increment callback.\n");
+    h1_printf("Could not register for NV counter increment callback.\n");
     return ret;
   }
 
   ret = command(H1_DRIVER_NVCOUNTER, TOCK_NVCOUNTER_CMD_INCREMENT,
                 0, 0);
   if (ret < 0) {
-    printf("Could not increment NV counter: %s (%i).\n", tock_strerror(ret), ret);
+    h1_printf("Could not increment NV counter: %s (%i).\n", tock_strerror(ret), ret);
     return ret;
   }
 
@@ -17,8 +17,22 @@
 
 int tock_nvcounter_check(void);
 
+// Configures the kernel's write-coalescing stride (1-256). Each flash
+// write then covers `stride` increments: the persisted value is a
+// high-water mark that always stays at or above the true count, and
+// increments under the mark complete without a flash write. A stride of
+// 1 (the default) writes flash on every increment. The same stride must
+// be used across boots, since the recovered count is strikes * stride.
+int tock_nvcounter_set_stride(unsigned int stride);
+
 // Returns whether the increment was successful; if so, the
 // incremented value is stored in counter.
 int tock_nvcounter_increment(unsigned int* counter);
 
+// Reads the current counter value without incrementing it. Served from
+// the kernel's RAM mirror, so it consumes no flash cycles and returns
+// synchronously (no callback). Returns TOCK_SUCCESS with the value
+// stored in counter, or a negative error.
+int tock_nvcounter_read(unsigned int* counter);
+
 #endif
@@ -54,4 +54,14 @@ void fips_p256_to_bin(const p256_int* src, uint8_t dst[]);
 
 void fips_p256_init(p256_int* a);
 
+// Software ECDSA P-256 verify: Montgomery-form field arithmetic with
+// 64-bit (UMULL) accumulation, Jacobian point math, Shamir
+// double-scalar multiply. Verify handles only public data, so this
+// path is not constant time. Returns 1 if the signature verifies.
+// Used as the fallback when the dcrypto engine is occupied; see
+// fips_p256_ecdsa_verify().
+int fips_p256_ecdsa_verify_sw(const p256_int* key_x, const p256_int* key_y,
+                              const p256_int* message, const p256_int* r,
+                              const p256_int* s);
+
 #endif  //_F_P256_H__
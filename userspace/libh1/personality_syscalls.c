@@ -13,13 +13,17 @@
 // limitations under the License.
 
 #include "personality_syscalls.h"
+#include "fmt.h"
 #include "tock.h"
 
 #define H1_DRIVER_PERSONALITY 0x5000b
 
-#define TOCK_PERSONALITY_CMD_CHECK   0
-#define TOCK_PERSONALITY_CMD_GET     1
-#define TOCK_PERSONALITY_CMD_SET     2
+#define TOCK_PERSONALITY_CMD_CHECK    0
+#define TOCK_PERSONALITY_CMD_GET      1
+#define TOCK_PERSONALITY_CMD_SET      2
+#define TOCK_PERSONALITY_CMD_GET_PTR  3
+#define TOCK_PERSONALITY_CMD_UPDATE   4
+#define TOCK_PERSONALITY_CMD_VALID    5
 
 #define TOCK_PERSONALITY_ALLOW       0
 
@@ -32,6 +36,26 @@ static void tock_personality_set_done(int unused0 __attribute__((unused)),
   *(bool*)callback_args = true;
 }
 
+// State for an outstanding asynchronous write. Only one may be in
+// flight at a time; the kernel driver serializes writes anyway.
+static struct {
+  bool busy;
+  tock_personality_callback callback;
+  void* user_data;
+} async_set;
+
+static void tock_personality_set_done_async(int result,
+                                            int unused1 __attribute__((unused)),
+                                            int unused2 __attribute__((unused)),
+                                            void *callback_args __attribute__((unused))) {
+  tock_personality_callback callback = async_set.callback;
+  void* user_data = async_set.user_data;
+  async_set.busy = false;
+  if (callback != NULL) {
+    callback(result == 0 ? TOCK_SUCCESS : TOCK_FAIL, user_data);
+  }
+}
+
 int tock_personality_check(void) {
   return command(H1_DRIVER_PERSONALITY, TOCK_PERSONALITY_CMD_CHECK, 0, 0);
 }
@@ -42,41 +66,118 @@ int tock_get_personality(perso_st* personality) {
   ret = allow(H1_DRIVER_PERSONALITY, TOCK_PERSONALITY_ALLOW,
               personality, sizeof(perso_st));
   if (ret < 0) {
-    printf("Could not give kernel access to personality buffer.\n");
+    h1_printf("Could not give kernel access to personality buffer.\n");
     return ret;
   }
 
   ret = command(H1_DRIVER_PERSONALITY, TOCK_PERSONALITY_CMD_GET,
                 0, 0);
   if (ret < 0) {
-    printf("Could not get H1 personality from kernel.\n");
+    h1_printf("Could not get H1 personality from kernel.\n");
     return ret;
   }
 
   return TOCK_SUCCESS;
 }
 
+int tock_personality_cert_valid(void) {
+  return command(H1_DRIVER_PERSONALITY, TOCK_PERSONALITY_CMD_VALID, 0, 0) == 1;
+}
+
+int tock_get_personality_ptr(const perso_st** personality) {
+  int ret = command(H1_DRIVER_PERSONALITY, TOCK_PERSONALITY_CMD_GET_PTR, 0, 0);
+  if (ret < 0) {
+    h1_printf("Could not get H1 personality address from kernel.\n");
+    return ret;
+  }
+  *personality = (const perso_st*)ret;
+  return TOCK_SUCCESS;
+}
+
 int tock_set_personality(const perso_st* personality) {
   int ret = 0;
   bool set_done = false;
   ret = subscribe(H1_DRIVER_PERSONALITY, TOCK_PERSONALITY_SET_DONE,
                   tock_personality_set_done, &set_done);
   if (ret < 0) {
-    printf("Could not register for personality set done callback.\n");
+    h1_printf("Could not register for personality set done callback.\n");
+    return ret;
+  }
+
+  ret = allow(H1_DRIVER_PERSONALITY, TOCK_PERSONALITY_ALLOW,
+              (perso_st*)personality, sizeof(perso_st));
+  if (ret < 0) {
+    h1_printf("Could not give kernel access to personality buffer.\n");
+    return ret;
+  }
+
+  ret = command(H1_DRIVER_PERSONALITY, TOCK_PERSONALITY_CMD_SET,
+                0, 0);
+  if (ret < 0) {
+    h1_printf("Could not get H1 personality from kernel.\n");
+    return ret;
+  }
+  yield_for(&set_done);
+
+  return TOCK_SUCCESS;
+}
+
+int tock_set_personality_async(const perso_st* personality,
+                               tock_personality_callback callback,
+                               void* user_data) {
+  int ret = 0;
+  if (async_set.busy) {
+    return TOCK_EBUSY;
+  }
+
+  ret = subscribe(H1_DRIVER_PERSONALITY, TOCK_PERSONALITY_SET_DONE,
+                  tock_personality_set_done_async, NULL);
+  if (ret < 0) {
+    h1_printf("Could not register for personality set done callback.\n");
     return ret;
   }
 
   ret = allow(H1_DRIVER_PERSONALITY, TOCK_PERSONALITY_ALLOW,
               (perso_st*)personality, sizeof(perso_st));
   if (ret < 0) {
-    printf("Could not give kernel access to personality buffer.\n");
+    h1_printf("Could not give kernel access to personality buffer.\n");
     return ret;
   }
 
   ret = command(H1_DRIVER_PERSONALITY, TOCK_PERSONALITY_CMD_SET,
                 0, 0);
   if (ret < 0) {
-    printf("Could not get H1 personality from kernel.\n");
+    h1_printf("Could not set H1 personality.\n");
+    return ret;
+  }
+
+  async_set.busy = true;
+  async_set.callback = callback;
+  async_set.user_data = user_data;
+  return TOCK_SUCCESS;
+}
+
+int tock_update_personality(size_t offset, const void* data, size_t len) {
+  int ret = 0;
+  bool set_done = false;
+  ret = subscribe(H1_DRIVER_PERSONALITY, TOCK_PERSONALITY_SET_DONE,
+                  tock_personality_set_done, &set_done);
+  if (ret < 0) {
+    h1_printf("Could not register for personality set done callback.\n");
+    return ret;
+  }
+
+  ret = allow(H1_DRIVER_PERSONALITY, TOCK_PERSONALITY_ALLOW,
+              (void*)data, len);
+  if (ret < 0) {
+    h1_printf("Could not give kernel access to personality update buffer.\n");
+    return ret;
+  }
+
+  ret = command(H1_DRIVER_PERSONALITY, TOCK_PERSONALITY_CMD_UPDATE,
+                offset, 0);
+  if (ret < 0) {
+    h1_printf("Could not update H1 personality.\n");
     return ret;
   }
   yield_for(&set_done);
@@ -17,8 +17,43 @@
 
 #include "storage.h"
 
+// Signature for personality write completion callbacks. result is
+// TOCK_SUCCESS if the data was committed to flash and negative on
+// failure.
+typedef void (*tock_personality_callback)(int result, void* user_data);
+
 int tock_personality_check(void);
+
+// Returns nonzero if the kernel verified at boot that the stored
+// certificate hashes to cert_hash and nothing has been written since.
+// Nonzero lets the caller skip its own pass over the 2KB certificate;
+// zero means it must verify for itself.
+int tock_personality_cert_valid(void);
 int tock_get_personality(perso_st* personality);
 int tock_set_personality(const perso_st* personality);
 
+// Starts a durable personality write and returns without waiting for
+// the flash operation; the callback runs from yield() once the write
+// has committed. The caller must keep *personality unchanged until
+// then. Useful when the caller has to keep servicing other work (e.g.
+// HID keepalives) during the multi-millisecond erase/program cycle.
+// Returns TOCK_EBUSY if an asynchronous write is already outstanding.
+int tock_set_personality_async(const perso_st* personality,
+                               tock_personality_callback callback,
+                               void* user_data);
+
+// Retrieves a read-only pointer to the flash-resident personality,
+// avoiding the 2KB copy that tock_get_personality() performs. The data
+// is valid until the next tock_set_personality(). Only usable on boards
+// whose MPU configuration permits userspace reads of kernel flash;
+// reading through the pointer faults otherwise.
+int tock_get_personality_ptr(const perso_st** personality);
+
+// Updates len bytes of the stored personality starting offset bytes into
+// the perso_st, leaving the rest untouched. The kernel performs a
+// read-modify-write that only erases/programs the affected flash words,
+// so updating a single field (e.g. cert_len or the salt) is much cheaper
+// than rewriting the full 2KB structure with tock_set_personality().
+int tock_update_personality(size_t offset, const void* data, size_t len);
+
 #endif
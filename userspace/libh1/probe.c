@@ -1,4 +1,4 @@
-// Copyright 2019 Google LLC
+// Copyright 2021 Google LLC
 //
 // Licensed under the Apache License, Version 2.0 (the "License");
 // you may not use this file except in compliance with the License.
@@ -12,15 +12,26 @@
 // See the License for the specific language governing permissions and
 // limitations under the License.
 
-#ifndef __FIPS_ENTROPY_H
-#define __FIPS_ENTROPY_H
+#include "probe.h"
 
-void flash_info_read_enable(uint32_t addr, uint32_t size);
-void flash_info_read_enable(uint32_t addr, uint32_t size) {}
+#include <gpio.h>
 
-uint32_t flash_physical_info_read_word(uint32_t addr);
-uint32_t flash_physical_info_read_word(uint32_t addr) {
-  return fips_entropy[addr];
+int tock_probe_init(unsigned int pin) {
+  int ret = gpio_enable_output(pin);
+  if (ret < 0) return ret;
+  return gpio_clear(pin);
 }
 
-#endif
+int tock_probe_hi(unsigned int pin) {
+  return gpio_set(pin);
+}
+
+int tock_probe_lo(unsigned int pin) {
+  return gpio_clear(pin);
+}
+
+int tock_probe_pulse(unsigned int pin) {
+  int ret = gpio_set(pin);
+  if (ret < 0) return ret;
+  return gpio_clear(pin);
+}
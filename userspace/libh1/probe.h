@@ -0,0 +1,43 @@
+// Copyright 2021 Google LLC
+//
+// Licensed under the Apache License, Version 2.0 (the "License");
+// you may not use this file except in compliance with the License.
+// You may obtain a copy of the License at
+//
+//     https://www.apache.org/licenses/LICENSE-2.0
+//
+// Unless required by applicable law or agreed to in writing, software
+// distributed under the License is distributed on an "AS IS" BASIS,
+// WITHOUT WARRANTIES OR CONDITIONS OF ANY KIND, either express or implied.
+// See the License for the specific language governing permissions and
+// limitations under the License.
+
+#ifndef TOCK_PROBE_H
+#define TOCK_PROBE_H
+
+// App-level logic-analyzer probe points, the userspace counterpart to
+// the kernel's `probes` feature (kernel/h1/src/probe.rs). The kernel
+// flips its probe pins with a raw register store at interrupt-path
+// events; an app can only get at a pin through the GPIO syscall
+// driver, so an app-level probe edge costs one command syscall (a few
+// microseconds). That is still an order of magnitude sharper than a
+// console print, and the edge lands on the wire at the instrumented
+// line of code, not when the UART drains.
+//
+// Probes address pins by the GPIO capsule's pin index. On golf2 the
+// capsule exposes pins 0 and 1 — the same pads the kernel probes
+// drive, so capture either the kernel's events or the app's on a
+// given pad, not both.
+
+// Configures the pin as an output, driven low. Returns a tock error
+// on failure (e.g. no GPIO driver).
+int tock_probe_init(unsigned int pin);
+
+// Edge primitives; each is one GPIO command syscall.
+int tock_probe_hi(unsigned int pin);
+int tock_probe_lo(unsigned int pin);
+
+// A high-then-low blip for point events (two syscalls).
+int tock_probe_pulse(unsigned int pin);
+
+#endif  // TOCK_PROBE_H
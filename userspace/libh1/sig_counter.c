@@ -0,0 +1,119 @@
+// Copyright 2021 Google LLC
+//
+// Licensed under the Apache License, Version 2.0 (the "License");
+// you may not use this file except in compliance with the License.
+// You may obtain a copy of the License at
+//
+//     https://www.apache.org/licenses/LICENSE-2.0
+//
+// Unless required by applicable law or agreed to in writing, software
+// distributed under the License is distributed on an "AS IS" BASIS,
+// WITHOUT WARRANTIES OR CONDITIONS OF ANY KIND, either express or implied.
+// See the License for the specific language governing permissions and
+// limitations under the License.
+
+#include <string.h>
+
+#include "sig_counter.h"
+#include "kvstore.h"
+#include "tock.h"
+
+// Counter records live under a 'C' prefix so they cannot collide with
+// the other records sharing the store (KAT cache, seed store).
+#define SIG_COUNTER_KEY(o)                                     \
+  (0x43000000u | ((uint32_t)(o)[0] << 16) | ((uint32_t)(o)[1] << 8) | \
+   (uint32_t)(o)[2])
+#define SIG_COUNTER_FLOOR_KEY 0x464c5231 /* "FLR1" */
+
+// Hot-origin cache; misses reload from the kvstore. Entries need no
+// writeback on eviction since the flash record always runs ahead of
+// the live value.
+#define SIG_COUNTER_CACHE 8
+
+typedef struct {
+  uint32_t key;
+  uint32_t value;   /* last value handed out */
+  uint32_t ceiling; /* value the flash record covers up to */
+} sig_counter_ent;
+
+static sig_counter_ent cache[SIG_COUNTER_CACHE];
+static uint8_t cache_next;
+
+/* Lower bound applied when (re)loading any record, from the floor
+ * record as it stood at mount. Covers counters whose own record was
+ * lost with the store. */
+static uint32_t floor_at_mount;
+
+/* Live floor record value; raised ahead of the global maximum. */
+static uint32_t floor_ceiling;
+
+static int counters_ready;
+
+int tock_sig_counter_init(void) {
+  uint32_t stored = 0;
+
+  if (tock_kvstore_get(SIG_COUNTER_FLOOR_KEY, &stored, sizeof(stored)) !=
+      (int)sizeof(stored))
+    stored = 0;
+
+  floor_at_mount = stored;
+  floor_ceiling = stored;
+  memset(cache, 0, sizeof(cache));
+  counters_ready = 1;
+  return TOCK_SUCCESS;
+}
+
+static sig_counter_ent *sig_counter_load(uint32_t key) {
+  sig_counter_ent *ent;
+  uint32_t stored = 0;
+  int i;
+
+  for (i = 0; i < SIG_COUNTER_CACHE; ++i) {
+    if (cache[i].key == key) return &cache[i];
+  }
+
+  /* Miss: reload from flash, round robin eviction. The record is a
+   * ceiling over everything ever handed out for this origin, so
+   * resuming at it (or at the mount-time floor) can skip values but
+   * never repeat one. */
+  if (tock_kvstore_get(key, &stored, sizeof(stored)) != (int)sizeof(stored))
+    stored = 0;
+  if (stored < floor_at_mount) stored = floor_at_mount;
+
+  ent = &cache[cache_next];
+  cache_next = (cache_next + 1) % SIG_COUNTER_CACHE;
+  ent->key = key;
+  ent->value = stored;
+  ent->ceiling = stored;
+  return ent;
+}
+
+uint32_t tock_sig_counter_incr(const uint8_t *origin) {
+  sig_counter_ent *ent;
+  uint32_t next;
+
+  if (!counters_ready) return 0;
+
+  ent = sig_counter_load(SIG_COUNTER_KEY(origin));
+  next = ent->value + 1;
+
+  /* Raise the records before handing out a value they do not cover;
+   * amortized this is one append per BATCH signatures per origin. */
+  if (next > ent->ceiling) {
+    uint32_t c = next + SIG_COUNTER_BATCH - 1;
+
+    if (tock_kvstore_put(ent->key, &c, sizeof(c)) != TOCK_SUCCESS) return 0;
+    ent->ceiling = c;
+  }
+  if (next > floor_ceiling) {
+    uint32_t f = next + SIG_COUNTER_FLOOR_BATCH - 1;
+
+    if (tock_kvstore_put(SIG_COUNTER_FLOOR_KEY, &f, sizeof(f)) !=
+        TOCK_SUCCESS)
+      return 0;
+    floor_ceiling = f;
+  }
+
+  ent->value = next;
+  return next;
+}
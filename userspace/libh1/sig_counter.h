@@ -0,0 +1,52 @@
+// Copyright 2021 Google LLC
+//
+// Licensed under the Apache License, Version 2.0 (the "License");
+// you may not use this file except in compliance with the License.
+// You may obtain a copy of the License at
+//
+//     https://www.apache.org/licenses/LICENSE-2.0
+//
+// Unless required by applicable law or agreed to in writing, software
+// distributed under the License is distributed on an "AS IS" BASIS,
+// WITHOUT WARRANTIES OR CONDITIONS OF ANY KIND, either express or implied.
+// See the License for the specific language governing permissions and
+// limitations under the License.
+
+#ifndef TOCK_SIG_COUNTER_H
+#define TOCK_SIG_COUNTER_H
+
+#include <stdint.h>
+
+// Per-origin U2F signature counters over the kvstore.
+//
+// The single global counter contends on one flash hot spot and lets
+// relying parties correlate usage across origins. Here each origin
+// gets its own counter record, and persistence is batched: the flash
+// record holds a ceiling SIG_COUNTER_BATCH ahead of the live value and
+// is only rewritten when the live value catches up, so an
+// authentication burst costs one kvstore append per BATCH signatures
+// per origin. The record is always raised before a value above it is
+// handed out, so a crash can skip counter values but never repeat one.
+// A global floor record, batched the same way, bounds every counter
+// from below at mount time and covers origins whose record is lost
+// with the store.
+
+// How far the flash records run ahead of the live values.
+#define SIG_COUNTER_BATCH 8
+#define SIG_COUNTER_FLOOR_BATCH 64
+
+// Bytes of the origin identifier used to key the counter record.
+#define SIG_COUNTER_ORIGIN_BYTES 3
+
+// Loads the global floor. The kvstore must already be mounted (the
+// counters share the app's store). Returns TOCK_SUCCESS on success.
+int tock_sig_counter_init(void);
+
+// Increments and returns the counter for origin (an appId hash; only
+// the first SIG_COUNTER_ORIGIN_BYTES key the record, so hash-close
+// origins may share a counter, which is monotonic either way).
+// Returns 0 if the store is unavailable or the persistence write
+// fails; 0 is never a valid counter value.
+uint32_t tock_sig_counter_incr(const uint8_t *origin);
+
+#endif  // TOCK_SIG_COUNTER_H
@@ -0,0 +1,46 @@
+// Copyright 2021 Google LLC
+//
+// Licensed under the Apache License, Version 2.0 (the "License");
+// you may not use this file except in compliance with the License.
+// You may obtain a copy of the License at
+//
+//     https://www.apache.org/licenses/LICENSE-2.0
+//
+// Unless required by applicable law or agreed to in writing, software
+// distributed under the License is distributed on an "AS IS" BASIS,
+// WITHOUT WARRANTIES OR CONDITIONS OF ANY KIND, either express or implied.
+// See the License for the specific language governing permissions and
+// limitations under the License.
+
+#include "stack_watermark.h"
+#include "tock.h"
+
+#define STACK_PAINT_WORD 0xc5c5c5c5u
+
+/* Tock memop operations used here. */
+#define MEMOP_MEMORY_START 2
+#define MEMOP_MEMORY_END 3
+#define MEMOP_GRANT_START 6
+
+void tock_stack_paint(void) {
+  uint32_t *base = (uint32_t *)(uintptr_t)memop(MEMOP_MEMORY_START, 0);
+  uint32_t marker;
+  /* Guard below the live frame for this function's own use. */
+  uint32_t *top = (uint32_t *)(((uintptr_t)&marker - 64) & ~(uintptr_t)3);
+
+  while (base < top) *base++ = STACK_PAINT_WORD;
+}
+
+uint32_t tock_stack_headroom(void) {
+  const uint32_t *p = (const uint32_t *)(uintptr_t)memop(MEMOP_MEMORY_START, 0);
+  const uint32_t *end = (const uint32_t *)(uintptr_t)memop(MEMOP_MEMORY_END, 0);
+  uint32_t n = 0;
+
+  while (&p[n] < end && p[n] == STACK_PAINT_WORD) n++;
+  return n * sizeof(uint32_t);
+}
+
+uint32_t tock_grant_bytes(void) {
+  return (uint32_t)memop(MEMOP_MEMORY_END, 0) -
+         (uint32_t)memop(MEMOP_GRANT_START, 0);
+}
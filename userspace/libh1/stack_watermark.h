@@ -0,0 +1,39 @@
+// Copyright 2021 Google LLC
+//
+// Licensed under the Apache License, Version 2.0 (the "License");
+// you may not use this file except in compliance with the License.
+// You may obtain a copy of the License at
+//
+//     https://www.apache.org/licenses/LICENSE-2.0
+//
+// Unless required by applicable law or agreed to in writing, software
+// distributed under the License is distributed on an "AS IS" BASIS,
+// WITHOUT WARRANTIES OR CONDITIONS OF ANY KIND, either express or implied.
+// See the License for the specific language governing permissions and
+// limitations under the License.
+
+#ifndef TOCK_STACK_WATERMARK_H
+#define TOCK_STACK_WATERMARK_H
+
+#include <stdint.h>
+
+// Stack and grant watermark readouts.
+//
+// Each app's STACK_SIZE is set by guesswork and oversized stacks
+// starve the buffer pools. Painting the unused stack at boot and
+// reading the high-water mark after real traffic turns resizing into
+// measurement. The paint covers from the bottom of process RAM (where
+// crt0 places the stack) up to just below the live frame.
+
+// Call early in main(), before deep call paths run.
+void tock_stack_paint(void);
+
+// Bytes of painted stack never touched since tock_stack_paint(): the
+// amount STACK_SIZE could shrink by, less margin.
+uint32_t tock_stack_headroom(void);
+
+// Bytes the kernel's grant allocations have carved off the top of
+// process RAM, across all drivers.
+uint32_t tock_grant_bytes(void);
+
+#endif  // TOCK_STACK_WATERMARK_H
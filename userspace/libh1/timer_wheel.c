@@ -0,0 +1,147 @@
+// Copyright 2021 Google LLC
+//
+// Licensed under the Apache License, Version 2.0 (the "License");
+// you may not use this file except in compliance with the License.
+// You may obtain a copy of the License at
+//
+//     https://www.apache.org/licenses/LICENSE-2.0
+//
+// Unless required by applicable law or agreed to in writing, software
+// distributed under the License is distributed on an "AS IS" BASIS,
+// WITHOUT WARRANTIES OR CONDITIONS OF ANY KIND, either express or implied.
+// See the License for the specific language governing permissions and
+// limitations under the License.
+
+#include "timer_wheel.h"
+
+#include <timer.h>
+
+#include "tock.h"
+
+// Deadlines are kept in kernel alarm ticks, read straight from the
+// alarm driver, so wheel arithmetic does not drift against the clock
+// the underlying timer sleeps on. Tick values wrap; comparisons go
+// through a signed difference, which is correct as long as no deadline
+// is more than half the 32-bit tick range out.
+#define DRIVER_ALARM 0x0
+#define ALARM_CMD_FREQUENCY 1
+#define ALARM_CMD_READ 2
+
+typedef struct {
+  uint32_t deadline;  /* absolute, in alarm ticks */
+  uint32_t period_ms; /* 0 for one-shot */
+  timer_wheel_cb cb;
+  void *data;
+  uint8_t in_use;
+} WHEEL_SLOT;
+
+static WHEEL_SLOT wheel[TIMER_WHEEL_SLOTS];
+static tock_timer_t wheel_timer;
+static uint8_t wheel_armed;
+static uint32_t ticks_per_ms;
+
+static void wheel_fire(int unused0, int unused1, int unused2, void *ud);
+
+static uint32_t wheel_now(void) {
+  return (uint32_t)command(DRIVER_ALARM, ALARM_CMD_READ, 0, 0);
+}
+
+static uint32_t ms_to_ticks(uint32_t ms) {
+  if (ticks_per_ms == 0) {
+    uint32_t freq =
+        (uint32_t)command(DRIVER_ALARM, ALARM_CMD_FREQUENCY, 0, 0);
+    ticks_per_ms = freq >= 1000 ? freq / 1000 : 1;
+  }
+  return ms * ticks_per_ms;
+}
+
+/* Re-arm the underlying timer at the earliest pending deadline (or
+ * cancel it when the wheel is empty). */
+static void wheel_rearm(uint32_t now) {
+  uint32_t best = 0;
+  int found = 0;
+  int i;
+
+  for (i = 0; i < TIMER_WHEEL_SLOTS; i++) {
+    uint32_t due_in;
+
+    if (!wheel[i].in_use) continue;
+    due_in = wheel[i].deadline - now;
+    if ((int32_t)due_in < 0) due_in = 0;
+    if (!found || due_in < best) {
+      best = due_in;
+      found = 1;
+    }
+  }
+
+  if (wheel_armed) {
+    timer_cancel(&wheel_timer);
+    wheel_armed = 0;
+  }
+  if (!found) return;
+
+  /* Round up so the wheel never wakes before the earliest deadline. */
+  timer_in(best / ms_to_ticks(1) + 1, wheel_fire, NULL, &wheel_timer);
+  wheel_armed = 1;
+}
+
+/* Batch expiry: one wakeup runs every timer due by now, then the
+ * underlying timer is re-armed once. Periodic timers re-arm relative
+ * to now, so a late wakeup stretches the period instead of bunching
+ * the next firings. */
+static void wheel_fire(int unused0 __attribute__((unused)),
+                       int unused1 __attribute__((unused)),
+                       int unused2 __attribute__((unused)),
+                       void *ud __attribute__((unused))) {
+  uint32_t now = wheel_now();
+  int i;
+
+  wheel_armed = 0;
+  for (i = 0; i < TIMER_WHEEL_SLOTS; i++) {
+    WHEEL_SLOT *s = &wheel[i];
+
+    if (!s->in_use) continue;
+    if ((int32_t)(s->deadline - now) > 0) continue;
+    if (s->period_ms) {
+      s->deadline = now + ms_to_ticks(s->period_ms);
+    } else {
+      s->in_use = 0;
+    }
+    /* The callback may add or cancel wheel timers; the re-arm below
+     * recomputes from scratch either way. */
+    s->cb(s->data);
+  }
+  wheel_rearm(wheel_now());
+}
+
+static int wheel_claim(uint32_t ms, uint32_t period_ms, timer_wheel_cb cb,
+                       void *data) {
+  uint32_t now = wheel_now();
+  int i;
+
+  for (i = 0; i < TIMER_WHEEL_SLOTS; i++) {
+    if (wheel[i].in_use) continue;
+    wheel[i].deadline = now + ms_to_ticks(ms);
+    wheel[i].period_ms = period_ms;
+    wheel[i].cb = cb;
+    wheel[i].data = data;
+    wheel[i].in_use = 1;
+    wheel_rearm(now);
+    return i;
+  }
+  return -1;
+}
+
+int timer_wheel_in(uint32_t ms, timer_wheel_cb cb, void *data) {
+  return wheel_claim(ms, 0, cb, data);
+}
+
+int timer_wheel_every(uint32_t ms, timer_wheel_cb cb, void *data) {
+  return wheel_claim(ms, ms, cb, data);
+}
+
+void timer_wheel_cancel(int id) {
+  if (id < 0 || id >= TIMER_WHEEL_SLOTS || !wheel[id].in_use) return;
+  wheel[id].in_use = 0;
+  wheel_rearm(wheel_now());
+}
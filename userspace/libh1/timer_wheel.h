@@ -0,0 +1,50 @@
+// Copyright 2021 Google LLC
+//
+// Licensed under the Apache License, Version 2.0 (the "License");
+// you may not use this file except in compliance with the License.
+// You may obtain a copy of the License at
+//
+//     https://www.apache.org/licenses/LICENSE-2.0
+//
+// Unless required by applicable law or agreed to in writing, software
+// distributed under the License is distributed on an "AS IS" BASIS,
+// WITHOUT WARRANTIES OR CONDITIONS OF ANY KIND, either express or implied.
+// See the License for the specific language governing permissions and
+// limitations under the License.
+
+#ifndef TOCK_TIMER_WHEEL_H
+#define TOCK_TIMER_WHEEL_H
+
+#include <stdint.h>
+
+// Software timer wheel over a single kernel alarm.
+//
+// Each libtock timer claims its own kernel alarm and pays a syscall
+// pair per re-arm, which adds up for code juggling several concurrent
+// timeouts (the U2F transport's keepalive, per-channel reassembly
+// timeouts and channel lock expiry). The wheel multiplexes up to
+// TIMER_WHEEL_SLOTS soft timers onto one underlying timer armed at the
+// earliest deadline; when it fires, every expired timer's callback
+// runs in the same pass and the underlying timer is re-armed once.
+//
+// Callbacks run from the kernel timer callback, i.e. during a yield(),
+// like libtock timer callbacks. Slot ids are reused after expiry or
+// cancel, so don't cancel an id after its one-shot callback has run.
+
+#define TIMER_WHEEL_SLOTS 8
+
+typedef void (*timer_wheel_cb)(void *data);
+
+// Runs cb(data) once, ms milliseconds from now. Returns the timer id,
+// or -1 if all slots are in use.
+int timer_wheel_in(uint32_t ms, timer_wheel_cb cb, void *data);
+
+// Runs cb(data) every ms milliseconds until canceled. Returns the
+// timer id, or -1 if all slots are in use.
+int timer_wheel_every(uint32_t ms, timer_wheel_cb cb, void *data);
+
+// Cancels a pending timer. Harmless on an already-expired one-shot id
+// only if the slot has not been handed out again.
+void timer_wheel_cancel(int id);
+
+#endif  // TOCK_TIMER_WHEEL_H
@@ -0,0 +1,63 @@
+// Copyright 2021 Google LLC
+//
+// Licensed under the Apache License, Version 2.0 (the "License");
+// you may not use this file except in compliance with the License.
+// You may obtain a copy of the License at
+//
+//     https://www.apache.org/licenses/LICENSE-2.0
+//
+// Unless required by applicable law or agreed to in writing, software
+// distributed under the License is distributed on an "AS IS" BASIS,
+// WITHOUT WARRANTIES OR CONDITIONS OF ANY KIND, either express or implied.
+// See the License for the specific language governing permissions and
+// limitations under the License.
+
+#include "timestamp_syscalls.h"
+#include "tock.h"
+
+#define H1_DRIVER_TIMESTAMP 0x40080
+
+#define TOCK_TIMESTAMP_CMD_CHECK 0
+#define TOCK_TIMESTAMP_CMD_READ  1
+#define TOCK_TIMESTAMP_CMD_DUMP_PROFILE 2
+#define TOCK_TIMESTAMP_CMD_READ64_LOW  3
+#define TOCK_TIMESTAMP_CMD_READ64_HIGH 4
+#define TOCK_TIMESTAMP_CMD_SLEEP_US    5
+#define TOCK_TIMESTAMP_CMD_SLEEP_COUNT 6
+#define TOCK_TIMESTAMP_CMD_CRYPTO_US   7
+
+int tock_timestamp_check(void) {
+  return command(H1_DRIVER_TIMESTAMP, TOCK_TIMESTAMP_CMD_CHECK, 0, 0);
+}
+
+uint32_t gettimeus(void) {
+  return (uint32_t)command(H1_DRIVER_TIMESTAMP, TOCK_TIMESTAMP_CMD_READ, 0, 0);
+}
+
+uint64_t gettimeus64(void) {
+  // The kernel latches the high word when the low word is read, so the
+  // pair is one consistent sample.
+  uint32_t low =
+      (uint32_t)command(H1_DRIVER_TIMESTAMP, TOCK_TIMESTAMP_CMD_READ64_LOW, 0, 0);
+  uint32_t high =
+      (uint32_t)command(H1_DRIVER_TIMESTAMP, TOCK_TIMESTAMP_CMD_READ64_HIGH, 0, 0);
+  return ((uint64_t)high << 32) | low;
+}
+
+int tock_syscall_profile_dump(void) {
+  return command(H1_DRIVER_TIMESTAMP, TOCK_TIMESTAMP_CMD_DUMP_PROFILE, 0, 0);
+}
+
+uint32_t tock_pmu_sleep_us(void) {
+  return (uint32_t)command(H1_DRIVER_TIMESTAMP, TOCK_TIMESTAMP_CMD_SLEEP_US, 0, 0);
+}
+
+uint32_t tock_pmu_sleep_count(void) {
+  return (uint32_t)command(H1_DRIVER_TIMESTAMP, TOCK_TIMESTAMP_CMD_SLEEP_COUNT,
+                           0, 0);
+}
+
+uint32_t tock_pmu_crypto_us(void) {
+  return (uint32_t)command(H1_DRIVER_TIMESTAMP, TOCK_TIMESTAMP_CMD_CRYPTO_US, 0,
+                           0);
+}
@@ -0,0 +1,52 @@
+// Copyright 2021 Google LLC
+//
+// Licensed under the Apache License, Version 2.0 (the "License");
+// you may not use this file except in compliance with the License.
+// You may obtain a copy of the License at
+//
+//     https://www.apache.org/licenses/LICENSE-2.0
+//
+// Unless required by applicable law or agreed to in writing, software
+// distributed under the License is distributed on an "AS IS" BASIS,
+// WITHOUT WARRANTIES OR CONDITIONS OF ANY KIND, either express or implied.
+// See the License for the specific language governing permissions and
+// limitations under the License.
+
+#ifndef TOCK_TIMESTAMP_H
+#define TOCK_TIMESTAMP_H
+
+#include <stdint.h>
+
+int tock_timestamp_check(void);
+
+// Returns the current value of the kernel's free-running microsecond
+// counter. One command() syscall, no allow, no yield: a read costs a
+// few microseconds end to end, so it is safe to call on hot paths.
+// The counter wraps every ~71 minutes; compute intervals as
+// gettimeus() - start in uint32_t arithmetic.
+uint32_t gettimeus(void);
+
+// Like gettimeus(), but widened to 64 bits by the kernel so it stays
+// monotonic across counter wraps. Two command() syscalls instead of
+// one; prefer gettimeus() for hot-path interval measurements.
+uint64_t gettimeus64(void);
+
+// Asks the kernel to print its syscall/interrupt latency profile over
+// the debug console and reset it. Only kernels built with the
+// syscall_profile feature record anything; otherwise this succeeds and
+// prints nothing.
+int tock_syscall_profile_dump(void);
+
+// PMU power-state telemetry, accumulated since boot. Benchmarks
+// sample before and after the measured section and report the diffs
+// (sleep time over wall time approximates the duty cycle; the sleep
+// count exposes wakeup churn). All three wrap in uint32_t like
+// gettimeus(), so compute diffs in uint32_t arithmetic.
+uint32_t tock_pmu_sleep_us(void);
+uint32_t tock_pmu_sleep_count(void);
+
+// Time the crypto engine clocks were held at full rate by in-flight
+// operations: the denominator for attributing energy to signing work.
+uint32_t tock_pmu_crypto_us(void);
+
+#endif
@@ -0,0 +1,55 @@
+// Copyright 2021 Google LLC
+//
+// Licensed under the Apache License, Version 2.0 (the "License");
+// you may not use this file except in compliance with the License.
+// You may obtain a copy of the License at
+//
+//     https://www.apache.org/licenses/LICENSE-2.0
+//
+// Unless required by applicable law or agreed to in writing, software
+// distributed under the License is distributed on an "AS IS" BASIS,
+// WITHOUT WARRANTIES OR CONDITIONS OF ANY KIND, either express or implied.
+// See the License for the specific language governing permissions and
+// limitations under the License.
+
+#include "fmt.h"
+
+#include "trace.h"
+
+// Power of two so the ring indices wrap with a mask. 64 records x 12
+// bytes keeps the whole thing under 1KB of RAM.
+#define TRACE_RING_ENTRIES 64
+#define TRACE_RING_MASK (TRACE_RING_ENTRIES - 1)
+
+typedef struct {
+  uint16_t id;
+  uint16_t seq;
+  uint32_t a0;
+  uint32_t a1;
+} trace_rec;
+
+static trace_rec ring[TRACE_RING_ENTRIES];
+static uint32_t wr;       // total records ever written
+static uint32_t rd;       // next record to drain
+static uint16_t next_seq; // global ordering across flushes
+
+void trace_emit(uint16_t id, uint32_t a0, uint32_t a1) {
+  trace_rec* r = &ring[wr & TRACE_RING_MASK];
+  r->id = id;
+  r->seq = next_seq++;
+  r->a0 = a0;
+  r->a1 = a1;
+  wr++;
+  // Ring overrun: advance the drain point past the record we just
+  // clobbered. The seq gap makes the loss visible in the output.
+  if (wr - rd > TRACE_RING_ENTRIES) rd = wr - TRACE_RING_ENTRIES;
+}
+
+void trace_flush(void) {
+  while (rd != wr) {
+    const trace_rec* r = &ring[rd & TRACE_RING_MASK];
+    h1_printf("T%04x %02x %08lx %08lx\n", r->seq, r->id, (unsigned long)r->a0,
+           (unsigned long)r->a1);
+    rd++;
+  }
+}
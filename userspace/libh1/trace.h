@@ -0,0 +1,90 @@
+// Copyright 2021 Google LLC
+//
+// Licensed under the Apache License, Version 2.0 (the "License");
+// you may not use this file except in compliance with the License.
+// You may obtain a copy of the License at
+//
+//     https://www.apache.org/licenses/LICENSE-2.0
+//
+// Unless required by applicable law or agreed to in writing, software
+// distributed under the License is distributed on an "AS IS" BASIS,
+// WITHOUT WARRANTIES OR CONDITIONS OF ANY KIND, either express or implied.
+// See the License for the specific language governing permissions and
+// limitations under the License.
+
+#ifndef TOCK_TRACE_H
+#define TOCK_TRACE_H
+
+#include <stdint.h>
+
+// Binary, non-blocking trace facility. A printf() on a hot path stalls
+// the app for milliseconds of UART formatting and draining; trace_emit
+// instead writes a fixed-size record (event id + two raw arguments)
+// into a RAM ring and returns. The ring is drained with trace_flush()
+// from an idle point — the U2F app's main loop does this between
+// frames — which is when the formatting cost is actually paid.
+//
+// Use the TRACE_ERR/TRACE_INFO macros rather than trace_emit directly;
+// they compile out below the build's TRACE_LEVEL:
+//   0  everything off
+//   1  errors only
+//   2  errors + informational events (default)
+// Override per app with e.g. CPPFLAGS += -DTRACE_LEVEL=0.
+
+#ifndef TRACE_LEVEL
+#define TRACE_LEVEL 2
+#endif
+
+// Event ids. Keep values stable; host-side tooling matches on them.
+enum trace_id {
+  // libh1 digest driver
+  TRACE_DIGEST_SET_INPUT = 0x10,
+  TRACE_DIGEST_SET_OUTPUT = 0x11,
+  TRACE_DIGEST_INITIALIZE = 0x12,
+  TRACE_DIGEST_UPDATE = 0x13,
+  TRACE_DIGEST_FINALIZE = 0x14,
+  TRACE_DIGEST_STREAM_ATTACH = 0x15,
+  TRACE_DIGEST_STREAM_UPDATE = 0x16,
+
+  // U2F transport (u2f_app)
+  TRACE_U2F_RX_ERR = 0x30,
+  TRACE_U2F_BAD_CID = 0x31,
+  TRACE_U2F_EXPECTED_CONT = 0x32,
+  TRACE_U2F_BAD_LEN = 0x33,
+  TRACE_U2F_SLOTS_FULL = 0x34,
+  TRACE_U2F_SPURIOUS_CONT = 0x35,
+  TRACE_U2F_BAD_SEQ = 0x36,
+  TRACE_U2F_CHANNEL_LOCKED = 0x37,
+  TRACE_U2F_TXN_CANCELLED = 0x38,
+  TRACE_U2F_BAD_FRAME_TYPE = 0x39,
+  TRACE_U2F_RESUMED = 0x3a,
+
+  // u2f_test load generator (U2F_LOADGEN mode)
+  TRACE_LG_RX = 0x40,            // a0 = seq, a1 = queue depth after enqueue
+  TRACE_LG_CRYPTO_START = 0x41,  // a0 = seq, a1 = op
+  TRACE_LG_CRYPTO_DONE = 0x42,   // a0 = seq, a1 = crypto us
+  TRACE_LG_TX = 0x43,            // a0 = seq, a1 = total us
+  TRACE_LG_DROP = 0x44,          // a0 = seq, a1 = drops so far
+};
+
+// Appends a record to the ring; never blocks, never prints. When the
+// ring is full the oldest record is overwritten and the loss counted.
+void trace_emit(uint16_t id, uint32_t a0, uint32_t a1);
+
+// Formats and prints the buffered records over the console, oldest
+// first, then empties the ring. Call from idle context only.
+void trace_flush(void);
+
+#if TRACE_LEVEL >= 1
+#define TRACE_ERR(id, a0, a1) trace_emit((id), (uint32_t)(a0), (uint32_t)(a1))
+#else
+#define TRACE_ERR(id, a0, a1) ((void)0)
+#endif
+
+#if TRACE_LEVEL >= 2
+#define TRACE_INFO(id, a0, a1) trace_emit((id), (uint32_t)(a0), (uint32_t)(a1))
+#else
+#define TRACE_INFO(id, a0, a1) ((void)0)
+#endif
+
+#endif  // TOCK_TRACE_H
@@ -0,0 +1,53 @@
+// Copyright 2021 Google LLC
+//
+// Licensed under the Apache License, Version 2.0 (the "License");
+// you may not use this file except in compliance with the License.
+// You may obtain a copy of the License at
+//
+//     https://www.apache.org/licenses/LICENSE-2.0
+//
+// Unless required by applicable law or agreed to in writing, software
+// distributed under the License is distributed on an "AS IS" BASIS,
+// WITHOUT WARRANTIES OR CONDITIONS OF ANY KIND, either express or implied.
+// See the License for the specific language governing permissions and
+// limitations under the License.
+
+#include "tracelog_syscalls.h"
+#include "tock.h"
+
+#define H1_DRIVER_TRACELOG 0x40090
+
+#define TOCK_TRACELOG_CMD_CHECK       0
+#define TOCK_TRACELOG_CMD_EMIT        1
+#define TOCK_TRACELOG_CMD_AVAILABLE   2
+#define TOCK_TRACELOG_CMD_DRAIN       3
+#define TOCK_TRACELOG_CMD_RECORD_SIZE 4
+
+#define TOCK_TRACELOG_ALLOW_DRAIN 0
+
+int tock_tracelog_check(void) {
+  return command(H1_DRIVER_TRACELOG, TOCK_TRACELOG_CMD_CHECK, 0, 0);
+}
+
+int tock_tracelog_emit(uint32_t id, uint32_t arg) {
+  return command(H1_DRIVER_TRACELOG, TOCK_TRACELOG_CMD_EMIT, id, arg);
+}
+
+int tock_tracelog_available(void) {
+  return command(H1_DRIVER_TRACELOG, TOCK_TRACELOG_CMD_AVAILABLE, 0, 0);
+}
+
+int tock_tracelog_record_size(void) {
+  return command(H1_DRIVER_TRACELOG, TOCK_TRACELOG_CMD_RECORD_SIZE, 0, 0);
+}
+
+int tock_tracelog_drain(void* buf, size_t len) {
+  int ret = allow(H1_DRIVER_TRACELOG, TOCK_TRACELOG_ALLOW_DRAIN, buf, len);
+  if (ret < 0) return ret;
+
+  ret = command(H1_DRIVER_TRACELOG, TOCK_TRACELOG_CMD_DRAIN, 0, 0);
+
+  // Drop the kernel's reference before handing the bytes back.
+  allow(H1_DRIVER_TRACELOG, TOCK_TRACELOG_ALLOW_DRAIN, NULL, 0);
+  return ret;
+}
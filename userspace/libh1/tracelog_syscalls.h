@@ -0,0 +1,48 @@
+// Copyright 2021 Google LLC
+//
+// Licensed under the Apache License, Version 2.0 (the "License");
+// you may not use this file except in compliance with the License.
+// You may obtain a copy of the License at
+//
+//     https://www.apache.org/licenses/LICENSE-2.0
+//
+// Unless required by applicable law or agreed to in writing, software
+// distributed under the License is distributed on an "AS IS" BASIS,
+// WITHOUT WARRANTIES OR CONDITIONS OF ANY KIND, either express or implied.
+// See the License for the specific language governing permissions and
+// limitations under the License.
+
+#ifndef TOCK_TRACELOG_H
+#define TOCK_TRACELOG_H
+
+#include <stddef.h>
+#include <stdint.h>
+
+// Wrappers for the kernel's binary trace stream driver (a RAM ring of
+// fixed-size records, h1::trace_stream). Writers append a record with
+// one syscall and no formatting; the low_level_debug app drains the
+// ring and streams the raw records over the UART. The driver is only
+// live on kernels built with the trace_stream feature — callers should
+// check first and skip instrumentation otherwise.
+
+// Returns TOCK_SUCCESS if the kernel stream is present.
+int tock_tracelog_check(void);
+
+// Appends one record tagged with this app. id and arg are opaque to
+// the kernel; the record is timestamped and sequence-numbered on the
+// way in.
+int tock_tracelog_emit(uint32_t id, uint32_t arg);
+
+// Number of records waiting in the kernel ring.
+int tock_tracelog_available(void);
+
+// Serialized size of one record in bytes, so drainers do not hard-code
+// the layout.
+int tock_tracelog_record_size(void);
+
+// Copies whole records into buf (shared with the kernel for the
+// duration of the call) and returns the number of bytes written, 0 if
+// the ring is empty, or a negative error.
+int tock_tracelog_drain(void* buf, size_t len);
+
+#endif  // TOCK_TRACELOG_H
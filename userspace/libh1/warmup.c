@@ -0,0 +1,51 @@
+// Copyright 2021 Google LLC
+//
+// Licensed under the Apache License, Version 2.0 (the "License");
+// you may not use this file except in compliance with the License.
+// You may obtain a copy of the License at
+//
+//     https://www.apache.org/licenses/LICENSE-2.0
+//
+// Unless required by applicable law or agreed to in writing, software
+// distributed under the License is distributed on an "AS IS" BASIS,
+// WITHOUT WARRANTIES OR CONDITIONS OF ANY KIND, either express or implied.
+// See the License for the specific language governing permissions and
+// limitations under the License.
+
+#include "warmup.h"
+#include "tock.h"
+
+// The H1 drivers libh1 wraps. Kept in sync with the driver numbers in
+// the individual *_syscalls.c files.
+static const uint32_t warmup_drivers[] = {
+  0x20008,      // u2f transport
+  0x40003,      // digest
+  0x40004,      // dcrypto
+  0x40010,      // aes
+  0x40040,      // flash (kvstore)
+  0x40080,      // timestamp
+  0x5000b,      // personality
+  0x80040000,   // nvcounter
+};
+
+int tock_warmup(void) {
+  int ret = TOCK_SUCCESS;
+  for (unsigned int i = 0;
+       i < sizeof(warmup_drivers) / sizeof(warmup_drivers[0]); i++) {
+    uint32_t driver = warmup_drivers[i];
+
+    // Absent driver: nothing to allocate for it on this board.
+    if (command(driver, 0 /* check */, 0, 0) < 0) {
+      continue;
+    }
+
+    // An empty subscribe makes the driver enter (and so allocate) this
+    // process's grant state. Drivers that take no subscriptions
+    // (timestamp) return ENOSUPPORT and allocate on their first command
+    // instead; only ENOMEM means the grant region is exhausted.
+    if (subscribe(driver, 0, NULL, NULL) == TOCK_ENOMEM) {
+      ret = TOCK_ENOMEM;
+    }
+  }
+  return ret;
+}
@@ -0,0 +1,29 @@
+// Copyright 2021 Google LLC
+//
+// Licensed under the Apache License, Version 2.0 (the "License");
+// you may not use this file except in compliance with the License.
+// You may obtain a copy of the License at
+//
+//     https://www.apache.org/licenses/LICENSE-2.0
+//
+// Unless required by applicable law or agreed to in writing, software
+// distributed under the License is distributed on an "AS IS" BASIS,
+// WITHOUT WARRANTIES OR CONDITIONS OF ANY KIND, either express or implied.
+// See the License for the specific language governing permissions and
+// limitations under the License.
+
+#ifndef TOCK_WARMUP_H
+#define TOCK_WARMUP_H
+
+// Touches every H1 driver libh1 talks to, so their per-process grant
+// state is allocated now rather than on the first real syscall. Call
+// once during app init, before registering any callbacks (the warmup
+// issues empty subscribes, which would clear them): afterwards,
+// steady-state syscalls never allocate, and an under-sized grant
+// region fails here instead of during the first authentication.
+//
+// Drivers a board does not expose are skipped; returns TOCK_ENOMEM if
+// any present driver failed to allocate, TOCK_SUCCESS otherwise.
+int tock_warmup(void);
+
+#endif  // TOCK_WARMUP_H
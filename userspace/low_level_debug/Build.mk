@@ -12,4 +12,4 @@
 # See the License for the specific language governing permissions and
 # limitations under the License.
 
-RUST_APPS += low_level_debug
+C_APPS += low_level_debug
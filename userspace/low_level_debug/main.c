@@ -0,0 +1,93 @@
+// Copyright 2019 Google LLC
+//
+// Licensed under the Apache License, Version 2.0 (the "License");
+// you may not use this file except in compliance with the License.
+// You may obtain a copy of the License at
+//
+//     https://www.apache.org/licenses/LICENSE-2.0
+//
+// Unless required by applicable law or agreed to in writing, software
+// distributed under the License is distributed on an "AS IS" BASIS,
+// WITHOUT WARRANTIES OR CONDITIONS OF ANY KIND, either express or implied.
+// See the License for the specific language governing permissions and
+// limitations under the License.
+
+// Drainer for the kernel's binary trace stream (h1::trace_stream): the
+// transport that carries trace and syscall-profiler records off the
+// device without formatting them on it. Writers - the kernel, and apps
+// via tock_tracelog_emit() - append fixed-size records to a RAM ring;
+// this app opportunistically pulls them out in batches and streams
+// them over the UART console as framed binary:
+//
+//   'T' 'R' 'C' version  count[2]  record_bytes[2]  records...
+//
+// Everything in a record is set kernel-side (timestamp, source,
+// sequence number), so this app adds no per-record cost to the writers
+// and the only timing effect of tracing is the ring write itself. The
+// host tool resynchronizes on the frame magic and detects loss from
+// gaps in the per-record sequence numbers, which the kernel leaves
+// when the ring overwrites undrained records rather than ever blocking
+// a writer.
+//
+// Requires a kernel built with the trace_stream feature; otherwise the
+// app prints a note and exits.
+
+#include <stdio.h>
+#include <string.h>
+#include <timer.h>
+#include <tock.h>
+#include <console.h>
+
+#include "tracelog_syscalls.h"
+
+#define FRAME_VERSION 1
+// Batch size: whole records only; sized for a comfortable multiple of
+// the kernel's 20-byte records without assuming their exact size.
+#define DRAIN_BUF_BYTES 480
+
+static uint8_t drain_buf[DRAIN_BUF_BYTES];
+static uint8_t frame[8 + DRAIN_BUF_BYTES];
+
+int main(void) {
+  int record_bytes;
+
+  delay_ms(2000);
+
+  if (tock_tracelog_check() != TOCK_SUCCESS) {
+    printf("No kernel trace stream (build the kernel with the "
+           "trace_stream feature); exiting.\n");
+    return 0;
+  }
+  record_bytes = tock_tracelog_record_size();
+  if (record_bytes <= 0 || record_bytes > DRAIN_BUF_BYTES) {
+    printf("Bad trace record size %d; exiting.\n", record_bytes);
+    return 1;
+  }
+  printf("Trace stream drainer: %d-byte records, %d per batch.\n",
+         record_bytes, DRAIN_BUF_BYTES / record_bytes);
+
+  while (1) {
+    int n = tock_tracelog_drain(drain_buf,
+                                (DRAIN_BUF_BYTES / record_bytes) *
+                                    record_bytes);
+    if (n > 0) {
+      int count = n / record_bytes;
+      frame[0] = 'T';
+      frame[1] = 'R';
+      frame[2] = 'C';
+      frame[3] = FRAME_VERSION;
+      frame[4] = (uint8_t)(count & 0xff);
+      frame[5] = (uint8_t)(count >> 8);
+      frame[6] = (uint8_t)(record_bytes & 0xff);
+      frame[7] = (uint8_t)(record_bytes >> 8);
+      memcpy(frame + 8, drain_buf, n);
+      putnstr((char*)frame, 8 + n);
+      // Keep draining at full rate while the ring has a backlog.
+      if (tock_tracelog_available() > 0) continue;
+    }
+    // Idle: let the writers run. 10ms of slack is far less than the
+    // time the 128-entry kernel ring takes to fill under any load that
+    // leaves the CPU alive.
+    delay_ms(10);
+  }
+}
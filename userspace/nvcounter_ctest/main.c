@@ -13,24 +13,138 @@
 // limitations under the License.
 
 // This tests the the nonvolatile counter userspace library.
+//
+// Built with NVCOUNTER_BENCH=<iters> the app runs a benchmark instead:
+// it times every increment, prints sustained increments/sec and the
+// per-increment latency percentiles, and reports the first increment's
+// latency separately since that one absorbs any recovery work left by
+// an interrupted increment on the previous boot. With
+// NVCOUNTER_BENCH_RESET=1 as well, each run ends by firing an increment
+// and resetting the chip before it completes, so a harness that just
+// leaves the board rebooting collects one recovery-time sample per boot
+// from the console log. The worst of those first-increment latencies
+// bounds the counter's contribution to boot time. Reset injection needs
+// the reset driver, which only the papa board installs.
 
 #include "nvcounter_syscalls.h"
 #include "timer.h"
+#include "timestamp_syscalls.h"
 
-#include <stdio.h>
+#include "fmt.h"
 #include <string.h>
 
 unsigned int val;
+
+#ifdef NVCOUNTER_BENCH
+
+#define H1_DRIVER_NVCOUNTER 0x80040000
+#define TOCK_NVCOUNTER_CMD_INCREMENT 1
+#define TOCK_NVCOUNTER_INCREMENT_DONE 0
+
+#define H1_DRIVER_RESET 0x40070
+#define TOCK_RESET_CMD_RESET 1
+
+#ifdef NVCOUNTER_BENCH_RESET
+static bool inject_done;
+
+static void inject_increment_done(int code __attribute__((unused)),
+                                  int counter __attribute__((unused)),
+                                  int unused2 __attribute__((unused)),
+                                  void* callback_args __attribute__((unused))) {
+  inject_done = true;
+}
+#endif
+
+static uint32_t samples[NVCOUNTER_BENCH];
+
+static void sort_samples(uint32_t* s, int n) {
+  int i, j;
+  for (i = 1; i < n; ++i) {
+    uint32_t v = s[i];
+    for (j = i; j > 0 && s[j - 1] > v; --j) s[j] = s[j - 1];
+    s[j] = v;
+  }
+}
+
 int main(void) {
-  printf("= Testing Nonvolatile Counter Driver =\n");
+  int i;
+  h1_printf("= Nonvolatile counter benchmark, %d increments =\n",
+            NVCOUNTER_BENCH);
+  if (tock_nvcounter_check() != TOCK_SUCCESS ||
+      tock_timestamp_check() != TOCK_SUCCESS) {
+    h1_printf("ERROR: need the nvcounter and timestamp drivers.\n");
+    return 1;
+  }
+
+  // The first increment after boot performs any recovery an
+  // interrupted increment left behind, so it is reported on its own
+  // rather than folded into the distribution.
+  uint32_t t0 = gettimeus();
+  if (tock_nvcounter_increment(&val) != TOCK_SUCCESS) {
+    h1_printf("ERROR: first increment failed.\n");
+    return 1;
+  }
+  h1_printf("nvcounter_bench first_increment_us=%lu value=%u\n",
+            (unsigned long)(gettimeus() - t0), val);
+
+  uint32_t run_start = gettimeus();
+  for (i = 0; i < NVCOUNTER_BENCH; ++i) {
+    t0 = gettimeus();
+    if (tock_nvcounter_increment(&val) != TOCK_SUCCESS) {
+      h1_printf("ERROR: increment %d failed.\n", i);
+      return 1;
+    }
+    samples[i] = gettimeus() - t0;
+  }
+  uint32_t total_us = gettimeus() - run_start;
+
+  sort_samples(samples, NVCOUNTER_BENCH);
+  h1_printf("nvcounter_bench n=%d total_us=%lu rate=%lu/sec\n",
+            NVCOUNTER_BENCH, (unsigned long)total_us,
+            (unsigned long)(((uint64_t)NVCOUNTER_BENCH * 1000000) / total_us));
+  h1_printf("nvcounter_bench min=%lu med=%lu p99=%lu max=%lu us\n",
+            (unsigned long)samples[0], (unsigned long)samples[NVCOUNTER_BENCH / 2],
+            (unsigned long)samples[(NVCOUNTER_BENCH * 99) / 100],
+            (unsigned long)samples[NVCOUNTER_BENCH - 1]);
+
+#ifdef NVCOUNTER_BENCH_RESET
+  // Simulate a power cut mid-increment: start an increment and reset
+  // the chip before yielding for its callback, leaving the flash write
+  // in whatever state the reset caught it. The next boot's
+  // first_increment_us line is the recovery-time sample.
+  h1_printf("nvcounter_bench injecting reset mid-increment\n");
+  inject_done = false;
+  if (subscribe(H1_DRIVER_NVCOUNTER, TOCK_NVCOUNTER_INCREMENT_DONE,
+                inject_increment_done, NULL) < 0 ||
+      command(H1_DRIVER_NVCOUNTER, TOCK_NVCOUNTER_CMD_INCREMENT, 0, 0) < 0) {
+    h1_printf("ERROR: could not start the increment to interrupt.\n");
+    return 1;
+  }
+  int ret = command(H1_DRIVER_RESET, TOCK_RESET_CMD_RESET, 0, 0);
+  // Only reached if the reset driver is missing (golf2 does not
+  // install it); let the orphaned increment finish and stop cleanly.
+  h1_printf("reset injection unavailable: %s (%i)\n", tock_strerror(ret), ret);
+  yield_for(&inject_done);
+#endif
+
+  h1_printf("= Benchmark complete =\n");
+  return 0;
+}
+
+#else  // !NVCOUNTER_BENCH
+
+int main(void) {
+  h1_printf("= Testing Nonvolatile Counter Driver =\n");
   int test = tock_nvcounter_check();
   if (test != TOCK_SUCCESS) {
-    printf("ERROR: no Nonvolatile Counter syscall driver installed.");
+    h1_printf("ERROR: no Nonvolatile Counter syscall driver installed.");
   }
   for (int i = 0; i < 5; i++) {
     int rval = tock_nvcounter_increment(&val);
-    printf("Increment %i is %u\n", i, val);
+    h1_printf("Increment %i is %u\n", i, val);
     delay_ms(1000);
   }
   return 0;
 }
+
+#endif  // NVCOUNTER_BENCH
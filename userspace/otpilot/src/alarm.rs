@@ -19,11 +19,15 @@ use core::cell::Cell;
 use libtock::result::TockResult;
 use libtock::syscalls;
 
+// Number of software timers multiplexed onto the single hardware alarm.
+pub const MAX_TIMERS: usize = 4;
+
 pub trait Alarm {
     // Get clock frequency in Hz.
     fn get_clock_frequency(&self) -> usize;
 
-    // Set alarm to occur after `ticks`.
+    // Set alarm to occur after `ticks`. Equivalent to set_timer on
+    // timer 0 with no slack.
     fn set(&self, ticks: usize) -> TockResult<()>;
 
     // Check if the alarm is expired.
@@ -31,6 +35,18 @@ pub trait Alarm {
 
     // Clear expired alarm or stop it if it's still running.
     fn clear(&self) -> TockResult<()>;
+
+    // Set software timer `timer` to expire after `ticks`. A timer whose
+    // deadline lands within `slack` ticks of an earlier wakeup fires on
+    // that wakeup instead of scheduling its own, so near-coincident
+    // deadlines cost one wakeup between them.
+    fn set_timer(&self, timer: usize, ticks: usize, slack: usize) -> TockResult<()>;
+
+    // Check if software timer `timer` is expired.
+    fn is_timer_expired(&self, timer: usize) -> bool;
+
+    // Clear software timer `timer`, expired or still pending.
+    fn clear_timer(&self, timer: usize) -> TockResult<()>;
 }
 
 // Get the static Controller object.
@@ -43,6 +59,7 @@ const DRIVER_NUMBER: usize = 0x00000;
 mod command_nr {
     pub const CHECK_IF_PRESENT: usize = 0;
     pub const GET_CLOCK_FREQUENCY: usize = 1;
+    pub const GET_CLOCK_VALUE: usize = 2;
     pub const STOP_ALARM: usize = 3;
     pub const SET_RELATIVE_ALARM: usize = 5;
 }
@@ -55,17 +72,26 @@ struct AlarmImpl {
     // Clock frequency for alarm
     clock_frequency: usize,
 
-    // ID of running alarm
+    // ID of running hardware alarm
     alarm_id: Cell<Option<usize>>,
 
-    // Whether the alarm is expired.
-    alarm_expired: Cell<bool>,
+    // Absolute deadline of each software timer, in clock ticks. None
+    // when the timer is not pending.
+    deadlines: [Cell<Option<u32>>; MAX_TIMERS],
+
+    // Coalescing slack of each software timer, in clock ticks.
+    slacks: [Cell<u32>; MAX_TIMERS],
+
+    // Whether each software timer is expired.
+    expired: [Cell<bool>; MAX_TIMERS],
 }
 
 static mut ALARM: AlarmImpl = AlarmImpl {
     clock_frequency: core::usize::MAX,
     alarm_id: Cell::new(None),
-    alarm_expired: Cell::new(false),
+    deadlines: [Cell::new(None), Cell::new(None), Cell::new(None), Cell::new(None)],
+    slacks: [Cell::new(0), Cell::new(0), Cell::new(0), Cell::new(0)],
+    expired: [Cell::new(false), Cell::new(false), Cell::new(false), Cell::new(false)],
 };
 
 static mut IS_INITIALIZED: bool = false;
@@ -104,11 +130,66 @@ impl AlarmImpl {
     }
 
     fn alarm_expired(&self, _ticks: usize, id: usize, _: usize) {
-        if let Some(alarm_id) = self.alarm_id.get() {
-            if alarm_id == id {
-                self.alarm_expired.set(true)
+        if self.alarm_id.get() != Some(id) {
+            return;
+        }
+        self.alarm_id.set(None);
+
+        let now = match self.now() {
+            Ok(now) => now,
+            Err(_) => return,
+        };
+
+        // Fire every timer whose deadline is within its slack of this
+        // wakeup; one wakeup covers the whole cluster of near-coincident
+        // deadlines instead of one interrupt each.
+        for timer in 0..MAX_TIMERS {
+            if let Some(deadline) = self.deadlines[timer].get() {
+                let due_in = deadline.wrapping_sub(now) as i32;
+                if due_in <= self.slacks[timer].get() as i32 {
+                    self.deadlines[timer].set(None);
+                    self.expired[timer].set(true);
+                }
             }
         }
+
+        let _ = self.rearm(now);
+    }
+
+    // Current counter value of the alarm clock.
+    fn now(&self) -> TockResult<u32> {
+        Ok(syscalls::command(DRIVER_NUMBER, command_nr::GET_CLOCK_VALUE, 0, 0)? as u32)
+    }
+
+    // Point the hardware alarm at the earliest pending deadline, or stop
+    // it if no timer is pending.
+    fn rearm(&self, now: u32) -> TockResult<()> {
+        let mut next: Option<u32> = None;
+        for timer in 0..MAX_TIMERS {
+            if let Some(deadline) = self.deadlines[timer].get() {
+                let due_in = deadline.wrapping_sub(now) as i32;
+                let due_in = if due_in < 0 { 0 } else { due_in as u32 };
+                next = Some(match next {
+                    None => due_in,
+                    Some(n) if due_in < n => due_in,
+                    Some(n) => n,
+                });
+            }
+        }
+
+        if let Some(alarm_id) = self.alarm_id.get() {
+            syscalls::command(DRIVER_NUMBER, command_nr::STOP_ALARM, alarm_id, 0)?;
+            self.alarm_id.set(None);
+        }
+
+        if let Some(due_in) = next {
+            let ticks = core::cmp::max(due_in, 1) as usize;
+            let alarm_id =
+                syscalls::command(DRIVER_NUMBER, command_nr::SET_RELATIVE_ALARM, ticks, 0)?;
+            self.alarm_id.set(Some(alarm_id));
+        }
+
+        Ok(())
     }
 }
 
@@ -118,33 +199,39 @@ impl Alarm for AlarmImpl {
     }
 
     fn set(&self, ticks: usize) -> TockResult<()> {
-        self.alarm_expired.set(false);
-        self.alarm_id.set(None);
-        let alarm_id = syscalls::command(DRIVER_NUMBER, command_nr::SET_RELATIVE_ALARM, ticks, 0)?;
-        self.alarm_id.set(Some(alarm_id));
-        Ok(())
+        self.set_timer(0, ticks, 0)
     }
 
     fn is_expired(&self) -> bool {
-        self.alarm_id.get().is_some() && self.alarm_expired.get()
+        self.is_timer_expired(0)
     }
 
     fn clear(&self) -> TockResult<()> {
-        // Clear an expired alarm.
-        if self.alarm_expired.get() {
-            self.alarm_expired.set(false);
-            self.alarm_id.set(None);
+        self.clear_timer(0)
+    }
 
-            // There's nothing else to do here.
-            return Ok(());
-        }
+    fn set_timer(&self, timer: usize, ticks: usize, slack: usize) -> TockResult<()> {
+        let now = self.now()?;
+        self.expired[timer].set(false);
+        self.deadlines[timer].set(Some(now.wrapping_add(ticks as u32)));
+        self.slacks[timer].set(slack as u32);
+        self.rearm(now)
+    }
 
-        // Stop a running alarm.
-        if let Some(alarm_id) = self.alarm_id.get() {
-            syscalls::command(DRIVER_NUMBER, command_nr::STOP_ALARM, alarm_id, 0)?;
-            self.alarm_id.set(None);
-        }
+    fn is_timer_expired(&self, timer: usize) -> bool {
+        self.expired[timer].get()
+    }
 
+    fn clear_timer(&self, timer: usize) -> TockResult<()> {
+        self.expired[timer].set(false);
+
+        // Stop a still-pending timer and retarget the hardware alarm at
+        // whatever remains.
+        if self.deadlines[timer].get().is_some() {
+            self.deadlines[timer].set(None);
+            let now = self.now()?;
+            self.rearm(now)?;
+        }
 
         Ok(())
     }
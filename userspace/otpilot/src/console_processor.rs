@@ -50,12 +50,20 @@ impl<'a> ConsoleProcessor<'a> {
 
     pub fn process_input(&self) -> TockResult<()> {
 
+        // The reader hands over its whole received batch as one borrowed
+        // slice; scan it in place so a scripted command stream costs one
+        // pass instead of one wakeup per byte.
         let data = console_reader::get().get_data();
-        if data.len() < 1 {
-            return Ok(());
+        for i in 0..data.len() {
+            self.process_command(data[i])?;
         }
 
-        match data[0] as char {
+        Ok(())
+    }
+
+    fn process_command(&self, cmd: u8) -> TockResult<()> {
+
+        match cmd as char {
             '?' => self.print_help()?,
             '1' => {
                 println!("Asserting BMC_CPU_RST");
@@ -83,6 +91,8 @@ impl<'a> ConsoleProcessor<'a> {
                 println!("resetting ...");
                 reset::get().reset()?;
             }
+            // Line endings and anything unmapped flow through silently,
+            // so pasted scripts with CR/LF separators just work.
             _ => (),
         }
 
@@ -0,0 +1,109 @@
+// Copyright 2021 lowRISC contributors.
+//
+// Licensed under the Apache License, Version 2.0 (the "License");
+// you may not use this file except in compliance with the License.
+// You may obtain a copy of the License at
+//
+//     https://www.apache.org/licenses/LICENSE-2.0
+//
+// Unless required by applicable law or agreed to in writing, software
+// distributed under the License is distributed on an "AS IS" BASIS,
+// WITHOUT WARRANTIES OR CONDITIONS OF ANY KIND, either express or implied.
+// See the License for the specific language governing permissions and
+// limitations under the License.
+//
+// SPDX-License-Identifier: Apache-2.0
+
+use libtock::result::TockResult;
+use libtock::syscalls;
+
+pub const SHA256_DIGEST_LENGTH: usize = 32;
+
+pub trait Digest {
+    // Start a SHA-256 session on the kernel digest engine. The engine
+    // is exclusive; this fails while another process has a session open.
+    fn initialize_sha256(&self) -> TockResult<()>;
+
+    // Feed len bytes from buffer into the running session.
+    // It must be: len <= buffer.len()
+    fn update(&self, buffer: &mut [u8], len: usize) -> TockResult<()>;
+
+    // Finish the session and write the digest into buffer.
+    // It must be: buffer.len() >= SHA256_DIGEST_LENGTH
+    fn finalize(&self, buffer: &mut [u8]) -> TockResult<()>;
+}
+
+// Get the static Digest object.
+pub fn get() -> &'static dyn Digest {
+    get_impl()
+}
+
+const DRIVER_NUMBER: usize = 0x40003;
+
+mod command_nr {
+    pub const CHECK_IF_PRESENT: usize = 0;
+    pub const INITIALIZE: usize = 1;
+    pub const UPDATE: usize = 2;
+    pub const FINALIZE: usize = 3;
+}
+
+mod allow_nr {
+    pub const INPUT_BUFFER: usize = 0;
+    pub const OUTPUT_BUFFER: usize = 1;
+}
+
+mod digest_mode {
+    pub const SHA256: usize = 1;
+}
+
+struct DigestImpl {}
+
+static mut DIGEST: DigestImpl = DigestImpl {};
+
+static mut IS_INITIALIZED: bool = false;
+
+fn get_impl() -> &'static DigestImpl {
+    unsafe {
+        if !IS_INITIALIZED {
+            if DIGEST.initialize().is_err() {
+                panic!("Could not initialize Digest");
+            }
+            IS_INITIALIZED = true;
+        }
+        &DIGEST
+    }
+}
+
+impl DigestImpl {
+    fn initialize(&'static mut self) -> TockResult<()> {
+        syscalls::command(DRIVER_NUMBER, command_nr::CHECK_IF_PRESENT, 0, 0)?;
+
+        Ok(())
+    }
+}
+
+impl Digest for DigestImpl {
+    fn initialize_sha256(&self) -> TockResult<()> {
+        syscalls::command(DRIVER_NUMBER, command_nr::INITIALIZE, digest_mode::SHA256, 0)?;
+
+        Ok(())
+    }
+
+    fn update(&self, buffer: &mut [u8], len: usize) -> TockResult<()> {
+        // We want this to go out of scope after executing the command
+        let _buffer_share = syscalls::allow(DRIVER_NUMBER, allow_nr::INPUT_BUFFER, buffer)?;
+
+        syscalls::command(DRIVER_NUMBER, command_nr::UPDATE, len, 0)?;
+
+        Ok(())
+    }
+
+    fn finalize(&self, buffer: &mut [u8]) -> TockResult<()> {
+        // We want this to go out of scope after executing the command
+        let _buffer_share = syscalls::allow(DRIVER_NUMBER, allow_nr::OUTPUT_BUFFER, buffer)?;
+
+        syscalls::command(DRIVER_NUMBER, command_nr::FINALIZE, 0, 0)?;
+
+        Ok(())
+    }
+}
@@ -14,6 +14,7 @@
 //
 // SPDX-License-Identifier: Apache-2.0
 
+use crate::digest;
 use crate::flash;
 
 
@@ -53,13 +54,30 @@ impl From<core::fmt::Error> for FirmwareControllerError {
 
 static mut WRITE_BUF : [u8; flash::MAX_BUFFER_LENGTH] = [0u8; flash::MAX_BUFFER_LENGTH];
 
+// H1 flash pages are 512 32-bit words.
+const PAGE_SIZE: usize = 2048;
+
 pub struct FirmwareController {
+    // Background erase state: pages [erase_page, erase_end_page) of
+    // erase_segment still need erasing. erase_busy is set while a page
+    // erase is in flight.
     erase_segment: SegmentInfo,
     erase_page: usize,
+    erase_end_page: usize,
+    erase_busy: bool,
 
     write_segment: SegmentInfo,
     write_offset: usize,
     write_length: usize,
+
+    // Running digest over the staged image: bytes [0, hash_offset) of
+    // hash_segment have already been streamed through the kernel digest
+    // engine as they were written. hashing is cleared if chunks arrive
+    // out of order or the engine is unavailable; the image then needs a
+    // separate full pass to be verified.
+    hash_segment: SegmentInfo,
+    hash_offset: usize,
+    hashing: bool,
 }
 
 pub type FirmwareControllerResult<T> = Result<T, FirmwareControllerError>;
@@ -70,9 +88,14 @@ impl FirmwareController {
         FirmwareController {
             erase_segment: UNKNOWN_SEGMENT,
             erase_page: 0,
+            erase_end_page: 0,
+            erase_busy: false,
             write_segment: UNKNOWN_SEGMENT,
             write_offset: 0,
             write_length: 0,
+            hash_segment: UNKNOWN_SEGMENT,
+            hash_offset: 0,
+            hashing: false,
         }
     }
 
@@ -87,23 +110,33 @@ impl FirmwareController {
         Ok(())
     }
 
-    fn erase_segment_start(&mut self, segment: SegmentInfo) -> FirmwareControllerResult<()> {
-        self.erase_segment = segment;
-        self.erase_page = self.erase_segment.start_page as usize;
-        flash::get().erase(self.erase_page)?;
-
+    // Wait for an in-flight background page erase to complete without
+    // starting the next one.
+    fn drain_erase(&mut self) -> FirmwareControllerResult<()> {
+        if self.erase_busy {
+            flash::get().wait_operation_done();
+            self.erase_busy = false;
+            if let Err(why) = self.check_operation_result() {
+                // Abandon the rest of the background erase; the failure
+                // resurfaces when the affected pages are written.
+                self.erase_end_page = self.erase_page;
+                return Err(why);
+            }
+            self.erase_page += 1;
+        }
         Ok(())
     }
 
-    fn erase_segment_continue(&mut self) -> FirmwareControllerResult<bool> {
-        if self.erase_page >= (self.erase_segment.start_page + self.erase_segment.page_count - 1) as usize {
-            // We're done.
-            return Ok(false);
+    // Block until every page up to and including last_page has been erased.
+    fn finish_erase_through(&mut self, last_page: usize) -> FirmwareControllerResult<()> {
+        loop {
+            self.drain_erase()?;
+            if self.erase_page >= self.erase_end_page || self.erase_page > last_page {
+                return Ok(());
+            }
+            flash::get().erase(self.erase_page)?;
+            self.erase_busy = true;
         }
-
-        self.erase_page += 1;
-        flash::get().erase(self.erase_page)?;
-        Ok(true)
     }
 
     fn get_write_flash_offset(&self) -> usize {
@@ -158,22 +191,114 @@ impl FirmwareController {
         Ok(true)
     }
 
+    // Start erasing the segment. Only the first page erase is kicked off
+    // here; the remaining pages are erased in the background through
+    // continue_erase(), and a write landing on a page that hasn't been
+    // erased yet finishes the erase for its pages on demand. The update
+    // protocol can therefore make progress while the bulk of the segment
+    // is still erasing.
     pub fn erase_segment(&mut self, segment: SegmentInfo) -> FirmwareControllerResult<()> {
-        self.erase_segment_start(segment)?;
-        flash::get().wait_operation_done();
-        self.check_operation_result()?;
-        while self.erase_segment_continue()? {
-            flash::get().wait_operation_done();
-            self.check_operation_result()?;
-        }
+        self.drain_erase()?;
+        self.erase_segment = segment;
+        self.erase_page = segment.start_page as usize;
+        self.erase_end_page = (segment.start_page + segment.page_count) as usize;
+        flash::get().erase(self.erase_page)?;
+        self.erase_busy = true;
+        self.start_image_digest(segment);
         Ok(())
     }
 
+    // Begin streaming the staged image through the kernel digest engine.
+    // Chunks are folded in as they are written, so the whole-image
+    // digest is ready as soon as the last chunk lands instead of costing
+    // a full read-back pass over the segment at the end of the download.
+    fn start_image_digest(&mut self, segment: SegmentInfo) {
+        self.abandon_image_digest();
+        self.hash_segment = segment;
+        self.hash_offset = 0;
+        self.hashing = digest::get().initialize_sha256().is_ok();
+    }
+
+    // Release the digest engine without keeping the result.
+    fn abandon_image_digest(&mut self) {
+        if self.hashing {
+            let mut scratch = [0u8; digest::SHA256_DIGEST_LENGTH];
+            let _ = digest::get().finalize(&mut scratch);
+            self.hashing = false;
+        }
+    }
+
+    // Fold the chunk just written (still in WRITE_BUF) into the running
+    // image digest. Only strictly sequential chunks can be streamed; a
+    // seek or rewrite invalidates the digest.
+    fn update_image_digest(&mut self) {
+        if !self.hashing || self.write_segment.identifier != self.hash_segment.identifier {
+            return;
+        }
+        if self.write_offset != self.hash_offset {
+            self.abandon_image_digest();
+            return;
+        }
+        unsafe {
+            // TODO(osk): We need the unsafe block since we're accessing WRITE_BUF as &mut.
+            if digest::get().update(&mut WRITE_BUF, self.write_length).is_err() {
+                self.abandon_image_digest();
+                return;
+            }
+        }
+        self.hash_offset += self.write_length;
+    }
+
+    // Finish the streamed image digest. Returns the number of image
+    // bytes it covers, or None if the chunks could not be streamed
+    // (out-of-order arrival or digest engine unavailable).
+    pub fn finish_image_digest(&mut self, digest_out: &mut [u8]) -> Option<usize> {
+        if !self.hashing {
+            return None;
+        }
+        self.hashing = false;
+        if digest::get().finalize(digest_out).is_err() {
+            return None;
+        }
+        Some(self.hash_offset)
+    }
+
+    // Advance the background segment erase if the flash controller has
+    // finished the previous page. Never blocks; returns true while pages
+    // remain to be erased.
+    pub fn continue_erase(&mut self) -> FirmwareControllerResult<bool> {
+        if self.erase_busy {
+            if !flash::get().is_operation_done() {
+                return Ok(true);
+            }
+            self.drain_erase()?;
+        }
+        if self.erase_page < self.erase_end_page {
+            flash::get().erase(self.erase_page)?;
+            self.erase_busy = true;
+            return Ok(true);
+        }
+        Ok(false)
+    }
+
     pub fn write_and_verify_segment_chunk(&mut self, segment: SegmentInfo, offset: usize, data: &[u8]) -> FirmwareControllerResult<bool> {
+        // Every page this chunk touches must have been erased first.
+        if data.len() > 0 && segment.identifier == self.erase_segment.identifier {
+            let last_page = segment.start_page as usize +
+                (offset + data.len() - 1) / PAGE_SIZE;
+            self.finish_erase_through(last_page)?;
+        }
+        // The flash controller runs one operation at a time, so any
+        // in-flight background erase must finish before the write.
+        self.drain_erase()?;
         self.write_segment_chunk(segment, offset, data)?;
         flash::get().wait_operation_done();
         self.check_operation_result()?;
-        self.verify_segment_chunk()
+        let matched = self.verify_segment_chunk()?;
+        if matched {
+            self.update_image_digest();
+        }
+        Ok(matched)
     }
 
     pub fn get_max_write_chunk_length(&self) -> usize {
@@ -19,6 +19,7 @@
 mod alarm;
 mod console_processor;
 mod console_reader;
+mod digest;
 mod firmware_controller;
 mod flash;
 mod fuse;
@@ -29,6 +30,7 @@ mod gpio_processor;
 mod manticore_support;
 mod reset;
 mod sfdp;
+mod sha256;
 mod spi_host;
 mod spi_host_h1;
 mod spi_host_helper;
@@ -57,11 +59,27 @@ libtock_core::stack_size! {2048}
 
 //////////////////////////////////////////////////////////////////////////////
 
+fn negotiate_host_clock(host_helper: &SpiHostHelper) -> TockResult<()> {
+    // The host SCK boots at a conservative divide-by-3 that any part
+    // can keep up with. A flash that publishes a valid SFDP table is
+    // JESD216-compliant, which guarantees Fast Read (0x0b, 8 dummy
+    // cycles) at the interface's full rate, so run it at the undivided
+    // clock; passthrough throughput scales linearly with SCK. Parts
+    // without SFDP stay at the conservative rate and plain reads.
+    let header = host_helper.read_sfdp(0x0, 8)?;
+    if header[0..4] == *b"SFDP" {
+        spi_host_h1::get().set_sck_divider(0)?;
+        spi_host_helper::set_fast_read(true);
+    }
+    Ok(())
+}
+
 fn run_host_helper_demo() -> TockResult<()> {
     // We cannot use the SPI host if passthrough is enabled.
     spi_host_h1::get().set_passthrough(false)?;
 
     let host_helper = SpiHostHelper {};
+    negotiate_host_clock(&host_helper)?;
     host_helper.enter_4b()?;
 
     host_helper.read_and_print_data(0x0)?;
@@ -142,6 +160,7 @@ fn run() -> TockResult<()> {
         manticore_handler: manticore_support::Handler::new(&identity),
         print_flash_headers: false,  // Enable to print incoming SPI flash headers
         firmware: firmware_controller::FirmwareController::new(),
+        reboot_pending: false,
     };
 
     let gpio_processor = GpioProcessor::new();
@@ -171,17 +190,33 @@ fn run() -> TockResult<()> {
     //////////////////////////////////////////////////////////////////////////////
 
     {
-        let mut sfdp = [0xff; 128];
+        // Prebuild the SFDP response for both address modes once. The
+        // spi_device wrapper programs the table for the current mode now and
+        // serves the cached counterpart on later address mode changes, so
+        // the table is never rebuilt while the AP is hammering SFDP reads.
+        let support_address_mode_switch =
+            spi_device::get().get_address_mode() == AddressMode::ThreeByte;
+        let mut sfdp_3b = [0xff; spi_device::SFDP_LEN];
+        let mut sfdp_4b = [0xff; spi_device::SFDP_LEN];
         sfdp::get_table(
-            &mut sfdp,
+            &mut sfdp_3b,
             spi_processor::SPI_FLASH_SIZE * 8, // image_size_bits
-            spi_device::get().get_address_mode(), // startup_address_mode
-            spi_device::get().get_address_mode() == AddressMode::ThreeByte, // support_address_mode_switch
+            AddressMode::ThreeByte, // startup_address_mode
+            support_address_mode_switch,
             spi_processor::SPI_MAILBOX_ADDRESS, // mailbox_offset
             spi_device::MAX_READ_BUFFER_SIZE as u32, // mailbox_size
             0 // google_capabilities
             ).map_err(|_| TockError::Format)?;
-        spi_device::get().set_sfdp(&mut sfdp)?;
+        sfdp::get_table(
+            &mut sfdp_4b,
+            spi_processor::SPI_FLASH_SIZE * 8, // image_size_bits
+            AddressMode::FourByte, // startup_address_mode
+            support_address_mode_switch,
+            spi_processor::SPI_MAILBOX_ADDRESS, // mailbox_offset
+            spi_device::MAX_READ_BUFFER_SIZE as u32, // mailbox_size
+            0 // google_capabilities
+            ).map_err(|_| TockError::Format)?;
+        spi_device::get().set_sfdp_cache(&sfdp_3b, &sfdp_4b)?;
     }
 
     //////////////////////////////////////////////////////////////////////////////
@@ -208,6 +243,12 @@ fn run() -> TockResult<()> {
             && !gpio_control::get().have_events()
             && !alarm::get().is_expired() {
 
+            // Advance any background segment erase before sleeping; the
+            // flash completion callback is one of the things that wakes us
+            // here. Errors are ignored on purpose (no console in this loop)
+            // and resurface when the affected pages are written.
+            let _ = spi_processor.firmware.continue_erase();
+
             // Note: Do NOT use the console here, as that results in a "hidden"
             // yieldk() which causes us to lose track of the conditions above.
             unsafe { yieldk(); }
@@ -262,6 +303,15 @@ fn run() -> TockResult<()> {
                 }
             }
         }
+
+        // A delayed reboot was acknowledged above. All events from this
+        // iteration have been handled and the ack sits in the read
+        // buffer for the host to fetch; switch over to the freshly
+        // written bank now rather than going back to sleep.
+        if spi_processor.reboot_pending {
+            println!("Firmware update: rebooting for bank switchover.");
+            reset::get().reset()?;
+        }
     }
 }
 
@@ -16,6 +16,8 @@
 
 use core::time::Duration;
 
+use crate::sha256;
+
 use manticore::crypto::rsa;
 use manticore::hardware;
 use manticore::protocol::capabilities::*;
@@ -79,54 +81,271 @@ impl hardware::Reset for Reset {
     }
 }
 
-pub struct NoRsaPubKey;
-impl rsa::PublicKey for NoRsaPubKey {
+// RSA-3072 signature verification. Cerberus certificate chains are
+// RSA-signed, but with the public exponent fixed at 65537 a
+// verification is only 17 modular multiplications of 3072-bit numbers
+// -- tens of milliseconds of Montgomery arithmetic on this core. (It
+// is private-key operations, with a full-width exponent, that need
+// the dcrypto engine; the tree carries no dcrypto assembler to
+// generate a modexp program with, so verification stays in software.)
+
+const RSA3072_LEN: usize = 384;
+
+// 3072-bit magnitudes as little-endian 32-bit limbs.
+const RSA3072_LIMBS: usize = RSA3072_LEN / 4;
+
+type Bn3072 = [u32; RSA3072_LIMBS];
+
+// a >= b.
+fn bn_ge(a: &Bn3072, b: &Bn3072) -> bool {
+    for i in (0..RSA3072_LIMBS).rev() {
+        if a[i] != b[i] {
+            return a[i] > b[i];
+        }
+    }
+    true
+}
+
+// a -= b mod 2^3072; callers arrange that any final borrow cancels
+// against a carry they are tracking out of band.
+fn bn_sub_assign(a: &mut Bn3072, b: &Bn3072) {
+    let mut borrow = 0u64;
+    for i in 0..RSA3072_LIMBS {
+        let v = (a[i] as u64).wrapping_sub(b[i] as u64 + borrow);
+        a[i] = v as u32;
+        borrow = (v >> 32) & 1;
+    }
+}
+
+// -n[0]^-1 mod 2^32 (the Montgomery n0' constant). Newton's method
+// doubles the number of correct low bits per round, and an odd n0 is
+// its own inverse mod 8, so four rounds are more than enough.
+fn bn_n0inv(n0: u32) -> u32 {
+    let mut x = n0;
+    for _ in 0..4 {
+        x = x.wrapping_mul(2u32.wrapping_sub(n0.wrapping_mul(x)));
+    }
+    x.wrapping_neg()
+}
+
+// r = a * b / 2^3072 mod n (Montgomery product, CIOS form). Inputs
+// must be below n; the result is below n.
+fn bn_mont_mul(r: &mut Bn3072, a: &Bn3072, b: &Bn3072,
+               n: &Bn3072, n0inv: u32) {
+    let mut t = [0u32; RSA3072_LIMBS + 2];
+    for i in 0..RSA3072_LIMBS {
+        // t += a[i] * b
+        let ai = a[i] as u64;
+        let mut carry = 0u64;
+        for j in 0..RSA3072_LIMBS {
+            let v = t[j] as u64 + ai * (b[j] as u64) + carry;
+            t[j] = v as u32;
+            carry = v >> 32;
+        }
+        let v = t[RSA3072_LIMBS] as u64 + carry;
+        t[RSA3072_LIMBS] = v as u32;
+        t[RSA3072_LIMBS + 1] = (v >> 32) as u32;
+
+        // t += m * n with m chosen to zero t's low limb, then shift
+        // the zero limb out.
+        let m = t[0].wrapping_mul(n0inv) as u64;
+        let v = t[0] as u64 + m * (n[0] as u64);
+        let mut carry = v >> 32;
+        for j in 1..RSA3072_LIMBS {
+            let v = t[j] as u64 + m * (n[j] as u64) + carry;
+            t[j - 1] = v as u32;
+            carry = v >> 32;
+        }
+        let v = t[RSA3072_LIMBS] as u64 + carry;
+        t[RSA3072_LIMBS - 1] = v as u32;
+        t[RSA3072_LIMBS] = t[RSA3072_LIMBS + 1]
+            .wrapping_add((v >> 32) as u32);
+        t[RSA3072_LIMBS + 1] = 0;
+    }
+    // t < 2n here, so one conditional subtraction normalizes it.
+    r.copy_from_slice(&t[..RSA3072_LIMBS]);
+    if t[RSA3072_LIMBS] != 0 || bn_ge(r, n) {
+        bn_sub_assign(r, n);
+    }
+}
+
+// Working state for one verification; static for the same
+// single-threaded reason as the message arenas above (2KB of limbs
+// has no business on the 2KB task stack).
+struct RsaScratch {
+    n: Bn3072,
+    sig: Bn3072,
+    rr: Bn3072,
+    acc: Bn3072,
+    tmp: Bn3072,
+}
+
+static mut RSA_SCRATCH: RsaScratch = RsaScratch {
+    n: [0; RSA3072_LIMBS],
+    sig: [0; RSA3072_LIMBS],
+    rr: [0; RSA3072_LIMBS],
+    acc: [0; RSA3072_LIMBS],
+    tmp: [0; RSA3072_LIMBS],
+};
+
+// DER DigestInfo prefix for SHA-256 (RFC 8017, section 9.2).
+const SHA256_DIGEST_INFO: [u8; 19] = [
+    0x30, 0x31, 0x30, 0x0d, 0x06, 0x09, 0x60, 0x86, 0x48, 0x01,
+    0x65, 0x03, 0x04, 0x02, 0x01, 0x05, 0x00, 0x04, 0x20,
+];
+
+pub struct Rsa3072PubKey {
+    // Big-endian, as it appears in the certificate.
+    modulus: [u8; RSA3072_LEN],
+}
+
+impl Rsa3072PubKey {
+    pub fn new(modulus: [u8; RSA3072_LEN]) -> Self {
+        Self { modulus }
+    }
+}
+
+impl rsa::PublicKey for Rsa3072PubKey {
     fn len(&self) -> rsa::ModulusLength {
-        unreachable!()
+        rsa::ModulusLength::Bits3072
     }
 }
 
-pub struct NoRsaEngine;
-impl rsa::Engine for NoRsaEngine {
+pub struct Rsa3072Engine {
+    key: Rsa3072PubKey,
+}
+
+impl rsa::Engine for Rsa3072Engine {
     type Error = ();
-    type Key = NoRsaPubKey;
+    type Key = Rsa3072PubKey;
 
     fn verify_signature(
         &mut self,
-        _signature: &[u8],
-        _message: &[u8],
+        signature: &[u8],
+        message: &[u8],
     ) -> Result<(), rsa::Error<()>> {
-        Err(manticore::crypto::rsa::Error::Custom(()))
+        if signature.len() != RSA3072_LEN {
+            return Err(rsa::Error::Custom(()));
+        }
+
+        let s = unsafe { &mut RSA_SCRATCH };
+
+        // Wire format is big-endian; the limbs are little-endian.
+        for i in 0..RSA3072_LIMBS {
+            let o = RSA3072_LEN - 4 * (i + 1);
+            s.n[i] = (self.key.modulus[o] as u32) << 24
+                | (self.key.modulus[o + 1] as u32) << 16
+                | (self.key.modulus[o + 2] as u32) << 8
+                | self.key.modulus[o + 3] as u32;
+            s.sig[i] = (signature[o] as u32) << 24
+                | (signature[o + 1] as u32) << 16
+                | (signature[o + 2] as u32) << 8
+                | signature[o + 3] as u32;
+        }
+
+        // An RSA modulus is odd, and a signature must be a residue.
+        if s.n[0] & 1 == 0 || bn_ge(&s.sig, &s.n) {
+            return Err(rsa::Error::Custom(()));
+        }
+        let n0inv = bn_n0inv(s.n[0]);
+
+        // rr = 2^6144 mod n, built by doubling: the one-time cost of
+        // entering the Montgomery domain without a division routine.
+        s.rr = [0; RSA3072_LIMBS];
+        s.rr[0] = 1;
+        for _ in 0..2 * 8 * RSA3072_LEN {
+            let mut carry = 0u32;
+            for j in 0..RSA3072_LIMBS {
+                let v = (s.rr[j] as u64) << 1 | carry as u64;
+                s.rr[j] = v as u32;
+                carry = (v >> 32) as u32;
+            }
+            if carry != 0 || bn_ge(&s.rr, &s.n) {
+                bn_sub_assign(&mut s.rr, &s.n);
+            }
+        }
+
+        // sig^65537 = (sig^(2^16)) * sig: 16 squarings and one
+        // multiply, all in the Montgomery domain.
+        bn_mont_mul(&mut s.acc, &s.sig, &s.rr, &s.n, n0inv);
+        s.sig = s.acc;
+        for _ in 0..16 {
+            bn_mont_mul(&mut s.tmp, &s.acc, &s.acc, &s.n, n0inv);
+            s.acc = s.tmp;
+        }
+        bn_mont_mul(&mut s.tmp, &s.acc, &s.sig, &s.n, n0inv);
+        // Multiplying by plain 1 divides the R factor back out.
+        s.sig = [0; RSA3072_LIMBS];
+        s.sig[0] = 1;
+        bn_mont_mul(&mut s.acc, &s.tmp, &s.sig, &s.n, n0inv);
+
+        // Pack the result back into the big-endian encoded message
+        // and check the PKCS#1 v1.5 structure around the digest.
+        let mut em = [0u8; RSA3072_LEN];
+        for i in 0..RSA3072_LIMBS {
+            let o = RSA3072_LEN - 4 * (i + 1);
+            em[o] = (s.acc[i] >> 24) as u8;
+            em[o + 1] = (s.acc[i] >> 16) as u8;
+            em[o + 2] = (s.acc[i] >> 8) as u8;
+            em[o + 3] = s.acc[i] as u8;
+        }
+
+        let digest = sha256::digest(message);
+        let ps_end =
+            RSA3072_LEN - sha256::DIGEST_SIZE - SHA256_DIGEST_INFO.len() - 1;
+        let ok = em[0] == 0x00
+            && em[1] == 0x01
+            && em[2..ps_end].iter().all(|&b| b == 0xff)
+            && em[ps_end] == 0x00
+            && em[ps_end + 1..ps_end + 1 + SHA256_DIGEST_INFO.len()]
+                == SHA256_DIGEST_INFO
+            && em[RSA3072_LEN - sha256::DIGEST_SIZE..] == digest;
+
+        if ok {
+            Ok(())
+        } else {
+            Err(rsa::Error::Custom(()))
+        }
     }
 }
 
-pub struct NoRsa;
-impl rsa::Builder for NoRsa {
-    type Engine = NoRsaEngine;
+pub struct Rsa3072;
+impl rsa::Builder for Rsa3072 {
+    type Engine = Rsa3072Engine;
 
-    fn supports_modulus(&self, _: rsa::ModulusLength) -> bool {
-        true
+    fn supports_modulus(&self, len: rsa::ModulusLength) -> bool {
+        matches!(len, rsa::ModulusLength::Bits3072)
     }
 
-    fn new_engine(&self, _key: NoRsaPubKey) -> Result<NoRsaEngine, rsa::Error<()>> {
-        Err(manticore::crypto::rsa::Error::Custom(()))
+    fn new_engine(
+        &self,
+        key: Rsa3072PubKey,
+    ) -> Result<Rsa3072Engine, rsa::Error<()>> {
+        Ok(Rsa3072Engine { key })
     }
 }
 
-pub fn get_pa_rot(identity: &Identity) -> PaRot<Identity, Reset, NoRsa> {
+pub fn get_pa_rot(identity: &Identity) -> PaRot<Identity, Reset, Rsa3072> {
     PaRot::new(Options {
         identity: &identity,
         reset: &Reset,
-        rsa: &NoRsa,
+        rsa: &Rsa3072,
         device_id: DEVICE_ID,
         networking: NETWORKING,
         timeouts: TIMEOUTS,
     })
 }
 
+// Static scratch arenas for message processing; nothing on the
+// per-message path allocates. The header arena is separate from the
+// request arena so the parsed header's storage is never aliased by the
+// arena handed to the server.
 const ARENA_SIZE : usize = 64;
 static mut ARENA: [u8; ARENA_SIZE] = [0; ARENA_SIZE];
 
+const HEADER_ARENA_SIZE : usize = 16;
+static mut HEADER_ARENA: [u8; HEADER_ARENA_SIZE] = [0; HEADER_ARENA_SIZE];
+
 #[derive(Copy, Clone, Debug)]
 pub enum HandlerError {
     FromWire(FromWireError),
@@ -155,9 +374,39 @@ impl From<manticore::server::Error> for HandlerError {
 
 pub type HandlerResult<T> = Result<T, HandlerError>;
 
+// Serialized-response cache for commands whose payloads change only at
+// reboot or re-provisioning. RoT managers re-fetch identity data on
+// every attestation round, so a repeat request is answered with a
+// buffer copy instead of a parse-dispatch-serialize pass. Challenges
+// and anything else nonce-bearing must never land here.
+const RSP_CACHE_ENTRIES: usize = 4;
+const RSP_CACHE_KEY_SIZE: usize = 16;
+const RSP_CACHE_RSP_SIZE: usize = 64;
+
+#[derive(Copy, Clone)]
+struct CachedResponse {
+    key_len: usize,
+    key: [u8; RSP_CACHE_KEY_SIZE],
+    rsp_len: usize,
+    rsp: [u8; RSP_CACHE_RSP_SIZE],
+}
+
+impl CachedResponse {
+    const EMPTY: CachedResponse = CachedResponse {
+        key_len: 0,
+        key: [0; RSP_CACHE_KEY_SIZE],
+        rsp_len: 0,
+        rsp: [0; RSP_CACHE_RSP_SIZE],
+    };
+}
+
 pub struct Handler<'a> {
     // The Handler protocol server.
-    server: PaRot<'a, Identity, Reset, NoRsa>,
+    server: PaRot<'a, Identity, Reset, Rsa3072>,
+
+    // Cached serialized responses, filled round-robin.
+    rsp_cache: [CachedResponse; RSP_CACHE_ENTRIES],
+    rsp_cache_next: usize,
 }
 
 impl<'a> Handler<'a> {
@@ -165,23 +414,48 @@ impl<'a> Handler<'a> {
     pub fn new(identity: &'a Identity) -> Self {
         Self {
             server: get_pa_rot(identity),
+            rsp_cache: [CachedResponse::EMPTY; RSP_CACHE_ENTRIES],
+            rsp_cache_next: 0,
         }
     }
 
     pub fn process_request(&mut self, mut input: &[u8], output: &mut[u8]) -> HandlerResult<usize> {
         use manticore::mem::BumpArena;
         use manticore::net::InMemHost;
+        use manticore::protocol::CommandType;
         use manticore::protocol::Header;
         use manticore::protocol::HEADER_LEN;
         use manticore::io::Cursor;
 
+        let raw_request = input;
+
         let header = {
             unsafe {
-                let arena = BumpArena::new(&mut ARENA[..]);
+                let arena = BumpArena::new(&mut HEADER_ARENA[..]);
                 Header::from_wire(&mut input, &arena)?
             }
         };
 
+        // Responses for these commands are static for the life of a
+        // boot; the key is the full raw request so variants that carry
+        // a selector (e.g. a firmware version slot) cache separately.
+        let cacheable = matches!(
+            header.command,
+            CommandType::FirmwareVersion
+                | CommandType::DeviceCapabilities
+                | CommandType::DeviceId);
+
+        if cacheable {
+            for entry in self.rsp_cache.iter() {
+                if entry.rsp_len > 0
+                    && entry.key_len == raw_request.len()
+                    && entry.key[..entry.key_len] == *raw_request {
+                    output[..entry.rsp_len].copy_from_slice(&entry.rsp[..entry.rsp_len]);
+                    return Ok(entry.rsp_len);
+                }
+            }
+        }
+
         let resp_header: Header;
         let resp_data_len: usize;
         {
@@ -202,9 +476,22 @@ impl<'a> Handler<'a> {
             }
         }
 
-        let tx_cursor = Cursor::new(output);
+        let tx_cursor = Cursor::new(&mut output[..]);
         resp_header.to_wire(tx_cursor)?;
-        Ok(resp_data_len + HEADER_LEN)
+
+        let total_len = resp_data_len + HEADER_LEN;
+        if cacheable
+            && raw_request.len() <= RSP_CACHE_KEY_SIZE
+            && total_len <= RSP_CACHE_RSP_SIZE {
+            let entry = &mut self.rsp_cache[self.rsp_cache_next];
+            self.rsp_cache_next = (self.rsp_cache_next + 1) % RSP_CACHE_ENTRIES;
+            entry.key_len = raw_request.len();
+            entry.key[..raw_request.len()].copy_from_slice(raw_request);
+            entry.rsp_len = total_len;
+            entry.rsp[..total_len].copy_from_slice(&output[..total_len]);
+        }
+
+        Ok(total_len)
     }
 
 }
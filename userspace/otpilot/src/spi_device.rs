@@ -31,6 +31,9 @@ use spiutils::protocol::wire::ToWire;
 
 pub const MAX_READ_BUFFER_SIZE: usize = 512;
 
+/// Length of an SFDP response table.
+pub const SFDP_LEN: usize = 128;
+
 #[allow(dead_code)]
 pub const MAX_WRITE_BUFFER_SIZE: usize = 2048;
 
@@ -73,6 +76,12 @@ pub trait SpiDevice {
     /// Set the SFDP data.
     fn set_sfdp(&self, data: &mut[u8]) -> TockResult<()>;
 
+    /// Register prebuilt SFDP responses, one per address mode. The table
+    /// matching the current address mode is programmed immediately; later
+    /// address mode changes re-program the matching table straight from the
+    /// cache, without rebuilding it.
+    fn set_sfdp_cache(&self, three_byte: &[u8], four_byte: &[u8]) -> TockResult<()>;
+
     /// Configure SPI addresses.
     fn configure_addresses(&self, address_config: AddressConfig) -> TockResult<()>;
 }
@@ -124,8 +133,16 @@ struct SpiDeviceImpl {
 
     /// The current address mode
     address_mode: Cell<AddressMode>,
+
+    /// Whether SFDP_CACHE holds valid prebuilt tables.
+    sfdp_cached: Cell<bool>,
 }
 
+// Prebuilt SFDP responses, one per address mode, constructed once at start.
+// After set_sfdp_cache these are only ever read, so serving one is a pointer
+// handoff to the kernel rather than a table rebuild.
+static mut SFDP_CACHE: [[u8; SFDP_LEN]; 2] = [[0xff; SFDP_LEN]; 2];
+
 static mut SPI_DEVICE: SpiDeviceImpl = SpiDeviceImpl {
     read_buffer: [0; MAX_READ_BUFFER_SIZE],
     read_buffer_share: Cell::new(None),
@@ -133,6 +150,7 @@ static mut SPI_DEVICE: SpiDeviceImpl = SpiDeviceImpl {
     is_busy_set: Cell::new(false),
     is_write_enable_set: Cell::new(false),
     address_mode: Cell::new(AddressMode::ThreeByte),
+    sfdp_cached: Cell::new(false),
 };
 
 static mut IS_INITIALIZED: bool = false;
@@ -201,11 +219,35 @@ impl SpiDeviceImpl {
     fn address_mode_changed(&self, arg1: usize, _: usize, _: usize) {
         // arg1: new AddressMode
         match AddressMode::try_from(arg1) {
-            Ok(val) => self.address_mode.set(val),
+            Ok(val) => {
+                self.address_mode.set(val);
+                // Keep the advertised SFDP table consistent with the new
+                // mode. There's nothing useful to do on error here.
+                if self.sfdp_cached.get() {
+                    let _ = self.program_sfdp(val);
+                }
+            },
             Err(_) => ()
         }
     }
 
+    // Program the kernel's SFDP response from the prebuilt cache for the
+    // given address mode.
+    fn program_sfdp(&self, address_mode: AddressMode) -> TockResult<()> {
+        let idx = match address_mode {
+            AddressMode::ThreeByte => 0,
+            AddressMode::FourByte => 1,
+        };
+
+        // We want this to go out of scope after executing the command
+        let _write_buffer_share = syscalls::allow(DRIVER_NUMBER, allow_nr::WRITE_BUFFER,
+            unsafe { &mut SFDP_CACHE[idx] })?;
+
+        syscalls::command(DRIVER_NUMBER, command_nr::SET_SFDP, 0, 0)?;
+
+        Ok(())
+    }
+
     /// Clear the current received transaction.
     fn clear_transaction(&self) {
         self.received_len.set(0);
@@ -289,6 +331,20 @@ impl SpiDevice for SpiDeviceImpl {
         Ok(())
     }
 
+    fn set_sfdp_cache(&self, three_byte: &[u8], four_byte: &[u8]) -> TockResult<()> {
+        if three_byte.len() > SFDP_LEN || four_byte.len() > SFDP_LEN {
+            return Err(TockError::Format);
+        }
+
+        unsafe {
+            SFDP_CACHE[0][..three_byte.len()].copy_from_slice(three_byte);
+            SFDP_CACHE[1][..four_byte.len()].copy_from_slice(four_byte);
+        }
+        self.sfdp_cached.set(true);
+
+        self.program_sfdp(self.get_address_mode())
+    }
+
     fn configure_addresses(&self, address_config: AddressConfig) -> TockResult<()> {
         let mut buf = [0u8; ADDRESS_CONFIG_LEN];
 
@@ -23,6 +23,11 @@ pub trait SpiHostH1 {
 
     /// Enable/disable wait for BUSY bit to clear before completing transactions.
     fn set_wait_busy_clear_in_transactions(&self, enabled: bool) -> TockResult<()>;
+
+    /// Set the SCK clock divider: SCK = PCLK / (divider + 1). The kernel
+    /// boots with a conservative divider; raise it only after probing
+    /// what the attached flash supports.
+    fn set_sck_divider(&self, divider: u32) -> TockResult<()>;
 }
 
 // Get the static SpiHostH1 object.
@@ -36,6 +41,7 @@ mod command_nr {
     pub const CHECK_IF_PRESENT: usize = 0;
     pub const ENABLE_DISABLE_PASSTHROUGH: usize = 1;
     pub const ENABLE_DISABLE_WAIT_BUSY_CLEAR_IN_TRANSACTIONS: usize = 2;
+    pub const SET_SCK_DIVIDER: usize = 3;
 }
 
 struct SpiHostH1Impl {}
@@ -76,4 +82,10 @@ impl SpiHostH1 for SpiHostH1Impl {
 
         Ok(())
     }
+
+    fn set_sck_divider(&self, divider: u32) -> TockResult<()> {
+        syscalls::command(DRIVER_NUMBER, command_nr::SET_SCK_DIVIDER, divider as usize, 0)?;
+
+        Ok(())
+    }
 }
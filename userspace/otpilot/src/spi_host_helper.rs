@@ -24,6 +24,15 @@ pub struct SpiHostHelper;
 
 static mut TXBUFFER: [u8; spi_host::MAX_READ_BUFFER_LENGTH] = [0xff; spi_host::MAX_READ_BUFFER_LENGTH];
 
+// Whether read_data uses Fast Read (0x0b, 8 dummy cycles) instead of
+// plain Read (0x03). Required once the host clock has been raised
+// beyond what plain Read is specified for.
+static mut FAST_READ: bool = false;
+
+pub fn set_fast_read(enabled: bool) {
+    unsafe { FAST_READ = enabled; }
+}
+
 impl SpiHostHelper {
     pub fn enter_4b(&self) -> TockResult<()> {
         spi_host::get().read_write_bytes(&mut [0xb7], 1)?;
@@ -39,17 +48,39 @@ impl SpiHostHelper {
 
     fn create_tx_buf(&self, cmd: u8, addr: u32) -> usize {
         unsafe {
+            // Only the opcode and address bytes are ever written to
+            // TXBUFFER, so the 0xff tail from its initializer stays
+            // valid and does not need to be rewritten per transaction.
             TXBUFFER[0] = cmd;
             TXBUFFER[1..5].copy_from_slice(&addr.to_be_bytes());
-            for idx in 5..TXBUFFER.len() {
-                TXBUFFER[idx] = 0xff;
-            }
             5
         }
     }
 
     pub fn read_data<'a>(&self, addr: u32, rx_len: usize) -> TockResult<&'static[u8]> {
-        let tx_len = self.create_tx_buf(0x03, addr);
+        let fast = unsafe { FAST_READ };
+        let mut tx_len = self.create_tx_buf(if fast { 0x0b } else { 0x03 }, addr);
+        if fast {
+            // 8 dummy cycles between address and data; the 0xff tail of
+            // TXBUFFER provides the don't-care byte.
+            tx_len += 1;
+        }
+        unsafe {
+            spi_host::get().read_write_bytes(&mut TXBUFFER, tx_len + rx_len)?;
+        }
+        spi_host::get().wait_read_write_done();
+        Ok(&spi_host::get().get_read_buffer()[tx_len..])
+    }
+
+    pub fn read_sfdp(&self, addr: u32, rx_len: usize) -> TockResult<&'static[u8]> {
+        // Read SFDP (0x5a) always takes a 3-byte address followed by 8
+        // dummy cycles, regardless of the current address mode.
+        let tx_len = unsafe {
+            TXBUFFER[0] = 0x5a;
+            TXBUFFER[1..4].copy_from_slice(&addr.to_be_bytes()[1..]);
+            TXBUFFER[4] = 0xff; // dummy byte
+            5
+        };
         unsafe {
             spi_host::get().read_write_bytes(&mut TXBUFFER, tx_len + rx_len)?;
         }
@@ -14,6 +14,7 @@
 //
 // SPDX-License-Identifier: Apache-2.0
 
+use crate::digest;
 use crate::firmware_controller::FirmwareController;
 use crate::globalsec;
 use crate::manticore_support;
@@ -108,6 +109,12 @@ pub struct SpiProcessor<'a> {
     pub print_flash_headers: bool,
 
     pub firmware: FirmwareController,
+
+    // Set when a delayed reboot request has been acknowledged. The main
+    // loop performs the actual reset once the transaction that carried
+    // the request is over, so the host sees the ack instead of a device
+    // that went away mid-exchange.
+    pub reboot_pending: bool,
 }
 
 const SPI_TX_BUF_SIZE : usize = 512;
@@ -119,6 +126,46 @@ static mut SPI_TX_BUF : [u8; SPI_TX_BUF_SIZE] = [0xff; SPI_TX_BUF_SIZE];
 
 pub type SpiProcessorResult<T> = Result<T, SpiProcessorError>;
 
+// Serialize the header (plus dummy byte if the opcode has one) and as much of
+// `data` as fits into `tx_buf`, advancing `data` and the header address past
+// the staged chunk. Returns the number of staged bytes.
+fn stage_chunk<AddrType>(
+    header: &mut spi_flash::Header::<AddrType>,
+    data: &mut &[u8],
+    tx_buf: &mut [u8],
+) -> SpiProcessorResult<usize>
+where AddrType: Address {
+    let tx_len : usize;
+    let data_len_to_send : usize;
+    {
+        let mut tx_cursor = SpiutilsCursor::new(tx_buf);
+        header.to_wire(&mut tx_cursor)?;
+        if header.opcode.has_dummy_byte() {
+            // Skip one dummy byte (send 0x0)
+            tx_cursor.write_bytes(&[0x0; 1])
+                .map_err(|err| SpiProcessorError::ToWire(ToWireError::Io(err)))?;
+        }
+
+        data_len_to_send = min(spi_host::MAX_READ_BUFFER_LENGTH - tx_cursor.consumed_len(), data.len());
+        tx_cursor.write_bytes(&data[..data_len_to_send])
+            .map_err(|err| SpiProcessorError::ToWire(ToWireError::Io(err)))?;
+
+        tx_len = tx_cursor.consumed_len()
+    }
+
+    // Move data and address forward
+    *data = &data[data_len_to_send..];
+    if let Some(addr) = header.address {
+        let delta : u32 = core::convert::TryFrom::<usize>::try_from(data_len_to_send)
+            .map_err(|_| SpiProcessorError::FromWire(FromWireError::OutOfRange))?;
+        let next_addr = addr.into() + delta;
+        header.address = Some(AddrType::try_from(next_addr)
+            .map_err(|_| SpiProcessorError::FromWire(FromWireError::OutOfRange))?);
+    }
+
+    Ok(tx_len)
+}
+
 impl<'a> SpiProcessor<'a> {
 
     fn send_data(&mut self, content_type: payload::ContentType, content_len: u16, tx_buf: &mut[u8]) -> SpiProcessorResult<()> {
@@ -302,6 +349,14 @@ impl<'a> SpiProcessor<'a> {
             req = firmware::RebootRequest::from_wire(&mut data)?;
         }
 
+        // The image digest was streamed as the chunks arrived, so it is
+        // available here immediately instead of costing a full pass over
+        // the staged image on the update critical path.
+        let mut image_digest = [0u8; digest::SHA256_DIGEST_LENGTH];
+        if let Some(len) = self.firmware.finish_image_digest(&mut image_digest) {
+            println!("Staged image digest ({} bytes): {:02x?}", len, image_digest);
+        }
+
         let result = match req.time {
             firmware::RebootTime::Immediate => {
                 if let Err(_) = reset::get().reset() {
@@ -311,8 +366,13 @@ impl<'a> SpiProcessor<'a> {
                 }
             },
             firmware::RebootTime::Delayed => {
-                // TODO(https://github.com/google/tock-on-titan/issues/236): Implement this.
-                firmware::RebootResult::Error
+                // Ack now, reset from the main loop once this exchange
+                // is finished. This is the switchover half of a
+                // background update: the new image was streamed into
+                // the inactive bank while the device kept serving, and
+                // the only downtime left is the reboot itself.
+                self.reboot_pending = true;
+                firmware::RebootResult::Success
             },
         };
 
@@ -343,19 +403,21 @@ impl<'a> SpiProcessor<'a> {
         result
     }
 
-    fn process_spi_payload(&mut self, mut data: &[u8]) -> SpiProcessorResult<()> {
-        let header = payload::Header::from_wire(&mut data)?;
-        if header.checksum != payload::compute_checksum(&header, data) {
+    fn process_spi_payload(&mut self, data: &[u8]) -> SpiProcessorResult<()> {
+        // Borrowed view: the header fields and checksum are read straight
+        // out of the receive buffer without deserializing into a struct.
+        let (header, data) = payload::HeaderView::new(data)?;
+        if !header.verify_checksum(data) {
             let error = error::BadChecksum {};
             return self.send_error(error);
         }
 
-        match header.content {
-            payload::ContentType::Manticore => {
-                self.process_manticore(&data[..header.content_len as usize])
+        match header.content() {
+            Some(payload::ContentType::Manticore) => {
+                self.process_manticore(&data[..header.content_len()])
             }
-            payload::ContentType::Firmware => {
-                self.process_firmware(&data[..header.content_len as usize])
+            Some(payload::ContentType::Firmware) => {
+                self.process_firmware(&data[..header.content_len()])
             }
             _ => {
                 let error = error::ContentTypeNotSupported {};
@@ -374,43 +436,29 @@ impl<'a> SpiProcessor<'a> {
     {
         // We need to update the header so copy it.
         let mut header = *header;
+        // One staging buffer for all chunks: only the header and the chunk
+        // data are rewritten per chunk, instead of refilling the whole
+        // buffer. Bytes beyond tx_len are never transmitted.
+        let mut tx_buf = [0xff; spi_host::MAX_READ_BUFFER_LENGTH];
+        let mut tx_len = stage_chunk(&mut header, &mut data, &mut tx_buf)?;
         loop {
             pre_transaction_fn()?;
 
-            let mut tx_buf = [0xff; spi_host::MAX_READ_BUFFER_LENGTH];
-            let tx_len : usize;
-            let data_len_to_send : usize;
-            {
-                let mut tx_cursor = SpiutilsCursor::new(&mut tx_buf);
-                header.to_wire(&mut tx_cursor)?;
-                if header.opcode.has_dummy_byte() {
-                    // Skip one dummy byte (send 0x0)
-                    tx_cursor.write_bytes(&[0x0; 1])
-                        .map_err(|err| SpiProcessorError::ToWire(ToWireError::Io(err)))?;
-                }
-
-                data_len_to_send = min(spi_host::MAX_READ_BUFFER_LENGTH - tx_cursor.consumed_len(), data.len());
-                tx_cursor.write_bytes(&data[..data_len_to_send])
-                    .map_err(|err| SpiProcessorError::ToWire(ToWireError::Io(err)))?;
-
-                tx_len = tx_cursor.consumed_len()
-            }
-
             spi_host_h1::get().set_wait_busy_clear_in_transactions(header.opcode.wait_busy_clear())?;
             spi_host::get().read_write_bytes(&mut tx_buf, tx_len)?;
-            spi_host::get().wait_read_write_done();
 
-            // Move data and address forward
-            data = &data[data_len_to_send..];
-            if let Some(addr) = header.address {
-                let delta : u32 = core::convert::TryFrom::<usize>::try_from(data_len_to_send)
-                    .map_err(|_| SpiProcessorError::FromWire(FromWireError::OutOfRange))?;
-                let next_addr = addr.into() + delta;
-                header.address = Some(AddrType::try_from(next_addr)
-                    .map_err(|_| SpiProcessorError::FromWire(FromWireError::OutOfRange))?);
+            // The kernel copies the staging buffer out during the command
+            // itself, so tx_buf is free again as soon as read_write_bytes
+            // returns: stage the next chunk while this one is still on the
+            // wire instead of after it completes.
+            let more = data.len() > 0;
+            if more {
+                tx_len = stage_chunk(&mut header, &mut data, &mut tx_buf)?;
             }
 
-            if data.len() == 0 { break; }
+            spi_host::get().wait_read_write_done();
+
+            if !more { break; }
         }
         Ok(())
     }
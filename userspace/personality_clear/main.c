@@ -29,7 +29,7 @@
 #include "fips.h"
 #include "x509.h"
 
-#include <stdio.h>
+#include "fmt.h"
 #include <string.h>
 #include <timer.h>
 #include <rng.h>
@@ -47,9 +47,9 @@ static void clear_personality(void) {
 int main(void) {
   init_fips();
   if (kl_init()) {
-    printf("kl_init() FAIL\n");
+    h1_printf("kl_init() FAIL\n");
   }
-  printf("= Clearing Personality =\n");
+  h1_printf("= Clearing Personality =\n");
   clear_personality();
   return 0;
 }
@@ -1,26 +0,0 @@
-// Copyright 2019 Google LLC
-//
-// Licensed under the Apache License, Version 2.0 (the "License");
-// you may not use this file except in compliance with the License.
-// You may obtain a copy of the License at
-//
-//     https://www.apache.org/licenses/LICENSE-2.0
-//
-// Unless required by applicable law or agreed to in writing, software
-// distributed under the License is distributed on an "AS IS" BASIS,
-// WITHOUT WARRANTIES OR CONDITIONS OF ANY KIND, either express or implied.
-// See the License for the specific language governing permissions and
-// limitations under the License.
-
-#ifndef __FIPS_ENTROPY_H
-#define __FIPS_ENTROPY_H
-
-void flash_info_read_enable(uint32_t addr, uint32_t size);
-void flash_info_read_enable(uint32_t addr, uint32_t size) {}
-
-uint32_t flash_physical_info_read_word(uint32_t addr);
-uint32_t flash_physical_info_read_word(uint32_t addr) {
-  return fips_entropy[addr];
-}
-
-#endif
@@ -12,26 +12,208 @@
 // See the License for the specific language governing permissions and
 // limitations under the License.
 
+// Entropy broker. Owns the TRNG health-test pipeline and serves random
+// bytes to other apps over IPC (see entropy_ipc.h for the protocol),
+// so TRNG draining and screening happen in exactly one place.
+//
+// Availability ordering matters more than anything else here: the
+// 4096-sample TRNG startup screen takes long enough that apps wanting
+// a post-boot nonce would stall behind it. So the broker first
+// restores last boot's seed from flash (encrypted under a key ladder
+// branch, so the blob is useless off this device), seeds its DRBG from
+// it and starts serving; only then does it run the TRNG startup tests
+// and fold fresh hardware entropy into the generator. A device that
+// has never booted before, or whose seed record fails its MAC, simply
+// waits for the TRNG instead.
+
 #include <stdint.h>
 #include <stdio.h>
+#include <string.h>
 #include <tock.h>
-#include <rng.h>
 
-struct rng_data {
-  bool done;
-  int len;
-};
+#include "drbg.h"
+#include "entropy_ipc.h"
+#include "fips.h"
+#include "fips_err.h"
+#include "kl.h"
+#include "flash_layout.h"
+#include "kvstore.h"
+#include "trng.h"
+
+// The seed record lives in a kvstore on this app's own page pair (see
+// flash_layout.h): kvstore state is per-process, so the pair cannot be
+// shared with the u2f_app's FIPS store.
+#define SEED_STORE_KEY 0x53454531 /* "SEE1" */
+
+// Key ladder branches for the seed pad and the record MAC. Like the
+// KAT cache seed in fips.c, these only need to be distinct from every
+// other branch in use.
+static const uint32_t KL_SEED_POOL_PAD[8] = {
+    0x2e544b46, 0x656e7472, 0x6f707970, 0x00000061,
+    0x00000000, 0x00000000, 0x00000000, 0x00000000};
+static const uint32_t KL_SEED_POOL_MAC[8] = {
+    0x2e544b46, 0x656e7472, 0x6f707970, 0x0000006d,
+    0x00000000, 0x00000000, 0x00000000, 0x00000000};
+
+// nonce feeds the pad derivation so a fresh seed never reuses an old
+// pad; mac covers the ciphertext so a tampered or bitrotted record is
+// rejected rather than folded into the generator.
+typedef struct {
+  uint32_t nonce;
+  uint32_t cipher[8];
+  uint32_t mac[8];
+} seed_record;
+
+static DRBG broker_drbg;
+static int drbg_ready;
+static int trng_ready;
+static uint32_t served_calls;
+static uint32_t served_bytes;
+
+static int seed_pad(uint32_t nonce, uint32_t pad[8]) {
+  uint32_t input[8] = {nonce, 0, 0, 0, 0, 0, 0, 0};
+  return kl_derive(KL_SEED_POOL_PAD, input, pad);
+}
+
+// Loads and decrypts last boot's seed. Returns 0 and fills seed[8]
+// only if the record's MAC checks out.
+static int seed_restore(uint32_t seed[8], uint32_t* nonce) {
+  seed_record rec;
+  uint32_t mac[8], pad[8];
+  int i;
+
+  if (tock_kvstore_get(SEED_STORE_KEY, &rec, sizeof(rec)) !=
+      (int)sizeof(rec))
+    return -1;
+  if (kl_derive(KL_SEED_POOL_MAC, rec.cipher, mac)) return -1;
+  if (memcmp(rec.mac, mac, sizeof(mac))) return -1;
+  if (seed_pad(rec.nonce, pad)) return -1;
+
+  for (i = 0; i < 8; i++) seed[i] = rec.cipher[i] ^ pad[i];
+  memset(pad, 0, sizeof(pad));
+  *nonce = rec.nonce;
+  return 0;
+}
+
+// Writes the next boot's seed: fresh generator output, encrypted under
+// a pad derived from a nonce this record has never used.
+static void seed_persist(uint32_t nonce) {
+  seed_record rec;
+  uint32_t seed[8], pad[8];
+  int i;
+
+  if (DRBG_generate(&broker_drbg, seed, sizeof(seed), NULL, 0) !=
+      EC_SUCCESS)
+    return;
+
+  rec.nonce = nonce;
+  if (seed_pad(rec.nonce, pad)) return;
+  for (i = 0; i < 8; i++) rec.cipher[i] = seed[i] ^ pad[i];
+  memset(seed, 0, sizeof(seed));
+  memset(pad, 0, sizeof(pad));
+
+  if (kl_derive(KL_SEED_POOL_MAC, rec.cipher, rec.mac)) return;
+  if (tock_kvstore_put(SEED_STORE_KEY, &rec, sizeof(rec)) != TOCK_SUCCESS)
+    printf("rng: could not persist next-boot seed\n");
+}
+
+// IPC request handler: first word of the shared buffer is the byte
+// count; the response overwrites it with the served count (or a
+// negative error) and puts the bytes right after it.
+static void entropy_handler(int pid, uint8_t* buf, size_t len,
+                            void* ud __attribute__((unused))) {
+  uint32_t req;
+  int32_t res;
+
+  if (len < 2 * sizeof(uint32_t)) return;
+  memcpy(&req, buf, sizeof(req));
+  if (req > len - sizeof(uint32_t)) req = len - sizeof(uint32_t);
+
+  if (!drbg_ready) {
+    res = TOCK_EBUSY;
+  } else {
+    if (DRBG_generate(&broker_drbg, buf + sizeof(uint32_t), req, NULL, 0) !=
+        EC_SUCCESS) {
+      // Reseed interval exhausted; fold in fresh TRNG words and retry.
+      uint32_t fresh[8];
+      int i;
+      for (i = 0; i < 8; i++) fresh[i] = fips_rand();
+      DRBG_reseed(&broker_drbg, fresh, sizeof(fresh), NULL, 0, NULL, 0);
+      memset(fresh, 0, sizeof(fresh));
+      res = DRBG_generate(&broker_drbg, buf + sizeof(uint32_t), req, NULL,
+                          0) == EC_SUCCESS
+                ? (int32_t)req
+                : TOCK_FAIL;
+    } else {
+      res = (int32_t)req;
+    }
+  }
+
+  if (res > 0) {
+    served_calls++;
+    served_bytes += res;
+  }
+  memcpy(buf, &res, sizeof(res));
+  h1_ipc_reply(pid);
+}
 
 int main(void) {
-  printf("Boooting RNG test application. Should output 250 words.\n");
+  uint32_t seed[8];
+  uint32_t nonce = 0;
+
+  printf("Booting entropy broker.\n");
 
-  unsigned long buf[250];
-  int size = sizeof(buf);
-  int len = rng_sync((uint8_t*)buf, size, size);
-  len = len / 4;
-  printf("Read %d words of random data.\n", len);
-  for (int i = 0; i < len; i++) {
-    printf("Sample data %i = 0x%08lx\n", i, buf[i]);
+  if (kl_init() != EC_SUCCESS) {
+    printf("rng: key ladder init failed\n");
+    return 1;
+  }
+  if (tock_kvstore_init(FLASH_LAYOUT_RNG_SEED_PAGE) != TOCK_SUCCESS) {
+    printf("rng: seed store mount failed\n");
+    return 1;
+  }
+
+  if (seed_restore(seed, &nonce) == 0) {
+    DRBG_init(&broker_drbg, seed, sizeof(seed), "entropy-broker",
+              sizeof("entropy-broker"), NULL, 0);
+    memset(seed, 0, sizeof(seed));
+    drbg_ready = 1;
+    printf("rng: serving from persisted seed\n");
+  } else {
+    printf("rng: no usable persisted seed; waiting for TRNG startup\n");
+  }
+
+  if (h1_ipc_register_service(entropy_handler, NULL) < 0) {
+    printf("rng: could not register IPC service\n");
+    return 1;
+  }
+
+  // Requests arrive from here on, answered during any yield below.
+  // Now pay for the TRNG startup screen and promote the generator to
+  // hardware-backed.
+  fips_trng_startup();
+  {
+    uint32_t fresh[16];
+    int i;
+    for (i = 0; i < 16; i++) fresh[i] = fips_rand();
+    if (drbg_ready) {
+      DRBG_reseed(&broker_drbg, fresh, sizeof(fresh), NULL, 0, NULL, 0);
+    } else {
+      DRBG_init(&broker_drbg, fresh, sizeof(fresh), "entropy-broker",
+                sizeof("entropy-broker"), NULL, 0);
+      drbg_ready = 1;
+    }
+    memset(fresh, 0, sizeof(fresh));
+  }
+  trng_ready = 1;
+
+  // Persist next boot's seed now that hardware entropy is in the
+  // generator, then keep the qualified-word ring topped up between
+  // requests.
+  seed_persist(nonce + 1);
+  printf("rng: TRNG online, next-boot seed persisted\n");
+
+  while (1) {
+    yield();
+    if (trng_ready) fips_trng_top_up();
   }
-  return 0;
 }
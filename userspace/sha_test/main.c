@@ -43,6 +43,54 @@ static void print_buffer(const uint8_t* buf, size_t len) {
   }
 }
 
+#ifdef SHA_SWEEP
+#include "timestamp_syscalls.h"
+
+// Chunk-size sweep: hashes the same amount of data through
+// tock_digest_hash_update() at chunk sizes from 16B to 4KB and prints
+// the throughput of each, to measure where the per-chunk syscall cost
+// stops dominating the engine's streaming rate. The winning size is
+// what libh1's streaming shim should use for its staging ring; build
+// it with -DDIGEST_RING_BYTES=<best chunk> (see tock_shims.c).
+#define SWEEP_TOTAL_BYTES (64 * 1024)
+static uint8_t sweep_buf[4096];
+
+static void chunk_sweep(void) {
+  size_t best_chunk = 0;
+  uint32_t best_kbps = 0;
+
+  if (tock_timestamp_check() != TOCK_SUCCESS) {
+    printf("No timestamp driver; cannot run the chunk sweep.\n");
+    return;
+  }
+  printf("Chunk-size sweep, %u bytes hashed per chunk size:\n",
+         (unsigned int)SWEEP_TOTAL_BYTES);
+  for (size_t chunk = 16; chunk <= sizeof(sweep_buf); chunk *= 2) {
+    tock_digest_hash_initialize(DIGEST_MODE_SHA256);
+    tock_digest_set_output(hash_output, sizeof(hash_output));
+    uint32_t start = gettimeus();
+    for (size_t fed = 0; fed < SWEEP_TOTAL_BYTES; fed += chunk) {
+      tock_digest_set_input(sweep_buf, chunk);
+      tock_digest_hash_update(chunk);
+    }
+    tock_digest_hash_finalize();
+    uint32_t us = gettimeus() - start;
+    uint32_t kbps =
+        (uint32_t)(((uint64_t)SWEEP_TOTAL_BYTES * 1000000) / us / 1024);
+    printf("chunk=%4u us=%6lu throughput=%luKB/s\n", (unsigned int)chunk,
+           (unsigned long)us, (unsigned long)kbps);
+    if (kbps > best_kbps) {
+      best_kbps = kbps;
+      best_chunk = chunk;
+    }
+  }
+  printf("Best chunk: %u bytes (%luKB/s); build libh1 with "
+         "-DDIGEST_RING_BYTES=%u\n",
+         (unsigned int)best_chunk, (unsigned long)best_kbps,
+         (unsigned int)best_chunk);
+}
+#endif  // SHA_SWEEP
+
 int main(void) {
   gpio_enable_output(LED_0);
   gpio_set(LED_0);
@@ -77,6 +125,10 @@ int main(void) {
   int result = memcmp(hash_output, reference_hash, hash_size);
   gpio_clear(LED_0);
 
+#ifdef SHA_SWEEP
+  chunk_sweep();
+#endif
+
   while (1) {
     if (result != 0) {
       gpio_toggle(LED_0);
@@ -12,12 +12,135 @@
 // See the License for the specific language governing permissions and
 // limitations under the License.
 
+// Interference load generator. Built with no flags this is the
+// original spin: a while(1) loop that never makes a system call, for
+// testing time-slicing against a co-resident app. The make flags turn
+// it into a calibrated interference source for measuring how much a
+// neighbor (u2f_app in particular) degrades under load:
+//
+//   SPIN_DUTY=<0-100>     CPU burned per 10ms period, the rest slept.
+//   SPIN_TIMER=<n>        timestamp syscalls issued per period.
+//   SPIN_CONSOLE=<n>      console bytes written per period.
+//   SPIN_FLASH=<n>        128-byte sync flash reads per period.
+//   SPIN_FOOTPRINT=<n>    bytes of static memory walked per period.
+//
+// Every 1000 periods the app prints its measured busy time per period
+// so logs show the duty cycle actually achieved, not just the one
+// requested. The flags exist because the runner's console is one-way;
+// there is no channel for interactive commands, so each load shape is
+// a build.
+
 #include <gpio.h>
 int x;
 
+#if defined(SPIN_DUTY) || defined(SPIN_TIMER) || defined(SPIN_CONSOLE) || \
+    defined(SPIN_FLASH) || defined(SPIN_FOOTPRINT)
+
+#include <console.h>
+#include <string.h>
+
+#include "fmt.h"
+#include "timer.h"
+#include "timestamp_syscalls.h"
+#include "tock.h"
+
+#ifndef SPIN_DUTY
+#define SPIN_DUTY 100
+#endif
+#ifndef SPIN_TIMER
+#define SPIN_TIMER 0
+#endif
+#ifndef SPIN_CONSOLE
+#define SPIN_CONSOLE 0
+#endif
+#ifndef SPIN_FLASH
+#define SPIN_FLASH 0
+#endif
+#ifndef SPIN_FOOTPRINT
+#define SPIN_FOOTPRINT 0
+#endif
+
+#define SPIN_PERIOD_US 10000
+#define SPIN_REPORT_PERIODS 1000
+
+#define H1_DRIVER_FLASH 0x40040
+#define TOCK_FLASH_CMD_READ 3
+#define TOCK_FLASH_ALLOW_READ 1
+
+// Read target: the personality page, the first page in the window the
+// flash driver serves. Reads are non-destructive.
+#define SPIN_FLASH_OFFSET ((256 - 3) * 2048)
+
+#if SPIN_FOOTPRINT > 0
+static volatile uint8_t footprint[SPIN_FOOTPRINT];
+#endif
+
+static uint8_t flash_buf[128];
+static const char console_pad[] =
+    "spin interference filler........................................\n";
+
+int main(void) {
+  uint32_t period = 0;
+  uint32_t busy_accum = 0;
+
+  h1_printf("= spin: duty=%d%% timer=%d console=%dB flash=%d footprint=%dB =\n",
+            SPIN_DUTY, SPIN_TIMER, SPIN_CONSOLE, SPIN_FLASH, SPIN_FOOTPRINT);
+  if (tock_timestamp_check() != TOCK_SUCCESS) {
+    h1_printf("ERROR: no timestamp driver; cannot pace the duty cycle.\n");
+    return 1;
+  }
+
+  while (1) {
+    uint32_t start = gettimeus();
+
+    // CPU burn: arithmetic in bursts, checking the clock only every
+    // 1024 iterations so the busy phase stays mostly syscall-free.
+    while (gettimeus() - start < (SPIN_PERIOD_US * SPIN_DUTY) / 100) {
+      for (int i = 0; i < 1024; i++) { x += i; }
+    }
+
+    for (int i = 0; i < SPIN_TIMER; i++) {
+      (void)gettimeus();
+    }
+    for (int sent = 0; sent < SPIN_CONSOLE; sent += sizeof(console_pad) - 1) {
+      int chunk = SPIN_CONSOLE - sent;
+      if (chunk > (int)sizeof(console_pad) - 1) chunk = sizeof(console_pad) - 1;
+      putnstr(console_pad, chunk);
+    }
+    for (int i = 0; i < SPIN_FLASH; i++) {
+      if (allow(H1_DRIVER_FLASH, TOCK_FLASH_ALLOW_READ, flash_buf,
+                sizeof(flash_buf)) >= 0) {
+        command(H1_DRIVER_FLASH, TOCK_FLASH_CMD_READ, SPIN_FLASH_OFFSET,
+                sizeof(flash_buf));
+      }
+    }
+#if SPIN_FOOTPRINT > 0
+    for (unsigned int i = 0; i < SPIN_FOOTPRINT; i++) {
+      footprint[i] = (uint8_t)(footprint[i] + 1);
+    }
+#endif
+
+    uint32_t busy = gettimeus() - start;
+    busy_accum += busy;
+    if (++period % SPIN_REPORT_PERIODS == 0) {
+      h1_printf("spin period=%lu busy_us=%lu/%u\n", (unsigned long)period,
+                (unsigned long)(busy_accum / SPIN_REPORT_PERIODS),
+                SPIN_PERIOD_US);
+      busy_accum = 0;
+    }
+
+    if (busy < SPIN_PERIOD_US) {
+      delay_ms((SPIN_PERIOD_US - busy) / 1000);
+    }
+  }
+}
+
+#else  // Original spin: no system calls at all.
+
 int main(void) {
   while(1) {
     for (int i = 0; i < 1000000; i++) {x+=i;}
   }
 }
 
+#endif
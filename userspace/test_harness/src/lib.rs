@@ -21,8 +21,14 @@
 
 mod assertions;
 mod compiler_required;
+mod perf;
+mod power;
+mod sram;
 
 pub use self::assertions::*;
 pub use self::compiler_required::*;
+pub use self::perf::*;
+pub use self::power::*;
+pub use self::sram::*;
 
 libtock_core::stack_size!{2048}
@@ -0,0 +1,84 @@
+// Copyright 2021 Google LLC
+//
+// Licensed under the Apache License, Version 2.0 (the "License");
+// you may not use this file except in compliance with the License.
+// You may obtain a copy of the License at
+//
+//     https://www.apache.org/licenses/LICENSE-2.0
+//
+// Unless required by applicable law or agreed to in writing, software
+// distributed under the License is distributed on an "AS IS" BASIS,
+// WITHOUT WARRANTIES OR CONDITIONS OF ANY KIND, either express or implied.
+// See the License for the specific language governing permissions and
+// limitations under the License.
+
+/// Performance regression checks for device tests.
+///
+/// A test reports named metric values (latencies, cycle counts, byte
+/// rates) with require_perf!; every value is echoed on a PERF_METRIC
+/// console line so a run always produces the current numbers, and if
+/// the test crate carries a baseline for that metric on the board the
+/// image was built for, a value more than PERF_MARGIN_PERCENT above
+/// the baseline fails the test — which fails the suite, so the runner
+/// exits nonzero and CI blocks the regression.
+///
+/// Baselines are compiled into the test image rather than stored on
+/// the device: the flash pages userspace can write belong to the
+/// personality and the nvcounter, and the runner's console is
+/// one-way. They live in the test crates next to the tests that
+/// measure them, one entry per board, and are updated by editing the
+/// table with the PERF_METRIC values from a known-good run.
+
+/// Slack tolerated above a baseline before a metric counts as a
+/// regression; covers run-to-run jitter from interrupt timing and
+/// flash pulse retries.
+pub const PERF_MARGIN_PERCENT: u32 = 10;
+
+/// The board this test image targets, from the build system
+/// (TANGO_PERF_BOARD); None when built outside make, e.g. by a bare
+/// `cargo test`, in which case all baselines are ignored.
+pub const PERF_BOARD: Option<&'static str> = option_env!("TANGO_PERF_BOARD");
+
+/// A known-good metric value for one board. Metrics are sized so that
+/// larger is worse (report a duration, not a rate).
+pub struct PerfBaseline {
+    pub board: &'static str,
+    pub metric: &'static str,
+    pub value: u32,
+}
+
+/// Reports a metric value and compares it against the board's
+/// baseline, if the table has one. Returns false on a regression.
+pub fn check_metric(metric: &str, value: u32, baselines: &[PerfBaseline]) -> bool {
+    let board = PERF_BOARD.unwrap_or("unknown");
+    libtock::println!("PERF_METRIC board={} {}={}", board, metric, value);
+    for baseline in baselines {
+        if baseline.board != board || baseline.metric != metric {
+            continue;
+        }
+        if value as u64 * 100 > baseline.value as u64 * (100 + PERF_MARGIN_PERCENT) as u64 {
+            libtock::println!("PERF_REGRESSION {}: {} > baseline {} (+{}%)",
+                              metric, value, baseline.value, PERF_MARGIN_PERCENT);
+            return false;
+        }
+        return true;
+    }
+    // No baseline for this board: the value is recorded but not gated,
+    // so new metrics can bake on the fleet before the table is filled.
+    true
+}
+
+/// Reports a named metric and fails the test if it regressed past the
+/// board's baseline. Usage mirrors require!:
+///     require_perf!("erase_page_us", elapsed, &BASELINES);
+#[macro_export]
+macro_rules! require_perf {
+    ($metric:expr, $value:expr, $baselines:expr) => (
+        if !test::check_metric($metric, $value, $baselines) {
+            return false;
+        }
+    );
+    ($metric:expr, $value:expr, $baselines:expr,) => (
+        require_perf!($metric, $value, $baselines)
+    );
+}
@@ -0,0 +1,77 @@
+// Copyright 2021 Google LLC
+//
+// Licensed under the Apache License, Version 2.0 (the "License");
+// you may not use this file except in compliance with the License.
+// You may obtain a copy of the License at
+//
+//     https://www.apache.org/licenses/LICENSE-2.0
+//
+// Unless required by applicable law or agreed to in writing, software
+// distributed under the License is distributed on an "AS IS" BASIS,
+// WITHOUT WARRANTIES OR CONDITIONS OF ANY KIND, either express or implied.
+// See the License for the specific language governing permissions and
+// limitations under the License.
+
+/// PMU power-state telemetry for device tests.
+///
+/// The kernel accumulates time asleep, the number of sleep periods,
+/// and time the crypto engine clocks were boosted, readable through
+/// the timestamp driver. A benchmark takes a power_sample() before
+/// the measured section and report_power() after: the diffs land on a
+/// POWER_TELEMETRY console line next to the PERF_METRIC output, so a
+/// latency win that trades away sleep time (duty cycle) shows up in
+/// the same run. Individual diffs also work with require_perf!
+/// (crypto_us and the sleep count are sized so larger is worse).
+
+const DRIVER_TIMESTAMP: usize = 0x40080;
+
+const CMD_SLEEP_US: usize = 5;
+const CMD_SLEEP_COUNT: usize = 6;
+const CMD_CRYPTO_US: usize = 7;
+
+fn read(cmd: usize) -> u32 {
+    unsafe { libtock::syscalls::raw::command(DRIVER_TIMESTAMP, cmd, 0, 0) as u32 }
+}
+
+/// One reading of the kernel's cumulative power counters. All fields
+/// wrap in u32; diff two samples with sleep_us_since() and friends
+/// rather than comparing absolutes.
+#[derive(Clone, Copy)]
+pub struct PowerSample {
+    pub sleep_us: u32,
+    pub sleep_count: u32,
+    pub crypto_us: u32,
+}
+
+pub fn power_sample() -> PowerSample {
+    PowerSample {
+        sleep_us: read(CMD_SLEEP_US),
+        sleep_count: read(CMD_SLEEP_COUNT),
+        crypto_us: read(CMD_CRYPTO_US),
+    }
+}
+
+impl PowerSample {
+    pub fn sleep_us_since(&self, start: &PowerSample) -> u32 {
+        self.sleep_us.wrapping_sub(start.sleep_us)
+    }
+
+    pub fn sleeps_since(&self, start: &PowerSample) -> u32 {
+        self.sleep_count.wrapping_sub(start.sleep_count)
+    }
+
+    pub fn crypto_us_since(&self, start: &PowerSample) -> u32 {
+        self.crypto_us.wrapping_sub(start.crypto_us)
+    }
+}
+
+/// Prints the counter movement since `start` for the runner to log.
+pub fn report_power(start: &PowerSample) {
+    let now = power_sample();
+    libtock::println!(
+        "POWER_TELEMETRY sleep_us={} sleeps={} crypto_us={}",
+        now.sleep_us_since(start),
+        now.sleeps_since(start),
+        now.crypto_us_since(start)
+    );
+}
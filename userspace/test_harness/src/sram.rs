@@ -0,0 +1,92 @@
+// Copyright 2021 Google LLC
+//
+// Licensed under the Apache License, Version 2.0 (the "License");
+// you may not use this file except in compliance with the License.
+// You may obtain a copy of the License at
+//
+//     https://www.apache.org/licenses/LICENSE-2.0
+//
+// Unless required by applicable law or agreed to in writing, software
+// distributed under the License is distributed on an "AS IS" BASIS,
+// WITHOUT WARRANTIES OR CONDITIONS OF ANY KIND, either express or implied.
+// See the License for the specific language governing permissions and
+// limitations under the License.
+
+/// SRAM watermark instrumentation for device tests.
+///
+/// Stack and grant sizes are set by guesswork (stack_size! per crate,
+/// STACK_SIZE per C app), and oversized allocations starve the buffer
+/// pools. A test calls stack_paint() first, exercises its workload,
+/// then report_sram() prints how much painted stack was never touched
+/// and how much RAM the kernel's grant allocations consumed, on an
+/// SRAM_WATERMARK console line the runner can log alongside
+/// PERF_METRIC output. The readouts also work as plain values for
+/// require_perf! gating (both are sized so larger is not worse, so
+/// gate on e.g. grant_bytes only).
+
+const STACK_PAINT: u32 = 0xC5C5_C5C5;
+
+// Tock memop operations used here.
+const MEMOP_MEMORY_START: u32 = 2;
+const MEMOP_MEMORY_END: u32 = 3;
+const MEMOP_GRANT_START: u32 = 6;
+
+fn memop(op: u32, arg: usize) -> usize {
+    unsafe { libtock::syscalls::raw::memop(op, arg) as usize }
+}
+
+/// Paints the unused stack. The stack sits at the bottom of the
+/// process RAM block (the layout stack_size! sets up) and grows down
+/// toward it, so the paint runs from memory start up to just below the
+/// live frame, with a small guard for this function's own use.
+pub fn stack_paint() {
+    let marker = 0u32;
+    let sp = &marker as *const u32 as usize;
+    let base = memop(MEMOP_MEMORY_START, 0);
+
+    if sp <= base + 64 {
+        return;
+    }
+    let mut p = base as *mut u32;
+    let top = ((sp - 64) & !3) as *mut u32;
+    unsafe {
+        while p < top {
+            core::ptr::write_volatile(p, STACK_PAINT);
+            p = p.add(1);
+        }
+    }
+}
+
+/// Bytes of painted stack never touched since stack_paint(): the
+/// amount the crate's stack_size! could shrink by, less margin.
+pub fn stack_headroom() -> usize {
+    let base = memop(MEMOP_MEMORY_START, 0) as *const u32;
+    let end = memop(MEMOP_MEMORY_END, 0);
+    let mut n = 0usize;
+
+    unsafe {
+        while (base.add(n) as usize) < end
+            && core::ptr::read_volatile(base.add(n)) == STACK_PAINT
+        {
+            n += 1;
+        }
+    }
+    n * core::mem::size_of::<u32>()
+}
+
+/// Bytes the kernel has carved off the top of the process RAM block
+/// for grant state, across all drivers. (Per-driver attribution would
+/// need kernel-side counters; the grant region is one contiguous
+/// carve-out from up here.)
+pub fn grant_bytes() -> usize {
+    memop(MEMOP_MEMORY_END, 0) - memop(MEMOP_GRANT_START, 0)
+}
+
+/// Prints the current watermarks for the runner to log.
+pub fn report_sram() {
+    libtock::println!(
+        "SRAM_WATERMARK stack_headroom={} grant_bytes={}",
+        stack_headroom(),
+        grant_bytes()
+    );
+}
@@ -0,0 +1,202 @@
+// Copyright 2021 Google LLC
+//
+// Licensed under the Apache License, Version 2.0 (the "License");
+// you may not use this file except in compliance with the License.
+// You may obtain a copy of the License at
+//
+//     https://www.apache.org/licenses/LICENSE-2.0
+//
+// Unless required by applicable law or agreed to in writing, software
+// distributed under the License is distributed on an "AS IS" BASIS,
+// WITHOUT WARRANTIES OR CONDITIONS OF ANY KIND, either express or implied.
+// See the License for the specific language governing permissions and
+// limitations under the License.
+
+/*
+ * Zero-copy CBOR codec. See cbor.h for the interface contract.
+ */
+
+#include <string.h>
+
+#include "cbor.h"
+
+/* Deepest container nesting cbor_skip() will walk. CTAP2 requests top
+ * out around four levels; the bound keeps recursion off a hostile
+ * message from eating the 4KB app stack. */
+#define CBOR_MAX_DEPTH 8
+
+void cbor_reader_init(CBOR_READER *r, const uint8_t *buf, size_t len) {
+  r->p = buf;
+  r->end = buf + len;
+}
+
+int cbor_read(CBOR_READER *r, CBOR_ITEM *item) {
+  uint8_t ib, ai;
+  uint32_t v;
+  size_t need;
+
+  if (r->p >= r->end) return -1;
+  ib = *r->p++;
+  item->type = ib >> 5;
+  item->slice = NULL;
+  ai = ib & 0x1f;
+
+  if (ai < 24) {
+    v = ai;
+  } else if (ai <= 27) {
+    need = (size_t)1 << (ai - 24); /* 1, 2, 4 or 8 argument bytes */
+    if ((size_t)(r->end - r->p) < need) return -1;
+    v = 0;
+    /* A 64-bit argument is fine as long as the top word is zero. */
+    if (need == 8) {
+      if (r->p[0] | r->p[1] | r->p[2] | r->p[3]) return -1;
+      r->p += 4;
+      need = 4;
+    }
+    while (need--) v = (v << 8) | *r->p++;
+  } else {
+    /* 28-30 are reserved, 31 is indefinite length: not canonical. */
+    return -1;
+  }
+  item->value = v;
+
+  if (item->type == CBOR_BSTR || item->type == CBOR_TSTR) {
+    if ((size_t)(r->end - r->p) < v) return -1;
+    item->slice = r->p;
+    r->p += v;
+  }
+  return 0;
+}
+
+static int cbor_skip_depth(CBOR_READER *r, int depth) {
+  CBOR_ITEM item;
+  uint32_t children;
+
+  if (depth >= CBOR_MAX_DEPTH) return -1;
+  if (cbor_read(r, &item)) return -1;
+
+  switch (item.type) {
+  case CBOR_ARRAY:
+    children = item.value;
+    break;
+  case CBOR_MAP:
+    if (item.value > UINT32_MAX / 2) return -1;
+    children = item.value * 2;
+    break;
+  case CBOR_TAG:
+    children = 1;
+    break;
+  default:
+    return 0; /* scalars and strings carry no children */
+  }
+
+  while (children--) {
+    if (cbor_skip_depth(r, depth + 1)) return -1;
+  }
+  return 0;
+}
+
+int cbor_skip(CBOR_READER *r) { return cbor_skip_depth(r, 0); }
+
+int cbor_tstr_eq(const CBOR_ITEM *item, const char *s) {
+  size_t n = strlen(s);
+
+  return item->type == CBOR_TSTR && item->value == n &&
+         memcmp(item->slice, s, n) == 0;
+}
+
+void cbor_writer_init(CBOR_WRITER *w, uint8_t *buf, size_t len) {
+  w->start = buf;
+  w->p = buf;
+  w->end = buf + len;
+  w->overflow = 0;
+}
+
+size_t cbor_writer_len(const CBOR_WRITER *w) {
+  return (size_t)(w->p - w->start);
+}
+
+int cbor_writer_ok(const CBOR_WRITER *w) { return !w->overflow; }
+
+static uint8_t *writer_reserve(CBOR_WRITER *w, size_t len) {
+  uint8_t *p = w->p;
+
+  if (w->overflow || (size_t)(w->end - w->p) < len) {
+    w->overflow = 1;
+    return NULL;
+  }
+  w->p += len;
+  return p;
+}
+
+/* Minimal-length head encoding, as canonical CBOR requires. */
+static void write_head(CBOR_WRITER *w, uint8_t type, uint32_t v) {
+  uint8_t *p;
+
+  if (v < 24) {
+    p = writer_reserve(w, 1);
+    if (p) p[0] = (type << 5) | v;
+  } else if (v <= 0xff) {
+    p = writer_reserve(w, 2);
+    if (p) {
+      p[0] = (type << 5) | 24;
+      p[1] = v;
+    }
+  } else if (v <= 0xffff) {
+    p = writer_reserve(w, 3);
+    if (p) {
+      p[0] = (type << 5) | 25;
+      p[1] = v >> 8;
+      p[2] = v;
+    }
+  } else {
+    p = writer_reserve(w, 5);
+    if (p) {
+      p[0] = (type << 5) | 26;
+      p[1] = v >> 24;
+      p[2] = v >> 16;
+      p[3] = v >> 8;
+      p[4] = v;
+    }
+  }
+}
+
+void cbor_write_uint(CBOR_WRITER *w, uint32_t v) {
+  write_head(w, CBOR_UINT, v);
+}
+
+void cbor_write_nint(CBOR_WRITER *w, uint32_t n) {
+  write_head(w, CBOR_NINT, n);
+}
+
+void cbor_write_bool(CBOR_WRITER *w, int b) {
+  write_head(w, CBOR_SIMPLE, b ? CBOR_TRUE : CBOR_FALSE);
+}
+
+void cbor_write_bstr(CBOR_WRITER *w, const uint8_t *data, size_t len) {
+  uint8_t *p = cbor_write_bstr_reserve(w, len);
+
+  if (p) memcpy(p, data, len);
+}
+
+void cbor_write_tstr(CBOR_WRITER *w, const char *s) {
+  size_t n = strlen(s);
+  uint8_t *p;
+
+  write_head(w, CBOR_TSTR, n);
+  p = writer_reserve(w, n);
+  if (p) memcpy(p, s, n);
+}
+
+void cbor_write_array(CBOR_WRITER *w, uint32_t count) {
+  write_head(w, CBOR_ARRAY, count);
+}
+
+void cbor_write_map(CBOR_WRITER *w, uint32_t pairs) {
+  write_head(w, CBOR_MAP, pairs);
+}
+
+uint8_t *cbor_write_bstr_reserve(CBOR_WRITER *w, size_t len) {
+  write_head(w, CBOR_BSTR, len);
+  return writer_reserve(w, len);
+}
@@ -0,0 +1,306 @@
+// Copyright 2021 Google LLC
+//
+// Licensed under the Apache License, Version 2.0 (the "License");
+// you may not use this file except in compliance with the License.
+// You may obtain a copy of the License at
+//
+//     https://www.apache.org/licenses/LICENSE-2.0
+//
+// Unless required by applicable law or agreed to in writing, software
+// distributed under the License is distributed on an "AS IS" BASIS,
+// WITHOUT WARRANTIES OR CONDITIONS OF ANY KIND, either express or implied.
+// See the License for the specific language governing permissions and
+// limitations under the License.
+
+/*
+ * CTAP2 command layer. Sits above u2f_transport.c next to the APDU
+ * message layer in u2f.c: the transport hands us the reassembled
+ * payload of a U2FHID_CBOR message and we hand back the response
+ * bytes. Everything is zero-copy end to end -- requests are walked in
+ * place through borrowed slices and responses are serialized straight
+ * into the transport's tx_buffer (see cbor.h).
+ *
+ * This is the message plumbing: getInfo is served for real so hosts
+ * can negotiate, and makeCredential/getAssertion fully validate their
+ * parameter maps before declining. Credential minting rides on the
+ * FIDO2 key schedule, which lands separately.
+ */
+
+#include <string.h>
+
+#include "cbor.h"
+#include "ctap2.h"
+#include "sha256.h"
+#include "u2f_hid_corp.h" /* MAX_BCNT */
+
+#include "fmt.h"
+
+/* Identifies this authenticator model in makeCredential attestation
+ * data and getInfo. All zeros until the fleet assigns one. */
+static const uint8_t ctap2_aaguid[16] = {0};
+
+/*
+ * authenticatorGetInfo: no request parameters; the response map keys
+ * are emitted in canonical (ascending) order.
+ */
+static uint8_t ctap2_get_info(CBOR_WRITER *w) {
+  cbor_write_map(w, 4);
+
+  /* 1: versions */
+  cbor_write_uint(w, 1);
+  cbor_write_array(w, 2);
+  cbor_write_tstr(w, "U2F_V2");
+  cbor_write_tstr(w, "FIDO_2_0");
+
+  /* 3: aaguid */
+  cbor_write_uint(w, 3);
+  cbor_write_bstr(w, ctap2_aaguid, sizeof(ctap2_aaguid));
+
+  /* 4: options. Keys in canonical order (length, then bytewise). No
+   * resident keys (all key material is derived, nothing is stored)
+   * and no PIN; user presence is the touch sensor. */
+  cbor_write_uint(w, 4);
+  cbor_write_map(w, 2);
+  cbor_write_tstr(w, "rk");
+  cbor_write_bool(w, 0);
+  cbor_write_tstr(w, "up");
+  cbor_write_bool(w, 1);
+
+  /* 5: maxMsgSize, what the HID transport can reassemble */
+  cbor_write_uint(w, 5);
+  cbor_write_uint(w, MAX_BCNT);
+
+  return CTAP2_OK;
+}
+
+/* Reads the top-level parameter map head. CTAP2 requires it even when
+ * empty. */
+static uint8_t ctap2_open_map(CBOR_READER *r, uint32_t *pairs) {
+  CBOR_ITEM item;
+
+  if (cbor_read(r, &item)) return CTAP2_ERR_INVALID_CBOR;
+  if (item.type != CBOR_MAP) return CTAP2_ERR_CBOR_UNEXPECTED_TYPE;
+  *pairs = item.value;
+  return CTAP2_OK;
+}
+
+/*
+ * authenticatorMakeCredential request map:
+ *   1: clientDataHash (bstr)      2: rp (map, "id": tstr)
+ *   3: user (map, "id": bstr)     4: pubKeyCredParams (array of maps)
+ * Unknown keys are skipped, per spec. All slices borrow from the
+ * request buffer; nothing is copied out.
+ */
+static uint8_t ctap2_make_credential(CBOR_READER *r) {
+  CBOR_ITEM key, item;
+  const uint8_t *client_data_hash = NULL;
+  const uint8_t *rp_id = NULL;
+  uint32_t rp_id_len = 0;
+  const uint8_t *user_id = NULL;
+  uint32_t pairs, sub, i;
+  int have_es256 = 0, have_params = 0;
+  uint8_t rc;
+
+  rc = ctap2_open_map(r, &pairs);
+  if (rc != CTAP2_OK) return rc;
+
+  while (pairs--) {
+    if (cbor_read(r, &key)) return CTAP2_ERR_INVALID_CBOR;
+    if (key.type != CBOR_UINT) return CTAP2_ERR_CBOR_UNEXPECTED_TYPE;
+
+    switch (key.value) {
+    case 1: /* clientDataHash */
+      if (cbor_read(r, &item)) return CTAP2_ERR_INVALID_CBOR;
+      if (item.type != CBOR_BSTR || item.value != SHA256_DIGEST_SIZE)
+        return CTAP2_ERR_CBOR_UNEXPECTED_TYPE;
+      client_data_hash = item.slice;
+      break;
+
+    case 2: /* rp */
+      if (cbor_read(r, &item)) return CTAP2_ERR_INVALID_CBOR;
+      if (item.type != CBOR_MAP) return CTAP2_ERR_CBOR_UNEXPECTED_TYPE;
+      for (sub = item.value; sub--;) {
+        if (cbor_read(r, &key)) return CTAP2_ERR_INVALID_CBOR;
+        if (cbor_tstr_eq(&key, "id")) {
+          if (cbor_read(r, &item)) return CTAP2_ERR_INVALID_CBOR;
+          if (item.type != CBOR_TSTR) return CTAP2_ERR_CBOR_UNEXPECTED_TYPE;
+          rp_id = item.slice;
+          rp_id_len = item.value;
+        } else if (cbor_skip(r)) {
+          return CTAP2_ERR_INVALID_CBOR;
+        }
+      }
+      break;
+
+    case 3: /* user */
+      if (cbor_read(r, &item)) return CTAP2_ERR_INVALID_CBOR;
+      if (item.type != CBOR_MAP) return CTAP2_ERR_CBOR_UNEXPECTED_TYPE;
+      for (sub = item.value; sub--;) {
+        if (cbor_read(r, &key)) return CTAP2_ERR_INVALID_CBOR;
+        if (cbor_tstr_eq(&key, "id")) {
+          if (cbor_read(r, &item)) return CTAP2_ERR_INVALID_CBOR;
+          if (item.type != CBOR_BSTR || item.value > 64)
+            return CTAP2_ERR_CBOR_UNEXPECTED_TYPE;
+          user_id = item.slice;
+        } else if (cbor_skip(r)) {
+          return CTAP2_ERR_INVALID_CBOR;
+        }
+      }
+      break;
+
+    case 4: /* pubKeyCredParams */
+      if (cbor_read(r, &item)) return CTAP2_ERR_INVALID_CBOR;
+      if (item.type != CBOR_ARRAY) return CTAP2_ERR_CBOR_UNEXPECTED_TYPE;
+      have_params = 1;
+      for (i = item.value; i--;) {
+        if (cbor_read(r, &item)) return CTAP2_ERR_INVALID_CBOR;
+        if (item.type != CBOR_MAP) return CTAP2_ERR_CBOR_UNEXPECTED_TYPE;
+        for (sub = item.value; sub--;) {
+          if (cbor_read(r, &key)) return CTAP2_ERR_INVALID_CBOR;
+          if (cbor_tstr_eq(&key, "alg")) {
+            if (cbor_read(r, &item)) return CTAP2_ERR_INVALID_CBOR;
+            /* ES256 is -7: a negative int encoding n = 6 */
+            if (item.type == CBOR_NINT &&
+                item.value == (uint32_t)(-(COSE_ALG_ES256)-1))
+              have_es256 = 1;
+          } else if (cbor_skip(r)) {
+            return CTAP2_ERR_INVALID_CBOR;
+          }
+        }
+      }
+      break;
+
+    default: /* excludeList, extensions, options, ... */
+      if (cbor_skip(r)) return CTAP2_ERR_INVALID_CBOR;
+      break;
+    }
+  }
+
+  if (!client_data_hash || !rp_id || !user_id || !have_params)
+    return CTAP2_ERR_MISSING_PARAMETER;
+  if (!have_es256) return CTAP2_ERR_UNSUPPORTED_ALGORITHM;
+
+  h1_printf("CTAP2 makeCredential rpId %lu bytes\n", rp_id_len);
+
+  /* Parameters are good; minting waits on the FIDO2 key schedule. */
+  return CTAP2_ERR_OPERATION_DENIED;
+}
+
+/*
+ * authenticatorGetAssertion request map:
+ *   1: rpId (tstr)   2: clientDataHash (bstr)
+ *   3: allowList (array of credential descriptors, "id": bstr)
+ */
+static uint8_t ctap2_get_assertion(CBOR_READER *r) {
+  CBOR_ITEM key, item;
+  const uint8_t *client_data_hash = NULL;
+  const uint8_t *rp_id = NULL;
+  uint32_t pairs, sub, i;
+  uint32_t allow_entries = 0;
+  uint8_t rc;
+
+  rc = ctap2_open_map(r, &pairs);
+  if (rc != CTAP2_OK) return rc;
+
+  while (pairs--) {
+    if (cbor_read(r, &key)) return CTAP2_ERR_INVALID_CBOR;
+    if (key.type != CBOR_UINT) return CTAP2_ERR_CBOR_UNEXPECTED_TYPE;
+
+    switch (key.value) {
+    case 1: /* rpId */
+      if (cbor_read(r, &item)) return CTAP2_ERR_INVALID_CBOR;
+      if (item.type != CBOR_TSTR) return CTAP2_ERR_CBOR_UNEXPECTED_TYPE;
+      rp_id = item.slice;
+      break;
+
+    case 2: /* clientDataHash */
+      if (cbor_read(r, &item)) return CTAP2_ERR_INVALID_CBOR;
+      if (item.type != CBOR_BSTR || item.value != SHA256_DIGEST_SIZE)
+        return CTAP2_ERR_CBOR_UNEXPECTED_TYPE;
+      client_data_hash = item.slice;
+      break;
+
+    case 3: /* allowList */
+      if (cbor_read(r, &item)) return CTAP2_ERR_INVALID_CBOR;
+      if (item.type != CBOR_ARRAY) return CTAP2_ERR_CBOR_UNEXPECTED_TYPE;
+      for (i = item.value; i--;) {
+        if (cbor_read(r, &item)) return CTAP2_ERR_INVALID_CBOR;
+        if (item.type != CBOR_MAP) return CTAP2_ERR_CBOR_UNEXPECTED_TYPE;
+        for (sub = item.value; sub--;) {
+          if (cbor_read(r, &key)) return CTAP2_ERR_INVALID_CBOR;
+          if (cbor_tstr_eq(&key, "id")) {
+            if (cbor_read(r, &item)) return CTAP2_ERR_INVALID_CBOR;
+            if (item.type != CBOR_BSTR) return CTAP2_ERR_CBOR_UNEXPECTED_TYPE;
+            allow_entries++;
+          } else if (cbor_skip(r)) {
+            return CTAP2_ERR_INVALID_CBOR;
+          }
+        }
+      }
+      break;
+
+    default: /* extensions, options, ... */
+      if (cbor_skip(r)) return CTAP2_ERR_INVALID_CBOR;
+      break;
+    }
+  }
+
+  if (!rp_id || !client_data_hash) return CTAP2_ERR_MISSING_PARAMETER;
+
+  h1_printf("CTAP2 getAssertion, allowList %lu entries\n", allow_entries);
+
+  /* No resident keys, and no FIDO2-minted handles to match against
+   * yet (see ctap2_make_credential). */
+  return CTAP2_ERR_NO_CREDENTIALS;
+}
+
+uint16_t ctap2_rcv(const uint8_t *ibuf, uint16_t in_len, uint8_t *obuf,
+                   uint16_t max_len) {
+  CBOR_READER reader;
+  CBOR_WRITER writer;
+  uint8_t status;
+
+  if (in_len < 1 || max_len < 1) {
+    if (max_len >= 1) obuf[0] = CTAP1_ERR_INVALID_LENGTH;
+    return max_len >= 1;
+  }
+
+  cbor_reader_init(&reader, ibuf + 1, in_len - 1);
+  cbor_writer_init(&writer, obuf + 1, max_len - 1);
+
+  switch (ibuf[0]) {
+  case CTAP_CMD_MAKE_CREDENTIAL:
+    status = ctap2_make_credential(&reader);
+    break;
+
+  case CTAP_CMD_GET_ASSERTION:
+    status = ctap2_get_assertion(&reader);
+    break;
+
+  case CTAP_CMD_GET_INFO:
+    status = ctap2_get_info(&writer);
+    break;
+
+  case CTAP_CMD_CLIENT_PIN:
+    /* getInfo does not advertise clientPin */
+    status = CTAP1_ERR_INVALID_COMMAND;
+    break;
+
+  case CTAP_CMD_RESET:
+    /* Key material is derived from device secrets, not stored; there
+     * is nothing a reset could wipe. */
+    status = CTAP2_ERR_OPERATION_DENIED;
+    break;
+
+  default:
+    status = CTAP1_ERR_INVALID_COMMAND;
+    break;
+  }
+
+  /* A truncated response must not go out; report the overflow. */
+  if (status == CTAP2_OK && !cbor_writer_ok(&writer)) status = CTAP1_ERR_OTHER;
+
+  obuf[0] = status;
+  if (status != CTAP2_OK) return 1;
+  return (uint16_t)(1 + cbor_writer_len(&writer));
+}
@@ -0,0 +1,107 @@
+// Copyright 2021 Google LLC
+//
+// Licensed under the Apache License, Version 2.0 (the "License");
+// you may not use this file except in compliance with the License.
+// You may obtain a copy of the License at
+//
+//     https://www.apache.org/licenses/LICENSE-2.0
+//
+// Unless required by applicable law or agreed to in writing, software
+// distributed under the License is distributed on an "AS IS" BASIS,
+// WITHOUT WARRANTIES OR CONDITIONS OF ANY KIND, either express or implied.
+// See the License for the specific language governing permissions and
+// limitations under the License.
+
+#ifndef __CBOR_H__
+#define __CBOR_H__
+
+#include <stddef.h>
+#include <stdint.h>
+
+/*
+ * Zero-copy CBOR codec for the CTAP2 message layer.
+ *
+ * The reader walks a message in place: string and byte-string items
+ * come back as borrowed slices into the caller's buffer, so a request
+ * is never duplicated into an intermediate tree. The writer appends
+ * directly into the response buffer (the transport's tx_buffer), so
+ * handlers serialize incrementally instead of staging a copy.
+ *
+ * Only the canonical (definite-length) subset that CTAP2 mandates is
+ * accepted; indefinite-length items are rejected as malformed.
+ */
+
+/* CBOR major types */
+#define CBOR_UINT 0
+#define CBOR_NINT 1 /* value field holds n, the item encodes -(n + 1) */
+#define CBOR_BSTR 2
+#define CBOR_TSTR 3
+#define CBOR_ARRAY 4
+#define CBOR_MAP 5 /* value field is the pair count */
+#define CBOR_TAG 6
+#define CBOR_SIMPLE 7 /* false/true/null and friends */
+
+/* CBOR_SIMPLE values of interest */
+#define CBOR_FALSE 20
+#define CBOR_TRUE 21
+
+typedef struct {
+  const uint8_t *p;   /* next unread byte */
+  const uint8_t *end; /* one past the message */
+} CBOR_READER;
+
+/* One decoded item head. For BSTR/TSTR, slice borrows the payload out
+ * of the reader's buffer and value is its byte length; the slice is
+ * only valid while the underlying buffer is. For ARRAY/MAP, value is
+ * the element/pair count and the children follow in the stream. */
+typedef struct {
+  uint8_t type;         /* CBOR_* major type */
+  uint32_t value;       /* argument: int value, length or count */
+  const uint8_t *slice; /* BSTR/TSTR payload, NULL otherwise */
+} CBOR_ITEM;
+
+void cbor_reader_init(CBOR_READER *r, const uint8_t *buf, size_t len);
+
+/* Decodes the next item head (and, for strings, its payload) in
+ * place. Returns 0 on success, nonzero on truncated or non-canonical
+ * input. Arguments wider than 32 bits are rejected; nothing in a CTAP
+ * message needs them and it keeps the item struct small. */
+int cbor_read(CBOR_READER *r, CBOR_ITEM *item);
+
+/* Skips the next item including any nested children (bounded nesting
+ * depth; see CBOR_MAX_DEPTH in cbor.c). Handlers use this to step
+ * over map keys they do not understand. Returns 0 on success. */
+int cbor_skip(CBOR_READER *r);
+
+/* True if item is a text string matching the literal s. */
+int cbor_tstr_eq(const CBOR_ITEM *item, const char *s);
+
+typedef struct {
+  uint8_t *start;
+  uint8_t *p;
+  uint8_t *end;
+  int overflow; /* sticky; set once a write no longer fits */
+} CBOR_WRITER;
+
+void cbor_writer_init(CBOR_WRITER *w, uint8_t *buf, size_t len);
+
+/* Bytes emitted so far. Meaningless once overflow is set; check
+ * cbor_writer_ok() once at the end instead of after every write. */
+size_t cbor_writer_len(const CBOR_WRITER *w);
+int cbor_writer_ok(const CBOR_WRITER *w);
+
+void cbor_write_uint(CBOR_WRITER *w, uint32_t v);
+void cbor_write_nint(CBOR_WRITER *w, uint32_t n); /* encodes -(n + 1) */
+void cbor_write_bool(CBOR_WRITER *w, int b);
+void cbor_write_bstr(CBOR_WRITER *w, const uint8_t *data, size_t len);
+void cbor_write_tstr(CBOR_WRITER *w, const char *s);
+void cbor_write_array(CBOR_WRITER *w, uint32_t count); /* children follow */
+void cbor_write_map(CBOR_WRITER *w, uint32_t pairs);   /* pairs follow */
+
+/* Emits a byte-string head for len bytes and returns a pointer to the
+ * reserved payload region, or NULL on overflow. Producers (hashes,
+ * signatures, public keys) write straight into the response buffer
+ * through this instead of staging the payload elsewhere. */
+uint8_t *cbor_write_bstr_reserve(CBOR_WRITER *w, size_t len);
+
+#endif  // __CBOR_H__
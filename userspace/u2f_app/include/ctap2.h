@@ -0,0 +1,60 @@
+// Copyright 2021 Google LLC
+//
+// Licensed under the Apache License, Version 2.0 (the "License");
+// you may not use this file except in compliance with the License.
+// You may obtain a copy of the License at
+//
+//     https://www.apache.org/licenses/LICENSE-2.0
+//
+// Unless required by applicable law or agreed to in writing, software
+// distributed under the License is distributed on an "AS IS" BASIS,
+// WITHOUT WARRANTIES OR CONDITIONS OF ANY KIND, either express or implied.
+// See the License for the specific language governing permissions and
+// limitations under the License.
+
+#ifndef __CTAP2_H__
+#define __CTAP2_H__
+
+#include <stdint.h>
+
+/*
+ * CTAP2 message layer, carried over the HID transport by U2FHID_CBOR
+ * frames the same way U2FHID_MSG carries APDUs. Requests are parsed in
+ * place with borrowed slices (see cbor.h) and responses are written
+ * incrementally into the transport's tx_buffer.
+ */
+
+/* Authenticator command bytes (CTAP 2.0 section 6) */
+#define CTAP_CMD_MAKE_CREDENTIAL 0x01
+#define CTAP_CMD_GET_ASSERTION 0x02
+#define CTAP_CMD_GET_INFO 0x04
+#define CTAP_CMD_CLIENT_PIN 0x06
+#define CTAP_CMD_RESET 0x07
+#define CTAP_CMD_GET_NEXT_ASSERTION 0x08
+
+/* Status bytes (CTAP 2.0 section 6.3) */
+#define CTAP2_OK 0x00
+#define CTAP1_ERR_INVALID_COMMAND 0x01
+#define CTAP1_ERR_INVALID_PARAMETER 0x02
+#define CTAP1_ERR_INVALID_LENGTH 0x03
+#define CTAP2_ERR_CBOR_UNEXPECTED_TYPE 0x11
+#define CTAP2_ERR_INVALID_CBOR 0x12
+#define CTAP2_ERR_MISSING_PARAMETER 0x14
+#define CTAP2_ERR_UNSUPPORTED_ALGORITHM 0x26
+#define CTAP2_ERR_OPERATION_DENIED 0x27
+#define CTAP2_ERR_NO_CREDENTIALS 0x2e
+#define CTAP1_ERR_OTHER 0x7f
+
+/* COSE algorithm identifier for ECDSA w/ SHA-256 */
+#define COSE_ALG_ES256 (-7)
+
+/*
+ * Handles one CTAP2 request: ibuf[0] is the command byte, the rest is
+ * the CBOR-encoded parameter map (borrowed for the duration of the
+ * call). Writes the status byte and any CBOR response into obuf and
+ * returns the response byte count (always >= 1).
+ */
+uint16_t ctap2_rcv(const uint8_t *ibuf, uint16_t in_len, uint8_t *obuf,
+                   uint16_t max_len);
+
+#endif  // __CTAP2_H__
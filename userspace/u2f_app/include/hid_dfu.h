@@ -15,6 +15,11 @@
 #ifndef __HID_DFU_H__
 #define __HID_DFU_H__
 
+// The DFU handler itself is not part of this tree: nothing here
+// defines CONFIG_HID_DFU, so the U2FHID_DFU dispatch case in
+// u2f_transport.c compiles out and this header only fixes the
+// interface and error codes an out-of-tree implementation must use.
+
 enum dfu_err {
   DFU_SUCCESS = 0,
   DFU_WRONG_STATE = 1,           // uninitialized?
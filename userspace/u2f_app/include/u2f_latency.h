@@ -0,0 +1,94 @@
+// Copyright 2021 Google LLC
+//
+// Licensed under the Apache License, Version 2.0 (the "License");
+// you may not use this file except in compliance with the License.
+// You may obtain a copy of the License at
+//
+//     https://www.apache.org/licenses/LICENSE-2.0
+//
+// Unless required by applicable law or agreed to in writing, software
+// distributed under the License is distributed on an "AS IS" BASIS,
+// WITHOUT WARRANTIES OR CONDITIONS OF ANY KIND, either express or implied.
+// See the License for the specific language governing permissions and
+// limitations under the License.
+
+#ifndef __U2F_LATENCY_H__
+#define __U2F_LATENCY_H__
+
+#include <stdint.h>
+
+/* On-device latency accounting for U2F transactions.
+ *
+ * The transport records four timestamps per message: arrival of the
+ * first frame, start and end of command processing ("crypto"), and the
+ * moment the last response frame has been handed to the USB driver.
+ * Samples accumulate into per-command histograms that a host can fetch
+ * with the vendor U2FHID_LATENCY command, so device time can be
+ * measured without the noise of the host's USB stack.
+ */
+
+/* Commands tracked separately; everything else lands in OTHER. */
+enum u2f_lat_class {
+  U2F_LAT_REGISTER = 0,
+  U2F_LAT_AUTHENTICATE,
+  U2F_LAT_VERSION,
+  U2F_LAT_OTHER,
+  U2F_LAT_CLASSES
+};
+
+/* Log2 buckets of total first-frame..last-TX time. Bucket i counts
+ * samples below (64 << i) microseconds; the last bucket is open. */
+#define U2F_LAT_BUCKETS 12
+#define U2F_LAT_BUCKET0_US 64
+
+/* One class's accumulated stats, serialized as-is (little-endian) in
+ * the U2FHID_LATENCY response, U2F_LAT_CLASSES structs back to back. */
+typedef struct {
+  uint32_t count;
+  uint32_t total_us;  /* sum of first-frame..last-TX */
+  uint32_t crypto_us; /* sum of crypto start..end */
+  uint32_t max_us;
+  uint32_t bucket[U2F_LAT_BUCKETS];
+} u2f_lat_stats;
+
+/* First frame of a message arrived on cid. */
+void u2f_lat_first_frame(uint32_t cid);
+
+/* Brackets the command handler inside u2fhid_response_msg. */
+void u2f_lat_crypto_start(void);
+void u2f_lat_crypto_end(void);
+
+/* Last response frame sent; folds the sample for cid into the
+ * histogram for ins (a U2F_INS_* value, or 0xff for non-MSG traffic). */
+void u2f_lat_msg_done(uint32_t cid, uint8_t ins);
+
+/* The message on cid died (error, cancelled transaction); discard its
+ * pending first-frame timestamp. */
+void u2f_lat_drop(uint32_t cid);
+
+/* Error paths counted separately, one per U2FHID_ERROR code the
+ * transport can emit (codes it never sends land in OTHER). Serialized
+ * after the histograms in the U2FHID_LATENCY payload as uint32_t
+ * counts, in this order. A healthy host population sends none of
+ * these; a nonzero rate is a host retrying, i.e. latency the
+ * histograms above never see. */
+enum u2f_lat_err_path {
+  U2F_LAT_ERR_INVALID_CMD = 0,
+  U2F_LAT_ERR_INVALID_LEN,
+  U2F_LAT_ERR_INVALID_SEQ,
+  U2F_LAT_ERR_MSG_TIMEOUT,
+  U2F_LAT_ERR_CHANNEL_BUSY,
+  U2F_LAT_ERR_INVALID_CID,
+  U2F_LAT_ERR_OTHER,
+  U2F_LAT_ERR_PATHS
+};
+
+/* A U2FHID_ERROR frame with this code was sent. */
+void u2f_lat_err(uint8_t errno);
+
+/* Serializes the histograms and error counters into buf; returns the
+ * number of bytes written, or 0 if max is too small. With reset set,
+ * the accumulated stats are cleared after they are copied out. */
+uint16_t u2f_lat_report(uint8_t *buf, uint16_t max, int reset);
+
+#endif  // __U2F_LATENCY_H__
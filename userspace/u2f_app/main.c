@@ -25,7 +25,7 @@
 //   - CONSOLE (for printing out messages)
 //   - RNG (for entropy generation)
 
-#include <stdio.h>
+#include "fmt.h"
 #include <string.h>
 #include <timer.h>
 #include <rng.h>
@@ -34,8 +34,14 @@
 
 #include "fips.h"
 #include "kl.h"
+#include "personality_syscalls.h"
+#include "stack_watermark.h"
 #include "storage.h"
+#include "trace.h"
+#include "trng.h"
 #include "u2f_syscalls.h"
+#include "warmup.h"
+#include "u2f_corp.h"
 #include "u2f_hid.h"
 #include "x509.h"
 
@@ -45,11 +51,30 @@ static void setup_personality(void);
 
 int check_personality(const perso_st* id) {
   uint32_t chksum[8];
+  LITE_SHA256_CTX ctx;  // SHA256 output container
   uint32_t err = 0;
   size_t i;
   if (id == NULL) {
     return EC_ERROR_UNKNOWN;
   }
+  /* The ladder checksum below only binds cert_hash to this chip; also
+   * check that the stored cert still hashes to cert_hash. Validating
+   * once here lets individual_cert() serve the stored cert on every
+   * U2F REGISTER without reinspecting it, and a stale or corrupt cert
+   * gets regenerated instead of shipped. */
+  if (id->cert_len == 0 || id->cert_len > sizeof(id->cert)) {
+    return EC_ERROR_UNKNOWN;
+  }
+  /* The kernel hashes the stored cert once at boot and latches the
+   * verdict; only redo the 2KB pass when the latch is cold (e.g. right
+   * after a personality write). */
+  if (!tock_personality_cert_valid()) {
+    SHA256_INIT(&ctx);
+    SHA256_UPDATE(&ctx, id->cert, id->cert_len);
+    if (memcmp(SHA256_FINAL(&ctx), id->cert_hash, SHA256_DIGEST_SIZE) != 0) {
+      return EC_ERROR_UNKNOWN;
+    }
+  }
   err = kl_derive_attest(id->cert_hash, chksum);
   for (i = 0; i < 8; ++i) {
     err |= (chksum[i] ^ id->chksum[i]);
@@ -59,7 +84,6 @@ int check_personality(const perso_st* id) {
 
 int new_personality(perso_st* id) {
    p256_int priv;
-  LITE_SHA256_CTX ctx;  // SHA256 output container
   int err = 0;
 
   if (id == NULL) {
@@ -71,16 +95,15 @@ int new_personality(perso_st* id) {
   err |= kl_random(id->salt);
 
   err |= individual_keypair(&priv, &id->pub_x, &id->pub_y, id->salt);
+  // generate_cert() hashes into cert_hash during its copy-out, so no
+  // second pass over the cert is needed here.
   id->cert_len = generate_cert(&priv, &id->pub_x, &id->pub_y, 1, id->cert,
-                               sizeof(id->cert));
-  SHA256_INIT(&ctx);
-  SHA256_UPDATE(&ctx, id->cert, id->cert_len);
-  memcpy(id->cert_hash, SHA256_FINAL(&ctx), SHA256_DIGEST_SIZE);
+                               sizeof(id->cert), id->cert_hash);
 
   err |= kl_derive_attest(id->cert_hash, id->chksum);
-  //printf("Setting personality\n");
+  //h1_printf("Setting personality\n");
   //set_personality(id);
-  //printf("Personality set\n");
+  //h1_printf("Personality set\n");
 
   return err == 0 ? EC_SUCCESS : EC_ERROR_UNKNOWN;
 }
@@ -88,54 +111,146 @@ int new_personality(perso_st* id) {
 static void setup_personality(void) {
   perso_st* person = get_personality();
   if (check_personality(person) == EC_SUCCESS) return;
-  printf("Personality not found: generating and storing.\n");
+  h1_printf("Personality not found: generating and storing.\n");
   if (new_personality(person) == EC_SUCCESS) set_personality(person);
 }
 
 
 static void check_device_setup(void) {
-  printf("Setting up device entropy.\n");
+  h1_printf("Setting up device entropy.\n");
   ensure_factory_entropy();
-  printf("Setting up device personality.\n");
+  h1_printf("Setting up device personality.\n");
   setup_personality();
-  printf("Setup complete.\n");
+  h1_printf("Setup complete.\n");
 }
 
 void u2fhid_process_frame(U2FHID_FRAME *f_p);
 
 void process_frame(U2FHID_FRAME* frame) {
-  //printf("U2F APP: processing frame\n");
+  //h1_printf("U2F APP: processing frame\n");
   u2fhid_process_frame(frame);
-  //printf("U2F APP: completed processing frame\n");
+  //h1_printf("U2F APP: completed processing frame\n");
+}
+
+// Receive ring shared with the kernel. Frames are parsed where the
+// kernel wrote them; a slot is not reused until the ring wraps, so the
+// ring only needs to cover frames that can arrive while one frame is
+// being handled.
+#define U2F_RX_RING_FRAMES 8
+static uint8_t u2f_rx_ring[U2F_RX_RING_FRAMES * U2F_FRAME_SIZE];
+
+// Prioritized main-loop dispatcher. Sources are polled in table order
+// and one handler runs per pass, re-scanning from the top afterwards,
+// so a frame waiting in the receive ring (continuation frames of a
+// message in reassembly above all) is never made to queue behind
+// housekeeping. Crypto completions need no entry of their own: command
+// handlers wait for them inline (yield_for), so under load a pending
+// completion always finishes before the next frame is admitted. The
+// table is static; nothing allocates.
+#define ARRAY_SIZE(x) (sizeof(x) / sizeof((x)[0]))
+
+typedef struct {
+  int (*pending)(void);  // nonzero if the source has work
+  void (*service)(void); // handle one unit of work
+} EVENT_SOURCE;
+
+static int u2f_rx_pending(void) {
+  return tock_u2f_frames_pending() != 0;
+}
+
+static void u2f_rx_service(void) {
+  void* frame = NULL;
+  int ret = tock_u2f_receive_frame(&frame); // no wait: a frame is pending
+
+  if (ret != 0) {
+    TRACE_ERR(TRACE_U2F_RX_ERR, ret, 0);
+    return;
+  }
+  process_frame((U2FHID_FRAME*)frame);
 }
 
-char u2f_buffer[U2F_FRAME_SIZE];
+// Lowest priority: runs only when no frame is waiting. Tops up the
+// entropy pool so signing never waits on the TRNG, runs one unit of
+// precompute (key derivations, store mounts, DRBG reseeds -- the lazy
+// costs the first transaction after an idle period would otherwise
+// pay), drains the trace ring, then sleeps until a callback delivers
+// more work. While precompute reports work remaining the loop re-scans
+// instead of sleeping, so a frame arriving mid-warmup waits behind at
+// most one stage.
+static int idle_pending(void) {
+  return 1;
+}
+
+static void idle_service(void) {
+  static int sram_reported;
+
+  fips_trng_top_up();
+  if (u2f_idle_precompute()) return;
+  if (!sram_reported) {
+    /* One watermark line once warm-up settles; tock_stack_headroom()
+     * stays callable for later spot checks. */
+    sram_reported = 1;
+    h1_printf("SRAM_WATERMARK stack_headroom=%lu grant_bytes=%lu\n",
+              tock_stack_headroom(), tock_grant_bytes());
+  }
+  trace_flush();
+  if (!u2f_rx_pending()) yield();
+}
+
+static const EVENT_SOURCE event_sources[] = {
+    {u2f_rx_pending, u2f_rx_service},
+    {idle_pending, idle_service},
+};
 
 int main(void) {
   int ret = 0;
-  printf("= Booting U2F application =\n");
+
+  /* Paint the unused stack first, before any deep call path runs. */
+  tock_stack_paint();
+
+  h1_printf("= Booting U2F application =\n");
+
+  // Allocate grant state for every driver up front, so an under-sized
+  // grant region fails at boot rather than mid-authentication.
+  if (tock_warmup() != TOCK_SUCCESS) {
+    h1_printf("U2F APP: driver warmup could not allocate grant state.\n");
+  }
+
   init_fips();
 
   if (kl_init()) {
-    printf("kl_init() FAIL\n");
+    h1_printf("kl_init() FAIL\n");
   }
 
   tock_pop_enable_detection();
 
-  printf("= Configuring device state and identity = \n");
+  h1_printf("= Configuring device state and identity = \n");
   check_device_setup();
   u2f_init();
-  printf("= Running U2F application =\n");
+  h1_printf("= Running U2F application =\n");
+
+  ret = tock_u2f_receive_ring_setup(u2f_rx_ring, sizeof(u2f_rx_ring));
+  if (ret != 0) {
+    h1_printf("U2F APP: error %i setting up receive ring.\n", ret);
+    return ret;
+  }
+
+  // Batch continuation frames of large messages: one wakeup per half
+  // ring rather than one per 64-byte frame. Message-final frames are
+  // still delivered immediately.
+  if (tock_u2f_receive_coalesce(U2F_RX_RING_FRAMES / 2) != TOCK_SUCCESS) {
+    h1_printf("U2F APP: kernel lacks receive coalescing; per-frame wakeups.\n");
+  }
 
   while (1) {
-    //printf("U2F APP: receiving frame into 0x%08x.\n", (unsigned int)u2f_buffer);
-    ret = tock_u2f_receive(u2f_buffer, U2F_FRAME_SIZE);
-    if (ret != 0) {
-      printf("U2F APP: error %i in receive, retry.\n", ret);
-      continue;
+    size_t i;
+
+    for (i = 0; i < ARRAY_SIZE(event_sources); i++) {
+      if (event_sources[i].pending()) {
+        event_sources[i].service();
+        break;
+      }
     }
-    U2FHID_FRAME* frame = (U2FHID_FRAME*)u2f_buffer;
-    process_frame(frame);
   }
   return ret;
 }
@@ -28,8 +28,12 @@
 #include "kl.h"
 #include "x509.h"
 
+#include "fmt.h"
+#include "sig_counter.h"
 #include "u2f_syscalls.h"
 
+#define ARRAY_SIZE(x) (sizeof(x) / sizeof((x)[0]))
+
 int pop_check_presence(int consume, int bpm);
 
 int pop_check_presence(int consume, int bpm) {
@@ -149,9 +153,12 @@ static int gen_scramblek(const uint8_t *origin __attribute((unused)),
   return EC_SUCCESS;
 }
 
-/* en/dis-entangle kh w/ the origin dependent scramble key. */
+/* en/dis-entangle kh w/ the origin dependent scramble key. len is
+ * KH_LEN for v1 handles (three CBC blocks plus the masked tail block)
+ * or KH_V2_LEN for compact v2 handles, whose tail is the fingerprint
+ * and is not ciphered here. */
 static int obfuscate_kh(const uint8_t *origin, const uint8_t *in, uint8_t *out,
-                        enum AES_encrypt_mode mode) {
+                        size_t len, enum AES_encrypt_mode mode) {
   uint8_t scramblek[SHA256_DIGEST_SIZE];
   uint8_t iv[AES_BLOCK_LEN] = {0};
   int i;
@@ -165,6 +172,8 @@ static int obfuscate_kh(const uint8_t *origin, const uint8_t *in, uint8_t *out,
   for (i = 0; i < 3; i++) {
     fips_aes_block(in + i * AES_BLOCK_LEN, out + i * AES_BLOCK_LEN);
   }
+  if (len < KH_LEN) return EC_SUCCESS;
+
   /* block[3] ^= sha256(block[0..2]) */
   SHA256(out, 3 * AES_BLOCK_LEN, scramblek);
   for (i = 0; i < AES_BLOCK_LEN; ++i) {
@@ -174,6 +183,131 @@ static int obfuscate_kh(const uint8_t *origin, const uint8_t *in, uint8_t *out,
   return EC_SUCCESS;
 }
 
+/*
+ * Key handle fingerprint pre-filter.
+ *
+ * Browsers send check-only AUTHENTICATE probes in bulk, one per
+ * registered key, and each probe used to pay the full unwrap (ladder
+ * derivation, DRBG, AES-CBC) just to learn the handle is foreign.
+ * Handles minted here carry a 16 byte keyed fingerprint in their last
+ * block: HMAC(fp key, appId || first three ciphertext blocks),
+ * truncated. One HMAC pass proves a handle is ours and bound to the
+ * presented appId, so check-only probes answer without unwrapping.
+ *
+ * The fingerprint takes the place of the random block that killed the
+ * covert channel; HMAC output under a device-secret key is equally
+ * opaque. Handles minted by older firmware (and G2F_ATTEST handles,
+ * whose last block encodes the fw version) fail the fingerprint and
+ * take the full unwrap path exactly as before.
+ */
+#define KH_FP_LEN AES_BLOCK_LEN
+/* Compact v2 handles keep only the first 8 fingerprint bytes; the
+ * filter is advisory (a miss just costs the full unwrap), so the
+ * truncation spends no security budget. */
+#define KH_V2_FP_LEN (KH_V2_LEN - 3 * AES_BLOCK_LEN)
+#define KH_FP_MSG_LEN (U2F_APPID_SIZE + 3 * AES_BLOCK_LEN)
+
+static uint32_t kh_fp_key[8];
+static int kh_fp_key_ready;
+
+static int kh_fingerprint(const uint8_t *appId, const uint8_t *wrapped,
+                          uint8_t fp[KH_FP_LEN]) {
+  uint32_t mac[SHA256_DIGEST_WORDS];
+  uint8_t msg[KH_FP_MSG_LEN];
+
+  if (!kh_fp_key_ready) {
+    if (kl_derive_khfp(get_personality()->salt, kh_fp_key))
+      return EC_ERROR_UNKNOWN;
+    kh_fp_key_ready = 1;
+  }
+
+  memcpy(msg, appId, U2F_APPID_SIZE);
+  memcpy(msg + U2F_APPID_SIZE, wrapped, 3 * AES_BLOCK_LEN);
+  if (!fips_hwHMAC256_oneshot(kh_fp_key, msg, sizeof(msg), mac)) {
+    fips_hwHMAC256_init(kh_fp_key);
+    fips_hwSHA256_update(msg, sizeof(msg));
+    fips_hwSHA256_final(mac);
+  }
+  memcpy(fp, mac, KH_FP_LEN);
+  return EC_SUCCESS;
+}
+
+/* Negative cache of recently rejected (appId, key handle) pairs, so a
+ * foreign handle presented again skips even the fingerprint HMAC.
+ * Entries are added only after a full unwrap has rejected the pair, so
+ * a hit cannot misclassify a valid handle. */
+#define KH_REJECT_ENTRIES 4
+static uint8_t kh_reject[KH_REJECT_ENTRIES][SHA256_DIGEST_SIZE];
+static uint8_t kh_reject_used[KH_REJECT_ENTRIES];
+static uint8_t kh_reject_next;
+
+static void kh_reject_tag(const U2F_AUTHENTICATE_REQ *req, size_t kh_len,
+                          uint8_t tag[SHA256_DIGEST_SIZE]) {
+  LITE_SHA256_CTX ctx;
+
+  SHA256_INIT(&ctx);
+  SHA256_UPDATE(&ctx, req->appId, U2F_APPID_SIZE);
+  SHA256_UPDATE(&ctx, req->keyHandle, kh_len);
+  memcpy(tag, SHA256_FINAL(&ctx), SHA256_DIGEST_SIZE);
+}
+
+/* Per-origin signature counter store. Mounted lazily (first
+ * authentication or first idle pass, whichever comes sooner). */
+static int sig_ctr_ready;
+
+static void sig_ctr_mount(void) {
+  if (!sig_ctr_ready && fips_kvstore_mount() == EC_SUCCESS &&
+      tock_sig_counter_init() == TOCK_SUCCESS)
+    sig_ctr_ready = 1;
+}
+
+/*
+ * Idle-cycle precompute. The main loop calls this when no frame is
+ * waiting; each call performs at most one unit of work so a frame
+ * arriving mid-warmup queues behind one stage, not all of them. The
+ * stages front-load exactly what the first transaction after an idle
+ * period would otherwise pay for lazily: the fingerprint HMAC key
+ * (ladder derivation), the signature counter store mount (flash scan),
+ * and TRNG reseeds of exhausted channel DRBGs. Returns nonzero if work
+ * was done, zero once everything is warm.
+ */
+int u2f_idle_precompute(void) {
+  static int warm_tried;
+
+  if (!warm_tried) {
+    /* One attempt per boot for the one-shot stages; the lazy paths in
+     * kh_fingerprint() and u2f_authenticate() still retry on demand if
+     * either fails here. */
+    warm_tried = 1;
+    if (!kh_fp_key_ready &&
+        kl_derive_khfp(get_personality()->salt, kh_fp_key) == EC_SUCCESS)
+      kh_fp_key_ready = 1;
+    sig_ctr_mount();
+    return 1;
+  }
+  return fips_drbg_precompute();
+}
+
+static int kh_reject_hit(const uint8_t tag[SHA256_DIGEST_SIZE]) {
+  int i;
+
+  for (i = 0; i < KH_REJECT_ENTRIES; i++) {
+    if (kh_reject_used[i] &&
+        equal_arrays(tag, kh_reject[i], SHA256_DIGEST_SIZE))
+      return 1;
+  }
+  return 0;
+}
+
+static void kh_reject_add(const uint8_t tag[SHA256_DIGEST_SIZE]) {
+  memcpy(kh_reject[kh_reject_next], tag, SHA256_DIGEST_SIZE);
+  kh_reject_used[kh_reject_next] = 1;
+  kh_reject_next = (kh_reject_next + 1) % KH_REJECT_ENTRIES;
+}
+
+/* The well-formed (Lc == 0) case is served from apdu_const_rsp before
+ * dispatch ever gets here; this handler remains for the malformed
+ * variants. */
 static uint16_t u2f_version(APDU apdu, uint8_t *obuf, uint16_t *obuf_len) {
   /*  "U2F_V2" */
   static const uint8_t version[] = {0x55, 0x32, 0x46, 0x5f, 0x56, 0x32};
@@ -199,6 +333,7 @@ static uint16_t u2f_register(APDU apdu, uint8_t *obuf, uint16_t *obuf_len) {
   /* KDF, Key handle */
   uint8_t kh[U2F_APPID_SIZE + sizeof(p256_int)];
   uint8_t buf[U2F_APPID_SIZE + sizeof(p256_int)];
+  size_t kh_len;
   /* sha256({RFU, app ID, nonce, keyhandle, public key}) */
   p256_int h;
   const uint8_t rfu = U2F_REGISTER_HASH_ID;
@@ -206,12 +341,12 @@ static uint16_t u2f_register(APDU apdu, uint8_t *obuf, uint16_t *obuf_len) {
   p256_int att_d;
   uint32_t cert_len;
   LITE_SHA256_CTX ctx;  // SHA256 output container
-  DRBG drbg_ctx;
+  DRBG *drbg;
 
-  //printf("REGISTER CMD\n");
+  //h1_printf("REGISTER CMD\n");
 
   if (apdu.len != sizeof(U2F_REGISTER_REQ)) {
-    printf(
+    h1_printf(
         "ERR: u2f_register "
         "length (%i should be %i), return 0x%x\n", apdu.len, sizeof(U2F_REGISTER_REQ), U2F_SW_WRONG_LENGTH);
     return U2F_SW_WRONG_LENGTH;
@@ -220,19 +355,19 @@ static uint16_t u2f_register(APDU apdu, uint8_t *obuf, uint16_t *obuf_len) {
   /* Check user presence, w/ optional consume */
   if (pop_check_presence(apdu.p1 & G2F_CONSUME, 250) != POP_TOUCH_YES &&
       (apdu.p1 & G2F_TUP) != 0) {
-    printf("ERR: u2f_register: did not satisfy conditions.\n");
+    h1_printf("ERR: u2f_register: did not satisfy conditions.\n");
     return U2F_SW_CONDITIONS_NOT_SATISFIED;
   }
 
   /* Check crypto state */
   if (fips_fatal != FIPS_INITIALIZED) {
-    printf("ERR: u2f_register: fips not initialized.\n");
+    h1_printf("ERR: u2f_register: fips not initialized.\n");
     return U2F_SW_WTF + 6;
   }
 
   /* Generate origin-specific keypair */
   if (origin_keypair(od_seed, &od, &opk_x, &opk_y) != EC_SUCCESS) {
-    printf("ERR: u2f_register: origin-specific keypair generation failed!");
+    h1_printf("ERR: u2f_register: origin-specific keypair generation failed!");
     return U2F_SW_WTF + 1;
   }
 
@@ -248,17 +383,38 @@ static uint16_t u2f_register(APDU apdu, uint8_t *obuf, uint16_t *obuf_len) {
     rand_bytes(buf + 48, 16);
   }
 
-  if (obfuscate_kh(req->appId, buf, kh, AES_ENCRYPT_MODE) != EC_SUCCESS) {
-    printf("ERR: u2f_register: could not obfuscate key handle.\n");
+  /* Compact v2 handles drop the filler tail block in favor of a short
+   * fingerprint; ATTEST handles keep the v1 layout since their tail
+   * carries the fw version. */
+  kh_len = KH_LEN;
+  if ((apdu.p1 & G2F_COMPACT_KH) && !(apdu.p1 & G2F_ATTEST))
+    kh_len = KH_V2_LEN;
+
+  if (obfuscate_kh(req->appId, buf, kh, KH_LEN, AES_ENCRYPT_MODE) !=
+      EC_SUCCESS) {
+    h1_printf("ERR: u2f_register: could not obfuscate key handle.\n");
     return U2F_SW_WTF + 2;
   }
 
+  if (!(apdu.p1 & G2F_ATTEST)) {
+    /* Stamp the pre-filter fingerprint over the random last block
+     * (truncated to the 8 byte tail for v2 handles). A failure here
+     * just leaves a full-size handle that authenticates via the full
+     * unwrap path. */
+    uint8_t fp[KH_FP_LEN];
+
+    if (kh_fingerprint(req->appId, kh, fp) == EC_SUCCESS)
+      memcpy(kh + 3 * AES_BLOCK_LEN, fp, kh_len - 3 * AES_BLOCK_LEN);
+    else
+      kh_len = KH_LEN;
+  }
+
   /* Response message hash for signing */
   SHA256_INIT(&ctx);
   SHA256_UPDATE(&ctx, &rfu, sizeof(rfu));
   SHA256_UPDATE(&ctx, req->appId, U2F_APPID_SIZE);
   SHA256_UPDATE(&ctx, req->nonce, U2F_NONCE_SIZE);
-  SHA256_UPDATE(&ctx, kh, sizeof(kh));
+  SHA256_UPDATE(&ctx, kh, kh_len);
   SHA256_UPDATE(&ctx, &pk_start, sizeof(pk_start));
 
   /* Insert origin-specific public keys into the response */
@@ -274,25 +430,25 @@ static uint16_t u2f_register(APDU apdu, uint8_t *obuf, uint16_t *obuf_len) {
   l = sizeof(resp->registerId);
   resp->pubKey.format = UNCOMPRESSED_POINT;
   l += sizeof(resp->pubKey);
-  resp->keyHandleLen = sizeof(kh);
+  resp->keyHandleLen = kh_len;
   l += sizeof(resp->keyHandleLen);
-  memcpy(resp->keyHandleCertSig, kh, sizeof(kh));
-  l += sizeof(kh);
-  m_off = sizeof(kh);
+  memcpy(resp->keyHandleCertSig, kh, kh_len);
+  l += kh_len;
+  m_off = kh_len;
 
   if (apdu.p1 & G2F_ATTEST) {
-    printf("Using keyladder-derived keypair for Individual attestation.\n");
+    h1_printf("Using keyladder-derived keypair for Individual attestation.\n");
     /* Use a keyladder-derived keypair for Individual attestation */
     if (individual_keypair(&att_d, NULL, NULL, NULL) != EC_SUCCESS) {
-      printf("ERR: Attestation key generation failed!");
+      h1_printf("ERR: Attestation key generation failed!");
       return U2F_SW_WTF + 3;
     }
-    printf("indiv attest\n");
+    h1_printf("indiv attest\n");
     cert_len =
         individual_cert(resp->keyHandleCertSig + m_off, MAX_CERT_SIZE);
   } else {
     /* Anon attestation keypair; use origin key to self-sign */
-    printf("anonymous attestion\n");
+    h1_printf("anonymous attestion\n");
     cert_len =
       anonymous_cert(&od, &opk_x, &opk_y, resp->keyHandleCertSig + m_off,
                        MAX_CERT_SIZE);
@@ -304,10 +460,10 @@ static uint16_t u2f_register(APDU apdu, uint8_t *obuf, uint16_t *obuf_len) {
   m_off += cert_len;
 
   /* Sign over the response w/ the attestation key */
-  make_drbg2(&drbg_ctx);
-  if (!ECDSA_SIGN(&drbg_ctx, &att_d, &h, &r, &s)) {
+  drbg = fips_channel_drbg();
+  if (!ECDSA_SIGN(drbg, &att_d, &h, &r, &s)) {
     PT_CLEAR(&att_d);
-    printf("ERR: signing error 1\n");
+    h1_printf("ERR: signing error 1\n");
     return U2F_SW_WTF + 5;
   }
   PT_CLEAR(&att_d);
@@ -315,7 +471,7 @@ static uint16_t u2f_register(APDU apdu, uint8_t *obuf, uint16_t *obuf_len) {
   /* Signature -> ASN.1 DER encoded bytes */
   l += asn1_sigp(resp->keyHandleCertSig + m_off, &r, &s);
 
-  //printf("cmd REGISTER completed\n");
+  //h1_printf("cmd REGISTER completed\n");
   *obuf_len = l;
 
   return U2F_SW_NO_ERROR; /* APDU success */
@@ -326,6 +482,8 @@ static uint16_t u2f_authenticate(APDU apdu, uint8_t *obuf, uint16_t *obuf_len) {
   U2F_AUTHENTICATE_RESP *resp = (U2F_AUTHENTICATE_RESP *)obuf;
   uint8_t kh[KH_LEN];
   uint8_t od_seed[SHA256_DIGEST_SIZE];
+  uint8_t fp[KH_FP_LEN];
+  uint8_t tag[SHA256_DIGEST_SIZE];
 
   p256_int origin_d;
   uint8_t origin[U2F_APPID_SIZE];
@@ -336,10 +494,19 @@ static uint16_t u2f_authenticate(APDU apdu, uint8_t *obuf, uint16_t *obuf_len) {
 
   uint32_t count = 0;
 
-  DRBG drbg_ctx;
-
-  if (apdu.len != U2F_APPID_SIZE + U2F_NONCE_SIZE + 1 + KH_LEN) {
-    printf(
+  DRBG *drbg;
+  size_t kh_len, fp_len;
+
+  /* Accept both keyhandle layouts: v1 (64 bytes, masked tail block)
+   * and compact v2 (56 bytes, truncated fingerprint tail). */
+  if (apdu.len == U2F_APPID_SIZE + U2F_NONCE_SIZE + 1 + KH_LEN) {
+    kh_len = KH_LEN;
+    fp_len = KH_FP_LEN;
+  } else if (apdu.len == U2F_APPID_SIZE + U2F_NONCE_SIZE + 1 + KH_V2_LEN) {
+    kh_len = KH_V2_LEN;
+    fp_len = KH_V2_FP_LEN;
+  } else {
+    h1_printf(
         "ERR: U2F AUTHENTICATE INS error wrong "
         "length\n");
     return U2F_SW_WRONG_LENGTH;
@@ -347,14 +514,31 @@ static uint16_t u2f_authenticate(APDU apdu, uint8_t *obuf, uint16_t *obuf_len) {
 
   /* Check crypto state */
   if (fips_fatal != FIPS_INITIALIZED) {
-    printf("u2f_authenticate: fips not initialized!\n");
+    h1_printf("u2f_authenticate: fips not initialized!\n");
     return U2F_SW_WTF + 6;
   }
 
-  /* Disentangle key handle */
-  if (obfuscate_kh(req->appId, req->keyHandle, kh, AES_DECRYPT_MODE) !=
-      EC_SUCCESS) {
-    printf("u2f_authenticate: obfuscate_kh failed\n");
+  /* Fingerprint pre-filter: one HMAC pass settles handles we minted
+   * without the full unwrap; anything else consults the negative
+   * cache before paying for one. */
+  if (kh_fingerprint(req->appId, req->keyHandle, fp) == EC_SUCCESS &&
+      equal_arrays(fp, req->keyHandle + 3 * AES_BLOCK_LEN, fp_len)) {
+    if (apdu.p1 & G2F_CHECK) {
+      h1_printf("u2f_authenticate: origin check via fingerprint.\n");
+      return U2F_SW_CONDITIONS_NOT_SATISFIED;
+    }
+  } else {
+    kh_reject_tag(req, kh_len, tag);
+    if (kh_reject_hit(tag)) {
+      return U2F_SW_WRONG_DATA;
+    }
+  }
+
+  /* Disentangle key handle. The deinterleave below reads only the
+   * three cipher blocks, so a v2 decrypt is complete. */
+  if (obfuscate_kh(req->appId, req->keyHandle, kh, kh_len,
+                   AES_DECRYPT_MODE) != EC_SUCCESS) {
+    h1_printf("u2f_authenticate: obfuscate_kh failed\n");
     return U2F_SW_WTF + 1;
   }
 
@@ -362,33 +546,50 @@ static uint16_t u2f_authenticate(APDU apdu, uint8_t *obuf, uint16_t *obuf_len) {
 
   /* Check whether appId (i.e. origin) matches. Constant time. */
   if (!equal_arrays(origin, req->appId, 24)) {
-    printf("u2f_authenticate: wrong_data on appId\n");
+    h1_printf("u2f_authenticate: wrong_data on appId\n");
+    kh_reject_tag(req, kh_len, tag);
+    kh_reject_add(tag);
     return U2F_SW_WRONG_DATA;
   }
 
   /* Origin check only? */
   if (apdu.p1 & G2F_CHECK) {
-    printf("u2f_authenticate: origin check only, return early.\n");
+    h1_printf("u2f_authenticate: origin check only, return early.\n");
     return U2F_SW_CONDITIONS_NOT_SATISFIED;
   }
-  printf("u2f_authenticate: origin passes checks. Wait for user presence.\n");
+  h1_printf("u2f_authenticate: origin passes checks. Wait for user presence.\n");
 
   /* Sense user presence, with optional consume */
   resp->flags = pop_check_presence(apdu.p1 & G2F_CONSUME, 500) == POP_TOUCH_YES;
 
   /* Mandatory user presence? */
   if ((apdu.p1 & G2F_TUP) != 0 && resp->flags == 0) {
-    printf("u2f_authenticate: TUP and flags conditions not satisfied\n");
+    h1_printf("u2f_authenticate: TUP and flags conditions not satisfied\n");
     return U2F_SW_CONDITIONS_NOT_SATISFIED;
   }
 
-  /* Increment-only counter in flash. OK to share between origins. */
-  count = flash_ctr_incr();
+  /* Increment-only counter in flash, kept per origin so relying
+   * parties cannot correlate usage across origins and concurrent
+   * authentications do not serialize on one record. Falls back to the
+   * shared global counter if the store is unavailable. */
+  sig_ctr_mount();
+  if (sig_ctr_ready) count = tock_sig_counter_incr(req->appId);
+  if (count == 0) {
+    /* Observable once per boot: every authentication after this line
+     * is sharing (and correlating on) the global counter. */
+    static int fallback_logged;
+    if (!fallback_logged) {
+      fallback_logged = 1;
+      h1_printf("u2f_authenticate: per-origin counter store unavailable; "
+                "using global counter\n");
+    }
+    count = flash_ctr_incr();
+  }
   resp->ctr[0] = (count >> 24) & 0xFF;
   resp->ctr[1] = (count >> 16) & 0xFF;
   resp->ctr[2] = (count >> 8) & 0xFF;
   resp->ctr[3] = count & 0xFF;
-  printf("u2f_authenticate: incremented counter to %li\n", count);
+  h1_printf("u2f_authenticate: incremented counter to %li\n", count);
 
   /* Message signature */
   SHA256_INIT(&ctx);
@@ -398,47 +599,76 @@ static uint16_t u2f_authenticate(APDU apdu, uint8_t *obuf, uint16_t *obuf_len) {
   SHA256_UPDATE(&ctx, req->nonce, U2F_NONCE_SIZE);
   PT_FROM_BIN(SHA256_FINAL(&ctx), &h);
 
-  printf("u2f_authenticate: generated hash of message.\n");
-  printf("u2f_authenticate: generating signature.\n");
+  h1_printf("u2f_authenticate: generated hash of message.\n");
+  h1_printf("u2f_authenticate: generating signature.\n");
 
   if (origin_keypair(od_seed, &origin_d, NULL, NULL)) {
-    printf("u2f_authenticate: failed to origin_keypair\n");
+    h1_printf("u2f_authenticate: failed to origin_keypair\n");
     return U2F_SW_WTF + 2;
   }
 
-  make_drbg2(&drbg_ctx);
+  drbg = fips_channel_drbg();
 
-  if (!ECDSA_SIGN(&drbg_ctx, &origin_d, &h, &r, &s)) {
+  if (!ECDSA_SIGN(drbg, &origin_d, &h, &r, &s)) {
     PT_CLEAR(&origin_d);
-    printf("u2f_authenticate: failed to ECDSA_SIGN\n");
+    h1_printf("u2f_authenticate: failed to ECDSA_SIGN\n");
     return U2F_SW_WTF + 3;
   }
   PT_CLEAR(&origin_d);
 
-  printf("u2f_authenticate: ECDSA signed.\n");
+  h1_printf("u2f_authenticate: ECDSA signed.\n");
 
   sig_len = asn1_sigp(resp->sig, &r, &s);
-  printf("u2f_authenticate: asn1 signature generated of len %i.\n", sig_len);
+  h1_printf("u2f_authenticate: asn1 signature generated of len %i.\n", sig_len);
 
   *obuf_len = sizeof(resp->flags) + U2F_CTR_SIZE + sig_len;
-  printf("U2F: u2f_authenticate completes.\n");
+  h1_printf("U2F: u2f_authenticate completes.\n");
   return U2F_SW_NO_ERROR;
 }
 
+typedef uint16_t (*apdu_handler)(APDU apdu, uint8_t *obuf,
+                                 uint16_t *obuf_len);
+
+/* INS dispatch table. The APDU passed to a handler is a borrowed view
+ * into the transport's buffer -- no copy is made, so handlers must be
+ * done with apdu.data before they write the response. */
+static const struct apdu_cmd {
+  uint8_t ins;
+  uint8_t fips; /* suppress the response if a FIPS error tripped */
+  const char *name;
+  apdu_handler handler;
+} apdu_cmds[] = {
+    {U2F_INS_REGISTER, 1, "REGISTER", u2f_register},
+    {U2F_INS_AUTHENTICATE, 1, "AUTHENTICATE", u2f_authenticate},
+    {U2F_INS_VERSION, 0, "VERSION", u2f_version},
+};
+
+/* Responses that never change, stored complete (payload plus status
+ * word) and served ahead of dispatch. Hosts probe VERSION on every
+ * connection setup, and after a hub power cycle every channel probes
+ * at once, so this path is one table compare and one 8-byte copy.
+ * Only parameterless (Lc == 0) requests match; anything else takes
+ * the handler path and earns its error status honestly. */
+static const struct apdu_const_rsp {
+  uint8_t ins;
+  uint8_t len;       /* bytes of rsp, SW included */
+  uint8_t rsp[8];
+} apdu_const_rsps[] = {
+    /* VERSION: "U2F_V2", U2F_SW_NO_ERROR */
+    {U2F_INS_VERSION, 8, {0x55, 0x32, 0x46, 0x5f, 0x56, 0x32, 0x90, 0x00}},
+};
+
 /* Receives an apdu-framed message from the U2F HID transport layer
  * Return output buffer's byte count on success. */
 uint16_t apdu_rcv(const uint8_t *ibuf, uint16_t in_len, uint8_t *obuf) {
   uint16_t obuf_len = 0;
   uint16_t sw = U2F_SW_CLA_NOT_SUPPORTED;
-  uint8_t CLA = ibuf[0];
-  uint8_t INS = ibuf[1];
+  const uint8_t CLA = ibuf[0];
+  const uint8_t INS = ibuf[1];
   APDU apdu = {.p1 = ibuf[2], .p2 = ibuf[3], .len = 0, .data = ibuf + 5};
+  size_t i;
 
-  /* Fill in APDU structure */
   /* [CLA INS P1 P2 [LC1 [LC2 LC3 <request-data>]]] */
-  CLA = ibuf[0];
-  INS = ibuf[1];
-
   /* ISO7618 LC decoding */
   if (in_len >= 5) {
     apdu.len = ibuf[4];
@@ -448,39 +678,38 @@ uint16_t apdu_rcv(const uint8_t *ibuf, uint16_t in_len, uint8_t *obuf) {
     apdu.data += 2;
   }
 
-  //printf("\n\n");
-  //printf("APDU rcv'd: %p\n", ibuf);
-  //printf("  APDU.len: 0x%x\n", apdu.len);
+  //h1_printf("\n\n");
+  //h1_printf("APDU rcv'd: %p\n", ibuf);
+  //h1_printf("  APDU.len: 0x%x\n", apdu.len);
 
   if (CLA == 0x00) { /* Always 0x00 */
     sw = U2F_SW_INS_NOT_SUPPORTED;
 
-    switch (INS) {
-    case (U2F_INS_REGISTER):
-      printf("U2F REGISTER cmd received\n");
-      sw = u2f_register(apdu, obuf, &obuf_len);
-      //printf("  - result 0x%x\n", sw);
-      if (fips_fatal != FIPS_INITIALIZED) {
-        obuf_len = 0;
-        sw = U2F_SW_WTF + 6;
-        printf("  fips uninitialized (0x%x) change SW to 0x%x\n", fips_fatal, sw);
+    /* Static responses first: no dispatch, no SW append */
+    if (apdu.len == 0) {
+      for (i = 0; i < ARRAY_SIZE(apdu_const_rsps); ++i) {
+        const struct apdu_const_rsp *c = &apdu_const_rsps[i];
+
+        if (c->ins != INS) continue;
+        memcpy(obuf, c->rsp, c->len);
+        return c->len;
       }
-      break;
+    }
 
-    case (U2F_INS_AUTHENTICATE):
-      printf("U2F AUTHENTICATE cmd received\n");
-      sw = u2f_authenticate(apdu, obuf, &obuf_len);
-      //printf("  -setting SW to 0x%x\n", sw);
-      if (fips_fatal != FIPS_INITIALIZED) {
+    for (i = 0; i < ARRAY_SIZE(apdu_cmds); ++i) {
+      const struct apdu_cmd *cmd = &apdu_cmds[i];
+
+      if (cmd->ins != INS) continue;
+      h1_printf("U2F %s cmd received\n", cmd->name);
+      sw = cmd->handler(apdu, obuf, &obuf_len);
+      //h1_printf("  - result 0x%x\n", sw);
+      if (cmd->fips && fips_fatal != FIPS_INITIALIZED) {
         obuf_len = 0;
         sw = U2F_SW_WTF + 6;
+        h1_printf("  fips uninitialized (0x%x) change SW to 0x%x\n", fips_fatal,
+               sw);
       }
       break;
-
-    case (U2F_INS_VERSION):
-      //printf("U2F VERSION\n");
-      sw = u2f_version(apdu, obuf, &obuf_len);
-      break;
     }
 
 #if defined(CONFIG_G2F)
@@ -496,14 +725,14 @@ uint16_t apdu_rcv(const uint8_t *ibuf, uint16_t in_len, uint8_t *obuf) {
   obuf[obuf_len - 2] = sw >> 8;
   obuf[obuf_len - 1] = sw;
 
-  //printf(" SW status: %04x\n", sw);
+  //h1_printf(" SW status: %04x\n", sw);
 
   {
     //int i = 0;
 
-    //printf("\nAPDU response buffer: %d\n", obuf_len);
-    //for (i = 0; i < obuf_len; i++) printf("%02X", obuf[i]);
-    //printf("\n");
+    //h1_printf("\nAPDU response buffer: %d\n", obuf_len);
+    //for (i = 0; i < obuf_len; i++) h1_printf("%02X", obuf[i]);
+    //h1_printf("\n");
   }
 
   return obuf_len;
@@ -0,0 +1,152 @@
+// Copyright 2021 Google LLC
+//
+// Licensed under the Apache License, Version 2.0 (the "License");
+// you may not use this file except in compliance with the License.
+// You may obtain a copy of the License at
+//
+//     https://www.apache.org/licenses/LICENSE-2.0
+//
+// Unless required by applicable law or agreed to in writing, software
+// distributed under the License is distributed on an "AS IS" BASIS,
+// WITHOUT WARRANTIES OR CONDITIONS OF ANY KIND, either express or implied.
+// See the License for the specific language governing permissions and
+// limitations under the License.
+
+#include <string.h>
+
+#include "timestamp_syscalls.h"
+#include "u2f.h"
+#include "u2f_hid.h"
+#include "u2f_latency.h"
+
+/* Timestamps come from the kernel's microsecond counter: one syscall,
+ * no yields, cheap enough to leave on in production builds. */
+static uint32_t lat_ticks(void) {
+  return gettimeus();
+}
+
+/* First-frame timestamps, keyed by cid. Sized to the transport's
+ * transaction slot pool; a message that outlives its entry simply
+ * doesn't get sampled. */
+#define LAT_PENDING 4
+
+static struct {
+  uint32_t cid;
+  uint32_t t_first;
+} pending[LAT_PENDING];
+
+/* Crypto window of the message currently in u2fhid_response_msg; the
+ * transport processes one message at a time, so a single pair of
+ * timestamps suffices. */
+static uint32_t t_crypto_start;
+static uint32_t t_crypto_end;
+
+static u2f_lat_stats stats[U2F_LAT_CLASSES];
+
+static uint32_t err_counts[U2F_LAT_ERR_PATHS];
+
+void u2f_lat_first_frame(uint32_t cid) {
+  int i;
+  int free_i = -1;
+  if (cid == 0) return;
+  for (i = 0; i < LAT_PENDING; i++) {
+    if (pending[i].cid == cid) {
+      free_i = i; /* INIT frame reuse; restart the clock */
+      break;
+    }
+    if (pending[i].cid == 0) free_i = i;
+  }
+  if (free_i < 0) return;
+  pending[free_i].cid = cid;
+  pending[free_i].t_first = lat_ticks();
+}
+
+void u2f_lat_crypto_start(void) {
+  t_crypto_start = lat_ticks();
+  t_crypto_end = t_crypto_start;
+}
+
+void u2f_lat_crypto_end(void) {
+  t_crypto_end = lat_ticks();
+}
+
+void u2f_lat_drop(uint32_t cid) {
+  int i;
+  for (i = 0; i < LAT_PENDING; i++) {
+    if (pending[i].cid == cid) pending[i].cid = 0;
+  }
+}
+
+static int ins_class(uint8_t ins) {
+  switch (ins) {
+  case U2F_INS_REGISTER:
+    return U2F_LAT_REGISTER;
+  case U2F_INS_AUTHENTICATE:
+    return U2F_LAT_AUTHENTICATE;
+  case U2F_INS_VERSION:
+    return U2F_LAT_VERSION;
+  default:
+    return U2F_LAT_OTHER;
+  }
+}
+
+static int err_path(uint8_t errno) {
+  switch (errno) {
+  case ERR_INVALID_CMD:
+    return U2F_LAT_ERR_INVALID_CMD;
+  case ERR_INVALID_LEN:
+    return U2F_LAT_ERR_INVALID_LEN;
+  case ERR_INVALID_SEQ:
+    return U2F_LAT_ERR_INVALID_SEQ;
+  case ERR_MSG_TIMEOUT:
+    return U2F_LAT_ERR_MSG_TIMEOUT;
+  case ERR_CHANNEL_BUSY:
+    return U2F_LAT_ERR_CHANNEL_BUSY;
+  case ERR_INVALID_CID:
+    return U2F_LAT_ERR_INVALID_CID;
+  default:
+    return U2F_LAT_ERR_OTHER;
+  }
+}
+
+void u2f_lat_err(uint8_t errno) {
+  err_counts[err_path(errno)]++;
+}
+
+void u2f_lat_msg_done(uint32_t cid, uint8_t ins) {
+  uint32_t t_last = lat_ticks();
+  uint32_t total_us, bound;
+  u2f_lat_stats *s;
+  int i, b;
+
+  for (i = 0; i < LAT_PENDING; i++) {
+    if (pending[i].cid == cid) break;
+  }
+  if (i == LAT_PENDING) return; /* never saw the first frame */
+  total_us = t_last - pending[i].t_first;
+  pending[i].cid = 0;
+
+  s = &stats[ins_class(ins)];
+  s->count++;
+  s->total_us += total_us;
+  s->crypto_us += t_crypto_end - t_crypto_start;
+  if (total_us > s->max_us) s->max_us = total_us;
+
+  bound = U2F_LAT_BUCKET0_US;
+  for (b = 0; b < U2F_LAT_BUCKETS - 1; b++) {
+    if (total_us < bound) break;
+    bound <<= 1;
+  }
+  s->bucket[b]++;
+}
+
+uint16_t u2f_lat_report(uint8_t *buf, uint16_t max, int reset) {
+  if (max < sizeof(stats) + sizeof(err_counts)) return 0;
+  memcpy(buf, stats, sizeof(stats));
+  memcpy(buf + sizeof(stats), err_counts, sizeof(err_counts));
+  if (reset) {
+    memset(stats, 0, sizeof(stats));
+    memset(err_counts, 0, sizeof(err_counts));
+  }
+  return sizeof(stats) + sizeof(err_counts);
+}
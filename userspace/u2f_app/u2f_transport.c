@@ -13,22 +13,28 @@
 // limitations under the License.
 
 /*
- * NOTHING YET!
- *
- * TODO: How many errors should clear the channel state, all of them?
- * If the response is an error message, does that always wipe out the
- * channel?. Possible to stick this into the error handler? Easy to check
- * once it's all working.
- *
- *  TODO: Some errors expect the channel to be reset, some don't. Try
- *  and make this consistent.
+ * Channel-error policy: every U2FHID_ERROR the transport emits goes
+ * through u2fhid_err(), which applies one rule -- message errors reset
+ * the channel's transaction state, frame errors leave it alone. The
+ * full policy (and which codes fall in which class) is documented next
+ * to the error codes in u2f_hid_corp.h; error paths are counted per
+ * code in the U2FHID_LATENCY instrumentation (u2f_latency.h).
  */
 
+#include <timer.h>
+#include <tock.h>
+
 #include "kl.h"
+#include "ctap2.h"
 #include "hid_dfu.h"
 #include "trng.h"
+#include "u2f.h"
 #include "u2f_corp.h"
 #include "u2f_hid_corp.h"
+#include "u2f_latency.h"
+#include "u2f_syscalls.h"
+#include "timer_wheel.h"
+#include "trace.h"
 
 
 #include "fips.h"
@@ -39,38 +45,278 @@
 #endif
 
 #include "console.h"
+#include "fmt.h"
 
 /* Next CID to allocate. */
 static uint32_t next_CID = 0x1;
-/* Channel lock variable -- lock CID for n seconds */
+/* Channel lock variable -- lock CID for n seconds. The lock is
+ * device-wide by spec, so it stays a single variable. */
 static uint32_t lock_CID;
-/* CID of the channel waiting for timeout */
-static uint32_t timeout_CID;
 
-/* Maintains state for multi-packet transactions */
-static PENDING_MSG pending;
+/* Known-channel table: open-addressed, power-of-two sized, 128 bytes
+ * total. Every operation probes at most CID_PROBES entries, so frame
+ * handling stays O(1) no matter how many channels a host cycles
+ * through. Entries age by a per-use stamp; when a probe window is
+ * full, the stalest entry in it is recycled (approximate LRU). */
+#define CID_TABLE_SIZE 16
+#define CID_PROBES 4
+
+typedef struct {
+  uint32_t cid;   /* 0 => empty */
+  uint32_t stamp; /* last use */
+} CID_ENTRY;
+
+static CID_ENTRY cid_table[CID_TABLE_SIZE];
+static uint32_t cid_clock;
+
+static uint32_t cid_hash(uint32_t cid) {
+  /* Knuth multiplicative hash; CIDs are sequential, this spreads them */
+  return (cid * 2654435761u) >> 28;
+}
+
+/* Find cid's entry, NULL if unknown */
+static CID_ENTRY *cid_lookup(uint32_t cid) {
+  uint32_t h = cid_hash(cid);
+  int i;
+
+  for (i = 0; i < CID_PROBES; i++) {
+    CID_ENTRY *e = &cid_table[(h + i) & (CID_TABLE_SIZE - 1)];
+
+    if (e->cid == cid) return e;
+  }
+  return NULL;
+}
+
+/* Insert (or refresh) cid, recycling the stalest entry of its probe
+ * window when all are taken */
+static void cid_insert(uint32_t cid) {
+  uint32_t h = cid_hash(cid);
+  CID_ENTRY *victim = NULL;
+  int i;
+
+  for (i = 0; i < CID_PROBES; i++) {
+    CID_ENTRY *e = &cid_table[(h + i) & (CID_TABLE_SIZE - 1)];
+
+    if (e->cid == cid || e->cid == 0) {
+      victim = e;
+      break;
+    }
+    if (victim == NULL || (int32_t)(e->stamp - victim->stamp) < 0) victim = e;
+  }
+  victim->cid = cid;
+  victim->stamp = ++cid_clock;
+}
+
+/* Keep the LRU stamps current as traffic arrives */
+static void cid_touch(uint32_t cid) {
+  CID_ENTRY *e = cid_lookup(cid);
+
+  if (e != NULL) e->stamp = ++cid_clock;
+}
+
+/* Allocate a fresh CID: skip broadcast and any cid still in the
+ * table, so rollover can never hand out a live channel's id */
+static uint32_t cid_alloc(void) {
+  uint32_t cid;
+
+  do {
+    cid = next_CID++;
+    if (next_CID == CID_BROADCAST) next_CID = 1;
+  } while (cid == 0 || cid_lookup(cid) != NULL);
+  cid_insert(cid);
+
+  return cid;
+}
+
+/* Per-channel transaction state. Hosts multiplex several logical
+ * channels over one device; a singleton pending message meant a second
+ * channel's traffic during a long transaction got ERR_CHANNEL_BUSY.
+ * Each active CID instead claims a slot and reassembles its frames
+ * there; busy is only returned when all slots are taken. */
+#define MAX_CHANNELS 4
+
+typedef struct {
+  PENDING_MSG msg;        /* msg.cid == 0 => slot free */
+  uint8_t timeout;        /* wheel timer id + 1, or 0 if none armed */
+  uint8_t *buf;           /* borrowed reassembly arena, or NULL */
+} CHANNEL_SLOT;
+
+static CHANNEL_SLOT channels[MAX_CHANNELS];
 
-static uint8_t rx_buffer[MAX_BCNT];
 static uint8_t tx_buffer[MAX_BCNT];
 
+/* Reassembly arena pool. Singleton requests are parsed in place in the
+ * receive ring and responses serialize straight into tx_buffer, so a
+ * slot only needs a full-size buffer while a multi-frame request is in
+ * flight. Lending arenas from a small pool instead of embedding one in
+ * every slot cuts the transport's static footprint from
+ * (MAX_CHANNELS + 1) to (RX_ARENAS + 1) times MAX_BCNT -- about 15KB
+ * of SRAM back. All MAX_CHANNELS slots still serve singleton traffic;
+ * a host interleaving more than RX_ARENAS multi-frame requests gets
+ * ERR_CHANNEL_BUSY, the same answer as exhausted slots. */
+#define RX_ARENAS 2
+static uint8_t rx_arenas[RX_ARENAS][MAX_BCNT];
+static uint8_t rx_arena_used[RX_ARENAS];
+
+static uint8_t *arena_borrow(void) {
+  int i;
+
+  for (i = 0; i < RX_ARENAS; i++) {
+    if (!rx_arena_used[i]) {
+      rx_arena_used[i] = 1;
+      return rx_arenas[i];
+    }
+  }
+  return NULL;
+}
+
+static void arena_return(const uint8_t *buf) {
+  int i;
+
+  for (i = 0; i < RX_ARENAS; i++) {
+    if (rx_arenas[i] == buf) rx_arena_used[i] = 0;
+  }
+}
+
+/* Staging for vectored response transmits: frames are batched here and
+ * handed to the kernel in one submission per batch, rather than one
+ * syscall pair per 64-byte frame. */
+#define TX_BATCH_FRAMES 8
+static U2FHID_FRAME tx_batch[TX_BATCH_FRAMES];
+
 static SYSINFO U2F_sysinfo;
 
+static CHANNEL_SLOT *slot_find(uint32_t cid) {
+  int i;
+
+  for (i = 0; i < MAX_CHANNELS; i++) {
+    if (channels[i].msg.cid == cid) return &channels[i];
+  }
+  return NULL;
+}
+
+static CHANNEL_SLOT *slot_alloc(uint32_t cid) {
+  CHANNEL_SLOT *s = slot_find(0);
+
+  if (s != NULL) s->msg.cid = cid;
+  return s;
+}
+
+static void clear_slot(CHANNEL_SLOT *s) {
+  if (s->buf != NULL) {
+    arena_return(s->buf);
+    s->buf = NULL;
+  }
+  s->msg.cid = 0;
+  s->msg.data = NULL;
+  s->msg.cmd = 0;
+  s->msg.seqno = 0;
+  s->msg.bcnt = 0;
+  if (s->timeout) {
+    timer_wheel_cancel(s->timeout - 1);
+    s->timeout = 0;
+  }
+}
+
+/* Release whichever slot owns cid, if any */
+static void slot_release(uint32_t cid) {
+  CHANNEL_SLOT *s = slot_find(cid);
+
+  if (s != NULL) clear_slot(s);
+}
+
 /* Return 0 if success, 1 if last frame. */
-static int consume_frame(U2FHID_FRAME *f_p) {
-  int nreceived = 57 + pending.seqno * 59;
-  uint8_t *p = rx_buffer + nreceived;
+/* Multi-frame payloads are interleaved with 5-byte frame headers on the
+ * wire, so assembling a contiguous message takes one gather copy per
+ * CONT frame; singleton messages are parsed in the receive ring with no
+ * copy at all. */
+static int consume_frame(CHANNEL_SLOT *s, U2FHID_FRAME *f_p) {
+  int nreceived = 57 + s->msg.seqno * 59;
+  uint8_t *p = s->buf + nreceived;
 
   memcpy(p, f_p->cont.data, 59);
   nreceived += 59;
-  pending.seqno += 1;
+  s->msg.seqno += 1;
+
+  return nreceived >= s->msg.bcnt;
+}
+
+/* Keepalive state. Long commands block in yield() waiting on kernel
+ * callbacks (ECDSA on dcrypto, flash writes, presence polling); the
+ * timer wheel callback rides those same yields, so keepalives keep
+ * flowing while crypto is pending and the command path needs no
+ * keepalive calls of its own. */
+static int keepalive_id = -1;
+static uint32_t keepalive_cid;
+static uint8_t put_frame_busy;
+
+/* All transmits in this file go through here so the keepalive callback
+ * can tell when it interrupted a transmit mid-flight. */
+static int put_frame(const U2FHID_FRAME *f_p) {
+  int rval;
+
+  put_frame_busy = 1;
+  rval = usbu2f_put_frame(f_p);
+  put_frame_busy = 0;
+  return rval;
+}
+
+static void keepalive_cb(void *ud __attribute__((unused))) {
+  U2FHID_FRAME r = {0, .init = {0, 0, 0, {0}}};
+
+  /* Skip a beat rather than interleave with a frame going out */
+  if (keepalive_cid == 0 || put_frame_busy) return;
+
+  r.cid = keepalive_cid;
+  r.init.cmd = U2FHID_KEEPALIVE;
+  r.init.bcnth = 0;
+  r.init.bcntl = 1;
+  r.init.data[0] = KEEPALIVE_STATUS_PROCESSING;
+  put_frame(&r);
+}
+
+static void keepalive_start(uint32_t cid) {
+  keepalive_cid = cid;
+  if (keepalive_id < 0)
+    keepalive_id = timer_wheel_every(KEEPALIVE_INTERVAL_MS, keepalive_cb, NULL);
+}
 
-  return nreceived >= pending.bcnt;
+static void keepalive_stop(void) {
+  if (keepalive_cid == 0) return;
+  if (keepalive_id >= 0) {
+    timer_wheel_cancel(keepalive_id);
+    keepalive_id = -1;
+  }
+  keepalive_cid = 0;
 }
 
-/* Send the U2F HID protocol error code back over the USB channel */
+/* Does this error condemn the channel's in-flight message? Message
+ * errors reset the channel's transaction state; frame errors reject
+ * the offending frame and touch nothing. See the policy comment next
+ * to the ERR_* split in u2f_hid_corp.h. */
+static int err_resets_channel(uint8_t errno) {
+  switch (errno) {
+  case ERR_INVALID_CMD:
+  case ERR_INVALID_SEQ:
+  case ERR_MSG_TIMEOUT:
+    return 1;
+  default:
+    return 0;
+  }
+}
+
+/* Send the U2F HID protocol error code back over the USB channel.
+ * Single choke point for errors: the reset policy and the per-error
+ * counters both live here, so no path can apply them inconsistently. */
 static void u2fhid_err(uint32_t cid, uint8_t errno) {
   U2FHID_FRAME r = {0, .init = {0, 0, 0, {0}}};
 
+  u2f_lat_err(errno);
+  if (err_resets_channel(errno) && cid != 0 && cid != CID_BROADCAST) {
+    slot_release(cid);
+    u2f_lat_drop(cid);
+  }
+
   /* Construct U2F HID error cmd response frame */
   r.cid = cid;
   r.init.cmd = U2FHID_ERROR;
@@ -79,40 +325,47 @@ static void u2fhid_err(uint32_t cid, uint8_t errno) {
   r.init.data[0] = errno;
 
   /* Send the response */
-  usbu2f_put_frame(&r);
+  put_frame(&r);
 }
 
-static void clear_pending(void) {
-  pending.cid = 0;
-  pending.data = NULL;
-  pending.cmd = 0;
-  pending.seqno = 0;
-  pending.bcnt = 0;
-}
+static void start_timeout(CHANNEL_SLOT *s);
 
-// Note: timeouts are not used; they are vestigial from original U2F code.
-/*
-  static void u2fhid_timeout(void) {
-  if (timeout_CID) {
-    printf("%s: cid %04lx (pending %04lx)", __func__, timeout_CID, pending.cid);
-    u2fhid_err(timeout_CID, ERR_MSG_TIMEOUT);
-    timeout_CID = 0;
-    clear_pending();
+/* A reassembly whose continuation frames stop arriving times out:
+ * ERR_MSG_TIMEOUT goes back and u2fhid_err's reset policy releases the
+ * slot. This was vestigial from the original EC code (whose deferred
+ * hooks did not port); the timer wheel carries it now. */
+static void u2fhid_timeout(void *ud) {
+  CHANNEL_SLOT *s = ud;
+
+  s->timeout = 0; /* this one-shot id is spent */
+  /* Skip a beat rather than interleave the error frame with a
+   * transmit in flight. */
+  if (put_frame_busy) {
+    start_timeout(s);
+    return;
   }
-}*/
-//DECLARE_DEFERRED(u2fhid_timeout);
+  h1_printf("%s: cid %04lx\n", __func__, s->msg.cid);
+  u2fhid_err(s->msg.cid, ERR_MSG_TIMEOUT);
+}
+
+static void cancel_timeout(uint32_t cid) {
+  CHANNEL_SLOT *s = slot_find(cid);
 
-static void cancel_timeout(void) {
-  if (timeout_CID) {
-    timeout_CID = 0;
+  if (s != NULL && s->timeout) {
+    timer_wheel_cancel(s->timeout - 1);
+    s->timeout = 0;
   }
-  //hook_call_deferred(&u2fhid_timeout_data, -1);
 }
 
-/* Start/restart timeout for a given channel */
-static void start_timeout(uint32_t cid) {
-  timeout_CID = cid;
-  //  hook_call_deferred(&u2fhid_timeout_data, MSG_TIMEOUT);
+/* Start/restart the reassembly timeout for a given channel */
+static void start_timeout(CHANNEL_SLOT *s) {
+  int id;
+
+  if (s->timeout) timer_wheel_cancel(s->timeout - 1);
+  id = timer_wheel_in(MSG_TIMEOUT / 1000, u2fhid_timeout, s);
+  /* A full wheel just leaves the channel without a timeout, as
+   * before. */
+  s->timeout = id < 0 ? 0 : (uint8_t)(id + 1);
 }
 
 /* Spec 4.1.1
@@ -138,12 +391,15 @@ static int u2fhid_cmd_ping(const uint8_t *in, const uint16_t n, uint8_t *out) {
 
   return EC_SUCCESS;
 }
-/*
-static void cancel_lock_timeout(void) {
-  printf("Lock %04lx expired\n", lock_CID);
+/* Channel-lock expiry, spec-mandated at up to 10 seconds; also
+ * revived from the EC deferred hooks onto the timer wheel. */
+static int lock_timer_id = -1;
+
+static void lock_expire(void *ud __attribute__((unused))) {
+  h1_printf("Lock %04lx expired\n", lock_CID);
+  lock_timer_id = -1;
   lock_CID = 0;
-  }*/
-//DECLARE_DEFERRED(cancel_lock_timeout);
+}
 
 /* Spec 4.2.2
  * The lock command places an exclusive lock for one channel to
@@ -155,13 +411,16 @@ static void cancel_lock_timeout(void) {
  * commands to maintain the lock.
  */
 static int u2fhid_cmd_lock(const uint32_t cid, const uint8_t duration) {
+  if (lock_timer_id >= 0) {
+    timer_wheel_cancel(lock_timer_id);
+    lock_timer_id = -1;
+  }
   if (!duration) {
-    printf("Lock %04lx canceled\n", cid);
+    h1_printf("Lock %04lx canceled\n", cid);
     lock_CID = 0;
-    //hook_call_deferred(&cancel_lock_timeout_data, -1);
   } else {
-    printf("Lock %04lx set for %d\n", cid, duration);
-    //hook_call_deferred(&cancel_lock_timeout_data, duration * SECOND);
+    h1_printf("Lock %04lx set for %d\n", cid, duration);
+    lock_timer_id = timer_wheel_in((uint32_t)duration * 1000, lock_expire, NULL);
     lock_CID = cid;
   }
 
@@ -171,14 +430,14 @@ static int u2fhid_cmd_lock(const uint32_t cid, const uint8_t duration) {
 /* U2F HID command WINK */
 static int u2fhid_cmd_wink(void) {
   /* TODO: Frob the LED */
-  //printf("\nWINK WINK\n");
+  //h1_printf("\nWINK WINK\n");
   return EC_SUCCESS;
 }
 
 /* U2F HID command PROMPT */
 static int u2fhid_cmd_prompt(void) {
   /* TODO: Frob the LED */
-  //printf("\nPROMPT PROMPT\n");
+  //h1_printf("\nPROMPT PROMPT\n");
   return EC_SUCCESS;
 }
 
@@ -246,7 +505,7 @@ static U2FHID_FRAME init_frame(uint8_t cmd, uint16_t bcnt, uint8_t *buf_resp) {
   r.init.cmd = cmd;
   r.init.bcntl = 0xFF & bcnt;
   r.init.bcnth = bcnt >> 8;
-  /* printf("Copying %d bytes @ %x\n", n, buf_resp); */
+  /* h1_printf("Copying %d bytes @ %x\n", n, buf_resp); */
   if (n >= 57) {
     /* Full INIT frame */
     memcpy(r.init.data, buf_resp, 57);
@@ -263,9 +522,14 @@ static void u2fhid_response_msg(PENDING_MSG *req) {
   uint16_t rsp_len = 0;          // Bytes
   uint8_t num_cont_frames = -1;  // -1 => only INIT frame
   uint8_t i = 0;
+  /* APDU INS byte for the latency histograms; 0xff for non-MSG traffic */
+  uint8_t lat_ins = 0xff;
+
+  if (((req->cmd | TYPE_MASK) == U2FHID_MSG) && req->bcnt >= 2)
+    lat_ins = req->data[1];
 
   /* Message received */
-  cancel_timeout();
+  cancel_timeout(req->cid);
   rsp.cid = req->cid;
 
   /* TRNG may have failed earlier, init *only* when uninitialized.
@@ -274,31 +538,43 @@ static void u2fhid_response_msg(PENDING_MSG *req) {
    */
   if (fips_fatal == FIPS_UNINITIALIZED) init_fips();
 
+  /* Route ephemeral DRBG draws to this channel's instance. */
+  fips_set_active_channel(req->cid);
+
+  /* Keepalives fire from the timer until the command returns */
+  keepalive_start(req->cid);
+
   /* Command dispatch */
+  u2f_lat_crypto_start();
   switch (req->cmd | TYPE_MASK) {
   case U2FHID_MSG:
-    //printf("Responding to cmd MSG on CID: %02lx\n", req->cid);
+    //h1_printf("Responding to cmd MSG on CID: %02lx\n", req->cid);
       u2fhid_cmd_msg(req->data, req->bcnt, tx_buffer, &rsp_len);
       break;
 
+  case U2FHID_CBOR:
+    //h1_printf("Responding to cmd CBOR on CID: %02lx\n", req->cid);
+    rsp_len = ctap2_rcv(req->data, req->bcnt, tx_buffer, sizeof(tx_buffer));
+    break;
+
   case U2FHID_PING:
-    //printf("Responding to cmd PING on CID: %02lx\n", req->cid);
+    //h1_printf("Responding to cmd PING on CID: %02lx\n", req->cid);
     rsp_len = req->bcnt; /* bytes in = bytes out */
     u2fhid_cmd_ping(req->data, req->bcnt, tx_buffer);
     break;
 
   case U2FHID_LOCK:
-    //printf("Responding to cmd LOCK on CID: %02lx\n", req->cid);
+    //h1_printf("Responding to cmd LOCK on CID: %02lx\n", req->cid);
     u2fhid_cmd_lock(req->cid, req->data[0]);
     break;
 
   case U2FHID_WINK:
-    //printf("Responding to cmd WINK on CID: %02lx\n", req->cid);
+    //h1_printf("Responding to cmd WINK on CID: %02lx\n", req->cid);
     u2fhid_cmd_wink();
     break;
 
   case U2FHID_PROMPT:
-    //printf("Responding to cmd PROMPT on CID: %02lx\n", req->cid);
+    //h1_printf("Responding to cmd PROMPT on CID: %02lx\n", req->cid);
     u2fhid_cmd_prompt();
     break;
 
@@ -313,25 +589,36 @@ static void u2fhid_response_msg(PENDING_MSG *req) {
 
 #if defined(CONFIG_FIPS_TEST)
     case U2FHID_FIPS:
-      //printf("Responding to U2F command FIPS on CID: %02lx\n", req->cid);
+      //h1_printf("Responding to U2F command FIPS on CID: %02lx\n", req->cid);
       rsp_len = sizeof(tx_buffer);
       u2fhid_cmd_fips(req->data, req->bcnt, tx_buffer, &rsp_len);
       break;
 #endif
 
   case U2FHID_SYSINFO:
-    //printf("Responding to cmd SYSINFO on CID: %02lx\n", req->cid);
+    //h1_printf("Responding to cmd SYSINFO on CID: %02lx\n", req->cid);
     u2fhid_cmd_sysinfo(tx_buffer, &rsp_len);
     break;
 
-    /* TODO: Make this state not-special if possible */
+  case U2FHID_LATENCY:
+    /* One request byte: nonzero resets the stats after reporting. */
+    rsp_len = u2f_lat_report(tx_buffer, sizeof(tx_buffer),
+                             req->bcnt >= 1 && req->data[0] != 0);
+    break;
+
   default:
-    //printf("Command %02x on CID %02lx does not exist.\n", req->cmd, req->cid);
+    //h1_printf("Command %02x on CID %02lx does not exist.\n", req->cmd, req->cid);
+    keepalive_stop();
+    /* Message error; u2fhid_err resets the channel */
     u2fhid_err(req->cid, ERR_INVALID_CMD);
-    clear_pending();
     return;
   }
 
+  /* Command done; the response frames below must not interleave with
+   * keepalives on the wire */
+  u2f_lat_crypto_end();
+  keepalive_stop();
+
   /* Number of continuation frames needed for response message */
   if (rsp_len > 57)
     num_cont_frames = ((rsp_len - 57) + 58) / 59;
@@ -341,22 +628,40 @@ static void u2fhid_response_msg(PENDING_MSG *req) {
   /* Construct U2F HID INIT frame */
   rsp = init_frame(req->cmd | TYPE_MASK, rsp_len, tx_buffer);
   rsp.cid = req->cid;
-  if (usbu2f_put_frame(&rsp) < 0) goto cleanup;
 
-  /* TODO: Send multiple frames automagically using scatter */
-  /* gather. Output-to-host buffer should be 8256B to handle max 129 x */
-  /* 64B frames  */
-
-  /* Construct U2F CONT INIT frame(s) */
-  for (i = 0; i < num_cont_frames; i++) {
-    rsp = cont_frame(i, rsp_len, tx_buffer);
-    rsp.cid = req->cid;
-    if (usbu2f_put_frame(&rsp) < 0) break;
+  if (num_cont_frames == 0) {
+    if (put_frame(&rsp) < 0) goto cleanup;
+  } else {
+    /* Multi-frame response: batch the INIT and CONT frames and hand
+     * each batch to the kernel in one vectored submission, one
+     * completion wakeup per batch. Keepalives are already stopped, so
+     * nothing else can interleave on the wire. */
+    uint8_t batched = 0;
+
+    tx_batch[batched++] = rsp;
+    for (i = 0; i < num_cont_frames; i++) {
+      rsp = cont_frame(i, rsp_len, tx_buffer);
+      rsp.cid = req->cid;
+      tx_batch[batched++] = rsp;
+      if (batched == TX_BATCH_FRAMES) {
+        if (tock_u2f_transmit_frames(tx_batch, batched) < 0) goto cleanup;
+        batched = 0;
+      }
+    }
+    if (batched > 0 &&
+        tock_u2f_transmit_frames(tx_batch, batched) < 0) goto cleanup;
   }
 
+  /* Last response frame is with the USB driver; close the sample. */
+  u2f_lat_msg_done(req->cid, lat_ins);
+  slot_release(req->cid);
+  return;
+
 cleanup:
-  /* State's in the pending channel; OK to clear here */
-  clear_pending();
+  /* Response truncated; don't let a partial send pollute the stats */
+  u2f_lat_drop(req->cid);
+  /* Transaction complete; release the channel's slot */
+  slot_release(req->cid);
 }
 
 /* This command synchronizes a channel and optionally requests
@@ -371,17 +676,16 @@ static void u2fhid_cmd_init(U2FHID_FRAME *f_p) {
   /* Create the response packet */
   /* Allocate a new channel if requested from host application */
   if (f_p->cid == CID_BROADCAST) {
-    proposed_cid = next_CID++;
-    if (next_CID == CID_BROADCAST) next_CID = 1;
+    proposed_cid = cid_alloc();
     /* Respond on the broadcast channel */
     response.cid = CID_BROADCAST;
   } else {
     proposed_cid = f_p->cid;
+    /* Resyncing an existing channel; make sure it is in the table */
+    cid_insert(f_p->cid);
     /* Respond on the same channel */
     response.cid = f_p->cid;
   }
-  /* Don't even need to check for unallocated CIDs */
-  /* TODO (domrizzo): Handle CID rollover, unlikely as it is. */
   /* Init'ing a union inside a structure is a pain */
   response.init.cmd = U2FHID_INIT;
   response.init.bcnth = 0;
@@ -406,14 +710,16 @@ static void u2fhid_cmd_init(U2FHID_FRAME *f_p) {
   response.init.data[15] = 0;
   /* DATA + 16 = Capabilities flags */
   /* TODO: Yes/no? */
-  response.init.data[16] = CAPFLAG_WINK | CAPFLAG_LOCK;
-  //printf("Response Frame -> cid:%08lx cmd:%02x ", response.cid,
+  response.init.data[16] = CAPFLAG_WINK | CAPFLAG_LOCK | CAPFLAG_CBOR;
+  //h1_printf("Response Frame -> cid:%08lx cmd:%02x ", response.cid,
   //        response.init.cmd);
-  //printf("bcnth:%02x bcntl:%02x ", response.init.bcnth, response.init.bcntl);
-  usbu2f_put_frame(&response);
+  //h1_printf("bcnth:%02x bcntl:%02x ", response.init.bcnth, response.init.bcntl);
+  put_frame(&response);
 }
 
-void u2fhid_process_frame(U2FHID_FRAME *f_p);
+/* Hot: every USB frame funnels through here; keep it (and what it
+ * inlines under LTO) grouped in .text.hot. */
+void u2fhid_process_frame(U2FHID_FRAME *f_p) __attribute__((hot));
 
 void u2fhid_process_frame(U2FHID_FRAME *f_p) {
   /* From the U2F HID spec, 2.5.4 Packet sequencing The device keeps
@@ -426,20 +732,19 @@ void u2fhid_process_frame(U2FHID_FRAME *f_p) {
    */
 
   uint16_t bcnt = 0;
-  //printf("U2F: processing frame at 0x%08x.\n", (unsigned int)f_p);
+  //h1_printf("U2F: processing frame at 0x%08x.\n", (unsigned int)f_p);
   /* Channel error checking */
   /* TODO: Would be nice to check anything related to the channel here. */
   /* ERROR: Nothing should ever be on channel 0 */
   if (f_p->cid == 0) {
-    printf("No frame should ever use channel 0\n");
-    printf("Except this error msg, according to the test. \n");
+    TRACE_ERR(TRACE_U2F_BAD_CID, 0, FRAME_CMD(*f_p));
     u2fhid_err(f_p->cid, ERR_INVALID_CID);
     return;
   }
   /* Only U2FHID_INIT commands on broadcast CID */
   if ((f_p->cid == CID_BROADCAST) &&
       (FRAME_CMD(*f_p) != (~TYPE_MASK & U2FHID_INIT))) {
-    printf("Only U2FHID_INIT commands on broadcast CID\n");
+    TRACE_ERR(TRACE_U2F_BAD_CID, f_p->cid, FRAME_CMD(*f_p));
     /* TODO: Kosher to respond on the broadcast channel? */
     u2fhid_err(f_p->cid, ERR_INVALID_CID);
     return;
@@ -449,28 +754,32 @@ void u2fhid_process_frame(U2FHID_FRAME *f_p) {
    * very quickly. */
   if ((FRAME_TYPE(*f_p) == TYPE_INIT) &&
       (FRAME_CMD(*f_p) == (~TYPE_MASK & U2FHID_INIT))) {
-    /* Abort an ongoing multi-packet transaction */
-    if (f_p->cid == pending.cid) {
-      cancel_timeout();
-      clear_pending();
-      printf("Pending transaction cancelled\n");
+    /* Abort this channel's ongoing multi-packet transaction; other
+     * channels' reassembly carries on untouched. */
+    if (slot_find(f_p->cid) != NULL) {
+      slot_release(f_p->cid);
+      u2f_lat_drop(f_p->cid);
+      TRACE_INFO(TRACE_U2F_TXN_CANCELLED, f_p->cid, 0);
     }
 
     /* Cope w/ the "special" U2FHID_INIT command */
-    //printf("U2F HID Init cmd received\n");
+    //h1_printf("U2F HID Init cmd received\n");
     u2fhid_cmd_init(f_p);
-    //printf("U2F HID Init cmd completed\n");
+    //h1_printf("U2F HID Init cmd completed\n");
     return;
   }
 
   /* Normal msg flow; not U2FHID_INIT */
   else {
+    /* Refresh this channel's LRU stamp */
+    cid_touch(f_p->cid);
+
     /* Channel lock set? */
     if (lock_CID > 0) {
       /* Lock cancels itself on expiration. */
       /* ERR: Other CID attempted to use locked chn */
       if (f_p->cid != lock_CID) {
-        printf("Channel locked by U2F_LOCK cmd\n");
+        TRACE_INFO(TRACE_U2F_CHANNEL_LOCKED, f_p->cid, lock_CID);
         u2fhid_err(f_p->cid, ERR_CHANNEL_BUSY);
         return;
         /* Don't clear the channel */
@@ -479,92 +788,106 @@ void u2fhid_process_frame(U2FHID_FRAME *f_p) {
 
     /* INIT frame */
     if (FRAME_TYPE(*f_p) == TYPE_INIT) {
-      //printf("U2F: Received init frame.\n");
-      /* ERROR: Device in use by another channel */
-      if ((f_p->cid != pending.cid) && (pending.cid != 0)) {
-        printf("U2F: Fob in use by other channel.\n");
-        u2fhid_err(f_p->cid, ERR_CHANNEL_BUSY);
-        return;
-      }
-      /* ERROR: Right channel, but CONT frame expected
+      CHANNEL_SLOT *s = slot_find(f_p->cid);
+
+      //h1_printf("U2F: Received init frame.\n");
+      /* ERROR: This channel already reassembling, CONT frame expected
        */
-      if (pending.cid != 0) {
-        printf("U2F: Expected CONT frame.\n");
+      if (s != NULL) {
+        TRACE_ERR(TRACE_U2F_EXPECTED_CONT, f_p->cid, 0);
+        /* Message error; u2fhid_err resets the channel */
         u2fhid_err(f_p->cid, ERR_INVALID_SEQ);
-        /* Clear the channel + timeout */
-        cancel_timeout();
-        clear_pending();
         return;
       }
       /* ERROR: Message length is too large */
       if (MSG_LEN(*f_p) > MAX_BCNT) {
-        printf("U2F: Msg length exceeds max # bytes.\n");
+        TRACE_ERR(TRACE_U2F_BAD_LEN, f_p->cid, MSG_LEN(*f_p));
         u2fhid_err(f_p->cid, ERR_INVALID_LEN);
         return;
       }
+      /* ERROR: Every transaction slot in use */
+      s = slot_alloc(f_p->cid);
+      if (s == NULL) {
+        TRACE_ERR(TRACE_U2F_SLOTS_FULL, f_p->cid, MAX_CHANNELS);
+        u2fhid_err(f_p->cid, ERR_CHANNEL_BUSY);
+        return;
+      }
 
       /* Init frame through. Begin transaction. */
+      u2f_lat_first_frame(f_p->cid);
       /* Start timeout */
-      start_timeout(f_p->cid);
+      start_timeout(s);
       bcnt = MSG_LEN(*f_p);
-      /* TODO: Possible to replace this w/ only use of
-       * pending struct?
-       */
-      pending.cid = f_p->cid;
-      pending.data = rx_buffer;
-      pending.cmd = FRAME_CMD(*f_p);
-      pending.seqno = 0;
-      pending.bcnt = bcnt;
+      s->msg.cmd = FRAME_CMD(*f_p);
+      s->msg.seqno = 0;
+      s->msg.bcnt = bcnt;
 
       /* Singleton or multi-packet request message? */
       /* singleton msg (msg <= 1 frame) */
       if (bcnt <= 57) {
-        memcpy(rx_buffer, f_p->init.data, bcnt);
+        /* Parse the payload in place in the receive ring; its slot is
+         * not recycled until the ring wraps, long after the response
+         * below has been built. */
+        s->msg.data = f_p->init.data;
         /* Process response message immediately
          */
-        u2fhid_response_msg(&pending);
-        /* Clear the channel? */
+        u2fhid_response_msg(&s->msg);
+        /* Slot released by u2fhid_response_msg */
       }
       /* multi-pkt msg */
       else {
+        /* Borrow a reassembly arena for the duration of the message */
+        s->buf = arena_borrow();
+        if (s->buf == NULL) {
+          TRACE_ERR(TRACE_U2F_SLOTS_FULL, f_p->cid, RX_ARENAS);
+          /* Roll back this frame's own slot and timestamp before the
+           * (non-resetting) busy error; there was no prior transaction
+           * on the channel to preserve. */
+          clear_slot(s);
+          u2f_lat_drop(f_p->cid);
+          u2fhid_err(f_p->cid, ERR_CHANNEL_BUSY);
+          return;
+        }
+        s->msg.data = s->buf;
         /* Start filling up the msg buffer */
-        memcpy(rx_buffer, f_p->init.data, 57);
+        memcpy(s->buf, f_p->init.data, 57);
       }
       /* INIT frame handled */
       return;
     }
     /* CONTinuation frame */
     else if (FRAME_TYPE(*f_p) == TYPE_CONT) {
-      //printf("U2F: Received CONT frame.\n");
-      /* ERRORish: No pending transaction, ignore. */
-      if (pending.cid == 0 || pending.cid != f_p->cid) {
-        printf("U2F: Random CONT packet; ignoring\n");
+      CHANNEL_SLOT *s = slot_find(f_p->cid);
+
+      //h1_printf("U2F: Received CONT frame.\n");
+      /* ERRORish: No pending transaction on this channel, ignore. */
+      if (s == NULL) {
+        TRACE_INFO(TRACE_U2F_SPURIOUS_CONT, f_p->cid, f_p->cont.seq);
         return;
       }
       /* ERROR: incorrect sequence # */
-      if (pending.seqno != f_p->cont.seq) {
-        printf("U2F: Invalid sequence number\n");
+      if (s->msg.seqno != f_p->cont.seq) {
+        TRACE_ERR(TRACE_U2F_BAD_SEQ, f_p->cid,
+                  ((uint32_t)s->msg.seqno << 8) | f_p->cont.seq);
+        /* Message error; u2fhid_err resets the channel */
         u2fhid_err(f_p->cid, ERR_INVALID_SEQ);
-        cancel_timeout();
-        clear_pending();
         return;
       }
 
       /* CONT frame rcv'd w/out error, process */
       /* Restart timeout */
-      start_timeout(pending.cid);
+      start_timeout(s);
       /* Consume frame, process full request msg if last frame */
-      if (consume_frame(f_p)) {
-        //printf("U2F: Message completed, process.\n");
-        u2fhid_response_msg(&pending);
+      if (consume_frame(s, f_p)) {
+        //h1_printf("U2F: Message completed, process.\n");
+        u2fhid_response_msg(&s->msg);
       }
     }
     /* Invalid frame type; shouldn't happen */
     else {
-      printf("ERR_OTHER: should never get here.\n");
-      printf("frame type: %02x, cmd: %02x\n\n", FRAME_TYPE(*f_p),
-              FRAME_CMD(*f_p));
-      /* TODO: return ERR_OTHER */
+      TRACE_ERR(TRACE_U2F_BAD_FRAME_TYPE, FRAME_TYPE(*f_p), FRAME_CMD(*f_p));
+      /* Frame error; any in-flight message on the channel survives */
+      u2fhid_err(f_p->cid, ERR_OTHER);
     }
     /* All possible frame types handled */
   }
@@ -575,9 +898,24 @@ void u2f_wakeup(void) {
   //  if (task_start_called()) task_set_event(TASK_ID_U2F, TASK_EVENT_FRAME, 0);
 }
 
+/* Called when the USB bus resumes from suspend. The kernel keeps the
+ * device enumerated and configured across suspend, so everything here
+ * is deliberately preserved: the channel table, any slots mid-message
+ * and the channel lock all survive, and a host that suspended in the
+ * middle of a conversation continues on its existing CID without
+ * re-opening a channel. The first frame after resume is therefore
+ * serviced immediately instead of after INIT plus channel setup. */
+static void u2fhid_resumed(void) {
+  TRACE_INFO(TRACE_U2F_RESUMED, lock_CID, 0);
+}
+
 void u2f_init(void) {
   if (kl_init()) {
-    printf("ERROR: kl_init() FAIL!\n");
+    h1_printf("ERROR: kl_init() FAIL!\n");
+  }
+  if (tock_u2f_on_resume(u2fhid_resumed) != TOCK_SUCCESS) {
+    h1_printf("U2F: kernel lacks resume notification; suspend will cost a"
+           " re-enumeration.\n");
   }
 }
 
@@ -595,7 +933,7 @@ static void u2f_task_init(void) {
           int i;
 
   if (kl_init()) {
-    printf("kl_init() FAIL!\n");
+    h1_printf("kl_init() FAIL!\n");
   }
 
   // Clear channel state
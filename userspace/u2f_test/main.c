@@ -18,6 +18,222 @@
 
 #include "u2f.h"
 
+#ifdef U2F_LOADGEN
+// Load-generation mode: the host scripts bursts of register/
+// authenticate-shaped work over the raw 64-byte frame channel and the
+// device answers each request with its own per-phase timing, so a host
+// script sweeping offered load gets a closed-loop throughput/latency
+// curve from device-side numbers instead of extrapolating from
+// single-shot runs.
+//
+// Request frame:  "LG" op flags seq[4] param[32] pad
+// Response frame: "lg" op status seq[4] queue_us[4] crypto_us[4]
+//                 total_us[4] depth drops[4] sig_head[8] pad
+//
+// Ops: 0 ping (transport only; byte 33 of the response reports the
+// device queue depth), 1 register (fresh keypair plus a sign, the
+// dcrypto shape of a registration), 2 authenticate (one sign). param
+// feeds the signed message so the work is not constant.
+//
+// Concurrency is host-driven: the host decides how many requests it
+// keeps in flight before collecting responses. The device keeps one
+// receive posted at all times and queues up to LG_QUEUE_DEPTH
+// requests, running the sign asynchronously, so queue_us (receive to
+// crypto start) is the device-side congestion signal; drops counts
+// requests that arrived with the queue full. Each phase also lands in
+// the trace ring (TRACE_LG_*), flushed when the device goes idle.
+//
+// Build with: make U2F_LOADGEN=1
+
+#include <tock.h>
+
+#include "drbg.h"
+#include "fips.h"
+#include "p256.h"
+#include "p256_ecdsa.h"
+#include "timestamp_syscalls.h"
+#include "trace.h"
+
+#define LG_QUEUE_DEPTH 4
+#define LG_FRAME_LEN 64
+
+enum { LG_OP_PING = 0, LG_OP_REGISTER = 1, LG_OP_AUTH = 2 };
+
+typedef struct {
+  uint8_t raw[LG_FRAME_LEN];
+  uint32_t rx_us;
+  uint8_t depth_at_rx;
+} lg_slot;
+
+static lg_slot lg_queue[LG_QUEUE_DEPTH];
+static unsigned int lg_head;
+static unsigned int lg_count;
+static uint32_t lg_drops;
+
+static uint8_t rx_frame[LG_FRAME_LEN];
+static uint8_t tx_frame[LG_FRAME_LEN];
+
+static DRBG lg_drbg;
+static p256_int lg_d, lg_x, lg_y;
+
+// The request being worked on, and the response under construction.
+static bool lg_busy;
+static bool lg_respond;
+static lg_slot lg_current;
+static uint32_t lg_crypto_start_us;
+static uint32_t lg_crypto_us;
+static uint8_t lg_status;
+static uint8_t lg_sig_head[8];
+
+static uint32_t lg_get32(const uint8_t* p) {
+  uint32_t v;
+  memcpy(&v, p, sizeof(v));
+  return v;
+}
+
+static void lg_put32(uint8_t* p, uint32_t v) {
+  memcpy(p, &v, sizeof(v));
+}
+
+static void lg_post_receive(void);
+
+static void lg_rx_done(int error, void* ud __attribute__((unused))) {
+  uint32_t seq = lg_get32(rx_frame + 4);
+
+  if (error == 0 && rx_frame[0] == 'L' && rx_frame[1] == 'G') {
+    if (lg_count < LG_QUEUE_DEPTH) {
+      lg_slot* slot = &lg_queue[(lg_head + lg_count) % LG_QUEUE_DEPTH];
+      memcpy(slot->raw, rx_frame, LG_FRAME_LEN);
+      slot->rx_us = gettimeus();
+      slot->depth_at_rx = (uint8_t)lg_count;
+      lg_count++;
+      TRACE_INFO(TRACE_LG_RX, seq, lg_count);
+    } else {
+      lg_drops++;
+      TRACE_ERR(TRACE_LG_DROP, seq, lg_drops);
+    }
+  }
+  lg_post_receive();
+}
+
+static void lg_post_receive(void) {
+  if (tock_u2f_receive_async(rx_frame, sizeof(rx_frame), lg_rx_done, NULL) !=
+      0) {
+    printf("loadgen: could not post receive\n");
+  }
+}
+
+static void lg_sign_done(int result, const p256_int* r, const p256_int* s,
+                         void* ud __attribute__((unused))) {
+  lg_crypto_us = gettimeus() - lg_crypto_start_us;
+  lg_status = result ? 0 : 1;
+  memcpy(lg_sig_head, r->a, 4);
+  memcpy(lg_sig_head + 4, s->a, 4);
+  TRACE_INFO(TRACE_LG_CRYPTO_DONE, lg_get32(lg_current.raw + 4),
+             lg_crypto_us);
+  lg_respond = true;
+}
+
+static void lg_start(lg_slot* slot) {
+  uint8_t op = slot->raw[2];
+  p256_int msg;
+
+  lg_current = *slot;
+  lg_busy = true;
+  lg_status = 0;
+  lg_crypto_us = 0;
+  lg_crypto_start_us = gettimeus();
+  memset(lg_sig_head, 0, sizeof(lg_sig_head));
+  TRACE_INFO(TRACE_LG_CRYPTO_START, lg_get32(slot->raw + 4), op);
+
+  if (op == LG_OP_PING) {
+    lg_respond = true;
+    return;
+  }
+
+  fips_p256_from_bin(slot->raw + 8, &msg);
+
+  if (op == LG_OP_REGISTER) {
+    // The dcrypto shape of a registration: derive a fresh keypair
+    // (without burning a flash counter, which fips_keygen would),
+    // then sign with it.
+    if (fips_p256_pick(&lg_drbg, &lg_d, NULL, 0) != 0 ||
+        !fips_p256_base_point_mul(&lg_d, &lg_x, &lg_y)) {
+      lg_status = 1;
+      lg_crypto_us = gettimeus() - lg_crypto_start_us;
+      lg_respond = true;
+      return;
+    }
+  }
+
+  if (!fips_p256_ecdsa_sign_async(&lg_drbg, &lg_d, &msg, lg_sign_done,
+                                  NULL)) {
+    lg_status = 1;
+    lg_crypto_us = gettimeus() - lg_crypto_start_us;
+    lg_respond = true;
+  }
+}
+
+static void lg_send_response(void) {
+  uint32_t now = gettimeus();
+  uint32_t seq = lg_get32(lg_current.raw + 4);
+
+  memset(tx_frame, 0, sizeof(tx_frame));
+  tx_frame[0] = 'l';
+  tx_frame[1] = 'g';
+  tx_frame[2] = lg_current.raw[2];
+  tx_frame[3] = lg_status;
+  lg_put32(tx_frame + 4, seq);
+  lg_put32(tx_frame + 8, lg_crypto_start_us - lg_current.rx_us);
+  lg_put32(tx_frame + 12, lg_crypto_us);
+  lg_put32(tx_frame + 16, now - lg_current.rx_us);
+  tx_frame[20] = lg_current.depth_at_rx;
+  lg_put32(tx_frame + 21, lg_drops);
+  memcpy(tx_frame + 25, lg_sig_head, sizeof(lg_sig_head));
+  if (lg_current.raw[2] == LG_OP_PING) {
+    tx_frame[33] = LG_QUEUE_DEPTH;
+  }
+
+  TRACE_INFO(TRACE_LG_TX, seq, now - lg_current.rx_us);
+  tock_u2f_transmit(tx_frame, sizeof(tx_frame));
+  lg_busy = false;
+  lg_respond = false;
+}
+
+int main(void) {
+  delay_ms(2000);
+  printf("= U2F load generator: queue depth %d =\n", LG_QUEUE_DEPTH);
+
+  if (tock_timestamp_check() != TOCK_SUCCESS) {
+    printf("No timestamp driver; cannot report timings.\n");
+    return 1;
+  }
+  init_fips();
+  make_drbg2(&lg_drbg);
+  if (fips_keygen(&lg_drbg, &lg_d, &lg_x, &lg_y, NULL, 0) != 0) {
+    printf("loadgen: keygen failed\n");
+    return 1;
+  }
+
+  lg_post_receive();
+
+  while (1) {
+    if (lg_respond) {
+      lg_send_response();
+    } else if (!lg_busy && lg_count > 0) {
+      lg_slot* slot = &lg_queue[lg_head];
+      lg_head = (lg_head + 1) % LG_QUEUE_DEPTH;
+      lg_count--;
+      lg_start(slot);
+    } else {
+      trace_flush();
+      yield();
+    }
+  }
+}
+
+#else  // U2F_LOADGEN
+
 static char u2f_received_frame[64];
 
 int main(void) {
@@ -39,3 +255,5 @@ int main(void) {
     printf("\n");
   }
 }
+
+#endif  // U2F_LOADGEN
@@ -99,3 +99,49 @@ int tock_u2f_receive(void* data, size_t datalen) {
 
   return 0;
 }
+
+static tock_u2f_rx_callback async_rx_callback = NULL;
+static void* async_rx_userdata = NULL;
+
+static void tock_u2f_receive_async_done(int error,
+                                        int fault __attribute__((unused)),
+                                        int unused __attribute__((unused)),
+                                        void* callback_args
+                                            __attribute__((unused))) {
+  tock_u2f_rx_callback cb = async_rx_callback;
+
+  async_rx_callback = NULL;
+  if (cb != NULL) cb(error, async_rx_userdata);
+}
+
+int tock_u2f_receive_async(void* data, size_t datalen,
+                           tock_u2f_rx_callback callback, void* user_data) {
+  int ret;
+
+  if (async_rx_callback != NULL) return TOCK_EBUSY;
+
+  ret = subscribe(HOTEL_DRIVER_U2F, TOCK_U2F_SUBSCRIBE_RECEIVE_DONE,
+                  tock_u2f_receive_async_done, NULL);
+  if (ret < 0) {
+    printf("Could not register U2F receive callback with kernel: %d\n", ret);
+    return ret;
+  }
+
+  ret = allow(HOTEL_DRIVER_U2F, TOCK_U2F_ALLOW_RECEIVE, data, datalen);
+  if (ret < 0) {
+    printf("Could not give kernel access to U2F data: %d\n", ret);
+    return TOCK_EBUSY;
+  }
+
+  async_rx_callback = callback;
+  async_rx_userdata = user_data;
+
+  ret = command(HOTEL_DRIVER_U2F, TOCK_U2F_CMD_RECEIVE, datalen, 0);
+  if (ret < 0) {
+    printf("Could not receive over U2F: %d\n", ret);
+    async_rx_callback = NULL;
+    return ret;
+  }
+
+  return 0;
+}
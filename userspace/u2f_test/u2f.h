@@ -36,4 +36,14 @@ int tock_u2f_transmit(void* data, size_t datalen);
 // Receive a frame from U2F endopint. datalen must be <= 64.
 int tock_u2f_receive(void* data, size_t datalen);
 
+// Completion handler for tock_u2f_receive_async. error is 0 if a frame
+// landed in the posted buffer.
+typedef void (*tock_u2f_rx_callback)(int error, void* user_data);
+
+// Post a receive and return immediately; the callback fires from a
+// later yield() once a frame arrives. Lets the app keep a receive
+// outstanding while it works on earlier frames. datalen must be <= 64.
+int tock_u2f_receive_async(void* data, size_t datalen,
+                           tock_u2f_rx_callback callback, void* user_data);
+
 #endif